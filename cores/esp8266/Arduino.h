@@ -170,8 +170,27 @@ void digitalWrite(uint8_t pin, uint8_t val);
 int digitalRead(uint8_t pin);
 int analogRead(uint8_t pin);
 void analogReference(uint8_t mode);
+
+// Bursts of ADC samples, radio off (WIFI_OFF) only.  clkDiv 8...32 sets the
+// sample rate, periodCycles receives the measured CPU cycles per sample.
+bool analogReadFast(uint16_t *samples, uint16_t count, uint8_t clkDiv, uint32_t *startCycles, uint32_t *periodCycles);
+
+typedef struct {
+  uint32_t cycles; // ESP.getCycleCount() at the first sample
+  uint32_t period; // CPU cycles per sample within the block
+  uint16_t count;
+  uint16_t *samples;
+} analog_block_t;
+
+// Continuous capture into a ring of blocks, one burst per loop() iteration
+bool analogCaptureBegin(uint16_t blockSamples, uint8_t blocks, uint8_t clkDiv);
+void analogCaptureEnd();
+const analog_block_t *analogCaptureGet(); // oldest captured block or NULL
+void analogCaptureRelease();              // done with the block from analogCaptureGet()
+uint32_t analogCaptureOverruns();         // bursts skipped because no block was free
 void analogWrite(uint8_t pin, int val);
 void analogWriteMode(uint8_t pin, int val, bool openDrain);
+void analogWriteMulti(const uint8_t *pins, const int *vals, size_t count);
 void analogWriteFreq(uint32_t freq);
 void analogWriteResolution(int res);
 void analogWriteRange(uint32_t range);
@@ -186,6 +205,21 @@ void attachInterrupt(uint8_t pin, void (*)(void), int mode);
 void detachInterrupt(uint8_t pin);
 void attachInterruptArg(uint8_t pin, void (*)(void*), void* arg, int mode);
 
+// Record pin edges with their cycle count in a ring read from loop()
+typedef struct {
+  uint32_t cycles; // ESP.getCycleCount() when the edge was taken
+  uint8_t pin;
+  uint8_t level;   // pin level read right after the edge
+} capture_edge_t;
+
+bool captureBegin(size_t entries);
+void captureEnd();
+bool captureAttach(uint8_t pin, int mode);
+void captureDetach(uint8_t pin);
+size_t captureRead(capture_edge_t* edges, size_t count);
+size_t captureAvailable();
+uint32_t captureOverruns();
+
 void preinit(void);
 void setup(void);
 void loop(void);
@@ -272,6 +306,15 @@ void configTime(int timezone, int daylightOffset_sec, const char* server1,
 void configTime(const char* tz, const char* server1,
     const char* server2 = nullptr, const char* server3 = nullptr);
 
+// Ask all the SNTP servers at once after configTime(), every second until
+// the first reply, to get the time faster after boot
+void configTimeFastSync(bool enable = true);
+
+// Save the time at each SNTP synchronisation in RTC user memory blocks
+// rtcBlock to rtcBlock + 6, and after a deep sleep wake set the clock from
+// there.  Returns true when the clock was set.  Call before configTime().
+bool configTimeRtc(uint32_t rtcBlock = 32);
+
 // esp32 api compatibility
 inline void configTzTime(const char* tz, const char* server1,
     const char* server2 = nullptr, const char* server3 = nullptr)
@@ -284,6 +327,7 @@ inline void configTzTime(const char* tz, const char* server1,
 
 #include "WCharacter.h"
 #include "WString.h"
+#include "StringView.h"
 
 #include "HardwareSerial.h"
 #include "Esp.h"
@@ -23,8 +23,13 @@
  */
 
 #include <Arduino.h>
+#include <interrupts.h>
+#include <atomic>
+#include <cstddef>
 #include <memory>
 #include <list>
+#include <new>
+#include <type_traits>
 #include <utility>
 
 namespace experimental
@@ -78,6 +83,170 @@ public:
     }
 };
 
+// Fixed capacity variant for callbacks executed often, e.g. from the lwIP
+// packet path.  Callables are stored in the list itself, up to Storage
+// bytes each, so add() and execute() never allocate, and execute() takes
+// no lock while calling, so it may run from an interrupt.
+//
+// remove() may be called at any time, from a callback too: a callback is
+// not called anymore once it is removed, and it is destroyed when no
+// execute() is running.  Handles are slot numbers, -1 when the list is full.
+template<typename Signature, size_t Capacity, size_t Storage = 4 * sizeof(void*)>
+class StaticCallBackList;
+
+template<typename... Args, size_t Capacity, size_t Storage>
+class StaticCallBackList<void(Args...), Capacity, Storage>
+{
+public:
+    using CallBackHandler = int;
+    static constexpr CallBackHandler invalid = -1;
+
+    StaticCallBackList() {}
+    StaticCallBackList(const StaticCallBackList&) = delete;
+    StaticCallBackList& operator= (const StaticCallBackList&) = delete;
+
+    ~StaticCallBackList()
+    {
+        for (auto& slot : _slots) {
+            if (slot.state != Free) {
+                slot.destroy(&slot.storage);
+            }
+        }
+    }
+
+    template<typename F>
+    CallBackHandler add(F&& f)
+    {
+        using Fn = typename std::decay<F>::type;
+        static_assert(sizeof(Fn) <= Storage, "callable is larger than the StaticCallBackList storage");
+        static_assert(alignof(Fn) <= alignof(std::max_align_t), "callable alignment is not supported");
+
+        CallBackHandler handler = invalid;
+        {
+            esp8266::InterruptLock lock;
+            for (size_t i = 0; i < Capacity; i++) {
+                if (_slots[i].state == Free) {
+                    _slots[i].state = Reserved;
+                    handler = i;
+                    break;
+                }
+            }
+        }
+        if (handler == invalid) {
+            return invalid;
+        }
+        // built out of the lock, execute() skips the slot until it is Active
+        Slot& slot = _slots[handler];
+        new (&slot.storage) Fn(std::forward<F>(f));
+        slot.invoke = [](void* fn, Args... params) {
+            (*static_cast<Fn*>(fn))(params...);
+        };
+        slot.destroy = [](void* fn) {
+            static_cast<Fn*>(fn)->~Fn();
+        };
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.state = Active;
+        return handler;
+    }
+
+    bool remove(CallBackHandler handler)
+    {
+        if (handler < 0 || (size_t)handler >= Capacity) {
+            return false;
+        }
+        Slot& slot = _slots[handler];
+        {
+            esp8266::InterruptLock lock;
+            if (slot.state != Active) {
+                return false;
+            }
+            if (_running) {
+                // the callback may be running, collect() destroys it
+                slot.state = Removed;
+                _removed = true;
+                return true;
+            }
+            slot.state = Dying;
+        }
+        release(slot);
+        return true;
+    }
+
+    // callbacks added and not removed
+    size_t size() const
+    {
+        size_t n = 0;
+        for (const auto& slot : _slots) {
+            n += slot.state == Active;
+        }
+        return n;
+    }
+
+    // returns the number of callbacks called
+    int execute(Args... params)
+    {
+        {
+            esp8266::InterruptLock lock;
+            _running++;
+        }
+        int called = 0;
+        for (auto& slot : _slots) {
+            if (slot.state == Active) {
+                std::atomic_thread_fence(std::memory_order_acquire);
+                slot.invoke(&slot.storage, params...);
+                called++;
+            }
+        }
+        collect();
+        return called;
+    }
+
+protected:
+    // Dying is destroyed by remove(), Collected by collect()
+    enum State : uint8_t { Free, Reserved, Active, Removed, Dying, Collected };
+
+    struct Slot
+    {
+        typename std::aligned_storage<Storage, alignof(std::max_align_t)>::type storage;
+        void (*invoke)(void*, Args...);
+        void (*destroy)(void*);
+        volatile State state = Free;
+    };
+
+    void release(Slot& slot)
+    {
+        slot.destroy(&slot.storage);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.state = Free;
+    }
+
+    // the last execute() to end destroys the callbacks removed meanwhile
+    void collect()
+    {
+        {
+            esp8266::InterruptLock lock;
+            if (--_running || !_removed) {
+                return;
+            }
+            _removed = false;
+            for (auto& slot : _slots) {
+                if (slot.state == Removed) {
+                    slot.state = Collected;
+                }
+            }
+        }
+        for (auto& slot : _slots) {
+            if (slot.state == Collected) {
+                release(slot);
+            }
+        }
+    }
+
+    Slot _slots[Capacity];
+    volatile int _running = 0;
+    volatile bool _removed = false;
+};
+
 } //CBListImplementation
 }//experimental
 
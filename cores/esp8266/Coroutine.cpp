@@ -0,0 +1,167 @@
+/*
+ Coroutine.cpp - cooperative coroutines on separately allocated stacks
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <Arduino.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "Coroutine.h"
+#include "Schedule.h"
+#include "debug.h"
+
+#define CONT_STACKGUARD 0xfeefeffe
+
+Coroutine* Coroutine::_current = nullptr;
+Coroutine* Coroutine::_first = nullptr;
+bool Coroutine::_scheduled = false;
+
+Coroutine::Coroutine(size_t stackSize)
+: _stackSize((stackSize + 3) & ~3)
+{
+}
+
+Coroutine::~Coroutine() {
+    _unlink();
+    _release();
+}
+
+/*
+  The stack is laid out like cont_t: a guard word at the bottom, the
+  stack, then at stack_end (16 byte aligned, as the ABI wants for sp) a
+  second guard word, followed by a pointer to the Context.  cont_norm in
+  cont.S reads that pointer when the function returns.
+*/
+bool Coroutine::start(std::function<void()> fn) {
+    static_assert(offsetof(cont_t, sp_ret) == offsetof(Context, sp_ret) &&
+                  offsetof(cont_t, pc_yield) == offsetof(Context, pc_yield) &&
+                  offsetof(cont_t, sp_yield) == offsetof(Context, sp_yield) &&
+                  offsetof(cont_t, stack_end) == offsetof(Context, stack_end), "Context must match cont_t");
+    if (_state != Idle || !fn) {
+        return false;
+    }
+    const size_t words = _stackSize / 4 + 6;
+    unsigned* raw = (unsigned*)malloc(words * 4);
+    if (!raw) {
+        return false;
+    }
+    unsigned* end = (unsigned*)((uintptr_t)(raw + words - 2) & ~(uintptr_t)15);
+    for (unsigned* pos = raw; pos <= end; ++pos) {
+        *pos = CONT_STACKGUARD;
+    }
+    end[1] = (unsigned)(uintptr_t)&_ctx;
+
+    _stack = raw;
+    _ctx = { nullptr, nullptr, nullptr, nullptr, end };
+    _fn = std::move(fn);
+    _state = Suspended;
+
+    _next = _first;
+    _first = this;
+    if (!_scheduled) {
+        _scheduled = schedule_recurrent_function_us([]() {
+            runAll();
+            _scheduled = _first != nullptr;
+            return _scheduled;
+        }, 0);
+    }
+    return true;
+}
+
+void Coroutine::_entry() {
+    Coroutine* self = _current;
+    self->_fn();
+    self->_fn = nullptr;
+    self->_state = Idle;
+}
+
+bool Coroutine::resume() {
+    if (_state != Suspended) {
+        return false;
+    }
+    Coroutine* resumer = _current;
+    _current = this;
+    _state = Running;
+    cont_run(reinterpret_cast<cont_t*>(&_ctx), &Coroutine::_entry);
+    _current = resumer;
+
+    if (_stack[0] != CONT_STACKGUARD || *_ctx.stack_end != CONT_STACKGUARD) {
+        panic();
+    }
+    if (_state == Idle) {
+        _unlink();
+        _release();
+        return false;
+    }
+    _state = Suspended;
+    return true;
+}
+
+void Coroutine::yield() {
+    Coroutine* self = _current;
+    if (!self) {
+        ::yield();
+        return;
+    }
+    cont_yield(reinterpret_cast<cont_t*>(&self->_ctx));
+}
+
+size_t Coroutine::freeStack() const {
+    if (!_stack) {
+        return 0;
+    }
+    size_t bytes = 0;
+    for (const unsigned* pos = _stack + 1; pos < _ctx.stack_end && *pos == CONT_STACKGUARD; ++pos) {
+        bytes += 4;
+    }
+    return bytes;
+}
+
+void Coroutine::runAll() {
+    // A coroutine may start others (they go first in the list and wait
+    // for the next run), but must not destroy the one after it.
+    for (Coroutine* co = _first; co;) {
+        Coroutine* next = co->_next;
+        co->resume();
+        co = next;
+    }
+}
+
+void Coroutine::_release() {
+    free(_stack);
+    _stack = nullptr;
+    _state = Idle;
+}
+
+void Coroutine::_unlink() {
+    for (Coroutine** link = &_first; *link; link = &(*link)->_next) {
+        if (*link == this) {
+            *link = _next;
+            break;
+        }
+    }
+    _next = nullptr;
+}
+
+// yield() calls this first, see core_esp8266_main.cpp
+extern "C" bool coroutine_yield() {
+    if (!Coroutine::current()) {
+        return false;
+    }
+    Coroutine::yield();
+    return true;
+}
@@ -0,0 +1,100 @@
+/*
+ Coroutine.h - cooperative coroutines on separately allocated stacks
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __COROUTINE_H
+#define __COROUTINE_H
+
+#include <stddef.h>
+#include <functional>
+
+#include "cont.h"
+
+/*
+  A Coroutine runs a function on its own stack and switches with the same
+  cont_run()/cont_yield() primitive as the sketch's loop().  Started
+  coroutines are resumed one after the other from loop() and from yield()
+  (as a recurrent scheduled function), until they call yield() or
+  Coroutine::yield() and give the others a turn.  Inside a coroutine
+  yield(), which is also what blocking Stream and WiFi code call while
+  waiting, returns to the code that resumed it.  delay() and other
+  esp_yield() based waits suspend the whole loop task as before.
+
+  The stack is allocated by start() from the current heap, so it can be
+  placed in the IRAM heap with HeapSelectIram (byte accesses to it are
+  then emulated, which is slow).  It is released when the function
+  returns.  A Coroutine must not be destroyed while it is suspended
+  inside its function: the objects on its stack would not be destroyed.
+*/
+class Coroutine {
+    public:
+        explicit Coroutine(size_t stackSize = 2048);
+        ~Coroutine();
+        Coroutine(const Coroutine&) = delete;
+        Coroutine& operator=(const Coroutine&) = delete;
+
+        // Allocate the stack and queue fn for the next run.  Returns false
+        // when the coroutine is already started or out of memory.
+        bool start(std::function<void()> fn);
+
+        // Run until the coroutine yields or returns.  Returns false when it
+        // is not started, is running, or has just returned.
+        bool resume();
+
+        bool started() const { return _state != Idle; }
+        bool running() const { return _state == Running; }
+        // Bytes of stack never touched so far
+        size_t freeStack() const;
+
+        // Switch back to the code that resumed the coroutine we are in,
+        // or plain yield() outside of coroutines.
+        static void yield();
+        // The coroutine we are in, nullptr in loop()
+        static Coroutine* current() { return _current; }
+        // Resume every started coroutine once
+        static void runAll();
+
+    protected:
+        enum State { Idle, Suspended, Running };
+
+        // Same layout as the start of cont_t, the only part cont.S uses
+        struct Context {
+            void (*pc_ret)(void);
+            unsigned* sp_ret;
+            void (*pc_yield)(void);
+            unsigned* sp_yield;
+            unsigned* stack_end;
+        };
+
+        static void _entry();
+        void _release();
+        void _unlink();
+
+        Context _ctx;
+        unsigned* _stack = nullptr;
+        size_t _stackSize;
+        State _state = Idle;
+        std::function<void()> _fn;
+        Coroutine* _next = nullptr;
+
+        static Coroutine* _current;
+        static Coroutine* _first;
+        static bool _scheduled;
+};
+
+#endif // __COROUTINE_H
@@ -469,6 +469,95 @@ String MD5SHA1::hash(const String &message)
 }
 
 
+// #################### Incremental hash and HMAC ####################
+
+BasicHashContext::BasicHashContext(const br_hash_class *hashType)
+{
+    hashContext.vtable = hashType;
+    reset();
+}
+
+void BasicHashContext::reset()
+{
+    hashContext.vtable->init(&hashContext.vtable);
+}
+
+void BasicHashContext::update(const void *data, const size_t dataLength)
+{
+    hashContext.vtable->update(&hashContext.vtable, data, dataLength);
+}
+
+void BasicHashContext::update(const String &message)
+{
+    update(message.c_str(), message.length());
+}
+
+void *BasicHashContext::finish(void *resultArray) const
+{
+    hashContext.vtable->out(&hashContext.vtable, resultArray);
+    return resultArray;
+}
+
+String BasicHashContext::finish() const
+{
+    uint8_t hashArray[length()];
+    finish(hashArray);
+    return TypeCast::uint8ArrayToHexString(hashArray, sizeof hashArray);
+}
+
+size_t BasicHashContext::length() const
+{
+    return (hashContext.vtable->desc >> BR_HASHDESC_OUT_OFF) & BR_HASHDESC_OUT_MASK;
+}
+
+BasicHmacContext::BasicHmacContext(const br_hash_class *hashType, const void *hashKey, const size_t hashKeyLength, const size_t outputLength)
+    : hmacLength(outputLength)
+{
+    br_hmac_key_init(&keyContext, hashType, hashKey, hashKeyLength);
+    reset();
+}
+
+BasicHmacContext::~BasicHmacContext()
+{
+    // The key context holds the processed key
+    memset(&keyContext, 0, sizeof keyContext);
+    memset(&hmacContext, 0, sizeof hmacContext);
+}
+
+void BasicHmacContext::reset()
+{
+    br_hmac_init(&hmacContext, &keyContext, hmacLength);
+}
+
+void BasicHmacContext::update(const void *data, const size_t dataLength)
+{
+    br_hmac_update(&hmacContext, data, dataLength);
+}
+
+void BasicHmacContext::update(const String &message)
+{
+    update(message.c_str(), message.length());
+}
+
+void *BasicHmacContext::finish(void *resultArray) const
+{
+    br_hmac_out(&hmacContext, resultArray);
+    return resultArray;
+}
+
+String BasicHmacContext::finish() const
+{
+    uint8_t hmac[length()];
+    finish(hmac);
+    return TypeCast::uint8ArrayToHexString(hmac, sizeof hmac);
+}
+
+size_t BasicHmacContext::length() const
+{
+    return br_hmac_size(const_cast<br_hmac_context *>(&hmacContext));
+}
+
+
 // #################### HKDF ####################
 
 HKDF::HKDF(const void *keyMaterial, const size_t keyMaterialLength, const void *salt, const size_t saltLength)
@@ -549,5 +638,295 @@ bool ChaCha20Poly1305::decrypt(void *data, const size_t dataLength, const void *
 
     return true;
 }
+
+// Poly1305 as in RFC 8439, after poly1305-donna (public domain).
+// The AEAD construction pads each part of the MAC input to 16 bytes, so
+// there is never a partial last block.
+
+namespace
+{
+inline uint32_t load32le(const uint8_t *p)
+{
+    return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+inline void store32le(uint8_t *p, uint32_t v)
+{
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+}
+
+inline void store64le(uint8_t *p, uint64_t v)
+{
+    store32le(p, v);
+    store32le(p + 4, v >> 32);
+}
+}
+
+ChaCha20Poly1305Context::~ChaCha20Poly1305Context()
+{
+    memset(_key, 0, sizeof _key);
+    memset(_keystream, 0, sizeof _keystream);
+    memset(_r, 0, sizeof _r);
+    memset(_pad, 0, sizeof _pad);
+}
+
+void ChaCha20Poly1305Context::beginEncrypt(const void *key, const void *keySalt, const size_t keySaltLength, void *resultingNonce)
+{
+    getNonceGenerator()((uint8_t *)resultingNonce, 12);
+    begin(key, keySalt, keySaltLength, resultingNonce, true);
+}
+
+void ChaCha20Poly1305Context::beginDecrypt(const void *key, const void *keySalt, const size_t keySaltLength, const void *encryptionNonce)
+{
+    begin(key, keySalt, keySaltLength, encryptionNonce, false);
+}
+
+void ChaCha20Poly1305Context::begin(const void *key, const void *keySalt, const size_t keySaltLength, const void *nonce, const bool encrypt)
+{
+    if (keySalt == nullptr)
+    {
+        memcpy(_key, key, ENCRYPTION_KEY_LENGTH);
+    }
+    else
+    {
+        HKDF hkdfInstance(key, ENCRYPTION_KEY_LENGTH, keySalt, keySaltLength);
+        hkdfInstance.produce(_key, ENCRYPTION_KEY_LENGTH);
+    }
+    memcpy(_nonce, nonce, sizeof _nonce);
+    _encrypt = encrypt;
+    _inData = false;
+    _aadLength = 0;
+    _dataLength = 0;
+
+    // The Poly1305 key is the start of the keystream block 0, the data uses the following blocks
+    uint8_t polyKey[32] {0};
+    br_chacha20_ct_run(_key, _nonce, 0, polyKey, sizeof polyKey);
+    _counter = 1;
+    _keystreamUsed = sizeof _keystream;
+
+    _r[0] = load32le(polyKey + 0) & 0x3ffffff;
+    _r[1] = (load32le(polyKey + 3) >> 2) & 0x3ffff03;
+    _r[2] = (load32le(polyKey + 6) >> 4) & 0x3ffc0ff;
+    _r[3] = (load32le(polyKey + 9) >> 6) & 0x3f03fff;
+    _r[4] = (load32le(polyKey + 12) >> 8) & 0x00fffff;
+    for (int i = 0; i < 4; ++i)
+    {
+        _pad[i] = load32le(polyKey + 16 + 4 * i);
+    }
+    memset(_h, 0, sizeof _h);
+    _buffered = 0;
+    memset(polyKey, 0, sizeof polyKey);
+}
+
+void ChaCha20Poly1305Context::addAad(const void *aad, const size_t aadLength)
+{
+    assert(!_inData);
+    polyUpdate((const uint8_t *)aad, aadLength);
+    _aadLength += aadLength;
+}
+
+void ChaCha20Poly1305Context::update(void *data, const size_t dataLength)
+{
+    if (!_inData)
+    {
+        polyPad();
+        _inData = true;
+    }
+    if (!_encrypt)
+    {
+        polyUpdate((const uint8_t *)data, dataLength);
+    }
+
+    uint8_t *pos = (uint8_t *)data;
+    size_t left = dataLength;
+    while (left)
+    {
+        if (_keystreamUsed == sizeof _keystream && left >= sizeof _keystream)
+        {
+            // whole blocks directly in place
+            const size_t whole = left & ~(sizeof _keystream - 1);
+            _counter = br_chacha20_ct_run(_key, _nonce, _counter, pos, whole);
+            pos += whole;
+            left -= whole;
+            continue;
+        }
+        if (_keystreamUsed == sizeof _keystream)
+        {
+            memset(_keystream, 0, sizeof _keystream);
+            _counter = br_chacha20_ct_run(_key, _nonce, _counter, _keystream, sizeof _keystream);
+            _keystreamUsed = 0;
+        }
+        while (left && _keystreamUsed < sizeof _keystream)
+        {
+            *pos++ ^= _keystream[_keystreamUsed++];
+            --left;
+        }
+    }
+
+    if (_encrypt)
+    {
+        polyUpdate((const uint8_t *)data, dataLength);
+    }
+    _dataLength += dataLength;
+}
+
+void ChaCha20Poly1305Context::finish(void *resultingTag)
+{
+    polyFinish((uint8_t *)resultingTag);
+}
+
+bool ChaCha20Poly1305Context::verify(const void *encryptionTag)
+{
+    uint8_t newTag[16];
+    polyFinish(newTag);
+    const uint8_t *oldTag = (const uint8_t *)encryptionTag;
+    uint8_t diff = 0;
+    for (uint32_t i = 0; i < sizeof newTag; ++i)
+    {
+        diff |= newTag[i] ^ oldTag[i];
+    }
+    return diff == 0;
+}
+
+void ChaCha20Poly1305Context::polyUpdate(const uint8_t *data, size_t dataLength)
+{
+    if (_buffered)
+    {
+        while (dataLength && _buffered < sizeof _buffer)
+        {
+            _buffer[_buffered++] = *data++;
+            --dataLength;
+        }
+        if (_buffered < sizeof _buffer)
+        {
+            return;
+        }
+        polyBlocks(_buffer, 1);
+        _buffered = 0;
+    }
+    polyBlocks(data, dataLength / 16);
+    data += dataLength & ~15;
+    dataLength &= 15;
+    memcpy(_buffer, data, dataLength);
+    _buffered = dataLength;
+}
+
+void ChaCha20Poly1305Context::polyPad()
+{
+    if (_buffered)
+    {
+        memset(_buffer + _buffered, 0, sizeof _buffer - _buffered);
+        polyBlocks(_buffer, 1);
+        _buffered = 0;
+    }
+}
+
+void ChaCha20Poly1305Context::polyBlocks(const uint8_t *data, size_t blockCount)
+{
+    const uint32_t r0 = _r[0], r1 = _r[1], r2 = _r[2], r3 = _r[3], r4 = _r[4];
+    const uint32_t s1 = r1 * 5, s2 = r2 * 5, s3 = r3 * 5, s4 = r4 * 5;
+    uint32_t h0 = _h[0], h1 = _h[1], h2 = _h[2], h3 = _h[3], h4 = _h[4];
+
+    for (; blockCount; --blockCount, data += 16)
+    {
+        h0 += load32le(data + 0) & 0x3ffffff;
+        h1 += (load32le(data + 3) >> 2) & 0x3ffffff;
+        h2 += (load32le(data + 6) >> 4) & 0x3ffffff;
+        h3 += (load32le(data + 9) >> 6) & 0x3ffffff;
+        h4 += (load32le(data + 12) >> 8) | (1 << 24);
+
+        const uint64_t d0 = (uint64_t)h0 * r0 + (uint64_t)h1 * s4 + (uint64_t)h2 * s3 + (uint64_t)h3 * s2 + (uint64_t)h4 * s1;
+        uint64_t d1 = (uint64_t)h0 * r1 + (uint64_t)h1 * r0 + (uint64_t)h2 * s4 + (uint64_t)h3 * s3 + (uint64_t)h4 * s2;
+        uint64_t d2 = (uint64_t)h0 * r2 + (uint64_t)h1 * r1 + (uint64_t)h2 * r0 + (uint64_t)h3 * s4 + (uint64_t)h4 * s3;
+        uint64_t d3 = (uint64_t)h0 * r3 + (uint64_t)h1 * r2 + (uint64_t)h2 * r1 + (uint64_t)h3 * r0 + (uint64_t)h4 * s4;
+        uint64_t d4 = (uint64_t)h0 * r4 + (uint64_t)h1 * r3 + (uint64_t)h2 * r2 + (uint64_t)h3 * r1 + (uint64_t)h4 * r0;
+
+        h0 = (uint32_t)d0 & 0x3ffffff;
+        d1 += d0 >> 26;
+        h1 = (uint32_t)d1 & 0x3ffffff;
+        d2 += d1 >> 26;
+        h2 = (uint32_t)d2 & 0x3ffffff;
+        d3 += d2 >> 26;
+        h3 = (uint32_t)d3 & 0x3ffffff;
+        d4 += d3 >> 26;
+        h4 = (uint32_t)d4 & 0x3ffffff;
+        h0 += (uint32_t)(d4 >> 26) * 5;
+        h1 += h0 >> 26;
+        h0 &= 0x3ffffff;
+    }
+
+    _h[0] = h0;
+    _h[1] = h1;
+    _h[2] = h2;
+    _h[3] = h3;
+    _h[4] = h4;
+}
+
+void ChaCha20Poly1305Context::polyFinish(uint8_t *tag)
+{
+    polyPad();
+    uint8_t lengths[16];
+    store64le(lengths, _aadLength);
+    store64le(lengths + 8, _dataLength);
+    polyBlocks(lengths, 1);
+
+    uint32_t h0 = _h[0], h1 = _h[1], h2 = _h[2], h3 = _h[3], h4 = _h[4];
+    uint32_t c = h1 >> 26;
+    h1 &= 0x3ffffff;
+    h2 += c;
+    c = h2 >> 26;
+    h2 &= 0x3ffffff;
+    h3 += c;
+    c = h3 >> 26;
+    h3 &= 0x3ffffff;
+    h4 += c;
+    c = h4 >> 26;
+    h4 &= 0x3ffffff;
+    h0 += c * 5;
+    c = h0 >> 26;
+    h0 &= 0x3ffffff;
+    h1 += c;
+
+    // h - p, selected in constant time if h >= p
+    uint32_t g0 = h0 + 5;
+    c = g0 >> 26;
+    g0 &= 0x3ffffff;
+    uint32_t g1 = h1 + c;
+    c = g1 >> 26;
+    g1 &= 0x3ffffff;
+    uint32_t g2 = h2 + c;
+    c = g2 >> 26;
+    g2 &= 0x3ffffff;
+    uint32_t g3 = h3 + c;
+    c = g3 >> 26;
+    g3 &= 0x3ffffff;
+    const uint32_t g4 = h4 + c - (1 << 26);
+
+    const uint32_t mask = (g4 >> 31) - 1;
+    h0 = (h0 & ~mask) | (g0 & mask);
+    h1 = (h1 & ~mask) | (g1 & mask);
+    h2 = (h2 & ~mask) | (g2 & mask);
+    h3 = (h3 & ~mask) | (g3 & mask);
+    h4 = (h4 & ~mask) | (g4 & mask);
+
+    // h % 2^128 + pad
+    h0 = h0 | (h1 << 26);
+    h1 = (h1 >> 6) | (h2 << 20);
+    h2 = (h2 >> 12) | (h3 << 14);
+    h3 = (h3 >> 18) | (h4 << 8);
+    uint64_t f = (uint64_t)h0 + _pad[0];
+    store32le(tag, f);
+    f = (uint64_t)h1 + _pad[1] + (f >> 32);
+    store32le(tag + 4, f);
+    f = (uint64_t)h2 + _pad[2] + (f >> 32);
+    store32le(tag + 8, f);
+    f = (uint64_t)h3 + _pad[3] + (f >> 32);
+    store32le(tag + 12, f);
+
+    memset(_h, 0, sizeof _h);
+}
 }
 }
@@ -104,6 +104,14 @@ struct MD5
 {
     static constexpr uint8_t NATURAL_LENGTH = 16;
 
+    /**
+        The BearSSL hash implementation, for HashContext and HmacContext.
+    */
+    static const br_hash_class *hashClass()
+    {
+        return &br_md5_vtable;
+    }
+
     /**
         WARNING! The MD5 hash is broken in terms of attacker resistance.
         Only use it in those cases where attacker resistance is not important. Prefer SHA-256 or higher otherwise.
@@ -202,6 +210,14 @@ struct SHA1
 {
     static constexpr uint8_t NATURAL_LENGTH = 20;
 
+    /**
+        The BearSSL hash implementation, for HashContext and HmacContext.
+    */
+    static const br_hash_class *hashClass()
+    {
+        return &br_sha1_vtable;
+    }
+
     /**
         WARNING! The SHA-1 hash is broken in terms of attacker resistance.
         Only use it in those cases where attacker resistance is not important. Prefer SHA-256 or higher otherwise.
@@ -300,6 +316,14 @@ struct SHA224
 {
     static constexpr uint8_t NATURAL_LENGTH = 28;
 
+    /**
+        The BearSSL hash implementation, for HashContext and HmacContext.
+    */
+    static const br_hash_class *hashClass()
+    {
+        return &br_sha224_vtable;
+    }
+
     /**
         Create a SHA224 hash of the data. The result will be NATURAL_LENGTH bytes long and stored in resultArray.
         Uses the BearSSL cryptographic library.
@@ -392,6 +416,14 @@ struct SHA256
 {
     static constexpr uint8_t NATURAL_LENGTH = 32;
 
+    /**
+        The BearSSL hash implementation, for HashContext and HmacContext.
+    */
+    static const br_hash_class *hashClass()
+    {
+        return &br_sha256_vtable;
+    }
+
     /**
         Create a SHA256 hash of the data. The result will be NATURAL_LENGTH bytes long and stored in resultArray.
         Uses the BearSSL cryptographic library.
@@ -484,6 +516,14 @@ struct SHA384
 {
     static constexpr uint8_t NATURAL_LENGTH = 48;
 
+    /**
+        The BearSSL hash implementation, for HashContext and HmacContext.
+    */
+    static const br_hash_class *hashClass()
+    {
+        return &br_sha384_vtable;
+    }
+
     /**
         Create a SHA384 hash of the data. The result will be NATURAL_LENGTH bytes long and stored in resultArray.
         Uses the BearSSL cryptographic library.
@@ -576,6 +616,14 @@ struct SHA512
 {
     static constexpr uint8_t NATURAL_LENGTH = 64;
 
+    /**
+        The BearSSL hash implementation, for HashContext and HmacContext.
+    */
+    static const br_hash_class *hashClass()
+    {
+        return &br_sha512_vtable;
+    }
+
     /**
         Create a SHA512 hash of the data. The result will be NATURAL_LENGTH bytes long and stored in resultArray.
         Uses the BearSSL cryptographic library.
@@ -698,6 +746,125 @@ struct MD5SHA1
 };
 
 
+// #################### Incremental hash and HMAC ####################
+
+/**
+    Hash data that arrives in pieces, for instance network chunks or flash sectors, without collecting it in one buffer first.
+    Use the HashContext<SHA256> (or any of MD5, SHA1, SHA224, SHA384, SHA512) template below.
+    Uses the BearSSL cryptographic library.
+*/
+class BasicHashContext
+{
+public:
+
+    explicit BasicHashContext(const br_hash_class *hashType);
+
+    /**
+        Start a new hash, dropping the data given so far.
+    */
+    void reset();
+
+    /**
+        Add dataLength bytes of data to the hash.
+    */
+    void update(const void *data, const size_t dataLength);
+    void update(const String &message);
+
+    /**
+        Store the hash of the data given so far in resultArray, which MUST be able to contain length() bytes.
+        The context is not modified, so more data may follow.
+
+        @return A pointer to resultArray.
+    */
+    void *finish(void *resultArray) const;
+
+    /**
+        @return A String with the hash of the data given so far in HEX format.
+    */
+    String finish() const;
+
+    /**
+        @return The length of the hash in bytes.
+    */
+    size_t length() const;
+
+private:
+
+    br_hash_compat_context hashContext;
+};
+
+template <typename HashT>
+class HashContext : public BasicHashContext
+{
+public:
+
+    HashContext() : BasicHashContext(HashT::hashClass()) {}
+};
+
+/**
+    An HMAC of data that arrives in pieces. Use the HmacContext<SHA256> (or any of MD5, SHA1, SHA224, SHA384, SHA512) template below.
+    Uses the BearSSL cryptographic library.
+*/
+class BasicHmacContext
+{
+public:
+
+    /**
+        @param hashType The BearSSL hash implementation.
+        @param hashKey The hash key to use when creating the HMAC.
+        @param hashKeyLength The length of the hash key in bytes.
+        @param outputLength The desired length of the generated HMAC, in bytes. If outputLength is 0 or greater than the natural HMAC output length,
+                           the natural HMAC output length is selected.
+    */
+    BasicHmacContext(const br_hash_class *hashType, const void *hashKey, const size_t hashKeyLength, const size_t outputLength = 0);
+    ~BasicHmacContext();
+
+    /**
+        Start a new HMAC with the same key, dropping the data given so far.
+    */
+    void reset();
+
+    /**
+        Add dataLength bytes of data to the HMAC.
+    */
+    void update(const void *data, const size_t dataLength);
+    void update(const String &message);
+
+    /**
+        Store the HMAC of the data given so far in resultArray, which MUST be able to contain length() bytes.
+        The context is not modified, so more data may follow.
+
+        @return A pointer to resultArray.
+    */
+    void *finish(void *resultArray) const;
+
+    /**
+        @return A String with the HMAC of the data given so far in HEX format.
+    */
+    String finish() const;
+
+    /**
+        @return The length of the HMAC in bytes.
+    */
+    size_t length() const;
+
+private:
+
+    br_hmac_key_context keyContext;
+    br_hmac_context hmacContext;
+    size_t hmacLength;
+};
+
+template <typename HashT>
+class HmacContext : public BasicHmacContext
+{
+public:
+
+    HmacContext(const void *hashKey, const size_t hashKeyLength, const size_t outputLength = 0)
+        : BasicHmacContext(HashT::hashClass(), hashKey, hashKeyLength, outputLength) {}
+};
+
+
 // #################### HKDF ####################
 
 struct HKDF
@@ -840,6 +1007,84 @@ struct ChaCha20Poly1305
     */
     static bool decrypt(void *data, const size_t dataLength, const void *key, const void *keySalt, const size_t keySaltLength, const void *encryptionNonce, const void *encryptionTag, const void *aad = nullptr, const size_t aadLength = 0);
 };
+
+/**
+    ChaCha20+Poly1305 for data that arrives in pieces, compatible with ChaCha20Poly1305::encrypt and ChaCha20Poly1305::decrypt.
+    Uses the ChaCha20 implementation of the BearSSL cryptographic library, and its own Poly1305.
+
+    Encryption: beginEncrypt(), then addAad() zero or more times, then update() for each piece of data, then finish().
+    Decryption: beginDecrypt(), then addAad() zero or more times, then update() for each piece of data, then verify().
+    Decrypted data must not be used before verify() has returned true.
+*/
+class ChaCha20Poly1305Context
+{
+public:
+
+    ~ChaCha20Poly1305Context();
+
+    /**
+        Start an encryption. The key, keySalt and the nonce generation are the same as for ChaCha20Poly1305::encrypt.
+
+        @param resultingNonce The array that will store the generated nonce. Must be able to contain at least 12 bytes.
+    */
+    void beginEncrypt(const void *key, const void *keySalt, const size_t keySaltLength, void *resultingNonce);
+
+    /**
+        Start a decryption. The parameters are the same as for ChaCha20Poly1305::decrypt.
+    */
+    void beginDecrypt(const void *key, const void *keySalt, const size_t keySaltLength, const void *encryptionNonce);
+
+    /**
+        Add additional authenticated data. All of it must be given before the first update().
+    */
+    void addAad(const void *aad, const size_t aadLength);
+
+    /**
+        Encrypt or decrypt the next dataLength bytes of data in place.
+    */
+    void update(void *data, const size_t dataLength);
+
+    /**
+        End an encryption.
+
+        @param resultingTag The array that will store the message authentication tag. Must be able to contain at least 16 bytes.
+    */
+    void finish(void *resultingTag);
+
+    /**
+        End a decryption.
+
+        @param encryptionTag An array containing the message authentication tag that was generated during encryption. The tag should be 16 bytes.
+
+        @return True if the generated tag matches encryptionTag. False otherwise.
+    */
+    bool verify(const void *encryptionTag);
+
+private:
+
+    void begin(const void *key, const void *keySalt, const size_t keySaltLength, const void *nonce, const bool encrypt);
+    void polyUpdate(const uint8_t *data, size_t dataLength);
+    void polyPad();
+    void polyBlocks(const uint8_t *data, size_t blockCount);
+    void polyFinish(uint8_t *tag);
+
+    uint8_t _key[ENCRYPTION_KEY_LENGTH];
+    uint8_t _nonce[12];
+    uint32_t _counter;
+    uint8_t _keystream[64];
+    uint8_t _keystreamUsed;
+    bool _encrypt;
+    bool _inData;
+    uint64_t _aadLength;
+    uint64_t _dataLength;
+
+    // Poly1305 state, 26 bit limbs
+    uint32_t _r[5];
+    uint32_t _h[5];
+    uint32_t _pad[4];
+    uint8_t _buffer[16];
+    uint8_t _buffered;
+};
 }
 }
 #endif
@@ -29,7 +29,9 @@ void EspClass::getHeapStats(uint32_t* hfree, uint16_t* hmax, uint8_t* hfrag)
     // Having getFreeHeap()=sum(hole-size), fragmentation is given by
     // 100 * (1 - sqrt(sum(hole-size²)) / sum(hole-size))
 
+#ifndef UMM_INLINE_METRICS
     umm_info(NULL, false);
+#endif
 
     uint32_t free_size = umm_free_heap_size_core(umm_get_current_heap());
     if (hfree)
@@ -20,12 +20,15 @@
 
 #include "Esp.h"
 #include "flash_utils.h"
+#include "flash_hal.h"
 #include "eboot_command.h"
 #include <memory>
 #include "interrupts.h"
 #include "MD5Builder.h"
 #include "umm_malloc/umm_malloc.h"
 #include "cont.h"
+#include "StackThunk.h"
+#include "Schedule.h"
 
 #include "coredecls.h"
 #include "umm_malloc/umm_malloc.h"
@@ -140,6 +143,11 @@ uint64_t EspClass::deepSleepMax()
 
 }
 
+void EspClass::setTicklessDelay(uint32_t minSleepMs)
+{
+    delay_set_tickless(minSleepMs);
+}
+
 /*
 Layout of RTC Memory is as follows:
 Ref: Espressif doc 2C-ESP8266_Non_OS_SDK_API_Reference, section 3.3.23 (system_rtc_mem_write)
@@ -192,6 +200,66 @@ bool EspClass::rtcUserMemoryWrite(uint32_t offset, uint32_t *data, size_t size)
     }
 }
 
+bool EspClass::crashLogBegin(size_t records)
+{
+    if (records == 0 || records > CRASHLOG_MAX_RECORDS) {
+        return false;
+    }
+    if (crashlog_capacity() != records) {
+        CRASHLOG_RTC[CRASHLOG_RTC_BLOCKS - 2] = 0;
+        CRASHLOG_RTC[CRASHLOG_RTC_BLOCKS - 1] = CRASHLOG_MAGIC ^ records;
+    }
+
+    // A hardware WDT reset leaves a record only when the stack dump at
+    // boot is built in, add a bare one otherwise (once per boot)
+    static bool checked = false;
+    if (!checked) {
+        checked = true;
+        const uint32_t written = crashlog_written();
+        volatile uint32_t* newest = written ? crashlog_slot(records, written - 1) : nullptr;
+        crashlog_record_t record;
+        if (newest) {
+            for (size_t i = 0; i < CRASHLOG_RECORD_BLOCKS; ++i) {
+                ((uint32_t*)&record)[i] = newest[i];
+            }
+        }
+        if (newest && (record.ctx & CRASHLOG_CTX_AT_BOOT)) {
+            record.ctx &= ~CRASHLOG_CTX_AT_BOOT;
+            newest[offsetof(crashlog_record_t, ctx) / 4] = ((uint32_t*)&record)[offsetof(crashlog_record_t, ctx) / 4];
+        } else if (resetInfo.reason == REASON_WDT_RST) {
+            memset(&record, 0, sizeof(record));
+            record.reason = REASON_WDT_RST;
+            crashlog_add(&record);
+        }
+    }
+    return true;
+}
+
+size_t EspClass::crashLogCount()
+{
+    const uint32_t capacity = crashlog_capacity();
+    const uint32_t written = crashlog_written();
+    return written < capacity ? written : capacity;
+}
+
+bool EspClass::crashLogRead(size_t index, crashlog_record_t& record)
+{
+    if (index >= crashLogCount()) {
+        return false;
+    }
+    const uint32_t capacity = crashlog_capacity();
+    volatile uint32_t* src = crashlog_slot(capacity, crashlog_written() - crashLogCount() + index);
+    for (size_t i = 0; i < CRASHLOG_RECORD_BLOCKS; ++i) {
+        ((uint32_t*)&record)[i] = src[i];
+    }
+    return true;
+}
+
+void EspClass::crashLogClear()
+{
+    CRASHLOG_RTC[CRASHLOG_RTC_BLOCKS - 2] = 0;
+}
+
 void EspClass::reset(void)
 {
     __real_system_restart_local();
@@ -239,6 +307,117 @@ void EspClass::resetFreeContStack()
     cont_repaint_stack(g_pcont);
 }
 
+/*
+  Stack sampling.  Unused stack is painted, so the free part of a stack is
+  the run of paint at its bottom: a sample costs one load per free word,
+  and only the minimum is kept.  The SYS stack starts above the ROM BSS
+  and, while loop() runs, is unused below the SP saved by cont_run().
+*/
+#define SYS_STACK_BOTTOM ((uint32_t*)0x3fffeb30UL)
+#define SYS_STACK_PAINT 0xfeefeffe
+#define THUNK_STACK_PAINT 0xdeadbeef
+
+static StackWatermarks s_stackWatermarks;
+static uint32_t s_stackSamplingRun = 0;
+
+static uint32_t stack_painted_bytes(const uint32_t* pos, const uint32_t* end, uint32_t paint)
+{
+    const uint32_t* start = pos;
+    while (pos < end && *pos == paint) {
+        ++pos;
+    }
+    return (pos - start) * 4;
+}
+
+static void stack_watermark_update(StackWatermark& mark, uint32_t free, uint32_t now)
+{
+    if (!mark.time || free < mark.free) {
+        mark.free = free;
+        mark.time = now ? now : 1;
+    }
+}
+
+void EspClass::sampleStacks()
+{
+    const uint32_t now = millis();
+    const uint32_t* sysTop = g_pcont->sp_ret;
+    if (sysTop > SYS_STACK_BOTTOM) {
+        stack_watermark_update(s_stackWatermarks.sys, stack_painted_bytes(SYS_STACK_BOTTOM, sysTop, SYS_STACK_PAINT), now);
+    }
+    stack_watermark_update(s_stackWatermarks.cont, cont_get_free_stack(g_pcont), now);
+    if (stack_thunk_get_refcnt()) {
+        const uint32_t* bot = (const uint32_t*)stack_thunk_get_stack_bot();
+        const uint32_t* top = (const uint32_t*)stack_thunk_get_stack_top();
+        stack_watermark_update(s_stackWatermarks.thunk, stack_painted_bytes(bot, top + 1, THUNK_STACK_PAINT), now);
+    }
+}
+
+void EspClass::startStackSampling(uint32_t intervalMs)
+{
+    // Only loop() may repaint: SYS is suspended then, and the 64 bytes
+    // below its SP are left alone
+    if (!can_yield()) {
+        return;
+    }
+    for (uint32_t* pos = SYS_STACK_BOTTOM; pos < g_pcont->sp_ret - 16; ++pos) {
+        *pos = SYS_STACK_PAINT;
+    }
+    cont_repaint_stack(g_pcont);
+    const uint32_t sp = (uint32_t)__builtin_frame_address(0);
+    if (stack_thunk_get_refcnt() &&
+        (sp < stack_thunk_get_stack_bot() || sp > stack_thunk_get_stack_top())) {
+        // not from a BearSSL callback running on that stack
+        stack_thunk_repaint();
+    }
+    s_stackWatermarks = StackWatermarks();
+    sampleStacks();
+
+    const uint32_t run = ++s_stackSamplingRun;
+    schedule_recurrent_function_us([run]() {
+        if (run != s_stackSamplingRun) {
+            return false;
+        }
+        sampleStacks();
+        return true;
+    }, intervalMs * 1000);
+}
+
+void EspClass::stopStackSampling()
+{
+    ++s_stackSamplingRun;
+}
+
+StackWatermarks EspClass::getStackWatermarks()
+{
+    return s_stackWatermarks;
+}
+
+static uint32_t s_heapCheckRun = 0;
+
+void EspClass::startHeapCheck(uint32_t intervalMs, uint16_t blocksPerStep, void (*onCorruption)(void* where))
+{
+    const uint32_t run = ++s_heapCheckRun;
+    schedule_recurrent_function_us([run, blocksPerStep, onCorruption]() {
+        if (run != s_heapCheckRun) {
+            return false;
+        }
+        void* where = nullptr;
+        if (umm_integrity_check_step(blocksPerStep, &where)) {
+            return true;
+        }
+        if (!onCorruption) {
+            panic();
+        }
+        onCorruption(where);
+        return false;
+    }, intervalMs * 1000);
+}
+
+void EspClass::stopHeapCheck()
+{
+    ++s_heapCheckRun;
+}
+
 uint32_t EspClass::getChipId(void)
 {
     return system_get_chip_id();
@@ -512,6 +691,10 @@ struct rst_info * EspClass::getResetInfoPtr(void) {
     return &resetInfo;
 }
 
+const boot_profile_t& EspClass::getBootProfile() {
+    return boot_profile;
+}
+
 bool EspClass::eraseConfig(void) {
     const size_t cfgSize = 0x4000;
     size_t cfgAddr = ESP.getFlashChipSize() - cfgSize;
@@ -667,6 +850,7 @@ bool EspClass::updateSketch(Stream& in, uint32_t size, bool restartOnFail, bool
 static const int FLASH_INT_MASK = ((B10 << 8) | B00111010);
 
 bool EspClass::flashEraseSector(uint32_t sector) {
+    flash_hal_cache_invalidate(sector * SPI_FLASH_SEC_SIZE, SPI_FLASH_SEC_SIZE);
     int rc = spi_flash_erase_sector(sector);
     return rc == 0;
 }
@@ -726,6 +910,7 @@ bool EspClass::flashReplaceBlock(uint32_t address, const uint8_t *value, uint32_
         // Only one 4 byte block is supported
         return false;
     }
+    flash_hal_cache_invalidate(alignedAddress, 4);
 #if PUYA_SUPPORT
     if (getFlashChipVendorId() == SPI_FLASH_VENDOR_PUYA) {
         uint8_t tempData[4] __attribute__((aligned(4)));
@@ -819,6 +1004,7 @@ bool EspClass::flashWrite(uint32_t address, const uint32_t *data, size_t size) {
     if ((uintptr_t)data % 4 != 0 || size % 4 != 0 || pageBreak) {
         return false;
     }
+    flash_hal_cache_invalidate(address, size);
 #if PUYA_SUPPORT
     if (getFlashChipVendorId() == SPI_FLASH_VENDOR_PUYA) {
         rc = spi_flash_write_puya(address, const_cast<uint32_t *>(data), size);
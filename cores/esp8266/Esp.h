@@ -24,6 +24,9 @@
 #include <Arduino.h>
 #include "core_esp8266_features.h"
 #include "spi_vendors.h"
+#include "core_esp8266_crashlog.h"
+#include "core_esp8266_fastboot.h"
+#include "flash_quirks.h"
 
 /**
  * AVR macros for WDT management
@@ -59,6 +62,13 @@ enum RFMode {
 
 #define RF_MODE(mode) int __get_rf_mode() { return mode; }
 #define RF_PRE_INIT() void __run_user_rf_pre_init()
+// Skip the RF calibration at boot while the last one is recent, using
+// two words of RTC user memory at rtcBlock (see core_esp8266_fastboot.h)
+#define FAST_BOOT(rtcBlock) int __get_fast_boot_block() { return (rtcBlock); }
+// Raise the flash clock from 40 to 80MHz (FLASH_FAST_CLOCK) and/or switch
+// its reads to QIO (FLASH_FAST_QIO) at boot, when the chip is known to
+// support it (see flash_quirks.h)
+#define FLASH_FAST_MODE(modes) int __get_flash_fast_mode() { return (modes); }
 
 // compatibility definitions
 #define WakeMode RFMode
@@ -84,6 +94,19 @@ typedef enum {
      FM_UNKNOWN = 0xff
 } FlashMode_t;
 
+// Smallest free stack (bytes) seen by the stack sampler, and the millis()
+// of the sample that first saw it.  time is 0 until the stack was sampled.
+struct StackWatermark {
+    uint32_t free;
+    uint32_t time;
+};
+
+struct StackWatermarks {
+    StackWatermark sys;     // SDK (SYS) stack
+    StackWatermark cont;    // loop() stack
+    StackWatermark thunk;   // BearSSL stack, only while it is allocated
+};
+
 class EspClass {
     public:
         // TODO: figure out how to set WDT timeout
@@ -98,9 +121,25 @@ class EspClass {
         static void deepSleepInstant(uint64_t time_us, RFMode mode = RF_DEFAULT);
         static uint64_t deepSleepMax();
 
+        // With WiFi off, let delay() sleep in forced light sleep when it
+        // would wait at least `minSleepMs`, 0 disables it.  millis() and
+        // micros() keep counting, os_timers and Ticker are late by the
+        // time slept.  A wakeup pin set by gpio_pin_wakeup_enable() ends
+        // the delay() early.
+        static void setTicklessDelay(uint32_t minSleepMs = 20);
+
         static bool rtcUserMemoryRead(uint32_t offset, uint32_t *data, size_t size);
         static bool rtcUserMemoryWrite(uint32_t offset, uint32_t *data, size_t size);
 
+        // Reserve the end of the RTC user memory for the last `records`
+        // crash records (at most CRASHLOG_MAX_RECORDS), which postmortem and
+        // the hardware WDT dump write.  A ring of the same size is kept.
+        static bool crashLogBegin(size_t records = 4);
+        static size_t crashLogCount();
+        // index 0 is the oldest record kept
+        static bool crashLogRead(size_t index, crashlog_record_t& record);
+        static void crashLogClear();
+
         static void reset();
         static void restart();
 	/**
@@ -121,6 +160,24 @@ class EspClass {
         static uint32_t getFreeContStack();
         static void resetFreeContStack();
 
+        // Repaint the SYS, loop() and BearSSL stacks, then record their
+        // smallest free size every intervalMs from the scheduler.  Each
+        // sample scans the untouched part of the stacks only.
+        static void startStackSampling(uint32_t intervalMs = 1000);
+        static void stopStackSampling();
+        // Take one sample now (also works without startStackSampling())
+        static void sampleStacks();
+        static StackWatermarks getStackWatermarks();
+
+        // Check the links of blocksPerStep heap blocks every intervalMs
+        // from the scheduler, going round all the heaps, so corruption is
+        // found soon after it happens without a long stop with interrupts
+        // disabled.  onCorruption gets the address of the broken block
+        // header, without a callback it is a panic().
+        static void startHeapCheck(uint32_t intervalMs = 10, uint16_t blocksPerStep = 32,
+                                   void (*onCorruption)(void* where) = nullptr);
+        static void stopHeapCheck();
+
         static const char * getSdkVersion();
         static String getCoreVersion();
         static String getFullVersion();
@@ -207,6 +264,8 @@ class EspClass {
         static String getResetReason();
         static String getResetInfo();
         static struct rst_info * getResetInfoPtr();
+        // Cycle counts at each step of this boot, see core_esp8266_fastboot.h
+        static const boot_profile_t& getBootProfile();
 
         static bool eraseConfig();
 
@@ -0,0 +1,265 @@
+#ifndef __EVENTLOOP_H__
+#define __EVENTLOOP_H__
+
+/*
+ EventLoop.h - fixed size, allocation free dispatcher of timers and
+ readiness sources
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <stddef.h>
+#include "PolledTimeout.h"
+
+namespace esp8266
+{
+
+/*
+  Up to TimersN timers and SourcesN sources live in fixed arrays, and
+  callbacks are plain function pointers with a void* argument, so nothing
+  is allocated.  A source is a readiness test, for instance
+  WiFiClient::available() or a flag raised by a GPIO interrupt, with the
+  callback to run when it holds.
+
+  runOnce() runs the timers that are due, nearest deadline first and each
+  at most once, then the callbacks of the sources that are ready.
+  Periodic timers keep their phase like polledTimeout::periodic.  Calls
+  from loop() are fine; run() is a replacement for loop() itself.
+  Callbacks may add and remove timers and sources.
+*/
+template <size_t TimersN, size_t SourcesN, typename TimePolicyT = polledTimeout::TimePolicy::TimeMillis>
+class EventLoop
+{
+public:
+  using timeType = typename TimePolicyT::timeType;
+  typedef void (*callback_t)(void* arg);
+  typedef bool (*ready_t)(void* arg);
+
+  static constexpr int invalid = -1;
+  static constexpr timeType neverExpires = std::numeric_limits<timeType>::max();
+
+  // Call callback(arg) after `timeout`, then every `period` unless it is 0.
+  // Returns the timer id, or invalid when all timers are in use.
+  int addTimer(timeType timeout, timeType period, callback_t callback, void* arg = nullptr)
+  {
+    for (size_t i = 0; i < TimersN; ++i)
+    {
+      Timer& t = _timers[i];
+      if (!t.callback)
+      {
+        t.callback = callback;
+        t.arg = arg;
+        t.start = TimePolicyT::time();
+        t.timeout = TimePolicyT::toTimeTypeUnit(timeout);
+        t.period = TimePolicyT::toTimeTypeUnit(period);
+        return i;
+      }
+    }
+    return invalid;
+  }
+
+  template <typename TArg>
+  int addTimer(timeType timeout, timeType period, void (*callback)(TArg*), TArg* arg)
+  {
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wcast-function-type"
+    return addTimer(timeout, period, reinterpret_cast<callback_t>(callback), static_cast<void*>(arg));
+#pragma GCC diagnostic pop
+  }
+
+  bool removeTimer(int id)
+  {
+    if (id < 0 || (size_t)id >= TimersN || !_timers[id].callback)
+      return false;
+    _timers[id].callback = nullptr;
+    return true;
+  }
+
+  // Call callback(arg) from runOnce() whenever ready(arg) is true.
+  // Returns the source id, or invalid when all sources are in use.
+  int addSource(ready_t ready, callback_t callback, void* arg = nullptr)
+  {
+    for (size_t i = 0; i < SourcesN; ++i)
+    {
+      Source& s = _sources[i];
+      if (!s.callback)
+      {
+        s.ready = ready;
+        s.callback = callback;
+        s.arg = arg;
+        return i;
+      }
+    }
+    return invalid;
+  }
+
+  // A Stream, WiFiClient, ... is ready when available() > 0
+  template <typename T>
+  int addSource(T* stream, void (*callback)(T*))
+  {
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wcast-function-type"
+    return addSource([](void* arg) { return static_cast<T*>(arg)->available() > 0; },
+                     reinterpret_cast<callback_t>(callback), static_cast<void*>(stream));
+#pragma GCC diagnostic pop
+  }
+
+  // A flag raised by an interrupt, it is cleared before the callback runs
+  int addFlag(volatile bool* flag, callback_t callback)
+  {
+    for (size_t i = 0; i < SourcesN; ++i)
+    {
+      Source& s = _sources[i];
+      if (!s.callback)
+      {
+        s.ready = nullptr;
+        s.flag = flag;
+        s.callback = callback;
+        s.arg = const_cast<bool*>(flag);
+        return i;
+      }
+    }
+    return invalid;
+  }
+
+  bool removeSource(int id)
+  {
+    if (id < 0 || (size_t)id >= SourcesN || !_sources[id].callback)
+      return false;
+    _sources[id].callback = nullptr;
+    _sources[id].flag = nullptr;
+    return true;
+  }
+
+  // Returns the number of callbacks run
+  size_t runOnce()
+  {
+    size_t done = 0;
+    bool ran[TimersN] = { };
+    while (true)
+    {
+      const timeType now = TimePolicyT::time();
+      int nearest = invalid;
+      timeType late = 0;
+      for (size_t i = 0; i < TimersN; ++i)
+      {
+        const Timer& t = _timers[i];
+        const timeType elapsed = now - t.start;
+        if (t.callback && !ran[i] && elapsed >= t.timeout && (nearest == invalid || elapsed - t.timeout > late))
+        {
+          nearest = i;
+          late = elapsed - t.timeout;
+        }
+      }
+      if (nearest == invalid)
+        break;
+
+      Timer& t = _timers[nearest];
+      ran[nearest] = true;
+      const callback_t callback = t.callback;
+      void* const arg = t.arg;
+      if (t.period)
+      {
+        // skip the periods that were missed
+        const timeType elapsed = now - t.start - t.timeout;
+        t.start += t.timeout + (elapsed / t.period) * t.period;
+        t.timeout = t.period;
+      }
+      else
+      {
+        t.callback = nullptr;
+      }
+      callback(arg);
+      ++done;
+    }
+
+    for (size_t i = 0; i < SourcesN; ++i)
+    {
+      Source& s = _sources[i];
+      if (!s.callback)
+        continue;
+      if (s.flag)
+      {
+        if (!*s.flag)
+          continue;
+        *s.flag = false;
+      }
+      else if (!s.ready(s.arg))
+      {
+        continue;
+      }
+      s.callback(s.arg);
+      ++done;
+    }
+    return done;
+  }
+
+  // Time until the nearest timer is due, 0 if one is, neverExpires if
+  // there is none
+  timeType untilNext() const
+  {
+    const timeType now = TimePolicyT::time();
+    timeType nearest = neverExpires;
+    bool any = false;
+    for (size_t i = 0; i < TimersN; ++i)
+    {
+      const Timer& t = _timers[i];
+      if (!t.callback)
+        continue;
+      const timeType elapsed = now - t.start;
+      const timeType remaining = elapsed >= t.timeout ? 0 : t.timeout - elapsed;
+      if (!any || remaining < nearest)
+        nearest = remaining;
+      any = true;
+    }
+    return any ? TimePolicyT::toUserUnit(nearest) : neverExpires;
+  }
+
+  // Never returns: dispatches and yields forever
+  [[noreturn]] void run()
+  {
+    while (true)
+    {
+      runOnce();
+      delay(0);
+    }
+  }
+
+protected:
+  struct Timer
+  {
+    callback_t callback = nullptr;
+    void* arg = nullptr;
+    timeType start = 0;
+    timeType timeout = 0;
+    timeType period = 0;
+  };
+
+  struct Source
+  {
+    ready_t ready = nullptr;
+    volatile bool* flag = nullptr;
+    callback_t callback = nullptr;
+    void* arg = nullptr;
+  };
+
+  Timer _timers[TimersN];
+  Source _sources[SourcesN];
+};
+
+} // namespace esp8266
+
+#endif // __EVENTLOOP_H__
@@ -20,15 +20,355 @@
 
 #include "FS.h"
 #include "FSImpl.h"
+#include <vector>
 
 using namespace fs;
 
 static bool sflags(const char* mode, OpenMode& om, AccessMode& am);
 
+namespace fs {
+
+/*
+  Entries of recently completed listings, see FS::setDirCache().  A
+  listing is recorded while the application walks a Dir and stored once
+  next() reports the end, unless something was changed in the meantime.
+  Any change on the FS drops all listings.
+*/
+struct DirCacheEntry {
+    String name;
+    size_t size;
+    time_t time;
+    time_t creationTime;
+    bool directory;
+};
+
+typedef std::vector<DirCacheEntry> DirCacheEntries;
+
+class DirCache {
+public:
+    DirCache(size_t maxEntries) : _maxEntries(maxEntries) { }
+
+    void invalidate() {
+        ++_generation;
+        _listings.clear();
+        _used = 0;
+    }
+
+    std::shared_ptr<const DirCacheEntries> find(const char* path) {
+        for (auto& listing : _listings) {
+            if (listing.path == path) {
+                listing.lastUse = ++_tick;
+                return listing.entries;
+            }
+        }
+        return nullptr;
+    }
+
+    void store(const char* path, uint32_t generation, std::shared_ptr<const DirCacheEntries> entries) {
+        if (generation != _generation || entries->size() > _maxEntries) {
+            return;
+        }
+        while (_used + entries->size() > _maxEntries) {
+            // Drop the least recently used listing
+            auto victim = _listings.begin();
+            for (auto it = _listings.begin(); it != _listings.end(); ++it) {
+                if (it->lastUse < victim->lastUse) {
+                    victim = it;
+                }
+            }
+            _used -= victim->entries->size();
+            _listings.erase(victim);
+        }
+        _listings.push_back({path, entries, ++_tick});
+        _used += entries->size();
+    }
+
+    uint32_t generation() const { return _generation; }
+    size_t maxEntries() const { return _maxEntries; }
+
+protected:
+    struct Listing {
+        String path;
+        std::shared_ptr<const DirCacheEntries> entries;
+        uint32_t lastUse;
+    };
+
+    size_t _maxEntries;
+    size_t _used = 0;
+    uint32_t _generation = 0;
+    uint32_t _tick = 0;
+    std::vector<Listing> _listings;
+};
+
+// Replays a cached listing without touching the filesystem
+class CachedDirImpl : public DirImpl {
+public:
+    CachedDirImpl(FSImplPtr fs, const char* path, std::shared_ptr<const DirCacheEntries> entries)
+        : _fs(fs), _path(path), _entries(entries) { }
+
+    FileImplPtr openFile(OpenMode openMode, AccessMode accessMode) override {
+        if (!_valid()) {
+            return FileImplPtr();
+        }
+        String path = _path;
+        if (path.length() && path[path.length() - 1] != '/') {
+            path += "/";
+        }
+        path += _entry().name;
+        return _fs->open(path.c_str(), openMode, accessMode);
+    }
+    const char* fileName() override { return _valid() ? _entry().name.c_str() : nullptr; }
+    size_t fileSize() override { return _valid() ? _entry().size : 0; }
+    time_t fileTime() override { return _valid() ? _entry().time : 0; }
+    time_t fileCreationTime() override { return _valid() ? _entry().creationTime : 0; }
+    bool isFile() const override { return _valid() && !_entry().directory; }
+    bool isDirectory() const override { return _valid() && _entry().directory; }
+    bool next() override {
+        if (_count <= _entries->size()) {
+            ++_count;
+        }
+        return _valid();
+    }
+    bool rewind() override {
+        _count = 0;
+        return true;
+    }
+
+protected:
+    bool _valid() const { return _count > 0 && _count <= _entries->size(); }
+    const DirCacheEntry& _entry() const { return (*_entries)[_count - 1]; }
+
+    FSImplPtr _fs;
+    String _path;
+    std::shared_ptr<const DirCacheEntries> _entries;
+    size_t _count = 0; // calls to next() so far, the current entry is the last one
+};
+
+// Passes a real Dir through and records the entries it returns
+class RecordingDirImpl : public DirImpl {
+public:
+    RecordingDirImpl(DirImplPtr dir, std::shared_ptr<DirCache> cache, const char* path)
+        : _dir(dir), _cache(cache), _path(path) {
+        _start();
+    }
+
+    FileImplPtr openFile(OpenMode openMode, AccessMode accessMode) override {
+        return _dir->openFile(openMode, accessMode);
+    }
+    const char* fileName() override { return _dir->fileName(); }
+    size_t fileSize() override { return _dir->fileSize(); }
+    time_t fileTime() override { return _dir->fileTime(); }
+    time_t fileCreationTime() override { return _dir->fileCreationTime(); }
+    bool isFile() const override { return _dir->isFile(); }
+    bool isDirectory() const override { return _dir->isDirectory(); }
+    bool next() override {
+        bool ret = _dir->next();
+        if (!_entries) {
+            return ret;
+        }
+        if (!ret) {
+            _cache->store(_path.c_str(), _generation, _entries);
+            _entries = nullptr;
+        } else if (_entries->size() >= _cache->maxEntries()) {
+            // Too big to keep, stop collecting
+            _entries = nullptr;
+        } else {
+            _entries->push_back({_dir->fileName(), _dir->fileSize(), _dir->fileTime(),
+                                 _dir->fileCreationTime(), _dir->isDirectory()});
+        }
+        return ret;
+    }
+    bool rewind() override {
+        _start();
+        return _dir->rewind();
+    }
+    void setTimeCallback(time_t (*cb)(void)) override {
+        _timeCallback = cb;
+        _dir->setTimeCallback(cb);
+    }
+
+protected:
+    void _start() {
+        _generation = _cache->generation();
+        _entries = std::make_shared<DirCacheEntries>();
+    }
+
+    DirImplPtr _dir;
+    std::shared_ptr<DirCache> _cache;
+    String _path;
+    uint32_t _generation;
+    std::shared_ptr<DirCacheEntries> _entries;
+};
+
+/*
+  Files opened read-only and closed since, still open in the filesystem,
+  see FS::setFileCache().  open() takes one back for its path instead of
+  resolving the path again.  Any change on the FS closes them all, and a
+  file closed after a change is closed for real.
+*/
+class FileCache {
+public:
+    FileCache(size_t maxFiles) : _maxFiles(maxFiles) { }
+
+    ~FileCache() {
+        invalidate();
+    }
+
+    void invalidate() {
+        ++_generation;
+        for (auto& entry : _files) {
+            entry.file->close();
+        }
+        _files.clear();
+    }
+
+    // Removes and returns the file kept for path, if any
+    FileImplPtr take(const char* path) {
+        for (auto it = _files.begin(); it != _files.end(); ++it) {
+            if (it->path == path) {
+                FileImplPtr file = it->file;
+                _files.erase(it);
+                return file;
+            }
+        }
+        return FileImplPtr();
+    }
+
+    bool contains(const char* path) const {
+        for (const auto& entry : _files) {
+            if (entry.path == path) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void give(const String& path, uint32_t generation, FileImplPtr file) {
+        if (generation != _generation || contains(path.c_str())) {
+            file->close();
+            return;
+        }
+        if (_files.size() >= _maxFiles) {
+            // Close the least recently used file
+            auto victim = _files.begin();
+            for (auto it = _files.begin(); it != _files.end(); ++it) {
+                if (it->lastUse < victim->lastUse) {
+                    victim = it;
+                }
+            }
+            victim->file->close();
+            _files.erase(victim);
+        }
+        _files.push_back({path, file, ++_tick});
+    }
+
+    bool empty() const { return _files.empty(); }
+    uint32_t generation() const { return _generation; }
+
+protected:
+    struct Entry {
+        String path;
+        FileImplPtr file;
+        uint32_t lastUse;
+    };
+
+    size_t _maxFiles;
+    uint32_t _generation = 0;
+    uint32_t _tick = 0;
+    std::vector<Entry> _files;
+};
+
+// A read-only file which goes back to the FileCache when closed
+class CachedFileImpl : public FileImpl {
+public:
+    CachedFileImpl(FileImplPtr file, std::shared_ptr<FileCache> cache, const char* path)
+        : _file(file), _cache(cache), _path(path), _generation(cache->generation()) { }
+
+    ~CachedFileImpl() override {
+        close();
+    }
+
+    size_t write(const uint8_t *buf, size_t size) override {
+        (void) buf;
+        (void) size;
+        return 0;
+    }
+    int read(uint8_t* buf, size_t size) override { return _file ? _file->read(buf, size) : -1; }
+    void flush() override { }
+    bool seek(uint32_t pos, SeekMode mode) override { return _file && _file->seek(pos, mode); }
+    size_t position() const override { return _file ? _file->position() : 0; }
+    size_t size() const override { return _file ? _file->size() : 0; }
+    bool truncate(uint32_t size) override {
+        (void) size;
+        return false;
+    }
+    void close() override {
+        if (_file) {
+            _cache->give(_path, _generation, _file);
+            _file = nullptr;
+        }
+    }
+    const char* name() const override { return _file ? _file->name() : nullptr; }
+    const char* fullName() const override { return _file ? _file->fullName() : nullptr; }
+    bool isFile() const override { return _file && _file->isFile(); }
+    bool isDirectory() const override { return _file && _file->isDirectory(); }
+    void setTimeCallback(time_t (*cb)(void)) override {
+        _timeCallback = cb;
+        if (_file) {
+            _file->setTimeCallback(cb);
+        }
+    }
+    time_t getLastWrite() override { return _file ? _file->getLastWrite() : 0; }
+    time_t getCreationTime() override { return _file ? _file->getCreationTime() : 0; }
+
+protected:
+    FileImplPtr _file;
+    std::shared_ptr<FileCache> _cache;
+    String _path;
+    uint32_t _generation;
+};
+
+} // namespace fs
+
+const char* FileImpl::peekBuffer() {
+    if (_peekPos == _peekLen) {
+        _peekPos = _peekLen = 0;
+        size_t left = size() - position();
+        if (!left)
+            return nullptr;
+        if (!_peekBuf) {
+            _peekBuf.reset(new (std::nothrow) char[FS_PEEK_BUFFER_SIZE]);
+            if (!_peekBuf)
+                return nullptr;
+        }
+        int r = read((uint8_t*)_peekBuf.get(), std::min(left, (size_t)FS_PEEK_BUFFER_SIZE));
+        if (r <= 0)
+            return nullptr;
+        _peekLen = r;
+    }
+    return _peekBuf.get() + _peekPos;
+}
+
+size_t FileImpl::peekAvailable() {
+    return peekBuffer() ? _peekLen - _peekPos : 0;
+}
+
+void FileImpl::peekConsume(size_t consume) {
+    _peekPos += std::min(consume, (size_t)(_peekLen - _peekPos));
+}
+
+void FileImpl::peekDiscard() {
+    if (_peekPos != _peekLen)
+        seek(position() - (_peekLen - _peekPos), SeekSet);
+    _peekPos = _peekLen = 0;
+}
+
 size_t File::write(uint8_t c) {
     if (!_p)
         return 0;
 
+    _markModified();
+    _p->peekDiscard();
     return _p->write(&c, 1);
 }
 
@@ -36,6 +376,8 @@ size_t File::write(const uint8_t *buf, size_t size) {
     if (!_p)
         return 0;
 
+    _markModified();
+    _p->peekDiscard();
     return _p->write(buf, size);
 }
 
@@ -43,7 +385,7 @@ int File::available() {
     if (!_p)
         return false;
 
-    return _p->size() - _p->position();
+    return _p->size() - position();
 }
 
 int File::availableForWrite() {
@@ -58,6 +400,7 @@ int File::read() {
     if (!_p)
         return -1;
 
+    _p->peekDiscard();
     uint8_t result;
     if (_p->read(&result, 1) != 1) {
         return -1;
@@ -70,6 +413,7 @@ int File::read(uint8_t* buf, size_t size) {
     if (!_p)
         return 0;
 
+    _p->peekDiscard();
     return _p->read(buf, size);
 }
 
@@ -77,6 +421,7 @@ int File::peek() {
     if (!_p)
         return -1;
 
+    _p->peekDiscard();
     size_t curPos = _p->position();
     int result = read();
     seek(curPos, SeekSet);
@@ -87,13 +432,19 @@ void File::flush() {
     if (!_p)
         return;
 
+    _p->peekDiscard();
     _p->flush();
+    if (_modified) {
+        // Sizes may only be updated in the directory now
+        _markModified();
+    }
 }
 
 bool File::seek(uint32_t pos, SeekMode mode) {
     if (!_p)
         return false;
 
+    _p->peekDiscard();
     return _p->seek(pos, mode);
 }
 
@@ -101,7 +452,7 @@ size_t File::position() const {
     if (!_p)
         return 0;
 
-    return _p->position();
+    return _p->position() - _p->peekBuffered();
 }
 
 size_t File::size() const {
@@ -115,9 +466,38 @@ void File::close() {
     if (_p) {
         _p->close();
         _p = nullptr;
+        if (_modified) {
+            _markModified();
+        }
     }
 }
 
+void File::_markModified() {
+    _modified = true;
+    if (_baseFS) {
+        _baseFS->_cacheInvalidate();
+    }
+}
+
+size_t File::peekAvailable() {
+    if (!_p)
+        return 0;
+
+    return _p->peekAvailable();
+}
+
+const char* File::peekBuffer() {
+    if (!_p)
+        return nullptr;
+
+    return _p->peekBuffer();
+}
+
+void File::peekConsume(size_t consume) {
+    if (_p)
+        _p->peekConsume(consume);
+}
+
 File::operator bool() const {
     return !!_p;
 }
@@ -126,6 +506,8 @@ bool File::truncate(uint32_t size) {
     if (!_p)
         return false;
 
+    _markModified();
+    _p->peekDiscard();
     return _p->truncate(size);
 }
 
@@ -220,6 +602,9 @@ File Dir::openFile(const char* mode) {
         DEBUGV("Dir::openFile: invalid mode `%s`\r\n", mode);
         return File();
     }
+    if (_baseFS && ((om != OM_DEFAULT) || (am & AM_WRITE))) {
+        _baseFS->_cacheInvalidate();
+    }
 
     File f(_impl->openFile(om, am), _baseFS);
     f.setTimeCallback(_timeCallback);
@@ -305,6 +690,7 @@ bool FS::begin() {
         DEBUGV("#error: FS: no implementation");
         return false;
     }
+    _cacheInvalidate();
     _impl->setTimeCallback(_timeCallback);
     bool ret = _impl->begin();
     DEBUGV("%s\n", ret? "": "#error: FS could not start");
@@ -312,11 +698,41 @@ bool FS::begin() {
 }
 
 void FS::end() {
+    // cached files are closed before the filesystem goes
+    _cacheInvalidate();
     if (_impl) {
         _impl->end();
     }
 }
 
+bool FS::setDirCache(size_t maxEntries) {
+    if (!_impl || (maxEntries && !_impl->dirCacheSupported())) {
+        return false;
+    }
+    _dirCache = maxEntries ? std::make_shared<DirCache>(maxEntries) : nullptr;
+    return true;
+}
+
+bool FS::setFileCache(size_t maxFiles) {
+    if (!_impl) {
+        return false;
+    }
+    if (_fileCache) {
+        _fileCache->invalidate();
+    }
+    _fileCache = maxFiles ? std::make_shared<FileCache>(maxFiles) : nullptr;
+    return true;
+}
+
+void FS::_cacheInvalidate() {
+    if (_dirCache) {
+        _dirCache->invalidate();
+    }
+    if (_fileCache) {
+        _fileCache->invalidate();
+    }
+}
+
 bool FS::gc() {
     if (!_impl) {
         return false;
@@ -335,6 +751,7 @@ bool FS::format() {
     if (!_impl) {
         return false;
     }
+    _cacheInvalidate();
     return _impl->format();
 }
 
@@ -367,7 +784,29 @@ File FS::open(const char* path, const char* mode) {
         DEBUGV("FS::open: invalid mode `%s`\r\n", mode);
         return File();
     }
-    File f(_impl->open(path, om, am), this);
+    if ((om != OM_DEFAULT) || (am & AM_WRITE)) {
+        _cacheInvalidate();
+    }
+    FileImplPtr p;
+    if (_fileCache && om == OM_DEFAULT && am == AM_READ) {
+        p = _fileCache->take(path);
+        if (p) {
+            p->seek(0, SeekSet);
+        } else {
+            p = _impl->open(path, om, am);
+            if (!p && !_fileCache->empty()) {
+                // The filesystem may be out of open files, give back ours
+                _fileCache->invalidate();
+                p = _impl->open(path, om, am);
+            }
+        }
+        if (p) {
+            p = std::make_shared<CachedFileImpl>(p, _fileCache, path);
+        }
+    } else {
+        p = _impl->open(path, om, am);
+    }
+    File f(p, this);
     f.setTimeCallback(_timeCallback);
     return f;
 }
@@ -376,6 +815,9 @@ bool FS::exists(const char* path) {
     if (!_impl) {
         return false;
     }
+    if (_fileCache && _fileCache->contains(path)) {
+        return true;
+    }
     return _impl->exists(path);
 }
 
@@ -387,7 +829,20 @@ Dir FS::openDir(const char* path) {
     if (!_impl) {
         return Dir();
     }
-    DirImplPtr p = _impl->openDir(path);
+    DirImplPtr p;
+    if (_dirCache) {
+        auto entries = _dirCache->find(path);
+        if (entries) {
+            p = std::make_shared<CachedDirImpl>(_impl, path, entries);
+        } else {
+            p = _impl->openDir(path);
+            if (p) {
+                p = std::make_shared<RecordingDirImpl>(p, _dirCache, path);
+            }
+        }
+    } else {
+        p = _impl->openDir(path);
+    }
     Dir d(p, this);
     d.setTimeCallback(_timeCallback);
     return d;
@@ -401,6 +856,7 @@ bool FS::remove(const char* path) {
     if (!_impl) {
         return false;
     }
+    _cacheInvalidate();
     return _impl->remove(path);
 }
 
@@ -412,6 +868,7 @@ bool FS::rmdir(const char* path) {
     if (!_impl) {
         return false;
     }
+    _cacheInvalidate();
     return _impl->rmdir(path);
 }
 
@@ -423,6 +880,7 @@ bool FS::mkdir(const char* path) {
     if (!_impl) {
         return false;
     }
+    _cacheInvalidate();
     return _impl->mkdir(path);
 }
 
@@ -434,6 +892,7 @@ bool FS::rename(const char* pathFrom, const char* pathTo) {
     if (!_impl) {
         return false;
     }
+    _cacheInvalidate();
     return _impl->rename(pathFrom, pathTo);
 }
 
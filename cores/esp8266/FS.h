@@ -40,6 +40,9 @@ typedef std::shared_ptr<FSImpl> FSImplPtr;
 class DirImpl;
 typedef std::shared_ptr<DirImpl> DirImplPtr;
 
+class DirCache;
+class FileCache;
+
 template <typename Tfs>
 bool mount(Tfs& fs, const char* mountPoint);
 
@@ -75,6 +78,13 @@ public:
     size_t position() const;
     size_t size() const;
     virtual ssize_t streamRemaining() override { return (ssize_t)size() - (ssize_t)position(); }
+
+    // peek buffer API, see FileImpl::peekBuffer()
+    virtual bool hasPeekBufferAPI () const override { return !!_p; }
+    virtual size_t peekAvailable () override;
+    virtual const char* peekBuffer () override;
+    virtual void peekConsume (size_t consume) override;
+    virtual bool inputCanTimeout () override { return false; }
     void close();
     operator bool() const;
     const char* name() const;
@@ -125,6 +135,9 @@ protected:
     // Arduino SD class emulation
     std::shared_ptr<Dir> _fakeDir;
     FS                  *_baseFS;
+
+    void _markModified();
+    bool _modified = false; // written through this object, see FS::setDirCache()
 };
 
 class Dir {
@@ -194,8 +207,29 @@ public:
     static constexpr uint32_t FSId = 0x53504946;
     SPIFFSConfig(bool autoFormat = true) : FSConfig(FSId, autoFormat) { }
 
+    // Keep the counters mounting gathers by reading every block in the
+    // last block of the partition, so the next mount can skip that scan
+    // as long as nothing was written in between.  This takes the block
+    // from the filesystem: format after turning it on or off.
+    SPIFFSConfig setMountSnapshot(bool val = true) {
+        _mountSnapshot = val;
+        return *this;
+    }
+    // File descriptors and cached pages (one page each, 32 at most),
+    // 0 = as many as the maximum number of open files given by the core
+    SPIFFSConfig setMaxOpenFiles(uint16_t files) {
+        _maxOpenFiles = files;
+        return *this;
+    }
+    SPIFFSConfig setCachePages(uint16_t pages) {
+        _cachePages = pages;
+        return *this;
+    }
+
     // Inherit _type and _autoFormat
-    // nothing yet, enableTime TBD when SPIFFS has metadate
+    bool _mountSnapshot = false;
+    uint16_t _maxOpenFiles = 0;
+    uint16_t _cachePages = 0;
 };
 
 class FS
@@ -233,6 +267,14 @@ public:
     bool rmdir(const char* path);
     bool rmdir(const String& path);
 
+    // Keep up to maxEntries directory entries of recent listings in RAM,
+    // 0 disables.  Only used by filesystems with real directories.
+    bool setDirCache(size_t maxEntries);
+    // Keep up to maxFiles files opened read-only open in the filesystem
+    // after they are closed, for the next open() of the same path, 0 disables.
+    // Each one holds what the filesystem needs per open file.
+    bool setFileCache(size_t maxFiles);
+
     // Low-level FS routines, not needed by most applications
     bool gc();
     bool check();
@@ -242,8 +284,15 @@ public:
     void setTimeCallback(time_t (*cb)(void));
 
     friend class ::SDClass; // More of a frenemy, but SD needs internal implementation to get private FAT bits
+    friend class File;
+    friend class Dir;
 protected:
+    // Drops the directory listings and closes the files kept by the caches
+    void _cacheInvalidate();
+
     FSImplPtr _impl;
+    std::shared_ptr<DirCache> _dirCache;
+    std::shared_ptr<FileCache> _fileCache;
     FSImplPtr getImpl() { return _impl; }
     time_t (*_timeCallback)(void) = nullptr;
     static time_t _defaultTimeCB(void) { return time(NULL); }
@@ -24,6 +24,10 @@
 #include <stdint.h>
 #include <FS.h>
 
+#ifndef FS_PEEK_BUFFER_SIZE
+#define FS_PEEK_BUFFER_SIZE 512
+#endif
+
 namespace fs {
 
 class FileImpl {
@@ -55,8 +59,22 @@ public:
     // Same for creation time.
     virtual time_t getCreationTime() { return 0; } // Default is to not support timestamps
 
+    // Read-ahead behind File's peek buffer API, so that Stream::send() moves
+    // file data in FS_PEEK_BUFFER_SIZE chunks. The buffer is allocated on first
+    // use. File calls peekDiscard() before any other operation, which seeks
+    // back over data read ahead but not consumed.
+    virtual const char* peekBuffer();
+    virtual size_t peekAvailable();
+    virtual void peekConsume(size_t consume);
+    virtual void peekDiscard();
+    virtual size_t peekBuffered() const { return _peekLen - _peekPos; }
+
 protected:
     time_t (*_timeCallback)(void) = nullptr;
+
+    std::unique_ptr<char[]> _peekBuf;
+    uint16_t _peekLen = 0;
+    uint16_t _peekPos = 0;
 };
 
 enum OpenMode {
@@ -116,6 +134,9 @@ public:
     virtual bool gc() { return true; } // May not be implemented in all file systems.
     virtual bool check() { return true; } // May not be implemented in all file systems.
     virtual time_t getCreationTime() { return 0; } // May not be implemented in all file systems.
+    // True if DirImpl::fileName() is relative to the opened directory, so an entry can be
+    // reopened by path.  Required for FS::setDirCache().
+    virtual bool dirCacheSupported() const { return false; }
 
     // Filesystems *may* support a timestamp per-file, so allow the user to override with
     // their own callback for all files on this FS.  The default implementation simply
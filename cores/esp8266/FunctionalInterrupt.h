@@ -8,6 +8,9 @@
 extern "C" {
 #include "c_types.h"
 #include "ets_sys.h"
+
+void attachInterruptArg(uint8_t pin, void (*)(void*), void* arg, int mode);
+void detachInterrupt(uint8_t pin);
 }
 
 // Structures for communication
@@ -31,5 +34,53 @@ struct ArgStructure {
 void attachInterrupt(uint8_t pin, std::function<void(void)> intRoutine, int mode);
 void attachScheduledInterrupt(uint8_t pin, std::function<void(InterruptInfo)> scheduledIntRoutine, int mode);
 
+// Statically dispatched handlers.  Nothing is allocated, the pin's slot in
+// the core's handler table keeps a pointer to a trampoline instantiated for
+// the handler type, and the object as its argument.  The trampolines are
+// in IRAM and inline what they call when the definition is visible, so a
+// member function or functor defined in a header needs no IRAM_ATTR of its
+// own.  The object must outlive the attachment.
+
+template <typename T, void (T::*method)()>
+void IRAM_ATTR __attribute__((flatten)) interruptMemberTrampoline(void* arg)
+{
+    (static_cast<T*>(arg)->*method)();
+}
+
+// attachInterrupt<Encoder, &Encoder::step>(pin, &encoder, CHANGE);
+template <typename T, void (T::*method)()>
+void attachInterrupt(uint8_t pin, T* object, int mode)
+{
+    attachInterruptArg(pin, interruptMemberTrampoline<T, method>, object, mode);
+}
+
+// Keeps a functor (e.g. a lambda with captures) inline:
+//   static InterruptFunctor handler([&count]() { ++count; });
+//   handler.attach(pin, RISING);
+template <typename F>
+class InterruptFunctor
+{
+public:
+    explicit InterruptFunctor(F f) : _f(f) {}
+
+    void attach(uint8_t pin, int mode)
+    {
+        attachInterruptArg(pin, trampoline, this, mode);
+    }
+
+    void detach(uint8_t pin)
+    {
+        detachInterrupt(pin);
+    }
+
+protected:
+    static void IRAM_ATTR __attribute__((flatten)) trampoline(void* arg)
+    {
+        static_cast<InterruptFunctor*>(arg)->_f();
+    }
+
+    F _f;
+};
+
 
 #endif //INTERRUPTS_H
@@ -0,0 +1,148 @@
+/*
+ GpioPort.h - GPIO0-15 as one port
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef GPIOPORT_H
+#define GPIOPORT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp8266_peri.h"
+
+/*
+  GPIO0-15 share one set of registers, bit n for GPIOn: writing a mask to
+  GPOS sets those outputs high and to GPOC sets them low, the others are
+  left as they are, and GPI holds all the input levels.  The functions
+  below are single register accesses, with none of the pin checks of
+  digitalWrite() and digitalRead().  GPIO16 has registers of its own and
+  is not part of the port.
+
+  Unlike digitalWrite(), port writes do not stop a tone(), analogWrite()
+  or startWaveform() on the pins: gpioPortMode() does, once.
+*/
+
+extern "C" void gpioPortMode(uint32_t mask, uint8_t mode);
+
+// outputs of mask high
+inline void gpioPortSet(uint32_t mask)
+{
+    GPOS = mask;
+}
+
+// outputs of mask low
+inline void gpioPortClear(uint32_t mask)
+{
+    GPOC = mask;
+}
+
+// outputs of mask to the matching bits of bits: the high ones are set,
+// then the low ones are cleared, other outputs are not touched
+inline void gpioPortWrite(uint32_t mask, uint32_t bits)
+{
+    GPOS = bits & mask;
+    GPOC = ~bits & mask;
+}
+
+// input levels of GPIO0-15
+inline uint32_t gpioPortRead()
+{
+    return GPI & 0xffff;
+}
+
+// Compile time mask of a set of pins:
+//   constexpr uint32_t lcdControl = GpioMask<D1, D2>::value;
+template <uint8_t... pins>
+struct GpioMask
+{
+    static_assert(sizeof...(pins) > 0, "no pins");
+    static_assert(((pins < 16) && ...), "GPIO16 is not on the port");
+    static constexpr uint32_t value = ((1UL << pins) | ...);
+};
+
+// A parallel bus, bit i of a value on the i-th pin:
+//   using Data = GpioBus<4, 5, 12, 13, 14, 15, 0, 2>;
+//   Data::begin();
+//   Data::write(0xa5);
+// On consecutive pins in order a value is only shifted into place.
+template <uint8_t... pins>
+class GpioBus
+{
+public:
+    static constexpr size_t width = sizeof...(pins);
+    static constexpr uint32_t mask = GpioMask<pins...>::value;
+
+    static void begin(uint8_t mode = 0x01 /* OUTPUT */)
+    {
+        gpioPortMode(mask, mode);
+    }
+
+    // value to port bits
+    static constexpr uint32_t spread(uint32_t value)
+    {
+        if (consecutive()) {
+            return (value << _pins[0]) & mask;
+        }
+        uint32_t bits = 0;
+        for (size_t i = 0; i < width; i++) {
+            if (value & (1UL << i)) {
+                bits |= 1UL << _pins[i];
+            }
+        }
+        return bits;
+    }
+
+    // port bits to value
+    static constexpr uint32_t gather(uint32_t bits)
+    {
+        if (consecutive()) {
+            return (bits & mask) >> _pins[0];
+        }
+        uint32_t value = 0;
+        for (size_t i = 0; i < width; i++) {
+            if (bits & (1UL << _pins[i])) {
+                value |= 1UL << i;
+            }
+        }
+        return value;
+    }
+
+    static void write(uint32_t value)
+    {
+        gpioPortWrite(mask, spread(value));
+    }
+
+    static uint32_t read()
+    {
+        return gather(gpioPortRead());
+    }
+
+protected:
+    static constexpr uint8_t _pins[] = { pins... };
+
+    static constexpr bool consecutive()
+    {
+        for (size_t i = 1; i < width; i++) {
+            if (_pins[i] != _pins[0] + i) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+#endif // GPIOPORT_H
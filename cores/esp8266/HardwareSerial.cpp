@@ -48,6 +48,9 @@ void HardwareSerial::begin(unsigned long baud, SerialConfig config, SerialMode m
 {
     end();
     _uart = uart_init(_uart_nr, baud, (int) config, (int) mode, tx_pin, _rx_size, invert);
+    if(_uart && _tx_size) {
+        _tx_size = uart_resize_tx_buffer(_uart, _tx_size);
+    }
 #if defined(DEBUG_ESP_PORT) && !defined(NDEBUG)
     if (static_cast<void*>(this) == static_cast<void*>(&DEBUG_ESP_PORT))
     {
@@ -86,6 +89,15 @@ size_t HardwareSerial::setRxBufferSize(size_t size){
     return _rx_size;
 }
 
+size_t HardwareSerial::setTxBufferSize(size_t size){
+    if(_uart) {
+        _tx_size = uart_resize_tx_buffer(_uart, size);
+    } else {
+        _tx_size = size;
+    }
+    return _tx_size;
+}
+
 void HardwareSerial::setDebugOutput(bool en)
 {
     if(!_uart) {
@@ -101,6 +101,22 @@ public:
         return uart_get_rx_buffer_size(_uart);
     }
 
+    // Call after begin(). fifoFull (1..127, default 16) is the RX FIFO level
+    // moving data to the RX buffer. timeout (symbol times, 0..127, default 0=off)
+    // also moves it when the line goes idle with fewer bytes in the FIFO.
+    bool setRxThresholds(uint8_t fifoFull, uint8_t timeout = 0)
+    {
+        return uart_set_rx_thresholds(_uart, fifoFull, timeout);
+    }
+
+    // 0 (default): write() busy-waits until everything is in the TX FIFO
+    // otherwise write() queues and returns, the TX interrupt sends the data
+    size_t setTxBufferSize(size_t size);
+    size_t getTxBufferSize()
+    {
+        return uart_get_tx_buffer_size(_uart);
+    }
+
     bool swap()
     {
         return swap(1);
@@ -231,6 +247,7 @@ protected:
     int _uart_nr;
     uart_t* _uart = nullptr;
     size_t _rx_size;
+    size_t _tx_size = 0;
 };
 
 extern HardwareSerial Serial;
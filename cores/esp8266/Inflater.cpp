@@ -0,0 +1,470 @@
+/*
+ Inflater.cpp - streaming zlib and gzip decompression with a bounded window
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "Arduino.h"
+#include <algorithm>
+#include <new>
+#include <string.h>
+#include "Inflater.h"
+
+// RFC 1951 3.2.5
+static const uint16_t lengthBase[29] PROGMEM = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const uint8_t lengthExtra[29] PROGMEM = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const uint16_t distanceBase[30] PROGMEM = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static const uint8_t distanceExtra[30] PROGMEM = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+// Order of the code length code lengths, RFC 1951 3.2.7
+static const uint8_t codeLengthOrder[19] PROGMEM = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+#define GZIP_FHCRC    0x02
+#define GZIP_FEXTRA   0x04
+#define GZIP_FNAME    0x08
+#define GZIP_FCOMMENT 0x10
+
+Inflater::~Inflater() {
+    end();
+}
+
+bool Inflater::begin(uint8_t windowBits, Sink sink) {
+    end();
+    if (windowBits < 8 || windowBits > 15 || !sink) {
+        return false;
+    }
+    _window = new (std::nothrow) uint8_t[1 << windowBits];
+    if (!_window) {
+        _error = NoMemory;
+        return false;
+    }
+    _windowMask = (1 << windowBits) - 1;
+    _sink = std::move(sink);
+    _total = 0;
+    _flushed = 0;
+    _inPos = 0;
+    _inLen = 0;
+    _bitBuf = 0;
+    _bitCount = 0;
+    _underflow = false;
+    _state = Header;
+    _error = Ok;
+    _last = false;
+    _gzipFlags = 0;
+    _storedLeft = 0;
+    return true;
+}
+
+void Inflater::end() {
+    delete[] _window;
+    _window = nullptr;
+    _sink = nullptr;
+}
+
+size_t Inflater::write(const uint8_t* data, size_t len) {
+    if (!_window || _error) {
+        return 0;
+    }
+    size_t used = 0;
+    do {
+        if (_inPos) {
+            memmove(_in, _in + _inPos, _inLen - _inPos);
+            _inLen -= _inPos;
+            _inPos = 0;
+        }
+        const size_t n = std::min(len - used, INPUT_SIZE - _inLen);
+        memcpy(_in + _inLen, data + used, n);
+        _inLen += n;
+        used += n;
+        if (!_run(false)) {
+            return 0;
+        }
+    } while (used < len);
+    return _flush() ? used : 0;
+}
+
+bool Inflater::finish() {
+    if (!_window) {
+        return false;
+    }
+    if (_run(true) && _state != Done) {
+        _fail(Truncated);
+    }
+    return !_error && _flush();
+}
+
+void Inflater::_fail(Error error) {
+    if (!_error) {
+        _error = error;
+    }
+}
+
+// Decodes until more input is needed, false on error
+bool Inflater::_run(bool finishing) {
+    while (!_error) {
+        const size_t available = _inLen - _inPos;
+        bool progress = false;
+        switch (_state) {
+        case Header:
+            progress = _header(finishing);
+            break;
+        case GzipFields:
+            progress = _gzipFields();
+            break;
+        case Block:
+            progress = (available >= BLOCK_NEED || (finishing && (available || _bitCount))) && _block();
+            break;
+        case Stored:
+            progress = _stored();
+            break;
+        case Codes:
+            progress = _codes(finishing);
+            break;
+        case Done:
+            // Ignore the trailer
+            _inPos = _inLen;
+            return true;
+        }
+        if (_underflow) {
+            _fail(Truncated);
+        }
+        if (!progress) {
+            break;
+        }
+    }
+    return !_error;
+}
+
+bool Inflater::_header(bool finishing) {
+    const size_t available = _inLen - _inPos;
+    if (available < 2 || (available < 10 && !finishing)) {
+        return false;
+    }
+    const uint8_t* p = _in + _inPos;
+    if (p[0] == 0x1f && p[1] == 0x8b) {
+        if (available < 10) {
+            return false;
+        }
+        if (p[2] != 8 || (p[3] & 0xe0)) {
+            _fail(BadHeader);
+            return false;
+        }
+        _gzipFlags = p[3] & (GZIP_FHCRC | GZIP_FEXTRA | GZIP_FNAME | GZIP_FCOMMENT);
+        _storedLeft = 0;
+        _inPos += 10;
+        _state = GzipFields;
+        return true;
+    }
+    // zlib: deflate, a window we can hold, no preset dictionary
+    const uint32_t window = 1 << ((p[0] >> 4) + 8);
+    if ((p[0] & 0x0f) != 8 || ((p[0] << 8) | p[1]) % 31 || (p[1] & 0x20) || window > _windowMask + 1) {
+        _fail(BadHeader);
+        return false;
+    }
+    _inPos += 2;
+    _state = Block;
+    return true;
+}
+
+// Skips the optional gzip fields, _storedLeft counts the bytes to skip
+bool Inflater::_gzipFields() {
+    bool progress = false;
+    while (_inPos < _inLen) {
+        progress = true;
+        if (_storedLeft) {
+            const size_t n = std::min(_inLen - _inPos, (size_t)_storedLeft);
+            _inPos += n;
+            _storedLeft -= n;
+        } else if (_gzipFlags & GZIP_FEXTRA) {
+            if (_inLen - _inPos < 2) {
+                return false;
+            }
+            _storedLeft = _in[_inPos] | (_in[_inPos + 1] << 8);
+            _inPos += 2;
+            _gzipFlags &= ~GZIP_FEXTRA;
+        } else if (_gzipFlags & (GZIP_FNAME | GZIP_FCOMMENT)) {
+            if (!_in[_inPos++]) {
+                _gzipFlags &= (_gzipFlags & GZIP_FNAME) ? ~GZIP_FNAME : ~GZIP_FCOMMENT;
+            }
+        } else if (_gzipFlags & GZIP_FHCRC) {
+            _storedLeft = 2;
+            _gzipFlags &= ~GZIP_FHCRC;
+        } else {
+            break;
+        }
+    }
+    if (!_gzipFlags && !_storedLeft) {
+        _state = Block;
+        return true;
+    }
+    return progress;
+}
+
+bool Inflater::_block() {
+    _last = _bits(1);
+    switch (_bits(2)) {
+    case 0:
+        // The bit buffer only holds the rest of the current byte
+        _bitBuf = 0;
+        _bitCount = 0;
+        _storedLeft = _bits(16);
+        if ((_bits(16) ^ 0xffff) != _storedLeft) {
+            _fail(BadData);
+            return false;
+        }
+        _state = Stored;
+        return true;
+    case 1:
+        _fixedTrees();
+        _state = Codes;
+        return true;
+    case 2:
+        if (!_dynamicTrees()) {
+            return false;
+        }
+        _state = Codes;
+        return true;
+    default:
+        _fail(BadData);
+        return false;
+    }
+}
+
+bool Inflater::_stored() {
+    if (!_storedLeft) {
+        _state = _last ? Done : Block;
+        return true;
+    }
+    const size_t n = std::min(_inLen - _inPos, (size_t)_storedLeft);
+    for (size_t i = 0; i < n; ++i) {
+        if (!_put(_in[_inPos + i])) {
+            return false;
+        }
+    }
+    _inPos += n;
+    _storedLeft -= n;
+    return n != 0;
+}
+
+bool Inflater::_codes(bool finishing) {
+    while (finishing || _inLen - _inPos >= CODE_NEED) {
+        int symbol = _decode(_lit);
+        if (_underflow) {
+            return false;
+        }
+        if (symbol < 256) {
+            if (symbol < 0) {
+                _fail(BadData);
+                return false;
+            }
+            if (!_put(symbol)) {
+                return false;
+            }
+            continue;
+        }
+        if (symbol == 256) {
+            _state = _last ? Done : Block;
+            return true;
+        }
+        symbol -= 257;
+        if (symbol >= 29) {
+            _fail(BadData);
+            return false;
+        }
+        uint32_t length = pgm_read_word(&lengthBase[symbol]) + _bits(pgm_read_byte(&lengthExtra[symbol]));
+        symbol = _decode(_dist);
+        if (symbol < 0 || symbol >= 30) {
+            _fail(BadData);
+            return false;
+        }
+        const uint32_t distance = pgm_read_word(&distanceBase[symbol]) + _bits(pgm_read_byte(&distanceExtra[symbol]));
+        if (_underflow) {
+            return false;
+        }
+        if (distance > _windowMask + 1 || distance > _total) {
+            _fail(TooFar);
+            return false;
+        }
+        while (length--) {
+            if (!_put(_window[(_total - distance) & _windowMask])) {
+                return false;
+            }
+        }
+    }
+    return false;
+}
+
+void Inflater::_fixedTrees() {
+    uint8_t lengths[288];
+    memset(lengths, 8, 144);
+    memset(lengths + 144, 9, 256 - 144);
+    memset(lengths + 256, 7, 280 - 256);
+    memset(lengths + 280, 8, 288 - 280);
+    _build(_lit, lengths, 288);
+    memset(lengths, 5, 30);
+    _build(_dist, lengths, 30);
+}
+
+bool Inflater::_dynamicTrees() {
+    const size_t literals = _bits(5) + 257;
+    const size_t distances = _bits(5) + 1;
+    const size_t codes = _bits(4) + 4;
+    if (literals > 286 || distances > 30) {
+        _fail(BadData);
+        return false;
+    }
+
+    // The code length code goes to _lit until the real trees are built
+    uint8_t lengths[286 + 30] = { 0 };
+    for (size_t i = 0; i < codes; ++i) {
+        lengths[pgm_read_byte(&codeLengthOrder[i])] = _bits(3);
+    }
+    if (!_build(_lit, lengths, 19)) {
+        _fail(BadData);
+        return false;
+    }
+
+    size_t index = 0;
+    while (index < literals + distances) {
+        int symbol = _decode(_lit);
+        if (symbol < 0 || _underflow) {
+            _fail(_underflow ? Truncated : BadData);
+            return false;
+        }
+        if (symbol < 16) {
+            lengths[index++] = symbol;
+            continue;
+        }
+        uint8_t repeated = 0;
+        size_t count;
+        if (symbol == 16) {
+            if (!index) {
+                _fail(BadData);
+                return false;
+            }
+            repeated = lengths[index - 1];
+            count = 3 + _bits(2);
+        } else if (symbol == 17) {
+            count = 3 + _bits(3);
+        } else {
+            count = 11 + _bits(7);
+        }
+        if (index + count > literals + distances) {
+            _fail(BadData);
+            return false;
+        }
+        memset(lengths + index, repeated, count);
+        index += count;
+    }
+
+    if (!lengths[256] || !_build(_lit, lengths, literals) || !_build(_dist, lengths + literals, distances)) {
+        _fail(BadData);
+        return false;
+    }
+    return true;
+}
+
+// Canonical Huffman code from the code lengths.  Incomplete codes are
+// allowed (a single distance code is), over-subscribed ones are not.
+bool Inflater::_build(Tree& tree, const uint8_t* lengths, size_t count) {
+    memset(tree.counts, 0, sizeof(tree.counts));
+    for (size_t i = 0; i < count; ++i) {
+        tree.counts[lengths[i]]++;
+    }
+    tree.counts[0] = 0;
+
+    int left = 1;
+    for (int len = 1; len < 16; ++len) {
+        left = (left << 1) - tree.counts[len];
+        if (left < 0) {
+            return false;
+        }
+    }
+
+    uint16_t offsets[16];
+    offsets[1] = 0;
+    for (int len = 1; len < 15; ++len) {
+        offsets[len + 1] = offsets[len] + tree.counts[len];
+    }
+    for (size_t i = 0; i < count; ++i) {
+        if (lengths[i]) {
+            tree.symbols[offsets[lengths[i]]++] = i;
+        }
+    }
+    return true;
+}
+
+// One code, read a bit at a time as codes are stored from their top bit
+int Inflater::_decode(const Tree& tree) {
+    int code = 0;
+    int first = 0;
+    int index = 0;
+    for (int len = 1; len < 16; ++len) {
+        code |= _bits(1);
+        const int count = tree.counts[len];
+        if (code - count < first) {
+            return tree.symbols[index + (code - first)];
+        }
+        index += count;
+        first = (first + count) << 1;
+        code <<= 1;
+    }
+    return -1;
+}
+
+uint32_t Inflater::_bits(uint8_t count) {
+    while (_bitCount < count) {
+        if (_inPos == _inLen) {
+            _underflow = true;
+            return 0;
+        }
+        _bitBuf |= (uint32_t)_in[_inPos++] << _bitCount;
+        _bitCount += 8;
+    }
+    const uint32_t value = _bitBuf & ((1U << count) - 1);
+    _bitBuf >>= count;
+    _bitCount -= count;
+    return value;
+}
+
+bool Inflater::_put(uint8_t value) {
+    if (_total - _flushed > _windowMask && !_flush()) {
+        return false;
+    }
+    _window[_total++ & _windowMask] = value;
+    return true;
+}
+
+bool Inflater::_flush() {
+    while (_flushed < _total) {
+        const size_t start = _flushed & _windowMask;
+        const size_t n = std::min(_total - _flushed, (size_t)_windowMask + 1 - start);
+        if (!_sink(_window + start, n)) {
+            _fail(SinkFailed);
+            return false;
+        }
+        _flushed += n;
+    }
+    return true;
+}
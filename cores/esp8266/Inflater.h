@@ -0,0 +1,124 @@
+/*
+ Inflater.h - streaming zlib and gzip decompression with a bounded window
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __INFLATER_H
+#define __INFLATER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+
+/*
+  Decodes a zlib (RFC 1950) or gzip (RFC 1952) stream fed in pieces of
+  any size, and hands the result to the sink in order.  Only the last
+  2^windowBits output bytes are kept for back references, a stream
+  referring further back fails with TooFar: compress it with a matching
+  window (zlib wbits, gzip cannot be told and uses 32KB).
+
+  Input is buffered until a whole block header or symbol is available,
+  so finish() must be called once all of it has been written.  The
+  trailer checksum is not verified, the Updater checks the MD5 of the
+  result instead.
+*/
+class Inflater {
+public:
+    // Returns false to abort
+    using Sink = std::function<bool(const uint8_t* data, size_t len)>;
+
+    enum Error : uint8_t {
+        Ok,
+        NoMemory,
+        BadHeader,  // neither zlib nor gzip, or a zlib window over windowBits
+        BadData,    // invalid block or code
+        TooFar,     // back reference beyond the window
+        Truncated,  // finish() came before the last block ended
+        SinkFailed,
+    };
+
+    Inflater() = default;
+    ~Inflater();
+    Inflater(const Inflater&) = delete;
+    Inflater& operator=(const Inflater&) = delete;
+
+    // Allocates the 2^windowBits window, 8 to 15 bits
+    bool begin(uint8_t windowBits, Sink sink);
+    void end();
+
+    // Consumes all of data unless an error occurs
+    size_t write(const uint8_t* data, size_t len);
+    // No more input, decodes what is left. True if the stream ended well
+    bool finish();
+
+    bool done() const { return _state == Done; }
+    Error error() const { return _error; }
+    // Bytes handed to the sink
+    size_t total() const { return _total; }
+
+private:
+    struct Tree {
+        uint16_t counts[16];    // codes of each length
+        uint16_t symbols[288];  // symbols ordered by code
+    };
+
+    enum State : uint8_t { Header, GzipFields, Block, Stored, Codes, Done };
+
+    // Worst case input for a block header (a dynamic one with all code
+    // lengths at 7 bits plus 7 extra bits) and for one length/distance pair
+    static constexpr size_t BLOCK_NEED = 600;
+    static constexpr size_t CODE_NEED = 8;
+    static constexpr size_t INPUT_SIZE = 1024;
+
+    bool _run(bool finishing);
+    bool _header(bool finishing);
+    bool _gzipFields();
+    bool _block();
+    bool _stored();
+    bool _codes(bool finishing);
+    bool _dynamicTrees();
+    void _fixedTrees();
+    static bool _build(Tree& tree, const uint8_t* lengths, size_t count);
+    int _decode(const Tree& tree);
+    uint32_t _bits(uint8_t count);
+    bool _put(uint8_t value);
+    bool _flush();
+    void _fail(Error error);
+
+    Sink _sink;
+    uint8_t* _window = nullptr;
+    uint32_t _windowMask = 0;
+    size_t _total = 0;          // bytes decoded, the window holds the last ones
+    size_t _flushed = 0;        // bytes handed to the sink
+
+    uint8_t _in[INPUT_SIZE];
+    size_t _inPos = 0;
+    size_t _inLen = 0;
+    uint32_t _bitBuf = 0;
+    uint8_t _bitCount = 0;
+    bool _underflow = false;
+
+    State _state = Header;
+    Error _error = Ok;
+    bool _last = false;         // the current block is the final one
+    uint8_t _gzipFlags = 0;
+    uint16_t _storedLeft = 0;
+    Tree _lit;
+    Tree _dist;
+};
+
+#endif // __INFLATER_H
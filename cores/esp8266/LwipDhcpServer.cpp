@@ -97,21 +97,26 @@ typedef enum
 typedef enum
 {
     DHCPS_STATE_ONLINE,
-    DHCPS_STATE_OFFLINE
+    DHCPS_STATE_OFFLINE,
+    DHCPS_STATE_FREE        // unused slot of the lease table
 } dhcps_state_t;
 
+// one slot of the lease table, its address is given by its position
 struct dhcps_pool
 {
-    struct ipv4_addr ip;
-    uint8 mac[6];
     uint32 lease_timer;
-    dhcps_type_t type;
-    dhcps_state_t state;
-
+    uint8 mac[6];
+    uint8 mac_next;         // next slot with the same MAC hash
+    uint8 type;             // dhcps_type_t
+    uint8 state;            // dhcps_state_t
 };
 
 #define DHCPS_LEASE_TIMER  dhcps_lease_time  //0x05A0
 #define DHCPS_MAX_LEASE 0x64
+#define DHCPS_LEASE_GROW 8  // lease table grows by this many slots
+#define DHCPS_NO_LEASE 0xFF // end of a MAC hash chain
+
+static_assert(DHCPS_MAX_LEASE < DHCPS_NO_LEASE, "lease table index must fit in a uint8");
 #define BOOTP_BROADCAST 0x8000
 
 #define DHCP_REQUEST        1
@@ -177,7 +182,10 @@ DhcpServer::DhcpServer(netif* netif): _netif(netif)
 {
     pcb_dhcps = nullptr;
     dns_address.addr = 0;
-    plist = nullptr;
+    leases = nullptr;
+    leases_start = 0;
+    leases_count = 0;
+    memset(mac_hash, DHCPS_NO_LEASE, sizeof(mac_hash));
     offer = 0xFF;
     renew = false;
     dhcps_lease_time = DHCPS_LEASE_TIME_DEF;  //minute
@@ -211,90 +219,161 @@ void DhcpServer::dhcps_set_dns(int num, const ipv4_addr_t* dns)
     }
 }
 
+static uint8 mac_hash_of(const uint8 *mac)
+{
+    return mac[3] ^ mac[4] ^ mac[5];
+}
+
 /******************************************************************************
-    FunctionName : node_insert_to_list
-    Description  : insert the node to the list
-    Parameters   : arg -- Additional argument to pass to the callback function
-    Returns      : none
+    FunctionName : lease_slot
+    Description  : get the lease table slot of an address of the range
+    Parameters   : ip -- address (network order)
+                   grow -- enlarge the table when the slot is not there yet
+    Returns      : the slot, nullptr if ip is out of range or (!grow) not there
 *******************************************************************************/
-void DhcpServer::node_insert_to_list(list_node **phead, list_node* pinsert)
+struct dhcps_pool* DhcpServer::lease_slot(uint32 ip, bool grow)
 {
-    list_node *plist = nullptr;
-    struct dhcps_pool *pdhcps_pool = nullptr;
-    struct dhcps_pool *pdhcps_node = nullptr;
-    if (*phead == nullptr)
+    uint32 start_ip = ntohl(dhcps_lease.start_ip.addr);
+    uint32 end_ip = ntohl(dhcps_lease.end_ip.addr);
+
+    ip = ntohl(ip);
+    if ((ip < start_ip) || (ip > end_ip))
     {
-        *phead = pinsert;
+        return nullptr;
     }
-    else
+
+    uint32 index = ip - start_ip;
+    if (index >= leases_count)
     {
-        plist = *phead;
-        pdhcps_node = (struct dhcps_pool*)pinsert->pnode;
-        pdhcps_pool = (struct dhcps_pool*)plist->pnode;
+        if (!grow)
+        {
+            return nullptr;
+        }
 
-        if (pdhcps_node->ip.addr < pdhcps_pool->ip.addr)
+        uint32 count = index + DHCPS_LEASE_GROW;
+        if (count > end_ip - start_ip + 1)
         {
-            pinsert->pnext = plist;
-            *phead = pinsert;
+            count = end_ip - start_ip + 1;
         }
-        else
+        struct dhcps_pool *table = (struct dhcps_pool *)realloc(leases, count * sizeof(struct dhcps_pool));
+        if (table == nullptr)
         {
-            while (plist->pnext != nullptr)
-            {
-                pdhcps_pool = (struct dhcps_pool*)plist->pnext->pnode;
-                if (pdhcps_node->ip.addr < pdhcps_pool->ip.addr)
-                {
-                    pinsert->pnext = plist->pnext;
-                    plist->pnext = pinsert;
-                    break;
-                }
-                plist = plist->pnext;
-            }
-
-            if (plist->pnext == nullptr)
-            {
-                plist->pnext = pinsert;
-            }
+            return nullptr;
+        }
+        if (leases == nullptr)
+        {
+            leases_start = dhcps_lease.start_ip.addr;
+        }
+        memset(&table[leases_count], 0, (count - leases_count) * sizeof(struct dhcps_pool));
+        for (uint32 i = leases_count; i < count; i++)
+        {
+            table[i].state = DHCPS_STATE_FREE;
         }
+        leases = table;
+        leases_count = count;
     }
-    //  pinsert->pnext = nullptr;
+    return &leases[index];
 }
 
 /******************************************************************************
-    FunctionName : node_delete_from_list
-    Description  : remove the node from list
-    Parameters   : arg -- Additional argument to pass to the callback function
-    Returns      : none
+    FunctionName : find_lease_by_mac
+    Description  : find the lease of a station
+    Parameters   : mac -- station mac address
+    Returns      : the lease or nullptr
 *******************************************************************************/
-void DhcpServer::node_remove_from_list(list_node **phead, list_node* pdelete)
+struct dhcps_pool* DhcpServer::find_lease_by_mac(const uint8 *mac)
 {
-    list_node *plist = nullptr;
-
-    plist = *phead;
-    if (plist == nullptr)
+    for (uint8 i = mac_hash[mac_hash_of(mac) % mac_hash_size]; i != DHCPS_NO_LEASE; i = leases[i].mac_next)
     {
-        *phead = nullptr;
+        if (memcmp(leases[i].mac, mac, sizeof(leases[i].mac)) == 0)
+        {
+            return &leases[i];
+        }
     }
-    else
+    return nullptr;
+}
+
+/******************************************************************************
+    FunctionName : find_free_lease
+    Description  : find the unused slot with the lowest address
+    Parameters   : none
+    Returns      : the slot or nullptr if the range is exhausted
+*******************************************************************************/
+struct dhcps_pool* DhcpServer::find_free_lease(void)
+{
+    for (uint16 i = 0; i < leases_count; i++)
     {
-        if (plist == pdelete)
+        if (leases[i].state == DHCPS_STATE_FREE)
         {
-            *phead = plist->pnext;
-            pdelete->pnext = nullptr;
+            return &leases[i];
         }
-        else
+    }
+    return lease_slot(htonl(ntohl(dhcps_lease.start_ip.addr) + leases_count), true);
+}
+
+/******************************************************************************
+    FunctionName : lease_ip
+    Description  : address of a lease
+    Parameters   : pool -- slot of the lease table
+    Returns      : address (network order)
+*******************************************************************************/
+uint32 DhcpServer::lease_ip(const struct dhcps_pool* pool) const
+{
+    return htonl(ntohl(leases_start) + (pool - leases));
+}
+
+/******************************************************************************
+    FunctionName : lease_set_mac
+    Description  : give an unused slot to a station
+    Parameters   : pool -- free slot of the lease table
+                   mac -- station mac address
+    Returns      : none
+*******************************************************************************/
+void DhcpServer::lease_set_mac(struct dhcps_pool* pool, const uint8 *mac)
+{
+    uint8 *head = &mac_hash[mac_hash_of(mac) % mac_hash_size];
+
+    memcpy(pool->mac, mac, sizeof(pool->mac));
+    pool->mac_next = *head;
+    *head = pool - leases;
+}
+
+/******************************************************************************
+    FunctionName : lease_free
+    Description  : release a slot of the lease table
+    Parameters   : pool -- slot of the lease table
+    Returns      : none
+*******************************************************************************/
+void DhcpServer::lease_free(struct dhcps_pool* pool)
+{
+    uint8 index = pool - leases;
+    uint8 *pnext = &mac_hash[mac_hash_of(pool->mac) % mac_hash_size];
+
+    while (*pnext != DHCPS_NO_LEASE)
+    {
+        if (*pnext == index)
         {
-            while (plist != nullptr)
-            {
-                if (plist->pnext == pdelete)
-                {
-                    plist->pnext = pdelete->pnext;
-                    pdelete->pnext = nullptr;
-                }
-                plist = plist->pnext;
-            }
+            *pnext = pool->mac_next;
+            break;
         }
+        pnext = &leases[*pnext].mac_next;
     }
+    memset(pool, 0, sizeof(struct dhcps_pool));
+    pool->state = DHCPS_STATE_FREE;
+}
+
+/******************************************************************************
+    FunctionName : free_lease_table
+    Description  : forget all leases
+    Parameters   : none
+    Returns      : none
+*******************************************************************************/
+void DhcpServer::free_lease_table(void)
+{
+    free(leases);
+    leases = nullptr;
+    leases_count = 0;
+    memset(mac_hash, DHCPS_NO_LEASE, sizeof(mac_hash));
 }
 
 /******************************************************************************
@@ -306,28 +385,17 @@ void DhcpServer::node_remove_from_list(list_node **phead, list_node* pdelete)
 bool DhcpServer::add_dhcps_lease(uint8 *macaddr)
 {
     struct dhcps_pool *pdhcps_pool = nullptr;
-    list_node *pback_node = nullptr;
 
-    uint32 start_ip = dhcps_lease.start_ip.addr;
-    uint32 end_ip = dhcps_lease.end_ip.addr;
-
-    for (pback_node = plist; pback_node != nullptr; pback_node = pback_node->pnext)
+    if (find_lease_by_mac(macaddr) != nullptr)
     {
-        pdhcps_pool = (dhcps_pool*)pback_node->pnode;
-        if (memcmp(pdhcps_pool->mac, macaddr, sizeof(pdhcps_pool->mac)) == 0)
-        {
 #if DHCPS_DEBUG
-            os_printf("this mac already exist");
+        os_printf("this mac already exist");
 #endif
-            return false;
-        }
-        else
-        {
-            start_ip = htonl((ntohl(start_ip) + 1));
-        }
+        return false;
     }
 
-    if (start_ip > end_ip)
+    pdhcps_pool = find_free_lease();
+    if (pdhcps_pool == nullptr)
     {
 #if DHCPS_DEBUG
         os_printf("no more ip available");
@@ -335,16 +403,10 @@ bool DhcpServer::add_dhcps_lease(uint8 *macaddr)
         return false;
     }
 
-    pdhcps_pool = (struct dhcps_pool *)zalloc(sizeof(struct dhcps_pool));
-    pdhcps_pool->ip.addr = start_ip;
-    memcpy(pdhcps_pool->mac, macaddr, sizeof(pdhcps_pool->mac));
+    lease_set_mac(pdhcps_pool, macaddr);
     pdhcps_pool->lease_timer = DHCPS_LEASE_TIMER;
     pdhcps_pool->type = DHCPS_TYPE_STATIC;
     pdhcps_pool->state = DHCPS_STATE_ONLINE;
-    pback_node = (list_node *)zalloc(sizeof(list_node));
-    pback_node->pnode = pdhcps_pool;
-    pback_node->pnext = nullptr;
-    node_insert_to_list(&plist, pback_node);
 
     return true;
 }
@@ -1044,6 +1106,13 @@ bool DhcpServer::begin(struct ip_info *info)
 
     server_address = info->ip;
     init_dhcps_lease(server_address.addr);
+    if ((leases != nullptr)
+            && ((leases_start != dhcps_lease.start_ip.addr)
+                || (leases_count > ntohl(dhcps_lease.end_ip.addr) - ntohl(dhcps_lease.start_ip.addr) + 1)))
+    {
+        // lease range has changed
+        free_lease_table();
+    }
 
     udp_bind(pcb_dhcps, IP_ADDR_ANY, DHCPS_SERVER_PORT);
     udp_recv(pcb_dhcps, S_handle_dhcp, this);
@@ -1063,6 +1132,7 @@ bool DhcpServer::begin(struct ip_info *info)
 DhcpServer::~DhcpServer()
 {
     end();
+    free_lease_table(); // static leases may be set without begin()
 }
 
 void DhcpServer::end()
@@ -1077,29 +1147,18 @@ void DhcpServer::end()
     pcb_dhcps = nullptr;
 
     //udp_remove(pcb_dhcps);
-    list_node *pnode = nullptr;
-    list_node *pback_node = nullptr;
-    struct dhcps_pool* dhcp_node = nullptr;
     struct ipv4_addr ip_zero;
 
     memset(&ip_zero, 0x0, sizeof(ip_zero));
-    pnode = plist;
-    while (pnode != nullptr)
-    {
-        pback_node = pnode;
-        pnode = pback_node->pnext;
-        node_remove_from_list(&plist, pback_node);
-        dhcp_node = (struct dhcps_pool*)pback_node->pnode;
-        //dhcps_client_leave(dhcp_node->mac,&dhcp_node->ip,true); // force to delete
-        if (_netif->num == SOFTAP_IF)
+    for (uint16 i = 0; i < leases_count; i++)
+    {
+        //dhcps_client_leave(leases[i].mac,&ip,true); // force to delete
+        if ((leases[i].state != DHCPS_STATE_FREE) && (_netif->num == SOFTAP_IF))
         {
-            wifi_softap_set_station_info(dhcp_node->mac, &ip_zero);
+            wifi_softap_set_station_info(leases[i].mac, &ip_zero);
         }
-        free(pback_node->pnode);
-        pback_node->pnode = nullptr;
-        free(pback_node);
-        pback_node = nullptr;
     }
+    free_lease_table();
 }
 
 bool DhcpServer::isRunning()
@@ -1225,59 +1284,41 @@ bool DhcpServer::get_dhcps_lease(struct dhcps_lease *please)
 
 void DhcpServer::kill_oldest_dhcps_pool(void)
 {
-    list_node *pre = nullptr, *p = nullptr;
-    list_node *minpre = nullptr, *minp = nullptr;
-    struct dhcps_pool *pdhcps_pool = nullptr, *pmin_pool = nullptr;
-    pre = plist;
-    p = pre->pnext;
-    minpre = pre;
-    minp = p;
-    while (p != nullptr)
-    {
-        pdhcps_pool = (struct dhcps_pool*)p->pnode;
-        pmin_pool = (struct dhcps_pool*)minp->pnode;
-        if (pdhcps_pool->lease_timer < pmin_pool->lease_timer)
+    struct dhcps_pool *pmin_pool = nullptr;
+    for (uint16 i = 0; i < leases_count; i++)
+    {
+        if ((leases[i].state != DHCPS_STATE_FREE)
+                && ((pmin_pool == nullptr) || (leases[i].lease_timer < pmin_pool->lease_timer)))
         {
-            minp = p;
-            minpre = pre;
+            pmin_pool = &leases[i];
         }
-        pre = p;
-        p = p->pnext;
-    }
-    minpre->pnext = minp->pnext; pdhcps_pool->state = DHCPS_STATE_OFFLINE;
-    free(minp->pnode);
-    minp->pnode = nullptr;
-    free(minp);
-    minp = nullptr;
+    }
+    if (pmin_pool != nullptr)
+    {
+        lease_free(pmin_pool);
+    }
 }
 
 void DhcpServer::dhcps_coarse_tmr(void)
 {
     uint8 num_dhcps_pool = 0;
-    list_node *pback_node = nullptr;
-    list_node *pnode = nullptr;
-    struct dhcps_pool *pdhcps_pool = nullptr;
-    pnode = plist;
-    while (pnode != nullptr)
+    for (uint16 i = 0; i < leases_count; i++)
     {
-        pdhcps_pool = (struct dhcps_pool*)pnode->pnode;
+        struct dhcps_pool *pdhcps_pool = &leases[i];
+        if (pdhcps_pool->state == DHCPS_STATE_FREE)
+        {
+            continue;
+        }
         if (pdhcps_pool->type == DHCPS_TYPE_DYNAMIC)
         {
             pdhcps_pool->lease_timer --;
         }
         if (pdhcps_pool->lease_timer == 0)
         {
-            pback_node = pnode;
-            pnode = pback_node->pnext;
-            node_remove_from_list(&plist, pback_node);
-            free(pback_node->pnode);
-            pback_node->pnode = nullptr;
-            free(pback_node);
-            pback_node = nullptr;
+            lease_free(pdhcps_pool);
         }
         else
         {
-            pnode = pnode ->pnext;
             num_dhcps_pool ++;
         }
     }
@@ -1366,48 +1407,29 @@ uint32 DhcpServer::get_dhcps_lease_time(void) // minute
 void DhcpServer::dhcps_client_leave(u8 *bssid, struct ipv4_addr *ip, bool force)
 {
     struct dhcps_pool *pdhcps_pool = nullptr;
-    list_node *pback_node = nullptr;
 
     if ((bssid == nullptr) || (ip == nullptr))
     {
         return;
     }
 
-    for (pback_node = plist; pback_node != nullptr; pback_node = pback_node->pnext)
+    pdhcps_pool = find_lease_by_mac(bssid);
+    if ((pdhcps_pool != nullptr) && (lease_ip(pdhcps_pool) == ip->addr))
     {
-        pdhcps_pool = (struct dhcps_pool*)pback_node->pnode;
-        if (memcmp(pdhcps_pool->mac, bssid, sizeof(pdhcps_pool->mac)) == 0)
+        if ((pdhcps_pool->type == DHCPS_TYPE_STATIC) || (force))
         {
-            if (memcmp(&pdhcps_pool->ip.addr, &ip->addr, sizeof(pdhcps_pool->ip.addr)) == 0)
-            {
-                if ((pdhcps_pool->type == DHCPS_TYPE_STATIC) || (force))
-                {
-                    if (pback_node != nullptr)
-                    {
-                        node_remove_from_list(&plist, pback_node);
-                        free(pback_node);
-                        pback_node = nullptr;
-                    }
-
-                    if (pdhcps_pool != nullptr)
-                    {
-                        free(pdhcps_pool);
-                        pdhcps_pool = nullptr;
-                    }
-                }
-                else
-                {
-                    pdhcps_pool->state = DHCPS_STATE_OFFLINE;
-                }
-
-                struct ipv4_addr ip_zero;
-                memset(&ip_zero, 0x0, sizeof(ip_zero));
-                if (_netif->num == SOFTAP_IF)
-                {
-                    wifi_softap_set_station_info(bssid, &ip_zero);
-                }
-                break;
-            }
+            lease_free(pdhcps_pool);
+        }
+        else
+        {
+            pdhcps_pool->state = DHCPS_STATE_OFFLINE;
+        }
+
+        struct ipv4_addr ip_zero;
+        memset(&ip_zero, 0x0, sizeof(ip_zero));
+        if (_netif->num == SOFTAP_IF)
+        {
+            wifi_softap_set_station_info(bssid, &ip_zero);
         }
     }
 }
@@ -1415,12 +1437,8 @@ void DhcpServer::dhcps_client_leave(u8 *bssid, struct ipv4_addr *ip, bool force)
 uint32 DhcpServer::dhcps_client_update(u8 *bssid, struct ipv4_addr *ip)
 {
     struct dhcps_pool *pdhcps_pool = nullptr;
-    list_node *pback_node = nullptr;
-    list_node *pmac_node = nullptr;
-    list_node *pip_node = nullptr;
-    bool flag = false;
-    uint32 start_ip = dhcps_lease.start_ip.addr;
-    uint32 end_ip = dhcps_lease.end_ip.addr;
+    struct dhcps_pool *pmac_pool = nullptr;
+    struct dhcps_pool *pip_pool = nullptr;
     dhcps_type_t type = DHCPS_TYPE_DYNAMIC;
     if (bssid == nullptr)
     {
@@ -1444,163 +1462,60 @@ uint32 DhcpServer::dhcps_client_update(u8 *bssid, struct ipv4_addr *ip)
     }
 
     renew = false;
-    for (pback_node = plist; pback_node != nullptr; pback_node = pback_node->pnext)
-    {
-        pdhcps_pool = (struct dhcps_pool*)pback_node->pnode;
-        //os_printf("mac:"MACSTR"bssid:"MACSTR"\r\n",MAC2STR(pdhcps_pool->mac),MAC2STR(bssid));
-        if (memcmp(pdhcps_pool->mac, bssid, sizeof(pdhcps_pool->mac)) == 0)
-        {
-            pmac_node = pback_node;
-            if (ip == nullptr)
-            {
-                flag = true;
-                break;
-            }
-        }
-        if (ip != nullptr)
-        {
-            if (memcmp(&pdhcps_pool->ip.addr, &ip->addr, sizeof(pdhcps_pool->ip.addr)) == 0)
-            {
-                pip_node = pback_node;
-            }
-        }
-        else if (flag == false)
-        {
-            if (memcmp(&pdhcps_pool->ip.addr, &start_ip, sizeof(pdhcps_pool->ip.addr)) != 0)
-            {
-                flag = true;
-            }
-            else
-            {
-                start_ip = htonl((ntohl(start_ip) + 1));
-            }
-        }
-    }
-
-    if ((ip == nullptr) && (flag == false))
+    if (ip != nullptr)
     {
-        if (plist == nullptr)
-        {
-            if (start_ip <= end_ip)
-            {
-                flag = true;
-            }
-            else
-            {
-                return IPADDR_ANY;
-            }
-        }
-        else
+        // the table may grow (move) here, so look for the mac afterwards
+        pip_pool = lease_slot(ip->addr, true);
+        if (pip_pool == nullptr)    // ip out of range
         {
-            if (start_ip > end_ip)
-            {
-                return IPADDR_ANY;
-            }
-            //start_ip = htonl((ntohl(start_ip) + 1));
-            flag = true;
+            return IPADDR_ANY;
         }
     }
+    pmac_pool = find_lease_by_mac(bssid);
 
-    if (pmac_node != nullptr)   // update new ip
+    if (pmac_pool != nullptr)   // known station
     {
-        if (pip_node != nullptr)
+        if (pip_pool == pmac_pool)
         {
-            pdhcps_pool = (struct dhcps_pool*)pip_node->pnode;
-
-            if (pip_node != pmac_node)
-            {
-                if (pdhcps_pool->state != DHCPS_STATE_OFFLINE)  // ip is used
-                {
-                    return IPADDR_ANY;
-                }
-
-                // mac exists and ip exists in other node,delete mac
-                node_remove_from_list(&plist, pmac_node);
-                free(pmac_node->pnode);
-                pmac_node->pnode = nullptr;
-                free(pmac_node);
-                pmac_node = pip_node;
-                memcpy(pdhcps_pool->mac, bssid, sizeof(pdhcps_pool->mac));
-            }
-            else
-            {
-                renew = true;
-                type = DHCPS_TYPE_DYNAMIC;
-            }
-
-            pdhcps_pool->lease_timer = DHCPS_LEASE_TIMER;
-            pdhcps_pool->type = type;
-            pdhcps_pool->state = DHCPS_STATE_ONLINE;
-
+            renew = true;
+            type = DHCPS_TYPE_DYNAMIC;
         }
-        else
+        else if (pip_pool != nullptr)   // update new ip
         {
-            pdhcps_pool = (struct dhcps_pool*)pmac_node->pnode;
-            if (ip != nullptr)
-            {
-                pdhcps_pool->ip.addr = ip->addr;
-            }
-            else if (flag == true)
-            {
-                pdhcps_pool->ip.addr = start_ip;
-            }
-            else        // no ip to distribute
+            if (pip_pool->state == DHCPS_STATE_ONLINE)  // ip is used
             {
                 return IPADDR_ANY;
             }
 
-            node_remove_from_list(&plist, pmac_node);
-            pdhcps_pool->lease_timer = DHCPS_LEASE_TIMER;
-            pdhcps_pool->type = type;
-            pdhcps_pool->state = DHCPS_STATE_ONLINE;
-            node_insert_to_list(&plist, pmac_node);
+            // mac exists and ip exists in other node,delete mac
+            lease_free(pmac_pool);
+            lease_free(pip_pool);
+            lease_set_mac(pip_pool, bssid);
+            pmac_pool = pip_pool;
         }
+        pdhcps_pool = pmac_pool;
     }
     else     // new station
     {
-        if (pip_node != nullptr)   // maybe ip has used
+        if (pip_pool != nullptr)   // maybe ip has used
         {
-            pdhcps_pool = (struct dhcps_pool*)pip_node->pnode;
-            if (pdhcps_pool->state != DHCPS_STATE_OFFLINE)
+            if (pip_pool->state == DHCPS_STATE_ONLINE)
             {
                 return IPADDR_ANY;
             }
-            memcpy(pdhcps_pool->mac, bssid, sizeof(pdhcps_pool->mac));
-            pdhcps_pool->lease_timer = DHCPS_LEASE_TIMER;
-            pdhcps_pool->type = type;
-            pdhcps_pool->state = DHCPS_STATE_ONLINE;
+            lease_free(pip_pool);
+            pdhcps_pool = pip_pool;
         }
-        else
+        else if ((pdhcps_pool = find_free_lease()) == nullptr)   // no ip to distribute
         {
-            pdhcps_pool = (struct dhcps_pool *)zalloc(sizeof(struct dhcps_pool));
-            if (ip != nullptr)
-            {
-                pdhcps_pool->ip.addr = ip->addr;
-            }
-            else if (flag == true)
-            {
-                pdhcps_pool->ip.addr = start_ip;
-            }
-            else        // no ip to distribute
-            {
-                free(pdhcps_pool);
-                return IPADDR_ANY;
-            }
-            if (pdhcps_pool->ip.addr > end_ip)
-            {
-                free(pdhcps_pool);
-                return IPADDR_ANY;
-            }
-            memcpy(pdhcps_pool->mac, bssid, sizeof(pdhcps_pool->mac));
-            pdhcps_pool->lease_timer = DHCPS_LEASE_TIMER;
-            pdhcps_pool->type = type;
-            pdhcps_pool->state = DHCPS_STATE_ONLINE;
-            pback_node = (list_node *)zalloc(sizeof(list_node));
-            pback_node->pnode = pdhcps_pool;
-            pback_node->pnext = nullptr;
-            node_insert_to_list(&plist, pback_node);
+            return IPADDR_ANY;
         }
+        lease_set_mac(pdhcps_pool, bssid);
     }
 
-    return pdhcps_pool->ip.addr;
+    pdhcps_pool->lease_timer = DHCPS_LEASE_TIMER;
+    pdhcps_pool->type = type;
+    pdhcps_pool->state = DHCPS_STATE_ONLINE;
+
+    return lease_ip(pdhcps_pool);
 }
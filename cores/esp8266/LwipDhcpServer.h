@@ -68,14 +68,15 @@ protected:
 
     // legacy C structure and API to eventually turn into C++
 
-    typedef struct _list_node
-    {
-        void *pnode;
-        struct _list_node *pnext;
-    } list_node;
-
-    void node_insert_to_list(list_node **phead, list_node* pinsert);
-    void node_remove_from_list(list_node **phead, list_node* pdelete);
+    // leases are kept in a table indexed by the offset of their address in
+    // the lease range (grown on demand), with a small hash for MAC lookups
+    struct dhcps_pool* lease_slot(uint32 ip, bool grow); // ip in network order
+    struct dhcps_pool* find_lease_by_mac(const uint8 *mac);
+    struct dhcps_pool* find_free_lease(void);
+    uint32 lease_ip(const struct dhcps_pool* pool) const;
+    void lease_set_mac(struct dhcps_pool* pool, const uint8 *mac);
+    void lease_free(struct dhcps_pool* pool);
+    void free_lease_table(void);
     uint8_t* add_msg_type(uint8_t *optptr, uint8_t type);
     uint8_t* add_offer_options(uint8_t *optptr);
     uint8_t* add_end(uint8_t *optptr);
@@ -110,7 +111,11 @@ protected:
     uint32 dhcps_lease_time;
 
     struct dhcps_lease dhcps_lease;
-    list_node *plist;
+    struct dhcps_pool *leases;
+    uint32 leases_start;    // dhcps_lease.start_ip when the table was made
+    uint16 leases_count;
+    static constexpr uint8 mac_hash_size = 16;
+    uint8 mac_hash[mac_hash_size];
     uint8 offer;
     bool renew;
 
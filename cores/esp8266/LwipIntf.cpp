@@ -14,6 +14,14 @@ extern "C" {
 
 #include "debug.h"
 #include "LwipIntf.h"
+#include "Print.h"
+
+size_t LwipIntf::Stats::printTo(Print& p) const
+{
+    return p.printf_P(PSTR("rx %u pkts %u bytes, drop %u err %u nopbuf %u polllimit %u / tx %u pkts %u bytes, err %u / input %u us (max %u)"),
+                      rxPackets, rxBytes, rxDrops, rxErrors, rxAllocFail, rxPollLimit,
+                      txPackets, txBytes, txErrors, inputUs, inputMaxUs);
+}
 
 // args      | esp order    arduino order
 // ----      + ---------    -------------
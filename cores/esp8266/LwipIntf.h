@@ -13,6 +13,25 @@ public:
 
     using CBType = std::function <void(netif*)>;
 
+    // traffic counters of an interface driven by this core (LwipIntfDev),
+    // all wrapping 32 bits: compare two readings to get rates
+    struct Stats: public Printable
+    {
+        uint32_t rxPackets = 0;
+        uint32_t rxBytes = 0;
+        uint32_t rxDrops = 0;       // refused by netif->input()
+        uint32_t rxErrors = 0;      // driver read errors
+        uint32_t rxAllocFail = 0;   // no pbuf, frame discarded
+        uint32_t rxPollLimit = 0;   // polls stopped at the per-poll frame limit
+        uint32_t txPackets = 0;
+        uint32_t txBytes = 0;
+        uint32_t txErrors = 0;
+        uint32_t inputUs = 0;       // total time spent in netif->input()
+        uint32_t inputMaxUs = 0;
+
+        size_t printTo(Print& p) const override;
+    };
+
     static bool stateUpCB(LwipIntf::CBType&& cb);
 
     // reorder WiFi.config() parameters for a esp8266/official Arduino dual-compatibility API
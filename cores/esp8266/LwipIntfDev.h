@@ -74,6 +74,18 @@ public:
 
     wl_status_t status();
 
+    // traffic counters of this interface
+    const Stats& stats() const
+    {
+        return _stats;
+    }
+    void resetStats()
+    {
+        _stats = Stats();
+    }
+    // print a line of counters to 'out' every 'periodMs', 0 to stop
+    bool printStats(Print& out, uint32_t periodMs);
+
 protected:
 
     err_t netif_init();
@@ -82,6 +94,7 @@ protected:
     static err_t netif_init_s(netif* netif);
     static err_t linkoutput_s(netif *netif, struct pbuf *p);
     static void  netif_status_callback_s(netif* netif);
+    static void  IRAM_ATTR intr_s(void* arg);
 
     // called on a regular basis or on interrupt
     err_t handlePackets();
@@ -95,6 +108,10 @@ protected:
     uint8_t     _macAddress[6];
     bool        _started;
     bool        _default;
+    volatile bool _intrPending = false;
+
+    Stats       _stats;
+    uint32_t    _statsPrinter = 0;
 
 };
 
@@ -197,9 +214,31 @@ boolean LwipIntfDev<RawDev>::begin(const uint8_t* macAddress, const uint16_t mtu
 
     if (_intrPin >= 0)
     {
-        if (RawDev::interruptIsPossible())
+        if constexpr (RawDev::interruptIsPossible())
         {
-            //attachInterrupt(_intrPin, [&]() { this->handlePackets(); }, FALLING);
+            // frames are read from the first scheduler pass (end of loop()
+            // or any yield()/delay()) after the pin fires, the slow poll
+            // catches up with a missed edge
+            RawDev::enableRecvInterrupt();
+            pinMode(_intrPin, INPUT);
+            attachInterruptArg(_intrPin, intr_s, this, FALLING);
+            auto service = [&]()
+            {
+                this->_intrPending = false;
+                this->clearRecvInterrupt();
+                this->handlePackets();
+                return true;
+            };
+            auto pending = [&]()
+            {
+                return this->_intrPending;
+            };
+            if (!schedule_recurrent_function_us(service, 100000, pending))
+            {
+                detachInterrupt(_intrPin);
+                netif_remove(&_netif);
+                return false;
+            }
         }
         else
         {
@@ -227,6 +266,27 @@ wl_status_t LwipIntfDev<RawDev>::status()
     return _started ? (connected() ? WL_CONNECTED : WL_DISCONNECTED) : WL_NO_SHIELD;
 }
 
+template <class RawDev>
+bool LwipIntfDev<RawDev>::printStats(Print& out, uint32_t periodMs)
+{
+    // a running printer stops when it sees another id
+    uint32_t id = ++_statsPrinter;
+    if (!periodMs)
+    {
+        return true;
+    }
+    return schedule_recurrent_function_us([this, &out, id]()
+    {
+        if (id != _statsPrinter)
+        {
+            return false;
+        }
+        out.printf_P(PSTR("%c%c: "), _netif.name[0], _netif.name[1]);
+        out.println(_stats);
+        return true;
+    }, periodMs * 1000);
+}
+
 template <class RawDev>
 err_t LwipIntfDev<RawDev>::linkoutput_s(netif *netif, struct pbuf *pbuf)
 {
@@ -238,6 +298,15 @@ err_t LwipIntfDev<RawDev>::linkoutput_s(netif *netif, struct pbuf *pbuf)
     }
 
     uint16_t len = ths->sendFrame((const uint8_t*)pbuf->payload, pbuf->len);
+    if (len == pbuf->len)
+    {
+        ths->_stats.txPackets++;
+        ths->_stats.txBytes += len;
+    }
+    else
+    {
+        ths->_stats.txErrors++;
+    }
 
 #if PHY_HAS_CAPTURE
     if (phy_capture)
@@ -249,6 +318,12 @@ err_t LwipIntfDev<RawDev>::linkoutput_s(netif *netif, struct pbuf *pbuf)
     return len == pbuf->len ? ERR_OK : ERR_MEM;
 }
 
+template <class RawDev>
+void LwipIntfDev<RawDev>::intr_s(void* arg)
+{
+    ((LwipIntfDev*)arg)->_intrPending = true;
+}
+
 template <class RawDev>
 err_t LwipIntfDev<RawDev>::netif_init_s(struct netif* netif)
 {
@@ -315,6 +390,9 @@ err_t LwipIntfDev<RawDev>::handlePackets()
         if (++pkt == 10)
             // prevent starvation
         {
+            _stats.rxPollLimit++;
+            // in interrupt mode, come back on next scheduler pass
+            _intrPending = true;
             return ERR_OK;
         }
 
@@ -339,6 +417,7 @@ err_t LwipIntfDev<RawDev>::handlePackets()
             {
                 pbuf_free(pbuf);
             }
+            _stats.rxAllocFail++;
             RawDev::discardFrame(tot_len);
             return ERR_BUF;
         }
@@ -350,11 +429,22 @@ err_t LwipIntfDev<RawDev>::handlePackets()
             // and is supposed to be honoured by readFrameData()
             // todo: ensure this test is unneeded, remove the print
             Serial.println("read error?\r\n");
+            _stats.rxErrors++;
             pbuf_free(pbuf);
             return ERR_BUF;
         }
 
+        _stats.rxPackets++;
+        _stats.rxBytes += tot_len;
+
+        uint32_t inputStart = micros();
         err_t err = _netif.input(pbuf, &_netif);
+        uint32_t inputUs = micros() - inputStart;
+        _stats.inputUs += inputUs;
+        if (inputUs > _stats.inputMaxUs)
+        {
+            _stats.inputMaxUs = inputUs;
+        }
 
 #if PHY_HAS_CAPTURE
         if (phy_capture)
@@ -365,6 +455,7 @@ err_t LwipIntfDev<RawDev>::handlePackets()
 
         if (err != ERR_OK)
         {
+            _stats.rxDrops++;
             pbuf_free(pbuf);
             return err;
         }
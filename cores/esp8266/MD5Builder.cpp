@@ -1,6 +1,7 @@
 #include <Arduino.h>
 #include <MD5Builder.h>
 #include <memory>
+#include <algorithm>
 
 uint8_t hex_char_to_byte(uint8_t c) {
     return (c >= 'a' && c <= 'f') ? (c - ((uint8_t)'a' - 0xa)) :
@@ -8,13 +9,160 @@ uint8_t hex_char_to_byte(uint8_t c) {
            (c >= '0' && c <= '9') ? (c - (uint8_t)'0') : 0;
 }
 
+/*
+  MD5 with the 64 steps unrolled, in place of the ROM MD5Update() which
+  runs a table driven loop.  The context keeps the layout of md5_context_t:
+  state, bit count (low word first), partial block.
+*/
+namespace {
+
+inline uint32_t md5_rol(uint32_t x, uint32_t n) {
+    return (x << n) | (x >> (32 - n));
+}
+
+#define MD5_F(x, y, z) ((z) ^ ((x) & ((y) ^ (z))))
+#define MD5_G(x, y, z) ((y) ^ ((z) & ((x) ^ (y))))
+#define MD5_H(x, y, z) ((x) ^ (y) ^ (z))
+#define MD5_I(x, y, z) ((y) ^ ((x) | ~(z)))
+#define MD5_STEP(f, a, b, c, d, x, t, s) \
+    a += f(b, c, d) + (x) + (t); \
+    a = md5_rol(a, s) + b;
+
+void md5_blocks(uint32_t state[4], const uint8_t* data, size_t blocks) {
+    uint32_t x[16];
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    for (; blocks; --blocks, data += 64) {
+        // both the host and the lx106 are little endian
+        memcpy(x, data, sizeof(x));
+        const uint32_t aa = a, bb = b, cc = c, dd = d;
+
+        MD5_STEP(MD5_F, a, b, c, d, x[ 0], 0xd76aa478,  7)
+        MD5_STEP(MD5_F, d, a, b, c, x[ 1], 0xe8c7b756, 12)
+        MD5_STEP(MD5_F, c, d, a, b, x[ 2], 0x242070db, 17)
+        MD5_STEP(MD5_F, b, c, d, a, x[ 3], 0xc1bdceee, 22)
+        MD5_STEP(MD5_F, a, b, c, d, x[ 4], 0xf57c0faf,  7)
+        MD5_STEP(MD5_F, d, a, b, c, x[ 5], 0x4787c62a, 12)
+        MD5_STEP(MD5_F, c, d, a, b, x[ 6], 0xa8304613, 17)
+        MD5_STEP(MD5_F, b, c, d, a, x[ 7], 0xfd469501, 22)
+        MD5_STEP(MD5_F, a, b, c, d, x[ 8], 0x698098d8,  7)
+        MD5_STEP(MD5_F, d, a, b, c, x[ 9], 0x8b44f7af, 12)
+        MD5_STEP(MD5_F, c, d, a, b, x[10], 0xffff5bb1, 17)
+        MD5_STEP(MD5_F, b, c, d, a, x[11], 0x895cd7be, 22)
+        MD5_STEP(MD5_F, a, b, c, d, x[12], 0x6b901122,  7)
+        MD5_STEP(MD5_F, d, a, b, c, x[13], 0xfd987193, 12)
+        MD5_STEP(MD5_F, c, d, a, b, x[14], 0xa679438e, 17)
+        MD5_STEP(MD5_F, b, c, d, a, x[15], 0x49b40821, 22)
+
+        MD5_STEP(MD5_G, a, b, c, d, x[ 1], 0xf61e2562,  5)
+        MD5_STEP(MD5_G, d, a, b, c, x[ 6], 0xc040b340,  9)
+        MD5_STEP(MD5_G, c, d, a, b, x[11], 0x265e5a51, 14)
+        MD5_STEP(MD5_G, b, c, d, a, x[ 0], 0xe9b6c7aa, 20)
+        MD5_STEP(MD5_G, a, b, c, d, x[ 5], 0xd62f105d,  5)
+        MD5_STEP(MD5_G, d, a, b, c, x[10], 0x02441453,  9)
+        MD5_STEP(MD5_G, c, d, a, b, x[15], 0xd8a1e681, 14)
+        MD5_STEP(MD5_G, b, c, d, a, x[ 4], 0xe7d3fbc8, 20)
+        MD5_STEP(MD5_G, a, b, c, d, x[ 9], 0x21e1cde6,  5)
+        MD5_STEP(MD5_G, d, a, b, c, x[14], 0xc33707d6,  9)
+        MD5_STEP(MD5_G, c, d, a, b, x[ 3], 0xf4d50d87, 14)
+        MD5_STEP(MD5_G, b, c, d, a, x[ 8], 0x455a14ed, 20)
+        MD5_STEP(MD5_G, a, b, c, d, x[13], 0xa9e3e905,  5)
+        MD5_STEP(MD5_G, d, a, b, c, x[ 2], 0xfcefa3f8,  9)
+        MD5_STEP(MD5_G, c, d, a, b, x[ 7], 0x676f02d9, 14)
+        MD5_STEP(MD5_G, b, c, d, a, x[12], 0x8d2a4c8a, 20)
+
+        MD5_STEP(MD5_H, a, b, c, d, x[ 5], 0xfffa3942,  4)
+        MD5_STEP(MD5_H, d, a, b, c, x[ 8], 0x8771f681, 11)
+        MD5_STEP(MD5_H, c, d, a, b, x[11], 0x6d9d6122, 16)
+        MD5_STEP(MD5_H, b, c, d, a, x[14], 0xfde5380c, 23)
+        MD5_STEP(MD5_H, a, b, c, d, x[ 1], 0xa4beea44,  4)
+        MD5_STEP(MD5_H, d, a, b, c, x[ 4], 0x4bdecfa9, 11)
+        MD5_STEP(MD5_H, c, d, a, b, x[ 7], 0xf6bb4b60, 16)
+        MD5_STEP(MD5_H, b, c, d, a, x[10], 0xbebfbc70, 23)
+        MD5_STEP(MD5_H, a, b, c, d, x[13], 0x289b7ec6,  4)
+        MD5_STEP(MD5_H, d, a, b, c, x[ 0], 0xeaa127fa, 11)
+        MD5_STEP(MD5_H, c, d, a, b, x[ 3], 0xd4ef3085, 16)
+        MD5_STEP(MD5_H, b, c, d, a, x[ 6], 0x04881d05, 23)
+        MD5_STEP(MD5_H, a, b, c, d, x[ 9], 0xd9d4d039,  4)
+        MD5_STEP(MD5_H, d, a, b, c, x[12], 0xe6db99e5, 11)
+        MD5_STEP(MD5_H, c, d, a, b, x[15], 0x1fa27cf8, 16)
+        MD5_STEP(MD5_H, b, c, d, a, x[ 2], 0xc4ac5665, 23)
+
+        MD5_STEP(MD5_I, a, b, c, d, x[ 0], 0xf4292244,  6)
+        MD5_STEP(MD5_I, d, a, b, c, x[ 7], 0x432aff97, 10)
+        MD5_STEP(MD5_I, c, d, a, b, x[14], 0xab9423a7, 15)
+        MD5_STEP(MD5_I, b, c, d, a, x[ 5], 0xfc93a039, 21)
+        MD5_STEP(MD5_I, a, b, c, d, x[12], 0x655b59c3,  6)
+        MD5_STEP(MD5_I, d, a, b, c, x[ 3], 0x8f0ccc92, 10)
+        MD5_STEP(MD5_I, c, d, a, b, x[10], 0xffeff47d, 15)
+        MD5_STEP(MD5_I, b, c, d, a, x[ 1], 0x85845dd1, 21)
+        MD5_STEP(MD5_I, a, b, c, d, x[ 8], 0x6fa87e4f,  6)
+        MD5_STEP(MD5_I, d, a, b, c, x[15], 0xfe2ce6e0, 10)
+        MD5_STEP(MD5_I, c, d, a, b, x[ 6], 0xa3014314, 15)
+        MD5_STEP(MD5_I, b, c, d, a, x[13], 0x4e0811a1, 21)
+        MD5_STEP(MD5_I, a, b, c, d, x[ 4], 0xf7537e82,  6)
+        MD5_STEP(MD5_I, d, a, b, c, x[11], 0xbd3af235, 10)
+        MD5_STEP(MD5_I, c, d, a, b, x[ 2], 0x2ad7d2bb, 15)
+        MD5_STEP(MD5_I, b, c, d, a, x[ 9], 0xeb86d391, 21)
+
+        a += aa;
+        b += bb;
+        c += cc;
+        d += dd;
+    }
+    state[0] = a;
+    state[1] = b;
+    state[2] = c;
+    state[3] = d;
+}
+
+void md5_init(md5_context_t* ctx) {
+    ctx->state[0] = 0x67452301;
+    ctx->state[1] = 0xefcdab89;
+    ctx->state[2] = 0x98badcfe;
+    ctx->state[3] = 0x10325476;
+    ctx->count[0] = 0;
+    ctx->count[1] = 0;
+}
+
+void md5_update(md5_context_t* ctx, const uint8_t* data, size_t len) {
+    const uint32_t used = (ctx->count[0] >> 3) & 63;
+    const uint32_t bits = (uint32_t)len << 3;
+    ctx->count[0] += bits;
+    ctx->count[1] += (uint32_t)(len >> 29) + (ctx->count[0] < bits);
+
+    if (used) {
+        const size_t fill = std::min(len, (size_t)(64 - used));
+        memcpy(ctx->buffer + used, data, fill);
+        if (used + fill < 64) {
+            return;
+        }
+        md5_blocks(ctx->state, ctx->buffer, 1);
+        data += fill;
+        len -= fill;
+    }
+    md5_blocks(ctx->state, data, len / 64);
+    memcpy(ctx->buffer, data + (len & ~(size_t)63), len & 63);
+}
+
+void md5_final(uint8_t digest[16], md5_context_t* ctx) {
+    uint8_t lengths[8];
+    memcpy(lengths, ctx->count, sizeof(lengths));
+    const uint32_t used = (ctx->count[0] >> 3) & 63;
+    static const uint8_t padding[64] = { 0x80 };
+    md5_update(ctx, padding, (used < 56 ? 56 : 120) - used);
+    md5_update(ctx, lengths, sizeof(lengths));
+    memcpy(digest, ctx->state, 16);
+}
+
+} // namespace
+
 void MD5Builder::begin(void){
     memset(_buf, 0x00, 16);
-    MD5Init(&_ctx);
+    md5_init(&_ctx);
 }
 
 void MD5Builder::add(const uint8_t * data, const uint16_t len){
-    MD5Update(&_ctx, data, len);
+    md5_update(&_ctx, data, len);
 }
 
 void MD5Builder::addHexString(const char * data){
@@ -34,6 +182,22 @@ void MD5Builder::addHexString(const char * data){
 }
 
 bool MD5Builder::addStream(Stream &stream, const size_t maxLen) {
+    if (stream.hasPeekBufferAPI()) {
+        // hash straight from the stream's buffer, no copy
+        size_t maxLengthLeft = maxLen;
+        size_t bytesAvailable;
+        while (maxLengthLeft && (bytesAvailable = stream.peekAvailable())) {
+            if (bytesAvailable > maxLengthLeft) {
+                bytesAvailable = maxLengthLeft;
+            }
+            md5_update(&_ctx, (const uint8_t*)stream.peekBuffer(), bytesAvailable);
+            stream.peekConsume(bytesAvailable);
+            maxLengthLeft -= bytesAvailable;
+            yield();
+        }
+        return true;
+    }
+
     const int buf_size = 512;
     int maxLengthLeft = maxLen;
 
@@ -62,7 +226,7 @@ bool MD5Builder::addStream(Stream &stream, const size_t maxLen) {
         }
 
         // Update MD5 with buffer payload
-        MD5Update(&_ctx, buf.get(), numBytesRead);
+        md5_update(&_ctx, buf.get(), numBytesRead);
 
         yield();      // time for network streams
 
@@ -75,7 +239,7 @@ bool MD5Builder::addStream(Stream &stream, const size_t maxLen) {
 }
 
 void MD5Builder::calculate(void){
-    MD5Final(_buf, &_ctx);
+    md5_final(_buf, &_ctx);
 }
 
 void MD5Builder::getBytes(uint8_t * output) const {
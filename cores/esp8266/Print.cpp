@@ -47,49 +47,73 @@ size_t Print::write(const uint8_t *buffer, size_t size) {
     return n;
 }
 
-size_t Print::printf(const char *format, ...) {
-    va_list arg;
-    va_start(arg, format);
+typedef int (*vsnprintf_t)(char*, size_t, const char*, va_list);
+
+// Formats straight into the destination when it has a write buffer:
+// one pass when the output fits in what is immediately available, a second
+// one into a reservation of the exact size otherwise, and no heap copy.
+static size_t printf_impl(Print& out, vsnprintf_t format_fn, const char* format, va_list arg) {
+    va_list copy;
     char temp[64];
     char* buffer = temp;
-    size_t len = vsnprintf(temp, sizeof(temp), format, arg);
-    va_end(arg);
-    if (len > sizeof(temp) - 1) {
+    size_t size = sizeof(temp);
+    const bool direct = out.hasWriteBufferAPI();
+    if (direct) {
+        char* dst = out.writeBuffer(size);
+        if (dst && size >= sizeof(temp)) {
+            buffer = dst;
+        } else {
+            size = sizeof(temp);
+        }
+    }
+    va_copy(copy, arg);
+    size_t len = format_fn(buffer, size, format, copy);
+    va_end(copy);
+    if (buffer != temp && len < size) {
+        out.writeCommit(len);
+        return len;
+    }
+    if (len > size - 1) {
+        buffer = nullptr;
+        if (direct) {
+            size = len + 1;
+            buffer = out.writeBuffer(size);
+            if (buffer && size >= len + 1) {
+                va_copy(copy, arg);
+                format_fn(buffer, len + 1, format, copy);
+                va_end(copy);
+                out.writeCommit(len);
+                return len;
+            }
+        }
         buffer = new (std::nothrow) char[len + 1];
         if (!buffer) {
             return 0;
         }
-        va_start(arg, format);
-        vsnprintf(buffer, len + 1, format, arg);
-        va_end(arg);
+        va_copy(copy, arg);
+        format_fn(buffer, len + 1, format, copy);
+        va_end(copy);
     }
-    len = write((const uint8_t*) buffer, len);
+    len = out.write((const uint8_t*) buffer, len);
     if (buffer != temp) {
         delete[] buffer;
     }
     return len;
 }
 
+size_t Print::printf(const char *format, ...) {
+    va_list arg;
+    va_start(arg, format);
+    size_t len = printf_impl(*this, vsnprintf, format, arg);
+    va_end(arg);
+    return len;
+}
+
 size_t Print::printf_P(PGM_P format, ...) {
     va_list arg;
     va_start(arg, format);
-    char temp[64];
-    char* buffer = temp;
-    size_t len = vsnprintf_P(temp, sizeof(temp), format, arg);
+    size_t len = printf_impl(*this, vsnprintf_P, format, arg);
     va_end(arg);
-    if (len > sizeof(temp) - 1) {
-        buffer = new (std::nothrow) char[len + 1];
-        if (!buffer) {
-            return 0;
-        }
-        va_start(arg, format);
-        vsnprintf_P(buffer, len + 1, format, arg);
-        va_end(arg);
-    }
-    len = write((const uint8_t*) buffer, len);
-    if (buffer != temp) {
-        delete[] buffer;
-    }
     return len;
 }
 
@@ -101,7 +125,7 @@ size_t Print::print(const __FlashStringHelper *ifsh) {
     size_t n = 0;
     while (n < len) {
         int to_write = std::min(sizeof(buff), len - n);
-        memcpy_P(buff, p, to_write);
+        memcpy_P_bulk(buff, p, to_write);
         auto written = write(buff, to_write);
         n += written;
         p += written;
@@ -249,8 +273,19 @@ template<typename T> size_t Print::printNumber(T n, uint8_t base) {
     *str = '\0';
 
     // prevent crash if called with base == 1
-    if (base < 2) {
-        base = 10;
+    if (base < 2 || base == 10) {
+        return write(ulltoa_dec(n, str));
+    }
+
+    if (!(base & (base - 1))) {
+        // 2, 4, 8, 16...: shifts instead of divisions
+        const int shift = __builtin_ctz(base);
+        do {
+            char c = n & (base - 1);
+            n >>= shift;
+            *--str = c < 10 ? c + '0' : c + 'A' - 10;
+        } while (n);
+        return write(str);
     }
 
     do {
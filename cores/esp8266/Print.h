@@ -115,6 +115,20 @@ class Print {
         // by default write timeout is possible (outgoing data from network,serial..)
         // (children can override to false (like String))
         virtual bool outputCanTimeout () { return true; }
+
+        //////////////////// extension: direct access to output buffer
+        // destination side of Stream's peekBuffer API, lets Stream::send*()
+        // copy straight into the output buffer
+
+        // by default: not available
+        virtual bool hasWriteBufferAPI () const { return false; }
+
+        // returns where up to len bytes can be written, lowering len to what
+        // is available right now (nullptr and len=0 when nothing is)
+        virtual char* writeBuffer (size_t& len) { len = 0; return nullptr; }
+
+        // hands over the first len bytes written to writeBuffer()
+        virtual void writeCommit (size_t len) { (void)len; }
 };
 
 template<> size_t Print::printNumber(double number, uint8_t digits);
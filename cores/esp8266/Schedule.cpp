@@ -17,17 +17,76 @@
 */
 
 #include <assert.h>
+#include <atomic>
 
 #include "Schedule.h"
 #include "PolledTimeout.h"
 #include "interrupts.h"
 #include "coredecls.h"
 
+#if SCHEDULED_FN_PROFILING
+
+#include <Print.h>
+
+// Callbacks are identified by their function pointer when there is one, or
+// by the address of the caller of schedule_*function*() for lambdas.
+// The last slot gathers all callbacks which do not fit in the table.
+struct scheduled_fn_profile_t
+{
+    const void* mKey;
+    uint32_t mCalls;
+    uint32_t mMaxCycles;
+    uint64_t mCycles;
+};
+
+static scheduled_fn_profile_t sProfiles[SCHEDULED_FN_PROFILING_SLOTS];
+
+IRAM_ATTR // called from ISR
+static uint8_t profile_slot(const void* key)
+{
+    esp8266::InterruptLock lockAllInterruptsInThisScope;
+
+    uint8_t i;
+    for (i = 0; i < SCHEDULED_FN_PROFILING_SLOTS - 1; i++)
+    {
+        if (sProfiles[i].mKey == key)
+            break;
+        if (!sProfiles[i].mKey)
+        {
+            sProfiles[i].mKey = key;
+            break;
+        }
+    }
+    return i;
+}
+
+static void profile_account(uint8_t slot, uint32_t cycles)
+{
+    scheduled_fn_profile_t& profile = sProfiles[slot];
+    profile.mCalls++;
+    profile.mCycles += cycles;
+    if (cycles > profile.mMaxCycles)
+        profile.mMaxCycles = cycles;
+}
+
+#define PROFILE_DECLARE_SLOT  uint8_t mProfile = 0;
+#define PROFILE_START()       const uint32_t profileStart = esp_get_cycle_count()
+#define PROFILE_STOP(slot)    profile_account(slot, esp_get_cycle_count() - profileStart)
+
+#else // !SCHEDULED_FN_PROFILING
+
+#define PROFILE_DECLARE_SLOT
+#define PROFILE_START()       do { } while (0)
+#define PROFILE_STOP(slot)    do { } while (0)
+
+#endif // !SCHEDULED_FN_PROFILING
+
 typedef std::function<void(void)> mSchedFuncT;
 struct scheduled_fn_t
 {
     scheduled_fn_t* mNext = nullptr;
     mSchedFuncT mFunc;
+    PROFILE_DECLARE_SLOT
 };
 
 static scheduled_fn_t* sFirst = nullptr;
@@ -35,18 +94,80 @@ static scheduled_fn_t* sLast = nullptr;
 static scheduled_fn_t* sUnused = nullptr;
 static int sCount = 0;
 
+// ring of function pointers: producers are ISRs or cont, the only consumer
+// is run_scheduled_functions().  Indexes are free running, and the consumer
+// only writes pTail while producers only write pHead.
+static_assert((SCHEDULED_FNPTR_QUEUE_SIZE & (SCHEDULED_FNPTR_QUEUE_SIZE - 1)) == 0,
+    "SCHEDULED_FNPTR_QUEUE_SIZE must be a power of 2");
+
+struct scheduled_fnptr_entry_t
+{
+    scheduled_fnptr_t mFunc;
+    void* mArg;
+};
+
+static scheduled_fnptr_entry_t pQueue[SCHEDULED_FNPTR_QUEUE_SIZE];
+static volatile uint32_t pHead = 0;
+static volatile uint32_t pTail = 0;
+
 typedef std::function<bool(void)> mRecFuncT;
 struct recurrent_fn_t
 {
     recurrent_fn_t* mNext = nullptr;
     mRecFuncT mFunc;
-    esp8266::polledTimeout::periodicFastUs callNow;
+    uint32_t mRepeatUs;
+    uint32_t mDeadlineUs; // micros() value of next call
     std::function<bool(void)> alarm = nullptr;
-    recurrent_fn_t(esp8266::polledTimeout::periodicFastUs interval) : callNow(interval) { }
+    PROFILE_DECLARE_SLOT
+    recurrent_fn_t(uint32_t repeat_us) : mRepeatUs(repeat_us), mDeadlineUs(micros() + repeat_us) { }
 };
 
-static recurrent_fn_t* rFirst = nullptr;
-static recurrent_fn_t* rLast = nullptr;
+// Recurrent functions without alarm are kept sorted by deadline, so only
+// the due ones are visited.  Functions with an alarm must be polled on every
+// run and have their own FIFO list.  New functions, possibly registered
+// from an ISR, are first appended to the pending FIFO list, which is merged
+// into the others by run_scheduled_recurrent_functions().  Only the pending
+// list needs to be protected against interrupts.
+static recurrent_fn_t* rFirst = nullptr;        // sorted by deadline
+static recurrent_fn_t* rAlarmFirst = nullptr;   // FIFO
+static recurrent_fn_t* rAlarmLast = nullptr;
+static recurrent_fn_t* rPendingFirst = nullptr; // FIFO
+static recurrent_fn_t* rPendingLast = nullptr;
+
+static inline bool is_due(const recurrent_fn_t* fn, uint32_t now)
+{
+    // valid as long as deadlines are less than ~35mn away
+    return (int32_t)(now - fn->mDeadlineUs) >= 0;
+}
+
+// insert after items with the same deadline to keep FIFO order
+static void insert_sorted(recurrent_fn_t** first, recurrent_fn_t* item, uint32_t now)
+{
+    const uint32_t itemDelay = item->mDeadlineUs - now;
+    while (*first && (int32_t)((*first)->mDeadlineUs - now) <= (int32_t)itemDelay)
+        first = &(*first)->mNext;
+    item->mNext = *first;
+    *first = item;
+}
+
+static void append_alarm(recurrent_fn_t* item)
+{
+    item->mNext = nullptr;
+    if (rAlarmLast)
+        rAlarmLast->mNext = item;
+    else
+        rAlarmFirst = item;
+    rAlarmLast = item;
+}
+
+// next deadline after a call (same as polledTimeout's periodic retrigger)
+static void retrigger(recurrent_fn_t* fn, uint32_t now)
+{
+    if (!fn->mRepeatUs)
+        fn->mDeadlineUs = now;
+    else
+        fn->mDeadlineUs += ((now - fn->mDeadlineUs) / fn->mRepeatUs + 1) * fn->mRepeatUs;
+}
 
 // Returns a pointer to an unused sched_fn_t,
 // or if none are available allocates a new one,
@@ -92,6 +213,9 @@ bool schedule_function(const std::function<void(void)>& fn)
 
     item->mFunc = fn;
     item->mNext = nullptr;
+#if SCHEDULED_FN_PROFILING
+    item->mProfile = profile_slot(__builtin_return_address(0));
+#endif
 
     if (sFirst)
         sLast->mNext = item;
@@ -102,11 +226,33 @@ bool schedule_function(const std::function<void(void)>& fn)
     return true;
 }
 
+IRAM_ATTR // (not only) called from ISR
+bool schedule_function_ptr(scheduled_fnptr_t fn, void* arg)
+{
+    if (!fn)
+        return false;
+
+    // Producers from cont stack and from ISR are serialized by masking
+    // interrupts for these few instructions only (there is no heap
+    // access anymore, and no atomic read-modify-write on lx106).
+    esp8266::InterruptLock lockAllInterruptsInThisScope;
+
+    uint32_t head = pHead;
+    if (head - pTail >= SCHEDULED_FNPTR_QUEUE_SIZE)
+        return false;
+
+    pQueue[head & (SCHEDULED_FNPTR_QUEUE_SIZE - 1)] = { fn, arg };
+    std::atomic_thread_fence(std::memory_order_release);
+    pHead = head + 1;
+
+    return true;
+}
+
 IRAM_ATTR // (not only) called from ISR
 bool schedule_recurrent_function_us(const std::function<bool(void)>& fn,
     uint32_t repeat_us, const std::function<bool(void)>& alarm)
 {
-    assert(repeat_us < decltype(recurrent_fn_t::callNow)::neverExpires); //~26800000us (26.8s)
+    assert(repeat_us < 26800000); // same limit as with former periodicFastUs
 
     if (!fn)
         return false;
@@ -117,26 +263,64 @@ bool schedule_recurrent_function_us(const std::function<bool(void)>& fn,
 
     item->mFunc = fn;
     item->alarm = alarm;
+#if SCHEDULED_FN_PROFILING
+    item->mProfile = profile_slot(__builtin_return_address(0));
+#endif
 
     esp8266::InterruptLock lockAllInterruptsInThisScope;
 
-    if (rLast)
+    if (rPendingLast)
     {
-        rLast->mNext = item;
+        rPendingLast->mNext = item;
     }
     else
     {
-        rFirst = item;
+        rPendingFirst = item;
     }
-    rLast = item;
+    rPendingLast = item;
 
     return true;
 }
 
+uint32_t get_scheduled_recurrent_delay_us()
+{
+    if (rPendingFirst)
+        // not merged yet
+        return 0;
+    if (!rFirst)
+        return SCHEDULED_NO_RECURRENT_DELAY;
+    const int32_t delay = rFirst->mDeadlineUs - micros();
+    return delay > 0? delay: 0;
+}
+
 void run_scheduled_functions()
 {
     esp8266::polledTimeout::periodicFastMs yieldNow(100); // yield every 100ms
 
+    // function pointers first, no lock needed (single consumer)
+    // prevent scheduling of new functions during this run
+    const uint32_t pStop = pHead;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    while (pTail != pStop)
+    {
+        const scheduled_fnptr_entry_t entry = pQueue[pTail & (SCHEDULED_FNPTR_QUEUE_SIZE - 1)];
+        std::atomic_thread_fence(std::memory_order_acq_rel);
+        // release the slot before calling, the function may schedule itself again
+        pTail = pTail + 1;
+
+        PROFILE_START();
+        entry.mFunc(entry.mArg);
+        PROFILE_STOP(profile_slot((const void*)entry.mFunc));
+
+        if (yieldNow)
+        {
+            // because scheduled functions might last too long for watchdog etc,
+            // this is yield() in cont stack:
+            esp_schedule();
+            cont_yield(g_pcont);
+        }
+    }
+
     // prevent scheduling of new functions during this run
     auto stop = sLast;
     bool done = false;
@@ -144,7 +328,9 @@ void run_scheduled_functions()
     {
         done = sFirst == stop;
 
+        PROFILE_START();
         sFirst->mFunc();
+        PROFILE_STOP(sFirst->mProfile);
 
         {
             // remove function from stack
@@ -181,8 +367,7 @@ void run_scheduled_recurrent_functions()
     // its purpose is that it is never called from an interrupt
     // (always on cont stack).
 
-    auto current = rFirst;
-    if (!current)
+    if (!rFirst && !rAlarmFirst && !rPendingFirst)
         return;
 
     static bool fence = false;
@@ -198,27 +383,56 @@ void run_scheduled_recurrent_functions()
         fence = true;
     }
 
-    recurrent_fn_t* prev = nullptr;
-    // prevent scheduling of new functions during this run
-    auto stop = rLast;
+    uint32_t now = micros();
 
-    bool done;
-    do
+    // merge newly scheduled functions
+    if (rPendingFirst)
     {
-        done = current == stop;
-        const bool wakeup = current->alarm && current->alarm();
-        bool callNow = current->callNow;
-
-        if ((wakeup || callNow) && !current->mFunc())
+        recurrent_fn_t* pending;
         {
-            // remove function from stack
             esp8266::InterruptLock lockAllInterruptsInThisScope;
+            pending = rPendingFirst;
+            rPendingFirst = rPendingLast = nullptr;
+        }
+        while (pending)
+        {
+            recurrent_fn_t* item = pending;
+            pending = pending->mNext;
+            if (item->alarm)
+                append_alarm(item);
+            else
+                insert_sorted(&rFirst, item, now);
+        }
+    }
+
+    // functions with alarm: poll all of them
+    // (functions appended during this run are not polled this time,
+    // because they are only merged at start of run)
+    recurrent_fn_t* prev = nullptr;
+    recurrent_fn_t* current = rAlarmFirst;
+    while (current)
+    {
+        const bool wakeup = current->alarm();
+        const bool callNow = is_due(current, now);
+        if (callNow)
+            retrigger(current, now);
+
+        bool keep = true;
+        if (wakeup || callNow)
+        {
+            PROFILE_START();
+            keep = current->mFunc();
+            PROFILE_STOP(current->mProfile);
+        }
 
+        if (!keep)
+        {
+            // remove function from stack
             auto to_ditch = current;
 
-            // removing rLast
-            if (rLast == current)
-                rLast = prev;
+            // removing rAlarmLast
+            if (rAlarmLast == current)
+                rAlarmLast = prev;
 
             current = current->mNext;
             if (prev)
@@ -227,7 +441,7 @@ void run_scheduled_recurrent_functions()
             }
             else
             {
-                rFirst = current;
+                rAlarmFirst = current;
             }
 
             delete(to_ditch);
@@ -245,7 +459,92 @@ void run_scheduled_recurrent_functions()
             esp_schedule();
             cont_yield(g_pcont);
         }
-    } while (current && !done);
+    }
+
+    // functions sorted by deadline: only visit the due ones,
+    // and keep them aside so they are not run twice in this run
+    recurrent_fn_t* ran = nullptr;
+    recurrent_fn_t* ranLast = nullptr;
+    while (rFirst && is_due(rFirst, now))
+    {
+        current = rFirst;
+        rFirst = rFirst->mNext;
+
+        PROFILE_START();
+        const bool keep = current->mFunc();
+        PROFILE_STOP(current->mProfile);
+
+        if (keep)
+        {
+            retrigger(current, now);
+            current->mNext = nullptr;
+            if (ranLast)
+                ranLast->mNext = current;
+            else
+                ran = current;
+            ranLast = current;
+        }
+        else
+        {
+            delete(current);
+        }
+
+        if (yieldNow)
+        {
+            // because scheduled functions might last too long for watchdog etc,
+            // this is yield() in cont stack:
+            esp_schedule();
+            cont_yield(g_pcont);
+        }
+    }
+
+    // put them back in the sorted list
+    while (ran)
+    {
+        current = ran;
+        ran = ran->mNext;
+        insert_sorted(&rFirst, current, now);
+    }
 
     fence = false;
 }
+
+#if SCHEDULED_FN_PROFILING
+
+void scheduled_functions_profile_dump(Print& out)
+{
+    out.printf_P(PSTR("scheduled functions profile (cycles):\n"
+                      "  callback   calls      average    max        total\n"));
+    for (uint8_t i = 0; i < SCHEDULED_FN_PROFILING_SLOTS; i++)
+    {
+        // copy, callbacks may run from ISR meanwhile
+        scheduled_fn_profile_t profile;
+        {
+            esp8266::InterruptLock lockAllInterruptsInThisScope;
+            profile = sProfiles[i];
+        }
+        if (!profile.mCalls)
+            continue;
+        if (i == SCHEDULED_FN_PROFILING_SLOTS - 1)
+            out.printf_P(PSTR("  (others)  "));
+        else
+            out.printf_P(PSTR("  %p "), profile.mKey);
+        out.printf_P(PSTR("%-10u %-10u %-10u "),
+                     profile.mCalls, (uint32_t)(profile.mCycles / profile.mCalls), profile.mMaxCycles);
+        out.println(profile.mCycles);
+    }
+}
+
+void scheduled_functions_profile_reset()
+{
+    esp8266::InterruptLock lockAllInterruptsInThisScope;
+    for (auto& profile : sProfiles)
+    {
+        // keep keys, they are referenced by scheduled functions
+        profile.mCalls = 0;
+        profile.mMaxCycles = 0;
+        profile.mCycles = 0;
+    }
+}
+
+#endif // SCHEDULED_FN_PROFILING
@@ -24,6 +24,10 @@
 
 #define SCHEDULED_FN_MAX_COUNT 32
 
+#ifndef SCHEDULED_FNPTR_QUEUE_SIZE
+#define SCHEDULED_FNPTR_QUEUE_SIZE 32 // must be a power of 2
+#endif
+
 // The purpose of scheduled functions is to trigger, from SYS stack (like in
 // an interrupt or a system event), registration of user code to be executed
 // in user stack (called CONT stack) without the common restrictions from
@@ -57,6 +61,40 @@
 
 bool schedule_function (const std::function<void(void)>& fn);
 
+// scheduled function pointers called once:
+//
+// * Same as above, but with a plain function pointer and its argument
+//   instead of a lambda.
+// * No heap allocation and no std::function copy is involved: entries are
+//   stored in a preallocated ring of SCHEDULED_FNPTR_QUEUE_SIZE entries,
+//   so this is the preferred way to schedule from an interrupt handler.
+// * The consumer side (`run_scheduled_functions()`) never disables
+//   interrupts.
+// * Internal queue is FIFO, separate from the lambda queue.  Function
+//   pointers are run before scheduled lambdas.
+// * Returns false when the ring is full.
+
+typedef void (*scheduled_fnptr_t)(void* arg);
+
+bool schedule_function_ptr (scheduled_fnptr_t fn, void* arg = nullptr);
+
+// fast lane functions:
+//
+// * The function pointer and its argument are posted to a dedicated SDK
+//   task, above the one running `loop()`.  It runs as soon as the sketch
+//   yields (`yield()`, `delay()`, end of `loop()`), before `loop()` is
+//   resumed and before the functions scheduled above.
+// * Nothing preempts the sketch: latency is the longest stretch between two
+//   yields, not the length of `loop()`.
+// * The function runs in SYS context, like an os_timer callback: keep it
+//   short, it must not call `yield()` or `delay()`.
+// * Can be called from an interrupt handler, no heap allocation.
+// * The queue holds FAST_QUEUE_SIZE (8) entries, returns false when full.
+// * The task uses USER_TASK_PRIO_2, sketches must not use that priority
+//   with system_os_task().
+
+bool schedule_fast_function (scheduled_fnptr_t fn, void* arg = nullptr);
+
 // Run all scheduled functions.
 // Use this function if your are not using `loop`,
 // or `loop` does not return on a regular basis.
@@ -65,7 +103,8 @@ void run_scheduled_functions();
 
 // recurrent scheduled function:
 //
-// * Internal queue is a FIFO.
+// * Internal queue is sorted by deadline, so only due functions are
+//   visited.  Functions with the same deadline are called in FIFO order.
 // * Run the lambda periodically about every <repeat_us> microseconds until
 //   it returns false.
 // * Note that it may be more than <repeat_us> microseconds between calls if
@@ -88,4 +127,45 @@ bool schedule_recurrent_function_us(const std::function<bool(void)>& fn,
 
 void run_scheduled_recurrent_functions();
 
+// Return the number of microseconds until the next recurrent scheduled
+// function is due (0 when one is already due), or SCHEDULED_NO_RECURRENT_DELAY
+// when there is none.  Functions with an alarm are not taken into account.
+// `delay()` uses it to wake up in time for recurrent functions.
+
+#define SCHEDULED_NO_RECURRENT_DELAY (~(uint32_t)0)
+
+uint32_t get_scheduled_recurrent_delay_us();
+
+// Optional profiling of scheduled functions, enabled with
+// -DSCHEDULED_FN_PROFILING=1 (for example in build_opt.h).
+//
+// * Per callback: call count, average, maximum and total CPU cycles.
+// * Callbacks are identified by their function pointer for
+//   `schedule_function_ptr()`, or by the address of the code calling
+//   `schedule_function()` or `schedule_recurrent_function_us()`
+//   (decode it like an exception stack trace).
+// * At most SCHEDULED_FN_PROFILING_SLOTS callbacks are accounted
+//   separately, the others are gathered in the last line.
+// * Time spent in yield() from inside a scheduled function is counted.
+
+#ifndef SCHEDULED_FN_PROFILING
+#define SCHEDULED_FN_PROFILING 0
+#endif
+
+#if SCHEDULED_FN_PROFILING
+
+#ifndef SCHEDULED_FN_PROFILING_SLOTS
+#define SCHEDULED_FN_PROFILING_SLOTS 16
+#endif
+
+class Print;
+
+// print profiling table
+void scheduled_functions_profile_dump(Print& out);
+
+// reset all counters
+void scheduled_functions_profile_reset();
+
+#endif // SCHEDULED_FN_PROFILING
+
 #endif // ESP_SCHEDULE_H
@@ -0,0 +1,283 @@
+/*
+ StreamRope.cpp - a Stream kept in fixed size segments
+
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "StreamRope.h"
+
+StreamRope::Segment* StreamRope::_pool = nullptr;
+size_t StreamRope::_poolCount = 0;
+size_t StreamRope::_poolMax = 4;
+
+StreamRope::Segment* StreamRope::_take()
+{
+    if (_pool)
+    {
+        Segment* segment = _pool;
+        _pool = segment->next;
+        _poolCount--;
+        segment->next = nullptr;
+        return segment;
+    }
+    Segment* segment = static_cast<Segment*>(malloc(sizeof(Segment)));
+    if (segment)
+    {
+        segment->next = nullptr;
+    }
+    return segment;
+}
+
+void StreamRope::_give(Segment* segment)
+{
+    if (_poolCount < _poolMax)
+    {
+        segment->next = _pool;
+        _pool = segment;
+        _poolCount++;
+    }
+    else
+    {
+        free(segment);
+    }
+}
+
+void StreamRope::setPoolSize(size_t segments)
+{
+    _poolMax = segments;
+    while (_poolCount > _poolMax)
+    {
+        Segment* segment = _pool;
+        _pool = segment->next;
+        _poolCount--;
+        free(segment);
+    }
+}
+
+bool StreamRope::reservePool(size_t segments)
+{
+    if (_poolMax < segments)
+    {
+        _poolMax = segments;
+    }
+    while (_poolCount < segments)
+    {
+        Segment* segment = static_cast<Segment*>(malloc(sizeof(Segment)));
+        if (!segment)
+        {
+            return false;
+        }
+        _give(segment);
+    }
+    return true;
+}
+
+StreamRope::StreamRope(StreamRope&& other):
+    _head(other._head), _tail(other._tail), _size(other._size),
+    _headRead(other._headRead), _tailUsed(other._tailUsed)
+{
+    other._head = other._tail = nullptr;
+    other._size = 0;
+    other._headRead = other._tailUsed = 0;
+}
+
+StreamRope& StreamRope::operator= (StreamRope&& other)
+{
+    if (this != &other)
+    {
+        clear();
+        _head = other._head;
+        _tail = other._tail;
+        _size = other._size;
+        _headRead = other._headRead;
+        _tailUsed = other._tailUsed;
+        other._head = other._tail = nullptr;
+        other._size = 0;
+        other._headRead = other._tailUsed = 0;
+    }
+    return *this;
+}
+
+void StreamRope::clear()
+{
+    while (_head)
+    {
+        Segment* next = _head->next;
+        _give(_head);
+        _head = next;
+    }
+    _tail = nullptr;
+    _size = 0;
+    _headRead = _tailUsed = 0;
+}
+
+String StreamRope::toString() const
+{
+    String out;
+    if (!out.reserve(_size))
+    {
+        return out;
+    }
+    size_t offset = _headRead;
+    for (const Segment* segment = _head; segment; segment = segment->next)
+    {
+        const size_t end = segment == _tail ? _tailUsed : segmentSize;
+        out.concat(segment->data + offset, end - offset);
+        offset = 0;
+    }
+    return out;
+}
+
+char* StreamRope::_room(size_t& len)
+{
+    if (!_tail || _tailUsed == segmentSize)
+    {
+        Segment* segment = _take();
+        if (!segment)
+        {
+            len = 0;
+            return nullptr;
+        }
+        if (_tail)
+        {
+            _tail->next = segment;
+        }
+        else
+        {
+            _head = segment;
+            _headRead = 0;
+        }
+        _tail = segment;
+        _tailUsed = 0;
+    }
+    len = std::min(len, segmentSize - _tailUsed);
+    return _tail->data + _tailUsed;
+}
+
+char* StreamRope::writeBuffer(size_t& len)
+{
+    if (!len)
+    {
+        return nullptr;
+    }
+    return _room(len);
+}
+
+void StreamRope::writeCommit(size_t len)
+{
+    _tailUsed += len;
+    _size += len;
+}
+
+size_t StreamRope::write(uint8_t data)
+{
+    size_t len = 1;
+    char* dst = _room(len);
+    if (!dst)
+    {
+        return 0;
+    }
+    *dst = data;
+    writeCommit(1);
+    return 1;
+}
+
+size_t StreamRope::write(const uint8_t* buffer, size_t len)
+{
+    size_t written = 0;
+    while (written < len)
+    {
+        size_t w = len - written;
+        char* dst = _room(w);
+        if (!dst)
+        {
+            break;
+        }
+        memcpy(dst, buffer + written, w);
+        writeCommit(w);
+        written += w;
+    }
+    return written;
+}
+
+size_t StreamRope::peekAvailable()
+{
+    if (!_head)
+    {
+        return 0;
+    }
+    return (_head == _tail ? _tailUsed : segmentSize) - _headRead;
+}
+
+const char* StreamRope::peekBuffer()
+{
+    return _head ? _head->data + _headRead : nullptr;
+}
+
+void StreamRope::peekConsume(size_t consume)
+{
+    consume = std::min(consume, _size);
+    _size -= consume;
+    while (consume)
+    {
+        const size_t chunk = std::min(consume, peekAvailable());
+        _headRead += chunk;
+        consume -= chunk;
+        if (_head != _tail && _headRead == segmentSize)
+        {
+            Segment* next = _head->next;
+            _give(_head);
+            _head = next;
+            _headRead = 0;
+        }
+    }
+    if (!_size)
+    {
+        // keeps the last segment for the next writes
+        _headRead = _tailUsed = 0;
+    }
+}
+
+int StreamRope::peek()
+{
+    return _size ? (uint8_t)_head->data[_headRead] : -1;
+}
+
+int StreamRope::read()
+{
+    const int c = peek();
+    if (c >= 0)
+    {
+        peekConsume(1);
+    }
+    return c;
+}
+
+int StreamRope::read(uint8_t* buffer, size_t len)
+{
+    size_t done = 0;
+    while (done < len && _size)
+    {
+        const size_t chunk = std::min(len - done, peekAvailable());
+        memcpy(buffer + done, peekBuffer(), chunk);
+        peekConsume(chunk);
+        done += chunk;
+    }
+    return done;
+}
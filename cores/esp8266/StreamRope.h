@@ -0,0 +1,156 @@
+/*
+ StreamRope.h - a Stream kept in fixed size segments
+
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __STREAMROPE_H
+#define __STREAMROPE_H
+
+#include <algorithm>
+#include <limits>
+#include "Stream.h"
+#include "WString.h"
+
+// Like StreamString, data written is read back in order, but it is kept in
+// a list of segments of StreamRope::segmentSize bytes instead of one
+// String.  Appending never moves what is already written and never needs
+// more than one segment of contiguous heap, so a large response can be
+// assembled on a fragmented heap, then sent with rope.sendAll(client) a
+// segment at a time through the peekBuffer API.
+//
+// Segments read to the end are kept in a pool shared by all ropes, up to
+// setPoolSize() of them, and taken from there before the heap.
+class StreamRope: public Stream
+{
+public:
+
+    static constexpr size_t segmentSize = 256;
+
+    StreamRope() = default;
+    StreamRope(const StreamRope&) = delete;
+    StreamRope& operator= (const StreamRope&) = delete;
+    StreamRope(StreamRope&& other);
+    StreamRope& operator= (StreamRope&& other);
+    virtual ~StreamRope()
+    {
+        clear();
+    }
+
+    // bytes not read yet
+    size_t length() const
+    {
+        return _size;
+    }
+
+    // releases all the segments
+    void clear();
+
+    // copy of what is not read yet, for small ropes
+    String toString() const;
+
+    // segments kept for reuse after they are read, 4 by default
+    static void setPoolSize(size_t segments);
+    // fill the pool now, false when the heap ran out first
+    static bool reservePool(size_t segments);
+
+    //// Stream
+
+    virtual int available() override
+    {
+        return std::min(_size, (size_t)std::numeric_limits<int>::max());
+    }
+
+    virtual int availableForWrite() override
+    {
+        return std::numeric_limits<int16_t>::max();
+    }
+
+    virtual int read() override;
+    virtual int read(uint8_t* buffer, size_t len) override;
+    virtual int peek() override;
+    virtual size_t write(uint8_t data) override;
+    virtual size_t write(const uint8_t* buffer, size_t len) override;
+    using Print::write;
+
+    virtual void flush() override
+    {
+        // nothing to do
+    }
+
+    virtual bool inputCanTimeout() override
+    {
+        return false;
+    }
+
+    virtual bool outputCanTimeout() override
+    {
+        return false;
+    }
+
+    virtual ssize_t streamRemaining() override
+    {
+        return _size;
+    }
+
+    //// Stream's peekBuffer API, one segment at a time
+
+    virtual bool hasPeekBufferAPI() const override
+    {
+        return true;
+    }
+
+    virtual size_t peekAvailable() override;
+    virtual const char* peekBuffer() override;
+    virtual void peekConsume(size_t consume) override;
+
+    //// Print's writeBuffer API, the room left in the last segment
+
+    virtual bool hasWriteBufferAPI() const override
+    {
+        return true;
+    }
+
+    virtual char* writeBuffer(size_t& len) override;
+    virtual void writeCommit(size_t len) override;
+
+protected:
+
+    struct Segment
+    {
+        Segment* next;
+        char data[segmentSize];
+    };
+
+    static Segment* _take();
+    static void _give(Segment* segment);
+
+    // room at the end of the last segment, a new one when it is full
+    char* _room(size_t& len);
+
+    Segment* _head = nullptr;
+    Segment* _tail = nullptr;
+    size_t _size = 0;
+    uint16_t _headRead = 0;  // bytes of _head already read
+    uint16_t _tailUsed = 0;  // bytes of _tail written
+
+    static Segment* _pool;
+    static size_t _poolCount;
+    static size_t _poolMax;
+};
+
+#endif // __STREAMROPE_H
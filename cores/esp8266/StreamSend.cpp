@@ -65,6 +65,8 @@ size_t Stream::SendGenericPeekBuffer(Print* to, const ssize_t len, const int rea
     // len==-1 => maxLen=0 <=> until starvation
     const size_t maxLen = std::max((ssize_t)0, len);
     size_t written = 0;
+    // both sides buffered: one memcpy per chunk, no availableForWrite()
+    const bool directWrite = to->hasWriteBufferAPI();
 
     while (!maxLen || written < maxLen)
     {
@@ -75,6 +77,37 @@ size_t Stream::SendGenericPeekBuffer(Print* to, const ssize_t len, const int rea
             break;
         }
 
+        if (directWrite && avpk)
+        {
+            size_t w = maxLen ? std::min(avpk, maxLen - written) : avpk;
+            char* dst = to->writeBuffer(w);
+            if (w == 0 && !to->outputCanTimeout())
+            {
+                // no more data can be written, ever
+                break;
+            }
+            if (w)
+            {
+                const char* directbuf = peekBuffer();
+                const char* last = readUntilChar >= 0 ? (const char*)memchr(directbuf, readUntilChar, w) : nullptr;
+                if (last)
+                {
+                    w = last - directbuf;
+                }
+                memcpy(dst, directbuf, w);
+                to->writeCommit(w);
+                peekConsume(w + (last ? 1 : 0));
+                written += w;
+                timedOut.reset(); // something has been written
+                if (last)
+                {
+                    break;
+                }
+                optimistic_yield(1000);
+                continue;
+            }
+        }
+
         size_t w = to->availableForWrite();
         if (w == 0 && !to->outputCanTimeout())
         {
@@ -280,6 +280,29 @@ public:
         resetpp();
         return *this;
     }
+
+    //// Print's writeBufferAPI
+
+    virtual bool hasWriteBufferAPI() const override
+    {
+        return true;
+    }
+
+    virtual char* writeBuffer(size_t& len) override
+    {
+        if (!len || !reserve(length() + len))
+        {
+            len = 0;
+            return nullptr;
+        }
+        return wbuffer() + length();
+    }
+
+    virtual void writeCommit(size_t len) override
+    {
+        setLen(length() + len);
+        wbuffer()[length()] = 0;
+    }
 };
 
 #endif // __STREAMSTRING_H
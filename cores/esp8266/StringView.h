@@ -0,0 +1,168 @@
+/*
+ StringView.h - non-owning, read-only view over characters
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __STRINGVIEW_H
+#define __STRINGVIEW_H
+
+#ifdef __cplusplus
+
+#include <pgmspace.h>
+#include <cctype>
+#include <climits>
+#include <cstring>
+
+#include "WString.h"
+
+// A pointer and a length, in RAM or in flash (the F() and PSTR() kind).
+// Nothing is copied: the viewed characters must outlive the view, and a
+// view is not NUL terminated (no c_str()).  Meant for read-only arguments
+// and for looking into a String without making substrings.
+class StringView {
+    public:
+        static constexpr size_t npos = (size_t)-1;
+
+        constexpr StringView() : _ptr(nullptr), _len(0), _progmem(false) { }
+        constexpr StringView(const char *ptr, size_t len, bool progmem = false) : _ptr(ptr), _len(len), _progmem(progmem) { }
+        StringView(const char *cstr) : _ptr(cstr), _len(cstr ? strlen(cstr) : 0), _progmem(false) { }
+        StringView(const String &str) : _ptr(str.c_str()), _len(str.length()), _progmem(false) { }
+        StringView(const __FlashStringHelper *str) :
+            _ptr(reinterpret_cast<const char *>(str)), _len(str ? strlen_P(reinterpret_cast<const char *>(str)) : 0), _progmem(true) { }
+
+        size_t length() const { return _len; }
+        bool isEmpty() const { return _len == 0; }
+        bool isProgmem() const { return _progmem; }
+        // characters in RAM or in flash, see isProgmem()
+        const char *data() const { return _ptr; }
+
+        char operator [](size_t index) const {
+            return index < _len ? at(index) : 0;
+        }
+
+        // same bounds as String::substring()
+        StringView substring(size_t from, size_t to = npos) const {
+            if (to > _len)
+                to = _len;
+            if (from > to)
+                from = to;
+            return StringView(_ptr + from, to - from, _progmem);
+        }
+
+        int indexOf(char ch, size_t from = 0) const {
+            for (size_t i = from; i < _len; ++i) {
+                if (at(i) == ch)
+                    return i;
+            }
+            return -1;
+        }
+
+        int indexOf(StringView str, size_t from = 0) const {
+            if (str._len > _len)
+                return -1;
+            for (size_t i = from; i + str._len <= _len; ++i) {
+                if (substring(i, i + str._len).equals(str))
+                    return i;
+            }
+            return -1;
+        }
+
+        bool equals(StringView other) const {
+            if (_len != other._len)
+                return false;
+            if (!_progmem && !other._progmem)
+                return memcmp(_ptr, other._ptr, _len) == 0;
+            for (size_t i = 0; i < _len; ++i) {
+                if (at(i) != other.at(i))
+                    return false;
+            }
+            return true;
+        }
+
+        bool equalsIgnoreCase(StringView other) const {
+            if (_len != other._len)
+                return false;
+            for (size_t i = 0; i < _len; ++i) {
+                if (tolower((unsigned char)at(i)) != tolower((unsigned char)other.at(i)))
+                    return false;
+            }
+            return true;
+        }
+
+        bool startsWith(StringView prefix) const {
+            return prefix._len <= _len && substring(0, prefix._len).equals(prefix);
+        }
+
+        bool endsWith(StringView suffix) const {
+            return suffix._len <= _len && substring(_len - suffix._len).equals(suffix);
+        }
+
+        // like String::toInt(): optional blanks and sign, then decimal
+        // digits up to the first other character, 0 when there are none
+        long toInt() const {
+            size_t i = 0;
+            while (i < _len && isspace((unsigned char)at(i)))
+                ++i;
+            bool negative = false;
+            if (i < _len && (at(i) == '-' || at(i) == '+'))
+                negative = at(i++) == '-';
+            unsigned long value = 0;
+            for (; i < _len && isdigit((unsigned char)at(i)); ++i) {
+                unsigned long next = value * 10 + (at(i) - '0');
+                if (next / 10 != value)
+                    return negative ? LONG_MIN : LONG_MAX;
+                value = next;
+            }
+            if (value > (unsigned long)LONG_MAX)
+                return negative ? LONG_MIN : LONG_MAX;
+            return negative ? -(long)value : (long)value;
+        }
+
+        // the only allocating operation
+        String toString() const {
+            String str;
+            if (!str.reserve(_len))
+                return str;
+            if (!_progmem) {
+                str.concat(_ptr, _len);
+                return str;
+            }
+            char chunk[32];
+            for (size_t done = 0; done < _len;) {
+                size_t n = _len - done < sizeof(chunk) ? _len - done : sizeof(chunk);
+                memcpy_P(chunk, _ptr + done, n);
+                str.concat(chunk, n);
+                done += n;
+            }
+            return str;
+        }
+
+        friend bool operator ==(StringView lhs, StringView rhs) { return lhs.equals(rhs); }
+        friend bool operator !=(StringView lhs, StringView rhs) { return !lhs.equals(rhs); }
+
+    protected:
+        char at(size_t index) const {
+            return _progmem ? (char)pgm_read_byte(_ptr + index) : _ptr[index];
+        }
+
+        const char *_ptr;
+        size_t _len;
+        bool _progmem;
+};
+
+#endif // __cplusplus
+#endif // __STRINGVIEW_H
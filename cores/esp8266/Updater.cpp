@@ -27,6 +27,9 @@ extern "C" {
 extern "C" uint32_t _FS_start;
 extern "C" uint32_t _FS_end;
 
+// How much of the second buffer goes to flash per step, see setDoubleBuffer()
+static constexpr size_t UPDATER_FLUSH_STEP = 1024;
+
 UpdaterClass::UpdaterClass()
 {
 #if ARDUINO_SIGNING
@@ -52,8 +55,20 @@ void UpdaterClass::_reset() {
     delete[] _buffer;
   _buffer = 0;
   _bufferLen = 0;
+  delete[] _flushBuffer;
+  _flushBuffer = nullptr;
+  _flushLen = 0;
+  _flushDone = 0;
+  _flushAddress = 0;
+  _deltaSize = 0;
+  _deltaCount = 0;
+  delete _inflater;
+  _inflater = nullptr;
+  _inflateSize = 0;
+  _inflateCount = 0;
   _startAddress = 0;
   _currentAddress = 0;
+  _eraseAddress = 0;
   _size = 0;
   _command = U_FLASH;
 
@@ -165,6 +180,7 @@ bool UpdaterClass::begin(size_t size, int command, int ledPin, uint8_t ledOn) {
   //initialize
   _startAddress = updateStartAddress;
   _currentAddress = _startAddress;
+  _eraseAddress = _startAddress;
   _size = size;
   if (ESP.getFreeHeap() > 2 * FLASH_SECTOR_SIZE) {
     _bufferSize = FLASH_SECTOR_SIZE;
@@ -172,6 +188,9 @@ bool UpdaterClass::begin(size_t size, int command, int ledPin, uint8_t ledOn) {
     _bufferSize = 256;
   }
   _buffer = new uint8_t[_bufferSize];
+  if (_doubleBuffer && _bufferSize == FLASH_SECTOR_SIZE && ESP.getFreeHeap() > 2 * FLASH_SECTOR_SIZE) {
+    _flushBuffer = new (std::nothrow) uint8_t[_bufferSize];
+  }
   _command = command;
 
 #ifdef DEBUG_UPDATER
@@ -182,6 +201,9 @@ bool UpdaterClass::begin(size_t size, int command, int ledPin, uint8_t ledOn) {
 
   if (!_verify) {
     _md5.begin();
+  } else {
+    _hash->begin();
+    _hashLen = 0;
   }
   return true;
 }
@@ -221,7 +243,20 @@ bool UpdaterClass::end(bool evenIfRemaining){
     if(_bufferLen > 0) {
       _writeBuffer();
     }
-    _size = progress();
+    if(_deltaSize) {
+      // The patch says how big the image is, all of it must be there
+      if(!_outFinished()) {
+        _setDeltaError(PSTR("patch incomplete"));
+        return false;
+      }
+    } else {
+      _size = _outProgress();
+    }
+  }
+
+  // Whatever is left in the second buffer must be in flash before checking
+  if (!_flushPending(_flushLen)) {
+    return false;
   }
 
   uint32_t sigLen = 0;
@@ -237,16 +272,19 @@ bool UpdaterClass::end(bool evenIfRemaining){
     }
 
     int binSize = _size - sigLen - sizeof(uint32_t) /* The siglen word */;
-    _hash->begin();
 #ifdef DEBUG_UPDATER
     DEBUG_UPDATER.printf_P(PSTR("[Updater] Adjusted binsize: %d\n"), binSize);
 #endif
-      // Calculate the MD5 and hash using proper size
-    uint8_t buff[128] __attribute__((aligned(4)));
-    for(int i = 0; i < binSize; i += sizeof(buff)) {
-      ESP.flashRead(_startAddress + i, (uint32_t *)buff, sizeof(buff));
-      size_t read = std::min((int)sizeof(buff), binSize - i);
-      _hash->add(buff, read);
+    if (_hashLen != (size_t)binSize) {
+      // The image ended somewhere else than begin() was told, so what was
+      // hashed while writing doesn't cover the right range. Hash it again.
+      _hash->begin();
+      uint8_t buff[128] __attribute__((aligned(4)));
+      for(int i = 0; i < binSize; i += sizeof(buff)) {
+        ESP.flashRead(_startAddress + i, (uint32_t *)buff, sizeof(buff));
+        size_t read = std::min((int)sizeof(buff), binSize - i);
+        _hash->add(buff, read);
+      }
     }
     _hash->end();
 #ifdef DEBUG_UPDATER
@@ -329,13 +367,56 @@ bool UpdaterClass::end(bool evenIfRemaining){
 }
 
 bool UpdaterClass::_writeBuffer(){
+  if (!_flushBuffer) {
+    if (!_writeFlash(_currentAddress, _buffer, _bufferLen)) {
+      return false;
+    }
+    _currentAddress += _bufferLen;
+    _bufferLen = 0;
+    return true;
+  }
+
+  // Hand the full buffer over to be written in steps and keep filling
+  // the other one. Only wait if the previous one isn't done yet.
+  if (!_flushPending(_flushLen)) {
+    return false;
+  }
+  std::swap(_buffer, _flushBuffer);
+  _flushAddress = _currentAddress;
+  _flushLen = _bufferLen;
+  _flushDone = 0;
+  _currentAddress += _bufferLen;
+  _bufferLen = 0;
+  if (_outRemaining() == 0) {
+    return _flushPending(_flushLen);
+  }
+  return true;
+}
+
+bool UpdaterClass::_flushPending(size_t maxLen){
+  while (_flushDone < _flushLen && maxLen) {
+    size_t len = std::min(_flushLen - _flushDone, maxLen);
+    if (!_writeFlash(_flushAddress + _flushDone, _flushBuffer + _flushDone, len)) {
+      return false;
+    }
+    _flushDone += len;
+    maxLen -= len;
+  }
+  if (_flushDone == _flushLen) {
+    _flushLen = 0;
+    _flushDone = 0;
+  }
+  return true;
+}
+
+bool UpdaterClass::_writeFlash(uint32_t address, uint8_t *data, size_t len){
   #define FLASH_MODE_PAGE  0
   #define FLASH_MODE_OFFSET  2
 
   bool eraseResult = true, writeResult = true;
-  if (_currentAddress % FLASH_SECTOR_SIZE == 0) {
+  while (eraseResult && _eraseAddress < address + len) {
     if(!_async) yield();
-    eraseResult = ESP.flashEraseSector(_currentAddress/FLASH_SECTOR_SIZE);
+    eraseResult = _eraseSector();
   }
 
   // If the flash settings don't match what we already have, modify them.
@@ -345,25 +426,25 @@ bool UpdaterClass::_writeBuffer(){
   FlashMode_t flashMode = FM_QIO;
   FlashMode_t bufferFlashMode = FM_QIO;
   //TODO - GZIP can't do this
-  if ((_currentAddress == _startAddress + FLASH_MODE_PAGE) && (_buffer[0] != 0x1f) && (_command == U_FLASH)) {
+  if ((address == _startAddress + FLASH_MODE_PAGE) && (data[0] != 0x1f) && (_command == U_FLASH)) {
     flashMode = ESP.getFlashChipMode();
     #ifdef DEBUG_UPDATER
-      DEBUG_UPDATER.printf_P(PSTR("Header: 0x%1X %1X %1X %1X\n"), _buffer[0], _buffer[1], _buffer[2], _buffer[3]);
+      DEBUG_UPDATER.printf_P(PSTR("Header: 0x%1X %1X %1X %1X\n"), data[0], data[1], data[2], data[3]);
     #endif
-    bufferFlashMode = ESP.magicFlashChipMode(_buffer[FLASH_MODE_OFFSET]);
+    bufferFlashMode = ESP.magicFlashChipMode(data[FLASH_MODE_OFFSET]);
     if (bufferFlashMode != flashMode) {
       #ifdef DEBUG_UPDATER
         DEBUG_UPDATER.printf_P(PSTR("Set flash mode from 0x%1X to 0x%1X\n"), bufferFlashMode, flashMode);
       #endif
 
-      _buffer[FLASH_MODE_OFFSET] = flashMode;
+      data[FLASH_MODE_OFFSET] = flashMode;
       modifyFlashMode = true;
     }
   }
   
   if (eraseResult) {
     if(!_async) yield();
-    writeResult = ESP.flashWrite(_currentAddress, _buffer, _bufferLen);
+    writeResult = ESP.flashWrite(address, data, len);
   } else { // if erase was unsuccessful
     _currentAddress = (_startAddress + _size);
     _setError(UPDATE_ERROR_ERASE);
@@ -373,7 +454,7 @@ bool UpdaterClass::_writeBuffer(){
   // Restore the old flash mode, if we modified it.
   // Ensures that the MD5 hash will still match what was sent.
   if (modifyFlashMode) {
-    _buffer[FLASH_MODE_OFFSET] = bufferFlashMode;
+    data[FLASH_MODE_OFFSET] = bufferFlashMode;
   }
 
   if (!writeResult) {
@@ -382,10 +463,49 @@ bool UpdaterClass::_writeBuffer(){
     return false;
   }
   if (!_verify) {
-    _md5.add(_buffer, _bufferLen);
+    _md5.add(data, len);
+  } else {
+    // Hash the image as it is written, up to where the signature starts
+    // if the size given to begin() holds
+    const size_t trailer = _verify->length() + sizeof(uint32_t);
+    const uint32_t binEnd = _size > trailer ? _startAddress + _size - trailer : _startAddress;
+    if (address < binEnd) {
+      size_t hashLen = std::min((size_t)(binEnd - address), len);
+      _hash->add(data, hashLen);
+      _hashLen += hashLen;
+    }
+  }
+  return true;
+}
+
+bool UpdaterClass::_eraseSector() {
+  if (!ESP.flashEraseSector(_eraseAddress/FLASH_SECTOR_SIZE)) {
+    return false;
+  }
+  _eraseAddress += FLASH_SECTOR_SIZE;
+  return true;
+}
+
+bool UpdaterClass::eraseAhead() {
+  if (hasError() || !isRunning()) {
+    return false;
+  }
+  if (_flushLen) {
+    return _flushPending(UPDATER_FLUSH_STEP);
+  }
+  uint32_t limit = (_currentAddress & ~(FLASH_SECTOR_SIZE - 1)) + (1 + _eraseAheadSectors) * FLASH_SECTOR_SIZE;
+  uint32_t end = _startAddress + ((_size + FLASH_SECTOR_SIZE - 1) & ~(FLASH_SECTOR_SIZE - 1));
+  if (limit > end) {
+    limit = end;
+  }
+  if (_eraseAddress >= limit) {
+    return false;
+  }
+  if (!_eraseSector()) {
+    _currentAddress = (_startAddress + _size);
+    _setError(UPDATE_ERROR_ERASE);
+    return false;
   }
-  _currentAddress += _bufferLen;
-  _bufferLen = 0;
   return true;
 }
 
@@ -393,7 +513,26 @@ size_t UpdaterClass::write(uint8_t *data, size_t len) {
   if(hasError() || !isRunning())
     return 0;
 
-  if(progress() + _bufferLen + len > _size) {
+  if(_inflateSize) {
+    return _writeInflate(data, len);
+  }
+
+  if(!_deltaSize && _command == U_FLASH && len && data[0] == UPDATER_DELTA_MAGIC &&
+     _currentAddress == _startAddress && !_bufferLen) {
+    // A delta patch rather than an image, see _writeDelta()
+    _deltaSize = _size;
+    _deltaCount = 0;
+    _deltaState = DELTA_HEADER;
+    _deltaFill = 0;
+  }
+  if(_deltaSize) {
+    return _writeDelta(data, len);
+  }
+  return _writeOutput(data, len);
+}
+
+size_t UpdaterClass::_writeOutput(const uint8_t *data, size_t len) {
+  if(_outProgress() + _bufferLen + len > _size) {
     _setError(UPDATE_ERROR_SPACE);
     return 0;
   }
@@ -413,19 +552,217 @@ size_t UpdaterClass::write(uint8_t *data, size_t len) {
   //lets see what's left
   memcpy(_buffer + _bufferLen, data + (len - left), left);
   _bufferLen += left;
-  if(_bufferLen == remaining()){
+  if(_bufferLen == _outRemaining()){
     //we are at the end of the update, so should write what's left to flash
     if(!_writeBuffer()){
       return len - left;
     }
+  } else if(_flushLen && !_flushPending(UPDATER_FLUSH_STEP)) {
+    return len - left;
+  }
+  return len;
+}
+
+bool UpdaterClass::setInflate(size_t compressedSize, uint8_t windowBits) {
+  if(!isRunning() || _inflateSize || _deltaSize || _outProgress() || _bufferLen || !compressedSize)
+    return false;
+  _inflater = new (std::nothrow) Inflater();
+  if(!_inflater || !_inflater->begin(windowBits, [this](const uint8_t *data, size_t len) {
+        return _writeOutput(data, len) == len;
+      })) {
+    delete _inflater;
+    _inflater = nullptr;
+    return false;
+  }
+  _inflateSize = compressedSize;
+  _inflateCount = 0;
+  return true;
+}
+
+size_t UpdaterClass::_writeInflate(const uint8_t *data, size_t len) {
+  if(_inflateCount + len > _inflateSize) {
+    _setError(UPDATE_ERROR_SPACE);
+    return 0;
+  }
+  // An error while writing out resets the update, which must not delete
+  // the Inflater while it runs
+  Inflater *inflater = _inflater;
+  _inflater = nullptr;
+  const bool ok = inflater->write(data, len) == len &&
+                  (_inflateCount + len < _inflateSize || inflater->finish());
+  if(!_size) {
+    delete inflater;
+    return 0;
+  }
+  _inflater = inflater;
+  if(!ok) {
+#ifdef DEBUG_UPDATER
+    DEBUG_UPDATER.printf_P(PSTR("[inflate] error %u\n"), inflater->error());
+#endif
+    _currentAddress = (_startAddress + _size);
+    _setError(UPDATE_ERROR_INFLATE);
+    return 0;
   }
+  _inflateCount += len;
   return len;
 }
 
+static uint32_t deltaLe32(const uint8_t *p) {
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+size_t UpdaterClass::_writeDelta(const uint8_t *data, size_t len) {
+  if(_deltaCount + len > _deltaSize) {
+    _setError(UPDATE_ERROR_SPACE);
+    return 0;
+  }
+
+  size_t done = 0;
+  while(done < len) {
+    if(_deltaState == DELTA_DATA) {
+      size_t n = std::min(len - done, (size_t)_deltaLen);
+      if(_writeOutput(data + done, n) != n) {
+        return done;
+      }
+      done += n;
+      _deltaCount += n;
+      _deltaLen -= n;
+      if(!_deltaLen) {
+        _deltaState = DELTA_OP;
+      }
+      continue;
+    }
+
+    if(_deltaState == DELTA_OP) {
+      _deltaOp = data[done++];
+      _deltaCount++;
+      _deltaFill = 0;
+      if(_deltaOp == DELTA_OP_COPY || _deltaOp == DELTA_OP_DATA) {
+        _deltaState = DELTA_ARGS;
+        continue;
+      }
+      _setDeltaError(PSTR("unknown op"));
+      return done;
+    }
+
+    // Collect the header or the arguments of an op
+    const size_t need = _deltaState == DELTA_HEADER ? DELTA_HEADER_SIZE : (_deltaOp == DELTA_OP_COPY ? 8 : 4);
+    size_t n = std::min(len - done, need - _deltaFill);
+    memcpy(_deltaArgs + _deltaFill, data + done, n);
+    _deltaFill += n;
+    done += n;
+    _deltaCount += n;
+    if(_deltaFill < need) {
+      continue;
+    }
+
+    if(_deltaState == DELTA_HEADER) {
+      if(!_beginDelta()) {
+        return done;
+      }
+      _deltaState = DELTA_OP;
+    } else if(_deltaOp == DELTA_OP_DATA) {
+      _deltaLen = deltaLe32(_deltaArgs);
+      _deltaState = _deltaLen ? DELTA_DATA : DELTA_OP;
+    } else {
+      uint32_t src = deltaLe32(_deltaArgs);
+      uint32_t left = deltaLe32(_deltaArgs + 4);
+      if(src > _deltaSourceSize || left > _deltaSourceSize - src) {
+        _setDeltaError(PSTR("copy outside of the running sketch"));
+        return done;
+      }
+      // Copy from the running sketch, which is below the update area
+      uint8_t chunk[256] __attribute__((aligned(4)));
+      while(left) {
+        size_t len = std::min((size_t)left, sizeof(chunk));
+        if(!ESP.flashRead(src, chunk, len)) {
+          _currentAddress = (_startAddress + _size);
+          _setError(UPDATE_ERROR_READ);
+          return done;
+        }
+        if(_writeOutput(chunk, len) != len) {
+          return done;
+        }
+        src += len;
+        left -= len;
+      }
+      _deltaState = DELTA_OP;
+    }
+  }
+  return done;
+}
+
+bool UpdaterClass::_beginDelta() {
+  if(_deltaArgs[0] != UPDATER_DELTA_MAGIC || _deltaArgs[1] != 'E' || _deltaArgs[2] != 'S' || _deltaArgs[3] != 'D') {
+    _setDeltaError(PSTR("bad header"));
+    return false;
+  }
+  const uint32_t targetSize = deltaLe32(_deltaArgs + 4);
+  _deltaSourceSize = deltaLe32(_deltaArgs + 8);
+  if(!targetSize || _deltaSourceSize != ESP.getSketchSize()) {
+    _setDeltaError(PSTR("made for a different sketch"));
+    return false;
+  }
+
+  // MD5 of the running sketch, with the flash mode and size bytes zeroed
+  // as they may have been changed when it was flashed
+  MD5Builder md5;
+  md5.begin();
+  uint8_t chunk[256] __attribute__((aligned(4)));
+  for(uint32_t pos = 0; pos < _deltaSourceSize; pos += sizeof(chunk)) {
+    size_t len = std::min((size_t)(_deltaSourceSize - pos), sizeof(chunk));
+    if(!ESP.flashRead(pos, chunk, len)) {
+      _setError(UPDATE_ERROR_READ);
+      return false;
+    }
+    if(pos == 0) {
+      chunk[2] = chunk[3] = 0;
+    }
+    md5.add(chunk, len);
+    if(!_async) yield();
+  }
+  md5.calculate();
+  uint8_t sourceMD5[16];
+  md5.getBytes(sourceMD5);
+  if(memcmp(sourceMD5, _deltaArgs + 12, sizeof(sourceMD5)) != 0) {
+    _setDeltaError(PSTR("made for a different sketch"));
+    return false;
+  }
+
+  // Nothing has been written yet, place the update for the real image size
+  uintptr_t updateEndAddress = (uintptr_t)&_FS_start - 0x40200000;
+  size_t currentSketchSize = (ESP.getSketchSize() + FLASH_SECTOR_SIZE - 1) & (~(FLASH_SECTOR_SIZE - 1));
+  size_t roundedSize = (targetSize + FLASH_SECTOR_SIZE - 1) & (~(FLASH_SECTOR_SIZE - 1));
+  uintptr_t updateStartAddress = (updateEndAddress > roundedSize)? (updateEndAddress - roundedSize) : 0;
+  if(updateStartAddress < currentSketchSize) {
+    _setError(UPDATE_ERROR_SPACE);
+    return false;
+  }
+  _startAddress = updateStartAddress;
+  _currentAddress = _startAddress;
+  _eraseAddress = _startAddress;
+  _size = targetSize;
+
+#ifdef DEBUG_UPDATER
+  DEBUG_UPDATER.printf_P(PSTR("[delta] target size: %u, _startAddress: 0x%08X\n"), targetSize, _startAddress);
+#endif
+  return true;
+}
+
+void UpdaterClass::_setDeltaError(PGM_P reason) {
+#ifdef DEBUG_UPDATER
+  DEBUG_UPDATER.printf_P(PSTR("[delta] %S\n"), reason);
+#else
+  (void)reason;
+#endif
+  _currentAddress = (_startAddress + _size);
+  _setError(UPDATE_ERROR_DELTA);
+}
+
 bool UpdaterClass::_verifyHeader(uint8_t data) {
     if(_command == U_FLASH) {
         // check for valid first magic byte (is always 0xE9)
-        if ((data != 0xE9) && (data != 0x1f)) {
+        if ((data != 0xE9) && (data != 0x1f) && (data != UPDATER_DELTA_MAGIC)) {
             _currentAddress = (_startAddress + _size);
             _setError(UPDATE_ERROR_MAGIC_BYTE);
             return false;
@@ -483,7 +820,7 @@ size_t UpdaterClass::writeStream(Stream &data, uint16_t streamTimeout) {
     if(hasError() || !isRunning())
         return 0;
 
-    if(!_verifyHeader(data.peek())) {
+    if(!_inflateSize && !_verifyHeader(data.peek())) {
 #ifdef DEBUG_UPDATER
         printError(DEBUG_UPDATER);
 #endif
@@ -497,15 +834,53 @@ size_t UpdaterClass::writeStream(Stream &data, uint16_t streamTimeout) {
     if(_ledPin != -1) {
         pinMode(_ledPin, OUTPUT);
     }
+    if(_command == U_FLASH && !_inflateSize && data.peek() == UPDATER_DELTA_MAGIC && !progress() && !_bufferLen) {
+        // Let write() see the start of the patch and switch to decoding it
+        uint8_t magic = data.read();
+        if(write(&magic, 1) != 1)
+            return 0;
+        written = 1;
+    }
 
     while(remaining()) {
         if(_ledPin != -1) {
             digitalWrite(_ledPin, _ledOn); // Switch LED on
         }
+        if(_deltaSize || _inflateSize) {
+            uint8_t chunk[256];
+            toRead = data.readBytes(chunk, std::min(sizeof(chunk), remaining()));
+            if(toRead == 0) { //Timeout
+              if (timeOut) {
+                _currentAddress = (_startAddress + _size);
+                _setError(UPDATE_ERROR_STREAM);
+                _reset();
+                return written;
+              }
+              delay(100);
+              continue;
+            }
+            timeOut.reset();
+            if(write(chunk, toRead) != toRead)
+                return written;
+            written += toRead;
+            if(_progress_callback) {
+                _progress_callback(progress(), size());
+            }
+            continue;
+        }
         size_t bytesToRead = _bufferSize - _bufferLen;
         if(bytesToRead > remaining()) {
             bytesToRead = remaining();
         }
+        // Alternate between reading and writing out the other buffer
+        if(_flushLen && bytesToRead > UPDATER_FLUSH_STEP) {
+            bytesToRead = UPDATER_FLUSH_STEP;
+        }
+        // Use the time until more data arrives to prepare the next sectors
+        if(!data.available() && eraseAhead()) {
+            timeOut.reset();
+            continue;
+        }
         toRead = data.readBytes(_buffer + _bufferLen,  bytesToRead);
         if(toRead == 0) { //Timeout
           if (timeOut) {
@@ -522,8 +897,12 @@ size_t UpdaterClass::writeStream(Stream &data, uint16_t streamTimeout) {
             digitalWrite(_ledPin, !_ledOn); // Switch LED off
         }
         _bufferLen += toRead;
-        if((_bufferLen == remaining() || _bufferLen == _bufferSize) && !_writeBuffer())
+        if(_bufferLen == remaining() || _bufferLen == _bufferSize) {
+            if(!_writeBuffer())
+                return written;
+        } else if(_flushLen && !_flushPending(UPDATER_FLUSH_STEP)) {
             return written;
+        }
         written += toRead;
         if(_progress_callback) {
             _progress_callback(progress(), _size);
@@ -531,7 +910,7 @@ size_t UpdaterClass::writeStream(Stream &data, uint16_t streamTimeout) {
         yield();
     }
     if(_progress_callback) {
-        _progress_callback(progress(), _size);
+        _progress_callback(progress(), size());
     }
     return written;
 }
@@ -574,6 +953,10 @@ void UpdaterClass::printError(Print &out){
     out.println(F("Magic byte is wrong, not 0xE9"));
   } else if (_error == UPDATE_ERROR_BOOTSTRAP){
     out.println(F("Invalid bootstrapping state, reset ESP8266 before updating"));
+  } else if (_error == UPDATE_ERROR_DELTA){
+    out.println(F("Delta patch does not apply to the running sketch"));
+  } else if (_error == UPDATE_ERROR_INFLATE){
+    out.println(F("Compressed image does not decompress"));
   } else {
     out.println(F("UNKNOWN"));
   }
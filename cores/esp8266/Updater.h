@@ -4,6 +4,7 @@
 #include <Arduino.h>
 #include <flash_utils.h>
 #include <MD5Builder.h>
+#include <Inflater.h>
 #include <functional>
 
 #define UPDATE_ERROR_OK                 (0)
@@ -20,11 +21,16 @@
 #define UPDATE_ERROR_BOOTSTRAP          (11)
 #define UPDATE_ERROR_SIGN               (12)
 #define UPDATE_ERROR_NO_DATA            (13)
+#define UPDATE_ERROR_DELTA              (14)
+#define UPDATE_ERROR_INFLATE            (15)
 
 #define U_FLASH   0
 #define U_FS      100
 #define U_AUTH    200
 
+// First byte of a delta patch, see doc/ota_updates/readme.rst
+#define UPDATER_DELTA_MAGIC 0xD7
+
 #ifdef DEBUG_ESP_UPDATER
 #ifdef DEBUG_ESP_PORT
 #define DEBUG_UPDATER DEBUG_ESP_PORT
@@ -70,6 +76,38 @@ class UpdaterClass {
     */
     void runAsync(bool async){ _async = async; }
 
+    /*
+      Number of sectors past the one being filled that are erased ahead of
+      time while waiting for data, so a full buffer can be written without
+      stalling on the erase. 0 erases each sector only when it is written
+    */
+    void setEraseAhead(uint8_t sectors){ _eraseAheadSectors = sectors; }
+
+    /*
+      Use a second sector buffer, allocated by begin() if there is enough
+      heap. A full buffer is then written to flash in small steps while
+      the other one is being filled, instead of blocking write()
+    */
+    void setDoubleBuffer(bool enable){ _doubleBuffer = enable; }
+
+    /*
+      Decompress what is written, a zlib or gzip stream of compressedSize
+      bytes whose back references stay within 2^windowBits bytes (see
+      Inflater.h). Call after begin(), which takes the size of the
+      decompressed image, and before writing anything.
+      Returns false if the window cannot be allocated
+    */
+    bool setInflate(size_t compressedSize, uint8_t windowBits = 15);
+
+    /*
+      Writes the next piece of the second buffer, or else erases the next
+      sector if fewer than setEraseAhead() are ready.
+      Call it while waiting for data when feeding write(uint8_t*, size_t),
+      writeStream() and write(T&) already do.
+      Returns true if it did any work
+    */
+    bool eraseAhead();
+
     /*
       Writes a buffer to the flash and increments the address
       Returns the amount written
@@ -127,10 +165,11 @@ class UpdaterClass {
     void clearError(){ _error = UPDATE_ERROR_OK; }
     bool hasError(){ return _error != UPDATE_ERROR_OK; }
     bool isRunning(){ return _size > 0; }
-    bool isFinished(){ return _currentAddress == (_startAddress + _size); }
-    size_t size(){ return _size; }
-    size_t progress(){ return _currentAddress - _startAddress; }
-    size_t remaining(){ return _size - (_currentAddress - _startAddress); }
+    // For a delta or compressed update these count the input, not the image it produces
+    bool isFinished(){ return _outFinished() && (!_deltaSize || _deltaCount == _deltaSize) && (!_inflateSize || _inflateCount == _inflateSize); }
+    size_t size(){ return _inflateSize ? _inflateSize : _deltaSize ? _deltaSize : _size; }
+    size_t progress(){ return _inflateSize ? _inflateCount : _deltaSize ? _deltaCount : _outProgress(); }
+    size_t remaining(){ return _inflateSize ? _inflateSize - _inflateCount : _deltaSize ? _deltaSize - _deltaCount : _outRemaining(); }
 
     /*
       Template to write from objects that expose
@@ -144,6 +183,22 @@ class UpdaterClass {
       if (hasError() || !isRunning())
         return 0;
 
+      // The start of a sketch update, delta patches and compressed updates
+      // go through write(uint8_t*, size_t), which decodes them
+      if (_inflateSize || _deltaSize || (_command == U_FLASH && _currentAddress == _startAddress && !_bufferLen)) {
+        uint8_t chunk[256];
+        size_t available = data.available();
+        while (available && remaining()) {
+          size_t len = std::min(std::min(available, sizeof(chunk)), remaining());
+          data.read(chunk, len);
+          if (write(chunk, len) != len)
+            return written;
+          written += len;
+          available = data.available();
+        }
+        return written;
+      }
+
       size_t available = data.available();
       while(available) {
         if(_bufferLen + available > remaining()){
@@ -168,7 +223,11 @@ class UpdaterClass {
         }
         if(remaining() == 0)
           return written;
-        delay(1);
+        if(!eraseAhead()) {
+          if(hasError())
+            return written;
+          delay(1);
+        }
         available = data.available();
       }
       return written;
@@ -177,20 +236,58 @@ class UpdaterClass {
   private:
     void _reset();
     bool _writeBuffer();
+    size_t _writeOutput(const uint8_t *data, size_t len);
+    size_t _writeDelta(const uint8_t *data, size_t len);
+    size_t _writeInflate(const uint8_t *data, size_t len);
+    bool _beginDelta();
+    void _setDeltaError(PGM_P reason);
+    bool _writeFlash(uint32_t address, uint8_t *data, size_t len);
+    bool _flushPending(size_t maxLen);
+    bool _eraseSector();
 
     bool _verifyHeader(uint8_t data);
     bool _verifyEnd();
 
     void _setError(int error);    
 
+    // Position in the image being written to flash
+    size_t _outProgress(){ return _currentAddress - _startAddress; }
+    size_t _outRemaining(){ return _size - _outProgress(); }
+    bool _outFinished(){ return _currentAddress == (_startAddress + _size); }
+
     bool _async = false;
     uint8_t _error = 0;
     uint8_t *_buffer = nullptr;
     size_t _bufferLen = 0; // amount of data written into _buffer
     size_t _bufferSize = 0; // total size of _buffer
+    bool _doubleBuffer = false;
+    uint8_t *_flushBuffer = nullptr; // full buffer being written out, see setDoubleBuffer()
+    size_t _flushLen = 0;
+    size_t _flushDone = 0;
+    uint32_t _flushAddress = 0;
+
+    // Delta patch decoding, see _writeDelta()
+    enum : uint8_t { DELTA_HEADER, DELTA_OP, DELTA_ARGS, DELTA_DATA };
+    static constexpr uint8_t DELTA_OP_COPY = 0x01;
+    static constexpr uint8_t DELTA_OP_DATA = 0x02;
+    static constexpr size_t DELTA_HEADER_SIZE = 28;
+    size_t _deltaSize = 0; // patch length given to begin(), 0 if not a delta update
+    size_t _deltaCount = 0; // patch bytes consumed
+    uint32_t _deltaSourceSize = 0;
+    uint32_t _deltaLen = 0; // bytes left in the current DATA op
+    uint8_t _deltaState = DELTA_HEADER;
+    uint8_t _deltaOp = 0;
+    uint8_t _deltaFill = 0; // bytes collected in _deltaArgs
+    uint8_t _deltaArgs[DELTA_HEADER_SIZE];
+    // Compressed update, see setInflate()
+    Inflater *_inflater = nullptr;
+    size_t _inflateSize = 0; // compressed length, 0 if not compressed
+    size_t _inflateCount = 0; // compressed bytes consumed
     size_t _size = 0;
     uint32_t _startAddress = 0;
     uint32_t _currentAddress = 0;
+    uint32_t _eraseAddress = 0; // first sector not erased yet
+    uint8_t _eraseAheadSectors = 2;
     uint32_t _command = U_FLASH;
 
     String _target_md5;
@@ -202,6 +299,7 @@ class UpdaterClass {
     // Optional signed binary verification
     UpdaterHashClass *_hash = nullptr;
     UpdaterVerifyClass *_verify = nullptr;
+    size_t _hashLen = 0; // bytes added to _hash while writing
     // Optional progress callback function
     THandlerFunction_Progress _progress_callback = nullptr;
 };
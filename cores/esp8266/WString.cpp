@@ -211,6 +211,15 @@ bool String::changeBuffer(unsigned int maxStrLen) {
     return false;
 }
 
+void String::reserveSum(unsigned int extra) {
+    // The string is the left side of a `a + b + c...` chain: leave room for
+    // the next steps so the chain reallocates a logarithmic number of times.
+    // Failure is fine, concat() retries with the exact size.
+    unsigned int total = length() + extra;
+    if (capacity() < total)
+        reserve(std::min(total + (total >> 1), (unsigned int)CAPACITY_MAX - 16));
+}
+
 /*********************************************/
 /*  Copy and Move                            */
 /*********************************************/
@@ -305,7 +314,7 @@ bool String::concat(const char *cstr, unsigned int length) {
         return true;
     if (!reserve(newlen))
         return false;
-    memmove_P(wbuffer() + len(), cstr, length + 1);
+    memmove_P(wbuffer() + len(), cstr, length);
     setLen(newlen);
     wbuffer()[newlen] = 0;
     return true;
@@ -321,41 +330,46 @@ bool String::concat(char c) {
     return concat(&c, 1);
 }
 
+// Numbers are formatted in place when the buffer already has room for the
+// widest value, going through a small temporary otherwise so that short
+// strings are not moved out of SSO.
+template <typename F>
+bool String::concatFormat(unsigned int maxlen, F &&format) {
+    const unsigned int oldlen = len();
+    if (buffer() && capacity() >= oldlen + maxlen) {
+        setLen(oldlen + format(wbuffer() + oldlen));
+        return true;
+    }
+    char buf[24];
+    return concat(buf, format(buf));
+}
+
 bool String::concat(unsigned char num) {
-    char buf[1 + 3 * sizeof(unsigned char)];
-    return concat(buf, sprintf(buf, "%d", num));
+    return concatFormat(3 * sizeof(unsigned char), [num](char *dst) { return sprintf(dst, "%d", num); });
 }
 
 bool String::concat(int num) {
-    char buf[2 + 3 * sizeof(int)];
-    return concat(buf, sprintf(buf, "%d", num));
+    return concatFormat(1 + 3 * sizeof(int), [num](char *dst) { return sprintf(dst, "%d", num); });
 }
 
 bool String::concat(unsigned int num) {
-    char buf[1 + 3 * sizeof(unsigned int)];
-    utoa(num, buf, 10);
-    return concat(buf, strlen(buf));
+    return concatFormat(3 * sizeof(unsigned int), [num](char *dst) { return (int)strlen(utoa(num, dst, 10)); });
 }
 
 bool String::concat(long num) {
-    char buf[2 + 3 * sizeof(long)];
-    return concat(buf, sprintf(buf, "%ld", num));
+    return concatFormat(1 + 3 * sizeof(long), [num](char *dst) { return sprintf(dst, "%ld", num); });
 }
 
 bool String::concat(unsigned long num) {
-    char buf[1 + 3 * sizeof(unsigned long)];
-    ultoa(num, buf, 10);
-    return concat(buf, strlen(buf));
+    return concatFormat(3 * sizeof(unsigned long), [num](char *dst) { return (int)strlen(ultoa(num, dst, 10)); });
 }
 
 bool String::concat(long long num) {
-    char buf[2 + 3 * sizeof(long long)];
-    return concat(buf, sprintf(buf, "%lld", num));
+    return concatFormat(1 + 3 * sizeof(long long), [num](char *dst) { return sprintf(dst, "%lld", num); });
 }
 
 bool String::concat(unsigned long long num) {
-    char buf[1 + 3 * sizeof(unsigned long long)];
-    return concat(buf, sprintf(buf, "%llu", num));
+    return concatFormat(3 * sizeof(unsigned long long), [num](char *dst) { return sprintf(dst, "%llu", num); });
 }
 
 bool String::concat(float num) {
@@ -445,10 +459,13 @@ String operator +(const String &lhs, String &&rhs) {
 String operator +(String &&lhs, String &&rhs) {
     String res;
     auto total = lhs.length() + rhs.length();
-    if ((total > lhs.capacity()) && (total < rhs.capacity())) {
+    // lhs usually has headroom from reserveSum(), rhs wins when it was
+    // reserved larger, no need to grow either
+    if ((total < rhs.capacity()) && (rhs.capacity() > lhs.capacity())) {
         rhs.insert(0, lhs);
         res = std::move(rhs);
     } else {
+        lhs.reserveSum(rhs.length());
         lhs += rhs;
         rhs.invalidate();
         res = std::move(lhs);
@@ -135,6 +135,16 @@ class String {
             return *this;
         }
 
+        // used by `a + b + c...` chains to grow the left side geometrically
+        void reserveSum(unsigned int extra);
+        static unsigned int sumLength(const String &s) { return s.length(); }
+        static unsigned int sumLength(const char *cstr) { return cstr ? strlen(cstr) : 0; }
+        static unsigned int sumLength(const __FlashStringHelper *str) { return str ? strlen_P(reinterpret_cast<const char *>(str)) : 0; }
+        static unsigned int sumLength(char) { return 1; }
+        // numbers: length unknown before formatting, they are written in place when there is room
+        template <typename T>
+        static unsigned int sumLength(const T &) { return 0; }
+
         explicit operator bool() const {
             return buffer() != nullptr;
         }
@@ -317,6 +327,9 @@ class String {
 
         // rvalue helper
         void move(String &rhs) noexcept;
+
+        template <typename F>
+        bool concatFormat(unsigned int maxlen, F &&format);
 };
 
 // concatenation (note that it's done using non-method operators to handle both possible type refs)
@@ -330,6 +343,7 @@ inline String operator +(const String &lhs, const String &rhs) {
 }
 
 inline String operator +(String &&lhs, const String &rhs) {
+    lhs.reserveSum(rhs.length());
     lhs += rhs;
     return std::move(lhs);
 }
@@ -340,7 +354,9 @@ String operator +(String &&lhs, String &&rhs);
 template <typename T,
     typename = std::enable_if_t<!std::is_same_v<String, std::decay_t<T>>>>
 inline String operator +(const String &lhs, const T &value) {
-    String res(lhs);
+    String res;
+    res.reserve(lhs.length() + String::sumLength(value));
+    res += lhs;
     res += value;
     return res;
 }
@@ -348,6 +364,7 @@ inline String operator +(const String &lhs, const T &value) {
 template <typename T,
     typename = std::enable_if_t<!std::is_same_v<String, std::decay_t<T>>>>
 inline String operator +(String &&lhs, const T &value) {
+    lhs.reserveSum(String::sumLength(value));
     lhs += value;
     return std::move(lhs);
 }
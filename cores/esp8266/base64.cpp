@@ -23,11 +23,134 @@
  */
 
 #include "Arduino.h"
-extern "C" {
-#include "libb64/cencode.h"
-}
+#include <algorithm>
 #include "base64.h"
 
+/*
+  Same output as libb64 (libb64/cencode.cpp), which this replaces here:
+  with doNewLines a '\n' follows every 72 characters of complete groups.
+
+  Three input bytes become four characters built in one register and
+  stored as one word.  When the input is word aligned, twelve bytes are
+  loaded with three 32-bit loads instead of twelve byte loads.
+*/
+
+#define BASE64_CHARS_PER_LINE 72
+
+static const char base64Chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// Values of '+' .. 'z', -1 for characters outside the alphabet
+static const int8_t base64Values[] = {
+    62, -1, -1, -1, 63, 52, 53, 54, 55, 56, 57, 58, 59, 60, 61, -1,
+    -1, -1, -1, -1, -1, -1,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9,
+    10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25,
+    -1, -1, -1, -1, -1, -1, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35,
+    36, 37, 38, 39, 40, 41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51,
+};
+
+static inline char* encodeGroup(uint32_t v, char* pos, uint8_t* lineGroups)
+{
+    const uint32_t chars = (uint8_t)base64Chars[v >> 18] |
+                           (uint8_t)base64Chars[(v >> 12) & 63] << 8 |
+                           (uint8_t)base64Chars[(v >> 6) & 63] << 16 |
+                           (uint32_t)(uint8_t)base64Chars[v & 63] << 24;
+    // both the host and the lx106 are little endian
+    memcpy(pos, &chars, 4);
+    pos += 4;
+    if (lineGroups && ++*lineGroups == BASE64_CHARS_PER_LINE / 4)
+    {
+        *pos++ = '\n';
+        *lineGroups = 0;
+    }
+    return pos;
+}
+
+// Encode complete groups of three bytes, returns the number of characters
+static size_t encodeGroups(const uint8_t* in, size_t groups, char* out, uint8_t* lineGroups)
+{
+    char* pos = out;
+    if (((uintptr_t)in & 3) == 0)
+    {
+        for (; groups >= 4; groups -= 4, in += 12)
+        {
+            uint32_t w0, w1, w2;
+            memcpy(&w0, __builtin_assume_aligned(in, 4), 4);
+            memcpy(&w1, __builtin_assume_aligned(in + 4, 4), 4);
+            memcpy(&w2, __builtin_assume_aligned(in + 8, 4), 4);
+            pos = encodeGroup((w0 & 0xff) << 16 | (w0 & 0xff00) | ((w0 >> 16) & 0xff), pos, lineGroups);
+            pos = encodeGroup((w0 >> 24) << 16 | (w1 & 0xff) << 8 | ((w1 >> 8) & 0xff), pos, lineGroups);
+            pos = encodeGroup((w1 & 0xff0000) | (w1 >> 24) << 8 | (w2 & 0xff), pos, lineGroups);
+            pos = encodeGroup((w2 & 0xff00) << 8 | ((w2 >> 8) & 0xff00) | (w2 >> 24), pos, lineGroups);
+        }
+    }
+    for (; groups; --groups, in += 3)
+    {
+        pos = encodeGroup((uint32_t)in[0] << 16 | in[1] << 8 | in[2], pos, lineGroups);
+    }
+    return pos - out;
+}
+
+// Encode the last one or two bytes with padding, always 4 characters
+static void encodeTail(const uint8_t* in, size_t length, char* out)
+{
+    const uint32_t v = (uint32_t)in[0] << 16 | (length > 1 ? in[1] << 8 : 0);
+    out[0] = base64Chars[v >> 18];
+    out[1] = base64Chars[(v >> 12) & 63];
+    out[2] = length > 1 ? base64Chars[(v >> 6) & 63] : '=';
+    out[3] = '=';
+}
+
+// Encode the complete groups in chunks handed to sink(const char*, size_t)
+template <typename SinkT>
+static void encodeChunks(const uint8_t* data, size_t groups, uint8_t* lineGroups, SinkT&& sink)
+{
+    // 16 groups contain at most one newline
+    constexpr size_t CHUNK_GROUPS = 16;
+    char buf[CHUNK_GROUPS * 4 + 1];
+    while (groups)
+    {
+        const size_t n = std::min(groups, CHUNK_GROUPS);
+        sink(buf, encodeGroups(data, n, buf, lineGroups));
+        data += n * 3;
+        groups -= n;
+    }
+}
+
+size_t base64::encodedLength(size_t length, bool doNewLines)
+{
+    return (length + 2) / 3 * 4 + (doNewLines ? length / 3 / (BASE64_CHARS_PER_LINE / 4) : 0);
+}
+
+size_t base64::encode(const uint8_t * data, size_t length, char * out, bool doNewLines)
+{
+    uint8_t lineGroups = 0;
+    size_t n = encodeGroups(data, length / 3, out, doNewLines ? &lineGroups : nullptr);
+    if (length % 3)
+    {
+        encodeTail(data + length - length % 3, length % 3, out + n);
+        n += 4;
+    }
+    out[n] = '\0';
+    return n;
+}
+
+size_t base64::encode(const uint8_t * data, size_t length, Print& out, bool doNewLines)
+{
+    uint8_t lineGroups = 0;
+    size_t written = 0;
+    encodeChunks(data, length / 3, doNewLines ? &lineGroups : nullptr, [&](const char* buf, size_t n)
+    {
+        written += out.write((const uint8_t*)buf, n);
+    });
+    if (length % 3)
+    {
+        char buf[4];
+        encodeTail(data + length - length % 3, length % 3, buf);
+        written += out.write((const uint8_t*)buf, sizeof(buf));
+    }
+    return written;
+}
+
 /**
  * convert input data to base64
  * @param data const uint8_t *
@@ -38,39 +161,152 @@ String base64::encode(const uint8_t * data, size_t length, bool doNewLines)
 {
     String base64;
 
-    // base64 needs more size then the source data, use cencode.h macros
-    size_t size = ((doNewLines ? base64_encode_expected_len( length )
-                    : base64_encode_expected_len_nonewlines( length )) + 1);
+    if (base64.reserve(encodedLength(length, doNewLines)))
+    {
+        uint8_t lineGroups = 0;
+        encodeChunks(data, length / 3, doNewLines ? &lineGroups : nullptr, [&](const char* buf, size_t n)
+        {
+            base64.concat(buf, n);
+        });
+        if (length % 3)
+        {
+            char buf[4];
+            encodeTail(data + length - length % 3, length % 3, buf);
+            base64.concat(buf, sizeof(buf));
+        }
+    }
+    else
+    {
+        base64 = F("-FAIL-");
+    }
 
-    if (base64.reserve(size))
+    return base64;
+}
+
+static inline int8_t decodeChar(uint8_t c)
+{
+    return (c >= '+' && c <= 'z') ? base64Values[c - '+'] : -1;
+}
+
+int base64::decode(const char * in, size_t length, uint8_t * out)
+{
+    uint8_t* pos = out;
+    uint32_t acc = 0;
+    uint32_t count = 0;
+    size_t i = 0;
+    while (i < length)
     {
+        if (count == 0)
+        {
+            // four characters at a time while there is nothing to skip
+            for (; i + 4 <= length; i += 4)
+            {
+                const int8_t a = decodeChar(in[i]), b = decodeChar(in[i + 1]), c = decodeChar(in[i + 2]), d = decodeChar(in[i + 3]);
+                if ((a | b | c | d) < 0)
+                {
+                    break;
+                }
+                const uint32_t v = a << 18 | b << 12 | c << 6 | d;
+                pos[0] = v >> 16;
+                pos[1] = v >> 8;
+                pos[2] = v;
+                pos += 3;
+            }
+            if (i == length)
+            {
+                break;
+            }
+        }
 
-        base64_encodestate _state;
-        if (doNewLines)
+        const char c = in[i++];
+        if (c == '=')
         {
-            base64_init_encodestate(&_state);
+            break;
         }
-        else
+        if (c == '\n' || c == '\r' || c == ' ' || c == '\t')
         {
-            base64_init_encodestate_nonewlines(&_state);
+            continue;
         }
-
-        constexpr size_t BUFSIZE = 48;
-        char buf[BUFSIZE + 1 /* newline */ + 1 /* NUL */];
-        for (size_t len = 0; len < length; len += BUFSIZE * 3 / 4)
+        const int8_t v = decodeChar(c);
+        if (v < 0)
+        {
+            return -1;
+        }
+        acc = acc << 6 | v;
+        if (++count == 4)
         {
-            size_t blocklen = base64_encode_block((const char*) data + len,
-                                                  std::min( BUFSIZE * 3 / 4, length - len ), buf, &_state);
-            buf[blocklen] = '\0';
-            base64 += buf;
+            pos[0] = acc >> 16;
+            pos[1] = acc >> 8;
+            pos[2] = acc;
+            pos += 3;
+            acc = 0;
+            count = 0;
         }
-        if (base64_encode_blockend(buf, &_state))
-            base64 += buf;
     }
-    else
+
+    switch (count)
     {
-        base64 = F("-FAIL-");
+    case 1:
+        return -1;
+    case 2:
+        *pos++ = acc >> 4;
+        break;
+    case 3:
+        *pos++ = acc >> 10;
+        *pos++ = acc >> 2;
+        break;
     }
+    return pos - out;
+}
 
-    return base64;
+size_t base64::Encoder::write(const uint8_t * data, size_t length)
+{
+    if (_ended)
+    {
+        return 0;
+    }
+    const size_t consumed = length;
+    uint8_t* lineGroups = _newLines ? &_lineGroups : nullptr;
+    if (_pendingLength)
+    {
+        if (_pendingLength + length < 3)
+        {
+            memcpy(_pending + _pendingLength, data, length);
+            _pendingLength += length;
+            return consumed;
+        }
+        uint8_t group[3];
+        const size_t fill = 3 - _pendingLength;
+        memcpy(group, _pending, _pendingLength);
+        memcpy(group + _pendingLength, data, fill);
+        data += fill;
+        length -= fill;
+        _pendingLength = 0;
+        char buf[5];
+        _out.write((const uint8_t*)buf, encodeGroups(group, 1, buf, lineGroups));
+    }
+    encodeChunks(data, length / 3, lineGroups, [&](const char* buf, size_t n)
+    {
+        _out.write((const uint8_t*)buf, n);
+    });
+    _pendingLength = length % 3;
+    memcpy(_pending, data + length - _pendingLength, _pendingLength);
+    return consumed;
+}
+
+size_t base64::Encoder::end()
+{
+    if (_ended)
+    {
+        return 0;
+    }
+    _ended = true;
+    if (!_pendingLength)
+    {
+        return 0;
+    }
+    char buf[4];
+    encodeTail(_pending, _pendingLength, buf);
+    _pendingLength = 0;
+    return _out.write((const uint8_t*)buf, sizeof(buf));
 }
@@ -26,6 +26,7 @@
 #define CORE_BASE64_H_
 
 #include <WString.h>
+#include <Print.h>
 
 class base64
 {
@@ -50,6 +51,55 @@ public:
     {
         return encode(text, false);
     }
+
+    // Without String: the output is the same as above, written to a caller
+    // buffer of at least encodedLength() + 1 bytes (NUL terminated), or to
+    // a Print.  Both return the number of characters.
+    static size_t encodedLength(size_t length, bool doNewLines = false);
+    static size_t encode(const uint8_t * data, size_t length, char * out, bool doNewLines = false);
+    static size_t encode(const uint8_t * data, size_t length, Print& out, bool doNewLines = false);
+
+    // Decode into a buffer of at least decodedLength(length) bytes.  Newlines
+    // and spaces are skipped, decoding stops at the first '='.  Returns the
+    // number of bytes, or -1 if the input has any other character.
+    static size_t decodedLength(size_t length)
+    {
+        return length / 4 * 3 + 3;
+    }
+    static int decode(const char * in, size_t length, uint8_t * out);
+    static inline int decode(const String& in, uint8_t * out)
+    {
+        return decode(in.c_str(), in.length(), out);
+    }
+
+    // Streaming encoder: everything written to it is encoded to `out`,
+    // end() writes the padding.
+    class Encoder: public Print
+    {
+    public:
+        Encoder(Print& out, bool doNewLines = false): _out(out), _newLines(doNewLines) {}
+        ~Encoder()
+        {
+            end();
+        }
+
+        size_t write(uint8_t c) override
+        {
+            return write(&c, 1);
+        }
+        size_t write(const uint8_t * data, size_t length) override;
+        // Returns the number of characters written, 0 if already ended
+        size_t end();
+
+    private:
+        Print& _out;
+        uint8_t _pending[2];
+        uint8_t _pendingLength = 0;
+        uint8_t _lineGroups = 0;
+        bool _newLines;
+        bool _ended = false;
+    };
+
 private:
 };
 
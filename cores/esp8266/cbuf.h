@@ -23,7 +23,9 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
+#include <atomic>
 
 class cbuf {
     public:
@@ -72,4 +74,129 @@ class cbuf {
 
 };
 
+// Ring with a power-of-two capacity for one producer and one consumer,
+// e.g. an ISR and the loop.  Both indexes run freely and are masked on
+// access, and each side only stores its own index (the producer _head,
+// the consumer _tail), so neither side has to mask interrupts.  The span
+// accessors return the linear part of the data or of the free room, for
+// bulk copies without per-byte wrap checks.
+// Everything is inlined so the producer side can be called from IRAM.
+class cbuf_pow2 {
+    public:
+        // size is rounded up to a power of two, capacity() is 0 when out of memory
+        explicit cbuf_pow2(size_t size) {
+            size_t cap = 1;
+            while (cap < size)
+                cap <<= 1;
+            _buf = (char*)malloc(cap);
+            _size = _buf ? cap : 0;
+        }
+        ~cbuf_pow2() { free(_buf); }
+        cbuf_pow2(const cbuf_pow2&) = delete;
+        cbuf_pow2& operator=(const cbuf_pow2&) = delete;
+
+        inline size_t capacity() const __attribute__((always_inline)) { return _size; }
+        inline size_t available() const __attribute__((always_inline)) { return _head - _tail; }
+        inline size_t room() const __attribute__((always_inline)) { return _size - available(); }
+        inline bool empty() const __attribute__((always_inline)) { return _head == _tail; }
+        inline bool full() const __attribute__((always_inline)) { return available() == _size; }
+
+        // consumer side
+
+        int peek() const {
+            if (empty())
+                return -1;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return (uint8_t)_buf[_tail & (_size - 1)];
+        }
+
+        int read() {
+            int c = peek();
+            if (c >= 0)
+                consume(1);
+            return c;
+        }
+
+        size_t read(char* dst, size_t size) {
+            size_t done = 0;
+            const char* span;
+            size_t n;
+            while (done < size && (n = readSpan(span))) {
+                if (n > size - done)
+                    n = size - done;
+                memcpy(dst + done, span, n);
+                consume(n);
+                done += n;
+            }
+            return done;
+        }
+
+        // Linear run of the oldest data, release it with consume()
+        inline size_t readSpan(const char*& span) const __attribute__((always_inline)) {
+            const size_t tail = _tail;
+            const size_t avail = _head - tail;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            const size_t pos = tail & (_size - 1);
+            span = _buf + pos;
+            return avail < _size - pos ? avail : _size - pos;
+        }
+
+        inline void consume(size_t size) __attribute__((always_inline)) {
+            std::atomic_thread_fence(std::memory_order_release);
+            _tail = _tail + size;
+        }
+
+        // drop all data
+        void flush() {
+            _tail = _head;
+        }
+
+        // producer side
+
+        inline bool write(char c) __attribute__((always_inline)) {
+            const size_t head = _head;
+            if (head - _tail == _size)
+                return false;
+            _buf[head & (_size - 1)] = c;
+            std::atomic_thread_fence(std::memory_order_release);
+            _head = head + 1;
+            return true;
+        }
+
+        size_t write(const char* src, size_t size) {
+            size_t done = 0;
+            char* span;
+            size_t n;
+            while (done < size && (n = writeSpan(span))) {
+                if (n > size - done)
+                    n = size - done;
+                memcpy(span, src + done, n);
+                commit(n);
+                done += n;
+            }
+            return done;
+        }
+
+        // Linear run of free room, publish what was written with commit()
+        inline size_t writeSpan(char*& span) const __attribute__((always_inline)) {
+            const size_t head = _head;
+            const size_t space = _size - (head - _tail);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            const size_t pos = head & (_size - 1);
+            span = _buf + pos;
+            return space < _size - pos ? space : _size - pos;
+        }
+
+        inline void commit(size_t size) __attribute__((always_inline)) {
+            std::atomic_thread_fence(std::memory_order_release);
+            _head = _head + size;
+        }
+
+    private:
+        char* _buf;
+        size_t _size;
+        volatile size_t _head = 0;
+        volatile size_t _tail = 0;
+};
+
 #endif//__cbuf_h
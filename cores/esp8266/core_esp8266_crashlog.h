@@ -0,0 +1,113 @@
+/*
+ core_esp8266_crashlog.h - compact crash records in RTC user memory
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __CORE_ESP8266_CRASHLOG_H
+#define __CORE_ESP8266_CRASHLOG_H
+
+#include <stdint.h>
+
+/*
+  The ring occupies the end of the RTC user memory (ESP.rtcUserMemory*
+  blocks): the records, then the number of records ever written, then
+  CRASHLOG_MAGIC ^ the number of slots in the last block.  It exists only
+  after ESP.crashLogBegin(), which reserves it.
+
+  The writers below are used by postmortem and by the hardware WDT stack
+  dump at boot, before the SDK runs, so they only access RTC memory
+  directly and are always inlined.
+*/
+
+#define CRASHLOG_FRAMES 8
+#define CRASHLOG_MAGIC 0x474c5243 // "CRLG"
+
+#define CRASHLOG_CTX_CONT 0
+#define CRASHLOG_CTX_SYS 1
+#define CRASHLOG_CTX_BEARSSL 2
+// Set in ctx by the hardware WDT dump, cleared by ESP.crashLogBegin()
+#define CRASHLOG_CTX_AT_BOOT 0x80
+
+typedef struct crashlog_record_ {
+    uint8_t reason;     // rst_info reason (REASON_*)
+    uint8_t exccause;
+    uint8_t ctx;        // CRASHLOG_CTX_*
+    uint8_t depth;      // valid entries in frames[]
+    uint32_t epc1;
+    uint32_t excvaddr;
+    uint32_t sp;
+    uint32_t uptime;    // millis() at the crash, 0 if not known
+    uint32_t frames[CRASHLOG_FRAMES];   // code addresses found on the stack, innermost first
+} crashlog_record_t;
+
+#define CRASHLOG_RTC ((volatile uint32_t*)0x60001200) // RTC user memory block 0
+#define CRASHLOG_RTC_BLOCKS 128
+#define CRASHLOG_RECORD_BLOCKS (sizeof(crashlog_record_t) / sizeof(uint32_t))
+// The first 32 blocks belong to eboot
+#define CRASHLOG_MAX_RECORDS ((CRASHLOG_RTC_BLOCKS - 32 - 2) / CRASHLOG_RECORD_BLOCKS)
+
+static inline uint32_t crashlog_capacity() __attribute__((always_inline));
+static inline uint32_t crashlog_capacity()
+{
+    const uint32_t slots = CRASHLOG_RTC[CRASHLOG_RTC_BLOCKS - 1] ^ CRASHLOG_MAGIC;
+    return (slots && slots <= CRASHLOG_MAX_RECORDS) ? slots : 0;
+}
+
+static inline uint32_t crashlog_written() __attribute__((always_inline));
+static inline uint32_t crashlog_written()
+{
+    return CRASHLOG_RTC[CRASHLOG_RTC_BLOCKS - 2];
+}
+
+// Slot of the n-th record ever written
+static inline volatile uint32_t* crashlog_slot(uint32_t capacity, uint32_t n) __attribute__((always_inline));
+static inline volatile uint32_t* crashlog_slot(uint32_t capacity, uint32_t n)
+{
+    return CRASHLOG_RTC + CRASHLOG_RTC_BLOCKS - 2 - (capacity - n % capacity) * CRASHLOG_RECORD_BLOCKS;
+}
+
+static inline void crashlog_add(const crashlog_record_t* record) __attribute__((always_inline));
+static inline void crashlog_add(const crashlog_record_t* record)
+{
+    const uint32_t capacity = crashlog_capacity();
+    if (!capacity) {
+        return;
+    }
+    const uint32_t written = crashlog_written();
+    volatile uint32_t* dst = crashlog_slot(capacity, written);
+    const uint32_t* src = (const uint32_t*)record;
+    for (uint32_t i = 0; i < CRASHLOG_RECORD_BLOCKS; ++i) {
+        dst[i] = src[i];
+    }
+    CRASHLOG_RTC[CRASHLOG_RTC_BLOCKS - 2] = written + 1;
+}
+
+// Keep the words of [pos, end) that look like IRAM or flash code addresses
+static inline uint8_t crashlog_collect_frames(uint32_t* frames, const uint32_t* pos, const uint32_t* end) __attribute__((always_inline));
+static inline uint8_t crashlog_collect_frames(uint32_t* frames, const uint32_t* pos, const uint32_t* end)
+{
+    uint8_t depth = 0;
+    for (; pos < end && depth < CRASHLOG_FRAMES; ++pos) {
+        const uint32_t value = *pos;
+        if ((value >= 0x40100000 && value < 0x40110000) || (value >= 0x40201000 && value < 0x40300000)) {
+            frames[depth++] = value;
+        }
+    }
+    return depth;
+}
+
+#endif // __CORE_ESP8266_CRASHLOG_H
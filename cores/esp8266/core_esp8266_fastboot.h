@@ -0,0 +1,92 @@
+/*
+ core_esp8266_fastboot.h - RF calibration skipping and boot profile
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __CORE_ESP8266_FASTBOOT_H
+#define __CORE_ESP8266_FASTBOOT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "core_esp8266_features.h"
+
+/*
+  FAST_BOOT(block) in the sketch (see Esp.h) keeps a two word record in
+  RTC user memory at `block`: the number of boots since the last
+  calibrated one, then FASTBOOT_MAGIC ^ that number.  While the record is
+  valid and younger than FASTBOOT_RECAL_BOOTS, the PHY init data tells the
+  SDK to skip the TX power calibration (init data byte 114 = 0) and to
+  use the calibration saved in flash as is.  A power cycle clears RTC
+  memory, so the first boot after it always calibrates.
+
+  The boot profile is recorded at every boot: esp_get_cycle_count() at
+  each step, 0 when the step was not reached yet.  It lives in .noinit
+  because the first step comes before .bss is cleared, and is cleared
+  there.  The cycle counter starts at reset, and runs at the ROM clock
+  until the SDK sets up the PLL (so app_entry is approximate), at 80MHz
+  until setup(), then at F_CPU.  boot_profile_us() accounts for that.
+*/
+
+#define FASTBOOT_MAGIC 0x54534146 // "FAST"
+#define FASTBOOT_RECAL_BOOTS 16
+
+enum {
+    BOOT_MARK_APP_ENTRY,    // app_entry(), the ROM bootloader and eboot are done
+    BOOT_MARK_RF_INIT,      // user_rf_pre_init(), the SDK is about to init the PHY
+    BOOT_MARK_USER_INIT,    // user_init(), the PHY is up
+    BOOT_MARK_INIT,         // init() returned
+    BOOT_MARK_VARIANT,      // initVariant() and the flash quirks returned
+    BOOT_MARK_INIT_DONE,    // the SDK is done, C++ constructors follow
+    BOOT_MARK_CTORS,        // constructors of the global objects returned
+    BOOT_MARK_SETUP,        // setup() called
+    BOOT_MARK_LOOP,         // first loop() called
+    BOOT_MARKS
+};
+
+typedef struct boot_profile_ {
+    uint32_t cycles[BOOT_MARKS];
+} boot_profile_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern boot_profile_t boot_profile;
+
+static inline void boot_mark(int mark) __attribute__((always_inline));
+static inline void boot_mark(int mark)
+{
+    boot_profile.cycles[mark] = esp_get_cycle_count();
+}
+
+// Approximate time of a step since reset, 0 when not reached
+uint32_t boot_profile_us(int mark);
+
+// Whether this boot skipped the RF calibration
+bool fastboot_rf_cal_skipped(void);
+// Force a calibration at the next boot
+void fastboot_invalidate(void);
+
+#ifdef __cplusplus
+}
+
+#include <Print.h>
+// One line with <mark>:<us> for each step reached
+size_t boot_profile_print(Print& out);
+#endif
+
+#endif // __CORE_ESP8266_FASTBOOT_H
@@ -103,6 +103,9 @@ unsigned long millis(void);
 unsigned long micros(void);
 uint64_t micros64(void);
 void delay(unsigned long);
+// Let delay() enter forced light sleep for waits of at least min_ms while
+// WiFi is off, 0 (the default) disables it.  See ESP.setTicklessDelay().
+void delay_set_tickless(uint32_t min_ms);
 void delayMicroseconds(unsigned int us);
 
 #if defined(F_CPU) || defined(CORE_MOCK)
@@ -20,10 +20,21 @@
 
 #include <c_types.h>
 #include "spi_flash.h"
+#include "esp8266_peri.h"
+#include "eagle_soc.h"
+#include "esp8266_undocumented.h"
+#include "core_esp8266_features.h"
 
 #include "spi_utils.h"
 #include "flash_quirks.h"
 
+// FLASH_FAST_MODE() in the sketch, see Esp.h
+extern int __get_flash_fast_mode() __attribute__((weak));
+int __get_flash_fast_mode()
+{
+    return 0;
+}
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -52,12 +63,101 @@ static int get_flash_mhz() {
     return 0;
 }
 
+/* Chips known to read at 80MHz and, with FLASH_CAP_QE_SR2, in QIO once the
+ * Quad Enable bit (status register 2, bit 1) is set.  Matched on the
+ * vendor and memory type bytes of the JEDEC ID, vendor in the low byte.
+ */
+#define FLASH_CAP_80MHZ  0x01
+#define FLASH_CAP_QE_SR2 0x02
+
+static const struct {
+    uint16_t id;
+    uint8_t caps;
+} flash_caps[] = {
+    { 0x40EF, FLASH_CAP_80MHZ | FLASH_CAP_QE_SR2 }, // Winbond W25Q
+    { 0x40C8, FLASH_CAP_80MHZ | FLASH_CAP_QE_SR2 }, // GigaDevice GD25Q
+    { 0x4020, FLASH_CAP_80MHZ | FLASH_CAP_QE_SR2 }, // XMC XM25QH
+    { 0x6085, FLASH_CAP_80MHZ | FLASH_CAP_QE_SR2 }, // Puya P25Q
+    { 0x20C2, FLASH_CAP_80MHZ },                    // Macronix MX25L
+};
+
+static uint8_t get_flash_caps(uint32_t id) {
+    for (const auto& chip : flash_caps) {
+        if (chip.id == (id & 0xffff)) {
+            return chip.caps;
+        }
+    }
+    return 0;
+}
+
+static int get_flash_mode() {
+    uint32_t data;
+    uint8_t * bytes = (uint8_t *) &data;
+    if(spi_flash_read(0x0000, &data, 4) == SPI_FLASH_RESULT_OK) {
+        return bytes[2];    // 0 QIO, 1 QOUT, 2 DIO, 3 DOUT
+    }
+    return -1;
+}
+
+/* Set the Quad Enable bit, in the volatile status register only: nothing
+ * is written to the flash cells, a power cycle or reset goes back to the
+ * chip's default and this runs again.
+ */
+static bool enable_flash_quad() {
+    uint32_t SR1, SR2;
+    if (SPI0Command(SPI_FLASH_CMD_RSR1, &SR1, 0, 8) != SPI_RESULT_OK ||
+        SPI0Command(SPI_FLASH_CMD_RSR2, &SR2, 0, 8) != SPI_RESULT_OK) {
+        return false;
+    }
+    if (SR2 & SPI_FLASH_SR2_QE) {
+        return true;
+    }
+    // SR1 then SR2 in one write, which older chips without WSR2 accept too
+    uint32_t SR = SR1 | ((SR2 | SPI_FLASH_SR2_QE) << 8);
+    if (SPI0Command(SPI_FLASH_CMD_WEVSR, NULL, 0, 0) != SPI_RESULT_OK ||
+        SPI0Command(SPI_FLASH_CMD_WSR1, &SR, 16, 0) != SPI_RESULT_OK) {
+        return false;
+    }
+    SPI0Command(SPI_FLASH_CMD_WRDI, NULL, 0, 0);
+    return SPI0Command(SPI_FLASH_CMD_RSR2, &SR2, 0, 8) == SPI_RESULT_OK
+        && (SR2 & SPI_FLASH_SR2_QE);
+}
+
+/* Switch the cache's flash reads to another mode and clock.  Nothing may
+ * be read from flash meanwhile, hence IRAM and interrupts off.
+ */
+static void IRAM_ATTR set_flash_mode(bool qio, bool clock80) {
+    uint32_t saved_ps = xt_rsil(15);
+    Wait_SPI_Idle(flashchip);
+    if (qio) {
+        SPI0C = (SPI0C & ~(SPICQIO | SPICDIO | SPICQOUT | SPICDOUT)) | SPICQIO | SPICFASTRD;
+    }
+    if (clock80) {
+        SET_PERI_REG_MASK(PERIPHS_IO_MUX_CONF_U, SPI0_CLK_EQU_SYS_CLK);
+        SPI0CLK = SPICLK_EQU_SYSCLK;
+    }
+    xt_wsr_ps(saved_ps);
+}
+
 /* initFlashQuirks()
  * Do any chip-specific initialization to improve performance and reliability.
  */
 void initFlashQuirks() {
   using namespace experimental;
-  uint32_t vendor = spi_flash_get_id() & 0x000000ff;
+  uint32_t id = spi_flash_get_id();
+  uint32_t vendor = id & 0x000000ff;
+
+  // Only on request: the chip may support QIO while GPIO9 and GPIO10 are
+  // not wired to its /HOLD and /WP pins, or are used by the sketch
+  int fast = __get_flash_fast_mode();
+  uint8_t caps = get_flash_caps(id);
+  if (fast && caps) {
+    bool clock80 = (fast & FLASH_FAST_CLOCK) && (caps & FLASH_CAP_80MHZ) && get_flash_mhz() == 40;
+    bool qio = (fast & FLASH_FAST_QIO) && (caps & FLASH_CAP_QE_SR2) && get_flash_mode() != 0 && enable_flash_quad();
+    if (clock80 || qio) {
+      set_flash_mode(qio, clock80);
+    }
+  }
 
   switch (vendor) {
     case SPI_FLASH_VENDOR_XMC:
@@ -0,0 +1,75 @@
+/*
+ core_esp8266_governor.h - CPU clock switched between 80 and 160MHz on load
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __CORE_ESP8266_GOVERNOR_H
+#define __CORE_ESP8266_GOVERNOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+  Once cpu_governor_begin() is called, core_esp8266_main.cpp measures the
+  time the sketch side runs (loop(), scheduled functions, up to each
+  yield) against the time that passed, over windows of window_ms.  Only
+  runs of 500us or more without a yield count, a loop() polling at full
+  speed is not load.  After a window busier than up_percent the CPU runs
+  at 160MHz, after one less busy than down_percent at 80MHz.  Between
+  cpu_boost_begin() and cpu_boost_end(), which nest, it runs at 160MHz
+  whatever the load; the BearSSL handshakes do so.
+
+  For 80MHz builds only (F_CPU), where the rest of the core is ready for
+  the CPU to run faster than F_CPU: the waveform generators check the
+  clock, delayMicroseconds() follows ets_update_cpu_frequency(), the UART,
+  timer1 and SPI are clocked from the 80MHz APB, and the I2C master is
+  told.  Sketch code timed with clockCyclesPerMicrosecond() or the cycle
+  counter is not, and loopstats histograms count 160MHz time double.
+*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// false in 160MHz builds
+bool cpu_governor_begin(uint8_t up_percent, uint8_t down_percent, uint32_t window_ms);
+// back to 80MHz
+void cpu_governor_end(void);
+void cpu_boost_begin(void);
+void cpu_boost_end(void);
+
+#ifdef __cplusplus
+}
+
+// 160MHz for the scope, while the governor runs
+class CpuBoost
+{
+public:
+    CpuBoost()
+    {
+        cpu_boost_begin();
+    }
+    ~CpuBoost()
+    {
+        cpu_boost_end();
+    }
+    CpuBoost(const CpuBoost&) = delete;
+    CpuBoost& operator=(const CpuBoost&) = delete;
+};
+#endif
+
+#endif // __CORE_ESP8266_GOVERNOR_H
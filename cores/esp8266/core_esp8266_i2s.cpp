@@ -25,11 +25,15 @@
 #include "ets_sys.h"
 #include "i2s_reg.h"
 #include "core_esp8266_i2s.h"
+#include "umm_malloc/umm_malloc.h"
 
 extern "C" {
 
-#define SLC_BUF_CNT (8)  // Number of buffers in the I2S circular buffer
-#define SLC_BUF_LEN (64) // Length of one buffer, in 32-bit words.
+#define SLC_BUF_CNT_MAX (16)  // Most buffers in the I2S circular buffer
+#define SLC_BUF_LEN_MAX (1023) // Longest buffer, in 32-bit words (12-bit descriptor length in bytes)
+
+static uint8_t  _slc_buf_cnt = 8;  // Number of buffers in the I2S circular buffer
+static uint16_t _slc_buf_len = 64; // Length of one buffer, in 32-bit words.
 
 // We use a queue to keep track of the DMA buffers that are empty. The ISR
 // will push buffers to the back of the queue, the I2S transmitter will pull
@@ -54,10 +58,11 @@ typedef struct slc_queue_item {
 } slc_queue_item_t;
 
 typedef struct i2s_state {
-  uint32_t *       slc_queue[SLC_BUF_CNT];
+  uint32_t *       slc_queue[SLC_BUF_CNT_MAX];
+  uint32_t         slc_queue_cycles[SLC_BUF_CNT_MAX]; // When each entry was queued, for the stats
   volatile uint8_t slc_queue_len;
-  uint32_t *       slc_buf_pntr[SLC_BUF_CNT]; // Pointer to the I2S DMA buffer data
-  slc_queue_item_t slc_items[SLC_BUF_CNT]; // I2S DMA buffer descriptors
+  uint32_t *       slc_buf_pntr[SLC_BUF_CNT_MAX]; // Pointer to the I2S DMA buffer data
+  slc_queue_item_t slc_items[SLC_BUF_CNT_MAX]; // I2S DMA buffer descriptors
   uint32_t *       curr_slc_buf; // Current buffer for writing
   uint32_t         curr_slc_buf_pos; // Position in the current buffer
   void             (*callback) (void);
@@ -65,12 +70,17 @@ typedef struct i2s_state {
   // and be placed in IRAM for faster execution. Avoid long computational tasks in this
   // function, use it to set flags and process later.
   bool             driveClocks;
+  bool             loop; // DMA repeats the ring as it is, see i2s_pwm_begin()
+  i2s_stats_t      stats;
 } i2s_state_t;
 
 // RX = I2S receive (i.e. microphone), TX = I2S transmit (i.e. DAC)
 static i2s_state_t *rx = NULL;
 static i2s_state_t *tx = NULL;
 
+// Fills every TX buffer the DMA is done with, instead of the write queue
+static void (*_i2s_tx_refill)(uint32_t *buf, uint16_t words) = NULL;
+
 // Last I2S sample rate requested
 static uint32_t _i2s_sample_rate;
 static int _i2s_bits = 16;
@@ -85,6 +95,19 @@ static int _i2s_bits = 16;
 #define I2SI_BCK  13
 #define I2SI_WS   14
 
+bool i2s_set_buffers(uint8_t count, uint16_t len) {
+  if (tx || rx || count < 2 || count > SLC_BUF_CNT_MAX || len < 16 || len > SLC_BUF_LEN_MAX) {
+    return false;
+  }
+  _slc_buf_cnt = count;
+  _slc_buf_len = len;
+  return true;
+}
+
+uint16_t i2s_buffer_len() {
+  return _slc_buf_len;
+}
+
 bool i2s_set_bits(int bits) {
   if (tx || rx || (bits != 16 && bits != 24)) {
     return false;
@@ -97,7 +120,7 @@ static bool _i2s_is_full(const i2s_state_t *ch) {
   if (!ch) {
     return false;
   }
-  return (ch->curr_slc_buf_pos==SLC_BUF_LEN || ch->curr_slc_buf==NULL) && (ch->slc_queue_len == 0);
+  return (ch->curr_slc_buf_pos==_slc_buf_len || ch->curr_slc_buf==NULL) && (ch->slc_queue_len == 0);
 }
 
 bool i2s_is_full() {
@@ -112,7 +135,7 @@ static bool _i2s_is_empty(const i2s_state_t *ch) {
   if (!ch) {
     return false;
   }
-  return (ch->slc_queue_len >= SLC_BUF_CNT-1);
+  return (ch->slc_queue_len >= _slc_buf_cnt-1);
 }
 
 bool i2s_is_empty() {
@@ -127,7 +150,7 @@ static uint16_t _i2s_available(const i2s_state_t *ch) {
   if (!ch) {
     return 0;
   }
-  return (SLC_BUF_CNT - ch->slc_queue_len) * SLC_BUF_LEN;
+  return (_slc_buf_cnt - ch->slc_queue_len) * _slc_buf_len;
 }
 
 uint16_t i2s_available(){
@@ -145,47 +168,88 @@ static uint32_t * IRAM_ATTR i2s_slc_queue_next_item(i2s_state_t *ch) {
   ch->slc_queue_len--;
   for ( i = 0; i < ch->slc_queue_len; i++) {
     ch->slc_queue[i] = ch->slc_queue[i+1];
+    ch->slc_queue_cycles[i] = ch->slc_queue_cycles[i+1];
   }
   return item;
 }
 
+// Pop the top off for the application, call with the SLC interrupt disabled
+static uint32_t *i2s_slc_queue_take(i2s_state_t *ch) {
+  uint32_t waited = esp_get_cycle_count() - ch->slc_queue_cycles[0];
+  ch->stats.wait_last_cycles = waited;
+  if (waited > ch->stats.wait_max_cycles) {
+    ch->stats.wait_max_cycles = waited;
+  }
+  return i2s_slc_queue_next_item(ch);
+}
+
+static void IRAM_ATTR i2s_slc_queue_push(i2s_state_t *ch, uint32_t *item, uint32_t now) {
+  ch->slc_queue[ch->slc_queue_len] = item;
+  ch->slc_queue_cycles[ch->slc_queue_len] = now;
+  ch->slc_queue_len++;
+  if (ch->slc_queue_len > ch->stats.queue_high_water) {
+    ch->stats.queue_high_water = ch->slc_queue_len;
+  }
+}
+
+static void IRAM_ATTR i2s_slc_count_xrun(i2s_state_t *ch, uint32_t now) {
+  ch->stats.xruns++;
+  ch->stats.xrun_samples += _slc_buf_len;
+  ch->stats.last_xrun_cycles = now;
+}
+
 // Append an item to the end of the queue from receive
-static void IRAM_ATTR i2s_slc_queue_append_item(i2s_state_t *ch, uint32_t *item) {
-  // Shift everything up, except for the one corresponding to this item
-  for (int i=0, dest=0; i < ch->slc_queue_len; i++) {
+static void IRAM_ATTR i2s_slc_queue_append_item(i2s_state_t *ch, uint32_t *item, uint32_t now) {
+  // Shift everything up, except for the one corresponding to this item.  If
+  // it was still queued the DMA has wrapped around and refilled it unread.
+  int dest = 0;
+  for (int i=0; i < ch->slc_queue_len; i++) {
     if (ch->slc_queue[i] != item) {
+      ch->slc_queue_cycles[dest] = ch->slc_queue_cycles[i];
       ch->slc_queue[dest++] = ch->slc_queue[i];
     }
   }
-  if (ch->slc_queue_len < SLC_BUF_CNT - 1) {
-    ch->slc_queue[ch->slc_queue_len++] = item;
-  } else {
-    ch->slc_queue[ch->slc_queue_len] = item;
+  if (dest != ch->slc_queue_len) {
+    i2s_slc_count_xrun(ch, now);
   }
+  ch->slc_queue_len = dest;
+  if (ch->slc_queue_len >= _slc_buf_cnt - 1) {
+    // Drop the newest waiting buffer to make room
+    ch->slc_queue_len--;
+    i2s_slc_count_xrun(ch, now);
+  }
+  i2s_slc_queue_push(ch, item, now);
 }
 
 static void IRAM_ATTR i2s_slc_isr(void) {
   ETS_SLC_INTR_DISABLE();
   uint32_t slc_intr_status = SLCIS;
   SLCIC = 0xFFFFFFFF;
+  uint32_t now = esp_get_cycle_count();
   if (slc_intr_status & SLCIRXEOF) {
     slc_queue_item_t *finished_item = (slc_queue_item_t *)SLCRXEDA;
-    // Zero the buffer so it is mute in case of underflow
-    ets_memset((void *)finished_item->buf_ptr, 0x00, SLC_BUF_LEN * 4);
-    if (tx->slc_queue_len >= SLC_BUF_CNT-1) {
-      // All buffers are empty. This means we have an underflow
-      i2s_slc_queue_next_item(tx); // Free space for finished_item
-    }
-    tx->slc_queue[tx->slc_queue_len++] = finished_item->buf_ptr;
-    if (tx->callback) {
-      tx->callback();
+    if (_i2s_tx_refill) {
+      // The buffer goes out again after the rest of the ring, never queue it
+      _i2s_tx_refill(finished_item->buf_ptr, _slc_buf_len);
+    } else {
+      // Zero the buffer so it is mute in case of underflow
+      ets_memset((void *)finished_item->buf_ptr, 0x00, _slc_buf_len * 4);
+      if (tx->slc_queue_len >= _slc_buf_cnt-1) {
+        // All buffers are empty. This means we have an underflow
+        i2s_slc_queue_next_item(tx); // Free space for finished_item
+        i2s_slc_count_xrun(tx, now);
+      }
+      i2s_slc_queue_push(tx, finished_item->buf_ptr, now);
+      if (tx->callback) {
+        tx->callback();
+      }
     }
   }
   if (slc_intr_status & SLCITXEOF) {
     slc_queue_item_t *finished_item = (slc_queue_item_t *)SLCTXEDA;
     // Set owner back to 1 (SW) or else RX stops.  TX has no such restriction.
     finished_item->owner = 1;
-    i2s_slc_queue_append_item(rx, finished_item->buf_ptr);
+    i2s_slc_queue_append_item(rx, finished_item->buf_ptr, now);
     if (rx->callback) {
       rx->callback();
     }
@@ -193,6 +257,43 @@ static void IRAM_ATTR i2s_slc_isr(void) {
   ETS_SLC_INTR_ENABLE();
 }
 
+static bool _i2s_get_stats(i2s_state_t *ch, i2s_stats_t *stats) {
+  if (!ch || !stats) {
+    return false;
+  }
+  ETS_SLC_INTR_DISABLE();
+  *stats = ch->stats;
+  ETS_SLC_INTR_ENABLE();
+  return true;
+}
+
+bool i2s_get_stats(i2s_stats_t *stats) {
+  return _i2s_get_stats(tx, stats);
+}
+
+bool i2s_rx_get_stats(i2s_stats_t *stats) {
+  return _i2s_get_stats(rx, stats);
+}
+
+void i2s_reset_stats() {
+  ETS_SLC_INTR_DISABLE();
+  if (tx) {
+    memset(&tx->stats, 0, sizeof(tx->stats));
+  }
+  if (rx) {
+    memset(&rx->stats, 0, sizeof(rx->stats));
+  }
+  ETS_SLC_INTR_ENABLE();
+}
+
+void i2s_set_refill_callback(void (*refill) (uint32_t *buf, uint16_t words)) {
+  ETS_SLC_INTR_DISABLE();
+  _i2s_tx_refill = refill;
+  if (tx || rx) {
+    ETS_SLC_INTR_ENABLE();
+  }
+}
+
 void i2s_set_callback(void (*callback) (void)) {
   if (tx) tx->callback = callback;
 }
@@ -203,22 +304,25 @@ void i2s_rx_set_callback(void (*callback) (void)) {
 
 static bool _alloc_channel(i2s_state_t *ch) {
   ch->slc_queue_len = 0;
-  for (int x=0; x<SLC_BUF_CNT; x++) {
-    ch->slc_buf_pntr[x] = (uint32_t *)malloc(SLC_BUF_LEN * sizeof(ch->slc_buf_pntr[0][0]));
+  for (int x=0; x<_slc_buf_cnt; x++) {
+    ch->slc_buf_pntr[x] = (uint32_t *)umm_class_malloc(UMM_HEAP_CLASS_DMA, _slc_buf_len * sizeof(ch->slc_buf_pntr[0][0]));
     if (!ch->slc_buf_pntr[x]) {
       // OOM, the upper layer will free up any partially allocated channels.
       return false;
     }
-    memset(ch->slc_buf_pntr[x], 0, SLC_BUF_LEN * sizeof(ch->slc_buf_pntr[x][0]));
+    memset(ch->slc_buf_pntr[x], 0, _slc_buf_len * sizeof(ch->slc_buf_pntr[x][0]));
+    if (ch == tx && _i2s_tx_refill) {
+      _i2s_tx_refill(ch->slc_buf_pntr[x], _slc_buf_len);
+    }
 
     ch->slc_items[x].unused = 0;
     ch->slc_items[x].owner = 1;
     ch->slc_items[x].eof = 1;
     ch->slc_items[x].sub_sof = 0;
-    ch->slc_items[x].datalen = SLC_BUF_LEN * 4;
-    ch->slc_items[x].blocksize = SLC_BUF_LEN * 4;
+    ch->slc_items[x].datalen = _slc_buf_len * 4;
+    ch->slc_items[x].blocksize = _slc_buf_len * 4;
     ch->slc_items[x].buf_ptr = (uint32_t*)&ch->slc_buf_pntr[x][0];
-    ch->slc_items[x].next_link_ptr = (x<(SLC_BUF_CNT-1))?(&ch->slc_items[x+1]):(&ch->slc_items[0]);
+    ch->slc_items[x].next_link_ptr = (x<(_slc_buf_cnt-1))?(&ch->slc_items[x+1]):(&ch->slc_items[0]);
   }
   return true;
 }
@@ -284,7 +388,7 @@ static void i2s_slc_end(){
   SLCTXL &= ~(SLCTXLAM << SLCTXLA); // clear TX descriptor address
   SLCRXL &= ~(SLCRXLAM << SLCRXLA); // clear RX descriptor address
 
-  for (int x = 0; x<SLC_BUF_CNT; x++) {
+  for (int x = 0; x<_slc_buf_cnt; x++) {
     if (tx) {
       free(tx->slc_buf_pntr[x]);
       tx->slc_buf_pntr[x] = NULL;
@@ -299,11 +403,11 @@ static void i2s_slc_end(){
 // These routines push a single, 32-bit sample to the I2S buffers. Call at (on average)
 // at least the current sample rate.
 static bool _i2s_write_sample(uint32_t sample, bool nb) {
-  if (!tx) {
+  if (!tx || tx->loop) {
     return false;
   }
 
-  if (tx->curr_slc_buf_pos==SLC_BUF_LEN || tx->curr_slc_buf==NULL) {
+  if (tx->curr_slc_buf_pos==_slc_buf_len || tx->curr_slc_buf==NULL) {
     if (tx->slc_queue_len == 0) {
       if (nb) {
         // Don't wait if nonblocking, just notify upper levels
@@ -318,7 +422,7 @@ static bool _i2s_write_sample(uint32_t sample, bool nb) {
       }
     }
     ETS_SLC_INTR_DISABLE();
-    tx->curr_slc_buf = (uint32_t *)i2s_slc_queue_next_item(tx);
+    tx->curr_slc_buf = i2s_slc_queue_take(tx);
     ETS_SLC_INTR_ENABLE();
     tx->curr_slc_buf_pos=0;
   }
@@ -349,7 +453,7 @@ static uint16_t _i2s_write_buffer(const int16_t *frames, uint16_t frame_count, b
     while(frame_count>0) {
    
         // make sure we have room in the current buffer
-        if (tx->curr_slc_buf_pos==SLC_BUF_LEN || tx->curr_slc_buf==NULL) {
+        if (tx->curr_slc_buf_pos==_slc_buf_len || tx->curr_slc_buf==NULL) {
             // no room in the current buffer? if there are no buffers available then exit
             if (tx->slc_queue_len == 0)
             {
@@ -370,13 +474,13 @@ static uint16_t _i2s_write_buffer(const int16_t *frames, uint16_t frame_count, b
             
             // get a new buffer
             ETS_SLC_INTR_DISABLE();
-            tx->curr_slc_buf = (uint32_t *)i2s_slc_queue_next_item(tx);
+            tx->curr_slc_buf = i2s_slc_queue_take(tx);
             ETS_SLC_INTR_ENABLE();
             tx->curr_slc_buf_pos=0;
         }       
 
         //space available in the current buffer
-        uint16_t	available = SLC_BUF_LEN - tx->curr_slc_buf_pos;
+        uint16_t	available = _slc_buf_len - tx->curr_slc_buf_pos;
 
         uint16_t fc = (available < frame_count) ? available : frame_count;
 
@@ -409,11 +513,55 @@ uint16_t i2s_write_buffer_nb(const int16_t *frames, uint16_t frame_count) { retu
 
 uint16_t i2s_write_buffer(const int16_t *frames, uint16_t frame_count) { return _i2s_write_buffer(frames, frame_count, false, false); }
 
+// Zero-copy access: hand out a whole DMA buffer.  While the application
+// owns it, curr_slc_buf points to it with no room left, so the sample based
+// calls move on to the next buffer instead of writing into it.
+static uint32_t *_i2s_get_buffer(i2s_state_t *ch, bool blocking) {
+  if (!ch || ch->loop) {
+    return NULL;
+  }
+  if (ch->slc_queue_len == 0) {
+    if (!blocking) {
+      return NULL;
+    }
+    while (ch->slc_queue_len == 0) {
+      optimistic_yield(10000);
+    }
+  }
+  ETS_SLC_INTR_DISABLE();
+  ch->curr_slc_buf = i2s_slc_queue_take(ch);
+  ETS_SLC_INTR_ENABLE();
+  ch->curr_slc_buf_pos = _slc_buf_len;
+  return ch->curr_slc_buf;
+}
+
+static void _i2s_commit_buffer(i2s_state_t *ch, const uint32_t *buf) {
+  if (ch && buf && ch->curr_slc_buf == buf) {
+    ch->curr_slc_buf = NULL;
+  }
+}
+
+uint32_t *i2s_tx_get_buffer(bool blocking) {
+  return _i2s_get_buffer(tx, blocking);
+}
+
+void i2s_tx_commit(uint32_t *buf) {
+  _i2s_commit_buffer(tx, buf);
+}
+
+const uint32_t *i2s_rx_get_buffer(bool blocking) {
+  return _i2s_get_buffer(rx, blocking);
+}
+
+void i2s_rx_release(const uint32_t *buf) {
+  _i2s_commit_buffer(rx, buf);
+}
+
 bool i2s_read_sample(int16_t *left, int16_t *right, bool blocking) {
   if (!rx) {
     return false;
   }
-  if (rx->curr_slc_buf_pos==SLC_BUF_LEN || rx->curr_slc_buf==NULL) {
+  if (rx->curr_slc_buf_pos==_slc_buf_len || rx->curr_slc_buf==NULL) {
     if (rx->slc_queue_len == 0) {
       if (!blocking) {
         return false;
@@ -427,7 +575,7 @@ bool i2s_read_sample(int16_t *left, int16_t *right, bool blocking) {
       }
     }
     ETS_SLC_INTR_DISABLE();
-    rx->curr_slc_buf = (uint32_t *)i2s_slc_queue_next_item(rx);
+    rx->curr_slc_buf = i2s_slc_queue_take(rx);
     ETS_SLC_INTR_ENABLE();
     rx->curr_slc_buf_pos=0;
   }
@@ -579,7 +727,7 @@ bool i2s_rxtxdrive_begin(bool enableRx, bool enableTx, bool driveRxClocks, bool
 
   if (rx) {
     // Need to prime the # of samples to receive in the engine
-    I2SRXEN = SLC_BUF_LEN;
+    I2SRXEN = _slc_buf_len;
   }
 
   I2SC |= (rx?I2SRXS:0) | (tx?I2STXS:0); // Start transmission/reception
@@ -591,6 +739,57 @@ void i2s_begin() {
   i2s_rxtx_begin(false, true);
 }
 
+// The TX ring holds _slc_buf_cnt * _slc_buf_len frames.  In loop mode the
+// EOF interrupt is left off, so the buffers are never zeroed or handed
+// back to the writer and the DMA keeps sending the same pattern forever.
+#define I2S_PWM_FRAMES (_slc_buf_cnt * _slc_buf_len)
+
+static uint16_t _i2s_pwm_steps;
+
+bool i2s_pwm_begin(uint32_t freq, uint16_t steps) {
+  if (_i2s_bits != 16 || freq == 0 || steps < 2 || (steps & (steps - 1)) || (I2S_PWM_FRAMES % steps)) {
+    return false;
+  }
+  if (!i2s_rxtx_begin(false, true)) {
+    return false;
+  }
+  ETS_SLC_INTR_DISABLE();
+  SLCIE = 0;
+  SLCIC = 0xFFFFFFFF;
+  tx->loop = true;
+  ETS_SLC_INTR_ENABLE();
+  _i2s_pwm_steps = steps;
+  i2s_set_rate(freq * steps);
+  return true;
+}
+
+void i2s_pwm_write(uint32_t channels, uint16_t duty) {
+  if (!tx || !tx->loop) {
+    return;
+  }
+  for (int f = 0; f < I2S_PWM_FRAMES; f++) {
+    uint32_t *frame = &tx->slc_buf_pntr[f / _slc_buf_len][f % _slc_buf_len];
+    if ((f & (_i2s_pwm_steps - 1)) < duty) {
+      *frame |= channels;
+    } else {
+      *frame &= ~channels;
+    }
+  }
+}
+
+void i2s_pwm_write_serial(uint32_t duty) {
+  if (!tx || !tx->loop) {
+    return;
+  }
+  // Frames go out MSB first, so a partial frame is filled from bit 31 down
+  const uint32_t full = duty / 32;
+  const uint32_t partial = (duty % 32) ? ~0UL << (32 - duty % 32) : 0;
+  for (int f = 0; f < I2S_PWM_FRAMES; f++) {
+    const uint32_t pos = f & (_i2s_pwm_steps - 1);
+    tx->slc_buf_pntr[f / _slc_buf_len][f % _slc_buf_len] = (pos < full) ? 0xFFFFFFFF : (pos == full) ? partial : 0;
+  }
+}
+
 void i2s_end() {
   // Disable any I2S send or receive
   // ? Maybe not needed since we're resetting on the next line...
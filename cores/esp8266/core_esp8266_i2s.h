@@ -43,10 +43,29 @@ speed.
 extern "C" {
 #endif
 
+// Counters kept by the DMA interrupt, in units of whole DMA buffers.
+// For TX an xrun is an underrun: the DMA got to a buffer that had not been
+// refilled and sent silence.  For RX it is an overrun: a received buffer
+// was overwritten before being read.  The wait times are the CPU cycles
+// between the interrupt handing a buffer to the queue and the application
+// taking it, the queue high water mark is the most buffers waiting at once
+// (sent and free for TX, received and unread for RX).
+typedef struct {
+  uint32_t xruns;
+  uint32_t xrun_samples;
+  uint32_t last_xrun_cycles; // ESP.getCycleCount() at the last xrun
+  uint32_t wait_last_cycles;
+  uint32_t wait_max_cycles;
+  uint8_t  queue_high_water;
+} i2s_stats_t;
+
 bool i2s_set_bits(int bits); // Set bits per sample, only 16 or 24 supported.  Call before begin.
 // Note that in 24 bit mode each sample must be left-aligned (i.e. 0x00000000 .. 0xffffff00) as the
 // hardware shifts starting at bit 31, not bit 23.
 
+bool i2s_set_buffers(uint8_t count, uint16_t len); // DMA ring of 'count' (2...16) buffers of 'len' (16...1023) samples, call before begin.  Default 8 x 64.
+uint16_t i2s_buffer_len(); // Samples per DMA buffer
+
 void i2s_begin(); // Enable TX only, for compatibility
 bool i2s_rxtx_begin(bool enableRx, bool enableTx); // Allow TX and/or RX, returns false on OOM error
 bool i2s_rxtxdrive_begin(bool enableRx, bool enableTx, bool driveRxClocks, bool driveTxClocks);
@@ -64,6 +83,14 @@ bool i2s_rx_is_full();
 bool i2s_rx_is_empty();
 uint16_t i2s_available();// returns the number of samples than can be written before blocking
 uint16_t i2s_rx_available();// returns the number of samples than can be written before blocking
+bool i2s_get_stats(i2s_stats_t *stats); // TX counters, false if TX is not running
+bool i2s_rx_get_stats(i2s_stats_t *stats);
+void i2s_reset_stats();
+// Set a function that refills each TX buffer from the DMA interrupt (so it must be in IRAM),
+// right after the buffer has been sent and a whole ring ahead of it going out again.  The
+// buffers are not zeroed and not offered to i2s_write_sample() and friends while it is set.
+// Set it before begin to also fill the initial buffers.  Pass NULL to go back to the queue.
+void i2s_set_refill_callback(void (*refill) (uint32_t *buf, uint16_t words));
 void i2s_set_callback(void (*callback) (void));
 void i2s_rx_set_callback(void (*callback) (void));
 
@@ -74,6 +101,34 @@ uint16_t i2s_write_buffer_mono_nb(const int16_t *frames, uint16_t frame_count);
 uint16_t i2s_write_buffer(const int16_t *frames, uint16_t frame_count);
 uint16_t i2s_write_buffer_nb(const int16_t *frames, uint16_t frame_count);
 
+// Zero-copy access to the DMA ring, one whole buffer of i2s_buffer_len() samples at a time.
+// i2s_tx_get_buffer() returns the next free TX buffer (NULL when none is free and !blocking),
+// fill all of it and give it back with i2s_tx_commit() before the DMA gets there, that is
+// within (count - 1) buffer periods.  i2s_rx_get_buffer() returns the oldest received buffer,
+// which stays valid until i2s_rx_release() or until the DMA wraps around to it again.
+// Unused TX buffers are zeroed by the core, so an underflow outputs silence.
+uint32_t *i2s_tx_get_buffer(bool blocking);
+void i2s_tx_commit(uint32_t *buf);
+const uint32_t *i2s_rx_get_buffer(bool blocking);
+void i2s_rx_release(const uint32_t *buf);
+
+// PWM through the DMA engine, no CPU time is used once the pattern is set.
+// i2s_pwm_begin() starts TX with a repeating pattern of 'steps' frames per
+// PWM period ('steps' a power of 2 that divides the ring, so 2...512 with the
+// default buffers, 16 bit mode only).  The frame
+// rate is freq * steps, so 256 steps give at most ~19kHz.
+// With one or more chained 74HC595 on DATA (SER), BCK (SRCLK) and WS (RCLK),
+// every bit of the 32 bit frame is a PWM channel: i2s_pwm_write() sets the
+// duty (0...steps) of all frame bits in the 'channels' mask.  Without a shift
+// register, i2s_pwm_write_serial() uses the DATA pin alone at bit resolution
+// (duty 0...steps*32).  The pattern is updated in place, so the period being
+// sent while it changes can show a mix of the old and the new duty.
+// i2s_write_sample() and friends are disabled in this mode, use i2s_end()
+// and i2s_begin() to go back to streaming.
+bool i2s_pwm_begin(uint32_t freq, uint16_t steps);
+void i2s_pwm_write(uint32_t channels, uint16_t duty);
+void i2s_pwm_write_serial(uint32_t duty);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,77 @@
+/*
+ core_esp8266_loopstats.h - loop() and yield gap timing histograms
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __CORE_ESP8266_LOOPSTATS_H
+#define __CORE_ESP8266_LOOPSTATS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+  Histograms kept by core_esp8266_main.cpp once loopstats_begin() is
+  called, nothing is measured (or allocated) before.  Bucket i counts
+  durations from 2^i to 2^(i+1)-1 us, bucket 0 also counts 0 us and the
+  last bucket everything longer.
+
+  loop:      one loop() call, with the yields inside it
+  gap:       the sketch side kept the CPU, from getting it back from the
+             SDK to the next yield() / delay() or the end of loop().  The
+             SDK needs a gap to end well before the WiFi stack starves.
+  scheduled: one pass of run_scheduled_functions() after loop()
+*/
+
+#define LOOPSTATS_BUCKETS 21
+
+typedef struct loopstats_histogram_ {
+    uint32_t count[LOOPSTATS_BUCKETS];
+    uint32_t max_us;
+} loopstats_histogram_t;
+
+typedef struct loopstats_ {
+    loopstats_histogram_t loop;
+    loopstats_histogram_t gap;
+    loopstats_histogram_t scheduled;
+} loopstats_t;
+
+// Called from the sketch context when a gap ended after more than the
+// alarm threshold.  `where` is the return address of the yield() /
+// delay() call that ended it, NULL when it ended with loop() returning.
+typedef void (*loopstats_alarm_t)(uint32_t gap_us, const void* where);
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+bool loopstats_begin(void);
+void loopstats_end(void);
+void loopstats_reset(void);
+// NULL unless started
+const loopstats_t* loopstats_get(void);
+// 0 disables the alarm
+void loopstats_set_alarm(uint32_t gap_us, loopstats_alarm_t alarm);
+
+#ifdef __cplusplus
+}
+
+#include <Print.h>
+// One line per histogram with the non-empty buckets as <bucket start us>:<count>
+size_t loopstats_print(Print& out);
+#endif
+
+#endif // __CORE_ESP8266_LOOPSTATS_H
@@ -39,10 +39,21 @@ extern "C" {
 #include <umm_malloc/umm_malloc.h>
 #include <core_esp8266_non32xfer.h>
 #include "core_esp8266_vm.h"
+#include "core_esp8266_loopstats.h"
+#include "core_esp8266_governor.h"
+#include "core_esp8266_fastboot.h"
 
 #define LOOP_TASK_PRIORITY 1
 #define LOOP_QUEUE_SIZE    1
 
+/* The fast lane task, one event per schedule_fast_function() call.
+ * It uses the top SDK user task priority, which sketches must leave free.
+ */
+#define FAST_TASK_PRIORITY USER_TASK_PRIO_2
+#ifndef FAST_QUEUE_SIZE
+#define FAST_QUEUE_SIZE    8
+#endif
+
 extern "C" void call_user_start();
 extern void loop();
 extern void setup();
@@ -61,9 +72,32 @@ cont_t* g_pcont __attribute__((section(".noinit")));
 /* Event queue used by the main (arduino) task */
 static os_event_t s_loop_queue[LOOP_QUEUE_SIZE];
 
+/* Event queue of the fast lane task */
+static os_event_t s_fast_queue[FAST_QUEUE_SIZE];
+
 /* Used to implement optimistic_yield */
 static uint32_t s_cycles_at_yield_start;
 
+/* Timing histograms, allocated by loopstats_begin() */
+static loopstats_t* s_loopstats = nullptr;
+static uint32_t s_loopstats_alarm_cycles = 0;
+static loopstats_alarm_t s_loopstats_alarm = nullptr;
+
+static struct {
+    bool on;
+    uint8_t up_percent;
+    uint8_t down_percent;
+    uint8_t boosts;
+    uint32_t window_us;
+    uint32_t window_start;
+    uint32_t busy_us;
+} s_governor;
+
+#define GOVERNOR_BUSY_US 500
+
+// core_esp8266_si2c.cpp, when linked in
+extern "C" void twi_cpuFreqChanged(uint8_t mhz) __attribute__((weak));
+
 /* For ets_intr_lock_nest / ets_intr_unlock_nest
  * Max nesting seen by SDK so far is 2.
  */
@@ -87,6 +121,9 @@ void initVariant() {
 }
 
 extern "C" void __preloop_update_frequency() {
+    if (s_governor.on) {
+        return;
+    }
 #if defined(F_CPU) && (F_CPU == 160000000L)
     ets_update_cpu_frequency(160);
     CPU2X |= 1UL;
@@ -109,8 +146,28 @@ extern "C" bool can_yield() {
   return cont_can_yield(g_pcont);
 }
 
+static void loopstats_add(loopstats_histogram_t& histogram, uint32_t us) {
+    const uint32_t bucket = us ? 31 - __builtin_clz(us) : 0;
+    ++histogram.count[bucket < LOOPSTATS_BUCKETS ? bucket : LOOPSTATS_BUCKETS - 1];
+    if (us > histogram.max_us) {
+        histogram.max_us = us;
+    }
+}
+
+// The sketch gives the CPU back to the SDK, the gap since s_cycles_at_yield_start ends
+static void loopstats_gap_end(const void* where) {
+    const uint32_t cycles = ESP.getCycleCount() - s_cycles_at_yield_start;
+    loopstats_add(s_loopstats->gap, cycles / ESP.getCpuFreqMHz());
+    if (s_loopstats_alarm && cycles > s_loopstats_alarm_cycles) {
+        s_loopstats_alarm(cycles / ESP.getCpuFreqMHz(), where);
+    }
+}
+
 static inline void esp_yield_within_cont() __attribute__((always_inline));
 static void esp_yield_within_cont() {
+        if (s_loopstats) {
+            loopstats_gap_end(__builtin_return_address(0));
+        }
         cont_yield(g_pcont);
         s_cycles_at_yield_start = ESP.getCycleCount();
         run_scheduled_recurrent_functions();
@@ -128,7 +185,18 @@ extern "C" IRAM_ATTR void esp_schedule() {
     ets_post(LOOP_TASK_PRIORITY, 0, 0);
 }
 
+// Coroutine.cpp replaces this when linked in, so that yield() inside a
+// coroutine switches back to the code that resumed it
+extern "C" bool __coroutine_yield() {
+    return false;
+}
+
+extern "C" bool coroutine_yield() __attribute__ ((weak, alias("__coroutine_yield")));
+
 extern "C" void __yield() {
+    if (coroutine_yield()) {
+        return;
+    }
     if (can_yield()) {
         esp_schedule();
         esp_yield_within_cont();
@@ -184,7 +252,13 @@ extern "C" bool IRAM_ATTR ets_post(uint8 prio, ETSSignal sig, ETSParam par) {
 
 extern "C" void __loop_end (void)
 {
-    run_scheduled_functions();
+    if (s_loopstats) {
+        const uint32_t start = micros();
+        run_scheduled_functions();
+        loopstats_add(s_loopstats->scheduled, micros() - start);
+    } else {
+        run_scheduled_functions();
+    }
     run_scheduled_recurrent_functions();
 }
 
@@ -194,10 +268,18 @@ static void loop_wrapper() {
     static bool setup_done = false;
     preloop_update_frequency();
     if(!setup_done) {
+        boot_mark(BOOT_MARK_SETUP);
         setup();
         setup_done = true;
+        boot_mark(BOOT_MARK_LOOP);
+    }
+    if (s_loopstats) {
+        const uint32_t start = micros();
+        loop();
+        loopstats_add(s_loopstats->loop, micros() - start);
+    } else {
+        loop();
     }
-    loop();
     loop_end();
     if (serialEventRun) {
         serialEventRun();
@@ -205,16 +287,189 @@ static void loop_wrapper() {
     esp_schedule();
 }
 
+static void fast_task(os_event_t *events) {
+    reinterpret_cast<scheduled_fnptr_t>(events->sig)(reinterpret_cast<void*>(events->par));
+}
+
+IRAM_ATTR // called from ISR
+bool schedule_fast_function(scheduled_fnptr_t fn, void* arg) {
+    return fn && system_os_post(FAST_TASK_PRIORITY,
+        reinterpret_cast<os_signal_t>(fn), reinterpret_cast<os_param_t>(arg));
+}
+
+static void governor_set_mhz(uint8_t mhz) {
+    if (system_get_cpu_freq() == mhz) {
+        return;
+    }
+    system_update_cpu_freq(mhz);
+    if (twi_cpuFreqChanged) {
+        twi_cpuFreqChanged(mhz);
+    }
+}
+
+static void governor_account(uint32_t now, uint32_t run_us) {
+    // A loop() polling at full speed hands the CPU back every few us, it
+    // is not load: only stretches without a yield count
+    if (run_us >= GOVERNOR_BUSY_US) {
+        s_governor.busy_us += run_us;
+    }
+    const uint32_t elapsed = now - s_governor.window_start;
+    if (elapsed < s_governor.window_us) {
+        return;
+    }
+    const uint32_t percent = (uint64_t)s_governor.busy_us * 100 / elapsed;
+    if (s_governor.boosts || percent >= s_governor.up_percent) {
+        governor_set_mhz(160);
+    } else if (percent <= s_governor.down_percent) {
+        governor_set_mhz(80);
+    }
+    s_governor.window_start = now;
+    s_governor.busy_us = 0;
+}
+
 static void loop_task(os_event_t *events) {
     (void) events;
     s_cycles_at_yield_start = ESP.getCycleCount();
     ESP.resetHeap();
+    const bool governed = s_governor.on;
+    const uint32_t start = governed ? system_get_time() : 0;
     cont_run(g_pcont, &loop_wrapper);
+    if (governed && s_governor.on) {
+        const uint32_t now = system_get_time();
+        governor_account(now, now - start);
+    }
+    if (s_loopstats) {
+        loopstats_gap_end(nullptr);
+    }
     ESP.setDramHeap();
     if (cont_check(g_pcont) != 0) {
         panic();
     }
 }
+
+extern "C" bool loopstats_begin(void) {
+    if (!s_loopstats) {
+        s_loopstats = static_cast<loopstats_t*>(calloc(1, sizeof(loopstats_t)));
+    }
+    return s_loopstats != nullptr;
+}
+
+extern "C" void loopstats_end(void) {
+    loopstats_t* stats = s_loopstats;
+    s_loopstats = nullptr;
+    free(stats);
+}
+
+extern "C" void loopstats_reset(void) {
+    if (s_loopstats) {
+        memset(s_loopstats, 0, sizeof(loopstats_t));
+    }
+}
+
+extern "C" const loopstats_t* loopstats_get(void) {
+    return s_loopstats;
+}
+
+extern "C" void loopstats_set_alarm(uint32_t gap_us, loopstats_alarm_t alarm) {
+    s_loopstats_alarm_cycles = gap_us * ESP.getCpuFreqMHz();
+    s_loopstats_alarm = gap_us ? alarm : nullptr;
+}
+
+extern "C" bool cpu_governor_begin(uint8_t up_percent, uint8_t down_percent, uint32_t window_ms) {
+#if defined(F_CPU) && (F_CPU != 80000000L)
+    (void) up_percent;
+    (void) down_percent;
+    (void) window_ms;
+    return false;
+#else
+    s_governor.up_percent = up_percent;
+    s_governor.down_percent = down_percent;
+    s_governor.window_us = window_ms * 1000;
+    s_governor.window_start = system_get_time();
+    s_governor.busy_us = 0;
+    s_governor.on = true;
+    return true;
+#endif
+}
+
+extern "C" void cpu_governor_end(void) {
+    if (s_governor.on) {
+        s_governor.on = false;
+        governor_set_mhz(80);
+    }
+}
+
+extern "C" void cpu_boost_begin(void) {
+    ++s_governor.boosts;
+    if (s_governor.on) {
+        governor_set_mhz(160);
+    }
+}
+
+// The next window decides, so back to back boosts do not switch each time
+extern "C" void cpu_boost_end(void) {
+    if (s_governor.boosts) {
+        --s_governor.boosts;
+    }
+}
+
+size_t loopstats_print(Print& out) {
+    if (!s_loopstats) {
+        return 0;
+    }
+    const struct {
+        const char* name;
+        const loopstats_histogram_t& histogram;
+    } rows[] = {
+        { PSTR("loop"), s_loopstats->loop },
+        { PSTR("gap"), s_loopstats->gap },
+        { PSTR("scheduled"), s_loopstats->scheduled },
+    };
+    size_t n = 0;
+    for (const auto& row : rows) {
+        n += out.printf_P(PSTR("%S max %u us:"), row.name, row.histogram.max_us);
+        for (uint32_t i = 0; i < LOOPSTATS_BUCKETS; ++i) {
+            if (row.histogram.count[i]) {
+                n += out.printf_P(PSTR(" %u:%u"), i ? 1U << i : 0U, row.histogram.count[i]);
+            }
+        }
+        n += out.println();
+    }
+    return n;
+}
+
+boot_profile_t boot_profile __attribute__((section(".noinit")));
+
+uint32_t boot_profile_us(int mark) {
+    const uint32_t cycles = boot_profile.cycles[mark];
+    if (!cycles) {
+        return 0;
+    }
+    if (mark <= BOOT_MARK_SETUP) {
+        return cycles / 80;
+    }
+    const uint32_t setup = boot_profile.cycles[BOOT_MARK_SETUP];
+    return setup / 80 + (cycles - setup) / esp_get_cpu_freq_mhz();
+}
+
+size_t boot_profile_print(Print& out) {
+    static const char names[BOOT_MARKS][10] PROGMEM = {
+        "app_entry", "rf_init", "user_init", "init", "variant",
+        "init_done", "ctors", "setup", "loop",
+    };
+    size_t n = out.print(F("boot"));
+    for (int i = 0; i < BOOT_MARKS; ++i) {
+        if (boot_profile.cycles[i]) {
+            n += out.printf_P(PSTR(" %S:%u"), names[i], boot_profile_us(i));
+        }
+    }
+    if (fastboot_rf_cal_skipped()) {
+        n += out.print(F(" (no RF cal)"));
+    }
+    n += out.println();
+    return n;
+}
+
 extern "C" {
 
 struct object { long placeholder[ 10 ]; };
@@ -260,7 +515,9 @@ void init_done() {
     system_set_os_print(1);
     gdb_init();
     std::set_terminate(__unhandled_exception_cpp);
+    boot_mark(BOOT_MARK_INIT_DONE);
     do_global_ctors();
+    boot_mark(BOOT_MARK_CTORS);
     esp_schedule();
     ESP.setDramHeap();
 }
@@ -325,6 +582,11 @@ static void app_entry_custom (void) __attribute__((weakref("app_entry_redefinabl
 
 extern "C" void app_entry (void)
 {
+    // no memset() yet, it is in flash
+    for (volatile uint32_t& cycles : boot_profile.cycles) {
+        cycles = 0;
+    }
+    boot_mark(BOOT_MARK_APP_ENTRY);
     umm_init();
     return app_entry_custom();
 }
@@ -347,16 +609,19 @@ extern "C" void __disableWiFiAtBootTime (void)
 }
 
 extern "C" void user_init(void) {
+    boot_mark(BOOT_MARK_USER_INIT);
     struct rst_info *rtc_info_ptr = system_get_rst_info();
     memcpy((void *) &resetInfo, (void *) rtc_info_ptr, sizeof(resetInfo));
 
     uart_div_modify(0, UART_CLK_FREQ / (115200));
 
     init(); // in core_esp8266_wiring.c, inits hw regs and sdk timer
+    boot_mark(BOOT_MARK_INIT);
 
     initVariant();
 
     experimental::initFlashQuirks(); // Chip specific flash init.
+    boot_mark(BOOT_MARK_VARIANT);
 
     cont_init(g_pcont);
 
@@ -381,6 +646,9 @@ extern "C" void user_init(void) {
     ets_task(loop_task,
         LOOP_TASK_PRIORITY, s_loop_queue,
         LOOP_QUEUE_SIZE);
+    system_os_task(fast_task,
+        FAST_TASK_PRIORITY, s_fast_queue,
+        FAST_QUEUE_SIZE);
 
     system_init_done_cb(&init_done);
 }
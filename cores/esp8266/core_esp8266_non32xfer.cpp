@@ -60,6 +60,70 @@ extern "C" {
 
 static fn_c_exception_handler_t old_c_handler = NULL;
 
+#ifdef DEBUG_ESP_MMU
+/* Trapped accesses per faulting instruction, to find the code worth moving
+   to mmu_get_uint8()/mmu_memcpy() and friends. */
+#define NON32XFER_SITES 16
+static non32xfer_site_t non32xfer_sites[NON32XFER_SITES];
+static uint32_t non32xfer_total;
+
+static inline IRAM_ATTR void non32xfer_count(uint32_t pc)
+{
+  ++non32xfer_total;
+  for (size_t i = 0; i < NON32XFER_SITES; i++) {
+    if (non32xfer_sites[i].pc == pc) {
+      ++non32xfer_sites[i].count;
+      return;
+    }
+    if (non32xfer_sites[i].count == 0) {
+      non32xfer_sites[i].pc = pc;
+      non32xfer_sites[i].count = 1;
+      return;
+    }
+  }
+  /* table full, only the total is kept */
+}
+
+size_t non32xfer_get_stats(non32xfer_site_t *sites, size_t max, uint32_t *total)
+{
+  size_t n = 0;
+  uint32_t ps = xt_rsil(15);
+  for (size_t i = 0; i < NON32XFER_SITES && non32xfer_sites[i].count; i++) {
+    if (n < max) {
+      sites[n] = non32xfer_sites[i];
+    }
+    ++n;
+  }
+  if (total) {
+    *total = non32xfer_total;
+  }
+  xt_wsr_ps(ps);
+  return n;
+}
+
+void non32xfer_reset_stats(void)
+{
+  uint32_t ps = xt_rsil(15);
+  memset(non32xfer_sites, 0, sizeof(non32xfer_sites));
+  non32xfer_total = 0;
+  xt_wsr_ps(ps);
+}
+#else
+size_t non32xfer_get_stats(non32xfer_site_t *sites, size_t max, uint32_t *total)
+{
+  (void)sites;
+  (void)max;
+  if (total) {
+    *total = 0;
+  }
+  return 0;
+}
+
+void non32xfer_reset_stats(void)
+{
+}
+#endif
+
 static
 IRAM_ATTR void non32xfer_exception_handler(struct __exception_frame *ef, int cause)
 {
@@ -101,6 +165,9 @@ IRAM_ATTR void non32xfer_exception_handler(struct __exception_frame *ef, int cau
     } else {
       continue;  /* fail */
     }
+#endif
+#ifdef DEBUG_ESP_MMU
+    non32xfer_count(ef->epc);
 #endif
     {
       uint32_t *pWord = (uint32_t *)(excvaddr & ~0x3);
@@ -1,12 +1,29 @@
 #ifndef __CORE_ESP8266_NON32XFER_H
 #define __CORE_ESP8266_NON32XFER_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 extern void install_non32xfer_exception_handler();
 
+/*
+  With DEBUG_ESP_MMU, byte/short accesses trapped by the handler are counted
+  per faulting instruction (first 16 sites).  Fills up to max entries and
+  returns the number of sites recorded; total gets all trapped accesses.
+  Without DEBUG_ESP_MMU nothing is recorded.
+ */
+typedef struct {
+  uint32_t pc;
+  uint32_t count;
+} non32xfer_site_t;
+
+extern size_t non32xfer_get_stats(non32xfer_site_t *sites, size_t max, uint32_t *total);
+extern void non32xfer_reset_stats(void);
+
 
     /*
        In adapting the public domain version, a crash would come or go away with
@@ -33,13 +33,80 @@
 extern "C" {
 
 char* ltoa(long value, char* result, int base) {
+    if (base == 10) {
+        char buf[12];
+        char* first = ulltoa_dec(value < 0 ? -(unsigned long)value : value, buf + sizeof(buf));
+        if (value < 0) {
+            *--first = '-';
+        }
+        const size_t len = buf + sizeof(buf) - first;
+        memcpy(result, first, len);
+        result[len] = 0;
+        return result;
+    }
     return itoa((int)value, result, base);
 }
 
 char* ultoa(unsigned long value, char* result, int base) {
+    if (base == 10) {
+        char buf[10];
+        char* first = ulltoa_dec(value, buf + sizeof(buf));
+        const size_t len = buf + sizeof(buf) - first;
+        memcpy(result, first, len);
+        result[len] = 0;
+        return result;
+    }
     return utoa((unsigned int)value, result, base);
 }
 
+static const uint32_t pow10_32[] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
+
+// prec <= 9 and number below 2^64: the integer part and the fraction
+// scaled by 10^prec are printed with integer divisions only
+static char* dtostrf_fixed(double number, bool negative, signed char width, unsigned char prec, char* s) {
+    char buf[32];
+    char* end = buf + sizeof(buf);
+    char* first = end;
+    uint64_t ip;
+    double frac;
+
+    if (number < 4294967296.0) {
+        const uint32_t ip32 = (uint32_t)number;
+        ip = ip32;
+        frac = number - ip32;
+    } else {
+        ip = (uint64_t)number;
+        frac = number - ip;
+    }
+    uint32_t fp = (uint32_t)(frac * pow10_32[prec] + 0.5);
+    if (fp >= pow10_32[prec]) {
+        fp -= pow10_32[prec];
+        ip++;
+    }
+    if (prec) {
+        first = ulltoa_dec(fp, end);
+        while (end - first < prec) {
+            *--first = '0';
+        }
+        *--first = '.';
+    }
+    first = ulltoa_dec(ip, first);
+    if (negative) {
+        *--first = '-';
+    }
+
+    char* out = s;
+    int fillme = width - (end - first);
+    while (fillme-- > 0) {
+        *out++ = ' ';
+    }
+    memcpy(out, first, end - first);
+    out[end - first] = 0;
+    return s;
+}
+
 char * dtostrf(double number, signed char width, unsigned char prec, char *s) {
     bool negative = false;
 
@@ -52,6 +119,11 @@ char * dtostrf(double number, signed char width, unsigned char prec, char *s) {
         return s;
     }
 
+    if (prec < sizeof(pow10_32) / sizeof(pow10_32[0]) && fabs(number) < 1.8e19) {
+        return dtostrf_fixed(fabs(number), number < 0.0, width, prec, s);
+    }
+
+    // larger numbers and precisions, digit by digit
     char* out = s;
 
     int fillme = width; // how many cells to fill for the integer part
@@ -0,0 +1,123 @@
+/*
+ core_esp8266_pgmspace.cpp - word-wise bulk reads of PROGMEM data
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <string.h>
+#include "core_esp8266_pgmspace.h"
+
+#if defined(__SANITIZE_ADDRESS__)
+// Reads whole words around the data, as the device must
+__attribute__((no_sanitize_address))
+#endif
+static inline uint32_t pgm_word(uintptr_t addr)
+{
+    return pgm_read_dword(reinterpret_cast<const uint32_t*>(addr));
+}
+
+extern "C" void* memcpy_P_bulk(void* dest, PGM_VOID_P src, size_t n)
+{
+    uint8_t* d = static_cast<uint8_t*>(dest);
+    uintptr_t s = reinterpret_cast<uintptr_t>(src);
+
+    const uint32_t offset = s & 3;
+    if (offset && n) {
+        // bytes up to the first word boundary (little endian: low byte first)
+        uint32_t w = pgm_word(s - offset) >> (8 * offset);
+        size_t head = 4 - offset;
+        if (head > n) {
+            head = n;
+        }
+        n -= head;
+        s += head;
+        while (head--) {
+            *d++ = w;
+            w >>= 8;
+        }
+    }
+
+    if ((reinterpret_cast<uintptr_t>(d) & 3) == 0) {
+        for (; n >= 4; n -= 4, s += 4, d += 4) {
+            const uint32_t w = pgm_word(s);
+            memcpy(__builtin_assume_aligned(d, 4), &w, 4);
+        }
+    } else {
+        for (; n >= 4; n -= 4, s += 4, d += 4) {
+            const uint32_t w = pgm_word(s);
+            d[0] = w;
+            d[1] = w >> 8;
+            d[2] = w >> 16;
+            d[3] = w >> 24;
+        }
+    }
+
+    if (n) {
+        uint32_t w = pgm_word(s);
+        while (n--) {
+            *d++ = w;
+            w >>= 8;
+        }
+    }
+    return dest;
+}
+
+extern "C" int strcmp_P_bulk(const char* str1, PGM_P str2P)
+{
+    const uint8_t* a = reinterpret_cast<const uint8_t*>(str1);
+    uintptr_t s = reinterpret_cast<uintptr_t>(str2P);
+    const uint32_t offset = s & 3;
+    s -= offset;
+    // The word holding the terminating NUL is read entirely, which is
+    // fine: it cannot cross into unmapped flash.
+    uint32_t w = pgm_word(s) >> (8 * offset);
+    uint32_t left = 4 - offset;
+    for (;;) {
+        const uint8_t b = w;
+        const uint8_t c = *a++;
+        if (c != b || !c) {
+            return c - b;
+        }
+        if (--left) {
+            w >>= 8;
+        } else {
+            s += 4;
+            w = pgm_word(s);
+            left = 4;
+        }
+    }
+}
+
+extern "C" PGM_VOID_P pgm_table_lookup(const char* key, PGM_VOID_P table, size_t count, size_t stride)
+{
+    const uint8_t* base = static_cast<const uint8_t*>(table);
+    size_t lo = 0;
+    size_t hi = count;
+    while (lo < hi) {
+        const size_t mid = (lo + hi) / 2;
+        const uint8_t* entry = base + mid * stride;
+        const int cmp = strcmp_P_bulk(key, static_cast<PGM_P>(pgm_read_ptr(entry)));
+        if (cmp == 0) {
+            return entry;
+        }
+        if (cmp < 0) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return nullptr;
+}
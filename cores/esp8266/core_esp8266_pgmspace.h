@@ -0,0 +1,63 @@
+/*
+ core_esp8266_pgmspace.h - word-wise bulk reads of PROGMEM data
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __CORE_ESP8266_PGMSPACE_H
+#define __CORE_ESP8266_PGMSPACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/pgmspace.h>
+
+/*
+  Flash can only be read 32 bits at a time.  pgm_read_byte() loads the
+  word holding the byte and extracts it, so a byte loop reads each word
+  four times.  These read every aligned word once and only split the
+  first and the last one.  Source and destination may have any alignment.
+*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// memcpy_P() reading each flash word once
+void* memcpy_P_bulk(void* dest, PGM_VOID_P src, size_t n);
+
+// strcmp_P() reading each flash word once: compares str1 (RAM) to str2P (PROGMEM)
+int strcmp_P_bulk(const char* str1, PGM_P str2P);
+
+/*
+  Binary search in a PROGMEM table of `count` entries, `stride` bytes
+  apart, each starting with a PGM_P key.  The table must be sorted by
+  strcmp() on the keys.  Returns the matching entry or NULL.
+*/
+PGM_VOID_P pgm_table_lookup(const char* key, PGM_VOID_P table, size_t count, size_t stride);
+
+#ifdef __cplusplus
+}
+
+// For a table of structs whose first member is the PGM_P key
+template <typename EntryT, size_t N>
+const EntryT* pgm_table_find(const char* key, const EntryT (&table)[N])
+{
+    static_assert(alignof(EntryT) >= alignof(PGM_P), "table entries must be word aligned");
+    return static_cast<const EntryT*>(pgm_table_lookup(key, table, N, sizeof(EntryT)));
+}
+#endif
+
+#endif // __CORE_ESP8266_PGMSPACE_H
@@ -27,6 +27,8 @@
 #include "ets_sys.h"
 #include "spi_flash.h"
 #include "user_interface.h"
+#include "esp8266_peri.h"
+#include "core_esp8266_fastboot.h"
 
 extern "C" {
 
@@ -296,8 +298,10 @@ static const uint8_t ICACHE_FLASH_ATTR phy_init_data[128] =
 #define __get_adc_mode _Z14__get_adc_modev
 #define __get_rf_mode _Z13__get_rf_modev
 #define __run_user_rf_pre_init _Z22__run_user_rf_pre_initv
+#define __get_fast_boot_block _Z21__get_fast_boot_blockv
 
 static bool spoof_init_data = false;
+static bool skip_rf_cal = false;
 
 extern int __real_spi_flash_read(uint32_t addr, uint32_t* dst, size_t size);
 extern int IRAM_ATTR __wrap_spi_flash_read(uint32_t addr, uint32_t* dst, size_t size);
@@ -311,6 +315,9 @@ extern int IRAM_ATTR __wrap_spi_flash_read(uint32_t addr, uint32_t* dst, size_t
 
     memcpy(dst, phy_init_data, sizeof(phy_init_data));
     ((uint8_t*)dst)[107] = __get_adc_mode();
+    if (skip_rf_cal) {
+        ((uint8_t*)dst)[114] = 0;
+    }
     return 0;
 }
 
@@ -332,8 +339,39 @@ extern void __run_user_rf_pre_init(void)
     return; // default do noting
 }
 
+extern int __get_fast_boot_block(void) __attribute__((weak));
+extern int __get_fast_boot_block(void)
+{
+    return -1;  // fast boot not used
+}
+
+// The FAST_BOOT() record, see core_esp8266_fastboot.h
+static volatile uint32_t* fastboot_record()
+{
+    const int block = __get_fast_boot_block();
+    if (block < 0 || block > 126) {
+        return nullptr;
+    }
+    return RTC_USER_MEM + block;
+}
+
+bool fastboot_rf_cal_skipped(void)
+{
+    return skip_rf_cal;
+}
+
+void fastboot_invalidate(void)
+{
+    volatile uint32_t* record = fastboot_record();
+    if (record) {
+        record[1] = 0;
+    }
+}
+
 uint32_t user_rf_cal_sector_set(void)
 {
+    volatile uint32_t* record = fastboot_record();
+    skip_rf_cal = record && (record[0] ^ record[1]) == FASTBOOT_MAGIC && record[0] < FASTBOOT_RECAL_BOOTS;
     spoof_init_data = true;
     return flashchip->chip_size/SPI_FLASH_SEC_SIZE - 4;
 }
@@ -341,7 +379,14 @@ uint32_t user_rf_cal_sector_set(void)
 void user_rf_pre_init()
 {
     // *((volatile uint32_t*) 0x60000710) = 0;
+    boot_mark(BOOT_MARK_RF_INIT);
     spoof_init_data = false;
+    volatile uint32_t* record = fastboot_record();
+    if (record) {
+        const uint32_t boots = skip_rf_cal ? record[0] + 1 : 0;
+        record[0] = boots;
+        record[1] = boots ^ FASTBOOT_MAGIC;
+    }
     volatile uint32_t* rtc_reg = (volatile uint32_t*) 0x60001000;
     rtc_reg[30] = 0;
 
@@ -33,6 +33,7 @@
 #include "gdb_hooks.h"
 #include "StackThunk.h"
 #include "coredecls.h"
+#include "core_esp8266_crashlog.h"
 
 extern "C" {
 
@@ -69,6 +70,8 @@ extern const char *umm_last_fail_alloc_file;
 extern int umm_last_fail_alloc_line;
 #endif
 
+unsigned long millis(void);
+
 static void raise_exception() __attribute__((noreturn));
 
 extern void __custom_crash_callback( struct rst_info * rst_info, uint32_t stack, uint32_t stack_end ) {
@@ -128,6 +131,14 @@ void __wrap_system_restart_local() {
 
     ets_install_putc1(&uart_write_char_d);
 
+    crashlog_record_t record;
+    memset(&record, 0, sizeof(record));
+    record.reason = rst_info.reason;
+    record.exccause = rst_info.exccause;
+    record.epc1 = rst_info.epc1;
+    record.excvaddr = rst_info.excvaddr;
+    record.uptime = millis();
+
     cut_here();
 
     if (s_panic_line) {
@@ -147,6 +158,7 @@ void __wrap_system_restart_local() {
         // The GCC divide routine in ROM jumps to the address below and executes ILL (00 00 00) on div-by-zero
         // In that case, print the exception as (6) which is IntegerDivZero
         bool div_zero = (rst_info.exccause == 0) && (rst_info.epc1 == 0x4000dce5);
+        record.exccause = div_zero ? 6 : rst_info.exccause;
         ets_printf_P(PSTR("\nException (%d):\nepc1=0x%08x epc2=0x%08x epc3=0x%08x excvaddr=0x%08x depc=0x%08x\n"),
             div_zero ? 6 : rst_info.exccause, rst_info.epc1, rst_info.epc2, rst_info.epc3, rst_info.excvaddr, rst_info.depc);
     }
@@ -157,6 +169,8 @@ void __wrap_system_restart_local() {
         ets_printf_P(PSTR("\nStack overflow detected.\n"));
         ets_printf_P(PSTR("\nException (%d):\nepc1=0x%08x epc2=0x%08x epc3=0x%08x excvaddr=0x%08x depc=0x%08x\n"),
             5 /* Alloca exception, closest thing to stack fault*/, s_stacksmash_addr, 0, 0, 0, 0);
+        record.exccause = 5;
+        record.epc1 = s_stacksmash_addr;
    }
     else {
         ets_printf_P(PSTR("\nGeneric Reset\n"));
@@ -186,6 +200,9 @@ void __wrap_system_restart_local() {
         // BearSSL we dump the BSSL second stack and then reset SP back to the main cont stack
         ets_printf_P(PSTR("\nctx: bearssl\nsp: %08x end: %08x offset: %04x\n"), sp_dump, stack_thunk_get_stack_top(), offset);
         print_stack(sp_dump + offset, stack_thunk_get_stack_top());
+        record.ctx = CRASHLOG_CTX_BEARSSL;
+        record.sp = sp_dump;
+        record.depth = crashlog_collect_frames(record.frames, (const uint32_t*)(sp_dump + offset), (const uint32_t*)stack_thunk_get_stack_top());
         offset = 0; // No offset needed anymore, the exception info was stored in the bssl stack
         sp_dump = stack_thunk_get_cont_sp();
     }
@@ -199,6 +216,13 @@ void __wrap_system_restart_local() {
         stack_end = 0x3fffffb0;
         // it's actually 0x3ffffff0, but the stuff below ets_run
         // is likely not really relevant to the crash
+        if (record.ctx != CRASHLOG_CTX_BEARSSL) {
+            record.ctx = CRASHLOG_CTX_SYS;
+        }
+    }
+    if (record.ctx != CRASHLOG_CTX_BEARSSL) {
+        record.sp = sp_dump;
+        record.depth = crashlog_collect_frames(record.frames, (const uint32_t*)(sp_dump + offset), (const uint32_t*)stack_end);
     }
 
     ets_printf_P(PSTR("sp: %08x end: %08x offset: %04x\n"), sp_dump, stack_end, offset);
@@ -226,6 +250,8 @@ void __wrap_system_restart_local() {
         ets_printf_P(PSTR("\nlast failed alloc caller: 0x%08x\n"), (uint32_t)umm_last_fail_alloc_addr);
     }
 
+    crashlog_add(&record);
+
     custom_crash_callback( &rst_info, sp_dump + offset, stack_end );
 
     ets_delay_us(10000);
@@ -23,6 +23,10 @@
 #include "pins_arduino.h"
 #include "wiring_private.h"
 #include "PolledTimeout.h"
+#include "Schedule.h"
+#include "core_esp8266_waveform.h"
+#include <algorithm>
+#include <atomic>
 
 
 
@@ -63,7 +67,9 @@ class Twi
 {
 private:
     unsigned int preferred_si2c_clock = 100000;
-    uint32_t twi_dcount = 18;
+    uint32_t twi_halfCycles = 400;  // CPU cycles per SCL half period
+    uint8_t twi_cpuMHz = 0;         // when not F_CPU, see cpuFreqChanged()
+    uint32_t twi_edge = 0;          // cycle count at the end of the last one
     unsigned char twi_sda = 0;
     unsigned char twi_scl = 0;
     unsigned char twi_addr = 0;
@@ -86,19 +92,31 @@ private:
     volatile enum { TWI_READY = 0, TWI_MRX, TWI_MTX, TWI_SRX, TWI_STX } twi_state = TWI_READY;
     volatile uint8_t twi_error = 0xFF;
 
-    uint8_t twi_txBuffer[TWI_BUFFER_LENGTH];
+    uint8_t twi_txDefault[TWI_BUFFER_LENGTH];
+    uint8_t* twi_txBuffer = twi_txDefault;
+    int twi_txBufferSize = TWI_BUFFER_LENGTH;
     volatile int twi_txBufferIndex = 0;
     volatile int twi_txBufferLength = 0;
 
-    uint8_t twi_rxBuffer[TWI_BUFFER_LENGTH];
+    // Received data goes to one of two banks.  They are the same buffer until
+    // setSlaveBuffers() is called; then the bus is released at STOP and the
+    // next write from the master goes to the other bank while the callback
+    // still reads this one.  twi_rxPending is set until that callback is done.
+    uint8_t twi_rxDefault[TWI_BUFFER_LENGTH];
+    uint8_t* twi_rxBanks[2] = { twi_rxDefault, twi_rxDefault };
+    uint8_t* twi_rxBuffer = twi_rxDefault;
+    int twi_rxBufferSize = TWI_BUFFER_LENGTH;
     volatile int twi_rxBufferIndex = 0;
+    volatile bool twi_rxPending = false;
 
     void (*twi_onSlaveTransmit)(void);
     void (*twi_onSlaveReceive)(uint8_t*, size_t);
 
     // ETS queue/timer interfaces
-    enum { EVENTTASK_QUEUE_SIZE = 1, EVENTTASK_QUEUE_PRIO = 2 };
+    enum { EVENTTASK_QUEUE_SIZE = 2, EVENTTASK_QUEUE_PRIO = 2 };
     enum { TWI_SIG_RANGE = 0x00000100, TWI_SIG_RX = 0x00000101, TWI_SIG_TX = 0x00000102 };
+    // TWI_SIG_RX parameter: length, bank and whether the bus was released already
+    enum { TWI_RX_LENGTH = 0xffff, TWI_RX_BANK = 0x10000, TWI_RX_RELEASED = 0x20000 };
     ETSEvent eventTaskQueue[EVENTTASK_QUEUE_SIZE];
     ETSTimer timer;
 
@@ -112,7 +130,7 @@ private:
     bool _slaveEnabled = false;
 
     // Internal use functions
-    void IRAM_ATTR busywait(unsigned int v);
+    void IRAM_ATTR halfPeriod(void);
     bool write_start(void);
     bool write_stop(void);
     bool write_bit(bool bit);
@@ -124,6 +142,10 @@ private:
     // Handle the case where a slave needs to stretch the clock with a time-limited busy wait
     inline void WAIT_CLOCK_STRETCH()
     {
+        if (SCL_READ(twi_scl))
+        {
+            return;
+        }
         esp8266::polledTimeout::oneShotFastUs timeout(twi_clockStretchLimit);
         esp8266::polledTimeout::periodicFastUs yieldTimeout(5000);
         while (!timeout && !SCL_READ(twi_scl)) // outer loop is stretch duration up to stretch limit
@@ -133,33 +155,67 @@ private:
                 yield();
             }
         }
+        // The high half period starts when the slave releases SCL
+        twi_edge = esp_get_cycle_count();
     }
 
     // Generate a clock "valley" (at the end of a segment, just before a repeated start)
     void twi_scl_valley(void);
 
+    // Asynchronous master transactions, clocked from the timer1 callback of the
+    // waveform generator one SCL half period per call.  The queue is a ring of
+    // pointers: the task side only moves asyncHead and asyncDone, the interrupt
+    // only asyncRun, so no locking is needed (the timer may run as an NMI).
+    enum { ASYNC_QUEUE = 8 };
+    enum { ASYNC_IDLE = 0, ASYNC_REP_START, ASYNC_REP_START2, ASYNC_START, ASYNC_START2,
+           ASYNC_BIT_LOW, ASYNC_BIT_HIGH, ASYNC_STOP, ASYNC_STOP2, ASYNC_STOP3, ASYNC_VALLEY, ASYNC_END };
+    twi_transaction_t* asyncQueue[ASYNC_QUEUE];
+    volatile uint32_t asyncHead = 0;
+    volatile uint32_t asyncRun = 0;
+    uint32_t asyncDone = 0;
+    bool asyncDispatching = false;
+    int asyncPhase = ASYNC_IDLE;
+    bool asyncBusHeld = false;      // the last transaction ended without STOP
+    bool asyncAbort = false;        // it also failed, skip up to the next STOP
+    uint32_t asyncHalf = 0;         // CPU cycles per SCL half period
+    uint32_t asyncCpuMHz = 80;
+    uint32_t asyncNext = 0;         // cycle count of the next step
+    uint32_t asyncStretchStart = 0;
+    bool asyncStretching = false;
+    uint32_t asyncByteIndex = 0;    // 0 is the address byte
+    int asyncBit = 0;               // 0..7 data, 8 acknowledge
+    uint8_t asyncByte = 0;
+
+    static uint32_t IRAM_ATTR onAsyncTimer();
+    uint32_t IRAM_ATTR asyncStep();
+    void IRAM_ATTR asyncFinish(uint8_t result, bool stop);
+    void asyncReport();
+    void waitAsync();
+
 public:
     void setClock(unsigned int freq);
     void setClockStretchLimit(uint32_t limit);
+    void cpuFreqChanged(uint8_t mhz);
     void init(unsigned char sda, unsigned char scl);
     void setAddress(uint8_t address);
     unsigned char writeTo(unsigned char address, unsigned char * buf, unsigned int len, unsigned char sendStop);
     unsigned char readFrom(unsigned char address, unsigned char* buf, unsigned int len, unsigned char sendStop);
     uint8_t status();
-    uint8_t transmit(const uint8_t* data, uint8_t length);
+    uint8_t transmit(const uint8_t* data, size_t length);
+    bool setSlaveBuffers(size_t rxSize, size_t txSize);
     void attachSlaveRxEvent(void (*function)(uint8_t*, size_t));
     void attachSlaveTxEvent(void (*function)(void));
     void IRAM_ATTR reply(uint8_t ack);
     void IRAM_ATTR releaseBus(void);
     void enableSlave();
+    bool queue(twi_transaction_t* t);
+    bool queue(twi_transaction_t* segments, size_t count);
+    unsigned char transfer(twi_transaction_t* segments, size_t count);
+    bool asyncBusy() const { return asyncDone != asyncHead; }
 };
 
 static Twi twi;
 
-#ifndef FCPU80
-#define FCPU80 80000000L
-#endif
-
 void Twi::setClock(unsigned int freq)
 {
     if (freq < 1000)  // minimum freq 1000Hz to minimize slave timeouts and WDT resets
@@ -169,25 +225,14 @@ void Twi::setClock(unsigned int freq)
 
     preferred_si2c_clock = freq;
 
-#if F_CPU == FCPU80
-
-    if (freq > 400000)
+    // Toggling the pins takes close to a full half period at higher rates
+    uint32_t cpuMHz = twi_cpuMHz ? twi_cpuMHz : ESP.getCpuFreqMHz();
+    uint32_t maxFreq = (cpuMHz >= 160) ? 1000000 : 400000;
+    if (freq > maxFreq)
     {
-        freq = 400000;
+        freq = maxFreq;
     }
-    twi_dcount = (500000000 / freq);  // half-cycle period in ns
-    twi_dcount = (1000 * (twi_dcount - 1120)) / 62500; // (half cycle - overhead) / busywait loop time
-
-#else
-
-    if (freq > 800000)
-    {
-        freq = 800000;
-    }
-    twi_dcount = (500000000 / freq);  // half-cycle period in ns
-    twi_dcount = (1000 * (twi_dcount - 560)) / 31250; // (half cycle - overhead) / busywait loop time
-
-#endif
+    twi_halfCycles = (cpuMHz * 500000U) / freq;
 }
 
 void Twi::setClockStretchLimit(uint32_t limit)
@@ -195,6 +240,15 @@ void Twi::setClockStretchLimit(uint32_t limit)
     twi_clockStretchLimit = limit;
 }
 
+// The CPU clock was switched at run time (core_esp8266_governor.h), between
+// transactions.  Queued transactions count F_CPU cycles, which the timer1
+// interrupt scales, only the blocking ones follow the cycle counter.
+void Twi::cpuFreqChanged(uint8_t mhz)
+{
+    twi_cpuMHz = mhz;
+    setClock(preferred_si2c_clock);
+}
+
 
 
 void Twi::init(unsigned char sda, unsigned char scl)
@@ -229,13 +283,17 @@ void Twi::enableSlave()
     }
 }
 
-void IRAM_ATTR Twi::busywait(unsigned int v)
+// Wait for the end of the current half period.  It is measured from the end
+// of the previous one, so the time spent driving the pins is part of it and
+// the clock does not depend on loop timing.  When an interrupt made us late,
+// the next half period starts now rather than being shortened.
+void IRAM_ATTR Twi::halfPeriod(void)
 {
-    unsigned int i;
-    for (i = 0; i < v; i++)  // loop time is 5 machine cycles: 31.25ns @ 160MHz, 62.5ns @ 80MHz
+    uint32_t now;
+    while ((now = esp_get_cycle_count()) - twi_edge < twi_halfCycles)
     {
-        __asm__ __volatile__("nop"); // minimum element to keep GCC from optimizing this function out.
     }
+    twi_edge = (now - twi_edge < 2 * twi_halfCycles) ? twi_edge + twi_halfCycles : now;
 }
 
 bool Twi::write_start(void)
@@ -246,9 +304,10 @@ bool Twi::write_start(void)
     {
         return false;
     }
-    busywait(twi_dcount);
+    twi_edge = esp_get_cycle_count();
+    halfPeriod();
     SDA_LOW(twi_sda);
-    busywait(twi_dcount);
+    halfPeriod();
     return true;
 }
 
@@ -256,12 +315,12 @@ bool Twi::write_stop(void)
 {
     SCL_LOW(twi_scl);
     SDA_LOW(twi_sda);
-    busywait(twi_dcount);
+    halfPeriod();
     SCL_HIGH(twi_scl);
     WAIT_CLOCK_STRETCH();
-    busywait(twi_dcount);
+    halfPeriod();
     SDA_HIGH(twi_sda);
-    busywait(twi_dcount);
+    halfPeriod();
     return true;
 }
 
@@ -276,10 +335,10 @@ bool Twi::write_bit(bool bit)
     {
         SDA_LOW(twi_sda);
     }
-    busywait(twi_dcount + 1);
+    halfPeriod();
     SCL_HIGH(twi_scl);
     WAIT_CLOCK_STRETCH();
-    busywait(twi_dcount);
+    halfPeriod();
     return true;
 }
 
@@ -287,11 +346,11 @@ bool Twi::read_bit(void)
 {
     SCL_LOW(twi_scl);
     SDA_HIGH(twi_sda);
-    busywait(twi_dcount + 2);
+    halfPeriod();
     SCL_HIGH(twi_scl);
     WAIT_CLOCK_STRETCH();
     bool bit = SDA_READ(twi_sda);
-    busywait(twi_dcount);
+    halfPeriod();
     return bit;
 }
 
@@ -321,6 +380,7 @@ unsigned char Twi::read_byte(bool nack)
 unsigned char Twi::writeTo(unsigned char address, unsigned char * buf, unsigned int len, unsigned char sendStop)
 {
     unsigned int i;
+    waitAsync();
     if (!write_start())
     {
         return 4;  //line busy
@@ -351,14 +411,13 @@ unsigned char Twi::writeTo(unsigned char address, unsigned char * buf, unsigned
     else
     {
         twi_scl_valley();
-        // TD-er: Also busywait(twi_dcount) here?
-        // busywait(twi_dcount);
+        // TD-er: Also halfPeriod() here?
     }
     i = 0;
     while (!SDA_READ(twi_sda) && (i++) < 10)
     {
         twi_scl_valley();
-        busywait(twi_dcount);
+        halfPeriod();
     }
     return 0;
 }
@@ -366,6 +425,7 @@ unsigned char Twi::writeTo(unsigned char address, unsigned char * buf, unsigned
 unsigned char Twi::readFrom(unsigned char address, unsigned char* buf, unsigned int len, unsigned char sendStop)
 {
     unsigned int i;
+    waitAsync();
     if (!write_start())
     {
         return 4;  //line busy
@@ -390,14 +450,13 @@ unsigned char Twi::readFrom(unsigned char address, unsigned char* buf, unsigned
     else
     {
         twi_scl_valley();
-        // TD-er: Also busywait(twi_dcount) here?
-        // busywait(twi_dcount);
+        // TD-er: Also halfPeriod() here?
     }
     i = 0;
     while (!SDA_READ(twi_sda) && (i++) < 10)
     {
         twi_scl_valley();
-        busywait(twi_dcount);
+        halfPeriod();
     }
     return 0;
 }
@@ -405,11 +464,346 @@ unsigned char Twi::readFrom(unsigned char address, unsigned char* buf, unsigned
 void Twi::twi_scl_valley(void)
 {
     SCL_LOW(twi_scl);
-    busywait(twi_dcount);
+    halfPeriod();
     SCL_HIGH(twi_scl);
     WAIT_CLOCK_STRETCH();
 }
 
+unsigned char Twi::transfer(twi_transaction_t* segments, size_t count)
+{
+    unsigned char ret = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (segments[i].read && !segments[i].len)
+        {
+            ret = 4;
+        }
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        twi_transaction_t* t = &segments[i];
+        bool last = (i + 1 == count);
+        t->sendStop = last;
+        if (ret)
+        {
+            // The chain ends at the first failure
+            t->result = 4;
+            continue;
+        }
+        ret = t->read ? readFrom(t->address, t->buf, t->len, last) : writeTo(t->address, t->buf, t->len, last);
+        t->result = ret;
+        if (ret && ret != 4 && !last)
+        {
+            // NACKed while holding the bus for the next segment
+            write_stop();
+        }
+    }
+    return ret;
+}
+
+bool Twi::queue(twi_transaction_t* segments, size_t count)
+{
+    if (!count || (ASYNC_QUEUE - (asyncHead - asyncDone)) < count)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        if (segments[i].read && !segments[i].len)
+        {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        segments[i].sendStop = (i + 1 == count);
+        if (!queue(&segments[i]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Twi::queue(twi_transaction_t* t)
+{
+    if (_slaveEnabled || !t || (t->read && !t->len) || (asyncHead - asyncDone) >= ASYNC_QUEUE)
+    {
+        return false;
+    }
+    bool wasIdle = !asyncBusy();
+    if (wasIdle)
+    {
+        // Prefer the configured clock, but each half period costs an interrupt
+        asyncCpuMHz = ESP.getCpuFreqMHz();
+        asyncHalf = (asyncCpuMHz * 500000U) / preferred_si2c_clock;
+        asyncNext = esp_get_cycle_count();
+    }
+    t->result = TWI_ASYNC_PENDING;
+    asyncQueue[asyncHead % ASYNC_QUEUE] = t;
+    std::atomic_thread_fence(std::memory_order_release);
+    asyncHead = asyncHead + 1;
+    if (wasIdle)
+    {
+        setTimer1Callback(onAsyncTimer);
+        if (!asyncDispatching)
+        {
+            asyncDispatching = schedule_recurrent_function_us([]()
+            {
+                twi.asyncReport();
+                twi.asyncDispatching = twi.asyncBusy();
+                return twi.asyncDispatching;
+            }, 100);
+        }
+    }
+    return true;
+}
+
+void Twi::waitAsync()
+{
+    while (asyncBusy())
+    {
+        if (asyncRun == asyncHead)
+        {
+            // All on the bus, just not reported yet
+            asyncReport();
+        }
+        else
+        {
+            optimistic_yield(1000);
+        }
+    }
+}
+
+void Twi::asyncReport()
+{
+    // Report in queue order from task context, callbacks may queue more
+    while (asyncDone != asyncRun)
+    {
+        twi_transaction_t* t = asyncQueue[asyncDone % ASYNC_QUEUE];
+        asyncDone++;
+        if (t->onDone)
+        {
+            t->onDone(t);
+        }
+    }
+    if (!asyncBusy())
+    {
+        setTimer1Callback(nullptr);
+    }
+}
+
+uint32_t IRAM_ATTR Twi::onAsyncTimer()
+{
+    // Called on every timer1 interrupt, not only when we asked for it
+    int32_t left = (int32_t)(twi.asyncNext - esp_get_cycle_count());
+    if (left > 0)
+    {
+        return left;
+    }
+    uint32_t wait = twi.asyncStep();
+    twi.asyncNext = esp_get_cycle_count() + wait;
+    return wait;
+}
+
+void IRAM_ATTR Twi::asyncFinish(uint8_t result, bool stop)
+{
+    asyncQueue[asyncRun % ASYNC_QUEUE]->result = result;
+    asyncAbort = result && !stop;
+    asyncPhase = stop ? ASYNC_STOP : ASYNC_VALLEY;
+}
+
+uint32_t IRAM_ATTR Twi::asyncStep()
+{
+    if (asyncPhase == ASYNC_IDLE)
+    {
+        if (asyncRun == asyncHead)
+        {
+            return asyncHalf * 100; // nothing queued, poll slowly until removed
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        twi_transaction_t* t = asyncQueue[asyncRun % ASYNC_QUEUE];
+        if (asyncAbort)
+        {
+            // Rest of a failed chain, only end it with a STOP
+            t->result = 4;
+            if (!t->sendStop)
+            {
+                asyncRun = asyncRun + 1;
+                return asyncHalf;
+            }
+            asyncAbort = false;
+            if (!asyncBusHeld)
+            {
+                asyncRun = asyncRun + 1;
+                return asyncHalf;
+            }
+            asyncPhase = ASYNC_STOP;
+            return asyncStep();
+        }
+        asyncByteIndex = 0;
+        asyncBit = 0;
+        asyncByte = (t->address << 1) | (t->read ? 1 : 0);
+        asyncPhase = asyncBusHeld ? ASYNC_REP_START : ASYNC_START;
+    }
+
+    twi_transaction_t* t = asyncQueue[asyncRun % ASYNC_QUEUE];
+
+    // After releasing SCL a slave may hold it low, wait for it up to the limit
+    if (asyncPhase == ASYNC_BIT_LOW || asyncPhase == ASYNC_STOP3 || asyncPhase == ASYNC_START || asyncPhase == ASYNC_END)
+    {
+        if (!SCL_READ(twi_scl))
+        {
+            if (!asyncStretching)
+            {
+                asyncStretching = true;
+                asyncStretchStart = esp_get_cycle_count();
+            }
+            else if ((esp_get_cycle_count() - asyncStretchStart) / asyncCpuMHz > twi_clockStretchLimit)
+            {
+                asyncStretching = false;
+                if (t->result == TWI_ASYNC_PENDING)
+                {
+                    t->result = 4;
+                }
+                asyncAbort = !t->sendStop;
+                asyncBusHeld = false;
+                asyncPhase = ASYNC_IDLE;
+                asyncRun = asyncRun + 1;
+                return asyncHalf;
+            }
+            return asyncHalf / 4;
+        }
+        if (asyncStretching)
+        {
+            // Give the slave a full high period once it lets go
+            asyncStretching = false;
+            return asyncHalf;
+        }
+    }
+
+    switch (asyncPhase)
+    {
+    case ASYNC_REP_START:
+        SCL_LOW(twi_scl);
+        SDA_HIGH(twi_sda);
+        asyncPhase = ASYNC_REP_START2;
+        return asyncHalf;
+    case ASYNC_REP_START2:
+        SCL_HIGH(twi_scl);
+        asyncPhase = ASYNC_START;
+        return asyncHalf;
+    case ASYNC_START:
+        SCL_HIGH(twi_scl);
+        SDA_HIGH(twi_sda);
+        if (!SDA_READ(twi_sda))
+        {
+            // Line busy, nothing was sent
+            t->result = 4;
+            asyncAbort = !t->sendStop;
+            asyncBusHeld = false;
+            asyncPhase = ASYNC_IDLE;
+            asyncRun = asyncRun + 1;
+            return asyncHalf;
+        }
+        asyncPhase = ASYNC_START2;
+        return asyncHalf;
+    case ASYNC_START2:
+        SDA_LOW(twi_sda);
+        asyncPhase = ASYNC_BIT_LOW;
+        return asyncHalf;
+    case ASYNC_BIT_LOW:
+    {
+        // The bit clocked by the previous high period is complete
+        bool reading = asyncByteIndex && t->read;
+        if (asyncBit > 0)
+        {
+            bool sda = SDA_READ(twi_sda);
+            if (asyncBit <= 8 && reading)
+            {
+                asyncByte = (asyncByte << 1) | sda;
+            }
+            if (asyncBit == 9)
+            {
+                // Acknowledge bit done, the byte is complete
+                if (!reading && sda)
+                {
+                    SCL_LOW(twi_scl);
+                    asyncFinish(asyncByteIndex ? 3 : 2, t->sendStop);
+                    return asyncHalf;
+                }
+                if (reading)
+                {
+                    t->buf[asyncByteIndex - 1] = asyncByte;
+                }
+                if (asyncByteIndex == t->len)
+                {
+                    SCL_LOW(twi_scl);
+                    asyncFinish(0, t->sendStop);
+                    return asyncHalf;
+                }
+                asyncByteIndex++;
+                asyncBit = 0;
+                reading = t->read;
+                asyncByte = reading ? 0 : t->buf[asyncByteIndex - 1];
+            }
+        }
+        SCL_LOW(twi_scl);
+        bool sdaHigh;
+        if (asyncBit < 8)
+        {
+            sdaHigh = reading ? true : (asyncByte & (0x80 >> asyncBit));
+        }
+        else
+        {
+            // Acknowledge: released when writing, NACK only after the last byte read
+            sdaHigh = reading ? (asyncByteIndex == t->len) : true;
+        }
+        if (sdaHigh)
+        {
+            SDA_HIGH(twi_sda);
+        }
+        else
+        {
+            SDA_LOW(twi_sda);
+        }
+        asyncPhase = ASYNC_BIT_HIGH;
+        return asyncHalf;
+    }
+    case ASYNC_BIT_HIGH:
+        SCL_HIGH(twi_scl);
+        asyncBit++;
+        asyncPhase = ASYNC_BIT_LOW;
+        return asyncHalf;
+    case ASYNC_STOP:
+        SCL_LOW(twi_scl);
+        SDA_LOW(twi_sda);
+        asyncPhase = ASYNC_STOP2;
+        return asyncHalf;
+    case ASYNC_STOP2:
+        SCL_HIGH(twi_scl);
+        asyncPhase = ASYNC_STOP3;
+        return asyncHalf;
+    case ASYNC_STOP3:
+        SDA_HIGH(twi_sda);
+        asyncBusHeld = false;
+        asyncPhase = ASYNC_IDLE;
+        asyncRun = asyncRun + 1;
+        return asyncHalf;
+    case ASYNC_VALLEY:
+        // SCL is low, hold the bus for a repeated start
+        SCL_HIGH(twi_scl);
+        asyncPhase = ASYNC_END;
+        return asyncHalf;
+    case ASYNC_END:
+    default:
+        asyncBusHeld = true;
+        asyncPhase = ASYNC_IDLE;
+        asyncRun = asyncRun + 1;
+        return asyncHalf;
+    }
+}
+
 uint8_t Twi::status()
 {
     WAIT_CLOCK_STRETCH();  // wait for a slow slave to finish
@@ -435,12 +829,10 @@ uint8_t Twi::status()
     return I2C_OK;
 }
 
-uint8_t Twi::transmit(const uint8_t* data, uint8_t length)
+uint8_t Twi::transmit(const uint8_t* data, size_t length)
 {
-    uint8_t i;
-
     // ensure data will fit into buffer
-    if (length > TWI_BUFFER_LENGTH)
+    if (length > (size_t)twi_txBufferSize)
     {
         return 1;
     }
@@ -453,12 +845,46 @@ uint8_t Twi::transmit(const uint8_t* data, uint8_t length)
 
     // set length and copy data into tx buffer
     twi_txBufferLength = length;
-    for (i = 0; i < length; ++i)
+    memcpy(twi_txBuffer, data, length);
+
+    return 0;
+}
+
+bool Twi::setSlaveBuffers(size_t rxSize, size_t txSize)
+{
+    // buffers cannot move under the interrupts
+    if (_slaveEnabled || !rxSize || rxSize > TWI_RX_LENGTH || !txSize)
     {
-        twi_txBuffer[i] = data[i];
+        return false;
     }
 
-    return 0;
+    // both banks in one block, with room for the terminating '\0'
+    uint8_t* rx = (uint8_t*)malloc(2 * (rxSize + 1));
+    uint8_t* tx = txSize > TWI_BUFFER_LENGTH ? (uint8_t*)malloc(txSize) : twi_txDefault;
+    if (!rx || !tx)
+    {
+        free(rx);
+        if (tx != twi_txDefault)
+        {
+            free(tx);
+        }
+        return false;
+    }
+
+    if (twi_rxBanks[0] != twi_rxDefault)
+    {
+        free(twi_rxBanks[0]);
+    }
+    if (twi_txBuffer != twi_txDefault)
+    {
+        free(twi_txBuffer);
+    }
+    twi_rxBanks[0] = twi_rxBuffer = rx;
+    twi_rxBanks[1] = rx + rxSize + 1;
+    twi_rxBufferSize = rxSize;
+    twi_txBuffer = tx;
+    twi_txBufferSize = std::max(txSize, (size_t)TWI_BUFFER_LENGTH);
+    return true;
 }
 
 void Twi::attachSlaveRxEvent(void (*function)(uint8_t*, size_t))
@@ -524,7 +950,7 @@ void IRAM_ATTR Twi::onTwipEvent(uint8_t status)
     case TW_SR_DATA_ACK:       // data received, returned ack
     case TW_SR_GCALL_DATA_ACK: // data received generally, returned ack
         // if there is still room in the rx buffer
-        if (twi_rxBufferIndex < TWI_BUFFER_LENGTH)
+        if (twi_rxBufferIndex < twi_rxBufferSize)
         {
             // put byte in buffer and ack
             twi_rxBuffer[twi_rxBufferIndex++] = twi_data;
@@ -537,14 +963,28 @@ void IRAM_ATTR Twi::onTwipEvent(uint8_t status)
         }
         break;
     case TW_SR_STOP: // stop or repeated start condition received
-        // put a null char after data if there's room
-        if (twi_rxBufferIndex < TWI_BUFFER_LENGTH)
+        // put a null char after data if there's room (always with two banks)
+        if (twi_rxBufferIndex < TWI_BUFFER_LENGTH || twi_rxBanks[0] != twi_rxBanks[1])
         {
             twi_rxBuffer[twi_rxBufferIndex] = '\0';
         }
-        // callback to user-defined callback over event task to allow for non-RAM-residing code
-        //twi_rxBufferLock = true; // This may be necessary
-        ets_post(EVENTTASK_QUEUE_PRIO, TWI_SIG_RX, twi_rxBufferIndex);
+        {
+            // callback to user-defined callback over event task to allow for non-RAM-residing code
+            ETSParam par = twi_rxBufferIndex;
+            if (twi_rxBuffer != twi_rxBanks[0])
+            {
+                par |= TWI_RX_BANK;
+            }
+            if (twi_rxBanks[0] != twi_rxBanks[1] && !twi_rxPending)
+            {
+                // the other bank is free: no need to stretch the clock until the callback
+                twi_rxPending = true;
+                twi_rxBuffer = twi_rxBanks[(par & TWI_RX_BANK) ? 0 : 1];
+                par |= TWI_RX_RELEASED;
+                releaseBus();
+            }
+            ets_post(EVENTTASK_QUEUE_PRIO, TWI_SIG_RX, par);
+        }
 
         // since we submit rx buffer to "wire" library, we can reset it
         twi_rxBufferIndex = 0;
@@ -647,11 +1087,21 @@ void Twi::eventTask(ETSEvent *e)
         break;
 
     case TWI_SIG_RX:
-        // ack future responses and leave slave receiver state
-        twi.releaseBus();
-        twi.twi_onSlaveReceive(twi.twi_rxBuffer, e->par);
+    {
+        const int bank = (e->par & TWI_RX_BANK) ? 1 : 0;
+        if (!(e->par & TWI_RX_RELEASED))
+        {
+            // receive into the other bank, when there are two, during the callback
+            twi.twi_rxBuffer = twi.twi_rxBanks[bank ^ 1];
+            twi.twi_rxPending = true;
+            // ack future responses and leave slave receiver state
+            twi.releaseBus();
+        }
+        twi.twi_onSlaveReceive(twi.twi_rxBanks[bank], e->par & TWI_RX_LENGTH);
+        twi.twi_rxPending = false;
         break;
     }
+    }
 }
 
 // The state machine is converted from a 0...15 state to a 1-hot encoded state, and then
@@ -978,6 +1428,11 @@ extern "C" {
         twi.setClockStretchLimit(limit);
     }
 
+    void twi_cpuFreqChanged(uint8_t mhz)
+    {
+        twi.cpuFreqChanged(mhz);
+    }
+
     uint8_t twi_writeTo(unsigned char address, unsigned char * buf, unsigned int len, unsigned char sendStop)
     {
         return twi.writeTo(address, buf, len, sendStop);
@@ -993,11 +1448,16 @@ extern "C" {
         return twi.status();
     }
 
-    uint8_t twi_transmit(const uint8_t * buf, uint8_t len)
+    uint8_t twi_transmit(const uint8_t * buf, size_t len)
     {
         return twi.transmit(buf, len);
     }
 
+    bool twi_setSlaveBuffers(size_t rxSize, size_t txSize)
+    {
+        return twi.setSlaveBuffers(rxSize, txSize);
+    }
+
     void twi_attachSlaveRxEvent(void (*cb)(uint8_t*, size_t))
     {
         twi.attachSlaveRxEvent(cb);
@@ -1023,4 +1483,24 @@ extern "C" {
         twi.enableSlave();
     }
 
+    bool twi_queueTransaction(twi_transaction_t* t)
+    {
+        return twi.queue(t);
+    }
+
+    bool twi_asyncBusy(void)
+    {
+        return twi.asyncBusy();
+    }
+
+    uint8_t twi_transfer(twi_transaction_t* segments, size_t count)
+    {
+        return twi.transfer(segments, count);
+    }
+
+    bool twi_queueTransfer(twi_transaction_t* segments, size_t count)
+    {
+        return twi.queue(segments, count);
+    }
+
 };
@@ -20,6 +20,8 @@
 */
 
 #include "Arduino.h" // using pinMode
+#include "core_esp8266_waveform.h" // using setTimer1Callback
+#include "Schedule.h"
 
 extern "C" {
 
@@ -30,6 +32,7 @@ extern "C" {
 #define GPSDE 16 // enable
 
 void sigmaDeltaSetPrescaler(uint8_t prescaler); // avoids compiler warning
+void sigmaDeltaStop(void);
 
 /******************************************************************************
  * FunctionName : sigmaDeltaEnable
@@ -84,6 +87,39 @@ void ICACHE_FLASH_ATTR sigmaDeltaDetachPin(uint8_t pin)
   }
 }
 
+/******************************************************************************
+ * FunctionName : sigmaDeltaAttachPins
+ * Description  : connects the sigma delta source to several output pins,
+ *                their outputs are all enabled by the same register write
+ * Parameters   : pins, bit mask of pins 0..15
+ * Returns      : none
+*******************************************************************************/
+void ICACHE_FLASH_ATTR sigmaDeltaAttachPins(uint16_t pins)
+{
+  for (uint8_t pin = 0; pin < 16; pin++) {
+    if (pins & (1 << pin)) {
+      GPF(pin) = GPFFS(GPFFS_GPIO(pin)); //Set mode to GPIO
+      GPC(pin) = (GPC(pin) & (0xF << GPCI)) | (1 << GPCS); //SOURCE(SigmaDelta) | DRIVER(NORMAL)
+    }
+  }
+  GPES = pins; //Enable
+}
+
+/******************************************************************************
+ * FunctionName : sigmaDeltaDetachPins
+ * Description  : disconnects the sigma delta source from several output pins
+ * Parameters   : pins, bit mask of pins 0..15
+ * Returns      : none
+*******************************************************************************/
+void ICACHE_FLASH_ATTR sigmaDeltaDetachPins(uint16_t pins)
+{
+  for (uint8_t pin = 0; pin < 16; pin++) {
+    if (pins & (1 << pin)) {
+      GPC(pin) &= ~(1 << GPCS); //SOURCE 0:GPIO_DATA,1:SigmaDelta
+    }
+  }
+}
+
 /******************************************************************************
  * FunctionName : sigmaDeltaIsPinAttached
  * Description  : query if pin is attached
@@ -150,6 +186,108 @@ uint8_t ICACHE_FLASH_ATTR sigmaDeltaRead(uint8_t channel)
   return (uint8_t)((GPSD >> GPSDT) & 0xFF);
 }
 
+// Duty sequencer: the timer1 callback of the waveform generator writes the
+// next target of the table at each step, and the sketch only gets involved
+// again to start another table.  Nothing else happens per step.
+static struct {
+  const uint8_t* duties;
+  uint32_t count;
+  volatile uint32_t index;
+  uint32_t period; // CPU cycles per step
+  uint32_t next;   // cycle count of the next step
+  bool loop;
+  volatile bool playing;
+  bool watching;   // the scheduled function removing the callback is set
+} sdSeq;
+
+static uint32_t IRAM_ATTR sigmaDeltaStep()
+{
+  // Called on every timer1 interrupt, not only when we asked for it
+  int32_t left = (int32_t)(sdSeq.next - esp_get_cycle_count());
+  if (left > 0) {
+    return left;
+  }
+  if (!sdSeq.playing) {
+    return sdSeq.period;
+  }
+  if (sdSeq.index == sdSeq.count) {
+    if (!sdSeq.loop) {
+      sdSeq.playing = false;
+      return sdSeq.period;
+    }
+    sdSeq.index = 0;
+  }
+  GPSD = (GPSD & ~(0xFF << GPSDT)) | (sdSeq.duties[sdSeq.index++] << GPSDT);
+  // steps keep to the rate unless we are more than one behind
+  sdSeq.next += sdSeq.period;
+  if (-left > (int32_t)sdSeq.period) {
+    sdSeq.next = esp_get_cycle_count() + sdSeq.period;
+  }
+  return sdSeq.period;
+}
+
+/******************************************************************************
+ * FunctionName : sigmaDeltaPlay
+ * Description  : play a table of duty cycles in the background, one entry
+ *                every 1/rate second, replacing the one playing if any
+ * Parameters   : duties, in RAM until the end or sigmaDeltaStop(),
+ *                count entries, rate 1..50000 steps per second,
+ *                loop to start over at the end
+ * Returns      : bool false for bad parameters
+*******************************************************************************/
+bool ICACHE_FLASH_ATTR sigmaDeltaPlay(const uint8_t* duties, uint32_t count, uint32_t rate, bool loop)
+{
+  if (!duties || !count || !rate || rate > 50000) {
+    return false;
+  }
+  sigmaDeltaStop();
+  sdSeq.duties = duties;
+  sdSeq.count = count;
+  sdSeq.index = 0;
+  sdSeq.period = microsecondsToClockCycles(1000000UL) / rate;
+  sdSeq.loop = loop;
+  sdSeq.next = esp_get_cycle_count();
+  sdSeq.playing = true;
+  setTimer1Callback(sigmaDeltaStep);
+  if (!sdSeq.watching) {
+    // the callback cannot remove itself, do it once the table is done
+    sdSeq.watching = schedule_recurrent_function_us([]() {
+      if (sdSeq.playing) {
+        return true;
+      }
+      setTimer1Callback(nullptr);
+      sdSeq.watching = false;
+      return false;
+    }, 10000);
+  }
+  return true;
+}
+
+/******************************************************************************
+ * FunctionName : sigmaDeltaStop
+ * Description  : stop the table playing, the duty cycle stays where it is
+ * Parameters   : none
+ * Returns      : none
+*******************************************************************************/
+void ICACHE_FLASH_ATTR sigmaDeltaStop(void)
+{
+  if (sdSeq.playing) {
+    sdSeq.playing = false;
+    setTimer1Callback(nullptr);
+  }
+}
+
+/******************************************************************************
+ * FunctionName : sigmaDeltaPlaying
+ * Description  : query if a table is playing
+ * Parameters   : none
+ * Returns      : bool
+*******************************************************************************/
+bool ICACHE_FLASH_ATTR sigmaDeltaPlaying(void)
+{
+  return sdSeq.playing;
+}
+
 /******************************************************************************
  * FunctionName : sigmaDeltaSetPrescaler
  * Description  : set the clock divider for the sigma-delta source
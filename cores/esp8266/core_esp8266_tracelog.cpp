@@ -0,0 +1,302 @@
+/*
+ core_esp8266_tracelog.cpp - log records kept raw in RAM, formatted later
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <algorithm>
+#include <Arduino.h>
+#include <user_interface.h>
+#include "core_esp8266_tracelog.h"
+
+// A record is the format address, the time, the number of argument words
+// and the words.  A format address of 0 marks the unused end of the ring
+// when a record did not fit there.  head == tail is empty, so one word is
+// always left free.
+#define TRACELOG_HEADER 3
+// an argument word announcing a string copied into the next words
+#define TRACELOG_STRING 0xffff0000
+
+static uint32_t* s_ring = nullptr;
+static uint32_t s_size = 0;
+static uint32_t s_head = 0;
+static uint32_t s_tail = 0;
+static uint32_t s_dropped = 0;
+
+extern "C" bool tracelog_begin(size_t bytes)
+{
+    tracelog_end();
+    uint32_t size = bytes / sizeof(uint32_t);
+    if (size < TRACELOG_HEADER + TRACELOG_MAX_WORDS + 1) {
+        return false;
+    }
+    uint32_t* ring = static_cast<uint32_t*>(malloc(size * sizeof(uint32_t)));
+    if (!ring) {
+        return false;
+    }
+    uint32_t saved = xt_rsil(15);
+    s_ring = ring;
+    s_size = size;
+    s_head = s_tail = 0;
+    s_dropped = 0;
+    xt_wsr_ps(saved);
+    return true;
+}
+
+extern "C" void tracelog_end(void)
+{
+    uint32_t saved = xt_rsil(15);
+    uint32_t* ring = s_ring;
+    s_ring = nullptr;
+    s_size = 0;
+    xt_wsr_ps(saved);
+    free(ring);
+}
+
+extern "C" uint32_t tracelog_dropped(void)
+{
+    return s_dropped;
+}
+
+extern "C" IRAM_ATTR bool tracelog_record(const char* fmt, const uint32_t* args, size_t words)
+{
+    const uint32_t now = system_get_time();
+    const uint32_t need = TRACELOG_HEADER + words;
+    uint32_t saved = xt_rsil(15);
+    if (!s_ring) {
+        xt_wsr_ps(saved);
+        return false;
+    }
+    uint32_t head = s_head;
+    const uint32_t tail = s_tail;
+    uint32_t next;
+    if (head >= tail && head + need < s_size + (tail ? 1 : 0)) {
+        next = head + need;
+    } else if (head >= tail && need < tail) {
+        s_ring[head] = 0;
+        head = 0;
+        next = need;
+    } else if (head < tail && head + need < tail) {
+        next = head + need;
+    } else {
+        s_dropped++;
+        xt_wsr_ps(saved);
+        return false;
+    }
+    uint32_t* p = s_ring + head;
+    p[0] = (uint32_t)(uintptr_t)fmt;
+    p[1] = now;
+    p[2] = words;
+    for (size_t i = 0; i < words; i++) {
+        p[TRACELOG_HEADER + i] = args[i];
+    }
+    s_head = next == s_size ? 0 : next;
+    xt_wsr_ps(saved);
+    return true;
+}
+
+// IRAM with the rest of the recording, DEBUGV() is used in interrupts
+IRAM_ATTR void TraceLogArgs::add(const char* s)
+{
+    if (!s || (uintptr_t)s >= 0x40000000) {
+        // flash stays, and reading it needs pgm_read_byte
+        word((uint32_t)(uintptr_t)s);
+        return;
+    }
+    size_t len = 0;
+    while (len < TRACELOG_MAX_STRING && s[len]) {
+        len++;
+    }
+    size_t n = (len + sizeof(uint32_t)) / sizeof(uint32_t);
+    if (count + 1 + n > TRACELOG_MAX_WORDS) {
+        word(0);
+        return;
+    }
+    word(TRACELOG_STRING | len);
+    uint8_t* dst = reinterpret_cast<uint8_t*>(words + count);
+    for (size_t i = 0; i < n * sizeof(uint32_t); i++) {
+        dst[i] = i < len ? s[i] : 0;
+    }
+    count += n;
+}
+
+// Takes the oldest record, false when empty
+static bool tracelog_take(const char*& fmt, uint32_t& time, uint32_t* args, size_t& words)
+{
+    uint32_t saved = xt_rsil(15);
+    if (s_ring && s_tail != s_head && !s_ring[s_tail]) {
+        s_tail = 0;
+    }
+    if (!s_ring || s_tail == s_head) {
+        xt_wsr_ps(saved);
+        return false;
+    }
+    const uint32_t* p = s_ring + s_tail;
+    fmt = (const char*)p[0];
+    time = p[1];
+    words = p[2];
+    for (size_t i = 0; i < words; i++) {
+        args[i] = p[TRACELOG_HEADER + i];
+    }
+    s_tail += TRACELOG_HEADER + words;
+    if (s_tail == s_size) {
+        s_tail = 0;
+    }
+    xt_wsr_ps(saved);
+    return true;
+}
+
+static size_t tracelog_format(Print& out, const char* fmt, const uint32_t* args, size_t words)
+{
+    size_t n = 0;
+    size_t w = 0;
+    char spec[24];
+    char buf[TRACELOG_MAX_STRING + 1];
+    char text[72];
+    for (;;) {
+        char c = pgm_read_byte(fmt++);
+        if (!c) {
+            break;
+        }
+        if (c != '%') {
+            // the line ends in print()
+            const char next = pgm_read_byte(fmt);
+            if ((c != '\n' && c != '\r') || (next && next != '\n' && next != '\r')) {
+                n += out.write(c);
+            }
+            continue;
+        }
+        // flags, width and precision are kept, length modifiers counted
+        size_t len = 0;
+        int longs = 0;
+        spec[len++] = '%';
+        for (;;) {
+            c = pgm_read_byte(fmt++);
+            if (c == 'l') {
+                longs++;
+            } else if (c == 'h' || c == 'z' || c == 'j' || c == 't' || c == 'L') {
+            } else if (c && strchr("-+ #0123456789.", c)) {
+                if (len < sizeof(spec) - 4) {
+                    spec[len++] = c;
+                }
+            } else {
+                break;
+            }
+        }
+        if (!c) {
+            break;
+        }
+        if (c == '%') {
+            n += out.write('%');
+            continue;
+        }
+        const bool wide = longs >= 2 || strchr("fFeEgGaA", c);
+        if (w + (wide ? 2 : 1) > words) {
+            n += out.print('?');
+            continue;
+        }
+        if (wide) {
+            unsigned long long u = args[w] | ((unsigned long long)args[w + 1] << 32);
+            w += 2;
+            if (strchr("fFeEgGaA", c)) {
+                spec[len++] = c;
+                spec[len] = 0;
+                double d;
+                memcpy(&d, &u, sizeof(d));
+                snprintf(text, sizeof(text), spec, d);
+            } else {
+                spec[len++] = 'l';
+                spec[len++] = 'l';
+                spec[len++] = c;
+                spec[len] = 0;
+                snprintf(text, sizeof(text), spec, u);
+            }
+            n += out.print(text);
+            continue;
+        }
+        uint32_t arg = args[w++];
+        if (c == 's' || c == 'S') {
+            const char* str = buf;
+            if ((arg & 0xffff0000) == TRACELOG_STRING) {
+                size_t chars = std::min((size_t)(arg & 0xffff), (size_t)TRACELOG_MAX_STRING);
+                chars = std::min(chars, (words - w) * sizeof(uint32_t));
+                memcpy(buf, args + w, chars);
+                buf[chars] = 0;
+                w += (chars + sizeof(uint32_t)) / sizeof(uint32_t);
+            } else if (arg >= 0x40000000) {
+                strncpy_P(buf, (PGM_P)arg, sizeof(buf) - 1);
+                buf[sizeof(buf) - 1] = 0;
+            } else {
+                str = arg ? (const char*)arg : "(null)";
+            }
+            spec[len++] = 's';
+            spec[len] = 0;
+            snprintf(text, sizeof(text), spec, str);
+        } else if (c == 'd' || c == 'i') {
+            spec[len++] = c;
+            spec[len] = 0;
+            snprintf(text, sizeof(text), spec, (int)arg);
+        } else if (c == 'p') {
+            spec[len++] = c;
+            spec[len] = 0;
+            snprintf(text, sizeof(text), spec, (void*)arg);
+        } else if (c == 'c' || strchr("uoxX", c)) {
+            spec[len++] = c;
+            spec[len] = 0;
+            snprintf(text, sizeof(text), spec, (unsigned)arg);
+        } else {
+            // %n and unknown conversions
+            continue;
+        }
+        n += out.print(text);
+    }
+    return n;
+}
+
+size_t tracelog_print(Print& out, size_t max)
+{
+    const char* fmt;
+    uint32_t time;
+    uint32_t args[TRACELOG_MAX_WORDS];
+    size_t words;
+    size_t count = 0;
+    while (count < max && tracelog_take(fmt, time, args, words)) {
+        out.printf_P(PSTR("%u.%06u "), time / 1000000, time % 1000000);
+        tracelog_format(out, fmt, args, words);
+        out.println();
+        count++;
+    }
+    return count;
+}
+
+size_t tracelog_dump(Print& out, size_t max)
+{
+    const char* fmt;
+    uint32_t time;
+    uint32_t args[TRACELOG_MAX_WORDS];
+    size_t words;
+    size_t count = 0;
+    while (count < max && tracelog_take(fmt, time, args, words)) {
+        out.printf_P(PSTR("%08x %u"), (uint32_t)(uintptr_t)fmt, time);
+        for (size_t i = 0; i < words; i++) {
+            out.printf_P(PSTR(" %x"), args[i]);
+        }
+        out.println();
+        count++;
+    }
+    out.printf_P(PSTR("dropped %u\nend\n"), s_dropped);
+    return count;
+}
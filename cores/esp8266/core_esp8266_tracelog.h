@@ -0,0 +1,134 @@
+/*
+ core_esp8266_tracelog.h - log records kept raw in RAM, formatted later
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __CORE_ESP8266_TRACELOG_H
+#define __CORE_ESP8266_TRACELOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pgmspace.h>
+
+/*
+  TRACELOG("fmt", args...) appends a record to a ring of 32 bit words
+  allocated by tracelog_begin(): the address of the format string, which
+  stays in flash, the time from system_get_time() and the arguments as
+  words.  Nothing is formatted and nothing is written to a port then, so
+  it costs about as much as a function call and can stay enabled.
+  tracelog_print() formats and removes records from the sketch, e.g. in
+  loop(), tracelog_dump() prints them raw for tools/tracelog.py to format
+  on the host with the sketch ELF.  Records that do not fit are dropped
+  and counted.
+
+  Integers, pointers and char take a word, 64 bit integers and floating
+  point (as double) two.  The characters of strings in RAM are copied
+  (TRACELOG_MAX_STRING at most), those of strings in flash (PSTR, F())
+  are not.  Conversions are those of printf except '*' widths and %n,
+  with at most TRACELOG_MAX_WORDS words of arguments.
+
+  With DEBUG_ESP_TRACELOG defined next to DEBUG_ESP_CORE, DEBUGV() records
+  with TRACELOG() instead of printing (see debug.h).
+*/
+
+#define TRACELOG_MAX_WORDS 32
+#define TRACELOG_MAX_STRING 63
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// bytes of RAM for the ring
+bool tracelog_begin(size_t bytes);
+void tracelog_end(void);
+// false when the record was dropped (full ring, or not started)
+bool tracelog_record(const char* fmt, const uint32_t* args, size_t words);
+uint32_t tracelog_dropped(void);
+
+#ifdef __cplusplus
+}
+
+#include <type_traits>
+#include <Print.h>
+
+// Format and remove up to max records, one line each, returns the count
+size_t tracelog_print(Print& out, size_t max = SIZE_MAX);
+// Same as hex words, for tools/tracelog.py
+size_t tracelog_dump(Print& out, size_t max = SIZE_MAX);
+
+class TraceLogArgs
+{
+public:
+    uint32_t words[TRACELOG_MAX_WORDS];
+    size_t count = 0;
+
+    void word(uint32_t w)
+    {
+        if (count < TRACELOG_MAX_WORDS) {
+            words[count++] = w;
+        }
+    }
+    void add(double v)
+    {
+        uint64_t u;
+        memcpy(&u, &v, sizeof(u));
+        add((unsigned long long)u);
+    }
+    void add(float v)
+    {
+        add((double)v);
+    }
+    void add(long long v)
+    {
+        add((unsigned long long)v);
+    }
+    void add(unsigned long long v)
+    {
+        word((uint32_t)v);
+        word((uint32_t)(v >> 32));
+    }
+    void add(const char* s);
+    void add(char* s)
+    {
+        add((const char*)s);
+    }
+    template <typename T>
+    void add(T v)
+    {
+        if constexpr (std::is_pointer<T>::value) {
+            word((uint32_t)(uintptr_t)v);
+        } else {
+            word((uint32_t)v);
+        }
+    }
+};
+
+template <typename... Args>
+inline __attribute__((always_inline)) bool tracelog(const char* fmt, Args... args)
+{
+    TraceLogArgs a;
+    (a.add(args), ...);
+    return tracelog_record(fmt, a.words, a.count);
+}
+
+#define TRACELOG(fmt, ...) tracelog(PSTR(fmt), ##__VA_ARGS__)
+
+#endif
+
+#endif // __CORE_ESP8266_TRACELOG_H
@@ -41,6 +41,14 @@
  implement a simple cache to minimize the amount of times we actually need
  to go out over the (slow) SPI bus.  The SPI is set up in a DIO mode which
  uses no more pins than normal SPI, but provides for ~2X faster transfers.
+ HSPI has no IO2/IO3 lines, so QIO is not possible here; every refill and
+ writeback already is a single burst of one cache line.
+
+ The cache is set associative, its geometry is set with
+ -DMMU_EXTERNAL_HEAP_CACHE_SETS=n (power of 2, default 4),
+ -DMMU_EXTERNAL_HEAP_CACHE_WAYS=n (lines per set, default 2, 0 disables
+ the cache) and -DMMU_EXTERNAL_HEAP_CACHE_WORDS=n (32-bit words per line,
+ power of 2 up to 16, default 16).  A lookup only walks the ways of one set.
 
  NOTE: This works fine for processor accesses, but cannot be used by any
  of the peripherals' DMA.  For that, we'd need a real MMU.
@@ -65,6 +73,7 @@
 #include <esp8266_undocumented.h>
 #include "esp8266_peri.h"
 #include "core_esp8266_vm.h"
+#include "interrupts.h"
 #include "core_esp8266_non32xfer.h"
 #include "umm_malloc/umm_malloc.h"
 
@@ -142,23 +151,49 @@ typedef enum { sio = 0, dio = 1 } iotype;
 
 constexpr int read_delay = (hspi_mode == dio) ? 4-1 : 0;
 
-constexpr int cache_ways = 4;   // N-way, fully associative cache
-constexpr int cache_words = 16; // Must be 16 words or smaller to fit in SPI buffer
+constexpr uint32_t vm_addrmask = 0x1ffff; // Offset into the SRAM of a 0x1xxxxxxx address
+
+// Cache geometry, can be overridden from the build flags.  The cache takes
+// about sets * ways * (words * 4 + 12) bytes of DRAM.
+#ifndef MMU_EXTERNAL_HEAP_CACHE_SETS
+#define MMU_EXTERNAL_HEAP_CACHE_SETS 4
+#endif
+#ifndef MMU_EXTERNAL_HEAP_CACHE_WAYS
+#define MMU_EXTERNAL_HEAP_CACHE_WAYS 2
+#endif
+#ifndef MMU_EXTERNAL_HEAP_CACHE_WORDS
+#define MMU_EXTERNAL_HEAP_CACHE_WORDS 16
+#endif
+
+constexpr int cache_sets = MMU_EXTERNAL_HEAP_CACHE_SETS;   // Set index is hashed from the line address
+constexpr int cache_ways = MMU_EXTERNAL_HEAP_CACHE_WAYS;   // N-way set associative, 0 for no cache
+constexpr int cache_words = MMU_EXTERNAL_HEAP_CACHE_WORDS; // Must be 16 words or smaller to fit in SPI buffer
+static_assert(cache_sets > 0 && (cache_sets & (cache_sets - 1)) == 0, "MMU_EXTERNAL_HEAP_CACHE_SETS must be a power of 2");
+static_assert(cache_words <= 16 && (cache_words & (cache_words - 1)) == 0, "MMU_EXTERNAL_HEAP_CACHE_WORDS must be a power of 2, 16 or less");
+constexpr int cache_lines = cache_ways ? cache_sets * cache_ways : 1;
 
 static struct cache_line {
   int32_t addr;            // Address, lower bits masked off
   int dirty;               // Needs writeback
-  struct cache_line *next; // We'll keep linked list in MRU order
   union {
     uint32_t w[cache_words];
     uint16_t s[cache_words * 2];
     uint8_t  b[cache_words * 4];
   };
-} __vm_cache_line[cache_ways];
+} __vm_cache_line[cache_lines];
+static struct cache_line *__vm_cache_set[cache_sets][cache_ways ? cache_ways : 1]; // Lines of each set in MRU order
 static struct cache_line *__vm_cache; // Always points to MRU (hence the line being read/written)
 
 constexpr int addrmask = ~(sizeof(__vm_cache[0].w)-1); // Helper to mask off bits present in cache entry
 
+// Fold the bits above the set index back in so power-of-two strides (array
+// columns, heap blocks of equal size) don't all land in the same set
+static inline IRAM_ATTR int cache_set(int addr)
+{
+  uint32_t line = (uint32_t)addr / sizeof(__vm_cache[0].w);
+  return (line ^ (line / cache_sets) ^ (line / (cache_sets * cache_sets))) & (cache_sets - 1);
+}
+
 
 static void spi_init(spi_regs *spi1)
 {
@@ -217,25 +252,27 @@ inline IRAM_ATTR uint32_t spi_readtransaction(spi_regs *spi1, int addr, int addr
 static inline IRAM_ATTR void cache_flushrefill(spi_regs *spi1, int addr)
 {
   addr &= addrmask;
-  struct cache_line *way = __vm_cache;
-
   if (__vm_cache->addr == addr) return; // Fast case, it already is the MRU
-  struct cache_line *last = way;
-  way = way->next;
 
-  for (auto i = 1; i < cache_ways; i++) {
+  struct cache_line **set = __vm_cache_set[cache_set(addr)];
+  for (auto i = 0; i < cache_ways; i++) {
+    struct cache_line *way = set[i];
     if (way->addr == addr) {
-      last->next = way->next;
-      way->next = __vm_cache;
+      for (; i > 0; i--) {
+        set[i] = set[i - 1];
+      }
+      set[0] = way;
       __vm_cache = way;
       return;
-    } else {
-      last = way;
-      way = way->next;
     }
   }
 
-  // At this point we know the line is not in the cache and way points to the LRU.
+  // Not in the cache, recycle the LRU line of the set
+  struct cache_line *last = set[cache_ways ? cache_ways - 1 : 0];
+  for (auto i = cache_ways - 1; i > 0; i--) {
+    set[i] = set[i - 1];
+  }
+  set[0] = last;
 
   // We allow reads to go before writes since the write can happen in the background.
   // We need to keep the data to be written back since it will be overwritten with read data
@@ -244,8 +281,6 @@ static inline IRAM_ATTR void cache_flushrefill(spi_regs *spi1, int addr)
     memcpy(wb, last->w, sizeof(last->w));
   }
 
-  // Update MRU info, list
-  last->next = __vm_cache;
   __vm_cache = last;
 
   // Do the actual read
@@ -296,6 +331,135 @@ static inline IRAM_ATTR uint32_t spi_ramread(spi_regs *spi1, int addr, int data_
   }
 }
 
+// Bulk transfers, one SPI transaction per cache line sized chunk instead
+// of one exception per access.  Lines present in the cache are used in
+// place so that the cache stays coherent, other chunks go straight to the
+// SRAM without being allocated in the cache.
+
+constexpr size_t vm_chunk = sizeof(__vm_cache_line[0].w);
+
+static inline bool is_vm(const void *p)
+{
+  return ((uint32_t)p >> 28) == 1;
+}
+
+static inline struct cache_line *cache_find(int addr)
+{
+  if (cache_ways == 0) {
+    return nullptr;
+  }
+  struct cache_line **set = __vm_cache_set[cache_set(addr)];
+  for (auto i = 0; i < cache_ways; i++) {
+    if (set[i]->addr == addr) {
+      return set[i];
+    }
+  }
+  return nullptr;
+}
+
+// The exception handler must not run in the middle of a transaction, and
+// ISRs could touch VM memory, so chunks are done with interrupts off
+static void vm_chunk_read(spi_regs *spi1, uint8_t *dst, uint32_t addr, size_t len)
+{
+  esp8266::InterruptLock lock;
+  struct cache_line *line = cache_find(addr & addrmask);
+  if (line) {
+    memcpy(dst, line->b + (addr - line->addr), len);
+  } else {
+    spi_readtransaction(spi1, (0x03 << 24) | addr, 32-1, read_delay, len * 8 - 1, hspi_mode);
+    memcpy(dst, spi1->spi_w, len);
+  }
+}
+
+static void vm_chunk_write(spi_regs *spi1, uint32_t addr, const uint8_t *src, size_t len)
+{
+  esp8266::InterruptLock lock;
+  struct cache_line *line = cache_find(addr & addrmask);
+  if (line) {
+    memcpy(line->b + (addr - line->addr), src, len);
+    line->dirty = 1;
+  } else {
+    while (spi1->spi_cmd & SPIBUSY) { /* previous writeback still uses spi_w */ }
+    memcpy(spi1->spi_w, src, len);
+    spi_writetransaction(spi1, (0x02 << 24) | addr, 32-1, 0, len * 8 - 1, hspi_mode);
+  }
+}
+
+static inline size_t vm_chunk_len(uint32_t addr, size_t len)
+{
+  size_t room = vm_chunk - (addr & (vm_chunk - 1));
+  return len < room ? len : room;
+}
+
+void vm_read_block(void *dst, const void *src, size_t len)
+{
+  if (!is_vm(src)) {
+    memcpy(dst, src, len);
+    return;
+  }
+  DECLARE_SPI1;
+  uint8_t *d = (uint8_t *)dst;
+  uint32_t addr = (uint32_t)src & vm_addrmask;
+  while (len) {
+    size_t n = vm_chunk_len(addr, len);
+    vm_chunk_read(spi1, d, addr, n);
+    d += n;
+    addr += n;
+    len -= n;
+  }
+}
+
+void vm_write_block(void *dst, const void *src, size_t len)
+{
+  if (!is_vm(dst)) {
+    memcpy(dst, src, len);
+    return;
+  }
+  DECLARE_SPI1;
+  const uint8_t *s = (const uint8_t *)src;
+  uint32_t addr = (uint32_t)dst & vm_addrmask;
+  while (len) {
+    size_t n = vm_chunk_len(addr, len);
+    vm_chunk_write(spi1, addr, s, n);
+    s += n;
+    addr += n;
+    len -= n;
+  }
+}
+
+void *vm_memcpy(void *dst, const void *src, size_t len)
+{
+  if (is_vm(dst) && is_vm(src)) {
+    uint8_t bounce[vm_chunk];
+    for (size_t done = 0; done < len;) {
+      size_t n = vm_chunk_len(((uint32_t)src + done) & vm_addrmask, len - done);
+      vm_read_block(bounce, (const uint8_t *)src + done, n);
+      vm_write_block((uint8_t *)dst + done, bounce, n);
+      done += n;
+    }
+  } else if (is_vm(dst)) {
+    vm_write_block(dst, src, len);
+  } else {
+    vm_read_block(dst, src, len);
+  }
+  return dst;
+}
+
+void *vm_memset(void *dst, int c, size_t len)
+{
+  if (!is_vm(dst)) {
+    return memset(dst, c, len);
+  }
+  uint8_t pattern[vm_chunk];
+  memset(pattern, c, sizeof(pattern));
+  for (size_t done = 0; done < len;) {
+    size_t n = vm_chunk_len(((uint32_t)dst + done) & vm_addrmask, len - done);
+    vm_write_block((uint8_t *)dst + done, pattern, n);
+    done += n;
+  }
+  return dst;
+}
+
 static void (*__old_handler)(struct __exception_frame *ef, int cause);
 
 static IRAM_ATTR void loadstore_exception_handler(struct __exception_frame *ef, int cause)
@@ -324,21 +488,21 @@ static IRAM_ATTR void loadstore_exception_handler(struct __exception_frame *ef,
     uint32_t val = ef->a_reg[regno];
     uint32_t what = insn & STORE_MASK;
     if (what == S8I_MATCH) {
-       spi_ramwrite(spi1, excvaddr & 0x1ffff, 8-1, val);
+       spi_ramwrite(spi1, excvaddr & vm_addrmask, 8-1, val);
     } else if (what == S16I_MATCH) {
-      spi_ramwrite(spi1, excvaddr & 0x1ffff, 16-1, val);
+      spi_ramwrite(spi1, excvaddr & vm_addrmask, 16-1, val);
     } else {
-      spi_ramwrite(spi1, excvaddr & 0x1ffff, 32-1, val);
+      spi_ramwrite(spi1, excvaddr & vm_addrmask, 32-1, val);
     }
   } else {
     if (insn & L32_MASK) {
-      ef->a_reg[regno] = spi_ramread(spi1, excvaddr & 0x1ffff, 32-1);
+      ef->a_reg[regno] = spi_ramread(spi1, excvaddr & vm_addrmask, 32-1);
     } else if (insn & L16_MASK) {
-      ef->a_reg[regno] = spi_ramread(spi1, excvaddr & 0x1ffff, 16-1);
+      ef->a_reg[regno] = spi_ramread(spi1, excvaddr & vm_addrmask, 16-1);
       if ((insn & SIGNED_MASK ) && (ef->a_reg[regno] & 0x8000))
         ef->a_reg[regno] |= 0xffff0000;
     } else {
-      ef->a_reg[regno] = spi_ramread(spi1, excvaddr & 0x1ffff, 8-1);
+      ef->a_reg[regno] = spi_ramread(spi1, excvaddr & vm_addrmask, 8-1);
     }
   }
 }
@@ -381,12 +545,12 @@ void install_vm_exception_handler()
 
   // Bring cache structures to baseline
   if (cache_ways > 0) {
-    for (auto i = 0; i < cache_ways; i++) {
+    for (auto i = 0; i < cache_lines; i++) {
       __vm_cache_line[i].addr = -1; // Invalid, bits set in lower region so will never match
-      __vm_cache_line[i].next = &__vm_cache_line[i+1];
+      __vm_cache_line[i].dirty = 0;
+      __vm_cache_set[i / cache_ways][i % cache_ways] = &__vm_cache_line[i];
     }
     __vm_cache = &__vm_cache_line[0];
-    __vm_cache_line[cache_ways - 1].next = NULL;
   }
 
   // Hook into memory manager
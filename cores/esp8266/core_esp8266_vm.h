@@ -1,9 +1,27 @@
+#include <stddef.h>
+#include <string.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 extern void install_vm_exception_handler();
 
+// Bulk copies to and from the external heap (MMU_EXTERNAL_HEAP) using one
+// SPI transaction per cache line instead of one exception per access.
+// Either side may be a normal pointer, then it is a plain memcpy/memset.
+#ifdef MMU_EXTERNAL_HEAP
+extern void vm_read_block(void *dst, const void *vmsrc, size_t len);
+extern void vm_write_block(void *vmdst, const void *src, size_t len);
+extern void *vm_memcpy(void *dst, const void *src, size_t len);
+extern void *vm_memset(void *dst, int c, size_t len);
+#else
+static inline void vm_read_block(void *dst, const void *vmsrc, size_t len) { memcpy(dst, vmsrc, len); }
+static inline void vm_write_block(void *vmdst, const void *src, size_t len) { memcpy(vmdst, src, len); }
+static inline void *vm_memcpy(void *dst, const void *src, size_t len) { return memcpy(dst, src, len); }
+static inline void *vm_memset(void *dst, int c, size_t len) { return memset(dst, c, len); }
+#endif
+
 
 #ifdef __cplusplus
 };
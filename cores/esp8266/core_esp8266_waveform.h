@@ -115,6 +115,7 @@ void setTimer1Callback(uint32_t (*fn)());
 extern void _setPWMFreq(uint32_t freq);
 extern bool _stopPWM(uint8_t pin);
 extern bool _setPWM(int pin, uint32_t val, uint32_t range);
+extern bool _setPWMMulti(const uint8_t *pins, const uint32_t *vals, size_t count, uint32_t range);
 
 #ifdef __cplusplus
 }
@@ -346,6 +346,75 @@ bool _setPWM(int pin, uint32_t val, uint32_t range) {
   return _setPWM_bound(pin, val, range);
 }
 
+// Called by analogWriteMulti() to change several pins with a single new edge
+// list, taken over by the ISR at the start of the next period.  Returns false
+// without changing anything if they don't all fit.
+extern bool _setPWMMulti_weak(const uint8_t *pins, const uint32_t *vals, size_t count, uint32_t range) __attribute__((weak));
+bool _setPWMMulti_weak(const uint8_t *pins, const uint32_t *vals, size_t count, uint32_t range) {
+  PWMState p;  // Working copy
+  p = pwmState;
+  uint32_t changing = 0;
+  uint32_t adding = 0;
+  for (size_t i = 0; i < count; i++) {
+    changing |= 1 << pins[i];
+    uint32_t cc = (_pwmPeriod * vals[i]) / range;
+    if ((cc != 0) && (cc < _pwmPeriod)) {
+      adding++;
+    }
+  }
+  uint32_t kept = 0;
+  for (uint32_t i = 0; i < p.cnt; i++) {
+    if ((p.mask & (1 << p.pin[i])) && !(changing & (1 << p.pin[i]))) {
+      kept++;
+    }
+  }
+  if (kept + adding > maxPWMs) {
+    return false; // No space left
+  }
+
+  uint32_t high = 0;
+  uint32_t low = 0;
+  for (size_t i = 0; i < count; i++) {
+    stopWaveform(pins[i]);
+    _cleanAndRemovePWM(&p, pins[i]);
+  }
+  for (size_t i = 0; i < count; i++) {
+    // Sanity check for all-on/off, set once the new list is in place
+    uint32_t cc = (_pwmPeriod * vals[i]) / range;
+    if (cc == 0) {
+      low |= 1 << pins[i];
+    } else if (cc >= _pwmPeriod) {
+      high |= 1 << pins[i];
+    } else {
+      _addPWMtoList(p, pins[i], vals[i], range);
+    }
+  }
+  if (!p.mask) {
+    p.cnt = 0;
+  }
+
+  if (pwmState.cnt || p.cnt) {
+    // Set mailbox and wait for ISR to copy it over
+    initTimer();
+    _notifyPWM(&p, true);
+    disableIdleTimer();
+  }
+  for (uint32_t pin = 0; pin <= 16; pin++) {
+    if ((high | low) & (1 << pin)) {
+      digitalWrite(pin, (high & (1 << pin)) ? HIGH : LOW);
+    }
+  }
+
+  // Potentially recalculate the PWM period if the number of pins changed
+  _setPWMFreq(_pwmFreq);
+
+  return true;
+}
+static bool _setPWMMulti_bound(const uint8_t *pins, const uint32_t *vals, size_t count, uint32_t range) __attribute__((weakref("_setPWMMulti_weak")));
+bool _setPWMMulti(const uint8_t *pins, const uint32_t *vals, size_t count, uint32_t range) {
+  return _setPWMMulti_bound(pins, vals, count, range);
+}
+
 // Start up a waveform on a pin, or change the current one.  Will change to the new
 // waveform smoothly on next low->high transition.  For immediate change, stopWaveform()
 // first, then it will immediately begin.
@@ -24,6 +24,7 @@
 #include "osapi.h"
 #include "user_interface.h"
 #include "cont.h"
+#include "Schedule.h"
 
 extern "C" {
 
@@ -38,21 +39,104 @@ static uint32_t micros_overflow_count = 0;
 #define ONCE 0
 #define REPEAT 1
 
+static volatile bool delay_timer_fired = false;
+
+// Time spent in tickless light sleep, when system_get_time() stands still
+static uint64_t micros_slept = 0;
+static uint32_t tickless_min_ms = 0;
+#define TICKLESS_MAX_MS (0xFFFFFFFUL / 1000) // wifi_fpm_do_sleep() limit
+
 void delay_end(void* arg) {
     (void) arg;
+    delay_timer_fired = true;
+    esp_schedule();
+}
+
+void delay_set_tickless(uint32_t min_ms) {
+    tickless_min_ms = min_ms;
+}
+
+static void tickless_wakeup() {
     esp_schedule();
 }
 
+// Forced light sleep for up to `ms` while WiFi is off.  The CPU and the
+// FRC timers stop, so the time is measured with the RTC clock and added
+// to millis()/micros(), and os_timers fire late by the time slept.
+static bool tickless_sleep(unsigned long ms) {
+    const sleep_type_t previous = wifi_fpm_get_sleep_type();
+    if (previous != NONE_SLEEP_T) {
+        // WiFi switched off at boot or by forceSleepBegin()
+        wifi_fpm_do_wakeup();
+        wifi_fpm_close();
+    }
+    wifi_fpm_set_sleep_type(LIGHT_SLEEP_T);
+    wifi_fpm_open();
+    wifi_fpm_set_wakeup_cb(tickless_wakeup);
+    const uint32_t cali = system_rtc_clock_cali_proc(); // us per RTC tick, Q12
+    const uint32_t rtc_start = system_get_rtc_time();
+    const uint32_t frc_start = system_get_time();
+    const bool slept = wifi_fpm_do_sleep(ms * 1000) == 0;
+    if (slept) {
+        // The SDK sleeps once this task yields, the timer is a fallback
+        os_timer_arm(&delay_timer, ms + 1, ONCE);
+        esp_yield();
+        os_timer_disarm(&delay_timer);
+        const uint32_t rtc_us = ((uint64_t)(system_get_rtc_time() - rtc_start) * cali) >> 12;
+        const uint32_t frc_us = system_get_time() - frc_start;
+        if (rtc_us > frc_us) {
+            micros_slept += rtc_us - frc_us;
+        }
+        // Otherwise woken early by a GPIO or ended by an esp_schedule()
+        delay_timer_fired = std::max(rtc_us, frc_us) + 1000 >= ms * 1000;
+    }
+    wifi_fpm_close();
+    if (previous != NONE_SLEEP_T) {
+        wifi_fpm_set_sleep_type(previous);
+        wifi_fpm_open();
+        wifi_fpm_do_sleep(0xFFFFFFF);
+    }
+    return slept;
+}
+
 void __delay(unsigned long ms) {
-    if(ms) {
-        os_timer_setfn(&delay_timer, (os_timer_func_t*) &delay_end, 0);
-        os_timer_arm(&delay_timer, ms, ONCE);
-    } else {
+    if(!ms) {
         esp_schedule();
+        esp_yield();
+        return;
     }
-    esp_yield();
-    if(ms) {
-        os_timer_disarm(&delay_timer);
+
+    // Wake up in time for recurrent scheduled functions, they are run by
+    // esp_yield() when resuming, then sleep again for the remaining time.
+    // An esp_schedule() from elsewhere still ends delay() early.
+    const unsigned long start = millis();
+    unsigned long remaining = ms;
+    os_timer_setfn(&delay_timer, (os_timer_func_t*) &delay_end, 0);
+    while (true) {
+        unsigned long wait = remaining;
+        const uint32_t next_us = get_scheduled_recurrent_delay_us();
+        if (next_us != SCHEDULED_NO_RECURRENT_DELAY) {
+            const unsigned long next_ms = std::max(1UL, (unsigned long)(next_us / 1000U));
+            wait = std::min(wait, next_ms);
+        }
+        delay_timer_fired = false;
+        const bool tickless = tickless_min_ms && wait >= tickless_min_ms && wifi_get_opmode() == NULL_MODE;
+        if (tickless) {
+            wait = std::min(wait, TICKLESS_MAX_MS);
+        }
+        if (!tickless || !tickless_sleep(wait)) {
+            os_timer_arm(&delay_timer, wait, ONCE);
+            esp_yield();
+            os_timer_disarm(&delay_timer);
+        }
+        if (!delay_timer_fired || wait == remaining) {
+            break;
+        }
+        const unsigned long elapsed = millis() - start;
+        if (elapsed >= ms) {
+            break;
+        }
+        remaining = ms - elapsed;
     }
 }
 
@@ -64,145 +148,44 @@ void micros_overflow_tick(void* arg) {
     if(m < micros_at_last_overflow_tick)
         ++micros_overflow_count;
     micros_at_last_overflow_tick = m;
+    millis(); // keeps its state within 2^32us
 }
 
 //---------------------------------------------------------------------------
-// millis() 'magic multiplier' approximation
-//
-// This function corrects the cumulative (296us / usec overflow) drift
-// seen in the original 'millis()' function.
-//
-// Input:
-//    'm' - 32-bit usec counter,           0 <= m <= 0xFFFFFFFF
-//    'c' - 32-bit usec overflow counter   0 <= c <  0x00400000
-// Output:
-//    Returns milliseconds in modulo 0x1,0000,0000 (0 to 0xFFFFFFFF)
-//
-// Notes:
-//
-// 1) This routine approximates the 64-bit integer division,
-//
-//    quotient =  ( 2^32 c + m ) / 1000,
-//
-//    through the use of 'magic' multipliers. A slow division is replaced by
-//    a faster multiply using a scaled multiplicative inverse of the divisor:
-//
-//    quotient =~ ( 2^32 c + m ) * k,  where k = Ceiling[ 2^n / 1000 ]
-//
-//    The precision difference between multiplier and divisor sets the
-//    upper-bound of the dividend which can be successfully divided.
-//
-//    For this application, n = 64, and the divisor (1000) has 10-bits of 
-//    precision. This sets the dividend upper-bound to (64 - 10) = 54 bits,
-//    and that of 'c' to (54 - 32) = 22 bits. This corresponds to a value
-//    for 'c' = 0x0040,0000 , or +570 years of usec counter overflows.
-//
-// 2) A distributed multiply with offset-summing is used find k( 2^32 c + m ):
-//
-//      prd = (2^32 kh + kl) * ( 2^32 c + m )
-//          = 2^64 kh c + 2^32 kl c + 2^32 kh m + kl m
-//               (d)         (c)         (b)       (a)
-//
-//    Graphically, the offset-sums align in little endian like this:
-//                  LS -> MS
-//            32       64       96      128
-//    | a[-1]  |  a[0]  |  a[1]  |  a[2]  |
-//    |       m kl      |    0   |    0   |  a[-1] not needed
-//    |        |       m kh      |        |
-//    |        |       c kl      |        |  a[1] holds the result
-//    |        |        |       c kh      |  a[2] can be discarded
-//
-//    As only the high-word of 'm kl' and low-word of 'c kh' contribute to the
-//    overall result, only (2) 32-bit words are needed for the accumulator.
-//
-// 3) As C++ does not intrinsically test for addition overflows, one must
-//    code specifically to detect them. This approximation skips these
-//    overflow checks for speed, hence the sum,
-//
-//    highword( m kl ) + m kh + c kl  <  (2^64-1),  MUST NOT OVERFLOW.
-//
-//    To meet this criteria, not only do we have to pick 'k' to achieve our
-//    desired precision, we also have to split 'k' appropriately to avoid
-//    any addition overflows.
-//
-//    'k' should be also chosen to align the various products on byte
-//    boundaries to avoid any 64-bit shifts before additions, as they incur
-//    major time penalties. The 'k' chosen for this specific division by 1000
-//    was picked primarily to avoid shifts as well as for precision.
-//
-//    For the reasons list above, this routine is NOT a general one.
-//    Changing divisors could break the overflow requirement and force
-//    picking a 'k' split which requires shifts before additions.
-//
-//              ** Test THOROUGHLY after making changes **
-//
-// 4) Results of time benchmarks run on an ESP8266 Huzzah feather are:
-//
-//         usec   x Orig   Comment
-// Orig:   3.18   1.00     Original code
-// Corr:  13.21   4.15     64-bit reference code
-// Test:   4.60   1.45     64-bit magic multiply, 4x32
-//
-// The magic multiplier routine runs ~3x faster than the reference. Execution
-// times can vary considerably with the numbers being multiplied, so one
-// should derate this factor to around 2x, worst case.
-//
-//   Reference function: corrected millis(), 64-bit arithmetic,
-//                       truncated to 32-bits by return
-//   unsigned long IRAM_ATTR millis_corr_DEBUG( void )
-//   {
-//     // Get usec system time, usec overflow conter
-//     ......
-//     return ( (c * 4294967296 + m) / 1000 );  // 64-bit division is SLOW
-//   } //millis_corr
-//
-// 5) See this link for a good discussion on magic multipliers:
-//    http://ridiculousfish.com/blog/posts/labor-of-division-episode-i.html
-//
-
-#define  MAGIC_1E3_wLO  0x4bc6a7f0    // LS part
-#define  MAGIC_1E3_wHI  0x00418937    // MS part, magic multiplier
+// millis() keeps the last result and the micros() value it was computed
+// at, and only adds the milliseconds elapsed since.  Called often (as by
+// PolledTimeout or the scheduler), that costs a compare, where a full
+// (2^32 c + m) / 1000 needs a 64-bit multiply in software.  It returns
+// the same value as long as the state is refreshed at least every 2^32us,
+// which micros_overflow_tick() does every minute.
+//---------------------------------------------------------------------------
+
+static uint32_t millis_last_us = 0;
+static uint32_t millis_last_ms = 0;
 
 unsigned long IRAM_ATTR millis()
 {
-  union {
-     uint64_t  q;     // Accumulator, 64-bit, little endian
-     uint32_t  a[2];  // ..........., 32-bit  segments
-  } acc;
-  acc.a[1] = 0;       // Zero high-acc
-  
-  // Get usec system time, usec overflow counter
-  uint32_t  m = system_get_time();
-  uint32_t  c = micros_overflow_count +
-                   ((m < micros_at_last_overflow_tick) ? 1 : 0);
-
-  // (a) Init. low-acc with high-word of 1st product. The right-shift
-  //     falls on a byte boundary, hence is relatively quick.
-  
-  acc.q  = ( (uint64_t)( m * (uint64_t)MAGIC_1E3_wLO ) >> 32 );
-
-  // (b) Offset sum, low-acc
-  acc.q += ( m * (uint64_t)MAGIC_1E3_wHI );
-
-  // (c) Offset sum, low-acc
-  acc.q += ( c * (uint64_t)MAGIC_1E3_wLO );
-
-  // (d) Truncated sum, high-acc
-  acc.a[1] += (uint32_t)( c * (uint64_t)MAGIC_1E3_wHI );
-
-  return ( acc.a[1] );  // Extract result, high-acc
-
-} //millis
+    const uint32_t savedPS = xt_rsil(15);
+    const uint32_t elapsed = micros() - millis_last_us;
+    if (elapsed >= 1000) {
+        const uint32_t ms = elapsed < 2000 ? 1 : elapsed / 1000;
+        millis_last_ms += ms;
+        millis_last_us += ms * 1000;
+    }
+    const uint32_t ms = millis_last_ms;
+    xt_wsr_ps(savedPS);
+    return ms;
+}
 
 unsigned long IRAM_ATTR micros() {
-    return system_get_time();
+    return system_get_time() + (uint32_t)micros_slept;
 }
 
 uint64_t IRAM_ATTR micros64() {
     uint32_t low32_us = system_get_time();
     uint32_t high32_us = micros_overflow_count + ((low32_us < micros_at_last_overflow_tick) ? 1 : 0);
     uint64_t duration64_us = (uint64_t)high32_us << 32 | low32_us;
-    return duration64_us;
+    return duration64_us + micros_slept;
 }
 
 void IRAM_ATTR delayMicroseconds(unsigned int us) {
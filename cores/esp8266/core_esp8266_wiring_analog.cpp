@@ -25,6 +25,7 @@
 #include "wiring_private.h"
 #include "pins_arduino.h"
 #include "user_interface.h"
+#include "Schedule.h"
 
 extern "C" {
 
@@ -51,4 +52,115 @@ void __analogReference(uint8_t mode)
 
 extern void analogReference(uint8_t mode) __attribute__ ((weak, alias("__analogReference")));
 
+
+// system_adc_read_fast() only works with the radio off and must not be
+// interrupted, the burst is timed with the cycle counter around it.
+bool analogReadFast(uint16_t *samples, uint16_t count, uint8_t clkDiv, uint32_t *startCycles, uint32_t *periodCycles)
+{
+    if (!samples || !count || clkDiv < 8 || clkDiv > 32 || wifi_get_opmode() != NULL_MODE) {
+        return false;
+    }
+    uint32_t savedPS = xt_rsil(15);
+    uint32_t start = esp_get_cycle_count();
+    system_adc_read_fast(samples, count, clkDiv);
+    uint32_t end = esp_get_cycle_count();
+    xt_wsr_ps(savedPS);
+    if (startCycles) {
+        *startCycles = start;
+    }
+    if (periodCycles) {
+        *periodCycles = (end - start) / count;
+    }
+    return true;
+}
+
+// Block ring filled by a recurrent scheduled function, one burst per call
+static analog_block_t *adc_blocks = nullptr;
+static uint16_t *adc_samples = nullptr;
+static uint8_t adc_block_count = 0;
+static uint16_t adc_block_len = 0;
+static uint8_t adc_clk_div = 0;
+static uint8_t adc_head = 0;    // next block to fill
+static uint8_t adc_queued = 0;  // filled blocks not yet released
+static uint32_t adc_overruns = 0;
+static uint32_t adc_generation = 0;
+
+static bool analogCaptureBlock(uint32_t generation)
+{
+    if (generation != adc_generation) {
+        return false;
+    }
+    if (adc_queued == adc_block_count) {
+        ++adc_overruns;
+        return true;
+    }
+    analog_block_t *block = &adc_blocks[adc_head];
+    if (analogReadFast(block->samples, adc_block_len, adc_clk_div, &block->cycles, &block->period)) {
+        block->count = adc_block_len;
+        adc_head = (adc_head + 1) % adc_block_count;
+        ++adc_queued;
+    }
+    return true;
+}
+
+bool analogCaptureBegin(uint16_t blockSamples, uint8_t blocks, uint8_t clkDiv)
+{
+    analogCaptureEnd();
+    if (!blockSamples || blocks < 2 || clkDiv < 8 || clkDiv > 32) {
+        return false;
+    }
+    adc_blocks = (analog_block_t *)calloc(blocks, sizeof(analog_block_t));
+    adc_samples = (uint16_t *)malloc(blocks * blockSamples * sizeof(uint16_t));
+    if (!adc_blocks || !adc_samples) {
+        analogCaptureEnd();
+        return false;
+    }
+    for (int i = 0; i < blocks; i++) {
+        adc_blocks[i].samples = adc_samples + i * blockSamples;
+    }
+    adc_block_count = blocks;
+    adc_block_len = blockSamples;
+    adc_clk_div = clkDiv;
+    adc_head = 0;
+    adc_queued = 0;
+    adc_overruns = 0;
+    uint32_t generation = ++adc_generation;
+    if (!schedule_recurrent_function_us([generation]() { return analogCaptureBlock(generation); }, 0)) {
+        analogCaptureEnd();
+        return false;
+    }
+    return true;
+}
+
+void analogCaptureEnd()
+{
+    ++adc_generation;
+    free(adc_blocks);
+    free(adc_samples);
+    adc_blocks = nullptr;
+    adc_samples = nullptr;
+    adc_block_count = 0;
+    adc_queued = 0;
+}
+
+const analog_block_t *analogCaptureGet()
+{
+    if (!adc_queued) {
+        return nullptr;
+    }
+    return &adc_blocks[(adc_head + adc_block_count - adc_queued) % adc_block_count];
+}
+
+void analogCaptureRelease()
+{
+    if (adc_queued) {
+        --adc_queued;
+    }
+}
+
+uint32_t analogCaptureOverruns()
+{
+    return adc_overruns;
+}
+
 };
@@ -27,6 +27,7 @@
 #include "user_interface.h"
 #include "core_esp8266_waveform.h"
 #include "interrupts.h"
+#include "GpioPort.h"
 
 extern "C" {
 
@@ -102,6 +103,16 @@ extern int IRAM_ATTR __digitalRead(uint8_t pin) {
   return 0;
 }
 
+extern void gpioPortMode(uint32_t mask, uint8_t mode) {
+  for (uint8_t pin = 0; pin < 16; ++pin) {
+    if (mask & (1 << pin)) {
+      stopWaveform(pin);
+      _stopPWM(pin);
+      pinMode(pin, mode);
+    }
+  }
+}
+
 /*
   GPIO INTERRUPTS
 */
@@ -131,15 +142,41 @@ typedef struct {
 static interrupt_handler_t interrupt_handlers[16] = { {0, 0, 0, 0}, };
 static uint32_t interrupt_reg = 0;
 
+// Edge capture ring, filled by interrupt_handler and drained by captureRead().
+// The ISR only moves capture_head and the reader only capture_tail, so no
+// locking is needed between them.
+static capture_edge_t* capture_ring = nullptr;
+static uint32_t capture_mask = 0; // ring size - 1, a power of 2
+static volatile uint32_t capture_head = 0;
+static volatile uint32_t capture_tail = 0;
+static volatile uint32_t capture_overruns = 0;
+static uint32_t capture_reg = 0;
+
 void IRAM_ATTR interrupt_handler(void *arg, void *frame)
 {
   (void) arg;
   (void) frame;
+  uint32_t cycles = esp_get_cycle_count();
   uint32_t status = GPIE;
   GPIEC = status;//clear them interrupts
   uint32_t levels = GPI;
-  if(status == 0 || interrupt_reg == 0) return;
+  if(status == 0 || (interrupt_reg | capture_reg) == 0) return;
   ETS_GPIO_INTR_DISABLE();
+  uint32_t capturebits = status & capture_reg;
+  while(capturebits){
+    int pin = __builtin_ctz(capturebits);
+    capturebits &= capturebits - 1;
+    uint32_t head = capture_head;
+    if (head - capture_tail > capture_mask) {
+      ++capture_overruns;
+      continue;
+    }
+    capture_edge_t* edge = &capture_ring[head & capture_mask];
+    edge->cycles = cycles;
+    edge->pin = pin;
+    edge->level = !!(levels & (1 << pin));
+    capture_head = head + 1;
+  }
   int i = 0;
   uint32_t changedbits = status & interrupt_reg;
   while(changedbits){
@@ -226,7 +263,7 @@ extern void IRAM_ATTR __detachInterrupt(uint8_t pin) {
         GPIEC = (1 << pin); //Clear Interrupt for this pin
         interrupt_reg &= ~(1 << pin);
 		set_interrupt_handlers(pin, nullptr, nullptr, 0, false);
-        if (interrupt_reg)
+        if (interrupt_reg | capture_reg)
         {
             ETS_GPIO_INTR_ENABLE();
         }
@@ -238,6 +275,80 @@ extern void __attachInterrupt(uint8_t pin, voidFuncPtr userFunc, int mode)
     __attachInterruptFunctionalArg(pin, (voidFuncPtrArg)userFunc, 0, mode, false);
 }
 
+bool captureBegin(size_t entries) {
+  if (entries < 2 || (entries & (entries - 1)) || capture_ring) {
+    return false;
+  }
+  capture_edge_t* ring = (capture_edge_t*)malloc(entries * sizeof(capture_edge_t));
+  if (!ring) {
+    return false;
+  }
+  ETS_GPIO_INTR_DISABLE();
+  capture_ring = ring;
+  capture_mask = entries - 1;
+  capture_head = capture_tail = capture_overruns = 0;
+  if (interrupt_reg) {
+    ETS_GPIO_INTR_ENABLE();
+  }
+  return true;
+}
+
+void captureEnd() {
+  for (int pin = 0; pin < 16; ++pin) {
+    if (capture_reg & (1 << pin)) {
+      captureDetach(pin);
+    }
+  }
+  free(capture_ring);
+  capture_ring = nullptr;
+}
+
+bool captureAttach(uint8_t pin, int mode) {
+  if (pin >= 16 || !capture_ring || (interrupt_reg & (1 << pin))) {
+    return false;
+  }
+  ETS_GPIO_INTR_DISABLE();
+  capture_reg |= (1 << pin);
+  GPC(pin) &= ~(0xF << GPCI);//INT mode disabled
+  GPIEC = (1 << pin); //Clear Interrupt for this pin
+  GPC(pin) |= ((mode & 0xF) << GPCI);//INT mode "mode"
+  ETS_GPIO_INTR_ATTACH(interrupt_handler, &interrupt_reg);
+  ETS_GPIO_INTR_ENABLE();
+  return true;
+}
+
+void captureDetach(uint8_t pin) {
+  if (pin >= 16 || !(capture_reg & (1 << pin))) {
+    return;
+  }
+  ETS_GPIO_INTR_DISABLE();
+  GPC(pin) &= ~(0xF << GPCI);//INT mode disabled
+  GPIEC = (1 << pin); //Clear Interrupt for this pin
+  capture_reg &= ~(1 << pin);
+  if (interrupt_reg | capture_reg) {
+    ETS_GPIO_INTR_ENABLE();
+  }
+}
+
+size_t captureRead(capture_edge_t* edges, size_t count) {
+  size_t n = 0;
+  uint32_t tail = capture_tail;
+  while (n < count && tail != capture_head) {
+    edges[n++] = capture_ring[tail & capture_mask];
+    ++tail;
+  }
+  capture_tail = tail;
+  return n;
+}
+
+size_t captureAvailable() {
+  return capture_head - capture_tail;
+}
+
+uint32_t captureOverruns() {
+  return capture_overruns;
+}
+
 extern void __resetPins() {
   for (int i = 0; i <= 16; ++i) {
     if (!isFlashInterfacePin(i))
@@ -83,6 +83,43 @@ extern void __analogWriteMode(uint8_t pin, int val, bool openDrain) {
   }
 }
 
+extern void __analogWriteMulti(const uint8_t *pins, const int *vals, size_t count) {
+  uint8_t usePins[17];
+  uint32_t useVals[17];
+  uint32_t seen = 0;
+  size_t n = 0;
+  for (size_t i = 0; i < count; i++) {
+    uint8_t pin = pins[i];
+    if ((pin > 16) || (seen & (1UL << pin))) {
+      continue;
+    }
+    seen |= 1UL << pin;
+    int val = vals[i];
+    if (val < 0) {
+      val = 0;
+    } else if (val > analogScale) {
+      val = analogScale;
+    }
+    usePins[n] = pin;
+    useVals[n] = val;
+    n++;
+  }
+
+  for (size_t i = 0; i < n; i++) {
+    if (!(analogMap & (1UL << usePins[i]))) {
+      pinMode(usePins[i], OUTPUT);
+    }
+  }
+  if (n && _setPWMMulti(usePins, useVals, n, analogScale)) {
+    analogMap |= seen;
+    return;
+  }
+  // Too many pins for the PWM generator (or using the phase locked one)
+  for (size_t i = 0; i < n; i++) {
+    analogWrite(usePins[i], useVals[i]);
+  }
+}
+
 extern void __analogWriteRange(uint32_t range) {
   if ((range >= 15) && (range <= 65535)) {
     analogScale = range;
@@ -97,6 +134,7 @@ extern void __analogWriteResolution(int res) {
 
 extern void analogWrite(uint8_t pin, int val) __attribute__((weak, alias("__analogWrite")));
 extern void analogWriteMode(uint8_t pin, int val, bool openDrain) __attribute__((weak, alias("__analogWriteMode")));
+extern void analogWriteMulti(const uint8_t *pins, const int *vals, size_t count) __attribute__((weak, alias("__analogWriteMulti")));
 extern void analogWriteFreq(uint32_t freq) __attribute__((weak, alias("__analogWriteFreq")));
 extern void analogWriteRange(uint32_t range) __attribute__((weak, alias("__analogWriteRange")));
 extern void analogWriteResolution(int res) __attribute__((weak, alias("__analogWriteResolution")));
@@ -26,12 +26,34 @@
  */
 
 #include "wiring_private.h"
+#include "GpioPort.h"
+#include "core_esp8266_waveform.h"
+
+// Pins on the port are driven through its registers, once what
+// digitalWrite() would stop (tone, PWM, waveform) is stopped.
+// GPIO16 takes the digitalWrite() loops.
+
 extern "C" {
 
 uint8_t shiftIn(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder) {
     uint8_t value = 0;
     uint8_t i;
 
+    if(dataPin < 16 && clockPin < 16) {
+        const uint32_t data = 1 << dataPin;
+        const uint32_t clock = 1 << clockPin;
+        stopWaveform(clockPin);
+        _stopPWM(clockPin);
+        for(i = 0; i < 8; ++i) {
+            gpioPortSet(clock);
+            value = bitOrder == LSBFIRST ? value >> 1 : value << 1;
+            if(gpioPortRead() & data)
+                value |= bitOrder == LSBFIRST ? 0x80 : 0x01;
+            gpioPortClear(clock);
+        }
+        return value;
+    }
+
     for(i = 0; i < 8; ++i) {
         digitalWrite(clockPin, HIGH);
         if(bitOrder == LSBFIRST)
@@ -46,6 +68,25 @@ uint8_t shiftIn(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder) {
 void shiftOut(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder, uint8_t val) {
     uint8_t i;
 
+    if(dataPin < 16 && clockPin < 16) {
+        const uint32_t data = 1 << dataPin;
+        const uint32_t clock = 1 << clockPin;
+        stopWaveform(dataPin);
+        _stopPWM(dataPin);
+        stopWaveform(clockPin);
+        _stopPWM(clockPin);
+        for(i = 0; i < 8; i++) {
+            bool bit = bitOrder == LSBFIRST ? val & (1 << i) : val & (1 << (7 - i));
+            if(bit)
+                gpioPortSet(data);
+            else
+                gpioPortClear(data);
+            gpioPortSet(clock);
+            gpioPortClear(clock);
+        }
+        return;
+    }
+
     for(i = 0; i < 8; i++) {
         if(bitOrder == LSBFIRST)
             digitalWrite(dataPin, !!(val & (1 << i)));
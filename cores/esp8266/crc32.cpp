@@ -22,6 +22,28 @@
 #include "coredecls.h"
 #include "pgmspace.h"
 
+// MSB first CRC32, polynomial 0x04c11db7, no reflection and no final xor.
+// The implementation is selected at build time with -DCRC32_TABLE=n:
+//   0  bitwise, no table
+//   1  4 bits at a time, 64 byte table in RAM
+//   2  slice-by-4, 4KB of tables in flash, data read with aligned 32-bit
+//      loads (default)
+// All three give the same result, data may be in RAM or in mapped flash.
+#ifndef CRC32_TABLE
+#define CRC32_TABLE 2
+#endif
+
+static constexpr uint32_t CRC32_POLY = 0x04c11db7;
+
+static constexpr uint32_t crc32_shift(uint32_t crc, int bits)
+{
+    for (int i = 0; i < bits; ++i)
+        crc = (crc & 0x80000000) ? (crc << 1) ^ CRC32_POLY : crc << 1;
+    return crc;
+}
+
+#if CRC32_TABLE == 0
+
 // moved from core_esp8266_eboot_command.cpp
 uint32_t crc32 (const void* data, size_t length, uint32_t crc /*= 0xffffffff*/)
 {
@@ -36,8 +58,86 @@ uint32_t crc32 (const void* data, size_t length, uint32_t crc /*= 0xffffffff*/)
                 bit = !bit;
             crc <<= 1;
             if (bit)
-                crc ^= 0x04c11db7;
+                crc ^= CRC32_POLY;
         }
     }
     return crc;
 }
+
+#elif CRC32_TABLE == 1
+
+struct crc32_nibble_table
+{
+    uint32_t t[16];
+    constexpr crc32_nibble_table(): t()
+    {
+        for (uint32_t n = 0; n < 16; ++n)
+            t[n] = crc32_shift(n << 28, 4);
+    }
+};
+
+static const crc32_nibble_table crc32_nibbles;
+
+uint32_t crc32 (const void* data, size_t length, uint32_t crc /*= 0xffffffff*/)
+{
+    const uint8_t* ldata = (const uint8_t*)data;
+    while (length--)
+    {
+        uint8_t c = pgm_read_byte(ldata++);
+        crc = (crc << 4) ^ crc32_nibbles.t[(crc >> 28) ^ (c >> 4)];
+        crc = (crc << 4) ^ crc32_nibbles.t[(crc >> 28) ^ (c & 0xf)];
+    }
+    return crc;
+}
+
+#else
+
+// t[k][b]: CRC of byte b followed by k zero bytes
+struct crc32_slice4_tables
+{
+    uint32_t t[4][256];
+    constexpr crc32_slice4_tables(): t()
+    {
+        for (uint32_t b = 0; b < 256; ++b)
+            t[0][b] = crc32_shift(b << 24, 8);
+        for (int k = 1; k < 4; ++k)
+            for (uint32_t b = 0; b < 256; ++b)
+                t[k][b] = (t[k - 1][b] << 8) ^ t[0][t[k - 1][b] >> 24];
+    }
+};
+
+static const crc32_slice4_tables crc32_slices PROGMEM;
+
+static inline uint32_t crc32_table(int k, uint32_t b)
+{
+    return pgm_read_dword(&crc32_slices.t[k][b]);
+}
+
+static inline uint32_t crc32_byte(uint32_t crc, uint8_t c)
+{
+    return (crc << 8) ^ crc32_table(0, (crc >> 24) ^ c);
+}
+
+uint32_t crc32 (const void* data, size_t length, uint32_t crc /*= 0xffffffff*/)
+{
+    const uint8_t* ldata = (const uint8_t*)data;
+    while (length && ((uintptr_t)ldata & 3))
+    {
+        crc = crc32_byte(crc, pgm_read_byte(ldata++));
+        --length;
+    }
+    // aligned loads work on flash as well as on RAM
+    const uint32_t* words = (const uint32_t*)ldata;
+    for (; length >= 4; length -= 4)
+    {
+        crc ^= __builtin_bswap32(*words++);
+        crc = crc32_table(3, crc >> 24) ^ crc32_table(2, (crc >> 16) & 0xff)
+            ^ crc32_table(1, (crc >> 8) & 0xff) ^ crc32_table(0, crc & 0xff);
+    }
+    ldata = (const uint8_t*)words;
+    while (length--)
+        crc = crc32_byte(crc, pgm_read_byte(ldata++));
+    return crc;
+}
+
+#endif
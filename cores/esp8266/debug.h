@@ -4,7 +4,11 @@
 #include <stddef.h>
 #include <stdint.h>
 
-#ifdef DEBUG_ESP_CORE
+#if defined(DEBUG_ESP_CORE) && defined(DEBUG_ESP_TRACELOG) && defined(__cplusplus)
+// recorded, see core_esp8266_tracelog.h
+#include "core_esp8266_tracelog.h"
+#define DEBUGV(fmt, ...) TRACELOG(fmt, ## __VA_ARGS__)
+#elif defined(DEBUG_ESP_CORE)
 #define DEBUGV(fmt, ...) ::printf((PGM_P)PSTR(fmt), ## __VA_ARGS__)
 #endif
 
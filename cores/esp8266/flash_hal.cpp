@@ -29,21 +29,100 @@ extern "C" {
 #include "spi_flash.h"
 }
 
+#if FLASH_HAL_CACHE_LINES > 0
+// Small read-through cache of aligned flash lines.  Filesystems read many
+// short, unaligned headers from the same few pages; serving them from RAM
+// saves a SPI transaction and the bounce buffer of the unaligned path.
+// Writes and erases keep it coherent, also when done through ESP.flash*().
+namespace {
+struct FlashCacheLine {
+    uint32_t addr = ~0U;
+    uint32_t lastUse = 0;
+    uint32_t data[FLASH_HAL_CACHE_LINE / 4];
+};
+
+FlashCacheLine s_cache[FLASH_HAL_CACHE_LINES];
+uint32_t s_cacheTick = 0;
+}
+
+void flash_hal_cache_invalidate(uint32_t addr, uint32_t size) {
+    for (auto& line : s_cache) {
+        if (line.addr != ~0U && line.addr < addr + size && addr < line.addr + FLASH_HAL_CACHE_LINE) {
+            line.addr = ~0U;
+        }
+    }
+}
+
+static FlashCacheLine* flash_hal_cache_line(uint32_t lineAddr) {
+    FlashCacheLine* victim = &s_cache[0];
+    for (auto& line : s_cache) {
+        if (line.addr == lineAddr) {
+            line.lastUse = ++s_cacheTick;
+            return &line;
+        }
+        if (line.addr == ~0U || (victim->addr != ~0U && line.lastUse < victim->lastUse)) {
+            victim = &line;
+        }
+    }
+    victim->addr = ~0U;
+    if (!ESP.flashRead(lineAddr, victim->data, FLASH_HAL_CACHE_LINE)) {
+        return nullptr;
+    }
+    victim->addr = lineAddr;
+    victim->lastUse = ++s_cacheTick;
+    return victim;
+}
+#else
+void flash_hal_cache_invalidate(uint32_t addr, uint32_t size) {
+    (void) addr;
+    (void) size;
+}
+#endif
+
 int32_t flash_hal_read(uint32_t addr, uint32_t size, uint8_t *dst) {
     optimistic_yield(10000);
 
+#if FLASH_HAL_CACHE_LINES > 0
+    while (size) {
+        const uint32_t lineAddr = addr & ~(FLASH_HAL_CACHE_LINE - 1);
+        const uint32_t lineOff = addr - lineAddr;
+        if (lineOff == 0 && size >= FLASH_HAL_CACHE_LINE) {
+            // Bulk part, read directly without evicting anything
+            const uint32_t bulk = size & ~(FLASH_HAL_CACHE_LINE - 1);
+            if (!ESP.flashRead(addr, dst, bulk)) {
+                return FLASH_HAL_READ_ERROR;
+            }
+            addr += bulk;
+            dst += bulk;
+            size -= bulk;
+            continue;
+        }
+        const uint32_t len = std::min(size, FLASH_HAL_CACHE_LINE - lineOff);
+        FlashCacheLine* line = flash_hal_cache_line(lineAddr);
+        if (!line) {
+            return FLASH_HAL_READ_ERROR;
+        }
+        memcpy(dst, reinterpret_cast<const uint8_t*>(line->data) + lineOff, len);
+        addr += len;
+        dst += len;
+        size -= len;
+    }
+    return FLASH_HAL_OK;
+#else
     // We use flashRead overload that handles proper alignment
     if (ESP.flashRead(addr, dst, size)) {
         return FLASH_HAL_OK;
     } else {
         return FLASH_HAL_READ_ERROR;
     }
+#endif
 }
 
 int32_t flash_hal_write(uint32_t addr, uint32_t size, const uint8_t *src) {
     optimistic_yield(10000);
 
-    // We use flashWrite overload that handles proper alignment
+    // We use flashWrite overload that handles proper alignment,
+    // it invalidates the cached lines it touches
     if (ESP.flashWrite(addr, src, size)) {
         return FLASH_HAL_OK;
     } else {
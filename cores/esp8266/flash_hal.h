@@ -42,8 +42,21 @@ extern "C" uint32_t _FS_block;
 #define FLASH_HAL_WRITE_ERROR (-2)
 #define FLASH_HAL_ERASE_ERROR (-3)
 
+// flash_hal_read() keeps the last few short reads in FLASH_HAL_CACHE_LINES
+// aligned lines of FLASH_HAL_CACHE_LINE bytes, set the former to 0 to
+// disable it.
+#ifndef FLASH_HAL_CACHE_LINES
+#define FLASH_HAL_CACHE_LINES (2)
+#endif
+#ifndef FLASH_HAL_CACHE_LINE
+#define FLASH_HAL_CACHE_LINE  (64U)
+#endif
+
 extern int32_t flash_hal_write(uint32_t addr, uint32_t size, const uint8_t *src);
 extern int32_t flash_hal_erase(uint32_t addr, uint32_t size);
 extern int32_t flash_hal_read(uint32_t addr, uint32_t size, uint8_t *dst);
+// Drop cached data for a range written without flash_hal, ESP.flashWrite()
+// and ESP.flashEraseSector() already call it
+extern void flash_hal_cache_invalidate(uint32_t addr, uint32_t size);
 
 #endif // !defined(flash_hal_h)
@@ -28,6 +28,13 @@ extern "C" {
 #include "spi_vendors.h"
 #include "spi_flash_defs.h"
 
+// FLASH_FAST_MODE() flags.  The flash chip's JEDEC ID is looked up in a
+// table of chips known to read at 80MHz and in QIO, those the boot header
+// sets to 40MHz and/or DIO/DOUT are raised.  QIO also needs GPIO9 and
+// GPIO10 wired to the chip's /HOLD and /WP pins and not used otherwise.
+#define FLASH_FAST_CLOCK 0x01
+#define FLASH_FAST_QIO   0x02
+
 namespace experimental {
 
 void initFlashQuirks();
@@ -26,7 +26,7 @@ extern "C" {
 #undef realloc
 #undef free
 
-#elif defined(DEBUG_ESP_OOM) || defined(UMM_INTEGRITY_CHECK)
+#elif defined(DEBUG_ESP_OOM) || defined(UMM_INTEGRITY_CHECK) || defined(UMM_HEAP_PROFILE)
 #define UMM_MALLOC(s)           umm_malloc(s)
 #define UMM_CALLOC(n,s)         umm_calloc(n,s)
 #define UMM_REALLOC_FL(p,s,f,l) umm_realloc(p,s)
@@ -127,6 +127,73 @@ int umm_last_fail_alloc_line = 0;
     }
 #endif
 
+#if defined(UMM_HEAP_PROFILE)
+/*
+  Allocation call-site profiler, see UMM_HEAP_PROFILE in umm_malloc_cfg.h.
+  It sits on top of the UMM_* layer selected above, so with poisoning enabled
+  the tag lives inside the poisoned user area. `caller` is evaluated in the
+  public wrapper, the return address there is the allocating code.
+*/
+static void* IRAM_ATTR profile_malloc(size_t size, const void* caller)
+{
+    if (0 == size) {
+        return UMM_MALLOC(0);
+    }
+    return umm_heap_profile_tag(UMM_MALLOC(size + UMM_HEAP_PROFILE_TAG_SIZE), size, caller);
+}
+
+static void* IRAM_ATTR profile_calloc(size_t count, size_t size, const void* caller)
+{
+    size_t total = count * size;
+    if (0 == total) {
+        return UMM_CALLOC(count, size);
+    }
+    return umm_heap_profile_tag(UMM_CALLOC(1, total + UMM_HEAP_PROFILE_TAG_SIZE), total, caller);
+}
+
+static void* IRAM_ATTR profile_realloc_fl(void* ptr, size_t size, const char* file, int line, const void* caller)
+{
+    if (NULL == ptr) {
+        return profile_malloc(size, caller);
+    }
+
+    size_t old_size = umm_heap_profile_untag(ptr);
+    void* base = (void*)((uintptr_t)ptr - UMM_HEAP_PROFILE_TAG_SIZE);
+    if (0 == size) {
+        UMM_FREE_FL(base, file, line);
+        return NULL;
+    }
+
+    void* ret = UMM_REALLOC_FL(base, size + UMM_HEAP_PROFILE_TAG_SIZE, file, line);
+    if (ret) {
+        return umm_heap_profile_tag(ret, size, caller);
+    }
+
+    // Failed, the old allocation is still there and now booked on this caller
+    umm_heap_profile_tag(base, old_size, caller);
+    return NULL;
+}
+
+static void IRAM_ATTR profile_free_fl(void* ptr, const char* file, int line)
+{
+    if (ptr) {
+        umm_heap_profile_untag(ptr);
+        ptr = (void*)((uintptr_t)ptr - UMM_HEAP_PROFILE_TAG_SIZE);
+    }
+    UMM_FREE_FL(ptr, file, line);
+}
+
+#define HEAP_MALLOC(s)           profile_malloc(s, __builtin_return_address(0))
+#define HEAP_CALLOC(n,s)         profile_calloc(n, s, __builtin_return_address(0))
+#define HEAP_REALLOC_FL(p,s,f,l) profile_realloc_fl(p, s, f, l, __builtin_return_address(0))
+#define HEAP_FREE_FL(p,f,l)      profile_free_fl(p, f, l)
+#else
+#define HEAP_MALLOC(s)           UMM_MALLOC(s)
+#define HEAP_CALLOC(n,s)         UMM_CALLOC(n,s)
+#define HEAP_REALLOC_FL(p,s,f,l) UMM_REALLOC_FL(p,s,f,l)
+#define HEAP_FREE_FL(p,f,l)      UMM_FREE_FL(p,f,l)
+#endif
+
 void* _malloc_r(struct _reent* unused, size_t size)
 {
     (void) unused;
@@ -213,7 +280,7 @@ void IRAM_ATTR print_oom_size(size_t size)
 #define OOM_CHECK__PRINT_LOC(p, s, f, l)
 #endif
 
-#if defined(DEBUG_ESP_OOM) || defined(UMM_POISON_CHECK) || defined(UMM_POISON_CHECK_LITE) || defined(UMM_INTEGRITY_CHECK)
+#if defined(DEBUG_ESP_OOM) || defined(UMM_POISON_CHECK) || defined(UMM_POISON_CHECK_LITE) || defined(UMM_INTEGRITY_CHECK) || defined(UMM_HEAP_PROFILE)
 /*
   The thinking behind the ordering of Integrity Check, Full Poison Check, and
   the specific *alloc function.
@@ -236,7 +303,7 @@ void* IRAM_ATTR malloc(size_t size)
 {
     INTEGRITY_CHECK__ABORT();
     POISON_CHECK__ABORT();
-    void* ret = UMM_MALLOC(size);
+    void* ret = HEAP_MALLOC(size);
     PTR_CHECK__LOG_LAST_FAIL(ret, size);
     OOM_CHECK__PRINT_OOM(ret, size);
     return ret;
@@ -246,7 +313,7 @@ void* IRAM_ATTR calloc(size_t count, size_t size)
 {
     INTEGRITY_CHECK__ABORT();
     POISON_CHECK__ABORT();
-    void* ret = UMM_CALLOC(count, size);
+    void* ret = HEAP_CALLOC(count, size);
     PTR_CHECK__LOG_LAST_FAIL(ret, count * size);
     OOM_CHECK__PRINT_OOM(ret, size);
     return ret;
@@ -255,7 +322,7 @@ void* IRAM_ATTR calloc(size_t count, size_t size)
 void* IRAM_ATTR realloc(void* ptr, size_t size)
 {
     INTEGRITY_CHECK__ABORT();
-    void* ret = UMM_REALLOC_FL(ptr, size, NULL, 0);
+    void* ret = HEAP_REALLOC_FL(ptr, size, NULL, 0);
     POISON_CHECK__ABORT();
     PTR_CHECK__LOG_LAST_FAIL(ret, size);
     OOM_CHECK__PRINT_OOM(ret, size);
@@ -265,7 +332,7 @@ void* IRAM_ATTR realloc(void* ptr, size_t size)
 void IRAM_ATTR free(void* p)
 {
     INTEGRITY_CHECK__ABORT();
-    UMM_FREE_FL(p, NULL, 0);
+    HEAP_FREE_FL(p, NULL, 0);
     POISON_CHECK__ABORT();
 }
 #endif
@@ -275,7 +342,7 @@ void* IRAM_ATTR heap_pvPortMalloc(size_t size, const char* file, int line)
 {
     INTEGRITY_CHECK__PANIC_FL(file, line);
     POISON_CHECK__PANIC_FL(file, line);
-    void* ret = UMM_MALLOC(size);
+    void* ret = HEAP_MALLOC(size);
     PTR_CHECK__LOG_LAST_FAIL_FL(ret, size, file, line);
     OOM_CHECK__PRINT_LOC(ret, size, file, line);
     return ret;
@@ -286,7 +353,7 @@ void* IRAM_ATTR heap_pvPortCalloc(size_t count, size_t size, const char* file, i
 {
     INTEGRITY_CHECK__PANIC_FL(file, line);
     POISON_CHECK__PANIC_FL(file, line);
-    void* ret = UMM_CALLOC(count, size);
+    void* ret = HEAP_CALLOC(count, size);
     PTR_CHECK__LOG_LAST_FAIL_FL(ret, count * size, file, line);
     OOM_CHECK__PRINT_LOC(ret, size, file, line);
     return ret;
@@ -296,7 +363,7 @@ STATIC_ALWAYS_INLINE
 void* IRAM_ATTR heap_pvPortRealloc(void *ptr, size_t size, const char* file, int line)
 {
     INTEGRITY_CHECK__PANIC_FL(file, line);
-    void* ret = UMM_REALLOC_FL(ptr, size, file, line);
+    void* ret = HEAP_REALLOC_FL(ptr, size, file, line);
     POISON_CHECK__PANIC_FL(file, line);
     PTR_CHECK__LOG_LAST_FAIL_FL(ret, size, file, line);
     OOM_CHECK__PRINT_LOC(ret, size, file, line);
@@ -308,7 +375,7 @@ void* IRAM_ATTR heap_pvPortZalloc(size_t size, const char* file, int line)
 {
     INTEGRITY_CHECK__PANIC_FL(file, line);
     POISON_CHECK__PANIC_FL(file, line);
-    void* ret = UMM_CALLOC(1, size);
+    void* ret = HEAP_CALLOC(1, size);
     PTR_CHECK__LOG_LAST_FAIL_FL(ret, size, file, line);
     OOM_CHECK__PRINT_LOC(ret, size, file, line);
     return ret;
@@ -318,7 +385,7 @@ STATIC_ALWAYS_INLINE
 void IRAM_ATTR heap_vPortFree(void *ptr, const char* file, int line)
 {
     INTEGRITY_CHECK__PANIC_FL(file, line);
-    UMM_FREE_FL(ptr, file, line);
+    HEAP_FREE_FL(ptr, file, line);
     POISON_CHECK__PANIC_FL(file, line);
 }
 
@@ -327,6 +394,74 @@ size_t IRAM_ATTR xPortWantedSizeAlign(size_t size)
     return (size + 3) & ~((size_t) 3);
 }
 
+/*
+  Routing of allocations by object class.  IRAM is only usable for data that
+  is accessed 32 bits at a time (or through the non32xfer handler, at a cost)
+  and never by DMA, these classes let libraries say what a buffer is and
+  leave the choice of Heap to one table.
+*/
+#ifdef UMM_HEAP_IRAM
+#define UMM_CLASS_HEAP_WORD32 UMM_HEAP_IRAM
+#else
+#define UMM_CLASS_HEAP_WORD32 UMM_HEAP_DRAM
+#endif
+
+static size_t umm_class_heap[UMM_HEAP_CLASS_COUNT] = {
+    UMM_HEAP_CLASS_CURRENT, // UMM_HEAP_CLASS_DEFAULT
+    UMM_CLASS_HEAP_WORD32,  // UMM_HEAP_CLASS_IOBUF
+    UMM_CLASS_HEAP_WORD32,  // UMM_HEAP_CLASS_WORD32
+    UMM_HEAP_DRAM,          // UMM_HEAP_CLASS_DMA
+};
+
+size_t umm_get_class_heap(umm_heap_class_t cls)
+{
+    return (cls < UMM_HEAP_CLASS_COUNT) ? umm_class_heap[cls] : UMM_HEAP_CLASS_CURRENT;
+}
+
+void umm_set_class_heap(umm_heap_class_t cls, size_t heap_id)
+{
+    if (cls < UMM_HEAP_CLASS_COUNT && cls != UMM_HEAP_CLASS_DMA &&
+        (heap_id == UMM_HEAP_CLASS_CURRENT || heap_id < UMM_NUM_HEAPS)) {
+        umm_class_heap[cls] = heap_id;
+    }
+}
+
+void *umm_class_malloc(umm_heap_class_t cls, size_t size)
+{
+    const size_t id = umm_get_class_heap(cls);
+    if (id == UMM_HEAP_CLASS_CURRENT) {
+        return malloc(size);
+    }
+    void *ptr;
+    {
+        HeapSelect ephemeral(id);
+        ptr = malloc(size);
+    }
+    if (!ptr && id != UMM_HEAP_DRAM) {
+        HeapSelectDram ephemeral;
+        ptr = malloc(size);
+    }
+    return ptr;
+}
+
+void *umm_class_calloc(umm_heap_class_t cls, size_t num, size_t size)
+{
+    const size_t id = umm_get_class_heap(cls);
+    if (id == UMM_HEAP_CLASS_CURRENT) {
+        return calloc(num, size);
+    }
+    void *ptr;
+    {
+        HeapSelect ephemeral(id);
+        ptr = calloc(num, size);
+    }
+    if (!ptr && id != UMM_HEAP_DRAM) {
+        HeapSelectDram ephemeral;
+        ptr = calloc(num, size);
+    }
+    return ptr;
+}
+
 void system_show_malloc(void)
 {
     HeapSelectDram ephemeral;
@@ -364,7 +499,7 @@ void* IRAM_ATTR pvPortZalloc(size_t size, const char* file, int line)
 
 void IRAM_ATTR vPortFree(void *ptr, const char* file, int line)
 {
-#if defined(DEBUG_ESP_OOM) || defined(UMM_POISON_CHECK) || defined(UMM_POISON_CHECK_LITE) || defined(UMM_INTEGRITY_CHECK)
+#if defined(DEBUG_ESP_OOM) || defined(UMM_POISON_CHECK) || defined(UMM_POISON_CHECK_LITE) || defined(UMM_INTEGRITY_CHECK) || defined(UMM_HEAP_PROFILE)
     // This is only needed for debug checks to ensure they are performed in
     // correct context. umm_malloc free internally determines the correct heap.
     HeapSelectDram ephemeral;
@@ -275,6 +275,7 @@
 #include <esp8266_peri.h>
 #include <uart.h>
 #include <pgmspace.h>
+#include "core_esp8266_crashlog.h"
 
 extern "C" {
 #include <user_interface.h>
@@ -965,6 +966,26 @@ STATIC void IRAM_MAYBE handle_hwdt(void) {
             if (hwdt_info.cont_integrity) {
                 ETS_PRINTF("\nCaution, the stack is possibly corrupt integrity checks did not pass.\n\n");
             }
+
+            /*
+             * Crash record for ESP.crashLog*(). The SP at the reset is not
+             * known, so the frames come from the deepest use of the stack
+             * that was active (only a hint), or from the cont SP it yielded at.
+             */
+            crashlog_record_t record;
+            ets_memset(&record, 0, sizeof(record));
+            record.reason = REASON_WDT_RST;
+            record.ctx = CRASHLOG_CTX_AT_BOOT;
+            if (0 == hwdt_info.cont_integrity && 0 == g_pcont->pc_yield && ctx_cont_ptr) {
+                record.ctx |= CRASHLOG_CTX_CONT;
+                record.sp = (uintptr_t)ctx_cont_ptr;
+                record.depth = crashlog_collect_frames(record.frames, ctx_cont_ptr, g_pcont->stack_end);
+            } else {
+                record.ctx |= CRASHLOG_CTX_SYS;
+                record.sp = (uintptr_t)ctx_sys_ptr;
+                record.depth = crashlog_collect_frames(record.frames, ctx_sys_ptr, ROM_STACK);
+            }
+            crashlog_add(&record);
         }
     }
 
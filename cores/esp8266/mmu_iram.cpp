@@ -189,4 +189,90 @@ extern "C" void pinMode( uint8_t pin, uint8_t mode ) {
 
 #endif  // #if (MMU_ICACHE_SIZE == 0x4000)
 
+/*
+ * Block routines for IRAM (and ICACHE for reads) built on aligned 32-bit
+ * accesses only, so they never go through the non32xfer exception handler.
+ * They work on DRAM as well, either side may be anywhere.
+ */
+void *mmu_memcpy(void *dst, const void *src, size_t n) {
+  uint8_t *d = (uint8_t *)dst;
+  const uint8_t *s = (const uint8_t *)src;
+  if ((((uintptr_t)d ^ (uintptr_t)s) & 3) == 0) {
+    while (n && ((uintptr_t)d & 3)) {
+      mmu_set_uint8(d++, mmu_get_uint8(s++));
+      --n;
+    }
+    uint32_t *d32 = (uint32_t *)d;
+    const uint32_t *s32 = (const uint32_t *)s;
+    for (; n >= 4; n -= 4) {
+      *d32++ = *s32++;
+    }
+    d = (uint8_t *)d32;
+    s = (const uint8_t *)s32;
+  } else if (((uintptr_t)d & 3) == 0) {
+    // Unaligned source: assemble each destination word from two source words
+    const uint32_t *s32 = (const uint32_t *)((uintptr_t)s & ~3);
+    const uint32_t shift = ((uintptr_t)s & 3) * 8;
+    uint32_t *d32 = (uint32_t *)d;
+    uint32_t lo = *s32++;
+    for (; n >= 4; n -= 4) {
+      uint32_t hi = *s32++;
+      *d32++ = (lo >> shift) | (hi << (32 - shift));
+      lo = hi;
+    }
+    d = (uint8_t *)d32;
+    s = (const uint8_t *)src + ((uint8_t *)d - (uint8_t *)dst);
+  }
+  while (n--) {
+    mmu_set_uint8(d++, mmu_get_uint8(s++));
+  }
+  return dst;
+}
+
+void *mmu_memset(void *dst, int c, size_t n) {
+  uint8_t *d = (uint8_t *)dst;
+  while (n && ((uintptr_t)d & 3)) {
+    mmu_set_uint8(d++, c);
+    --n;
+  }
+  uint32_t pattern = (uint8_t)c * 0x01010101u;
+  uint32_t *d32 = (uint32_t *)d;
+  for (; n >= 4; n -= 4) {
+    *d32++ = pattern;
+  }
+  d = (uint8_t *)d32;
+  while (n--) {
+    mmu_set_uint8(d++, c);
+  }
+  return dst;
+}
+
+size_t mmu_strlen(const char *str) {
+  const uint32_t *p32 = (const uint32_t *)((uintptr_t)str & ~3);
+  uint32_t pos = (uintptr_t)str & 3;
+  uint32_t word = *p32++ >> (pos * 8);
+  size_t len = 0;
+  for (;;) {
+    for (; pos < 4; ++pos, ++len, word >>= 8) {
+      if ((word & 0xff) == 0) {
+        return len;
+      }
+    }
+    word = *p32++;
+    pos = 0;
+  }
+}
+
+int mmu_memcmp(const void *a, const void *b, size_t n) {
+  const uint8_t *pa = (const uint8_t *)a;
+  const uint8_t *pb = (const uint8_t *)b;
+  while (n--) {
+    int diff = (int)mmu_get_uint8(pa++) - (int)mmu_get_uint8(pb++);
+    if (diff) {
+      return diff;
+    }
+  }
+  return 0;
+}
+
 };
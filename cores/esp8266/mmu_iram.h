@@ -17,6 +17,7 @@
 #ifndef __MMU_IRAM_H
 #define __MMU_IRAM_H
 
+#include <stddef.h>
 #include <stdint.h>
 #include <c_types.h>
 #include <assert.h>
@@ -197,6 +198,17 @@ int16_t mmu_set_int16(int16_t *p16, const int16_t val) {
   return val;
 }
 
+/*
+ * memcpy/memset/strlen/memcmp equivalents that only use aligned 32-bit
+ * accesses, for byte buffers kept in IRAM (e.g. allocated from the IRAM
+ * heap).  Either argument may also be in DRAM; source arguments may be in
+ * ICACHE (flash).
+ */
+void *mmu_memcpy(void *dst, const void *src, size_t n);
+void *mmu_memset(void *dst, int c, size_t n);
+size_t mmu_strlen(const char *str);
+int mmu_memcmp(const void *a, const void *b, size_t n);
+
 #if (MMU_IRAM_SIZE > 32*1024) && !defined(MMU_SEC_HEAP)
 extern void _text_end(void);
 #define MMU_SEC_HEAP mmu_sec_heap()
@@ -216,6 +228,54 @@ size_t mmu_sec_heap_size(void) {
 
 #ifdef __cplusplus
 }
+
+#include <string.h>
+#include <type_traits>
+
+/*
+ * Type safe versions of the accessors above: mmu_get(p) and mmu_set(p, v)
+ * for any trivially copyable type of 1, 2 or 4 bytes, naturally aligned.
+ * e.g. `mmu_set(&iram_buf[i], mmu_get(&iram_buf[i]) + 1);`
+ */
+template <typename T>
+static inline __attribute__((always_inline))
+T mmu_get(const T *p) {
+  static_assert(std::is_trivially_copyable<T>::value && (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4),
+    "mmu_get() needs a trivially copyable type of 1, 2 or 4 bytes");
+  T val;
+  if constexpr (sizeof(T) == 4) {
+    uint32_t v = *(const uint32_t *)p;
+    __builtin_memcpy(&val, &v, sizeof(T));
+  } else if constexpr (sizeof(T) == 2) {
+    uint16_t v = mmu_get_uint16((const uint16_t *)p);
+    __builtin_memcpy(&val, &v, sizeof(T));
+  } else {
+    uint8_t v = mmu_get_uint8(p);
+    __builtin_memcpy(&val, &v, sizeof(T));
+  }
+  return val;
+}
+
+template <typename T>
+static inline __attribute__((always_inline))
+T mmu_set(T *p, const T val) {
+  static_assert(std::is_trivially_copyable<T>::value && (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4),
+    "mmu_set() needs a trivially copyable type of 1, 2 or 4 bytes");
+  if constexpr (sizeof(T) == 4) {
+    uint32_t v;
+    __builtin_memcpy(&v, &val, sizeof(T));
+    *(uint32_t *)p = v;
+  } else if constexpr (sizeof(T) == 2) {
+    uint16_t v;
+    __builtin_memcpy(&v, &val, sizeof(T));
+    mmu_set_uint16((uint16_t *)p, v);
+  } else {
+    uint8_t v;
+    __builtin_memcpy(&v, &val, sizeof(T));
+    mmu_set_uint8(p, v);
+  }
+  return val;
+}
 #endif
 
 #endif
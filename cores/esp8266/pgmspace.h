@@ -5,6 +5,7 @@
 // to preserve backwards compatibility
 
 #include <sys/pgmspace.h>
+#include "core_esp8266_pgmspace.h"
 
 #ifdef __ets__
 
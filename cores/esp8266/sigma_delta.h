@@ -40,6 +40,10 @@ Usage :
 2. sigmaDeltaAttachPin(pin), any pin 0..15, TBC if gpio16 supports sigma-delta source
      This will set the pin to NORMAL output mode (pinMode(pin,OUTPUT))
 3. sigmaDeltaWrite(0,dc) : set the output signal duty cycle, duty cycle = dc/256
+4. sigmaDeltaAttachPins(mask) : several pins at once, the generator is shared so
+     they all output the same signal
+5. sigmaDeltaPlay(table,count,rate,loop) : play a table of duty cycles at rate
+     steps per second from the timer1 interrupt, e.g. a tone envelope or a fade
 
 *******************************************************************************/
 
@@ -59,11 +63,21 @@ uint8_t     sigmaDeltaRead(uint8_t channel = 0);
 void        sigmaDeltaAttachPin(uint8_t pin, uint8_t channel = 0);
 void        sigmaDeltaDetachPin(uint8_t pin);
 bool        sigmaDeltaIsPinAttached(uint8_t pin);
+// several pins at once, bit mask of pins 0..15
+void        sigmaDeltaAttachPins(uint16_t pins);
+void        sigmaDeltaDetachPins(uint16_t pins);
 
 // alternative way to control the sigma delta generator frequency
 uint8_t     sigmaDeltaGetPrescaler(void);
 void        sigmaDeltaSetPrescaler(uint8_t prescaler);
 
+// duty cycle sequencer, steps a table in RAM from the timer1 callback of the
+// waveform generator, so not together with Wire.queueTransfer(), ServoGroup
+// or the Profiler
+bool        sigmaDeltaPlay(const uint8_t* duties, uint32_t count, uint32_t rate, bool loop);
+void        sigmaDeltaStop(void);
+bool        sigmaDeltaPlaying(void);
+
 
 #ifdef __cplusplus
 }
@@ -30,6 +30,9 @@
 #define SPI_FLASH_SR3_XMC_DRV_S   5
 #define SPI_FLASH_SR3_XMC_DRV_MASK 0x03
 
+// Flash chip Status Register 2: Quad Enable (Winbond, GigaDevice, XMC, Puya)
+#define SPI_FLASH_SR2_QE (1 << 1)
+
 // Flash Chip commands
 #define SPI_FLASH_CMD_RSR1  0x05  //Read Flash Status Register...
 #define SPI_FLASH_CMD_RSR2  0x35
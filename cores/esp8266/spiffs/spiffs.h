@@ -196,6 +196,14 @@ typedef void (*spiffs_file_callback)(struct spiffs_t *fs, spiffs_fileop_type op,
 
 // phys structs
 
+// counters SPIFFS_mount gathers by scanning every object lookup page
+typedef struct spiffs_mount_state_t {
+  u32_t free_blocks;
+  u32_t stats_p_allocated;
+  u32_t stats_p_deleted;
+  spiffs_obj_id max_erase_count;
+} spiffs_mount_state;
+
 // spiffs spi configuration struct
 typedef struct {
   // physical read function
@@ -226,6 +234,9 @@ typedef struct {
   // an integer offset added to each file handle
   u16_t fh_ix_offset;
 #endif
+  // counters from SPIFFS_mount_state of an earlier mount, with nothing
+  // written since, so mounting does not scan; NULL to scan
+  const spiffs_mount_state *mount_state;
 } spiffs_config;
 
 typedef struct spiffs_t {
@@ -400,6 +411,14 @@ s32_t SPIFFS_mount(spiffs *fs, spiffs_config *config, u8_t *work,
  */
 void SPIFFS_unmount(spiffs *fs);
 
+/**
+ * Copies the counters gathered at mount and kept up to date since, for
+ * spiffs_config.mount_state of a later mount. Also valid after unmount.
+ * @param fs            the file system struct
+ * @param state         where to copy them
+ */
+void SPIFFS_mount_state(spiffs *fs, spiffs_mount_state *state);
+
 /**
  * Creates a new file.
  * @param fs            the file system struct
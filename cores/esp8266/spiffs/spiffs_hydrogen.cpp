@@ -134,8 +134,16 @@ s32_t SPIFFS_mount(spiffs *fs, spiffs_config *config, u8_t *work,
 
   fs->config_magic = SPIFFS_CONFIG_MAGIC;
 
-  res = spiffs_obj_lu_scan(fs);
-  SPIFFS_API_CHECK_RES_UNLOCK(fs, res);
+  if (config->mount_state) {
+    fs->free_blocks = config->mount_state->free_blocks;
+    fs->stats_p_allocated = config->mount_state->stats_p_allocated;
+    fs->stats_p_deleted = config->mount_state->stats_p_deleted;
+    fs->max_erase_count = config->mount_state->max_erase_count;
+  } else {
+    res = spiffs_obj_lu_scan(fs);
+    SPIFFS_API_CHECK_RES_UNLOCK(fs, res);
+  }
+  fs->cfg.mount_state = 0;
 
   SPIFFS_DBG("page index byte len:         " _SPIPRIi "\n", (u32_t)SPIFFS_CFG_LOG_PAGE_SZ(fs));
   SPIFFS_DBG("object lookup pages:         " _SPIPRIi "\n", (u32_t)SPIFFS_OBJ_LOOKUP_PAGES(fs));
@@ -155,6 +163,13 @@ s32_t SPIFFS_mount(spiffs *fs, spiffs_config *config, u8_t *work,
   return 0;
 }
 
+void SPIFFS_mount_state(spiffs *fs, spiffs_mount_state *state) {
+  state->free_blocks = fs->free_blocks;
+  state->stats_p_allocated = fs->stats_p_allocated;
+  state->stats_p_deleted = fs->stats_p_deleted;
+  state->max_erase_count = fs->max_erase_count;
+}
+
 void SPIFFS_unmount(spiffs *fs) {
   SPIFFS_API_DBG("%s\n", __func__);
   if (!SPIFFS_CHECK_CFG(fs) || !SPIFFS_CHECK_MOUNT(fs)) return;
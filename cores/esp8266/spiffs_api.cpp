@@ -21,6 +21,8 @@
  License along with this library; if not, write to the Free Software
  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
  */
+#include <stddef.h>
+#include <coredecls.h>
 #include "spiffs_api.h"
 
 using namespace fs;
@@ -95,6 +97,110 @@ DirImplPtr SPIFFSImpl::openDir(const char* path)
     return std::make_shared<SPIFFSDirImpl>(path, this, dir);
 }
 
+// Last sector of the partition, see SPIFFSImpl::_loadSnapshot()
+struct SpiffsMountSnapshot
+{
+    uint32_t magic;
+    uint32_t size;          // geometry of the filesystem it belongs to
+    uint32_t blockSize;
+    uint32_t pageSize;
+    spiffs_mount_state state;
+    uint32_t crc;           // of the fields above
+    uint32_t valid;         // ~0, programmed to 0 on the first change
+};
+
+static constexpr uint32_t SPIFFS_SNAPSHOT_MAGIC = 0x53504d53;
+
+SPIFFSImpl* SPIFFSImpl::_snapshotList = nullptr;
+
+bool SPIFFSImpl::_loadSnapshot(spiffs_mount_state& state)
+{
+    SpiffsMountSnapshot snap;
+    const uint32_t addr = _start + _size - FLASH_SECTOR_SIZE;
+    if (flash_hal_read(addr, sizeof(snap), (uint8_t*)&snap) != FLASH_HAL_OK) {
+        return false;
+    }
+    if (snap.magic != SPIFFS_SNAPSHOT_MAGIC || snap.valid != 0xffffffff
+        || snap.size != _size || snap.blockSize != _blockSize || snap.pageSize != _pageSize
+        || snap.crc != crc32(&snap, offsetof(SpiffsMountSnapshot, crc))) {
+        return false;
+    }
+    state = snap.state;
+    if (!_snapshotLinked()) {
+        _snapshotNext = _snapshotList;
+        _snapshotList = this;
+    }
+    return true;
+}
+
+void SPIFFSImpl::_saveSnapshot()
+{
+    SpiffsMountSnapshot snap;
+    memset(&snap, 0, sizeof(snap));
+    snap.magic = SPIFFS_SNAPSHOT_MAGIC;
+    snap.size = _size;
+    snap.blockSize = _blockSize;
+    snap.pageSize = _pageSize;
+    SPIFFS_mount_state(&_fs, &snap.state);
+    snap.crc = crc32(&snap, offsetof(SpiffsMountSnapshot, crc));
+    snap.valid = 0xffffffff;
+    const uint32_t addr = _start + _size - FLASH_SECTOR_SIZE;
+    if (flash_hal_erase(addr, FLASH_SECTOR_SIZE) != FLASH_HAL_OK
+        || flash_hal_write(addr, sizeof(snap), (const uint8_t*)&snap) != FLASH_HAL_OK) {
+        DEBUGV("SPIFFSImpl: mount snapshot not saved\r\n");
+        return;
+    }
+    if (!_snapshotLinked()) {
+        _snapshotNext = _snapshotList;
+        _snapshotList = this;
+    }
+}
+
+void SPIFFSImpl::_dropSnapshot()
+{
+    if (!_cfg._mountSnapshot && !_snapshotLinked()) {
+        return;
+    }
+    _unlinkSnapshot();
+    // 1 bits can always be programmed to 0, whatever the sector holds
+    const uint32_t zero = 0;
+    const uint32_t addr = _start + _size - FLASH_SECTOR_SIZE + offsetof(SpiffsMountSnapshot, valid);
+    flash_hal_write(addr, sizeof(zero), (const uint8_t*)&zero);
+}
+
+void SPIFFSImpl::_unlinkSnapshot()
+{
+    for (SPIFFSImpl** p = &_snapshotList; *p; p = &(*p)->_snapshotNext) {
+        if (*p == this) {
+            *p = _snapshotNext;
+            _snapshotNext = nullptr;
+            return;
+        }
+    }
+}
+
+bool SPIFFSImpl::_snapshotLinked() const
+{
+    for (const SPIFFSImpl* p = _snapshotList; p; p = p->_snapshotNext) {
+        if (p == this) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void SPIFFSImpl::_dropSnapshots(uint32_t addr)
+{
+    SPIFFSImpl* p = _snapshotList;
+    while (p) {
+        SPIFFSImpl* next = p->_snapshotNext;
+        if (addr >= p->_start && addr < p->_start + p->_size) {
+            p->_dropSnapshot();
+        }
+        p = next;
+    }
+}
+
 int getSpiffsMode(OpenMode openMode, AccessMode accessMode)
 {
     int mode = 0;
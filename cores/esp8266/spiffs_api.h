@@ -81,6 +81,7 @@ public:
     ~SPIFFSImpl()
     {
         end();
+        _unlinkSnapshot();
     }
 
     FileImplPtr open(const char* path, OpenMode openMode, AccessMode accessMode) override;
@@ -110,7 +111,7 @@ public:
     {
         info.blockSize = _blockSize;
         info.pageSize = _pageSize;
-        info.maxOpenFiles = _maxOpenFds;
+        info.maxOpenFiles = _openFds();
         info.maxPathLength = SPIFFS_OBJ_NAME_LEN;
         uint32_t totalBytes, usedBytes;
         auto rc = SPIFFS_info(&_fs, &totalBytes, &usedBytes);
@@ -185,6 +186,7 @@ public:
             return true;
         }
         if (_cfg._autoFormat) {
+            _dropSnapshot();
             auto rc = SPIFFS_format(&_fs);
             if (rc != SPIFFS_OK) {
                 DEBUGV("SPIFFS_format: rc=%d, err=%d\r\n", rc, _fs.err_code);
@@ -202,6 +204,10 @@ public:
             return;
         }
         SPIFFS_unmount(&_fs);
+        if (_cfg._mountSnapshot && !_snapshotLinked()) {
+            // written since the last snapshot, the counters are up to date again
+            _saveSnapshot();
+        }
         _workBuf.reset(nullptr);
         _fdsBuf.reset(nullptr);
         _cacheBuf.reset(nullptr);
@@ -219,6 +225,7 @@ public:
         if (_tryMount()) {
             SPIFFS_unmount(&_fs);
         }
+        _dropSnapshot();
         auto rc = SPIFFS_format(&_fs);
         if (rc != SPIFFS_OK) {
             DEBUGV("SPIFFS_format: rc=%d, err=%d\r\n", rc, _fs.err_code);
@@ -259,7 +266,7 @@ protected:
         config.hal_read_f       = &spiffs_hal_read;
         config.hal_write_f      = &spiffs_hal_write;
         config.hal_erase_f      = &spiffs_hal_erase;
-        config.phys_size        = _size;
+        config.phys_size        = _cfg._mountSnapshot ? _size - _blockSize : _size;
         config.phys_addr        = _start;
         config.phys_erase_block = FLASH_SECTOR_SIZE;
         config.log_block_size   = _blockSize;
@@ -293,8 +300,8 @@ protected:
         _fs.cfg.log_page_size = config.log_page_size;
 
         size_t workBufSize = 2 * _pageSize;
-        size_t fdsBufSize = SPIFFS_buffer_bytes_for_filedescs(&_fs, _maxOpenFds);
-        size_t cacheBufSize = SPIFFS_buffer_bytes_for_cache(&_fs, _maxOpenFds);
+        size_t fdsBufSize = SPIFFS_buffer_bytes_for_filedescs(&_fs, _openFds());
+        size_t cacheBufSize = SPIFFS_buffer_bytes_for_cache(&_fs, _cfg._cachePages ? _cfg._cachePages : _openFds());
 
         if (!_workBuf) {
             DEBUGV("SPIFFSImpl: allocating %zd+%zd+%zd=%zd bytes\r\n",
@@ -308,15 +315,50 @@ protected:
         DEBUGV("SPIFFSImpl: mounting fs @%x, size=%x, block=%x, page=%x\r\n",
                _start, _size, _blockSize, _pageSize);
 
+        spiffs_mount_state state;
+        const bool fromSnapshot = _cfg._mountSnapshot && _loadSnapshot(state);
+        if (fromSnapshot) {
+            config.mount_state = &state;
+        }
+
         auto err = SPIFFS_mount(&_fs, &config, _workBuf.get(),
                                 _fdsBuf.get(), fdsBufSize, _cacheBuf.get(), cacheBufSize,
                                 &SPIFFSImpl::_check_cb);
 
-        DEBUGV("SPIFFSImpl: mount rc=%d\r\n", err);
+        DEBUGV("SPIFFSImpl: mount rc=%d%s\r\n", err, fromSnapshot ? " from snapshot" : "");
 
+        if (err == SPIFFS_OK && _cfg._mountSnapshot && !fromSnapshot) {
+            _saveSnapshot();
+        }
         return err == SPIFFS_OK;
     }
 
+    uint32_t _openFds() const
+    {
+        return _cfg._maxOpenFiles ? _cfg._maxOpenFiles : _maxOpenFds;
+    }
+
+    // Mount snapshot, see SPIFFSConfig::setMountSnapshot().  It lives in the
+    // last sector of the partition, and is valid until its last word is
+    // programmed to 0, which the first write or erase to the filesystem
+    // does (no sector erase needed).  Filesystems with a valid snapshot
+    // are listed for the flash hal wrappers to find.
+    bool _loadSnapshot(spiffs_mount_state& state);
+    void _saveSnapshot();
+    void _dropSnapshot();
+    void _unlinkSnapshot();
+    bool _snapshotLinked() const;
+    static void _beforeWrite(uint32_t addr)
+    {
+        if (_snapshotList) {
+            _dropSnapshots(addr);
+        }
+    }
+    static void _dropSnapshots(uint32_t addr);
+
+    static SPIFFSImpl* _snapshotList;
+    SPIFFSImpl* _snapshotNext = nullptr;
+
     static void _check_cb(spiffs_check_type type, spiffs_check_report report,
                           uint32_t arg1, uint32_t arg2)
     {
@@ -334,9 +376,11 @@ protected:
 
     // Flash hal wrapper functions to get proper SPIFFS error codes
     static int32_t spiffs_hal_write(uint32_t addr, uint32_t size, const uint8_t *src) {
+        _beforeWrite(addr);
         return flash_hal_write(addr, size, src) == FLASH_HAL_OK ? SPIFFS_OK : SPIFFS_ERR_INTERNAL;
     }
     static int32_t spiffs_hal_erase(uint32_t addr, uint32_t size) {
+        _beforeWrite(addr);
         return flash_hal_erase(addr, size) == FLASH_HAL_OK ? SPIFFS_OK : SPIFFS_ERR_INTERNAL;
     }
     static int32_t spiffs_hal_read(uint32_t addr, uint32_t size, uint8_t *dst) {
@@ -44,6 +44,10 @@ char* ultoa (unsigned long val, char *s, int radix);
 
 char* ulltoa (unsigned long long val, char* str, int slen, unsigned int radix);
 
+// decimal digits of val written backwards before end, not terminated,
+// returns the first one
+char* ulltoa_dec (unsigned long long val, char* end);
+
 char* dtostrf (double val, signed char width, unsigned char prec, char *s);
 
 void reverse(char* begin, char* end);
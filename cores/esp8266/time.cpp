@@ -51,10 +51,34 @@ extern uint64_t micros64();
 extern void sntp_set_daylight(int daylight);
 
 static uint64_t timeshift64 = 0;
+static bool timeshift64_is_set = false;
+
+// Small SNTP corrections are slewed at this rate, like adjtime() does,
+// larger ones step the clock
+#define TIME_SLEW_PPM 500
+#define TIME_SLEW_MAX_US 128000
+static int64_t slew_us = 0;        // correction being applied
+static uint64_t slew_start = 0;    // micros64() when it started
 
 void tune_timeshift64 (uint64_t now_us)
 {
      timeshift64 = now_us - micros64();
+     timeshift64_is_set = true;
+     slew_us = 0;
+}
+
+static uint64_t time_now_us ()
+{
+    const uint64_t m = micros64();
+    if (slew_us)
+    {
+        const int64_t max = (m - slew_start) * TIME_SLEW_PPM / 1000000;
+        if (max < (slew_us < 0 ? -slew_us : slew_us))
+            return m + timeshift64 + (slew_us < 0 ? -max : max);
+        timeshift64 += slew_us;
+        slew_us = 0;
+    }
+    return m + timeshift64;
 }
 
 static void setServer(int id, const char* name_or_ip)
@@ -105,7 +129,7 @@ uint32 sntp_get_current_timestamp()
 
 time_t time(time_t * t)
 {
-    time_t currentTime_s = (micros64() + timeshift64) / 1000000ULL;
+    time_t currentTime_s = time_now_us() / 1000000ULL;
     if (t)
     {
         *t = currentTime_s;
@@ -119,7 +143,7 @@ int _gettimeofday_r(struct _reent* unused, struct timeval *tp, void *tzp)
     (void) tzp;
     if (tp)
     {
-        uint64_t currentTime_us = timeshift64 + micros64();
+        uint64_t currentTime_us = time_now_us();
         tp->tv_sec = currentTime_us / 1000000ULL;
         tp->tv_usec = currentTime_us % 1000000ULL;
     }
@@ -128,6 +152,213 @@ int _gettimeofday_r(struct _reent* unused, struct timeval *tp, void *tzp)
 
 }; // extern "C"
 
+///////////////////////////////////////////
+// fast first synchronisation
+//
+// lwIP's SNTP asks one server at a time and waits seconds for a reply
+// before trying the next.  Instead, ask all configured servers at once,
+// every second, and let the first valid reply set the clock.  This ends
+// at the first synchronisation, from here or from lwIP.
+
+#include <lwip/udp.h>
+#include <lwip/dns.h>
+#include <lwip/apps/sntp.h>
+
+#define NTP_PORT 123
+#define NTP_PACKET_SIZE 48
+#define NTP_UNIX_OFFSET 2208988800UL // 1900 to 1970
+
+static bool fast_sync_enabled = false;
+static bool fast_sync_running = false;
+static udp_pcb* fast_sync_pcb = nullptr;
+static uint64_t fast_sync_sent_us = 0;
+
+static void fastSyncStop ()
+{
+    fast_sync_running = false;
+    if (fast_sync_pcb)
+    {
+        // not from inside its own recv callback
+        udp_pcb* pcb = fast_sync_pcb;
+        fast_sync_pcb = nullptr;
+        schedule_function([pcb]() { udp_remove(pcb); });
+    }
+}
+
+static void fastSyncSend (const ip_addr_t* addr)
+{
+    if (!fast_sync_pcb || !addr)
+        return;
+    pbuf* p = pbuf_alloc(PBUF_TRANSPORT, NTP_PACKET_SIZE, PBUF_RAM);
+    if (!p)
+        return;
+    uint8_t* msg = (uint8_t*)p->payload;
+    memset(msg, 0, NTP_PACKET_SIZE);
+    msg[0] = 0x23; // version 4, client
+    // our send time as transmit timestamp, servers echo it as originate
+    memcpy(msg + 40, &fast_sync_sent_us, sizeof(fast_sync_sent_us));
+    udp_sendto(fast_sync_pcb, p, addr, NTP_PORT);
+    pbuf_free(p);
+}
+
+static void fastSyncResolved (const char* name, const ip_addr_t* addr, void* arg)
+{
+    (void)name;
+    (void)arg;
+    if (fast_sync_running)
+        fastSyncSend(addr);
+}
+
+static void fastSyncRecv (void* arg, udp_pcb* pcb, pbuf* p, const ip_addr_t* addr, u16_t port)
+{
+    (void)arg;
+    (void)pcb;
+    (void)addr;
+    uint8_t msg[NTP_PACKET_SIZE];
+    const bool valid = fast_sync_running && port == NTP_PORT
+                       && pbuf_copy_partial(p, msg, NTP_PACKET_SIZE, 0) == NTP_PACKET_SIZE
+                       && (msg[0] & 7) == 4                 // server
+                       && (msg[0] >> 6) != 3                // not unsynchronized
+                       && msg[1] >= 1 && msg[1] <= 15       // stratum
+                       && memcmp(msg + 24, &fast_sync_sent_us, sizeof(fast_sync_sent_us)) == 0;
+    pbuf_free(p);
+    if (!valid)
+        return;
+
+    const uint32_t sec = msg[40] << 24 | msg[41] << 16 | msg[42] << 8 | msg[43];
+    const uint32_t frac = msg[44] << 24 | msg[45] << 16 | msg[46] << 8 | msg[47];
+    // half of the round trip for the way back
+    const uint64_t now_us = (uint64_t)(sec - NTP_UNIX_OFFSET) * 1000000ULL
+                            + (((uint64_t)frac * 1000000ULL) >> 32)
+                            + (micros64() - fast_sync_sent_us) / 2;
+    fastSyncStop();
+    timeval tv = { (time_t)(now_us / 1000000ULL), (suseconds_t)(now_us % 1000000ULL) };
+    settimeofday(&tv, (struct timezone*)0xFeedC0de);
+}
+
+static bool fastSyncBurst ()
+{
+    if (!fast_sync_running)
+        return false;
+    fast_sync_sent_us = micros64();
+    for (u8_t i = 0; i < SNTP_MAX_SERVERS; i++)
+    {
+        const char* name = sntp_getservername(i);
+        if (!name || !*name)
+            continue;
+        ip_addr_t addr;
+        if (dns_gethostbyname(name, &addr, fastSyncResolved, nullptr) == ERR_OK)
+            fastSyncSend(&addr);
+    }
+    return true;
+}
+
+static void fastSyncStart ()
+{
+    if (!fast_sync_enabled || fast_sync_running)
+        return;
+    fast_sync_pcb = udp_new();
+    if (!fast_sync_pcb)
+        return;
+    udp_recv(fast_sync_pcb, fastSyncRecv, nullptr);
+    fast_sync_running = true;
+    fastSyncBurst();
+    schedule_recurrent_function_us(fastSyncBurst, 1000000);
+}
+
+void configTimeFastSync (bool enable)
+{
+    fast_sync_enabled = enable;
+    if (!enable && fast_sync_running)
+        fastSyncStop();
+}
+
+///////////////////////////////////////////
+// time kept across deep sleep
+//
+// The RTC counter keeps running in deep sleep.  Each SNTP synchronisation
+// saves the time with the RTC count it was taken at, and the drift of the
+// RTC clock measured between two synchronisations.  After a deep sleep
+// wake, the clock is set from these at once.  The RTC counter wraps after
+// about 7 hours, longer sleeps must not rely on this.
+
+struct time_rtc_record_t
+{
+    uint32_t magic;
+    uint32_t rtc;           // system_get_rtc_time() at the sync
+    uint32_t cali;          // us per RTC tick, Q12
+    int32_t drift_ppm;      // RTC clock error against SNTP
+    uint64_t unix_us;
+    uint32_t crc;
+};
+
+#define TIME_RTC_MAGIC 0x54494d45 // "TIME"
+#define TIME_RTC_BLOCKS (sizeof(time_rtc_record_t) / sizeof(uint32_t))
+static_assert(TIME_RTC_BLOCKS == 7, "record size");
+static int time_rtc_block = -1;
+
+static uint32_t timeRtcCrc (const time_rtc_record_t& record)
+{
+    return crc32(&record, offsetof(time_rtc_record_t, crc));
+}
+
+static bool timeRtcLoad (time_rtc_record_t& record)
+{
+    return time_rtc_block >= 0
+           && system_rtc_mem_read(64 + time_rtc_block, &record, sizeof(record))
+           && record.magic == TIME_RTC_MAGIC && record.crc == timeRtcCrc(record);
+}
+
+static void timeRtcSave (uint64_t unix_us)
+{
+    if (time_rtc_block < 0)
+        return;
+    const uint32_t rtc = system_get_rtc_time();
+    const uint32_t cali = system_rtc_clock_cali_proc();
+    time_rtc_record_t record;
+    int32_t drift_ppm = 0;
+    if (timeRtcLoad(record))
+    {
+        drift_ppm = record.drift_ppm;
+        const uint64_t rtc_us = ((uint64_t)(rtc - record.rtc) * ((record.cali + cali) / 2)) >> 12;
+        // measured over at least a minute, ignoring nonsense
+        if (rtc_us > 60000000ULL && unix_us > record.unix_us)
+        {
+            const int64_t measured = (int64_t)((unix_us - record.unix_us) - rtc_us) * 1000000 / (int64_t)rtc_us;
+            if (measured > -20000 && measured < 20000)
+                drift_ppm = drift_ppm ? (drift_ppm + (int32_t)measured) / 2 : (int32_t)measured;
+        }
+    }
+    record = { TIME_RTC_MAGIC, rtc, cali, drift_ppm, unix_us, 0 };
+    record.crc = timeRtcCrc(record);
+    system_rtc_mem_write(64 + time_rtc_block, &record, sizeof(record));
+}
+
+bool configTimeRtc (uint32_t rtcBlock)
+{
+    if (rtcBlock + TIME_RTC_BLOCKS > 128)
+        return false;
+    time_rtc_block = rtcBlock;
+
+    time_rtc_record_t record;
+    if (!timeRtcLoad(record))
+        return false;
+    if (system_get_rst_info()->reason != REASON_DEEP_SLEEP_AWAKE)
+    {
+        // the RTC counter restarted with the chip
+        record.magic = 0;
+        system_rtc_mem_write(64 + time_rtc_block, &record, sizeof(record));
+        return false;
+    }
+    const uint32_t cali = system_rtc_clock_cali_proc();
+    int64_t elapsed_us = ((uint64_t)(system_get_rtc_time() - record.rtc) * ((record.cali + cali) / 2)) >> 12;
+    elapsed_us += elapsed_us * record.drift_ppm / 1000000;
+    const uint64_t now_us = record.unix_us + elapsed_us;
+    timeval tv = { (time_t)(now_us / 1000000ULL), (suseconds_t)(now_us % 1000000ULL) };
+    settimeofday(&tv, nullptr);
+    return true;
+}
+
 void configTime(int timezone_sec, int daylightOffset_sec, const char* server1, const char* server2, const char* server3)
 {
     sntp_stop();
@@ -185,6 +416,7 @@ void configTime(int timezone_sec, int daylightOffset_sec, const char* server1, c
     setServer(2, server3);
 
     sntp_init();
+    fastSyncStart();
 }
 
 void setTZ(const char* tz){
@@ -205,6 +437,7 @@ void configTime(const char* tz, const char* server1, const char* server2, const
 	setTZ(tz);
 	
     sntp_init();
+    fastSyncStart();
 }
 
 static BoolCB _settimeofday_cb;
@@ -221,8 +454,6 @@ void settimeofday_cb (const BoolCB& cb)
 
 extern "C" {
 
-#include <lwip/apps/sntp.h>
-
 int settimeofday(const struct timeval* tv, const struct timezone* tz)
 {
     bool from_sntp;
@@ -243,8 +474,27 @@ int settimeofday(const struct timeval* tv, const struct timezone* tz)
         // tz is obsolete (cf. man settimeofday)
         return EINVAL;
 
-    // reset time subsystem
-    tune_timeshift64(tv->tv_sec * 1000000ULL + tv->tv_usec);
+    const uint64_t now_us = tv->tv_sec * 1000000ULL + tv->tv_usec;
+    if (from_sntp)
+    {
+        fastSyncStop();
+        timeRtcSave(now_us);
+    }
+
+    const int64_t correction = now_us - time_now_us();
+    if (from_sntp && timeshift64_is_set && correction > -TIME_SLEW_MAX_US && correction < TIME_SLEW_MAX_US)
+    {
+        // slew, keeping time monotonic
+        const uint64_t m = micros64();
+        timeshift64 = time_now_us() - m;
+        slew_us = correction;
+        slew_start = m;
+    }
+    else
+    {
+        // reset time subsystem
+        tune_timeshift64(now_us);
+    }
 
     if (_settimeofday_cb)
         schedule_recurrent_function_us([from_sntp](){ _settimeofday_cb(from_sntp); return false; }, 0);
@@ -46,7 +46,13 @@ uint8_t twi_writeTo(unsigned char address, unsigned char * buf, unsigned int len
 uint8_t twi_readFrom(unsigned char address, unsigned char * buf, unsigned int len, unsigned char sendStop);
 uint8_t twi_status();
 
-uint8_t twi_transmit(const uint8_t*, uint8_t);
+uint8_t twi_transmit(const uint8_t*, size_t);
+
+// Slave buffers of rxSize and txSize bytes instead of TWI_BUFFER_LENGTH.
+// Two receive buffers are allocated and used in turn, so the bus no longer
+// waits for the receive callback when the previous one is done.  Must be
+// called before slave mode is enabled, false otherwise or when out of memory.
+bool twi_setSlaveBuffers(size_t rxSize, size_t txSize);
 
 void twi_attachSlaveRxEvent(void (*)(uint8_t*, size_t));
 void twi_attachSlaveTxEvent(void (*)(void));
@@ -56,6 +62,39 @@ void twi_releaseBus(void);
 
 void twi_enableSlaveMode(void);
 
+// Asynchronous master transactions.  Queued transactions are clocked out in
+// the background from the timer1 interrupt (shared with the waveform
+// generator through setTimer1Callback()), with one interrupt per SCL half
+// period, so clocks above 100kHz mostly cost CPU time.  The structure must
+// stay valid until onDone() has been called from loop()/yield() context.
+// Not available while slave mode is enabled.
+#define TWI_ASYNC_PENDING 0xff
+
+typedef struct twi_transaction
+{
+    uint8_t* buf;
+    uint16_t len;
+    uint8_t address;
+    uint8_t read;       // 0 writes len bytes from buf, 1 reads len (>0) bytes into it
+    uint8_t sendStop;   // 0 keeps the bus for a repeated start by the next transaction
+    volatile uint8_t result; // TWI_ASYNC_PENDING, then as twi_writeTo()/twi_readFrom()
+    void (*onDone)(struct twi_transaction*);
+    void* arg;          // for the caller
+} twi_transaction_t;
+
+// Returns false if the queue is full or the transaction is invalid
+bool twi_queueTransaction(twi_transaction_t* t);
+// True until every queued transaction has been reported
+bool twi_asyncBusy(void);
+
+// Run count segments as one combined transaction: a repeated START between
+// segments and a STOP after the last one (sendStop is set accordingly).  The
+// first failing segment ends it, the remaining ones get result 4.  Returns
+// the first error or 0.
+uint8_t twi_transfer(twi_transaction_t* segments, size_t count);
+// Same, queued as a whole in the background; false if it does not fit
+bool twi_queueTransfer(twi_transaction_t* segments, size_t count);
+
 #ifdef __cplusplus
 }
 #endif
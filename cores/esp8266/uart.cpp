@@ -44,6 +44,8 @@
 #include <pgmspace.h>
 #include "gdb_hooks.h"
 #include "uart.h"
+#include "cbuf.h"
+#include <new>
 #include "esp8266_peri.h"
 #include "user_interface.h"
 #include "uart_register.h"
@@ -79,7 +81,8 @@ extern "C" {
 
 static int s_uart_debug_nr = UART0;
 
-struct uart_rx_buffer_
+// size == 0: no buffer, uart_write() busy-waits on the hw fifo
+struct uart_tx_buffer_
 {
     size_t size;
     size_t rpos;
@@ -97,9 +100,17 @@ struct uart_
     bool rx_error;
     uint8_t rx_pin;
     uint8_t tx_pin;
-    struct uart_rx_buffer_ * rx_buffer;
+    uint8_t rx_fifo_full;   // UCFFT
+    uint8_t rx_timeout;     // UCTOT, 0: off
+    // The ISR produces, but it also drops the oldest byte on overrun (see
+    // UART_DISCARD_NEWEST), so readers still mask the uart interrupt.
+    cbuf_pow2 * rx_buffer;
+    struct uart_tx_buffer_ tx_buffer;
 };
 
+// UART0 and UART1 share one interrupt, uart_isr() serves both from here
+static uart_t* s_uart_isr_uarts[UART1 + 1] = { NULL, NULL };
+
 
 /*
    In the context of the naming conventions in this file, "_unsafe" means two things:
@@ -121,17 +132,33 @@ uart_rx_fifo_available(const int uart_nr)
     return (USS(uart_nr) >> USRXC) & 0xFF;
 }
 
+/*
+  Reference for uart_tx_fifo_available() and uart_tx_fifo_full():
+  -Espressif Techinical Reference doc, chapter 11.3.7
+  -tools/sdk/uart_register.h
+  -cores/esp8266/esp8266_peri.h
+  */
+// called by ISR
+inline size_t IRAM_ATTR
+uart_tx_fifo_available(const int uart_nr)
+{
+    return (USS(uart_nr) >> USTXC) & 0xff;
+}
+
+inline bool
+uart_tx_fifo_full(const int uart_nr)
+{
+    return uart_tx_fifo_available(uart_nr) >= 0x7f;
+}
+
 
 /**********************************************************/
 /************ UNSAFE FUNCTIONS ****************************/
 /**********************************************************/
 inline size_t
-uart_rx_buffer_available_unsafe(const struct uart_rx_buffer_ * rx_buffer)
+uart_rx_buffer_available_unsafe(const cbuf_pow2 * rx_buffer)
 {
-    if(rx_buffer->wpos < rx_buffer->rpos)
-      return (rx_buffer->wpos + rx_buffer->size) - rx_buffer->rpos;
-
-    return rx_buffer->wpos - rx_buffer->rpos;
+    return rx_buffer->available();
 }
 
 inline size_t
@@ -147,12 +174,17 @@ uart_rx_available_unsafe(uart_t* uart)
 inline void IRAM_ATTR
 uart_rx_copy_fifo_to_buffer_unsafe(uart_t* uart)
 {
-    struct uart_rx_buffer_ *rx_buffer = uart->rx_buffer;
+    cbuf_pow2 *rx_buffer = uart->rx_buffer;
+    const int uart_nr = uart->uart_nr;
+    size_t avail;
 
-    while(uart_rx_fifo_available(uart->uart_nr))
+    // move whole linear runs: fifo count, free space and wrap-around are
+    // evaluated once per run instead of once per byte
+    while((avail = uart_rx_fifo_available(uart_nr)))
     {
-        size_t nextPos = (rx_buffer->wpos + 1) % rx_buffer->size;
-        if(nextPos == rx_buffer->rpos)
+        char* dst;
+        size_t chunk = rx_buffer->writeSpan(dst);
+        if(!chunk)
         {
             if (!uart->rx_overrun)
             {
@@ -165,18 +197,53 @@ uart_rx_copy_fifo_to_buffer_unsafe(uart_t* uart)
 #ifdef UART_DISCARD_NEWEST
             // discard newest data
             // Stop copying if rx buffer is full
-            USF(uart->uart_nr);
+            USF(uart_nr);
             break;
 #else
             // discard oldest data
-            if (++rx_buffer->rpos == rx_buffer->size)
-                rx_buffer->rpos = 0;
+            rx_buffer->consume(1);
+            chunk = rx_buffer->writeSpan(dst);
 #endif
         }
-        uint8_t data = USF(uart->uart_nr);
-        rx_buffer->buffer[rx_buffer->wpos] = data;
-        rx_buffer->wpos = nextPos;
+
+        if (chunk > avail)
+            chunk = avail;
+
+        for (size_t i = 0; i < chunk; ++i)
+            dst[i] = USF(uart_nr);
+
+        rx_buffer->commit(chunk);
+    }
+}
+
+inline size_t
+uart_tx_buffer_available_unsafe(const struct uart_tx_buffer_ * tx_buffer)
+{
+    if(tx_buffer->wpos < tx_buffer->rpos)
+      return (tx_buffer->wpos + tx_buffer->size) - tx_buffer->rpos;
+
+    return tx_buffer->wpos - tx_buffer->rpos;
+}
+
+// Move as much of the tx buffer as fits into the tx fifo. When the buffer
+// runs empty, the tx fifo empty interrupt is switched off until the next write.
+// called by ISR
+inline void IRAM_ATTR
+uart_tx_copy_buffer_to_fifo_unsafe(uart_t* uart)
+{
+    struct uart_tx_buffer_ *tx_buffer = &uart->tx_buffer;
+    const int uart_nr = uart->uart_nr;
+
+    size_t room = UART_TX_FIFO_SIZE - uart_tx_fifo_available(uart_nr);
+    while(room-- && tx_buffer->rpos != tx_buffer->wpos)
+    {
+        USF(uart_nr) = tx_buffer->buffer[tx_buffer->rpos];
+        if (++tx_buffer->rpos == tx_buffer->size)
+            tx_buffer->rpos = 0;
     }
+
+    if(tx_buffer->rpos == tx_buffer->wpos)
+        USIE(uart_nr) &= ~(1 << UIFE);
 }
 
 inline int
@@ -190,22 +257,15 @@ uart_peek_char_unsafe(uart_t* uart)
         // hw fifo can't be peeked, data need to be copied to sw
         uart_rx_copy_fifo_to_buffer_unsafe(uart);
 
-    return uart->rx_buffer->buffer[uart->rx_buffer->rpos];
+    return uart->rx_buffer->peek();
 }
 
 // taking data straight from hw fifo: loopback-test BW jumps by 19%
 inline int
 uart_read_char_unsafe(uart_t* uart)
 {
-    if (uart_rx_buffer_available_unsafe(uart->rx_buffer))
-    {
-        // take oldest sw data
-        int ret = uart->rx_buffer->buffer[uart->rx_buffer->rpos];
-        uart->rx_buffer->rpos = (uart->rx_buffer->rpos + 1) % uart->rx_buffer->size;
-        return ret;
-    }
-    // unavailable
-    return -1;
+    // take oldest sw data, -1 when there is none
+    return uart->rx_buffer->read();
 }
 
 uint8_t
@@ -248,30 +308,28 @@ size_t uart_peek_available (uart_t* uart)
     // - or return fifo when buffer is empty but then any move from fifo to
     //   buffer should be blocked until peek_consume is called
 
+    const char* span;
     ETS_UART_INTR_DISABLE();
     uart_rx_copy_fifo_to_buffer_unsafe(uart);
-    auto rpos = uart->rx_buffer->rpos;
-    auto wpos = uart->rx_buffer->wpos;
+    size_t ret = uart->rx_buffer->readSpan(span);
     ETS_UART_INTR_ENABLE();
-    if(wpos < rpos)
-        return uart->rx_buffer->size - rpos;
-    return wpos - rpos;
+    return ret;
 }
 
 // return a pointer to available data buffer (size = available())
 // semantic forbids any kind of read() between peekBuffer() and peekConsume()
 const char* uart_peek_buffer (uart_t* uart)
 {
-    return (const char*)&uart->rx_buffer->buffer[uart->rx_buffer->rpos];
+    const char* span;
+    uart->rx_buffer->readSpan(span);
+    return span;
 }
 
 // consume bytes after use (see uart_peek_buffer)
 void uart_peek_consume (uart_t* uart, size_t consume)
 {
     ETS_UART_INTR_DISABLE();
-    uart->rx_buffer->rpos += consume;
-    if (uart->rx_buffer->rpos >= uart->rx_buffer->size)
-        uart->rx_buffer->rpos -= uart->rx_buffer->size;
+    uart->rx_buffer->consume(consume);
     ETS_UART_INTR_ENABLE();
 }
 
@@ -306,13 +364,12 @@ uart_read(uart_t* uart, char* userbuffer, size_t usersize)
 
         // pour sw buffer to user's buffer
         // get largest linear length from sw buffer
-        size_t chunk = uart->rx_buffer->rpos < uart->rx_buffer->wpos?
-                           uart->rx_buffer->wpos - uart->rx_buffer->rpos:
-                           uart->rx_buffer->size - uart->rx_buffer->rpos;
+        const char* span;
+        size_t chunk = uart->rx_buffer->readSpan(span);
         if (ret + chunk > usersize)
             chunk = usersize - ret;
-        memcpy(userbuffer + ret, uart->rx_buffer->buffer + uart->rx_buffer->rpos, chunk);
-        uart->rx_buffer->rpos = (uart->rx_buffer->rpos + chunk) % uart->rx_buffer->size;
+        memcpy(userbuffer + ret, span, chunk);
+        uart->rx_buffer->consume(chunk);
         ret += chunk;
     }
 
@@ -333,10 +390,9 @@ static void IRAM_ATTR uart_isr_handle_data(void* arg, uint8_t data)
 
 // Copy all the rx fifo bytes that fit into the rx buffer
 // called by ISR
-    struct uart_rx_buffer_ *rx_buffer = uart->rx_buffer;
+    cbuf_pow2 *rx_buffer = uart->rx_buffer;
 
-    size_t nextPos = (rx_buffer->wpos + 1) % rx_buffer->size;
-    if(nextPos == rx_buffer->rpos)
+    if(rx_buffer->full())
     {
         uart->rx_overrun = true;
         //os_printf_plus(overrun_str);
@@ -349,12 +405,10 @@ static void IRAM_ATTR uart_isr_handle_data(void* arg, uint8_t data)
         return;
 #else
         // discard oldest data
-        if (++rx_buffer->rpos == rx_buffer->size)
-            rx_buffer->rpos = 0;
+        rx_buffer->consume(1);
 #endif
     }
-    rx_buffer->buffer[rx_buffer->wpos] = data;
-    rx_buffer->wpos = nextPos;
+    rx_buffer->write(data);
 
     // Check the UART flags and note hardware overflow/etc.
     uint32_t usis = USIS(uart->uart_nr);
@@ -374,64 +428,104 @@ uart_resize_rx_buffer(uart_t* uart, size_t new_size)
     if(uart == NULL || !uart->rx_enabled)
         return 0;
 
-    if(uart->rx_buffer->size == new_size)
-        return uart->rx_buffer->size;
-
-    uint8_t * new_buf = (uint8_t*)malloc(new_size);
-    if(!new_buf)
-        return uart->rx_buffer->size;
+    cbuf_pow2 * new_buf = new (std::nothrow) cbuf_pow2(new_size);
+    if(!new_buf || !new_buf->capacity() || new_buf->capacity() == uart->rx_buffer->capacity())
+    {
+        delete new_buf;
+        return uart->rx_buffer->capacity();
+    }
 
-    size_t new_wpos = 0;
     ETS_UART_INTR_DISABLE();
-    while(uart_rx_available_unsafe(uart) && new_wpos < new_size)
-        new_buf[new_wpos++] = uart_read_char_unsafe(uart); //if uart_rx_available_unsafe() returns non-0, uart_read_char_unsafe() can't return -1
-    if (new_wpos == new_size)
-        new_wpos = 0;
-
-    uint8_t * old_buf = uart->rx_buffer->buffer;
-    uart->rx_buffer->rpos = 0;
-    uart->rx_buffer->wpos = new_wpos;
-    uart->rx_buffer->size = new_size;
-    uart->rx_buffer->buffer = new_buf;
+    while(uart_rx_available_unsafe(uart) && !new_buf->full())
+        new_buf->write(uart_read_char_unsafe(uart)); //if uart_rx_available_unsafe() returns non-0, uart_read_char_unsafe() can't return -1
+
+    cbuf_pow2 * old_buf = uart->rx_buffer;
+    uart->rx_buffer = new_buf;
     ETS_UART_INTR_ENABLE();
-    free(old_buf);
-    return uart->rx_buffer->size;
+    delete old_buf;
+    return uart->rx_buffer->capacity();
 }
 
 size_t
 uart_get_rx_buffer_size(uart_t* uart)
 {
-    return uart && uart->rx_enabled? uart->rx_buffer->size: 0;
+    return uart && uart->rx_enabled? uart->rx_buffer->capacity(): 0;
 }
 
 // The default ISR handler called when GDB is not enabled
 void IRAM_ATTR
 uart_isr(void * arg, void * frame)
 {
+    (void) arg;
     (void) frame;
-    uart_t* uart = (uart_t*)arg;
-    uint32_t usis = USIS(uart->uart_nr);
 
-    if(uart == NULL || !uart->rx_enabled)
+    for (int uart_nr = UART0; uart_nr <= UART1; ++uart_nr)
     {
-        USIC(uart->uart_nr) = usis;
-        ETS_UART_INTR_DISABLE();
-        return;
-    }
+        uint32_t usis = USIS(uart_nr);
+        if(!usis)
+            continue;
 
-    if(usis & (1 << UIFF))
-        uart_rx_copy_fifo_to_buffer_unsafe(uart);
+        uart_t* uart = s_uart_isr_uarts[uart_nr];
+        if(uart == NULL)
+        {
+            USIE(uart_nr) = 0;
+            USIC(uart_nr) = usis;
+            continue;
+        }
 
-    if(usis & (1 << UIOF))
-    {
-        uart->rx_overrun = true;
-        //os_printf_plus(overrun_str);
+        if(uart->rx_enabled)
+        {
+            // UITO: fewer than the fifo full threshold, but the line went quiet
+            if(usis & ((1 << UIFF) | (1 << UITO)))
+                uart_rx_copy_fifo_to_buffer_unsafe(uart);
+
+            if(usis & (1 << UIOF))
+            {
+                uart->rx_overrun = true;
+                //os_printf_plus(overrun_str);
+            }
+
+            if (usis & ((1 << UIFR) | (1 << UIPE)))
+                uart->rx_error = true;
+        }
+
+        if(usis & (1 << UIFE))
+            uart_tx_copy_buffer_to_fifo_unsafe(uart);
+
+        USIC(uart_nr) = usis;
     }
+}
 
-    if (usis & ((1 << UIFR) | (1 << UIPE) | (1 << UITO)))
-        uart->rx_error = true;
+// true when uart_isr() has work to do for this uart
+static bool
+uart_isr_needed(const uart_t* uart)
+{
+    return uart != NULL && (uart->rx_enabled || uart->tx_buffer.size);
+}
 
-    USIC(uart->uart_nr) = usis;
+// UCFET value is when the TX fifo empty interrupt triggers, that is when
+// fewer bytes are left in the TX fifo: 16 bytes leave ~170us at 921600 baud
+// to refill it.
+#define TXTRIGG 16
+
+// UCFFT value is when the RX fifo full interrupt triggers.  A value of 1
+// triggers the IRS very often.  A value of 127 would not leave much time
+// for ISR to clear fifo before the next byte is dropped.  So pick a value
+// in the middle.
+// update: loopback test @ 3Mbauds/8n1 (=2343Kibits/s):
+// - 4..120 give > 2300Kibits/s
+// - 1, 2, 3 are below
+// was 100, use 16 to stay away from overrun
+// This is the default, see uart_set_rx_thresholds().
+#define INTRIGG 16
+
+static uint32_t
+uart_get_usc1(const uart_t* uart)
+{
+    uint32_t usc1 = (uart->rx_fifo_full << UCFFT) | (TXTRIGG << UCFET);
+    if(uart->rx_timeout)
+        usc1 |= (uart->rx_timeout << UCTOT) | (1U << UCTOE);
+    return usc1;
 }
 
 static void
@@ -445,18 +539,8 @@ uart_start_isr(uart_t* uart)
         return;
     }
 
-    // UCFFT value is when the RX fifo full interrupt triggers.  A value of 1
-    // triggers the IRS very often.  A value of 127 would not leave much time
-    // for ISR to clear fifo before the next byte is dropped.  So pick a value
-    // in the middle.
-    // update: loopback test @ 3Mbauds/8n1 (=2343Kibits/s):
-    // - 4..120 give > 2300Kibits/s
-    // - 1, 2, 3 are below
-    // was 100, use 16 to stay away from overrun
-    #define INTRIGG 16
-
     //was:USC1(uart->uart_nr) = (INTRIGG << UCFFT) | (0x02 << UCTOT) | (1 <<UCTOE);
-    USC1(uart->uart_nr) = (INTRIGG << UCFFT);
+    USC1(uart->uart_nr) = uart_get_usc1(uart);
     USIC(uart->uart_nr) = 0xffff;
     //was: USIE(uart->uart_nr) = (1 << UIFF) | (1 << UIFR) | (1 << UITO);
     // UIFF: rx fifo full
@@ -465,18 +549,24 @@ uart_start_isr(uart_t* uart)
     // UIPE: parity error
     // UITO: rx fifo timeout
     USIE(uart->uart_nr) = (1 << UIFF) | (1 << UIOF) | (1 << UIFR) | (1 << UIPE) | (1 << UITO);
-    ETS_UART_INTR_ATTACH(uart_isr,  (void *)uart);
+    ETS_UART_INTR_ATTACH(uart_isr, NULL);
     ETS_UART_INTR_ENABLE();
 }
 
 static void
 uart_stop_isr(uart_t* uart)
 {
-    if(uart == NULL || !uart->rx_enabled)
+    if(uart == NULL)
         return;
 
+    if(!uart_isr_needed(uart)) {
+        s_uart_isr_uarts[uart->uart_nr] = NULL;
+        return;
+    }
+
     if(gdbstub_has_uart_isr_control()) {
         gdbstub_set_uart_isr_callback(NULL, NULL);
+        s_uart_isr_uarts[uart->uart_nr] = NULL;
         return;
     }
 
@@ -484,25 +574,33 @@ uart_stop_isr(uart_t* uart)
     USC1(uart->uart_nr) = 0;
     USIC(uart->uart_nr) = 0xffff;
     USIE(uart->uart_nr) = 0;
-    ETS_UART_INTR_ATTACH(NULL, NULL);
+    s_uart_isr_uarts[uart->uart_nr] = NULL;
+    if(uart_isr_needed(s_uart_isr_uarts[UART0]) || uart_isr_needed(s_uart_isr_uarts[UART1]))
+        ETS_UART_INTR_ENABLE();
+    else
+        ETS_UART_INTR_ATTACH(NULL, NULL);
 }
 
-/*
-  Reference for uart_tx_fifo_available() and uart_tx_fifo_full():
-  -Espressif Techinical Reference doc, chapter 11.3.7
-  -tools/sdk/uart_register.h
-  -cores/esp8266/esp8266_peri.h
-  */
-inline size_t
-uart_tx_fifo_available(const int uart_nr)
+bool
+uart_set_rx_thresholds(uart_t* uart, uint8_t fifo_full, uint8_t timeout)
 {
-    return (USS(uart_nr) >> USTXC) & 0xff;
-}
+    if(uart == NULL || !uart->rx_enabled)
+        return false;
 
-inline bool
-uart_tx_fifo_full(const int uart_nr)
-{
-    return uart_tx_fifo_available(uart_nr) >= 0x7f;
+    // both are 7 bit fields, an empty fifo is never "full"
+    if(fifo_full < 1 || fifo_full > 127 || timeout > 127)
+        return false;
+
+    // GDB sets its own thresholds
+    if(gdbstub_has_uart_isr_control())
+        return false;
+
+    ETS_UART_INTR_DISABLE();
+    uart->rx_fifo_full = fifo_full;
+    uart->rx_timeout = timeout;
+    USC1(uart->uart_nr) = uart_get_usc1(uart);
+    ETS_UART_INTR_ENABLE();
+    return true;
 }
 
 
@@ -514,6 +612,57 @@ uart_do_write_char(const int uart_nr, char c)
     USF(uart_nr) = c;
 }
 
+// Queue into the tx buffer, the tx fifo empty interrupt drains it.
+// Only waits while the buffer is full.
+static void
+uart_do_write_buffered(uart_t* uart, const char* buf, size_t size)
+{
+    struct uart_tx_buffer_ *tx_buffer = &uart->tx_buffer;
+
+    while (size)
+    {
+        ETS_UART_INTR_DISABLE();
+        // one byte is kept unused, rpos == wpos means empty
+        size_t chunk = tx_buffer->size - 1 - uart_tx_buffer_available_unsafe(tx_buffer);
+        size_t linear = tx_buffer->size - tx_buffer->wpos;
+        if (chunk > linear)
+            chunk = linear;
+        if (chunk > size)
+            chunk = size;
+        if (chunk)
+        {
+            memcpy_P(tx_buffer->buffer + tx_buffer->wpos, buf, chunk);
+            tx_buffer->wpos = (tx_buffer->wpos + chunk) % tx_buffer->size;
+            USIE(uart->uart_nr) |= (1 << UIFE);
+        }
+        else
+        {
+            // full: drain by hand, the isr may not be able to run
+            uart_tx_copy_buffer_to_fifo_unsafe(uart);
+        }
+        ETS_UART_INTR_ENABLE();
+
+        buf += chunk;
+        size -= chunk;
+        if (!chunk)
+            optimistic_yield(10000UL);
+    }
+}
+
+// Wait until everything in the tx buffer went to the hw fifo
+static void
+uart_tx_drain_buffer(uart_t* uart)
+{
+    while(uart->tx_buffer.rpos != uart->tx_buffer.wpos)
+    {
+        // also drains when the isr can't run
+        ETS_UART_INTR_DISABLE();
+        uart_tx_copy_buffer_to_fifo_unsafe(uart);
+        ETS_UART_INTR_ENABLE();
+        delay(0);
+    }
+}
+
 size_t
 uart_write_char(uart_t* uart, char c)
 {
@@ -524,7 +673,10 @@ uart_write_char(uart_t* uart, char c)
         gdbstub_write_char(c);
         return 1;
     }
-    uart_do_write_char(uart->uart_nr, c);
+    if(uart->tx_buffer.size)
+        uart_do_write_buffered(uart, &c, 1);
+    else
+        uart_do_write_char(uart->uart_nr, c);
     return 1;
 }
 
@@ -539,6 +691,11 @@ uart_write(uart_t* uart, const char* buf, size_t size)
         return 0;
     }
 
+    if(uart->tx_buffer.size) {
+        uart_do_write_buffered(uart, buf, size);
+        return size;
+    }
+
     size_t ret = size;
     const int uart_nr = uart->uart_nr;
     while (size--) {
@@ -550,12 +707,70 @@ uart_write(uart_t* uart, const char* buf, size_t size)
 }
 
 
+size_t
+uart_resize_tx_buffer(uart_t* uart, size_t new_size)
+{
+    if(uart == NULL || !uart->tx_enabled)
+        return 0;
+
+    // GDB owns the uart interrupt
+    if(gdbstub_has_uart_isr_control())
+        return 0;
+
+    struct uart_tx_buffer_ *tx_buffer = &uart->tx_buffer;
+    // one byte is always kept unused, so 1 can't hold anything
+    if(tx_buffer->size == new_size || new_size == 1)
+        return tx_buffer->size;
+
+    uint8_t * new_buf = NULL;
+    if(new_size)
+    {
+        new_buf = (uint8_t*)malloc(new_size);
+        if(!new_buf)
+            return tx_buffer->size;
+    }
+
+    // let pending data go out first
+    uart_tx_drain_buffer(uart);
+
+    ETS_UART_INTR_DISABLE();
+    USIE(uart->uart_nr) &= ~(1 << UIFE);
+    uint8_t * old_buf = tx_buffer->buffer;
+    tx_buffer->rpos = 0;
+    tx_buffer->wpos = 0;
+    tx_buffer->size = new_size;
+    tx_buffer->buffer = new_buf;
+    if(new_size)
+    {
+        USC1(uart->uart_nr) = (USC1(uart->uart_nr) & ~(0x7f << UCFET)) | (TXTRIGG << UCFET);
+        ETS_UART_INTR_ATTACH(uart_isr, NULL);
+    }
+    if(uart_isr_needed(s_uart_isr_uarts[UART0]) || uart_isr_needed(s_uart_isr_uarts[UART1]))
+        ETS_UART_INTR_ENABLE();
+    free(old_buf);
+    return tx_buffer->size;
+}
+
+size_t
+uart_get_tx_buffer_size(uart_t* uart)
+{
+    return uart && uart->tx_enabled? uart->tx_buffer.size: 0;
+}
+
 size_t
 uart_tx_free(uart_t* uart)
 {
     if(uart == NULL || !uart->tx_enabled)
         return 0;
 
+    if(uart->tx_buffer.size)
+    {
+        ETS_UART_INTR_DISABLE();
+        size_t used = uart_tx_buffer_available_unsafe(&uart->tx_buffer);
+        ETS_UART_INTR_ENABLE();
+        return uart->tx_buffer.size - 1 - used;
+    }
+
     return UART_TX_FIFO_SIZE - uart_tx_fifo_available(uart->uart_nr);
 }
 
@@ -565,6 +780,8 @@ uart_wait_tx_empty(uart_t* uart)
     if(uart == NULL || !uart->tx_enabled)
         return;
 
+    uart_tx_drain_buffer(uart);
+
     while(uart_tx_fifo_available(uart->uart_nr) > 0)
         delay(0);
 
@@ -581,13 +798,21 @@ uart_flush(uart_t* uart)
     {
         tmp |= (1 << UCRXRST);
         ETS_UART_INTR_DISABLE();
-        uart->rx_buffer->rpos = 0;
-        uart->rx_buffer->wpos = 0;
+        uart->rx_buffer->flush();
         ETS_UART_INTR_ENABLE();
     }
 
     if(uart->tx_enabled)
+    {
         tmp |= (1 << UCTXRST);
+        if(uart->tx_buffer.size)
+        {
+            ETS_UART_INTR_DISABLE();
+            uart->tx_buffer.rpos = 0;
+            uart->tx_buffer.wpos = 0;
+            ETS_UART_INTR_ENABLE();
+        }
+    }
 
     if(!gdbstub_has_uart_isr_control() || uart->uart_nr != UART0) {
         USC0(uart->uart_nr) |= (tmp);
@@ -624,6 +849,12 @@ uart_init(int uart_nr, int baudrate, int config, int mode, int tx_pin, size_t rx
     uart->uart_nr = uart_nr;
     uart->rx_overrun = false;
     uart->rx_error = false;
+    uart->rx_fifo_full = INTRIGG;
+    uart->rx_timeout = 0;
+    uart->tx_buffer.size = 0;
+    uart->tx_buffer.rpos = 0;
+    uart->tx_buffer.wpos = 0;
+    uart->tx_buffer.buffer = NULL;
 
     switch(uart->uart_nr)
     {
@@ -637,19 +868,10 @@ uart_init(int uart_nr, int baudrate, int config, int mode, int tx_pin, size_t rx
         uart->rx_pin = (uart->rx_enabled)?3:255;
         if(uart->rx_enabled)
         {
-            struct uart_rx_buffer_ * rx_buffer = (struct uart_rx_buffer_ *)malloc(sizeof(struct uart_rx_buffer_));
-            if(rx_buffer == NULL)
-            {
-              free(uart);
-              return NULL;
-            }
-            rx_buffer->size = rx_size;//var this
-            rx_buffer->rpos = 0;
-            rx_buffer->wpos = 0;
-            rx_buffer->buffer = (uint8_t *)malloc(rx_buffer->size);
-            if(rx_buffer->buffer == NULL)
+            cbuf_pow2 * rx_buffer = new (std::nothrow) cbuf_pow2(rx_size);
+            if(rx_buffer == NULL || !rx_buffer->capacity())
             {
-              free(rx_buffer);
+              delete rx_buffer;
               free(uart);
               return NULL;
             }
@@ -694,6 +916,8 @@ uart_init(int uart_nr, int baudrate, int config, int mode, int tx_pin, size_t rx
         return NULL;
     }
 
+    s_uart_isr_uarts[uart->uart_nr] = uart;
+
     uart_set_baudrate(uart, baudrate);
     if(uart->uart_nr == UART0 && invert)
     {
@@ -725,6 +949,7 @@ uart_uninit(uart_t* uart)
     if(uart == NULL)
         return;
 
+    uart_tx_drain_buffer(uart);
     uart_stop_isr(uart);
 
     if(uart->tx_enabled && (!gdbstub_has_uart_isr_control() || uart->uart_nr != UART0)) {
@@ -742,9 +967,10 @@ uart_uninit(uart_t* uart)
         }
     }
 
+    free(uart->tx_buffer.buffer);
+
     if(uart->rx_enabled) {
-        free(uart->rx_buffer->buffer);
-        free(uart->rx_buffer);
+        delete uart->rx_buffer;
         if(!gdbstub_has_uart_isr_control()) {
             switch(uart->rx_pin)
             {
@@ -128,6 +128,16 @@ int uart_get_baudrate(uart_t* uart);
 size_t uart_resize_rx_buffer(uart_t* uart, size_t new_size);
 size_t uart_get_rx_buffer_size(uart_t* uart);
 
+// fifo_full (1..127, default 16): rx fifo level that triggers the isr
+// timeout (0..127, default 0=off): also trigger after the line was idle
+// for this many symbol times, with fewer bytes in the fifo
+bool uart_set_rx_thresholds(uart_t* uart, uint8_t fifo_full, uint8_t timeout);
+
+// size 0 (default): uart_write() busy-waits on the hw fifo
+// otherwise: uart_write() queues, the tx fifo empty interrupt sends
+size_t uart_resize_tx_buffer(uart_t* uart, size_t new_size);
+size_t uart_get_tx_buffer_size(uart_t* uart);
+
 size_t uart_write_char(uart_t* uart, char c);
 size_t uart_write(uart_t* uart, const char* buf, size_t size);
 int uart_read_char(uart_t* uart);
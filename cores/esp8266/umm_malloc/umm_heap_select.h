@@ -1,6 +1,8 @@
 #ifndef UMM_MALLOC_SELECT_H
 #define UMM_MALLOC_SELECT_H
 
+#include <stdint.h>
+#include <stdlib.h>
 #include <umm_malloc/umm_malloc.h>
 
 #ifndef ALWAYS_INLINE
@@ -99,4 +101,84 @@ protected:
 #endif
 };
 
+/*
+  HeapArena reserves a single block from a Heap and hands out pieces of it
+  with a bump pointer. Pieces are not freed individually, the whole block is
+  released when the arena goes out of scope. Short lived work, like handling
+  one web request, then leaves no holes in the Heap.
+
+  {
+      HeapArena arena(2048);                  // from the current Heap
+      // or HeapArena arena(2048, UMM_HEAP_EXTERNAL);
+      char *buf = (char *)arena.alloc(128);   // nullptr when exhausted
+      ...
+  }   // everything allocated from arena is released here
+
+  Arena memory is 4 byte aligned. Destructors of objects placed in the arena
+  are not called, use it for plain data. Observe the IRAM Heap access rules
+  when selecting UMM_HEAP_IRAM.
+ */
+
+class HeapArena {
+public:
+  explicit HeapArena(size_t size) {
+    _reserve(size);
+  }
+
+  HeapArena(size_t size, size_t id) {
+    HeapSelect ephemeral(id);
+    _reserve(size);
+  }
+
+  ~HeapArena() {
+    free(_base);
+  }
+
+  HeapArena(const HeapArena&) = delete;
+  HeapArena& operator=(const HeapArena&) = delete;
+
+  void *alloc(size_t size) {
+    size = (size + (_align - 1)) & ~(_align - 1);
+    if (size > _size - _used) {
+      return nullptr;
+    }
+    void *ptr = _base + _used;
+    _used += size;
+    return ptr;
+  }
+
+  // Forget everything allocated so far, keeping the reserved block
+  void reset() {
+    _used = 0;
+  }
+
+  size_t size() const {
+    return _size;
+  }
+
+  size_t used() const {
+    return _used;
+  }
+
+  size_t available() const {
+    return _size - _used;
+  }
+
+  explicit operator bool() const {
+    return nullptr != _base;
+  }
+
+protected:
+  static constexpr size_t _align = sizeof(uint32_t);
+
+  void _reserve(size_t size) {
+    _base = (char *)malloc(size);
+    _size = _base ? (size & ~(_align - 1)) : 0;
+  }
+
+  char *_base = nullptr;
+  size_t _size = 0;
+  size_t _used = 0;
+};
+
 #endif // UMM_MALLOC_SELECT_H
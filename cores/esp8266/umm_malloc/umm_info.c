@@ -25,6 +25,37 @@
 
 // UMM_HEAP_INFO ummHeapInfo;
 
+#ifdef UMM_INLINE_METRICS
+static inline unsigned umm_free_class( uint16_t blocks ) {
+  return 31 - __builtin_clz(blocks);
+}
+
+/*
+ * Find the largest free entry again, after the one that was the largest
+ * was allocated from or merged. Only the free list is walked, and the walk
+ * stops at an entry as large as the largest non empty size class holds.
+ */
+static void umm_max_free_update( umm_heap_context_t *_context ) {
+  unsigned int max = 0;
+  int k = UMM_FREE_CLASSES - 1;
+
+  while (k >= 0 && !_context->info.freeClassCount[k]) {
+    --k;
+  }
+  if (k >= 0) {
+    const unsigned int top = (2u << k) - 1;
+    for (uint16_t c = UMM_NFREE(0); c && max < top; c = UMM_NFREE(c)) {
+      unsigned int blocks = (UMM_NBLOCK(c) & UMM_BLOCKNO_MASK) - c;
+      if (max < blocks) {
+        max = blocks;
+      }
+    }
+  }
+  _context->info.maxFreeContiguousBlocks = max;
+  _context->info.maxFreeStale = false;
+}
+#endif
+
 void *umm_info( void *ptr, bool force ) {
   UMM_CRITICAL_DECL(id_info);
 
@@ -41,7 +72,13 @@ void *umm_info( void *ptr, bool force ) {
    * Clear out all of the entries in the ummHeapInfo structure before doing
    * any calculations..
    */
+#ifdef UMM_INLINE_METRICS
+  size_t oom_count = _context->info.oom_count;
+  memset( &_context->info, 0, sizeof( _context->info ) );
+  _context->info.oom_count = oom_count;
+#else
   memset( &_context->info, 0, sizeof( _context->info ) );
+#endif
 
   DBGLOG_FORCE( force, "\n" );
   DBGLOG_FORCE( force, "+----------+-------+--------+--------+-------+--------+--------+\n" );
@@ -78,6 +115,9 @@ void *umm_info( void *ptr, bool force ) {
       if (_context->info.maxFreeContiguousBlocks < curBlocks) {
         _context->info.maxFreeContiguousBlocks = curBlocks;
       }
+#ifdef UMM_INLINE_METRICS
+      ++_context->info.freeClassCount[umm_free_class(curBlocks)];
+#endif
 
       DBGLOG_FORCE( force, "|0x%08lx|B %5d|NB %5d|PB %5d|Z %5u|NF %5d|PF %5d|\n",
           DBGLOG_32_BIT_PTR(&UMM_BLOCK(blockNo)),
@@ -187,11 +227,21 @@ size_t umm_free_heap_size( void ) {
 //C TODO: update at next major release.
 //C size_t umm_max_free_block_size( void ) {
 size_t umm_max_block_size_core( umm_heap_context_t *_context ) {
+#ifdef UMM_INLINE_METRICS
+  if (_context->info.maxFreeStale) {
+    UMM_CRITICAL_DECL(id_info);
+    UMM_CRITICAL_ENTRY(id_info);
+    umm_max_free_update(_context);
+    UMM_CRITICAL_EXIT(id_info);
+  }
+#endif
   return _context->info.maxFreeContiguousBlocks * sizeof(umm_block);
 }
 
 size_t umm_max_block_size( void ) {
+#ifndef UMM_INLINE_METRICS
   umm_info(NULL, false);
+#endif
   return umm_max_block_size_core(umm_get_current_heap());
 }
 
@@ -239,9 +289,26 @@ int umm_fragmentation_metric( void ) {
 }
 
 #ifdef UMM_INLINE_METRICS
+size_t umm_free_class_counts( uint16_t *counts, size_t n ) {
+  umm_heap_context_t *_context = umm_get_current_heap();
+
+  if (n > UMM_FREE_CLASSES) {
+    n = UMM_FREE_CLASSES;
+  }
+  UMM_CRITICAL_DECL(id_info);
+  UMM_CRITICAL_ENTRY(id_info);
+  memcpy(counts, _context->info.freeClassCount, n * sizeof(uint16_t));
+  UMM_CRITICAL_EXIT(id_info);
+  return n;
+}
+
 static void umm_fragmentation_metric_init( umm_heap_context_t *_context ) {
     _context->info.freeBlocks = UMM_NUMBLOCKS - 2;
     _context->info.freeBlocksSquared = _context->info.freeBlocks * _context->info.freeBlocks;
+    memset(_context->info.freeClassCount, 0, sizeof(_context->info.freeClassCount));
+    _context->info.freeClassCount[umm_free_class(_context->info.freeBlocks)] = 1;
+    _context->info.maxFreeContiguousBlocks = _context->info.freeBlocks;
+    _context->info.maxFreeStale = false;
 }
 
 static void umm_fragmentation_metric_add( umm_heap_context_t *_context, uint16_t c ) {
@@ -249,6 +316,10 @@ static void umm_fragmentation_metric_add( umm_heap_context_t *_context, uint16_t
     DBGLOG_DEBUG( "Add block %d size %d to free metric\n", c, blocks);
     _context->info.freeBlocks += blocks;
     _context->info.freeBlocksSquared += (blocks * blocks);
+    ++_context->info.freeClassCount[umm_free_class(blocks)];
+    if (_context->info.maxFreeContiguousBlocks < blocks) {
+      _context->info.maxFreeContiguousBlocks = blocks;
+    }
 }
 
 static void umm_fragmentation_metric_remove( umm_heap_context_t *_context, uint16_t c ) {
@@ -256,6 +327,10 @@ static void umm_fragmentation_metric_remove( umm_heap_context_t *_context, uint1
     DBGLOG_DEBUG( "Remove block %d size %d from free metric\n", c, blocks);
     _context->info.freeBlocks -= blocks;
     _context->info.freeBlocksSquared -= (blocks * blocks);
+    --_context->info.freeClassCount[umm_free_class(blocks)];
+    if (_context->info.maxFreeContiguousBlocks == blocks) {
+      _context->info.maxFreeStale = true;
+    }
 }
 #endif // UMM_INLINE_METRICS
 
@@ -134,5 +134,106 @@ clean:
 }
 
 #endif
+/* }}} */
+
+/* incremental integrity check {{{ */
+
+/*
+ * Check the next `blocks` blocks of the heaps, each in a critical section
+ * of its own, and remember where to go on at the next call.  After the last
+ * block of a heap it goes on with the next heap, then starts over.
+ *
+ * Only the links of each block and of its neighbours are checked, so
+ * nothing is marked and the heap may change between two calls.  A block
+ * that is no longer one when the walk comes back to it (merged by a free)
+ * restarts the walk of that heap from the start.
+ *
+ * Returns false, with the address of the broken block header in *where,
+ * when links do not match.
+ */
+static uint16_t umm_integrity_cursor[UMM_NUM_HEAPS];
+static size_t umm_integrity_heap;
+
+static bool umm_integrity_check_block(umm_heap_context_t *_context, uint16_t *cursor) {
+  uint16_t cur = *cursor;
+
+  if (cur) {
+    uint16_t prev = UMM_PBLOCK(cur) & UMM_BLOCKNO_MASK;
+    if (cur >= UMM_NUMBLOCKS || prev >= cur || (UMM_NBLOCK(prev) & UMM_BLOCKNO_MASK) != cur) {
+      *cursor = 0;
+      return true;
+    }
+  }
+
+  uint16_t next = UMM_NBLOCK(cur) & UMM_BLOCKNO_MASK;
+  if (next == 0) {
+    /* last block */
+    *cursor = 0;
+    return true;
+  }
+  if (next >= UMM_NUMBLOCKS || next <= cur) {
+    DBGLOG_FUNCTION("heap integrity broken: bad next block num: %d "
+        "(in block %d, addr 0x%08x)\n", next, cur,
+        DBGLOG_32_BIT_PTR(&UMM_NBLOCK(cur)));
+    return false;
+  }
+  if ((UMM_PBLOCK(next) & UMM_BLOCKNO_MASK) != cur) {
+    DBGLOG_FUNCTION("heap integrity broken: block links don't match: "
+        "%d -> %d, but %d -> %d\n",
+        cur, next, next, UMM_PBLOCK(next) & UMM_BLOCKNO_MASK);
+    return false;
+  }
+
+  if (UMM_NBLOCK(cur) & UMM_FREELIST_MASK) {
+    uint16_t nfree = UMM_NFREE(cur);
+    uint16_t pfree = UMM_PFREE(cur);
+    if (nfree >= UMM_NUMBLOCKS || pfree >= UMM_NUMBLOCKS ||
+        (nfree && (!(UMM_NBLOCK(nfree) & UMM_FREELIST_MASK) || UMM_PFREE(nfree) != cur)) ||
+        (pfree && !(UMM_NBLOCK(pfree) & UMM_FREELIST_MASK)) ||
+        UMM_NFREE(pfree) != cur) {
+      DBGLOG_FUNCTION("heap integrity broken: free links don't match "
+          "at block %d: %d <- %d -> %d\n", cur, pfree, cur, nfree);
+      return false;
+    }
+  }
+
+  *cursor = next;
+  return true;
+}
+
+bool umm_integrity_check_step(size_t blocks, void **where) {
+  bool ok = true;
+
+  UMM_INIT_HEAP;
+
+  while (blocks--) {
+    umm_heap_context_t *_context = umm_get_heap_by_id(umm_integrity_heap);
+    uint16_t *cursor = &umm_integrity_cursor[umm_integrity_heap];
+
+    if (_context && _context->heap) {
+      UMM_CRITICAL_DECL(id_no_tag);
+      UMM_CRITICAL_ENTRY(id_no_tag);
+      uint16_t cur = *cursor;
+      ok = umm_integrity_check_block(_context, cursor);
+      if (!ok && where) {
+        *where = &UMM_BLOCK(cur);
+      }
+      UMM_CRITICAL_EXIT(id_no_tag);
+      if (!ok) {
+        *cursor = 0;
+        break;
+      }
+    } else {
+      *cursor = 0;
+    }
+
+    if (*cursor == 0) {
+      umm_integrity_heap = (umm_integrity_heap + 1) % UMM_NUM_HEAPS;
+    }
+  }
+
+  return ok;
+}
+
 /* }}} */
 #endif  // defined(BUILD_UMM_MALLOC_C)
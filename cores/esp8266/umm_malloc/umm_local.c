@@ -155,6 +155,213 @@ void umm_poison_free_fl(void *ptr, const char* file, int line) {
 
 /* ------------------------------------------------------------------------ */
 
+#if defined(UMM_HEAP_PROFILE)
+/*
+ * Allocation call-site histogram, see UMM_HEAP_PROFILE in umm_malloc_cfg.h.
+ * The tag word keeps the slot index in the top 8 bits and the requested size
+ * in the lower 24 bits.
+ */
+#define UMM_HEAP_PROFILE_SIZE_MASK 0x00FFFFFFU
+
+#if defined(UMM_POISON_CHECK) || defined(UMM_POISON_CHECK_LITE)
+#define UMM_HEAP_PROFILE_BLOCKS(s) \
+  umm_blocks((s) + UMM_HEAP_PROFILE_TAG_SIZE + poison_size((s) + UMM_HEAP_PROFILE_TAG_SIZE))
+#else
+#define UMM_HEAP_PROFILE_BLOCKS(s) umm_blocks((s) + UMM_HEAP_PROFILE_TAG_SIZE)
+#endif
+
+static umm_heap_profile_site_t umm_heap_profile[UMM_HEAP_PROFILE_SLOTS];
+
+#if defined(UMM_HEAP_PROFILE_TRACE)
+/*
+ * Ring of the last UMM_HEAP_PROFILE_TRACE allocations and frees. `size` keeps
+ * the requested size in the lower 24 bits like the tag, UMM_HEAP_PROFILE_FREE
+ * marks a free. The counters only grow, their difference is the number of
+ * entries not printed yet.
+ */
+#define UMM_HEAP_PROFILE_FREE 0x80000000U
+
+typedef struct UMM_HEAP_PROFILE_TRACE_t {
+  const void *ptr;
+  const void *caller;
+  uint32_t size;
+} umm_heap_profile_trace_t;
+
+static umm_heap_profile_trace_t umm_heap_profile_trace[UMM_HEAP_PROFILE_TRACE];
+static uint32_t umm_heap_profile_trace_written;
+static uint32_t umm_heap_profile_trace_read;
+
+/*
+ * Must be called only from within critical sections guarded by
+ * UMM_CRITICAL_ENTRY() and UMM_CRITICAL_EXIT().
+ */
+static void umm_heap_profile_record( const void *ptr, uint32_t size, const void *caller ) {
+  umm_heap_profile_trace_t *entry =
+    &umm_heap_profile_trace[umm_heap_profile_trace_written++ % UMM_HEAP_PROFILE_TRACE];
+
+  entry->ptr = ptr;
+  entry->caller = caller;
+  entry->size = size;
+}
+#else
+#define umm_heap_profile_record(ptr, size, caller) (void)0
+#endif
+
+/*
+ * Must be called only from within critical sections guarded by
+ * UMM_CRITICAL_ENTRY() and UMM_CRITICAL_EXIT().
+ */
+static size_t umm_heap_profile_slot( const void *caller ) {
+  size_t slot;
+
+  for (slot = 0; slot < UMM_HEAP_PROFILE_SLOTS - 1; ++slot) {
+    if (umm_heap_profile[slot].caller == caller) {
+      break;
+    }
+    if (NULL == umm_heap_profile[slot].caller) {
+      umm_heap_profile[slot].caller = caller;
+      break;
+    }
+  }
+
+  return slot;
+}
+
+/*
+ * Takes a pointer returned by the allocator with UMM_HEAP_PROFILE_TAG_SIZE
+ * extra bytes, books `size` bytes on the call site and returns the pointer
+ * to hand to the user.
+ */
+void *umm_heap_profile_tag( void *ptr, size_t size, const void *caller ) {
+  UMM_CRITICAL_DECL(id_no_tag);
+  size_t slot;
+
+  if (NULL == ptr) {
+    return NULL;
+  }
+
+  UMM_CRITICAL_ENTRY(id_no_tag);
+  slot = umm_heap_profile_slot(caller);
+  umm_heap_profile[slot].count += 1;
+  umm_heap_profile[slot].bytes += size;
+  umm_heap_profile[slot].blocks += UMM_HEAP_PROFILE_BLOCKS(size);
+  umm_heap_profile_record((void *)((uintptr_t)ptr + UMM_HEAP_PROFILE_TAG_SIZE),
+                          size & UMM_HEAP_PROFILE_SIZE_MASK, caller);
+  UMM_CRITICAL_EXIT(id_no_tag);
+
+  *(uint32_t *)ptr = ((uint32_t)slot << 24) | ((uint32_t)size & UMM_HEAP_PROFILE_SIZE_MASK);
+
+  return (void *)((uintptr_t)ptr + UMM_HEAP_PROFILE_TAG_SIZE);
+}
+
+/*
+ * Takes a pointer returned by umm_heap_profile_tag(), removes it from its call
+ * site, and returns the size it was booked with. The allocation itself starts
+ * UMM_HEAP_PROFILE_TAG_SIZE bytes before `ptr`.
+ */
+size_t umm_heap_profile_untag( void *ptr ) {
+  UMM_CRITICAL_DECL(id_no_tag);
+  uint32_t tag = *(uint32_t *)((uintptr_t)ptr - UMM_HEAP_PROFILE_TAG_SIZE);
+  size_t slot = tag >> 24;
+  size_t size = tag & UMM_HEAP_PROFILE_SIZE_MASK;
+
+  if (slot >= UMM_HEAP_PROFILE_SLOTS) {
+    DBGLOG_ERROR( "umm_heap_profile: bad tag 0x%08x at 0x%08x\n", tag, (uintptr_t)ptr );
+    return size;
+  }
+
+  UMM_CRITICAL_ENTRY(id_no_tag);
+  umm_heap_profile[slot].count -= 1;
+  umm_heap_profile[slot].bytes -= size;
+  umm_heap_profile[slot].blocks -= UMM_HEAP_PROFILE_BLOCKS(size);
+  umm_heap_profile_record(ptr, UMM_HEAP_PROFILE_FREE, NULL);
+  UMM_CRITICAL_EXIT(id_no_tag);
+
+  return size;
+}
+
+size_t ICACHE_FLASH_ATTR umm_heap_profile_get( umm_heap_profile_site_t *sites, size_t count ) {
+  UMM_CRITICAL_DECL(id_no_tag);
+  size_t n = 0;
+
+  for (size_t slot = 0; slot < UMM_HEAP_PROFILE_SLOTS && n < count; ++slot) {
+    UMM_CRITICAL_ENTRY(id_no_tag);
+    if (umm_heap_profile[slot].count) {
+      sites[n] = umm_heap_profile[slot];
+      if (UMM_HEAP_PROFILE_SLOTS - 1 == slot) {
+        sites[n].caller = NULL;
+      }
+      ++n;
+    }
+    UMM_CRITICAL_EXIT(id_no_tag);
+  }
+
+  return n;
+}
+
+void ICACHE_FLASH_ATTR umm_heap_profile_print( void ) {
+  umm_heap_profile_site_t site;
+  size_t bytes = 0;
+
+  DBGLOG_FORCE( true, "umm heap profile:\n");
+  DBGLOG_FORCE( true, "  Caller       Allocs   Bytes  Blocks\n");
+  /* One site at a time, to keep this off the stack */
+  for (size_t slot = 0; slot < UMM_HEAP_PROFILE_SLOTS; ++slot) {
+    UMM_CRITICAL_DECL(id_no_tag);
+    UMM_CRITICAL_ENTRY(id_no_tag);
+    site = umm_heap_profile[slot];
+    UMM_CRITICAL_EXIT(id_no_tag);
+
+    if (0 == site.count) {
+      continue;
+    }
+    bytes += site.bytes;
+    if (UMM_HEAP_PROFILE_SLOTS - 1 == slot) {
+      DBGLOG_FORCE( true, "  (others)   %7u %7u %7u\n", site.count, site.bytes, site.blocks);
+    } else {
+      DBGLOG_FORCE( true, "  0x%08x %7u %7u %7u\n", (uintptr_t)site.caller, site.count, site.bytes, site.blocks);
+    }
+  }
+  DBGLOG_FORCE( true, "  Total bytes  %7u\n", bytes);
+  DBGLOG_FORCE( true, "+--------------------------------------------------------------+\n" );
+}
+
+#if defined(UMM_HEAP_PROFILE_TRACE)
+void ICACHE_FLASH_ATTR umm_heap_profile_trace_print( void ) {
+  umm_heap_profile_trace_t entry;
+  uint32_t lost = 0;
+
+  for (;;) {
+    UMM_CRITICAL_DECL(id_no_tag);
+    UMM_CRITICAL_ENTRY(id_no_tag);
+    if (umm_heap_profile_trace_written - umm_heap_profile_trace_read > UMM_HEAP_PROFILE_TRACE) {
+      lost += umm_heap_profile_trace_written - umm_heap_profile_trace_read - UMM_HEAP_PROFILE_TRACE;
+      umm_heap_profile_trace_read = umm_heap_profile_trace_written - UMM_HEAP_PROFILE_TRACE;
+    }
+    if (umm_heap_profile_trace_read == umm_heap_profile_trace_written) {
+      UMM_CRITICAL_EXIT(id_no_tag);
+      break;
+    }
+    /* One entry at a time, allocations may happen while printing */
+    entry = umm_heap_profile_trace[umm_heap_profile_trace_read++ % UMM_HEAP_PROFILE_TRACE];
+    UMM_CRITICAL_EXIT(id_no_tag);
+
+    if (lost) {
+      DBGLOG_FORCE( true, "# umm trace lost %u\n", lost);
+      lost = 0;
+    }
+    if (entry.size & UMM_HEAP_PROFILE_FREE) {
+      DBGLOG_FORCE( true, "f %08x\n", (uintptr_t)entry.ptr);
+    } else {
+      DBGLOG_FORCE( true, "m %08x %u %08x\n", (uintptr_t)entry.ptr, entry.size, (uintptr_t)entry.caller);
+    }
+  }
+}
+#endif
+#endif
+
+/* ------------------------------------------------------------------------ */
+
 #if defined(UMM_STATS) || defined(UMM_STATS_FULL) || defined(UMM_INFO)
 size_t umm_block_size( void ) {
   return sizeof(umm_block);
@@ -208,7 +415,11 @@ int ICACHE_FLASH_ATTR umm_info_safe_printf_P(const char *fmt, ...) {
     strcpy_P(ram_buf, fmt);
     va_list argPtr;
     va_start(argPtr, fmt);
+#ifdef UMM_TEST_BUILD
+    int result = vprintf(ram_buf, argPtr);
+#else
     int result = ets_vprintf(ets_uart_putc1, ram_buf, argPtr);
+#endif
     va_end(argPtr);
     return result;
 }
@@ -7,12 +7,14 @@
  *
  */
 
+#ifndef UMM_TEST_BUILD
 #undef memcpy
 #undef memmove
 #undef memset
 #define memcpy ets_memcpy
 #define memmove ets_memmove
 #define memset ets_memset
+#endif
 
 
 /*
@@ -26,7 +28,7 @@
 // #define DBGLOG_FORCE(force, format, ...) {if(force) {::printf(PSTR(format), ## __VA_ARGS__);}}
 
 
-#if defined(DEBUG_ESP_OOM) || defined(UMM_POISON_CHECK) || defined(UMM_POISON_CHECK_LITE) || defined(UMM_INTEGRITY_CHECK)
+#if defined(DEBUG_ESP_OOM) || defined(UMM_POISON_CHECK) || defined(UMM_POISON_CHECK_LITE) || defined(UMM_INTEGRITY_CHECK) || defined(UMM_HEAP_PROFILE) || defined(UMM_TEST_BUILD)
 #else
 
 #define umm_malloc(s)    malloc(s)
@@ -36,6 +38,10 @@
 #endif
 
 
+#if defined(UMM_HEAP_PROFILE)
+static uint16_t umm_blocks( size_t size );
+#endif
+
 #if defined(UMM_POISON_CHECK_LITE)
 static bool check_poison_neighbors( umm_heap_context_t *_context, uint16_t cur );
 #endif
@@ -61,6 +67,10 @@ struct UMM_HEAP_CONTEXT {
 #endif
 #ifdef UMM_INFO
   UMM_HEAP_INFO info;
+#endif
+#ifdef UMM_SLAB
+  uint16_t slab_head[UMM_SLAB_CLASSES];
+  uint8_t slab_count[UMM_SLAB_CLASSES];
 #endif
   unsigned short int numblocks;
   unsigned char id;
@@ -86,6 +86,13 @@ extern "C" {
 
 /* ------------------------------------------------------------------------- */
 
+#ifndef UMM_BLOCK_BODY_SIZE
+#define UMM_BLOCK_BODY_SIZE (8)
+#endif
+#if (UMM_BLOCK_BODY_SIZE < 8) || (UMM_BLOCK_BODY_SIZE % 4)
+#error "UMM_BLOCK_BODY_SIZE must be at least 8 and a multiple of 4"
+#endif
+
 UMM_H_ATTPACKPRE typedef struct umm_ptr_t {
   uint16_t next;
   uint16_t prev;
@@ -98,7 +105,7 @@ UMM_H_ATTPACKPRE typedef struct umm_block_t {
   } header;
   union {
     umm_ptr free;
-    uint8_t data[4];
+    uint8_t data[UMM_BLOCK_BODY_SIZE - sizeof(struct umm_ptr_t)];
   } body;
 } UMM_H_ATTPACKSUF umm_block;
 
@@ -451,6 +458,11 @@ void umm_init_common( size_t id, void *start_addr, size_t size, bool zero ) {
   _context->heap      = (umm_block *)start_addr;
   _context->heap_end  = (void *)((uintptr_t)start_addr + size);
   _context->numblocks = (size / sizeof(umm_block));
+#ifdef UMM_SLAB
+  /* heap_context is .noinit; a cache surviving a restart would be stale */
+  memset(_context->slab_head, 0x00, sizeof(_context->slab_head));
+  memset(_context->slab_count, 0x00, sizeof(_context->slab_count));
+#endif
 
   // An option for blocking the zeroing of extra heaps allows for performing
   // post-crash discovery.
@@ -571,6 +583,121 @@ static void umm_free_core( umm_heap_context_t *_context, void *ptr ) {
 
 /* ------------------------------------------------------------------------ */
 
+#ifdef UMM_SLAB
+/*
+ * Size class cache in front of umm_malloc_core()/umm_free_core(). See
+ * UMM_SLAB in umm_malloc_cfg.h. All of these must be called only from within
+ * critical sections guarded by UMM_CRITICAL_ENTRY() and UMM_CRITICAL_EXIT().
+ */
+
+static const uint16_t umm_slab_blocks[UMM_SLAB_CLASSES] = { 2, 3, 5, 9 };
+
+#define UMM_SLAB_LINK(c) (*(uint16_t *)&UMM_DATA(c))
+
+/*
+ * Returns the smallest size class that holds `blocks`, or UMM_SLAB_CLASSES
+ * when the request is too big to be cached.
+ */
+static size_t umm_slab_class( uint16_t blocks ) {
+  size_t cls = 0;
+
+  while( cls < UMM_SLAB_CLASSES && umm_slab_blocks[cls] < blocks )
+    ++cls;
+
+  return( cls );
+}
+
+/*
+ * Largest request size that still fits in the blocks of class `cls`; the
+ * inverse of umm_blocks().
+ */
+static size_t umm_slab_size( size_t cls ) {
+  return( (umm_slab_blocks[cls] - 1) * sizeof(umm_block) +
+          sizeof(((umm_block *)0)->body) );
+}
+
+static void *umm_slab_pop( umm_heap_context_t *_context, size_t cls ) {
+  uint16_t c = _context->slab_head[cls];
+
+  if( 0 == c )
+    return( (void *)NULL );
+
+  _context->slab_head[cls] = UMM_SLAB_LINK(c);
+  _context->slab_count[cls] -= 1;
+
+  DBGLOG_DEBUG( "Allocating %6d blocks starting at %6d - slab\n", umm_slab_blocks[cls], c );
+
+  return( (void *)&UMM_DATA(c) );
+}
+
+/*
+ * Caches the allocation at `ptr` if it is exactly a class size and that
+ * class has room. Returns false when the caller has to free it to the heap.
+ */
+static bool umm_slab_push( umm_heap_context_t *_context, void *ptr ) {
+  uint16_t c;
+  uint16_t blocks;
+  size_t cls;
+
+  if (NULL == _context) {
+    return false;
+  }
+
+  c = (((uintptr_t)ptr)-(uintptr_t)(&(_context->heap[0])))/sizeof(umm_block);
+  blocks = (UMM_NBLOCK(c) & UMM_BLOCKNO_MASK) - c;
+  cls = umm_slab_class( blocks );
+
+  if( cls >= UMM_SLAB_CLASSES || umm_slab_blocks[cls] != blocks ||
+      _context->slab_count[cls] >= UMM_SLAB_DEPTH )
+    return false;
+
+  STATS__FREE_REQUEST(id_free);
+
+  DBGLOG_DEBUG( "Caching block %6d in slab class %d\n", c, (int)cls );
+
+  UMM_SLAB_LINK(c) = _context->slab_head[cls];
+  _context->slab_head[cls] = c;
+  _context->slab_count[cls] += 1;
+
+  return true;
+}
+
+/*
+ * Returns every cached allocation of the heap back to the heap. Returns
+ * true if anything was released.
+ */
+static bool umm_slab_flush_core( umm_heap_context_t *_context ) {
+  bool released = false;
+
+  for( size_t cls = 0; cls < UMM_SLAB_CLASSES; ++cls ) {
+    void *ptr;
+
+    while( (ptr = umm_slab_pop( _context, cls )) ) {
+      umm_free_core( _context, ptr );
+      released = true;
+    }
+  }
+
+  return( released );
+}
+
+void umm_slab_flush( void ) {
+  UMM_CRITICAL_DECL(id_free);
+
+  UMM_INIT_HEAP;
+
+  umm_heap_context_t *_context = umm_get_current_heap();
+
+  UMM_CRITICAL_ENTRY(id_free);
+
+  umm_slab_flush_core( _context );
+
+  UMM_CRITICAL_EXIT(id_free);
+}
+#endif
+
+/* ------------------------------------------------------------------------ */
+
 void umm_free( void *ptr ) {
   UMM_CRITICAL_DECL(id_free);
 
@@ -590,7 +717,14 @@ void umm_free( void *ptr ) {
   UMM_CRITICAL_ENTRY(id_free);
 
   /* Need to be in the heap in which this block lives */
+#ifdef UMM_SLAB
+  umm_heap_context_t *_context = umm_get_ptr_context( ptr );
+
+  if( !umm_slab_push( _context, ptr ) )
+    umm_free_core( _context, ptr );
+#else
   umm_free_core( umm_get_ptr_context( ptr ), ptr );
+#endif
 
   UMM_CRITICAL_EXIT(id_free);
 }
@@ -816,8 +950,28 @@ void *umm_malloc( size_t size ) {
     _context = umm_get_heap_by_id(UMM_HEAP_DRAM);
   }
 
+#ifdef UMM_SLAB
+  size_t cls = umm_slab_class( umm_blocks( size ) );
+  if( cls < UMM_SLAB_CLASSES ) {
+    ptr = umm_slab_pop( _context, cls );
+    if( ptr ) {
+      STATS__ALLOC_REQUEST(id_malloc, size);
+      UMM_CRITICAL_EXIT(id_malloc);
+      return( ptr );
+    }
+    /* Round up, so this allocation can be cached once it is freed */
+    size = umm_slab_size( cls );
+  }
+
   ptr = umm_malloc_core( _context, size );
 
+  if( NULL == ptr && umm_slab_flush_core( _context ) ) {
+    ptr = umm_malloc_core( _context, size );
+  }
+#else
+  ptr = umm_malloc_core( _context, size );
+#endif
+
   UMM_CRITICAL_EXIT(id_malloc);
 
   return( ptr );
@@ -42,6 +42,36 @@ extern umm_heap_context_t *umm_set_heap_by_id( size_t which );
 extern size_t umm_get_current_heap_id( void );
 extern umm_heap_context_t *umm_get_current_heap( void );
 
+/* ------------------------------------------------------------------------ */
+
+//C Not in upstream: allocation by object class, see heap.cpp.
+// The class decides which Heap serves the allocation, so libraries tag
+// their buffers instead of selecting a Heap around each call site.
+typedef enum {
+    UMM_HEAP_CLASS_DEFAULT = 0, // the currently selected Heap
+    UMM_HEAP_CLASS_IOBUF,       // bulk I/O buffers (TLS records, ...), IRAM Heap when present
+    UMM_HEAP_CLASS_WORD32,      // data only accessed 32 bits at a time, IRAM Heap when present
+    UMM_HEAP_CLASS_DMA,         // read or written by DMA, always DRAM
+    UMM_HEAP_CLASS_COUNT
+} umm_heap_class_t;
+
+#define UMM_HEAP_CLASS_CURRENT ((size_t)-1)
+
+// Heap id used for a class, or UMM_HEAP_CLASS_CURRENT
+extern size_t umm_get_class_heap( umm_heap_class_t cls );
+// Route a class to another Heap id (or UMM_HEAP_CLASS_CURRENT).  DMA stays on DRAM.
+extern void umm_set_class_heap( umm_heap_class_t cls, size_t heap_id );
+// Allocate from the Heap of the class, falling back to DRAM when it is full
+extern void *umm_class_malloc( umm_heap_class_t cls, size_t size );
+extern void *umm_class_calloc( umm_heap_class_t cls, size_t num, size_t size );
+
+/* ------------------------------------------------------------------------ */
+
+//C Not in upstream: umm_integrity_check() a few blocks at a time, see
+// umm_integrity.c and ESP.startHeapCheck().  False when the links of a
+// block are broken, *where (if given) is then its header.
+extern bool umm_integrity_check_step( size_t blocks, void **where );
+
 #ifdef __cplusplus
 }
 #endif
@@ -101,6 +101,13 @@ extern "C" {
  * Set this if you want to use a first-fit algorithm for allocating new blocks.
  * Faster than UMM_BEST_FIT but can result in higher fragmentation.
  *
+ * UMM_BLOCK_BODY_SIZE=n
+ *
+ * Size of a heap block in bytes, header included, 8 by default. It must be
+ * at least 8 and a multiple of 4. Larger blocks waste more memory on small
+ * allocations but cover a larger heap with the 15 bit block numbers and
+ * shorten the free list.
+ *
  * UMM_INFO
  *
  * Enables a dump of the heap contents and a function to return the total
@@ -115,6 +122,8 @@ extern "C" {
  * can be used to gauge heap health.
  * Setting this at compile time will automatically set UMM_INFO.
  * Note that enabling this define will add a slight runtime penalty.
+ * The free heap size, the fragmentation metric and the largest free block
+ * are then known without the walk of umm_info().
  *
  * UMM_INTEGRITY_CHECK
  *
@@ -143,7 +152,9 @@ extern "C" {
  * ----------------------------------------------------------------------------
  */
 
+#ifndef UMM_FIRST_FIT
 #define UMM_BEST_FIT
+#endif
 #define UMM_INFO
 // #define UMM_INLINE_METRICS
 #define UMM_STATS
@@ -170,12 +181,13 @@ extern "C" {
 
 #ifdef UMM_TEST_BUILD
 extern char test_umm_heap[];
+extern size_t test_umm_heap_size;
 #endif
 
 #ifdef UMM_TEST_BUILD
-/* Start addresses and the size of the heap */
+/* Start addresses and the size of the heap, both set by the test program */
 #define UMM_MALLOC_CFG_HEAP_ADDR (test_umm_heap)
-#define UMM_MALLOC_CFG_HEAP_SIZE 0x10000
+#define UMM_MALLOC_CFG_HEAP_SIZE (test_umm_heap_size)
 #else
 /* Start addresses and the size of the heap */
 extern char _heap_start[];
@@ -242,6 +254,12 @@ extern char _heap_start[];
     size_t oom_count;
     #define UMM_OOM_COUNT info.oom_count
     #define UMM_FREE_BLOCKS info.freeBlocks
+    //C Not in upstream: free entries by size, [k] counts those of 2^k to
+    // 2^(k+1)-1 blocks.  maxFreeContiguousBlocks is kept as well, and only
+    // looked for again (in the free list) when the largest entry was taken.
+    #define UMM_FREE_CLASSES 16
+    uint16_t freeClassCount[UMM_FREE_CLASSES];
+    bool maxFreeStale;
 #endif
     unsigned int maxFreeContiguousBlocks;
   }
@@ -265,6 +283,10 @@ typedef struct UMM_HEAP_CONTEXT umm_heap_context_t;
   extern ICACHE_FLASH_ATTR size_t umm_max_block_size_core( umm_heap_context_t *_context );
   extern ICACHE_FLASH_ATTR int umm_usage_metric_core( umm_heap_context_t *_context );
   extern ICACHE_FLASH_ATTR int umm_fragmentation_metric_core( umm_heap_context_t *_context );
+#ifdef UMM_INLINE_METRICS
+  // copies up to n counts of freeClassCount of the current Heap, returns n
+  extern ICACHE_FLASH_ATTR size_t umm_free_class_counts( uint16_t *counts, size_t n );
+#endif
 #else
   #define umm_info(p,b)
   #define umm_free_heap_size() (0)
@@ -497,13 +519,15 @@ static inline void _critical_exit(UMM_TIME_STAT *p, uint32_t *saved_ps) {
 #ifdef UMM_TEST_BUILD
     extern int umm_critical_depth;
     extern int umm_max_critical_depth;
-    #define UMM_CRITICAL_ENTRY() {\
+    #define UMM_CRITICAL_DECL(tag)
+    #define UMM_CRITICAL_ENTRY(tag) {\
           ++umm_critical_depth; \
           if (umm_critical_depth > umm_max_critical_depth) { \
               umm_max_critical_depth = umm_critical_depth; \
           } \
     }
-    #define UMM_CRITICAL_EXIT()  (umm_critical_depth--)
+    #define UMM_CRITICAL_EXIT(tag)  (umm_critical_depth--)
+    #define UMM_CRITICAL_WITHINISR(tag) (0)
 #else
     #if defined(UMM_CRITICAL_METRICS)
         #define UMM_CRITICAL_DECL(tag) uint32_t _saved_ps_##tag
@@ -572,6 +596,109 @@ static inline void _critical_exit(UMM_TIME_STAT *p, uint32_t *saved_ps) {
 */
 #define UMM_REALLOC_DEFRAG
 
+/*
+ * -D UMM_SLAB
+ *
+ * Build option to keep a small cache of recently freed allocations in front
+ * of umm_malloc. Requests that fit in 8, 16, 32, or 64 bytes are rounded up
+ * to that size class (2, 3, 5, or 9 heap blocks). On free, an allocation of
+ * exactly a class size is pushed on a per-heap, per-class singly-linked list
+ * instead of being returned to the heap; the next malloc of that class pops
+ * it again in O(1), without walking the free list. The link is kept in the
+ * first 16 bits of the cached allocation's data.
+ *
+ * Up to UMM_SLAB_DEPTH allocations are cached per class. Cached allocations
+ * are still "in use" from the heap's point of view: they are not included in
+ * free heap size, max block size, or umm_info() free counts. When an
+ * allocation cannot be satisfied, the caches of that heap are flushed back to
+ * the heap and the allocation is retried, so no memory is lost to the cache.
+ * umm_slab_flush() does the same on demand for the current heap.
+ *
+ * Status: Local addition, not for upstream. Not normally enabled.
+ */
+/*
+#define UMM_SLAB
+ */
+
+#if defined(UMM_SLAB)
+#define UMM_SLAB_CLASSES 4
+#ifndef UMM_SLAB_DEPTH
+#define UMM_SLAB_DEPTH 8
+#endif
+extern void umm_slab_flush( void );
+#endif
+
+/*
+ * -D UMM_HEAP_PROFILE
+ *
+ * Build option to keep a live histogram of heap usage per allocating call
+ * site. Each allocation made through malloc, calloc, realloc, and the
+ * pvPort* APIs is prefixed with a 4 byte tag holding the requested size and
+ * the slot of its caller, identified by return address the same way
+ * DEBUG_ESP_OOM records umm_last_fail_alloc_addr. Free and realloc use the
+ * tag to take the allocation off the books again.
+ *
+ * Up to UMM_HEAP_PROFILE_SLOTS - 1 call sites are tracked, the last slot
+ * collects everything else and reports a NULL caller. Slots are not reused
+ * once assigned. Allocations made by the SDK and lwIP all go through
+ * pvPortMalloc and show up as a single site.
+ *
+ * umm_heap_profile_get() copies the sites with live allocations, e.g. for
+ * formatting over HTTP. umm_heap_profile_print() writes them to the debug
+ * UART like umm_info(). Use addr2line on the caller addresses to find the
+ * code.
+ *
+ * With -DUMM_HEAP_PROFILE_TRACE=n, the last n allocations and frees are also
+ * kept in a ring, 12 bytes each. umm_heap_profile_trace_print() writes the
+ * entries recorded since its previous call to the debug UART, one per line:
+ *
+ *   m <address> <size> <caller>
+ *   f <address>
+ *
+ * and reports entries lost to an overflow of the ring. Calling it often
+ * enough from loop() and capturing the UART gives a trace of the sketch's
+ * heap usage, which tests/host can replay against other umm_malloc
+ * configurations (make umm-replay). A realloc is recorded as the free of
+ * the old address followed by the allocation of the new one.
+ *
+ * Enabling this option also selects the heap.cpp malloc wrappers used by the
+ * debug build options.
+ *
+ * Status: Local addition, not for upstream. Not normally enabled.
+ */
+/*
+#define UMM_HEAP_PROFILE
+ */
+
+#if defined(UMM_HEAP_PROFILE)
+#ifndef UMM_HEAP_PROFILE_SLOTS
+#define UMM_HEAP_PROFILE_SLOTS 32
+#endif
+#if UMM_HEAP_PROFILE_SLOTS < 2 || UMM_HEAP_PROFILE_SLOTS > 256
+#error "UMM_HEAP_PROFILE_SLOTS must be between 2 and 256"
+#endif
+#define UMM_HEAP_PROFILE_TAG_SIZE (sizeof(uint32_t))
+
+typedef struct UMM_HEAP_PROFILE_SITE_t {
+  const void *caller;
+  size_t count;           // live allocations
+  size_t bytes;           // live bytes, as requested
+  size_t blocks;          // live umm_blocks, including tag and poison
+} umm_heap_profile_site_t;
+
+extern void *umm_heap_profile_tag( void *ptr, size_t size, const void *caller );
+extern size_t umm_heap_profile_untag( void *ptr );
+extern size_t umm_heap_profile_get( umm_heap_profile_site_t *sites, size_t count );
+extern void umm_heap_profile_print( void );
+
+#if defined(UMM_HEAP_PROFILE_TRACE)
+#if UMM_HEAP_PROFILE_TRACE < 1
+#error "UMM_HEAP_PROFILE_TRACE must be the number of ring entries"
+#endif
+extern void umm_heap_profile_trace_print( void );
+#endif
+#endif
+
 /*
  * -D UMM_INTEGRITY_CHECK :
  *
@@ -185,6 +185,29 @@ void ArduinoOTAClass::_onRx(){
     _md5.trim();
     if(_md5.length() != 32)
       return;
+    // Newer espota.py add a line of options: "W" when it can stream the
+    // image without waiting for the count of each chunk, "Z<window bits>:<size>"
+    // when it can send it zlib compressed. The reply to the invitation lists
+    // the ones we take, see _runUpdate()
+    String options = readStringUntil('\n');
+    options.trim();
+    _windowed = false;
+    _inflateSize = 0;
+    for (unsigned int start = 0; start < options.length(); ) {
+      int end = options.indexOf(' ', start);
+      if (end < 0) {
+        end = options.length();
+      }
+      String option = options.substring(start, end);
+      int colon = option.indexOf(':');
+      if (option == "W") {
+        _windowed = true;
+      } else if (option[0] == 'Z' && colon > 1) {
+        _inflateBits = option.substring(1, colon).toInt();
+        _inflateSize = option.substring(colon + 1).toInt();
+      }
+      start = end + 1;
+    }
 
     ota_ip = _ota_ip;
 
@@ -242,6 +265,8 @@ void ArduinoOTAClass::_onRx(){
 void ArduinoOTAClass::_runUpdate() {
   IPAddress ota_ip = _ota_ip;
 
+  // Write full buffers to flash in steps while the next one arrives
+  Update.setDoubleBuffer(_windowed);
   if (!Update.begin(_size, _cmd)) {
 #ifdef OTA_DEBUG
     OTA_DEBUG.println("Update Begin Error");
@@ -260,7 +285,15 @@ void ArduinoOTAClass::_runUpdate() {
     _state = OTA_IDLE;
     return;
   }
-  _udp_ota->append("OK", 2);
+  String reply = F("OK");
+  if (_windowed) {
+    reply += F(" W");
+  }
+  // Without heap for the window, take the image uncompressed
+  if (_inflateSize && Update.setInflate(_inflateSize, _inflateBits)) {
+    reply += F(" Z");
+  }
+  _udp_ota->append(reply.c_str(), reply.length());
   _udp_ota->send(ota_ip, _ota_udp_port);
   delay(100);
 
@@ -289,11 +322,14 @@ void ArduinoOTAClass::_runUpdate() {
   // OTA sends little packets
   client.setNoDelay(true);
 
-  uint32_t written, total = 0;
+  uint32_t written;
   while (!Update.isFinished() && (client.connected() || client.available())) {
     int waited = 1000;
-    while (!client.available() && waited--)
-      delay(1);
+    while (!client.available() && waited--) {
+      if (!_windowed || !Update.eraseAhead()) {
+        delay(1);
+      }
+    }
     if (!waited){
 #ifdef OTA_DEBUG
       OTA_DEBUG.printf("Receive Failed\n");
@@ -306,10 +342,11 @@ void ArduinoOTAClass::_runUpdate() {
     }
     written = Update.write(client);
     if (written > 0) {
-      client.print(written, DEC);
-      total += written;
+      if (!_windowed) {
+        client.print(written, DEC);
+      }
       if(_progress_callback) {
-        _progress_callback(total, _size);
+        _progress_callback(Update.progress(), Update.size());
       }
     }
   }
@@ -89,6 +89,9 @@ class ArduinoOTAClass
     uint16_t _ota_udp_port = 0;
     IPAddress _ota_ip;
     String _md5;
+    bool _windowed = false;
+    size_t _inflateSize = 0;
+    uint8_t _inflateBits = 0;
 
     THandlerFunction _start_callback = nullptr;
     THandlerFunction _end_callback = nullptr;
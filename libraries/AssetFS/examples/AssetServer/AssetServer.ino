@@ -0,0 +1,52 @@
+/*
+  AssetFS example
+
+  Serves the files of the assets/ directory, compiled into the sketch as
+  assets.cpp, with ESP8266WebServer.  After changing them, rebuild the
+  image from the sketch directory with:
+
+    python3 <core>/tools/mkassets.py -o assets.cpp assets
+
+  This example code is in the public domain.
+*/
+
+#include <ESP8266WiFi.h>
+#include <ESP8266WebServer.h>
+#include <AssetFS.h>
+
+#ifndef STASSID
+#define STASSID "your-ssid"
+#define STAPSK "your-password"
+#endif
+
+extern const uint8_t assets_image[];
+
+ESP8266WebServer server(80);
+
+void setup() {
+  Serial.begin(115200);
+  Serial.println();
+
+  AssetFS.setConfig(AssetFSConfig(assets_image));
+  if (!AssetFS.begin()) {
+    Serial.println("AssetFS: no image");
+    return;
+  }
+
+  WiFi.mode(WIFI_STA);
+  WiFi.begin(STASSID, STAPSK);
+  while (WiFi.status() != WL_CONNECTED) {
+    delay(500);
+    Serial.print(".");
+  }
+  Serial.println();
+  Serial.print("http://");
+  Serial.println(WiFi.localIP());
+
+  server.serveStatic("/", AssetFS, "/");
+  server.begin();
+}
+
+void loop() {
+  server.handleClient();
+}
@@ -0,0 +1,24 @@
+// AssetFS image generated by tools/mkassets.py from assets/, do not edit
+
+#include <Arduino.h>
+
+extern const uint8_t assets_image[] PROGMEM __attribute__((aligned(4)));
+const uint8_t assets_image[] PROGMEM __attribute__((aligned(4))) = {
+    0x41, 0x46, 0x53, 0x31, 0x02, 0x00, 0x00, 0x00, 0x04, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x30, 0x00, 0x00, 0x00, 0x48, 0x00, 0x00, 0x00, 0x95, 0x00, 0x00, 0x00, 0x16, 0x36, 0xd0, 0x6a,
+    0x3c, 0x00, 0x00, 0x00, 0xe0, 0x00, 0x00, 0x00, 0x22, 0x00, 0x00, 0x00, 0x17, 0x36, 0xd0, 0x6a,
+    0x2f, 0x69, 0x6e, 0x64, 0x65, 0x78, 0x2e, 0x68, 0x74, 0x6d, 0x6c, 0x00, 0x2f, 0x73, 0x74, 0x79,
+    0x6c, 0x65, 0x2e, 0x63, 0x73, 0x73, 0x00, 0x00, 0x3c, 0x21, 0x44, 0x4f, 0x43, 0x54, 0x59, 0x50,
+    0x45, 0x20, 0x68, 0x74, 0x6d, 0x6c, 0x3e, 0x0a, 0x3c, 0x68, 0x74, 0x6d, 0x6c, 0x3e, 0x0a, 0x3c,
+    0x68, 0x65, 0x61, 0x64, 0x3e, 0x3c, 0x74, 0x69, 0x74, 0x6c, 0x65, 0x3e, 0x41, 0x73, 0x73, 0x65,
+    0x74, 0x46, 0x53, 0x3c, 0x2f, 0x74, 0x69, 0x74, 0x6c, 0x65, 0x3e, 0x3c, 0x6c, 0x69, 0x6e, 0x6b,
+    0x20, 0x72, 0x65, 0x6c, 0x3d, 0x22, 0x73, 0x74, 0x79, 0x6c, 0x65, 0x73, 0x68, 0x65, 0x65, 0x74,
+    0x22, 0x20, 0x68, 0x72, 0x65, 0x66, 0x3d, 0x22, 0x73, 0x74, 0x79, 0x6c, 0x65, 0x2e, 0x63, 0x73,
+    0x73, 0x22, 0x3e, 0x3c, 0x2f, 0x68, 0x65, 0x61, 0x64, 0x3e, 0x0a, 0x3c, 0x62, 0x6f, 0x64, 0x79,
+    0x3e, 0x3c, 0x68, 0x31, 0x3e, 0x53, 0x65, 0x72, 0x76, 0x65, 0x64, 0x20, 0x66, 0x72, 0x6f, 0x6d,
+    0x20, 0x41, 0x73, 0x73, 0x65, 0x74, 0x46, 0x53, 0x3c, 0x2f, 0x68, 0x31, 0x3e, 0x3c, 0x2f, 0x62,
+    0x6f, 0x64, 0x79, 0x3e, 0x0a, 0x3c, 0x2f, 0x68, 0x74, 0x6d, 0x6c, 0x3e, 0x0a, 0x00, 0x00, 0x00,
+    0x62, 0x6f, 0x64, 0x79, 0x20, 0x7b, 0x20, 0x66, 0x6f, 0x6e, 0x74, 0x2d, 0x66, 0x61, 0x6d, 0x69,
+    0x6c, 0x79, 0x3a, 0x20, 0x73, 0x61, 0x6e, 0x73, 0x2d, 0x73, 0x65, 0x72, 0x69, 0x66, 0x3b, 0x20,
+    0x7d, 0x0a, 0x00, 0x00,
+};
@@ -0,0 +1,297 @@
+/*
+  AssetFS.cpp - read-only filesystem for an image in memory mapped flash
+
+  This file is part of the esp8266 core for Arduino environment.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <Arduino.h>
+#include <pgmspace.h>
+#include "AssetFS.h"
+
+// Image layout, see tools/mkassets.py
+#define ASSETFS_MAGIC 0x31534641    // 'AFS1'
+#define ASSETFS_HEADER 16
+#define ASSETFS_ENTRY 16
+
+namespace assetfs_impl {
+
+// Paths are looked up with a leading '/' and no trailing one
+static String normalize(const char* path)
+{
+    String p;
+    if (path[0] != '/') {
+        p = '/';
+    }
+    p += path;
+    while (p.length() > 1 && p[p.length() - 1] == '/') {
+        p.remove(p.length() - 1);
+    }
+    return p;
+}
+
+bool AssetFSImpl::setConfig(const FSConfig& cfg)
+{
+    if (cfg._type != AssetFSConfig::FSId || _mounted) {
+        return false;
+    }
+    _image = static_cast<const uint8_t*>(static_cast<const AssetFSConfig*>(&cfg)->_image);
+    return true;
+}
+
+bool AssetFSImpl::begin()
+{
+    if (_mounted) {
+        return true;
+    }
+    if (!_image || ((uintptr_t)_image & 3) || pgm_read_dword(_image) != ASSETFS_MAGIC) {
+        DEBUGV("AssetFS: no image\n");
+        return false;
+    }
+    _count = pgm_read_dword(_image + 4);
+    _size = pgm_read_dword(_image + 8);
+    _mounted = _image;
+    return true;
+}
+
+void AssetFSImpl::end()
+{
+    _mounted = nullptr;
+    _count = 0;
+}
+
+bool AssetFSImpl::info(FSInfo& info)
+{
+    if (!_mounted) {
+        return false;
+    }
+    info.totalBytes = _size;
+    info.usedBytes = _size;
+    info.blockSize = 4;
+    info.pageSize = 4;
+    info.maxOpenFiles = 255;
+    info.maxPathLength = 255;
+    return true;
+}
+
+bool AssetFSImpl::info64(FSInfo64& info64)
+{
+    FSInfo i;
+    if (!info(i)) {
+        return false;
+    }
+    info64.blockSize     = i.blockSize;
+    info64.pageSize      = i.pageSize;
+    info64.maxOpenFiles  = i.maxOpenFiles;
+    info64.maxPathLength = i.maxPathLength;
+    info64.totalBytes    = i.totalBytes;
+    info64.usedBytes     = i.usedBytes;
+    return true;
+}
+
+const uint8_t* AssetFSImpl::_entry(uint32_t index) const
+{
+    return _mounted + ASSETFS_HEADER + index * ASSETFS_ENTRY;
+}
+
+const char* AssetFSImpl::name(uint32_t index) const
+{
+    return (const char*)(_mounted + pgm_read_dword(_entry(index)));
+}
+
+const uint8_t* AssetFSImpl::data(uint32_t index) const
+{
+    return _mounted + pgm_read_dword(_entry(index) + 4);
+}
+
+uint32_t AssetFSImpl::size(uint32_t index) const
+{
+    return pgm_read_dword(_entry(index) + 8);
+}
+
+time_t AssetFSImpl::time(uint32_t index) const
+{
+    return pgm_read_dword(_entry(index) + 12);
+}
+
+uint32_t AssetFSImpl::lowerBound(const char* path) const
+{
+    uint32_t lo = 0, hi = _count;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (strcmp_P(path, name(mid)) > 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+bool AssetFSImpl::startsWith(uint32_t index, const char* prefix, size_t len) const
+{
+    return index < _count && strncmp_P(prefix, name(index), len) == 0;
+}
+
+FileImplPtr AssetFSImpl::open(const char* path, OpenMode openMode, AccessMode accessMode)
+{
+    if (!_mounted || !path || (accessMode & AM_WRITE) || openMode != OM_DEFAULT) {
+        return FileImplPtr();
+    }
+    String p = normalize(path);
+    uint32_t index = lowerBound(p.c_str());
+    if (index < _count && strcmp_P(p.c_str(), name(index)) == 0) {
+        return std::make_shared<AssetFSFileImpl>(this, index, p.c_str());
+    }
+    if (exists(p.c_str())) {
+        return std::make_shared<AssetFSFileImpl>(this, _count, p.c_str());
+    }
+    return FileImplPtr();
+}
+
+bool AssetFSImpl::exists(const char* path)
+{
+    if (!_mounted || !path) {
+        return false;
+    }
+    String p = normalize(path);
+    uint32_t index = lowerBound(p.c_str());
+    if (index < _count && strcmp_P(p.c_str(), name(index)) == 0) {
+        return true;
+    }
+    // a directory when some file is below it
+    if (p.length() > 1) {
+        p += '/';
+    }
+    return startsWith(lowerBound(p.c_str()), p.c_str(), p.length());
+}
+
+DirImplPtr AssetFSImpl::openDir(const char* path)
+{
+    if (!_mounted || !path) {
+        return DirImplPtr();
+    }
+    return std::make_shared<AssetFSDirImpl>(this, path);
+}
+
+AssetFSFileImpl::AssetFSFileImpl(AssetFSImpl* fs, uint32_t index, const char* path)
+    : _path(path)
+{
+    if (index < fs->count()) {
+        _data = fs->data(index);
+        _size = fs->size(index);
+        _time = fs->time(index);
+    } else {
+        _data = nullptr;
+        _size = 0;
+        _time = 0;
+    }
+}
+
+int AssetFSFileImpl::read(uint8_t* buf, size_t size)
+{
+    if (!_opened || !_data) {
+        return -1;
+    }
+    size = std::min(size, (size_t)(_size - _pos));
+    memcpy_P(buf, _data + _pos, size);
+    _pos += size;
+    return size;
+}
+
+bool AssetFSFileImpl::seek(uint32_t pos, SeekMode mode)
+{
+    if (!_opened) {
+        return false;
+    }
+    int64_t to = pos;
+    if (mode == SeekCur) {
+        to += _pos;
+    } else if (mode == SeekEnd) {
+        to = (int64_t)_size - pos;
+    }
+    if (to < 0 || to > _size) {
+        return false;
+    }
+    _pos = to;
+    return true;
+}
+
+const char* AssetFSFileImpl::name() const
+{
+    if (!_opened) {
+        return nullptr;
+    }
+    const char* slash = strrchr(_path.c_str(), '/');
+    return slash ? slash + 1 : _path.c_str();
+}
+
+AssetFSDirImpl::AssetFSDirImpl(AssetFSImpl* fs, const char* path)
+    : _fs(fs), _prefix(normalize(path))
+{
+    if (_prefix.length() > 1) {
+        _prefix += '/';
+    }
+    rewind();
+}
+
+bool AssetFSDirImpl::rewind()
+{
+    _next = _fs->lowerBound(_prefix.c_str());
+    _valid = false;
+    return true;
+}
+
+bool AssetFSDirImpl::next()
+{
+    const size_t len = _prefix.length();
+    while (_fs->startsWith(_next, _prefix.c_str(), len)) {
+        _index = _next++;
+        // the rest of the name, up to the next '/' for files deeper down
+        char child[256];
+        strncpy_P(child, _fs->name(_index) + len, sizeof(child) - 1);
+        child[sizeof(child) - 1] = 0;
+        char* slash = strchr(child, '/');
+        _directory = slash != nullptr;
+        if (slash) {
+            *slash = 0;
+        }
+        if (_valid && _directory && _name == child) {
+            // more files in the same subdirectory, which sort together
+            continue;
+        }
+        _name = child;
+        _valid = true;
+        return true;
+    }
+    _valid = false;
+    return false;
+}
+
+FileImplPtr AssetFSDirImpl::openFile(OpenMode openMode, AccessMode accessMode)
+{
+    if (!_valid) {
+        return FileImplPtr();
+    }
+    String path = _prefix + _name;
+    return _fs->open(path.c_str(), openMode, accessMode);
+}
+
+}; // namespace assetfs_impl
+
+#if !defined(NO_GLOBAL_INSTANCES) && !defined(NO_GLOBAL_ASSETFS)
+FS AssetFS = FS(FSImplPtr(new assetfs_impl::AssetFSImpl()));
+#endif
@@ -0,0 +1,178 @@
+/*
+  AssetFS.h - read-only filesystem for an image in memory mapped flash
+
+  This file is part of the esp8266 core for Arduino environment.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef __ASSETFS_H
+#define __ASSETFS_H
+
+#include <FS.h>
+#include <FSImpl.h>
+
+/*
+  The image is built by tools/mkassets.py, usually as a PROGMEM array
+  compiled into the sketch, and is read in place: a lookup bisects the
+  sorted entry table, and file data is copied with memcpy_P() straight
+  from the flash cache, without SPI transactions or filesystem metadata.
+  Any image reachable through the flash mapping works, in RAM too.
+
+  Paths are those of the files under the directory given to the tool,
+  directories exist as long as they hold a file.  Nothing can be written.
+*/
+
+using namespace fs;
+
+namespace assetfs_impl {
+
+class AssetFSConfig : public FSConfig
+{
+public:
+    static constexpr uint32_t FSId = 0x41534654;
+    AssetFSConfig(const void* image = nullptr) : FSConfig(FSId, false), _image(image) { }
+
+    AssetFSConfig setImage(const void* image) {
+        _image = image;
+        return *this;
+    }
+
+    const void* _image;
+};
+
+class AssetFSImpl : public FSImpl
+{
+public:
+    AssetFSImpl() { }
+
+    bool setConfig(const FSConfig& cfg) override;
+    bool begin() override;
+    void end() override;
+    bool format() override { return false; }
+    bool info(FSInfo& info) override;
+    bool info64(FSInfo64& info) override;
+    FileImplPtr open(const char* path, OpenMode openMode, AccessMode accessMode) override;
+    bool exists(const char* path) override;
+    DirImplPtr openDir(const char* path) override;
+    bool rename(const char* pathFrom, const char* pathTo) override {
+        (void) pathFrom;
+        (void) pathTo;
+        return false;
+    }
+    bool remove(const char* path) override {
+        (void) path;
+        return false;
+    }
+    bool mkdir(const char* path) override {
+        (void) path;
+        return false;
+    }
+    bool rmdir(const char* path) override {
+        (void) path;
+        return false;
+    }
+    bool dirCacheSupported() const override {
+        return true;
+    }
+
+    // Entry table access, all words read with pgm_read_dword()
+    uint32_t count() const { return _count; }
+    const char* name(uint32_t index) const;
+    const uint8_t* data(uint32_t index) const;
+    uint32_t size(uint32_t index) const;
+    time_t time(uint32_t index) const;
+    // First entry whose name is not below path
+    uint32_t lowerBound(const char* path) const;
+    // Whether the name of entry index starts with prefix
+    bool startsWith(uint32_t index, const char* prefix, size_t len) const;
+
+protected:
+    const uint8_t* _entry(uint32_t index) const;
+
+    const uint8_t* _image = nullptr;
+    const uint8_t* _mounted = nullptr;
+    uint32_t _count = 0;
+    uint32_t _size = 0;
+};
+
+class AssetFSFileImpl : public FileImpl
+{
+public:
+    // index == count() for a directory
+    AssetFSFileImpl(AssetFSImpl* fs, uint32_t index, const char* path);
+
+    size_t write(const uint8_t* buf, size_t size) override {
+        (void) buf;
+        (void) size;
+        return 0;
+    }
+    int read(uint8_t* buf, size_t size) override;
+    void flush() override { }
+    bool seek(uint32_t pos, SeekMode mode) override;
+    size_t position() const override { return _pos; }
+    size_t size() const override { return _size; }
+    bool truncate(uint32_t size) override {
+        (void) size;
+        return false;
+    }
+    void close() override { _opened = false; }
+    const char* name() const override;
+    const char* fullName() const override { return _opened ? _path.c_str() : nullptr; }
+    bool isFile() const override { return _opened && _data; }
+    bool isDirectory() const override { return _opened && !_data; }
+    time_t getLastWrite() override { return _time; }
+
+protected:
+    String _path;
+    const uint8_t* _data;
+    uint32_t _size;
+    uint32_t _pos = 0;
+    time_t _time;
+    bool _opened = true;
+};
+
+class AssetFSDirImpl : public DirImpl
+{
+public:
+    AssetFSDirImpl(AssetFSImpl* fs, const char* path);
+
+    FileImplPtr openFile(OpenMode openMode, AccessMode accessMode) override;
+    const char* fileName() override { return _valid ? _name.c_str() : nullptr; }
+    size_t fileSize() override { return _valid && !_directory ? _fs->size(_index) : 0; }
+    time_t fileTime() override { return _valid && !_directory ? _fs->time(_index) : 0; }
+    bool isFile() const override { return _valid && !_directory; }
+    bool isDirectory() const override { return _valid && _directory; }
+    bool next() override;
+    bool rewind() override;
+
+protected:
+    AssetFSImpl* _fs;
+    String _prefix;     // the directory with a trailing '/'
+    uint32_t _next;     // entry to look at next
+    uint32_t _index = 0;
+    String _name;       // of the current entry, relative to the directory
+    bool _directory = false;
+    bool _valid = false;
+};
+
+}; // namespace assetfs_impl
+
+#if !defined(NO_GLOBAL_INSTANCES) && !defined(NO_GLOBAL_ASSETFS)
+extern FS AssetFS;
+using assetfs_impl::AssetFSConfig;
+#endif
+
+#endif // __ASSETFS_H
@@ -10,9 +10,15 @@
 #endif
 
 #define DNS_HEADER_SIZE sizeof(DNSHeader)
+// Name pointer, type, class, TTL, RData length and the IPv4 address
+#define DNS_ANSWER_SIZE 16
+
+#define DNS_RECORD_WILDCARD 1
 
 DNSServer::DNSServer()
 {
+  _records = nullptr;
+  _recordsLength = 0;
   _ttl = lwip_htonl(60);
   _errorReplyCode = DNSReplyCode::NonExistentDomain;
 }
@@ -21,16 +27,113 @@ bool DNSServer::start(const uint16_t &port, const String &domainName,
                      const IPAddress &resolvedIP)
 {
   _port = port;
-  
-  _domainName = domainName;
-  _resolvedIP[0] = resolvedIP[0];
-  _resolvedIP[1] = resolvedIP[1];
-  _resolvedIP[2] = resolvedIP[2];
-  _resolvedIP[3] = resolvedIP[3];
-  downcaseAndRemoveWwwPrefix(_domainName);
+
+  // An empty name leaves the table empty, every query gets the error code
+  clearRecords();
+  addRecord(domainName.c_str(), resolvedIP);
   return _udp.begin(_port) == 1;
 }
 
+bool DNSServer::addRecord(const char *name, const IPAddress &ip)
+{
+  uint8_t flags = 0;
+  size_t nameLength;
+
+  if (strncasecmp(name, "www.", 4) == 0)
+    name += 4;
+  if (strcmp(name, "*") == 0) {
+    flags = DNS_RECORD_WILDCARD;
+    name += 1;
+  } else if (strncmp(name, "*.", 2) == 0) {
+    flags = DNS_RECORD_WILDCARD;
+    name += 2;
+  }
+
+  // In wire format every dot becomes a label length and one more leads
+  nameLength = strlen(name);
+  if (nameLength > MAX_DNSNAME_LENGTH || (nameLength == 0 && !flags))
+    return false;
+  if (nameLength != 0)
+    nameLength += 1;
+
+  uint8_t *records = (uint8_t *)realloc(_records, _recordsLength + 6 + nameLength);
+  if (records == nullptr)
+    return false;
+  _records = records;
+
+  uint8_t *record = _records + _recordsLength;
+  record[0] = ip[0];
+  record[1] = ip[1];
+  record[2] = ip[2];
+  record[3] = ip[3];
+  record[4] = flags;
+  record[5] = nameLength;
+
+  uint8_t *label = record + 6;
+  uint8_t *out = label + 1;
+  for (const char *in = name; nameLength != 0; ++in) {
+    if (*in == '.' || *in == '\0') {
+      size_t labelLength = out - label - 1;
+      if (labelLength == 0 || labelLength > 63)
+        return false;
+      *label = labelLength;
+      if (*in == '\0')
+        break;
+      label = out++;
+    } else {
+      *out++ = tolower(*in);
+    }
+  }
+
+  _recordsLength += 6 + nameLength;
+  return true;
+}
+
+void DNSServer::clearRecords()
+{
+  free(_records);
+  _records = nullptr;
+  _recordsLength = 0;
+}
+
+static bool labelsEqual(const uint8_t *query, const uint8_t *record, size_t length)
+{
+  // Label lengths are below 64 so they compare unchanged
+  for (size_t i = 0; i < length; ++i) {
+    if (tolower(query[i]) != record[i])
+      return false;
+  }
+  return true;
+}
+
+const uint8_t *DNSServer::findRecord(const uint8_t *name, size_t nameLength) const
+{
+  for (size_t offset = 0; offset < _recordsLength; offset += 6 + _records[offset + 5]) {
+    const uint8_t *record = _records + offset;
+    const size_t recordLength = record[5];
+
+    if (!(record[4] & DNS_RECORD_WILDCARD)) {
+      if (recordLength == nameLength
+          && labelsEqual(name, record + 6, recordLength))
+        return record;
+      continue;
+    }
+
+    // "*" alone answers every name
+    if (recordLength == 0)
+      return record;
+
+    // The suffix must start on a label boundary after at least one label
+    size_t skip = 0;
+    while (nameLength - skip > recordLength)
+      skip += name[skip] + 1;
+    if (skip != 0 && skip == nameLength - recordLength
+        && labelsEqual(name + skip, record + 6, recordLength))
+      return record;
+  }
+  return nullptr;
+}
+
 void DNSServer::setErrorReplyCode(const DNSReplyCode &replyCode)
 {
   _errorReplyCode = replyCode;
@@ -46,19 +149,12 @@ void DNSServer::stop()
   _udp.stop();
 }
 
-void DNSServer::downcaseAndRemoveWwwPrefix(String &domainName)
-{
-  domainName.toLowerCase();
-  if (domainName.startsWith("www."))
-      domainName.remove(0, 4);
-}
-
 void DNSServer::respondToRequest(uint8_t *buffer, size_t length)
 {
   DNSHeader *dnsHeader;
   uint8_t *query, *start;
-  const char *matchString;
-  size_t remaining, labelLength, queryLength;
+  const uint8_t *record;
+  size_t remaining, labelLength, queryLength, nameLength;
   uint16_t qtype, qclass;
 
   dnsHeader = (DNSHeader *)buffer;
@@ -99,6 +195,7 @@ void DNSServer::respondToRequest(uint8_t *buffer, size_t length)
   if (remaining < 5)
     return replyWithError(dnsHeader, DNSReplyCode::FormError);
 
+  nameLength = start - query;
   start += 1; // Skip the 0 length label that we found above
 
   memcpy(&qtype, start, sizeof(qtype));
@@ -118,83 +215,62 @@ void DNSServer::respondToRequest(uint8_t *buffer, size_t length)
     return replyWithError(dnsHeader, DNSReplyCode::NonExistentDomain,
 			  query, queryLength);
 
-  // If we have no domain name configured, just return an error
-  if (_domainName.isEmpty())
-    return replyWithError(dnsHeader, _errorReplyCode,
-			  query, queryLength);
-
-  // If we're running with a wildcard we can just return a result now
-  if (_domainName == "*")
-    return replyWithIP(dnsHeader, query, queryLength);
-
-  matchString = _domainName.c_str();
-
   start = query;
 
   // If there's a leading 'www', skip it
-  if (*start == 3 && strncasecmp("www", (char *) start + 1, 3) == 0)
-      start += 4;
-
-  while (*start != 0) {
-    labelLength = *start;
-    start += 1;
-    while (labelLength > 0) {
-      if (tolower(*start) != *matchString)
-	return replyWithError(dnsHeader, _errorReplyCode,
-			      query, queryLength);
-      ++start;
-      ++matchString;
-      --labelLength;
-    }
-    if (*start == 0 && *matchString == '\0')
-      return replyWithIP(dnsHeader, query, queryLength);
-
-    if (*matchString != '.')
-      return replyWithError(dnsHeader, _errorReplyCode,
-			    query, queryLength);
-    ++matchString;
+  if (nameLength >= 4 && *start == 3
+      && strncasecmp("www", (char *) start + 1, 3) == 0) {
+    start += 4;
+    nameLength -= 4;
   }
 
-  return replyWithError(dnsHeader, _errorReplyCode,
-			query, queryLength);
+  record = findRecord(start, nameLength);
+  if (record == nullptr)
+    return replyWithError(dnsHeader, _errorReplyCode,
+			  query, queryLength);
+
+  return replyWithIP(dnsHeader, query, queryLength, record);
 }
 
 void DNSServer::processNextRequest()
 {
-  size_t currentPacketSize;
-
-  currentPacketSize = _udp.parsePacket();
-  if (currentPacketSize == 0)
-    return;
-
-  // The DNS RFC requires that DNS packets be less than 512 bytes in size,
-  // so just discard them if they are larger
-  if (currentPacketSize > MAX_DNS_PACKETSIZE)
-    return;
-
-  // If the packet size is smaller than the DNS header, then someone is
-  // messing with us
-  if (currentPacketSize < DNS_HEADER_SIZE)
-    return;
-
-  std::unique_ptr<uint8_t[]> buffer(new (std::nothrow) uint8_t[currentPacketSize]);
-  if (buffer == nullptr)
-    return;
-
-  _udp.read(buffer.get(), currentPacketSize);
-  respondToRequest(buffer.get(), currentPacketSize);
+  processRequests(1);
 }
 
-void DNSServer::writeNBOShort(uint16_t value)
+size_t DNSServer::processRequests(size_t maxPackets)
 {
-   _udp.write((unsigned char *)&value, 2);
+  // The request is answered in place, room is left for the answer
+  uint8_t buffer[MAX_DNS_PACKETSIZE + DNS_ANSWER_SIZE];
+  size_t count = 0;
+
+  while (count < maxPackets) {
+    size_t currentPacketSize = _udp.parsePacket();
+    if (currentPacketSize == 0)
+      break;
+    ++count;
+
+    // The DNS RFC requires that DNS packets be less than 512 bytes in size,
+    // so just discard them if they are larger
+    if (currentPacketSize > MAX_DNS_PACKETSIZE)
+      continue;
+
+    // If the packet size is smaller than the DNS header, then someone is
+    // messing with us
+    if (currentPacketSize < DNS_HEADER_SIZE)
+      continue;
+
+    _udp.read(buffer, currentPacketSize);
+    respondToRequest(buffer, currentPacketSize);
+  }
+  return count;
 }
 
 void DNSServer::replyWithIP(DNSHeader *dnsHeader,
 			    unsigned char * query,
-			    size_t queryLength)
+			    size_t queryLength,
+			    const uint8_t *ip)
 {
-  uint16_t value;
+  uint8_t *answer = query + queryLength;
 
   dnsHeader->QR = DNS_QR_RESPONSE;
   dnsHeader->QDCount = lwip_htons(1);
@@ -202,27 +278,29 @@ void DNSServer::replyWithIP(DNSHeader *dnsHeader,
   dnsHeader->NSCount = 0;
   dnsHeader->ARCount = 0;
 
-  _udp.beginPacket(_udp.remoteIP(), _udp.remotePort());
-  _udp.write((unsigned char *) dnsHeader, sizeof(DNSHeader));
-  _udp.write(query, queryLength);
-
   // Rather than restate the name here, we use a pointer to the name contained
   // in the query section. Pointers have the top two bits set.
-  value = 0xC000 | DNS_HEADER_SIZE;
-  writeNBOShort(lwip_htons(value));
+  answer[0] = 0xC0;
+  answer[1] = DNS_HEADER_SIZE;
 
-  // Answer is type A (an IPv4 address)
-  writeNBOShort(lwip_htons(DNS_QTYPE_A));
-
-  // Answer is in the Internet Class
-  writeNBOShort(lwip_htons(DNS_QCLASS_IN));
+  // Answer is type A (an IPv4 address) in the Internet Class
+  answer[2] = 0;
+  answer[3] = DNS_QTYPE_A;
+  answer[4] = 0;
+  answer[5] = DNS_QCLASS_IN;
 
   // Output TTL (already NBO)
-  _udp.write((unsigned char*)&_ttl, 4);
+  memcpy(answer + 6, &_ttl, 4);
 
   // Length of RData is 4 bytes (because, in this case, RData is IPv4)
-  writeNBOShort(lwip_htons(sizeof(_resolvedIP)));
-  _udp.write(_resolvedIP, sizeof(_resolvedIP));
+  answer[10] = 0;
+  answer[11] = 4;
+  memcpy(answer + 12, ip, 4);
+
+  // Header, query and answer follow each other in the buffer
+  _udp.beginPacket(_udp.remoteIP(), _udp.remotePort());
+  _udp.write((unsigned char *) dnsHeader,
+	     DNS_HEADER_SIZE + queryLength + DNS_ANSWER_SIZE);
   _udp.endPacket();
 }
 
@@ -241,10 +319,9 @@ void DNSServer::replyWithError(DNSHeader *dnsHeader,
   dnsHeader->NSCount = 0;
   dnsHeader->ARCount = 0;
 
+  // The query, when present, directly follows the header
   _udp.beginPacket(_udp.remoteIP(), _udp.remotePort());
-  _udp.write((unsigned char *)dnsHeader, sizeof(DNSHeader));
-  if (query != NULL)
-     _udp.write(query, queryLength);
+  _udp.write((unsigned char *)dnsHeader, DNS_HEADER_SIZE + queryLength);
   _udp.endPacket();
 }
 
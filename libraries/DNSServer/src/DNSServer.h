@@ -14,6 +14,7 @@
 
 #define MAX_DNSNAME_LENGTH 253
 #define MAX_DNS_PACKETSIZE 512
+#define MAX_DNS_BATCH 8
 
 enum class DNSReplyCode
 {
@@ -51,8 +52,13 @@ class DNSServer
     DNSServer();
     ~DNSServer() {
         stop();
+        clearRecords();
     };
+    DNSServer(const DNSServer&) = delete;
+    DNSServer& operator=(const DNSServer&) = delete;
     void processNextRequest();
+    // Answers up to maxPackets queued requests, returns how many were read
+    size_t processRequests(size_t maxPackets = MAX_DNS_BATCH);
     void setErrorReplyCode(const DNSReplyCode &replyCode);
     void setTTL(const uint32_t &ttl);
 
@@ -63,18 +69,31 @@ class DNSServer
     // stops the DNS server
     void stop();
 
+    // Answer queries for name with ip.  "*" matches every name and
+    // "*.example.com" every name below example.com.  A leading "www." is
+    // ignored in names and in queries.  The first matching record wins,
+    // so add wildcards after the names they cover.  start() replaces the
+    // table with its own record.  Returns false on a malformed name or
+    // when out of memory.
+    bool addRecord(const char *name, const IPAddress &ip);
+    void clearRecords();
+
   private:
     WiFiUDP _udp;
     uint16_t _port;
-    String _domainName;
-    unsigned char _resolvedIP[4];
+    // Records packed back to back: 4 bytes of IP, a flags byte, the
+    // length of the name and the lowercase name in wire format (the
+    // suffix only for wildcards, no terminating root label)
+    uint8_t *_records;
+    size_t _recordsLength;
     uint32_t _ttl;
     DNSReplyCode _errorReplyCode;
 
-    void downcaseAndRemoveWwwPrefix(String &domainName);
+    const uint8_t *findRecord(const uint8_t *name, size_t nameLength) const;
     void replyWithIP(DNSHeader *dnsHeader,
 		     unsigned char * query,
-		     size_t queryLength);
+		     size_t queryLength,
+		     const uint8_t *ip);
     void replyWithError(DNSHeader *dnsHeader,
 			DNSReplyCode rcode,
 			unsigned char *query,
@@ -82,6 +101,5 @@ class DNSServer
     void replyWithError(DNSHeader *dnsHeader,
 			DNSReplyCode rcode);
     void respondToRequest(uint8_t *buffer, size_t length);
-    void writeNBOShort(uint16_t value);
 };
 #endif
@@ -21,6 +21,7 @@
 
 #include "Arduino.h"
 #include "EEPROM.h"
+#include <new>
 #include "debug.h"
 
 extern "C" {
@@ -33,11 +34,20 @@ extern "C" {
 
 extern "C" uint32_t _EEPROM_start;
 
+// Header and image must fit in one sector with room for the journal
+#define EEPROM_JOURNAL_MAX_SIZE (SPI_FLASH_SEC_SIZE - 256)
+
 EEPROMClass::EEPROMClass(uint32_t sector)
 : _sector(sector)
 {
 }
 
+EEPROMClass::EEPROMClass(uint32_t sector, uint32_t sectorCount)
+: _sector(sector)
+, _sectorCount(sectorCount < 2 ? 2 : sectorCount)
+{
+}
+
 EEPROMClass::EEPROMClass(void)
 : _sector((((uint32_t)&_EEPROM_start - 0x40200000) / SPI_FLASH_SEC_SIZE))
 {
@@ -52,6 +62,10 @@ void EEPROMClass::begin(size_t size) {
     DEBUGV("EEPROMClass::begin error, %d > %d\n", size, SPI_FLASH_SEC_SIZE);
     size = SPI_FLASH_SEC_SIZE;
   }
+  if (_sectorCount && size > EEPROM_JOURNAL_MAX_SIZE) {
+    DEBUGV("EEPROMClass::begin error, %d > %d\n", size, EEPROM_JOURNAL_MAX_SIZE);
+    size = EEPROM_JOURNAL_MAX_SIZE;
+  }
 
   size = (size + 3) & (~3);
 
@@ -65,7 +79,9 @@ void EEPROMClass::begin(size_t size) {
 
   _size = size;
 
-  if (!ESP.flashRead(_sector * SPI_FLASH_SEC_SIZE, reinterpret_cast<uint32_t*>(_data), _size)) {
+  if (_sectorCount) {
+    _journalBegin();
+  } else if (!ESP.flashRead(_sector * SPI_FLASH_SEC_SIZE, reinterpret_cast<uint32_t*>(_data), _size)) {
     DEBUGV("EEPROMClass::begin flash read failed\n");
   }
 
@@ -86,6 +102,8 @@ bool EEPROMClass::end() {
   _data = 0;
   _size = 0;
   _dirty = false;
+  delete[] _dirtyWords;
+  _dirtyWords = nullptr;
 
   return retval;
 }
@@ -120,6 +138,7 @@ void EEPROMClass::write(int const address, uint8_t const value) {
   {
     *pData = value;
     _dirty = true;
+    _markDirty(address, 1);
   }
 }
 
@@ -131,6 +150,15 @@ bool EEPROMClass::commit() {
   if(!_data)
     return false;
 
+  if (_sectorCount) {
+    if (_journalCommit()) {
+      _dirty = false;
+      return true;
+    }
+    DEBUGV("EEPROMClass::commit failed\n");
+    return false;
+  }
+
   if (ESP.flashEraseSector(_sector)) {
     if (ESP.flashWrite(_sector * SPI_FLASH_SEC_SIZE, reinterpret_cast<uint32_t*>(_data), _size)) {
       _dirty = false;
@@ -144,6 +172,7 @@ bool EEPROMClass::commit() {
 
 uint8_t * EEPROMClass::getDataPtr() {
   _dirty = true;
+  _dirtyAll = true;
   return &_data[0];
 }
 
@@ -151,6 +180,188 @@ uint8_t const * EEPROMClass::getConstDataPtr() const {
   return &_data[0];
 }
 
+/*
+  Journal layout, one sector per page: a header, the full image as of the
+  last compaction, then 8 byte entries each replacing one 32 bit word.
+  The page with the highest generation is current.  A compaction writes
+  the image to the next page and its header last, so a reset during it
+  leaves the previous page in use.
+*/
+namespace {
+  constexpr uint32_t EEPROM_JOURNAL_MAGIC = 0x4a454545; // "EEEJ"
+
+  struct JournalHeader {
+    uint32_t magic;
+    uint32_t generation;
+    uint32_t size;
+    uint32_t check;     // ~(generation ^ size)
+  };
+
+  struct JournalEntry {
+    uint16_t word;
+    uint16_t wordInv;
+    uint32_t value;
+  };
+}
+
+void EEPROMClass::_markDirty(size_t address, size_t length) {
+  if (!_dirtyWords) {
+    return;
+  }
+  for (size_t word = address / 4; word <= (address + length - 1) / 4; ++word) {
+    _dirtyWords[word / 32] |= 1U << (word % 32);
+  }
+}
+
+bool EEPROMClass::_journalLoad(uint8_t* data) {
+  const uint32_t base = (_sector + _page) * SPI_FLASH_SEC_SIZE;
+  JournalHeader header;
+  if (!ESP.flashRead(base, reinterpret_cast<uint32_t*>(&header), sizeof(header))) {
+    return false;
+  }
+  const uint32_t stored = header.size < _size ? header.size : _size;
+  memset(data, 0xff, _size);
+  if (!ESP.flashRead(base + sizeof(header), reinterpret_cast<uint32_t*>(data), stored)) {
+    return false;
+  }
+
+  // Replay the entries; stop at the first blank or torn one
+  uint32_t offset = sizeof(header) + header.size;
+  while (offset + sizeof(JournalEntry) <= SPI_FLASH_SEC_SIZE) {
+    JournalEntry entry;
+    if (!ESP.flashRead(base + offset, reinterpret_cast<uint32_t*>(&entry), sizeof(entry))) {
+      return false;
+    }
+    if (entry.word == 0xffff && entry.wordInv == 0xffff) {
+      break;
+    }
+    if (entry.word != (uint16_t)~entry.wordInv) {
+      // Can't append behind damaged data, compact on next commit
+      _journalOffset = 0;
+      return true;
+    }
+    if ((entry.word + 1) * 4 <= _size) {
+      memcpy(data + entry.word * 4, &entry.value, 4);
+    }
+    offset += sizeof(entry);
+  }
+  _journalOffset = (header.size == _size && offset + sizeof(JournalEntry) <= SPI_FLASH_SEC_SIZE) ? offset : 0;
+  return true;
+}
+
+bool EEPROMClass::_journalBegin() {
+  delete[] _dirtyWords;
+  const size_t words = _size / 4;
+  _dirtyWords = new uint32_t[(words + 31) / 32]();
+  _dirtyAll = false;
+
+  bool found = false;
+  for (uint32_t page = 0; page < _sectorCount; ++page) {
+    JournalHeader header;
+    if (!ESP.flashRead((_sector + page) * SPI_FLASH_SEC_SIZE, reinterpret_cast<uint32_t*>(&header), sizeof(header))) {
+      continue;
+    }
+    if (header.magic != EEPROM_JOURNAL_MAGIC || header.check != ~(header.generation ^ header.size) ||
+        header.size > EEPROM_JOURNAL_MAX_SIZE) {
+      continue;
+    }
+    if (!found || (int32_t)(header.generation - _generation) > 0) {
+      found = true;
+      _page = page;
+      _generation = header.generation;
+    }
+  }
+  if (!found) {
+    // Blank or foreign data, start with an erased image
+    memset(_data, 0xff, _size);
+    _page = _sectorCount - 1;
+    _generation = 0;
+    _journalOffset = 0;
+    return true;
+  }
+  if (!_journalLoad(_data)) {
+    DEBUGV("EEPROMClass::begin flash read failed\n");
+    return false;
+  }
+  return true;
+}
+
+bool EEPROMClass::_journalCompact() {
+  const uint32_t page = (_page + 1) % _sectorCount;
+  const uint32_t base = (_sector + page) * SPI_FLASH_SEC_SIZE;
+  JournalHeader header = { EEPROM_JOURNAL_MAGIC, _generation + 1, _size, ~((_generation + 1) ^ _size) };
+  if (!ESP.flashEraseSector(_sector + page) ||
+      !ESP.flashWrite(base + sizeof(header), reinterpret_cast<uint32_t*>(_data), _size) ||
+      !ESP.flashWrite(base, reinterpret_cast<uint32_t*>(&header), sizeof(header))) {
+    return false;
+  }
+  _page = page;
+  _generation++;
+  _journalOffset = sizeof(header) + _size;
+  if (_journalOffset + sizeof(JournalEntry) > SPI_FLASH_SEC_SIZE) {
+    _journalOffset = 0;
+  }
+  memset(_dirtyWords, 0, ((_size / 4) + 31) / 32 * 4);
+  _dirtyAll = false;
+  return true;
+}
+
+bool EEPROMClass::_journalCommit() {
+  const size_t words = _size / 4;
+  if (_dirtyAll) {
+    // The caller had the raw pointer, find what changed against flash
+    uint8_t* stored = _journalOffset ? new (std::nothrow) uint8_t[_size] : nullptr;
+    if (!stored || !_journalLoad(stored)) {
+      delete[] stored;
+      return _journalCompact();
+    }
+    for (size_t word = 0; word < words; ++word) {
+      if (memcmp(stored + word * 4, _data + word * 4, 4) != 0) {
+        _dirtyWords[word / 32] |= 1U << (word % 32);
+      }
+    }
+    delete[] stored;
+    _dirtyAll = false;
+  }
+
+  size_t changed = 0;
+  for (size_t word = 0; word < words; ++word) {
+    if (_dirtyWords[word / 32] & (1U << (word % 32))) {
+      changed++;
+    }
+  }
+  if (!changed) {
+    return true;
+  }
+  if (!_journalOffset || _journalOffset + changed * sizeof(JournalEntry) > SPI_FLASH_SEC_SIZE) {
+    return _journalCompact();
+  }
+
+  // Append the entries in small batches, each a single flash write
+  const uint32_t base = (_sector + _page) * SPI_FLASH_SEC_SIZE;
+  JournalEntry batch[16];
+  size_t count = 0;
+  for (size_t word = 0; word < words; ++word) {
+    if (!(_dirtyWords[word / 32] & (1U << (word % 32)))) {
+      continue;
+    }
+    batch[count].word = word;
+    batch[count].wordInv = ~word;
+    memcpy(&batch[count].value, _data + word * 4, 4);
+    if (++count == sizeof(batch) / sizeof(batch[0]) || --changed == 0) {
+      if (!ESP.flashWrite(base + _journalOffset, reinterpret_cast<uint32_t*>(batch), count * sizeof(JournalEntry))) {
+        // Part of it may have been written, compact on the next commit
+        _journalOffset = 0;
+        return false;
+      }
+      _journalOffset += count * sizeof(JournalEntry);
+      count = 0;
+    }
+  }
+  memset(_dirtyWords, 0, ((words + 31) / 32) * 4);
+  return true;
+}
+
 #if !defined(NO_GLOBAL_INSTANCES) && !defined(NO_GLOBAL_EEPROM)
 EEPROMClass EEPROM;
 #endif
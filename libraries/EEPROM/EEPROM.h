@@ -29,6 +29,10 @@
 class EEPROMClass {
 public:
   EEPROMClass(uint32_t sector);
+  // Journaled EEPROM over sectorCount (at least 2) sectors starting at
+  // sector: commit() appends the changed words and only erases a sector
+  // when the journal is full. Not compatible with the single sector layout.
+  EEPROMClass(uint32_t sector, uint32_t sectorCount);
   EEPROMClass(void);
 
   void begin(size_t size);
@@ -56,6 +60,7 @@ public:
     if (memcmp(_data + address, (const uint8_t*)&t, sizeof(T)) != 0) {
       _dirty = true;
       memcpy(_data + address, (const uint8_t*)&t, sizeof(T));
+      _markDirty(address, sizeof(T));
     }
 
     return t;
@@ -67,10 +72,24 @@ public:
   uint8_t const & operator[](int const address) const {return getConstDataPtr()[address];}
 
 protected:
+  void _markDirty(size_t address, size_t length);
+  bool _journalBegin();
+  bool _journalCommit();
+  bool _journalCompact();
+  bool _journalLoad(uint8_t* data);
+
   uint32_t _sector;
   uint8_t* _data = nullptr;
   size_t _size = 0;
   bool _dirty = false;
+
+  // Journal state, unused with a single sector
+  uint32_t _sectorCount = 0;
+  uint32_t _page = 0;         // sector index holding the current image
+  uint32_t _generation = 0;
+  uint32_t _journalOffset = 0; // next free entry in _page, 0 forces compaction
+  uint32_t* _dirtyWords = nullptr; // bit per word changed since commit()
+  bool _dirtyAll = false;     // getDataPtr() was used, compare with flash
 };
 
 #if !defined(NO_GLOBAL_INSTANCES) && !defined(NO_GLOBAL_EEPROM)
@@ -38,7 +38,8 @@ extern "C" {
 #define AVRISP_HWVER 2
 #define AVRISP_SWMAJ 1
 #define AVRISP_SWMIN 18
-#define AVRISP_PTIME 10
+#define AVRISP_PTIME 10       // page write time without polling, ms
+#define AVRISP_EETIME 45      // EEPROM byte write time without polling, ms
 
 #define EECHUNK (32)
 
@@ -133,8 +134,16 @@ uint8_t ESP8266AVRISP::getch() {
 
 void ESP8266AVRISP::fill(int n) {
     // AVRISP_DEBUG("fill(%u)", n);
-    for (int x = 0; x < n; x++) {
-        buff[x] = getch();
+    int x = 0;
+    while (x < n) {
+        if (!_client.available()) {
+            yield();
+            continue;
+        }
+        int got = _client.read(&buff[x], n - x);
+        if (got > 0) {
+            x += got;
+        }
     }
 }
 
@@ -226,9 +235,12 @@ void ESP8266AVRISP::start_pmode() {
 
     spi_transaction(0xAC, 0x53, 0x00, 0x00);
     pmode = 1;
+    _busy = false;
+    memset(&_stats, 0, sizeof(_stats));
 }
 
 void ESP8266AVRISP::end_pmode() {
+    wait_ready();
     SPI.end();
     setReset(_reset_state);
     pmode = 0;
@@ -238,6 +250,7 @@ void ESP8266AVRISP::universal() {
     uint8_t ch;
 
     fill(4);
+    wait_ready();
     ch = spi_transaction(buff[0], buff[1], buff[2], buff[3]);
     breply(ch);
 }
@@ -251,7 +264,31 @@ void ESP8266AVRISP::flash(uint8_t hilo, int addr, uint8_t data) {
 
 void ESP8266AVRISP::commit(int addr) {
     spi_transaction(0x4C, (addr >> 8) & 0xFF, addr & 0xFF, 0);
-    delay(AVRISP_PTIME);
+    start_busy(AVRISP_PTIME);
+}
+
+// Writes run on the target while the reply goes out and the next command
+// comes in, whatever touches the target next waits for them here.
+void ESP8266AVRISP::start_busy(uint32_t ms) {
+    _busy = true;
+    _busy_start = millis();
+    _busy_ms = ms;
+}
+
+void ESP8266AVRISP::wait_ready() {
+    if (!_busy) {
+        return;
+    }
+    uint32_t start = micros();
+    while (millis() - _busy_start < _busy_ms) {
+        // Poll RDY/BSY: bit 0 clear once the write is done
+        if (param.polling && !(spi_transaction(0xF0, 0x00, 0x00, 0x00) & 1)) {
+            break;
+        }
+        optimistic_yield(1000);
+    }
+    _busy = false;
+    _stats.wait_us += micros() - start;
 }
 
 //#define _addr_page(x) (here & 0xFFFFE0)
@@ -266,6 +303,7 @@ int ESP8266AVRISP::addr_page(int addr) {
 
 
 void ESP8266AVRISP::write_flash(int length) {
+    uint32_t start = micros();
     fill(length);
 
     if (Sync_CRC_EOP == getch()) {
@@ -275,21 +313,49 @@ void ESP8266AVRISP::write_flash(int length) {
       error++;
       _client.print((char) Resp_STK_NOSYNC);
     }
+
+    uint32_t took = micros() - start;
+    _stats.pages++;
+    _stats.last_us = took;
+    _stats.max_us = std::max(_stats.max_us, took);
+    _stats.total_us += took;
+    AVRISP_DEBUG("page 0x%04x: %u us", here, took);
 }
 
 uint8_t ESP8266AVRISP::write_flash_pages(int length) {
+    // Load Program Memory Page commands, 16 bytes per transfer
+    uint8_t cmd[64];
+    size_t n = 0;
     int x = 0;
     int page = addr_page(here);
+    wait_ready();
     while (x < length) {
-        yield();
         if (page != addr_page(here)) {
+            SPI.writeBytes(cmd, n);
+            n = 0;
             commit(page);
+            wait_ready();
             page = addr_page(here);
         }
-        flash(LOW, here, buff[x++]);
-        flash(HIGH, here, buff[x++]);
+        cmd[n++] = 0x40;
+        cmd[n++] = (here >> 8) & 0xFF;
+        cmd[n++] = here & 0xFF;
+        cmd[n++] = buff[x++];
+        cmd[n++] = 0x48;
+        cmd[n++] = (here >> 8) & 0xFF;
+        cmd[n++] = here & 0xFF;
+        cmd[n++] = buff[x++];
         here++;
+        if (n == sizeof(cmd)) {
+            SPI.writeBytes(cmd, n);
+            n = 0;
+            yield();
+        }
+    }
+    if (n) {
+        SPI.writeBytes(cmd, n);
     }
+    // completes while the host sends the next page
     commit(page);
     return Resp_STK_OK;
 }
@@ -318,8 +384,9 @@ uint8_t ESP8266AVRISP::write_eeprom_chunk(int start, int length) {
     // prog_lamp(LOW);
     for (int x = 0; x < length; x++) {
         int addr = start + x;
+        wait_ready();
         spi_transaction(0xC0, (addr >> 8) & 0xFF, addr & 0xFF, buff[x]);
-        delay(45);
+        start_busy(AVRISP_EETIME);
     }
     // prog_lamp(HIGH);
     return Resp_STK_OK;
@@ -365,6 +432,7 @@ bool ESP8266AVRISP::flash_read_page(int length) {
     {
         return false;
     }
+    wait_ready();
     for (int x = 0; x < length; x += 2) {
         *(data + x) = flash_read(LOW, here);
         *(data + x + 1) = flash_read(HIGH, here);
@@ -384,6 +452,7 @@ bool ESP8266AVRISP::eeprom_read_page(int length) {
         return false;
     }
     int start = here * 2;
+    wait_ready();
     for (int x = 0; x < length; x++) {
         int addr = start + x;
         uint8_t ee = spi_transaction(0xA0, (addr >> 8) & 0xFF, addr & 0xFF, 0xFF);
@@ -418,6 +487,7 @@ void ESP8266AVRISP::read_signature() {
     }
     _client.print((char) Resp_STK_INSYNC);
 
+    wait_ready();
     uint8_t high = spi_transaction(0x30, 0x00, 0x00, 0x00);
     _client.print((char) high);
     uint8_t middle = spi_transaction(0x30, 0x00, 0x01, 0x00);
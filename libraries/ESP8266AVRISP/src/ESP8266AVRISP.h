@@ -44,6 +44,15 @@ typedef struct {
     int flashsize;
 } AVRISP_parameter_t;
 
+// flash programming timings, reset when entering program mode
+typedef struct {
+    uint32_t pages;         // STK_PROG_PAGE flash commands served
+    uint32_t last_us;       // time from receiving the last one to the reply
+    uint32_t max_us;
+    uint32_t total_us;
+    uint32_t wait_us;       // spent waiting for the target to finish writing
+} AVRISP_stats_t;
+
 
 class ESP8266AVRISP {
 public:
@@ -67,6 +76,8 @@ public:
     // returns the updated state
     AVRISPState_t serve();
 
+    const AVRISP_stats_t& stats() const { return _stats; }
+
 protected:
 
     inline void _reject_incoming(void);     // reject any incoming tcp connections
@@ -87,6 +98,8 @@ protected:
     uint8_t write_eeprom(int length);
     uint8_t write_eeprom_chunk(int start, int length);
     void commit(int addr);
+    void start_busy(uint32_t ms);   // the target is writing for up to ms
+    void wait_ready();              // until the last write has completed
     void program_page();
     uint8_t flash_read(uint8_t hilo, int addr);
     bool flash_read_page(int length);
@@ -120,6 +133,12 @@ protected:
 
     // address for reading and writing, set by 'U' command
     int here;
+
+    // a page or EEPROM write may still be running on the target
+    bool _busy = false;
+    uint32_t _busy_start;
+    uint32_t _busy_ms;
+    AVRISP_stats_t _stats;
 };
 
 
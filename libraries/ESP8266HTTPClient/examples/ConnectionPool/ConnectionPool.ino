@@ -0,0 +1,65 @@
+/**
+   ConnectionPool.ino
+
+   Several HTTPClient instances share keep-alive connections through a
+   HTTPClientPool: a request to a host that was used before goes out on
+   the same connection, without a new TCP (or TLS) handshake.
+*/
+
+#include <ESP8266WiFi.h>
+#include <ESP8266WiFiMulti.h>
+#include <ESP8266HTTPClient.h>
+
+#ifndef STASSID
+#define STASSID "your-ssid"
+#define STAPSK  "your-password"
+#endif
+
+ESP8266WiFiMulti WiFiMulti;
+
+// keep up to 2 idle connections, for 20 seconds at most
+HTTPClientPool pool(2, 20000);
+
+void get(const char* url) {
+  HTTPClient http;
+  if (!http.begin(pool, url)) {
+    Serial.printf("[HTTP] cannot begin %s\n", url);
+    return;
+  }
+  uint32_t start = millis();
+  int httpCode = http.GET();
+  if (httpCode > 0) {
+    Serial.printf("[HTTP] %s: %d, %u bytes in %u ms\n", url, httpCode, http.getString().length(), (unsigned)(millis() - start));
+  } else {
+    Serial.printf("[HTTP] %s failed: %s\n", url, http.errorToString(httpCode).c_str());
+  }
+  http.end(); // the connection goes back to the pool
+}
+
+void setup() {
+
+  Serial.begin(115200);
+
+  Serial.println();
+  Serial.println();
+  Serial.println("Connecting to WiFi...");
+
+  WiFi.mode(WIFI_STA);
+  WiFiMulti.addAP(STASSID, STAPSK);
+
+  while ((WiFiMulti.run() != WL_CONNECTED)) {
+    Serial.write('.');
+    delay(500);
+  }
+  Serial.println(" connected to WiFi");
+}
+
+void loop() {
+  get("http://jigsaw.w3.org/HTTP/connection.html");
+  get("http://jigsaw.w3.org/HTTP/");
+  Serial.printf("%u idle connection(s) in the pool\n\n", (unsigned)pool.idle());
+
+  // close the connections the server would drop anyway
+  pool.evictIdle();
+  delay(5000);
+}
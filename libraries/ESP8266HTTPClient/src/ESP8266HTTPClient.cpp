@@ -41,6 +41,114 @@ static int StreamReportToHttpClientReport (Stream::Report streamSendError)
     return 0; // never reached, keep gcc quiet
 }
 
+/**
+ * connection pool
+ * @param maxIdle size_t            idle connections kept at most
+ * @param idleTimeout_ms uint32_t   close idle connections after that
+ */
+HTTPClientPool::HTTPClientPool(size_t maxIdle, uint32_t idleTimeout_ms)
+    : _maxIdle(maxIdle), _idleTimeout(idleTimeout_ms)
+{
+}
+
+HTTPClientPool::~HTTPClientPool()
+{
+    clear();
+}
+
+/**
+ * set how new clients are made, for instance a WiFiClientSecure with its
+ * trust anchors and session for https
+ * @param factory ClientFactory
+ */
+void HTTPClientPool::setClientFactory(ClientFactory factory)
+{
+    _factory = std::move(factory);
+}
+
+void HTTPClientPool::setIdleTimeout(uint32_t idleTimeout_ms)
+{
+    _idleTimeout = idleTimeout_ms;
+}
+
+void HTTPClientPool::setMaxIdle(size_t maxIdle)
+{
+    _maxIdle = maxIdle;
+    while (_idle.size() > _maxIdle) {
+        _idle.front().client->stop();
+        _idle.erase(_idle.begin());
+    }
+}
+
+/**
+ * get a client for host:port
+ * @return an idle connected client, a new client, or nullptr
+ */
+std::unique_ptr<WiFiClient> HTTPClientPool::checkOut(const String& host, uint16_t port, bool https)
+{
+    evictIdle();
+
+    // most recently used first, it is the least likely to be closed by the server
+    for (auto it = _idle.rbegin(); it != _idle.rend(); ++it) {
+        if (it->port == port && it->https == https && it->host.equalsIgnoreCase(host)) {
+            std::unique_ptr<WiFiClient> client = std::move(it->client);
+            _idle.erase(std::next(it).base());
+            if (client->connected()) {
+                DEBUG_HTTPCLIENT("[HTTP-Client][pool] reusing connection to %s:%u\n", host.c_str(), port);
+                return client;
+            }
+            break;
+        }
+    }
+
+    if (_factory) {
+        return std::unique_ptr<WiFiClient>(_factory(host, port, https));
+    }
+    if (https) {
+        DEBUG_HTTPCLIENT("[HTTP-Client][pool] no client factory for https\n");
+        return nullptr;
+    }
+    return std::unique_ptr<WiFiClient>(new (std::nothrow) WiFiClient);
+}
+
+/**
+ * give a client back to the pool
+ * the client is kept only when it is still connected
+ */
+void HTTPClientPool::checkIn(std::unique_ptr<WiFiClient> client, const String& host, uint16_t port, bool https)
+{
+    if (!client || !_maxIdle || !client->connected()) {
+        return;
+    }
+    if (_idle.size() >= _maxIdle) {
+        _idle.front().client->stop();
+        _idle.erase(_idle.begin());
+    }
+    _idle.push_back(Idle{host, port, https, (uint32_t)millis(), std::move(client)});
+}
+
+void HTTPClientPool::evictIdle()
+{
+    uint32_t now = millis();
+    for (auto it = _idle.begin(); it != _idle.end(); ) {
+        if (now - it->since > _idleTimeout || !it->client->connected()) {
+            DEBUG_HTTPCLIENT("[HTTP-Client][pool] closing idle connection to %s:%u\n", it->host.c_str(), it->port);
+            it->client->stop();
+            it = _idle.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void HTTPClientPool::clear()
+{
+    for (auto& idle : _idle) {
+        idle.client->stop();
+    }
+    _idle.clear();
+}
+
 /**
  * constructor
  */
@@ -54,7 +162,13 @@ HTTPClient::HTTPClient()
  */
 HTTPClient::~HTTPClient()
 {
-    if(_client) {
+    if(_pooledClient) {
+        // keep-alive connections go back to the pool
+        if(!(_reuse && _canReuse)) {
+            _pooledClient->stop();
+        }
+        releasePooled();
+    } else if(_client) {
         _client->stop();
     }
     if(_currentHeaders) {
@@ -80,6 +194,7 @@ void HTTPClient::clear()
  * @return success bool
  */
 bool HTTPClient::begin(WiFiClient &client, const String& url) {
+    releasePooled();
     _client = &client;
 
     // check for : (http: or https:)
@@ -111,6 +226,7 @@ bool HTTPClient::begin(WiFiClient &client, const String& url) {
  */
 bool HTTPClient::begin(WiFiClient &client, const String& host, uint16_t port, const String& uri, bool https)
 {
+    releasePooled();
     _client = &client;
 
      clear();
@@ -122,6 +238,61 @@ bool HTTPClient::begin(WiFiClient &client, const String& host, uint16_t port, co
 }
 
 
+/**
+ * take the connection from a pool
+ * @param pool HTTPClientPool&
+ * @param url String
+ * @return success bool
+ */
+bool HTTPClient::begin(HTTPClientPool &pool, const String& url)
+{
+    releasePooled();
+    _client = nullptr;
+    if(!beginInternal(url, nullptr)) {
+        return false;
+    }
+    return beginPooled(pool);
+}
+
+bool HTTPClient::begin(HTTPClientPool &pool, const String& host, uint16_t port, const String& uri, bool https)
+{
+    releasePooled();
+    clear();
+    _host = host;
+    _port = port;
+    _uri = uri;
+    _protocol = (https ? "https" : "http");
+    return beginPooled(pool);
+}
+
+bool HTTPClient::beginPooled(HTTPClientPool &pool)
+{
+    _pooledClient = pool.checkOut(_host, _port, _protocol == "https");
+    if(!_pooledClient) {
+        DEBUG_HTTPCLIENT("[HTTP-Client][begin] no client for %s:%u\n", _host.c_str(), _port);
+        return false;
+    }
+    _pool = &pool;
+    _client = _pooledClient.get();
+    // a connection from the pool was already found reusable
+    _canReuse = _client->connected();
+    return true;
+}
+
+/**
+ * give the pooled client back, the pool keeps it if it is still open
+ */
+void HTTPClient::releasePooled()
+{
+    if(_pooledClient) {
+        if(_client == _pooledClient.get()) {
+            _client = nullptr;
+        }
+        _pool->checkIn(std::move(_pooledClient), _host, _port, _protocol == "https");
+    }
+    _pool = nullptr;
+}
+
 bool HTTPClient::beginInternal(const String& __url, const char* expectedProtocol)
 {
     String url(__url);
@@ -199,8 +370,10 @@ void HTTPClient::end(void)
  */
 void HTTPClient::disconnect(bool preserveClient)
 {
+
     if(connected()) {
-        if(_client->available() > 0) {
+        // with pipelining, what follows is the next response
+        if(_client->available() > 0 && !_pipelining) {
             DEBUG_HTTPCLIENT("[HTTP-Client][end] still data in buffer (%d), clean up.\n", _client->available());
             while(_client->available() > 0) {
                 _client->read();
@@ -225,6 +398,11 @@ void HTTPClient::disconnect(bool preserveClient)
 
         DEBUG_HTTPCLIENT("[HTTP-Client][end] tcp is closed\n");
     }
+
+    if(!preserveClient) {
+        // back to the pool, which keeps it only if it was left open
+        releasePooled();
+    }
 }
 
 /**
@@ -555,6 +733,80 @@ int HTTPClient::sendRequest(const char * type, Stream * stream, size_t size)
     return returnError(handleHeaderResponse());
 }
 
+/**
+ * sendRequests
+ * @param requests const PipelinedRequest*  type, payload and size of each request
+ * @param count size_t                      number of requests
+ * @param cb PipelineCallback               called for each response, in order
+ * @return number of responses, or < 0 on error
+ */
+int HTTPClient::sendRequests(const PipelinedRequest* requests, size_t count, PipelineCallback cb)
+{
+    if(!requests || !count) {
+        return 0;
+    }
+    if(_useHTTP10 || !_reuse) {
+        // pipelining needs a persistent HTTP/1.1 connection
+        DEBUG_HTTPCLIENT("[HTTP-Client][sendRequests] needs HTTP/1.1 and reuse\n");
+        return returnError(HTTPC_ERROR_NOT_CONNECTED);
+    }
+
+    for(size_t i = 0; i < _headerKeysCount; i++) {
+        _currentHeaders[i].value.clear();
+    }
+
+    if(!connect()) {
+        return returnError(HTTPC_ERROR_CONNECTION_FAILED);
+    }
+
+    // sendHeader() sends _headers, handleHeaderResponse() clears it
+    String headers = _headers;
+    for(size_t i = 0; i < count; i++) {
+        const PipelinedRequest& req = requests[i];
+        _headers = headers;
+        addHeader(F("Content-Length"), String(req.payload && req.size > 0 ? req.size : 0));
+        if(!sendHeader(req.type)) {
+            return returnError(HTTPC_ERROR_SEND_HEADER_FAILED);
+        }
+        if(req.payload && req.size && StreamConstPtr(req.payload, req.size).sendAll(_client) != req.size) {
+            return returnError(HTTPC_ERROR_SEND_PAYLOAD_FAILED);
+        }
+    }
+    DEBUG_HTTPCLIENT("[HTTP-Client][sendRequests] %u requests sent\n", (unsigned)count);
+
+    _pipelining = true;
+    size_t done = 0;
+    for(; done < count; done++) {
+        int code = handleHeaderResponse();
+        if(code < 0) {
+            break;
+        }
+        bool noBody = !strcmp(requests[done].type, "HEAD") || code < 200 ||
+                      code == HTTP_CODE_NO_CONTENT || code == HTTP_CODE_NOT_MODIFIED;
+        if(noBody) {
+            _payload.reset(new StreamString());
+        } else {
+            getString();
+        }
+        if(cb) {
+            cb(done, code);
+        }
+        if(!_canReuse) {
+            // the server closes after this one
+            done++;
+            break;
+        }
+    }
+    _pipelining = false;
+
+    if(done < count) {
+        DEBUG_HTTPCLIENT("[HTTP-Client][sendRequests] %u of %u responses\n", (unsigned)done, (unsigned)count);
+        _canReuse = false;
+        disconnect(true);
+    }
+    return done;
+}
+
 /**
  * size of message body / payload
  * @return -1 if no info or > 0 when Content-Length is set by server
@@ -633,61 +885,183 @@ int HTTPClient::writeToStream(Stream * stream)
             return returnError(StreamReportToHttpClientReport(_client->getLastSendReport()));
         }
     } else if(_transferEncoding == HTTPC_TE_CHUNKED) {
-        int size = 0;
-        while(1) {
+        bool written = true;
+        ret = readBody([stream, &written](const uint8_t* data, size_t size) {
+            written = stream->write(data, size) == size;
+            return written;
+        });
+        if(!written) {
+            return returnError(HTTPC_ERROR_STREAM_WRITE);
+        }
+        return ret;
+    } else {
+        return returnError(HTTPC_ERROR_ENCODING);
+    }
+
+    disconnect(true);
+    return ret;
+}
+
+/**
+ * hand the payload over to cb, slice by slice, without chunked framing
+ * @param cb BodyCallback
+ * @return size of the payload, or an error (< 0)
+ */
+int HTTPClient::readBody(BodyCallback cb)
+{
+    if(!cb) {
+        return returnError(HTTPC_ERROR_NO_STREAM);
+    }
+    if(!_client) {
+        return returnError(HTTPC_ERROR_NOT_CONNECTED);
+    }
+    if(_transferEncoding != HTTPC_TE_IDENTITY && _transferEncoding != HTTPC_TE_CHUNKED) {
+        return returnError(HTTPC_ERROR_ENCODING);
+    }
+
+    enum {
+        CHUNK_SIZE,     // hex digits
+        CHUNK_EXT,      // ";ext" up to the end of the line
+        CHUNK_DATA,
+        CHUNK_CRLF,     // after the data
+        TRAILER,        // header lines after the last chunk
+        BODY_DONE
+    } state;
+
+    const bool chunked = _transferEncoding == HTTPC_TE_CHUNKED;
+    const bool peekAPI = _client->hasPeekBufferAPI();
+    // bytes left in this chunk, or in the body (-1: until closed)
+    int left = chunked ? 0 : _size;
+    uint32_t chunkSize = 0;
+    int digits = 0;
+    size_t lineLen = 0;
+    int total = 0;
+    uint8_t buf[128];   // without peek buffer API
+    unsigned long lastDataTime = millis();
+
+    state = (chunked ? CHUNK_SIZE : (left == 0 ? BODY_DONE : CHUNK_DATA));
+    while(state != BODY_DONE) {
+        size_t avail = peekAPI ? _client->peekAvailable() : (size_t)std::max(_client->available(), 0);
+        if(!avail) {
             if(!connected()) {
+                if(!chunked && left < 0) {
+                    // no Content-Length, the body ends with the connection
+                    break;
+                }
                 return returnError(HTTPC_ERROR_CONNECTION_LOST);
             }
-            String chunkHeader = _client->readStringUntil('\n');
-
-            if(chunkHeader.length() <= 0) {
+            if((millis() - lastDataTime) > _tcpTimeout) {
                 return returnError(HTTPC_ERROR_READ_TIMEOUT);
             }
+            delay(0);
+            continue;
+        }
+        lastDataTime = millis();
+
+        const uint8_t* data;
+        if(peekAPI) {
+            data = (const uint8_t*)_client->peekBuffer();
+        } else {
+            // framing is read byte by byte, to leave what follows the body
+            size_t want = (state == CHUNK_DATA) ? sizeof(buf) : 1;
+            if(state == CHUNK_DATA && left >= 0) {
+                want = std::min(want, (size_t)left);
+            }
+            int got = _client->read(buf, std::min(avail, want));
+            if(got <= 0) {
+                continue;
+            }
+            avail = got;
+            data = buf;
+        }
 
-            chunkHeader.trim(); // remove \r
-
-            // read size of chunk
-            len = (uint32_t) strtol((const char *) chunkHeader.c_str(), NULL, 16);
-            size += len;
-            DEBUG_HTTPCLIENT("[HTTP-Client] read chunk len: %d\n", len);
-
-            // data left?
-            if(len > 0) {
-                // read len bytes with timeout
-                int r = _client->sendSize(stream, len);
-                if (_client->getLastSendReport() != Stream::Report::Success)
-                    // not all data transferred
-                    return returnError(StreamReportToHttpClientReport(_client->getLastSendReport()));
-                ret += r;
-            } else {
-
-                // if no length Header use global chunk size
-                if(_size <= 0) {
-                    _size = size;
+        size_t used = 0;
+        while(used < avail && state != BODY_DONE) {
+            if(state == CHUNK_DATA) {
+                size_t n = avail - used;
+                if(left >= 0) {
+                    n = std::min(n, (size_t)left);
+                    left -= n;
                 }
-
-                // check if we have write all data out
-                if(ret != _size) {
-                    return returnError(HTTPC_ERROR_STREAM_WRITE);
+                bool more = cb(data + used, n);
+                used += n;
+                total += n;
+                if(!more) {
+                    if(peekAPI) {
+                        _client->peekConsume(used);
+                    }
+                    _canReuse = false;
+                    return total;
                 }
-                break;
+                if(left == 0) {
+                    state = chunked ? CHUNK_CRLF : BODY_DONE;
+                }
+                continue;
             }
 
-            // read trailing \r\n at the end of the chunk
-            char buf[2];
-            auto trailing_seq_len = _client->readBytes((uint8_t*)buf, 2);
-            if (trailing_seq_len != 2 || buf[0] != '\r' || buf[1] != '\n') {
-                return returnError(HTTPC_ERROR_READ_TIMEOUT);
+            uint8_t c = data[used++];
+            switch(state) {
+            case CHUNK_SIZE:
+                if(isxdigit(c) && digits < 8) {
+                    chunkSize = (chunkSize << 4) | (uint32_t)(isdigit(c) ? c - '0' : (c | 0x20) - 'a' + 10);
+                    digits++;
+                } else if(digits && (c == ';' || c == ' ' || c == '\t' || c == '\r')) {
+                    state = CHUNK_EXT;
+                } else if(digits && c == '\n') {
+                    // bare LF, let CHUNK_EXT end the line
+                    state = CHUNK_EXT;
+                    used--;
+                } else {
+                    return returnError(HTTPC_ERROR_ENCODING);
+                }
+                break;
+            case CHUNK_EXT:
+                if(c == '\n') {
+                    DEBUG_HTTPCLIENT("[HTTP-Client] read chunk len: %u\n", chunkSize);
+                    if(chunkSize > (uint32_t)INT_MAX - total) {
+                        return returnError(HTTPC_ERROR_ENCODING);
+                    }
+                    left = chunkSize;
+                    state = chunkSize ? CHUNK_DATA : TRAILER;
+                    lineLen = 0;
+                }
+                break;
+            case CHUNK_CRLF:
+                if(c == '\n') {
+                    chunkSize = 0;
+                    digits = 0;
+                    state = CHUNK_SIZE;
+                } else if(c != '\r') {
+                    return returnError(HTTPC_ERROR_ENCODING);
+                }
+                break;
+            case TRAILER:
+                if(c == '\n') {
+                    if(!lineLen) {
+                        state = BODY_DONE;
+                    }
+                    lineLen = 0;
+                } else if(c != '\r') {
+                    lineLen++;
+                }
+                break;
+            default:
+                break;
             }
-
-            delay(0);
         }
-    } else {
-        return returnError(HTTPC_ERROR_ENCODING);
+        if(peekAPI) {
+            _client->peekConsume(used);
+        }
+        delay(0);
+    }
+
+    // if no length header, use the size of the chunks
+    if(_size <= 0) {
+        _size = total;
     }
 
     disconnect(true);
-    return ret;
+    return total;
 }
 
 /**
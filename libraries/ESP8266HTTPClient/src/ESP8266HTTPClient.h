@@ -27,6 +27,8 @@
 #define ESP8266HTTPClient_H_
 
 #include <memory>
+#include <vector>
+#include <functional>
 #include <Arduino.h>
 #include <StreamString.h>
 #include <WiFiClient.h>
@@ -148,6 +150,55 @@ typedef enum {
 class TransportTraits;
 typedef std::unique_ptr<TransportTraits> TransportTraitsPtr;
 
+/**
+ * Keep-alive connections shared by several HTTPClient instances.
+ * HTTPClient::begin(pool, url) checks out an idle connection to the same
+ * host, port and scheme, or a new client from the factory, and end() checks
+ * it back in when the server allowed to keep it open. Idle connections are
+ * closed after the idle timeout, or when more than maxIdle are kept.
+ * The default factory only makes plain WiFiClients: https needs a factory
+ * returning a configured WiFiClientSecure.
+ */
+class HTTPClientPool
+{
+public:
+    using ClientFactory = std::function<WiFiClient*(const String& host, uint16_t port, bool https)>;
+
+    HTTPClientPool(size_t maxIdle = 4, uint32_t idleTimeout_ms = 30000);
+    ~HTTPClientPool();
+
+    HTTPClientPool(const HTTPClientPool&) = delete;
+    HTTPClientPool& operator=(const HTTPClientPool&) = delete;
+
+    void setClientFactory(ClientFactory factory);
+    void setIdleTimeout(uint32_t idleTimeout_ms);
+    void setMaxIdle(size_t maxIdle);
+
+    // idle connection to host:port, or a new (unconnected) client
+    std::unique_ptr<WiFiClient> checkOut(const String& host, uint16_t port, bool https);
+    // keep client for later if it is still connected
+    void checkIn(std::unique_ptr<WiFiClient> client, const String& host, uint16_t port, bool https);
+
+    // close connections idle for longer than the idle timeout
+    void evictIdle();
+    void clear();
+    size_t idle() const { return _idle.size(); }
+
+protected:
+    struct Idle {
+        String host;
+        uint16_t port;
+        bool https;
+        uint32_t since;
+        std::unique_ptr<WiFiClient> client;
+    };
+
+    ClientFactory _factory;
+    size_t _maxIdle;
+    uint32_t _idleTimeout;
+    std::vector<Idle> _idle;    // oldest first
+};
+
 class HTTPClient
 {
 public:
@@ -161,6 +212,13 @@ public:
     bool begin(WiFiClient &client, const String& url);
     bool begin(WiFiClient &client, const String& host, uint16_t port, const String& uri = "/", bool https = false);
 
+/*
+ * Take the connection from pool, which must outlive the HTTPClient.
+ * end() gives it back.
+ */
+    bool begin(HTTPClientPool &pool, const String& url);
+    bool begin(HTTPClientPool &pool, const String& host, uint16_t port, const String& uri = "/", bool https = false);
+
     // old API is now explicitly forbidden
     bool begin(String url)  __attribute__ ((error("obsolete API, use ::begin(WiFiClient, url)")));
     bool begin(String host, uint16_t port, String uri = "/")  __attribute__ ((error("obsolete API, use ::begin(WiFiClient, host, port, uri)")));
@@ -197,6 +255,20 @@ public:
     int sendRequest(const char* type, const uint8_t* payload = NULL, size_t size = 0);
     int sendRequest(const char* type, Stream * stream, size_t size = 0);
 
+    // HTTP/1.1 pipelining: all requests go out back to back on one
+    // connection, to the current URL, then the responses are read in order.
+    // For each one cb(index, code) can use getString() (the body is already
+    // read, keep responses small), header(), getSize()... Returns the number
+    // of responses, fewer than count when the server closed the connection,
+    // or an HTTPC_ERROR_* code when nothing could be sent.
+    struct PipelinedRequest {
+        const char* type;
+        const uint8_t* payload;
+        size_t size;
+    };
+    using PipelineCallback = std::function<void(size_t index, int code)>;
+    int sendRequests(const PipelinedRequest* requests, size_t count, PipelineCallback cb);
+
     void addHeader(const String& name, const String& value, bool first = false, bool replace = true);
 
     /// Response handling
@@ -214,6 +286,13 @@ public:
     WiFiClient& getStream(void);
     WiFiClient* getStreamPtr(void);
     int writeToStream(Stream* stream);
+
+    // Pass the response body to cb in contiguous slices, straight from the
+    // client's receive buffer when it has the peek buffer API, with chunked
+    // framing already skipped. cb returns false to stop (the connection is
+    // then not reused). Returns the body size or an HTTPC_ERROR_* code.
+    using BodyCallback = std::function<bool(const uint8_t* data, size_t len)>;
+    int readBody(BodyCallback cb);
     const String& getString(void);
     static String errorToString(int error);
 
@@ -231,13 +310,18 @@ protected:
     bool sendHeader(const char * type);
     int handleHeaderResponse();
     int writeToStreamDataBlock(Stream * stream, int len);
+    bool beginPooled(HTTPClientPool &pool);
+    void releasePooled();
 
     WiFiClient* _client;
+    HTTPClientPool* _pool = nullptr;
+    std::unique_ptr<WiFiClient> _pooledClient;
 
     /// request handling
     String _host;
     uint16_t _port = 0;
     bool _reuse = true;
+    bool _pipelining = false;
     uint16_t _tcpTimeout = HTTPCLIENT_DEFAULT_TCP_TIMEOUT;
     bool _useHTTP10 = false;
 
@@ -61,17 +61,19 @@ extern "C" {
 #define FLAGS_RCODE_SHIFT       0
 #define FLAGS_RCODE_MASK        0xf
 
-#define _conn_read16() (((uint16_t)_conn->read() << 8) | _conn->read())
-#define _conn_read8() _conn->read()
-#define _conn_readS(b, l) _conn->read((b), (l));
-
 // llmnr ipv6 is FF02:0:0:0:0:0:1:3
 // lwip-v2's igmp_joingroup only supports IPv4
 #define LLMNR_MULTICAST_ADDR 224, 0, 0, 252
 static const int LLMNR_MULTICAST_TTL = 1;
 static const int LLMNR_PORT = 5355;
 
+// Offsets in the reply (and query): header, then the question's name
+#define LLMNR_HEADER_LEN        12
+#define LLMNR_QTYPE_QCLASS_LEN  4
+#define LLMNR_RR_LEN            (LLMNR_QTYPE_QCLASS_LEN + 4 + 2 + 4) // TYPE, CLASS, TTL, RDLENGTH, RDATA
+
 LLMNRResponder::LLMNRResponder() :
+    _name_len(0),
     _conn(0) {
 }
 
@@ -82,11 +84,51 @@ LLMNRResponder::~LLMNRResponder() {
 
 bool LLMNRResponder::begin(const char* hostname) {
     // Max length for a single label in DNS
-    if (strlen(hostname) > 63)
+    size_t len = strlen(hostname);
+    if (len > 63)
+        return false;
+
+    _name_len = len + 2;
+    size_t question_len = _name_len + LLMNR_QTYPE_QCLASS_LEN;
+    _reply.reset(new (std::nothrow) uint8_t[LLMNR_HEADER_LEN + question_len + _name_len + LLMNR_RR_LEN]);
+    if (!_reply)
         return false;
 
-    _hostname = hostname;
-    _hostname.toLowerCase();
+    uint8_t* p = _reply.get();
+    // Header
+    const uint8_t header[] = {
+        0, 0, // ID
+        (uint8_t)(FLAGS_QR >> 8), 0, // FLAGS
+        0, 1, // QDCOUNT
+        0, 0, // ANCOUNT
+        0, 0, // NSCOUNT
+        0, 0, // ARCOUNT
+    };
+    memcpy(p, header, sizeof(header));
+    p += sizeof(header);
+    // Question
+    uint8_t* name = p;
+    *p++ = len;
+    for (size_t i = 0; i < len; i++)
+        *p++ = tolower(hostname[i]);
+    *p++ = 0; // Name terminator
+    const uint8_t q[] = {
+        0, 1, // TYPE (A)
+        0, 1, // CLASS (IN)
+    };
+    memcpy(p, q, sizeof(q));
+    p += sizeof(q);
+    // Answer
+    memcpy(p, name, _name_len);
+    p += _name_len;
+    const uint8_t rr[] = {
+        0, 1, // TYPE (A)
+        0, 1, // CLASS (IN)
+        0, 0, 0, 30, // TTL (30 seconds)
+        0, 4, // RDLENGTH
+        0, 0, 0, 0, // RDATA
+    };
+    memcpy(p, rr, sizeof(rr));
 
     _sta_got_ip_handler = WiFi.onStationModeGotIP([this](const WiFiEventStationModeGotIP& event){
         (void) event;
@@ -136,26 +178,30 @@ void LLMNRResponder::_process_packet() {
     Serial.println("LLMNR: RX'd packet");
 #endif
 
-    uint16_t id = _conn_read16();
-    uint16_t flags = _conn_read16();
-    uint16_t qdcount = _conn_read16();
-    uint16_t ancount = _conn_read16();
-    uint16_t nscount = _conn_read16();
-    uint16_t arcount = _conn_read16();
+    // Header and question, read in one go unless the packet spans pbufs
+    size_t question_len = _name_len + LLMNR_QTYPE_QCLASS_LEN;
+    size_t len = LLMNR_HEADER_LEN + question_len;
+    if (_conn->getSize() < len) {
+#ifdef LLMNR_DEBUG
+        Serial.println("LLMNR: short packet or QNAME len mismatch");
+#endif
+        return;
+    }
+    uint8_t copy[LLMNR_HEADER_LEN + 63 + 2 + LLMNR_QTYPE_QCLASS_LEN];
+    const uint8_t* query = reinterpret_cast<const uint8_t*>(_conn->peekBuffer());
+    if (!query) {
+        _conn->read(reinterpret_cast<char*>(copy), len);
+        query = copy;
+    }
+
+    uint16_t flags = (query[2] << 8) | query[3];
+    uint16_t qdcount = (query[4] << 8) | query[5];
 
 #ifdef LLMNR_DEBUG
-    Serial.print("LLMNR: ID=");
-    Serial.println(id, HEX);
     Serial.print("LLMNR: FLAGS=");
     Serial.println(flags, HEX);
     Serial.print("LLMNR: QDCOUNT=");
     Serial.println(qdcount);
-    Serial.print("LLMNR: ANCOUNT=");
-    Serial.println(ancount);
-    Serial.print("LLMNR: NSCOUNT=");
-    Serial.println(nscount);
-    Serial.print("LLMNR: ARCOUNT=");
-    Serial.println(arcount);
 #endif
 
 #define BAD_FLAGS (FLAGS_QR | (FLAGS_OP_MASK << FLAGS_OP_SHIFT) | FLAGS_C)
@@ -173,54 +219,31 @@ void LLMNRResponder::_process_packet() {
         return;
     }
 
-    if (ancount || nscount || arcount) {
+    // ANCOUNT, NSCOUNT, ARCOUNT
+    if (query[6] | query[7] | query[8] | query[9] | query[10] | query[11]) {
 #ifdef LLMNR_DEBUG
         Serial.println("AN/NS/AR-COUNT != 0");
 #endif
         return;
     }
 
-    uint8_t namelen = _conn_read8();
-#ifdef LLMNR_DEBUG
-    Serial.print("QNAME len ");
-    Serial.println(namelen);
-#endif
-    if (namelen != _hostname.length()) {
-#ifdef LLMNR_DEBUG
-        Serial.println("QNAME len mismatch");
-#endif
-        return;
-    }
-
-    char qname[64];
-    _conn_readS(qname, namelen);
-    _conn_read8();
-    qname[namelen] = '\0';
-#ifdef LLMNR_DEBUG
-    Serial.print("QNAME ");
-    Serial.println(qname);
-#endif
-
-    if (strcmp(_hostname.c_str(), qname)) {
+    // QNAME, against the one encoded by begin()
+    if (memcmp(query + LLMNR_HEADER_LEN, _reply.get() + LLMNR_HEADER_LEN, _name_len)) {
 #ifdef LLMNR_DEBUG
         Serial.println("QNAME mismatch");
 #endif
         return;
     }
 
-    uint16_t qtype = _conn_read16();
-    uint16_t qclass = _conn_read16();
-
-#ifdef LLMNR_DEBUG
-    Serial.print("QTYPE ");
-    Serial.print(qtype);
-    Serial.print(" QCLASS ");
-    Serial.println(qclass);
-#endif
-
+    const uint8_t* qtype_qclass = query + LLMNR_HEADER_LEN + _name_len;
     bool have_rr =
-        (qtype == 1) && /* A */
-        (qclass == 1); /* IN */
+        (qtype_qclass[0] == 0) && (qtype_qclass[1] == 1) && /* A */
+        (qtype_qclass[2] == 0) && (qtype_qclass[3] == 1); /* IN */
+
+    uint8_t* reply = _reply.get();
+    reply[0] = query[0]; // ID
+    reply[1] = query[1];
+    reply[7] = have_rr; // ANCOUNT
 
     _conn->flush();
 
@@ -232,52 +255,24 @@ void LLMNRResponder::_process_packet() {
 
     IPAddress remote_ip = _conn->getRemoteAddress();
 
-    struct ip_info ip_info;
-    bool match_ap = false;
-    if (wifi_get_opmode() & SOFTAP_MODE) {
-        wifi_get_ip_info(SOFTAP_IF, &ip_info);
-        IPAddress infoIp(ip_info.ip);
-        IPAddress infoMask(ip_info.netmask);
-        if (ip_info.ip.addr && ip_addr_netcmp((const ip_addr_t*)remote_ip, (const ip_addr_t*)infoIp, ip_2_ip4((const ip_addr_t*)infoMask)))
-            match_ap = true;
-    }
-    if (!match_ap)
-        wifi_get_ip_info(STATION_IF, &ip_info);
-    uint32_t ip = ip_info.ip.addr;
-
-    // Header
-    uint8_t header[] = {
-        (uint8_t)(id >> 8), (uint8_t)(id & 0xff), // ID
-        (uint8_t)(FLAGS_QR >> 8), 0, // FLAGS
-        0, 1, // QDCOUNT
-        0, !!have_rr, // ANCOUNT
-        0, 0, // NSCOUNT
-        0, 0, // ARCOUNT
-    };
-    _conn->append(reinterpret_cast<const char*>(header), sizeof(header));
-    // Question
-    _conn->append(reinterpret_cast<const char*>(&namelen), 1);
-    _conn->append(qname, namelen);
-    uint8_t q[] = {
-        0, // Name terminator
-        0, 1, // TYPE (A)
-        0, 1, // CLASS (IN)
-    };
-    _conn->append(reinterpret_cast<const char*>(q), sizeof(q));
-    // Answer, if we have one
     if (have_rr) {
-        _conn->append(reinterpret_cast<const char*>(&namelen), 1);
-        _conn->append(qname, namelen);
-        uint8_t rr[] = {
-            0, // Name terminator
-            0, 1, // TYPE (A)
-            0, 1, // CLASS (IN)
-            0, 0, 0, 30, // TTL (30 seconds)
-            0, 4, // RDLENGTH
-            (uint8_t)(ip & 0xff), (uint8_t)((ip >> 8) & 0xff), (uint8_t)((ip >> 16) & 0xff), (uint8_t)((ip >> 24) & 0xff) // RDATA
-        };
-        _conn->append(reinterpret_cast<const char*>(rr), sizeof(rr));
+        struct ip_info ip_info;
+        bool match_ap = false;
+        if (wifi_get_opmode() & SOFTAP_MODE) {
+            wifi_get_ip_info(SOFTAP_IF, &ip_info);
+            IPAddress infoIp(ip_info.ip);
+            IPAddress infoMask(ip_info.netmask);
+            if (ip_info.ip.addr && ip_addr_netcmp((const ip_addr_t*)remote_ip, (const ip_addr_t*)infoIp, ip_2_ip4((const ip_addr_t*)infoMask)))
+                match_ap = true;
+        }
+        if (!match_ap)
+            wifi_get_ip_info(STATION_IF, &ip_info);
+        // RDATA, in network order already
+        memcpy(reply + len + _name_len + LLMNR_RR_LEN - 4, &ip_info.ip.addr, 4);
+        len += _name_len + LLMNR_RR_LEN;
     }
+
+    _conn->append(reinterpret_cast<const char*>(reply), len);
     _conn->setMulticastInterface(remote_ip);
     _conn->send(remote_ip, _conn->getRemotePort());
 }
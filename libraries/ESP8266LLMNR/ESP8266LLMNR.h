@@ -35,6 +35,7 @@
 #define ESP8266LLMNR_H
 
 #include <ESP8266WiFi.h>
+#include <memory>
 
 class UdpContext;
 
@@ -50,7 +51,10 @@ public:
     void notify_ap_change();
 
 private:
-    String _hostname;
+    // The whole reply, built by begin(): header, question and A record for
+    // the hostname. Per query, only ID, ANCOUNT and the address are set.
+    std::unique_ptr<uint8_t[]> _reply;
+    size_t _name_len; // encoded: length, label, terminator
     UdpContext *_conn;
     WiFiEventHandler _sta_got_ip_handler;
     WiFiEventHandler _sta_disconnected_handler;
@@ -4,6 +4,7 @@
 #include "ESP8266NetBIOS.h"
 
 #include <functional>
+#include <algorithm>
 
 extern "C" {
 #include "osapi.h"
@@ -79,27 +80,11 @@ struct NBNSANSWERN {
     uint16_t NBNSAN_NFLAGS; // node flags
 } __attribute__((packed));
 
-/** Metoda pro ziskani jmena z kodovani NETBIOS.
- *	\param nbname Ukazatel na jmeno v NETBIOS kodovani.
- *	\param name Ukazatel na misto, kam prevadime jmeno.
- *	\param maxlen Maximalni pocet znaku v nbname.
- */
-void ESP8266NetBIOS::_getnbname(char *nbname, char *name, uint8_t maxlen)
-{
-    uint8_t b;
-    uint8_t c = 0;
-
-    while ((*nbname != 0x0) && (c < maxlen)) {
-        b = (*nbname++ - 'A') << 4; // opravime nibble a prevedeme ho do vyssich bitu
-        c++; // pocitame pocet odebranych bytu
-        if (*nbname != 0x0) {
-            b |= *nbname++ - 'A'; // pridame nizsi nibble
-            c++; // opet spocitame pocet odebranych znaku
-        }
-        *name++ = b; // ulozime znak do vysledku a posuneme ukazatel
-    }
-    *name = 0x0; // ulozime ukoncovaci 0
-}
+// Jmeno "*" v NETBIOS kodovani (doplnene nulami), dotaz na stav uzlu
+static const char NBNS_WILDCARD[32] = {
+    'C', 'K', 'A', 'A', 'A', 'A', 'A', 'A', 'A', 'A', 'A', 'A', 'A', 'A', 'A', 'A',
+    'A', 'A', 'A', 'A', 'A', 'A', 'A', 'A', 'A', 'A', 'A', 'A', 'A', 'A', 'A', 'A',
+};
 
 /** Prevod zadaneho textu do NETBIOS kodovani
  *	\param name Ukazatel na prevadene jmeno.
@@ -151,6 +136,47 @@ bool ESP8266NetBIOS::begin(const char *name)
     }
     _name[n] = '\0';
 
+    // odpovedi sestavime predem, pri dotazu se doplni jen ID a adresa
+    static_assert(sizeof(NBNSANSWER) == sizeof(_answer), "NBNSANSWER size");
+    static_assert(sizeof(NBNSANSWERN) == sizeof(_answern), "NBNSANSWERN size");
+    struct NBNSANSWER *nbnsa = (struct NBNSANSWER *)_answer;
+    nbnsa->NBNSA_ID = 0;
+    nbnsa->NBNSA_FLAGS1 = 0x85;	// priznak odpovedi
+    nbnsa->NBNSA_FLAGS2 = 0; // vlajky 2 a response code
+    nbnsa->NBNSA_QUESTIONCOUNT = LWIP_PLATFORM_HTONS(0);
+    nbnsa->NBNSA_ANSWERCOUNT = LWIP_PLATFORM_HTONS(1);// poradove cislo odpovedi
+    nbnsa->NBNSA_AUTHORITYCOUNT = LWIP_PLATFORM_HTONS(0);
+    nbnsa->NBNSA_ADDITIONALRECORDCOUNT = LWIP_PLATFORM_HTONS(0);
+    nbnsa->NBNSA_NAMESIZE = sizeof(nbnsa->NBNSA_NAME) - 1; // prekopirujeme delku jmena stanice
+    _makenbname(_name, &nbnsa->NBNSA_NAME[0], sizeof(nbnsa->NBNSA_NAME) - 1); // prevedeme jmeno
+    nbnsa->NBNSA_TYPE = LWIP_PLATFORM_HTONS(0x20); // NetBIOS name
+    nbnsa->NBNSA_CLASS = LWIP_PLATFORM_HTONS(1); // Internet name
+    nbnsa->NBNSA_TIMETOLIVE = LWIP_PLATFORM_HTONL(300000UL);// Time to live (30000 sekund)
+    nbnsa->NBNSA_LENGTH = LWIP_PLATFORM_HTONS(6);
+    nbnsa->NBNSA_NODEFLAGS = LWIP_PLATFORM_HTONS(0);
+    nbnsa->NBNSA_NODEADDRESS = 0;
+
+    struct NBNSANSWERN *nbnsan = (struct NBNSANSWERN *)_answern;
+    nbnsan->NBNSAN_ID = 0;
+    nbnsan->NBNSAN_FLAGS1 = 0x84;	// priznak odpovedi
+    nbnsan->NBNSAN_FLAGS2 = 0; // vlajky 2 a response code
+    nbnsan->NBNSAN_QUESTIONCOUNT = LWIP_PLATFORM_HTONS(0);
+    nbnsan->NBNSAN_ANSWERCOUNT = LWIP_PLATFORM_HTONS(1);// poradove cislo odpovedi
+    nbnsan->NBNSAN_AUTHORITYCOUNT = LWIP_PLATFORM_HTONS(0);
+    nbnsan->NBNSAN_ADDITIONALRECORDCOUNT = LWIP_PLATFORM_HTONS(0);
+    nbnsan->NBNSAN_NAMESIZE = sizeof(NBNS_WILDCARD); // dotazovane jmeno je vzdy "*"
+    memcpy(nbnsan->NBNSAN_NAME, NBNS_WILDCARD, sizeof(NBNS_WILDCARD));
+    nbnsan->NBNSAN_NAME[sizeof(NBNS_WILDCARD)] = 0;
+    nbnsan->NBNSAN_TYPE = LWIP_PLATFORM_HTONS(0x21); // NBSTAT
+    nbnsan->NBNSAN_CLASS = LWIP_PLATFORM_HTONS(1); // Internet name
+    nbnsan->NBNSAN_TIMETOLIVE = LWIP_PLATFORM_HTONL(0);
+    nbnsan->NBNSAN_LENGTH = LWIP_PLATFORM_HTONS(4 + sizeof(nbnsan->NBNSAN_NNAME));
+    nbnsan->NBNSAN_NUMBER = 1; // Number of names
+    memset(nbnsan->NBNSAN_NNAME, 0x20, sizeof(nbnsan->NBNSAN_NNAME));
+    memcpy(nbnsan->NBNSAN_NNAME, _name, std::min(n, sizeof(nbnsan->NBNSAN_NNAME)));
+    nbnsan->NBNSAN_NTYPE = 0; // Workstation/Redirector
+    nbnsan->NBNSAN_NFLAGS = LWIP_PLATFORM_HTONS(0x400); // b-node, unique, active
+
     if(_pcb != NULL) {
         return true;
     }
@@ -185,72 +211,19 @@ void ESP8266NetBIOS::_recv(udp_pcb *upcb, pbuf *pb, const ip_addr_t *addr, uint1
 
         if (len >= sizeof(struct NBNSQUESTION)) {
             struct NBNSQUESTION * question = (struct NBNSQUESTION *)data;
-            if (0 == (question->NBNSQ_FLAGS1 & 0x80)) {
-                char name[ NBNS_MAX_HOSTNAME_LEN + 1 ]; // dekodovane dotazovane jmeno
-                char *str; // pomocna promenna, pouze pro praci s retezcem
-
-                _getnbname(&question->NBNSQ_NAME[0], (char *)&name, question->NBNSQ_NAMESIZE); // prevedeme dotazovane jmeno
-                if ((str = strchr(name, ' ')) != NULL) { // jmeno hledaneho zarizeni v tomto pripade ukoncuje i mezera
-                    *str = '\0';    // ukoncime retezec na vyskytu prvni mezery
-                }
-
-                if (0 == strcmp(name, _name)) {
+            if ((0 == (question->NBNSQ_FLAGS1 & 0x80)) && (32 == question->NBNSQ_NAMESIZE)) {
+                struct NBNSANSWER *nbnsa = (struct NBNSANSWER *)_answer;
+                // jmeno (15 znaku doplnenych mezerami) porovname v NETBIOS kodovani, priponu nechame byt
+                if (0 == memcmp(question->NBNSQ_NAME, nbnsa->NBNSA_NAME, 30)) {
                     // dotaz primo na nas
-                    struct NBNSANSWER nbnsa; // buffer, do ktereho je sestavena odpoved na dotaz
-
-                    nbnsa.NBNSA_ID = question->NBNSQ_ID;// ID dotazu kopirujeme do ID odpovedi
-                    nbnsa.NBNSA_FLAGS1 = 0x85;	// priznak odpovedi
-                    nbnsa.NBNSA_FLAGS2 = 0; // vlajky 2 a response code
-                    nbnsa.NBNSA_QUESTIONCOUNT = LWIP_PLATFORM_HTONS(0);
-                    nbnsa.NBNSA_ANSWERCOUNT = LWIP_PLATFORM_HTONS(1);// poradove cislo odpovedi
-                    nbnsa.NBNSA_AUTHORITYCOUNT = LWIP_PLATFORM_HTONS(0);
-                    nbnsa.NBNSA_ADDITIONALRECORDCOUNT = LWIP_PLATFORM_HTONS(0);
-                    nbnsa.NBNSA_NAMESIZE = sizeof(nbnsa.NBNSA_NAME) - 1; // prekopirujeme delku jmena stanice
-                    _makenbname(_name, &nbnsa.NBNSA_NAME[0], sizeof(nbnsa.NBNSA_NAME) - 1); // prevedeme jmeno
-                    nbnsa.NBNSA_TYPE = LWIP_PLATFORM_HTONS(0x20); // NetBIOS name
-                    nbnsa.NBNSA_CLASS = LWIP_PLATFORM_HTONS(1); // Internet name
-                    nbnsa.NBNSA_TIMETOLIVE = LWIP_PLATFORM_HTONL(300000UL);// Time to live (30000 sekund)
-                    nbnsa.NBNSA_LENGTH = LWIP_PLATFORM_HTONS(6);
-                    nbnsa.NBNSA_NODEFLAGS = LWIP_PLATFORM_HTONS(0);
-                    nbnsa.NBNSA_NODEADDRESS = WiFi.localIP(); // ulozime nasi IP adresu
-
-                    pbuf* pbt = pbuf_alloc(PBUF_TRANSPORT, sizeof(nbnsa), PBUF_RAM);
-                    if(pbt != NULL) {
-                        uint8_t* dst = reinterpret_cast<uint8_t*>(pbt->payload);
-                        memcpy(dst, (uint8_t *)&nbnsa, sizeof(nbnsa));
-                        udp_sendto(_pcb, pbt, saddr, NBNS_PORT);
-                        pbuf_free(pbt);
-                    }
-                } else if (0 == strcmp(name, "*")) {
+                    nbnsa->NBNSA_ID = question->NBNSQ_ID;// ID dotazu kopirujeme do ID odpovedi
+                    nbnsa->NBNSA_NODEADDRESS = WiFi.localIP(); // ulozime nasi IP adresu
+                    _send(_answer, sizeof(_answer), saddr);
+                } else if (0 == memcmp(question->NBNSQ_NAME, NBNS_WILDCARD, sizeof(NBNS_WILDCARD))) {
                     // obecny dotaz - mireny nejspis na nasi IP adresu
-                    struct NBNSANSWERN nbnsan; // buffer, do ktereho je sestavena odpoved na dotaz
-
-                    nbnsan.NBNSAN_ID = question->NBNSQ_ID;// ID dotazu kopirujeme do ID odpovedi
-                    nbnsan.NBNSAN_FLAGS1 = 0x84;	// priznak odpovedi
-                    nbnsan.NBNSAN_FLAGS2 = 0; // vlajky 2 a response code
-                    nbnsan.NBNSAN_QUESTIONCOUNT = LWIP_PLATFORM_HTONS(0);
-                    nbnsan.NBNSAN_ANSWERCOUNT = LWIP_PLATFORM_HTONS(1);// poradove cislo odpovedi
-                    nbnsan.NBNSAN_AUTHORITYCOUNT = LWIP_PLATFORM_HTONS(0);
-                    nbnsan.NBNSAN_ADDITIONALRECORDCOUNT = LWIP_PLATFORM_HTONS(0);
-                    nbnsan.NBNSAN_NAMESIZE = question->NBNSQ_NAMESIZE; // prekopirujeme delku jmena stanice
-                    memcpy(nbnsan.NBNSAN_NAME, question->NBNSQ_NAME, sizeof(nbnsan.NBNSAN_NAME)); // prekopirujeme dotazovane jmeno
-                    nbnsan.NBNSAN_TYPE = LWIP_PLATFORM_HTONS(0x21); // NBSTAT
-                    nbnsan.NBNSAN_CLASS = LWIP_PLATFORM_HTONS(1); // Internet name
-                    nbnsan.NBNSAN_TIMETOLIVE = LWIP_PLATFORM_HTONL(0);
-                    nbnsan.NBNSAN_LENGTH = LWIP_PLATFORM_HTONS(4 + sizeof(nbnsan.NBNSAN_NNAME));
-                    nbnsan.NBNSAN_NUMBER = 1; // Number of names
-                    memset(nbnsan.NBNSAN_NNAME, 0x20, sizeof(nbnsan.NBNSAN_NNAME));
-                    memcpy(nbnsan.NBNSAN_NNAME, _name, strlen(_name));
-                    nbnsan.NBNSAN_NTYPE = 0; // Workstation/Redirector
-                    nbnsan.NBNSAN_NFLAGS = LWIP_PLATFORM_HTONS(0x400); // b-node, unique, active
-
-                    pbuf* pbt = pbuf_alloc(PBUF_TRANSPORT, sizeof(nbnsan), PBUF_RAM);
-                    if(pbt != NULL) {
-                        uint8_t* dst = reinterpret_cast<uint8_t*>(pbt->payload);
-                        memcpy(dst, (uint8_t *)&nbnsan, sizeof(nbnsan));
-                        udp_sendto(_pcb, pbt, saddr, NBNS_PORT);
-                        pbuf_free(pbt);
-                    }
+                    struct NBNSANSWERN *nbnsan = (struct NBNSANSWERN *)_answern;
+                    nbnsan->NBNSAN_ID = question->NBNSQ_ID;// ID dotazu kopirujeme do ID odpovedi
+                    _send(_answern, sizeof(_answern), saddr);
                 }
             }
         }
@@ -262,6 +235,16 @@ void ESP8266NetBIOS::_recv(udp_pcb *upcb, pbuf *pb, const ip_addr_t *addr, uint1
     }
 }
 
+void ESP8266NetBIOS::_send(const uint8_t *reply, size_t len, const ip_addr_t *addr)
+{
+    pbuf* pbt = pbuf_alloc(PBUF_TRANSPORT, len, PBUF_RAM);
+    if(pbt != NULL) {
+        memcpy(pbt->payload, reply, len);
+        udp_sendto(_pcb, pbt, addr, NBNS_PORT);
+        pbuf_free(pbt);
+    }
+}
+
 void ESP8266NetBIOS::_s_recv(void *arg, udp_pcb *upcb, pbuf *p, const ip_addr_t *addr, uint16_t port)
 {
     reinterpret_cast<ESP8266NetBIOS*>(arg)->_recv(upcb, p, addr, port);
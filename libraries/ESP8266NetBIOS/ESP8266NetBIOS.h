@@ -24,8 +24,11 @@ class ESP8266NetBIOS
 protected:
     udp_pcb* _pcb;
     char _name[NBNS_MAX_HOSTNAME_LEN + 1];
-    void _getnbname(char *nbname, char *name, uint8_t maxlen);
+    // replies built by begin(), per query only ID and address are set
+    uint8_t _answer[62];    // struct NBNSANSWER, to a query for _name
+    uint8_t _answern[75];   // struct NBNSANSWERN, to a node status query for "*"
     void _makenbname(char *name, char *nbname, uint8_t outlen);
+    void _send(const uint8_t *reply, size_t len, const ip_addr_t *addr);
    
     void _recv(udp_pcb *upcb, pbuf *pb, const ip_addr_t *addr, uint16_t port);
     static void _s_recv(void *arg, udp_pcb *upcb, pbuf *p, const ip_addr_t *addr, uint16_t port);
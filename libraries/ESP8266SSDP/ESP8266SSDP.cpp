@@ -141,6 +141,7 @@ SSDPClass::SSDPClass()
 
 SSDPClass::~SSDPClass() {
   end();
+  _invalidate();
 }
 
 bool SSDPClass::begin() {
@@ -155,6 +156,8 @@ bool SSDPClass::begin() {
 	(uint16_t) ((chipId >>  8) & 0xff),
 	(uint16_t)   chipId        & 0xff);
   }
+  // the UUID may have just been generated
+  _invalidate();
   
 #ifdef DEBUG_SSDP
   DEBUG_SSDP.printf("SSDP UUID: %s\n", (char *)_uuid);
@@ -220,25 +223,46 @@ void SSDPClass::end() {
 #endif
 }
 void SSDPClass::_send(ssdp_method_t method) {
-  char buffer[1460];
   IPAddress ip = WiFi.localIP();
+  if ((uint32_t)ip != _packetIP) {
+    _invalidate();
+    _packetIP = ip;
+  }
 
-  char valueBuffer[strlen_P(_ssdp_notify_template) + 1];
-  strcpy_P(valueBuffer, (method == NONE) ? _ssdp_response_template : _ssdp_notify_template);
+  const int index = (method == NONE) ? (_st_is_uuid ? 1 : 0) : 2;
+  const char* packet = _packets[index];
+  size_t len = _packetLengths[index];
+  char buffer[1460];
 
-  int len = snprintf_P(buffer, sizeof(buffer),
-                       _ssdp_packet_template,
-                       valueBuffer,
-                       _interval,
-                       _modelName,
-                       _modelNumber,
-                       _uuid,
-                       (method == NONE) ? "ST" : "NT",
-                       (_st_is_uuid) ? _uuid : _deviceType,
-                       ip.toString().c_str(), _port, _schemaURL
-                      );
+  if (!packet) {
+    char valueBuffer[strlen_P(_ssdp_notify_template) + 1];
+    strcpy_P(valueBuffer, (method == NONE) ? _ssdp_response_template : _ssdp_notify_template);
+
+    int rendered = snprintf_P(buffer, sizeof(buffer),
+                              _ssdp_packet_template,
+                              valueBuffer,
+                              _interval,
+                              _modelName,
+                              _modelNumber,
+                              _uuid,
+                              (method == NONE) ? "ST" : "NT",
+                              (_st_is_uuid) ? _uuid : _deviceType,
+                              ip.toString().c_str(), _port, _schemaURL
+                             );
+    if (rendered < 0)
+      return;
+    len = std::min((size_t)rendered, sizeof(buffer) - 1);
+    packet = buffer;
+
+    // Without memory the packet is rendered again next time
+    _packets[index] = (char*)malloc(len);
+    if (_packets[index]) {
+      memcpy(_packets[index], buffer, len);
+      _packetLengths[index] = len;
+    }
+  }
 
-  _server->append(buffer, len);
+  _server->append(packet, len);
 
   IPAddress remoteAddr;
   uint16_t remotePort;
@@ -266,25 +290,47 @@ void SSDPClass::_send(ssdp_method_t method) {
 
 void SSDPClass::schema(Print &client) const {
   IPAddress ip = WiFi.localIP();
-  char buffer[strlen_P(_ssdp_schema_template) + 1];
-  strcpy_P(buffer, _ssdp_schema_template);
-  client.printf(buffer,
-                ip.toString().c_str(), _port,
-                _deviceType,
-                _friendlyName,
-                _presentationURL,
-                _serialNumber,
-                _modelName,
-                _modelNumber,
-                _modelURL,
-                _manufacturer,
-                _manufacturerURL,
-                _uuid
-               );
+  if (_schema && (uint32_t)ip != _schemaIP) {
+    free(_schema);
+    _schema = nullptr;
+  }
+
+  if (!_schema) {
+    String host = ip.toString();
+    auto render = [&](char* buffer, size_t size) {
+      return snprintf_P(buffer, size, _ssdp_schema_template,
+                        host.c_str(), _port,
+                        _deviceType,
+                        _friendlyName,
+                        _presentationURL,
+                        _serialNumber,
+                        _modelName,
+                        _modelNumber,
+                        _modelURL,
+                        _manufacturer,
+                        _manufacturerURL,
+                        _uuid
+                       );
+    };
+    int len = render(nullptr, 0);
+    if (len < 0)
+      return;
+    _schema = (char*)malloc(len + 1);
+    if (!_schema)
+      return;
+    render(_schema, len + 1);
+    _schemaLength = len;
+    _schemaIP = ip;
+  }
+
+  client.write((const uint8_t*)_schema, _schemaLength);
 }
 
 void SSDPClass::_update() {
-  if (!_pending && _server->next()) {
+  // Out of replies for now, the searches are dropped below without parsing
+  const bool replyAllowed = _replyAllowed();
+
+  if (!_pending && replyAllowed && _server->next()) {
     ssdp_method_t method = NONE;
 
     _respondToAddr = _server->getRemoteAddress();
@@ -384,7 +430,8 @@ void SSDPClass::_update() {
                 }
                 break;
               case MX:
-                _delay = random(0, atoi(buffer)) * 1000L;
+                // Spread over the whole window, not on whole seconds
+                _delay = random(0, constrain(atoi(buffer), 0, SSDP_MAX_MX) * 1000L);
                 break;
             }
 
@@ -415,6 +462,8 @@ void SSDPClass::_update() {
 
   if (_pending && (millis() - _process_time) > _delay) {
     _pending = false; _delay = 0;
+    if (_replyTokens)
+      --_replyTokens;
     _send(NONE);
   } else if(_notify_time == 0 || (millis() - _notify_time) > (_interval * 1000L)){
     _notify_time = millis();
@@ -422,62 +471,104 @@ void SSDPClass::_update() {
     _send(NOTIFY);
   }
 
-  if (_pending) {
+  if (_pending || !replyAllowed) {
     while (_server->next())
       _server->flush();
   }
 
+  if (_pending) {
+    // Wake up when the reply is due rather than at the next second
+    unsigned long elapsed = millis() - _process_time;
+    _armTimer(elapsed < _delay ? _delay - elapsed + 1 : 1, false);
+    _timerShort = true;
+  } else if (_timerShort) {
+    _timerShort = false;
+    _armTimer(1000, true);
+  }
+}
+
+bool SSDPClass::_replyAllowed() {
+  unsigned long earned = (millis() - _replyTime) / SSDP_REPLY_INTERVAL_MS;
+  if (earned) {
+    _replyTokens = std::min<unsigned long>(SSDP_REPLY_BURST, _replyTokens + earned);
+    _replyTime += earned * SSDP_REPLY_INTERVAL_MS;
+  }
+  return _replyTokens != 0;
+}
+
+void SSDPClass::_invalidate() {
+  for (int i = 0; i < 3; ++i) {
+    free(_packets[i]);
+    _packets[i] = nullptr;
+    _packetLengths[i] = 0;
+  }
+  free(_schema);
+  _schema = nullptr;
+  _schemaLength = 0;
 }
 
 void SSDPClass::setSchemaURL(const char *url) {
+  _invalidate();
   strlcpy(_schemaURL, url, sizeof(_schemaURL));
 }
 
 void SSDPClass::setHTTPPort(uint16_t port) {
+  _invalidate();
   _port = port;
 }
 
 void SSDPClass::setDeviceType(const char *deviceType) {
+  _invalidate();
   strlcpy(_deviceType, deviceType, sizeof(_deviceType));
 }
 
 void SSDPClass::setUUID(const char *uuid) {
+  _invalidate();
   snprintf_P(_uuid, sizeof(_uuid), PSTR("uuid:%s"), uuid);  
 }
 
 void SSDPClass::setName(const char *name) {
+  _invalidate();
   strlcpy(_friendlyName, name, sizeof(_friendlyName));
 }
 
 void SSDPClass::setURL(const char *url) {
+  _invalidate();
   strlcpy(_presentationURL, url, sizeof(_presentationURL));
 }
 
 void SSDPClass::setSerialNumber(const char *serialNumber) {
+  _invalidate();
   strlcpy(_serialNumber, serialNumber, sizeof(_serialNumber));
 }
 
 void SSDPClass::setSerialNumber(const uint32_t serialNumber) {
+  _invalidate();
   snprintf(_serialNumber, sizeof(uint32_t) * 2 + 1, "%08X", serialNumber);
 }
 
 void SSDPClass::setModelName(const char *name) {
+  _invalidate();
   strlcpy(_modelName, name, sizeof(_modelName));
 }
 
 void SSDPClass::setModelNumber(const char *num) {
+  _invalidate();
   strlcpy(_modelNumber, num, sizeof(_modelNumber));
 }
 
 void SSDPClass::setModelURL(const char *url) {
+  _invalidate();
   strlcpy(_modelURL, url, sizeof(_modelURL));
 }
 
 void SSDPClass::setManufacturer(const char *name) {
+  _invalidate();
   strlcpy(_manufacturer, name, sizeof(_manufacturer));
 }
 
 void SSDPClass::setManufacturerURL(const char *url) {
+  _invalidate();
   strlcpy(_manufacturerURL, url, sizeof(_manufacturerURL));
 }
 
@@ -486,6 +577,7 @@ void SSDPClass::setTTL(const uint8_t ttl) {
 }
 
 void SSDPClass::setInterval(uint32_t interval) {
+  _invalidate();
   _interval = interval;
 }
 
@@ -501,6 +593,16 @@ void SSDPClass::_startTimer() {
   os_timer_disarm(tm);
   os_timer_setfn(tm, reinterpret_cast<ETSTimerFunc*>(&SSDPClass::_onTimerStatic), reinterpret_cast<void*>(this));
   os_timer_arm(tm, interval, 1 /* repeat */);
+  _timerShort = false;
+}
+
+void SSDPClass::_armTimer(uint32_t ms, bool repeat) {
+  if(!_timer)
+    return;
+
+  ETSTimer* tm = &(_timer->timer);
+  os_timer_disarm(tm);
+  os_timer_arm(tm, ms, repeat);
 }
 
 void SSDPClass::_stopTimer() {
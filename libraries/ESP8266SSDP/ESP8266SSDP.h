@@ -49,6 +49,12 @@ class UdpContext;
 #define SSDP_INTERVAL_SECONDS       1200
 #define SSDP_MULTICAST_TTL          2
 #define SSDP_HTTP_PORT              80
+// M-SEARCH replies: at most SSDP_REPLY_BURST back to back, then one more
+// every SSDP_REPLY_INTERVAL_MS.  Searches beyond that are dropped unread.
+#define SSDP_REPLY_BURST            4
+#define SSDP_REPLY_INTERVAL_MS      250
+// Longest reply delay honoured, in seconds (the MX header)
+#define SSDP_MAX_MX                 5
 
 typedef enum {
   NONE,
@@ -102,6 +108,9 @@ class SSDPClass{
     void _update();
     void _startTimer();
     void _stopTimer();
+    void _armTimer(uint32_t ms, bool repeat);
+    bool _replyAllowed();
+    void _invalidate();
     static void _onTimerStatic(SSDPClass* self);
 
     UdpContext* _server = nullptr;
@@ -113,6 +122,19 @@ class SSDPClass{
     IPAddress _respondToAddr;
     uint16_t  _respondToPort = 0;
 
+    // Packets and schema rendered for _cacheIP, dropped by every setter.
+    // Indexed by response to the device type, response to the UUID, notify.
+    char* _packets[3] = { nullptr, nullptr, nullptr };
+    uint16_t _packetLengths[3] = { 0, 0, 0 };
+    uint32_t _packetIP = 0;
+    mutable char* _schema = nullptr;
+    mutable size_t _schemaLength = 0;
+    mutable uint32_t _schemaIP = 0;
+
+    uint8_t _replyTokens = SSDP_REPLY_BURST;
+    unsigned long _replyTime = 0;
+    bool _timerShort = false;
+
     bool _pending = false;
     bool _st_is_uuid = false;
     unsigned short _delay = 0;
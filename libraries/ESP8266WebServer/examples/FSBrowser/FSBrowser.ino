@@ -197,48 +197,46 @@ void handleFileList() {
     return;
   }
 
-  // use the same string for every line
-  String output;
-  output.reserve(64);
-  while (dir.next()) {
+  // entries are printed into a buffered writer, which sends them
+  // in a few large HTTP chunks
+  {
+    auto output = server.chunkedWriter();
+    char separator = '[';
+    while (dir.next()) {
 #ifdef USE_SPIFFS
-    String error = checkForUnsupportedPath(dir.fileName());
-    if (error.length() > 0) {
-      DBG_OUTPUT_PORT.println(String("Ignoring ") + error + dir.fileName());
-      continue;
-    }
+      String error = checkForUnsupportedPath(dir.fileName());
+      if (error.length() > 0) {
+        DBG_OUTPUT_PORT.println(String("Ignoring ") + error + dir.fileName());
+        continue;
+      }
 #endif
-    if (output.length()) {
-      // send string from previous iteration
-      // as an HTTP chunk
-      server.sendContent(output);
-      output = ',';
-    } else {
-      output = '[';
-    }
+      output.print(separator);
+      separator = ',';
 
-    output += "{\"type\":\"";
-    if (dir.isDirectory()) {
-      output += "dir";
-    } else {
-      output += F("file\",\"size\":\"");
-      output += dir.fileSize();
-    }
+      output.print("{\"type\":\"");
+      if (dir.isDirectory()) {
+        output.print("dir");
+      } else {
+        output.print(F("file\",\"size\":\""));
+        output.print(dir.fileSize());
+      }
 
-    output += F("\",\"name\":\"");
-    // Always return names without leading "/"
-    if (dir.fileName()[0] == '/') {
-      output += &(dir.fileName()[1]);
-    } else {
-      output += dir.fileName();
+      output.print(F("\",\"name\":\""));
+      // Always return names without leading "/"
+      if (dir.fileName()[0] == '/') {
+        output.print(&(dir.fileName()[1]));
+      } else {
+        output.print(dir.fileName());
+      }
+
+      output.print("\"}");
     }
 
-    output += "\"}";
+    if (separator == '[') {
+      output.print(separator);
+    }
+    output.print(']');
   }
-
-  // send last string
-  output += "]";
-  server.sendContent(output);
   server.chunkedResponseFinalize();
 }
 
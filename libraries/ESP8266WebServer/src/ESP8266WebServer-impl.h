@@ -21,6 +21,7 @@
 */
 
 #include <Arduino.h>
+#include <algorithm>
 #include <libb64/cencode.h>
 #include "WiFiServer.h"
 #include "WiFiClient.h"
@@ -28,6 +29,7 @@
 #include "FS.h"
 #include "base64.h"
 #include "detail/RequestHandlersImpl.h"
+#include "detail/WebSocket.h"
 #include <StreamDev.h>
 
 static const char AUTHORIZATION_HEADER[] PROGMEM = "Authorization";
@@ -71,12 +73,14 @@ void ESP8266WebServerTemplate<ServerType>::enableCORS(bool enable) {
 template <typename ServerType>
 void ESP8266WebServerTemplate<ServerType>::begin() {
   close();
+  _buildRouteIndex();
   _server.begin();
 }
 
 template <typename ServerType>
 void ESP8266WebServerTemplate<ServerType>::begin(uint16_t port) {
   close();
+  _buildRouteIndex();
   _server.begin(port);
 }
 
@@ -223,18 +227,41 @@ void ESP8266WebServerTemplate<ServerType>::requestAuthentication(HTTPAuthMethod
 }
 
 template <typename ServerType>
-void ESP8266WebServerTemplate<ServerType>::on(const Uri &uri, ESP8266WebServerTemplate<ServerType>::THandlerFunction handler) {
-  on(uri, HTTP_ANY, handler);
+typename ESP8266WebServerTemplate<ServerType>::RequestHandlerType& ESP8266WebServerTemplate<ServerType>::on(const Uri &uri, ESP8266WebServerTemplate<ServerType>::THandlerFunction handler) {
+  return on(uri, HTTP_ANY, handler);
 }
 
 template <typename ServerType>
-void ESP8266WebServerTemplate<ServerType>::on(const Uri &uri, HTTPMethod method, ESP8266WebServerTemplate<ServerType>::THandlerFunction fn) {
-  on(uri, method, fn, _fileUploadHandler);
+typename ESP8266WebServerTemplate<ServerType>::RequestHandlerType& ESP8266WebServerTemplate<ServerType>::on(const Uri &uri, HTTPMethod method, ESP8266WebServerTemplate<ServerType>::THandlerFunction fn) {
+  return on(uri, method, fn, _fileUploadHandler);
 }
 
 template <typename ServerType>
-void ESP8266WebServerTemplate<ServerType>::on(const Uri &uri, HTTPMethod method, ESP8266WebServerTemplate<ServerType>::THandlerFunction fn, ESP8266WebServerTemplate<ServerType>::THandlerFunction ufn) {
-  _addRequestHandler(new FunctionRequestHandler<ServerType>(fn, ufn, uri, method));
+typename ESP8266WebServerTemplate<ServerType>::RequestHandlerType& ESP8266WebServerTemplate<ServerType>::on(const Uri &uri, HTTPMethod method, ESP8266WebServerTemplate<ServerType>::THandlerFunction fn, ESP8266WebServerTemplate<ServerType>::THandlerFunction ufn) {
+  RequestHandlerType* handler = new FunctionRequestHandler<ServerType>(fn, ufn, uri, method);
+  _addRequestHandler(handler);
+  return *handler;
+}
+
+template <typename ServerType>
+void ESP8266WebServerTemplate<ServerType>::invalidateCache() {
+  for (RequestHandlerType* handler = _firstHandler; handler; handler = handler->next())
+    handler->invalidate();
+}
+
+template <typename ServerType>
+typename ESP8266WebServerTemplate<ServerType>::WebSocketType& ESP8266WebServerTemplate<ServerType>::onWebSocket(const Uri &uri, ESP8266WebServerTemplate<ServerType>::TWebSocketFunction fn) {
+  WebSocketType* handler = new WebSocketType(uri, fn);
+  _addRequestHandler(handler);
+  _webSockets.push_back(handler);
+  return *handler;
+}
+
+template <typename ServerType>
+typename ESP8266WebServerTemplate<ServerType>::EventSourceType& ESP8266WebServerTemplate<ServerType>::onEventSource(const Uri &uri) {
+  EventSourceType* handler = new EventSourceType(uri);
+  _addRequestHandler(handler);
+  return *handler;
 }
 
 template <typename ServerType>
@@ -252,6 +279,54 @@ void ESP8266WebServerTemplate<ServerType>::_addRequestHandler(RequestHandlerType
       _lastHandler->next(handler);
       _lastHandler = handler;
     }
+    _routeIndexValid = false;
+}
+
+template <typename ServerType>
+void ESP8266WebServerTemplate<ServerType>::_buildRouteIndex() {
+    _exactRoutes.clear();
+    _patternRoutes.clear();
+    size_t order = 0;
+    for (RequestHandlerType* handler = _firstHandler; handler; handler = handler->next()) {
+      const String* uri = handler->exactUri();
+      if (uri)
+        _exactRoutes.push_back({uri, handler, order});
+      else
+        _patternRoutes.push_back({nullptr, handler, order});
+      ++order;
+    }
+    // stable: handlers sharing an uri stay in registration order
+    std::stable_sort(_exactRoutes.begin(), _exactRoutes.end(),
+        [](const RouteEntry& a, const RouteEntry& b) { return a.uri->compareTo(*b.uri) < 0; });
+    _exactRoutes.shrink_to_fit();
+    _patternRoutes.shrink_to_fit();
+    _routeIndexValid = true;
+}
+
+template <typename ServerType>
+typename ESP8266WebServerTemplate<ServerType>::RequestHandlerType*
+ESP8266WebServerTemplate<ServerType>::_findHandler(HTTPMethod method, const String& uri) {
+    if (!_routeIndexValid)
+      _buildRouteIndex();
+
+    // Same result as walking _firstHandler in order: an exact route only wins
+    // if no pattern handler registered before it accepts the request.
+    auto exact = std::lower_bound(_exactRoutes.begin(), _exactRoutes.end(), uri,
+        [](const RouteEntry& e, const String& u) { return e.uri->compareTo(u) < 0; });
+    auto pattern = _patternRoutes.begin();
+    for (; exact != _exactRoutes.end() && *exact->uri == uri; ++exact) {
+      for (; pattern != _patternRoutes.end() && pattern->order < exact->order; ++pattern) {
+        if (pattern->handler->canHandle(method, uri))
+          return pattern->handler;
+      }
+      if (exact->handler->canHandle(method, uri))
+        return exact->handler;
+    }
+    for (; pattern != _patternRoutes.end(); ++pattern) {
+      if (pattern->handler->canHandle(method, uri))
+        return pattern->handler;
+    }
+    return nullptr;
 }
 
 template <typename ServerType>
@@ -270,12 +345,64 @@ void ESP8266WebServerTemplate<ServerType>::serveStatic(const char* uri, FS& fs,
     _addRequestHandler(new StaticDirectoryRequestHandler<ServerType>(fs, path, uri, cache_header));  
 }
 
+template <typename ServerType>
+void ESP8266WebServerTemplate<ServerType>::setMaxClients(uint8_t count) {
+  _maxClients = std::min(std::max(count, (uint8_t)1), (uint8_t)WEBSERVER_MAX_CLIENTS);
+  _slots.reset(_maxClients > 1 ? new ClientSlot[_maxClients - 1] : nullptr);
+  _nextSlot = 0;
+}
+
+template <typename ServerType>
+void ESP8266WebServerTemplate<ServerType>::_swapSlot(ClientSlot& slot) {
+  std::swap(_currentClient, slot.client);
+  std::swap(_currentStatus, slot.status);
+  std::swap(_statusChange, slot.statusChange);
+  std::swap(_keepAlive, slot.keepAlive);
+  std::swap(_requestCount, slot.requestCount);
+  std::swap(_head, slot.head);
+  std::swap(_headMatch, slot.headMatch);
+  std::swap(_headLineDone, slot.headLineDone);
+  std::swap(_headFuture, slot.headFuture);
+}
+
+template <typename ServerType>
+bool ESP8266WebServerTemplate<ServerType>::_hasFreeSlot() const {
+  for (uint8_t i = 0; i + 1 < _maxClients; i++) {
+    if (_slots[i].status == HC_NONE)
+      return true;
+  }
+  return false;
+}
+
 template <typename ServerType>
 void ESP8266WebServerTemplate<ServerType>::handleClient() {
+  // The current connection is slot 0, the others are swapped in one after
+  // the other, starting from a different slot on each call.
+  bool callYield = false;
+  for (uint8_t i = 0; i < _maxClients; i++) {
+    uint8_t slot = (_nextSlot + i) % _maxClients;
+    if (slot)
+      _swapSlot(_slots[slot - 1]);
+    callYield |= _handleCurrentClient();
+    if (slot)
+      _swapSlot(_slots[slot - 1]);
+  }
+  _nextSlot = (_nextSlot + 1) % _maxClients;
+
+  for (WebSocketType* ws : _webSockets)
+    callYield |= ws->loop();
+
+  if (callYield) {
+    yield();
+  }
+}
+
+template <typename ServerType>
+bool ESP8266WebServerTemplate<ServerType>::_handleCurrentClient() {
   if (_currentStatus == HC_NONE) {
     ClientType client = _server.available();
     if (!client) {
-      return;
+      return false;
     }
 
     DBGWS("New client\n");
@@ -283,6 +410,7 @@ void ESP8266WebServerTemplate<ServerType>::handleClient() {
     _currentClient = client;
     _currentStatus = HC_WAIT_READ;
     _statusChange = millis();
+    _requestCount = 0;
   }
 
   bool keepCurrentClient = false;
@@ -305,14 +433,23 @@ void ESP8266WebServerTemplate<ServerType>::handleClient() {
       // No-op to avoid C++ compiler warning
       break;
     case HC_WAIT_READ:
-      // Wait for data from client to become available
-      if (_currentClient.available()) {
-        switch (_parseRequest(_currentClient))
+      // Wait for the whole request head to become available
+      if (_currentClient.available() && _readRequestHead(_currentClient)) {
+        ClientFuture future = _parseRequest(_currentClient);
+        _clearRequestHead();
+        ++_requestCount;
+        switch (future)
         {
         case CLIENT_REQUEST_CAN_CONTINUE:
           _currentClient.setTimeout(HTTP_MAX_SEND_WAIT);
           _contentLength = CONTENT_LENGTH_NOT_SET;
           _handleRequest();
+          if (_clientGiven) {
+            // upgraded to a WebSocket, or kept for events
+            _clientGiven = false;
+            DBGWS("Give client\n");
+            break;
+          }
           /* fallthrough */
         case CLIENT_REQUEST_IS_HANDLED:
           if (_currentClient.connected() || _currentClient.available()) {
@@ -334,7 +471,7 @@ void ESP8266WebServerTemplate<ServerType>::handleClient() {
           break;
         } // switch _parseRequest()
       } else {
-        // !_currentClient.available(): waiting for more data
+        // waiting for more data
         if (millis() - _statusChange <= HTTP_MAX_DATA_WAIT) {
           keepCurrentClient = true;
         }
@@ -344,12 +481,14 @@ void ESP8266WebServerTemplate<ServerType>::handleClient() {
       }
       break;
     case HC_WAIT_CLOSE:
-      // Wait for client to close the connection
-      if (!_server.hasClient() && (millis() - _statusChange <= HTTP_MAX_CLOSE_WAIT)) {
+      // Wait for the next request on a kept alive connection, or for
+      // the client to close it, unless a new client is waiting for this slot
+      if ((!_server.hasClient() || _hasFreeSlot())
+          && (millis() - _statusChange <= (_keepAlive ? _keepAliveTimeout : HTTP_MAX_CLOSE_WAIT))) {
         keepCurrentClient = true;
         callYield = true;
-        if (_currentClient.available())
-            // continue serving current client
+        if (_keepAlive && _currentClient.available())
+            // continue serving current client, pipelined requests included
             _currentStatus = HC_WAIT_READ;
       }
       break;
@@ -361,17 +500,21 @@ void ESP8266WebServerTemplate<ServerType>::handleClient() {
     _currentClient = ClientType();
     _currentStatus = HC_NONE;
     _currentUpload.reset();
+    _clearRequestHead();
+    _head = String();
   }
 
-  if (callYield) {
-    yield();
-  }
+  return callYield;
 }
 
 template <typename ServerType>
 void ESP8266WebServerTemplate<ServerType>::close() {
   _server.close();
   _currentStatus = HC_NONE;
+  _clearRequestHead();
+  for (uint8_t i = 0; i + 1 < _maxClients; i++) {
+    _slots[i] = ClientSlot();
+  }
   if(!_headerKeysCount)
     collectHeaders();
 }
@@ -428,12 +571,20 @@ void ESP8266WebServerTemplate<ServerType>::_prepareHeader(String& response, int
       sendHeader(String(F("Access-Control-Allow-Origin")), String("*"));
     }
 
-    if (_keepAlive && _server.hasClient()) { // Disable keep alive if another client is waiting.
+    if (_keepAlive && _server.hasClient() && !_hasFreeSlot()) { // Disable keep alive if another client is waiting.
+      _keepAlive = false;
+    }
+    if (_keepAlive && _keepAliveMaxRequests && _requestCount >= _keepAliveMaxRequests) {
       _keepAlive = false;
     }
     sendHeader(String(F("Connection")), String(_keepAlive ? F("keep-alive") : F("close")));
     if (_keepAlive) {
-      sendHeader(String(F("Keep-Alive")), String(F("timeout=")) + HTTP_MAX_CLOSE_WAIT);
+      String keepAliveValue = String(F("timeout=")) + (_keepAliveTimeout + 999) / 1000;
+      if (_keepAliveMaxRequests) {
+        keepAliveValue += F(", max=");
+        keepAliveValue += _keepAliveMaxRequests - _requestCount;
+      }
+      sendHeader(String(F("Keep-Alive")), keepAliveValue);
     }
 
     response += _responseHeaders;
@@ -467,6 +618,36 @@ void ESP8266WebServerTemplate<ServerType>::send(int code, const char* content_ty
   String header;
   if (content_length == 0)
       content_length = std::max((ssize_t)0, stream->streamRemaining());
+  if (_cacheFill) {
+    // the first response of a cached handler, unless the body comes apart
+    ResponseCache* cache = _cacheFill;
+    _cacheFill = nullptr;
+    if (code == 200 && _contentLength == CONTENT_LENGTH_NOT_SET) {
+      StreamString body;
+      if (stream->sendSize(&body, content_length) == content_length) {
+        using namespace mime;
+        ResponseCache::Entry& entry = cache->store(_cacheKey);
+        entry.contentType = content_type ? content_type : String(FPSTR(mimeTable[html].mimeType));
+        entry.headers = _responseHeaders;
+        entry.body = std::move(body);
+        MD5Builder md5;
+        md5.begin();
+        md5.add(entry.body);
+        md5.calculate();
+        entry.etag = '"';
+        entry.etag += md5.toString().substring(0, 16);
+        entry.etag += '"';
+        _responseHeaders.clear();
+        _sendCached(entry);
+        return;
+      }
+      // only part of it: sent as is, without caching
+      content_length = body.length();
+      _prepareHeader(header, code, content_type, content_length);
+      StreamConstPtr(header).sendAll(&_currentClient);
+      return sendContent(&body, content_length);
+    }
+  }
   _prepareHeader(header, code, content_type, content_length);
   size_t sent = StreamConstPtr(header).sendAll(&_currentClient);
   if (sent != header.length())
@@ -551,13 +732,13 @@ const String& ESP8266WebServerTemplate<ServerType>::pathArg(unsigned int i) cons
 }
 
 template <typename ServerType>
-const String& ESP8266WebServerTemplate<ServerType>::arg(const String& name) const {
+const String& ESP8266WebServerTemplate<ServerType>::arg(StringView name) const {
   for (int j = 0; j < _postArgsLen; ++j) {
-    if ( _postArgs[j].key == name )
+    if ( name == _postArgs[j].key )
       return _postArgs[j].value;
   }
   for (int i = 0; i < _currentArgCount + _currentArgsHavePlain; ++i) {
-    if ( _currentArgs[i].key == name )
+    if ( name == _currentArgs[i].key )
       return _currentArgs[i].value;
   }
   return emptyString;
@@ -583,13 +764,13 @@ int ESP8266WebServerTemplate<ServerType>::args() const {
 }
 
 template <typename ServerType>
-bool ESP8266WebServerTemplate<ServerType>::hasArg(const String& name) const {
+bool ESP8266WebServerTemplate<ServerType>::hasArg(StringView name) const {
   for (int j = 0; j < _postArgsLen; ++j) {
-    if (_postArgs[j].key == name)
+    if (name == _postArgs[j].key)
       return true;
   }
   for (int i = 0; i < _currentArgCount + _currentArgsHavePlain; ++i) {
-    if (_currentArgs[i].key == name)
+    if (name == _currentArgs[i].key)
       return true;
   }
   return false;
@@ -597,11 +778,18 @@ bool ESP8266WebServerTemplate<ServerType>::hasArg(const String& name) const {
 
 template <typename ServerType>
 const String& ESP8266WebServerTemplate<ServerType>::header(const String& name) const {
-  for (int i = 0; i < _headerKeysCount; ++i) {
-    if (_currentHeaders[i].key.equalsIgnoreCase(name))
-      return _currentHeaders[i].value;
-  }
-  return emptyString;
+  return header(name.c_str());
+}
+
+template <typename ServerType>
+const String& ESP8266WebServerTemplate<ServerType>::header(const char* name) const {
+  int i = _headerIndex(name);
+  return i < 0 ? emptyString : _currentHeaders[i].value;
+}
+
+template <typename ServerType>
+const String& ESP8266WebServerTemplate<ServerType>::header(const __FlashStringHelper* name) const {
+  return header((PGM_P)name);
 }
 
 template<typename ServerType>
@@ -614,6 +802,7 @@ void ESP8266WebServerTemplate<ServerType>::collectHeaders(const char* headerKeys
   for (int i = 2; i < _headerKeysCount; i++){
       _currentHeaders[i].key = headerKeys[i - 2];
   }
+  _hashHeaderKeys();
 }
 
 template <typename ServerType>
@@ -626,6 +815,7 @@ void ESP8266WebServerTemplate<ServerType>::collectHeaders(const Args&... args) {
     { .key = FPSTR(ETAG_HEADER), .value = emptyString },
     { .key = args, .value = emptyString } ...
   };
+  _hashHeaderKeys();
 }
 
 template <typename ServerType>
@@ -649,11 +839,17 @@ int ESP8266WebServerTemplate<ServerType>::headers() const {
 
 template <typename ServerType>
 bool ESP8266WebServerTemplate<ServerType>::hasHeader(const String& name) const {
-  for (int i = 0; i < _headerKeysCount; ++i) {
-    if ((_currentHeaders[i].key.equalsIgnoreCase(name)) &&  (_currentHeaders[i].value.length() > 0))
-      return true;
-  }
-  return false;
+  return hasHeader(name.c_str());
+}
+
+template <typename ServerType>
+bool ESP8266WebServerTemplate<ServerType>::hasHeader(const char* name) const {
+  return header(name).length() > 0;
+}
+
+template <typename ServerType>
+bool ESP8266WebServerTemplate<ServerType>::hasHeader(const __FlashStringHelper* name) const {
+  return hasHeader((PGM_P)name);
 }
 
 template <typename ServerType>
@@ -678,7 +874,11 @@ void ESP8266WebServerTemplate<ServerType>::_handleRequest() {
     DBGWS("request handler not found\n");
   }
   else {
-    handled = _currentHandler->handle(*this, _currentMethod, _currentUri);
+    ResponseCache* cache = _currentHandler->responseCache();
+    if (cache && (_currentMethod == HTTP_GET || _currentMethod == HTTP_HEAD))
+      handled = _handleCached(*cache);
+    else
+      handled = _currentHandler->handle(*this, _currentMethod, _currentUri);
     if (!handled) {
       DBGWS("request handler failed to handle request\n");
     }
@@ -699,6 +899,38 @@ void ESP8266WebServerTemplate<ServerType>::_handleRequest() {
 }
 
 
+template <typename ServerType>
+bool ESP8266WebServerTemplate<ServerType>::_handleCached(ResponseCache& cache) {
+  _cacheKey = String(_currentUri);
+  for (const String& name : cache.args()) {
+    _cacheKey += '\n';
+    _cacheKey += arg(name);
+  }
+  const ResponseCache::Entry* entry = cache.find(_cacheKey);
+  if (entry) {
+    _sendCached(*entry);
+    return true;
+  }
+  // HEAD requests are answered without a body, GET ones fill the cache
+  if (_currentMethod == HTTP_GET)
+    _cacheFill = &cache;
+  bool handled = _currentHandler->handle(*this, _currentMethod, _currentUri);
+  _cacheFill = nullptr;
+  return handled;
+}
+
+template <typename ServerType>
+void ESP8266WebServerTemplate<ServerType>::_sendCached(const ResponseCache::Entry& entry) {
+  sendHeader(F("ETag"), entry.etag);
+  if (header(FPSTR(ETAG_HEADER)) == entry.etag) {
+    send(304);
+    return;
+  }
+  _responseHeaders += entry.headers;
+  StreamConstPtr body(entry.body.c_str(), entry.body.length());
+  send(200, entry.contentType.c_str(), &body);
+}
+
 template <typename ServerType>
 void ESP8266WebServerTemplate<ServerType>::_finalizeResponse() {
   if (_chunked) {
@@ -816,6 +1048,9 @@ String ESP8266WebServerTemplate<ServerType>::responseCodeToString(const int code
     case 417:
         r = F("Expectation Failed");
         break;
+    case 426:
+        r = F("Upgrade Required");
+        break;
     case 500:
         r = F("Internal Server Error");
         break;
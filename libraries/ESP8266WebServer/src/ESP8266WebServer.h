@@ -49,6 +49,7 @@ enum HTTPUploadStatus { UPLOAD_FILE_START, UPLOAD_FILE_WRITE, UPLOAD_FILE_END,
                         UPLOAD_FILE_ABORTED };
 enum HTTPClientStatus { HC_NONE, HC_WAIT_READ, HC_WAIT_CLOSE };
 enum HTTPAuthMethod { BASIC_AUTH, DIGEST_AUTH };
+enum WebSocketEvent { WS_CONNECTED, WS_DISCONNECTED, WS_TEXT, WS_BINARY };
 
 #define WEBSERVER_HAS_HOOK 1
 
@@ -58,6 +59,14 @@ enum HTTPAuthMethod { BASIC_AUTH, DIGEST_AUTH };
 #define HTTP_UPLOAD_BUFLEN 2048
 #endif
 
+#ifndef HTTP_MAX_HEAD_SIZE
+#define HTTP_MAX_HEAD_SIZE 2048 // request line and headers, longer requests are dropped
+#endif
+
+#ifndef WEBSERVER_MAX_CLIENTS
+#define WEBSERVER_MAX_CLIENTS 4 // upper limit for setMaxClients()
+#endif
+
 #define HTTP_MAX_DATA_WAIT 5000 //ms to wait for the client to send the request
 #define HTTP_MAX_POST_WAIT 5000 //ms to wait for POST data to arrive
 #define HTTP_MAX_SEND_WAIT 5000 //ms to wait for data chunk to be ACKed
@@ -82,9 +91,16 @@ namespace esp8266webserver {
 template<typename ServerType>
 class ESP8266WebServerTemplate;
 
+template<typename ServerType>
+class WebSocketHandler;
+
+template<typename ServerType>
+class EventSourceRequestHandler;
+
 }
 
 #include "detail/RequestHandler.h"
+#include "detail/ChunkedPrint.h"
 
 namespace esp8266webserver {
 
@@ -99,6 +115,8 @@ public:
   using ClientType = typename ServerType::ClientType;
   using RequestHandlerType = RequestHandler<ServerType>;
   using WebServerType = ESP8266WebServerTemplate<ServerType>;
+  using WebSocketType = WebSocketHandler<ServerType>;
+  using EventSourceType = EventSourceRequestHandler<ServerType>;
   enum ClientFuture { CLIENT_REQUEST_CAN_CONTINUE, CLIENT_REQUEST_IS_HANDLED, CLIENT_MUST_STOP, CLIENT_IS_GIVEN };
   typedef String (*ContentTypeFunction) (const String&);
   using HookFunction = std::function<ClientFuture(const String& method, const String& url, WiFiClient* client, ContentTypeFunction contentType)>;
@@ -108,17 +126,27 @@ public:
   void handleClient();
   void close();
   void stop();
+  // number of connections kept open and parsed in parallel (default 1),
+  // requests are still handled one at a time - to be called before begin()
+  void setMaxClients(uint8_t count);
 
   bool authenticate(const char * username, const char * password);
   bool authenticateDigest(const String& username, const String& H1);
   void requestAuthentication(HTTPAuthMethod mode = BASIC_AUTH, const char* realm = NULL, const String& authFailMsg = String("") );
 
   typedef std::function<void(void)> THandlerFunction;
-  void on(const Uri &uri, THandlerFunction handler);
-  void on(const Uri &uri, HTTPMethod method, THandlerFunction fn);
-  void on(const Uri &uri, HTTPMethod method, THandlerFunction fn, THandlerFunction ufn);
+  RequestHandlerType& on(const Uri &uri, THandlerFunction handler);
+  RequestHandlerType& on(const Uri &uri, HTTPMethod method, THandlerFunction fn);
+  RequestHandlerType& on(const Uri &uri, HTTPMethod method, THandlerFunction fn, THandlerFunction ufn);
   void addHandler(RequestHandlerType* handler);
   void serveStatic(const char* uri, fs::FS& fs, const char* path, const char* cache_header = NULL );
+  // WebSocket endpoint, fn(client number, event, payload, length) is
+  // called from handleClient(). The handler sends to its clients.
+  typedef std::function<void(uint8_t num, WebSocketEvent type, const uint8_t* payload, size_t length)> TWebSocketFunction;
+  WebSocketType& onWebSocket(const Uri &uri, TWebSocketFunction fn);
+  // Server-Sent Events endpoint, events are published with its send()
+  EventSourceType& onEventSource(const Uri &uri);
+  void invalidateCache(); // drop the responses kept by all handlers, see RequestHandler::cache()
   void onNotFound(THandlerFunction fn);  //called when handler is not assigned
   void onFileUpload(THandlerFunction fn); //handle file uploads
   void enableCORS(bool enable);
@@ -132,19 +160,23 @@ public:
   ServerType &getServer() { return _server; }
 
   const String& pathArg(unsigned int i) const; // get request path argument by number
-  const String& arg(const String& name) const;    // get request argument value by name
+  const String& arg(StringView name) const;       // get request argument value by name, no copy of name
   const String& arg(int i) const;          // get request argument value by number
   const String& argName(int i) const;      // get request argument name by number
   int args() const;                        // get arguments count
-  bool hasArg(const String& name) const;   // check if argument exists
+  bool hasArg(StringView name) const;      // check if argument exists
   void collectHeaders(const char* headerKeys[], const size_t headerKeysCount); // set the request headers to collect
   template<typename... Args>
   void collectHeaders(const Args&... args); // set the request headers to collect (variadic template version)
   const String& header(const String& name) const; // get request header value by name
+  const String& header(const char* name) const;
+  const String& header(const __FlashStringHelper* name) const;
   const String& header(int i) const;       // get request header value by number
   const String& headerName(int i) const;   // get request header name by number
   int headers() const;                     // get header count
   bool hasHeader(const String& name) const;       // check if header exists
+  bool hasHeader(const char* name) const;
+  bool hasHeader(const __FlashStringHelper* name) const;
   const String& hostHeader() const;        // get request host header if available or empty String if not
 
   // send response to the client
@@ -200,6 +232,12 @@ public:
   void chunkedResponseFinalize () {
     sendContent(emptyString);
   }
+  // Buffered writer for the body once the response header is sent, normally
+  // after chunkedResponseModeStart(). It must be flushed or destroyed before
+  // chunkedResponseFinalize().
+  ChunkedPrint chunkedWriter () {
+    return ChunkedPrint(_currentMethod == HTTP_HEAD ? nullptr : &_currentClient, _chunked);
+  }
 
   // Whether other requests should be accepted from the client on the
   // same socket after a response is sent.
@@ -208,6 +246,11 @@ public:
   // If the client sends the "Connection" header, the value given by the header is used.
   void keepAlive(bool keepAlive) { _keepAlive = keepAlive; }
   bool keepAlive() { return _keepAlive; }
+  // How long a kept alive connection may stay idle between two requests
+  // (default HTTP_MAX_CLOSE_WAIT ms), and how many requests it may carry
+  // before the server asks to close it (default 0, no limit).
+  void setKeepAliveTimeout(uint32_t ms) { _keepAliveTimeout = ms; }
+  void setKeepAliveMaxRequests(uint16_t count) { _keepAliveMaxRequests = count; }
 
   static String credentialHash(const String& username, const String& realm, const String& password);
 
@@ -272,18 +315,31 @@ public:
   }
 
 protected:
+  friend WebSocketType;
+  friend EventSourceType;
+
   void _addRequestHandler(RequestHandlerType* handler);
+  void _buildRouteIndex();
+  RequestHandlerType* _findHandler(HTTPMethod method, const String& uri);
+  bool _handleCurrentClient();
+  bool _hasFreeSlot() const;
   void _handleRequest();
+  bool _handleCached(ResponseCache& cache);
+  void _sendCached(const ResponseCache::Entry& entry);
   void _finalizeResponse();
+  bool _readRequestHead(ClientType& client);
+  void _clearRequestHead();
   ClientFuture _parseRequest(ClientType& client);
   void _parseArguments(const String& data);
   int _parseArgumentsPrivate(const String& data, std::function<void(String&,String&,const String&,int,int,int,int)> handler);
   bool _parseForm(ClientType& client, const String& boundary, uint32_t len);
   bool _parseFormUploadAborted();
-  void _uploadWriteByte(uint8_t b);
-  int _uploadReadByte(ClientType& client);
+  void _uploadSend(size_t len);
+  bool _uploadReadFile(ClientType& client, const String& boundary);
   void _prepareHeader(String& response, int code, const char* content_type, size_t contentLength);
   bool _collectHeader(const char* headerName, const char* headerValue);
+  void _hashHeaderKeys();
+  int _headerIndex(PGM_P name) const;
 
   void _streamFileCore(const size_t fileSize, const String & fileName, const String & contentType);
 
@@ -296,17 +352,49 @@ protected:
     String value;
   };
 
+  // state of a connection that is not the current one, see _swapSlot()
+  struct ClientSlot {
+    ClientType       client;
+    HTTPClientStatus status = HC_NONE;
+    unsigned long    statusChange = 0;
+    bool             keepAlive = false;
+    uint16_t         requestCount = 0;
+    String           head;
+    uint8_t          headMatch = 0;
+    bool             headLineDone = false;
+    ClientFuture     headFuture = CLIENT_REQUEST_CAN_CONTINUE;
+  };
+  void _swapSlot(ClientSlot& slot);
+
+  // handler with its position in the _firstHandler list, so that lookups
+  // through the index still pick the first registered handler that matches
+  struct RouteEntry {
+    const String* uri;
+    RequestHandlerType* handler;
+    size_t order;
+  };
+
   ServerType  _server;
   ClientType  _currentClient;
   HTTPMethod  _currentMethod = HTTP_ANY;
   String      _currentUri;
+  String      _head;               // request line and headers received so far
+  uint8_t     _headMatch = 0;      // how much of "\r\n\r\n" was just seen
+  bool        _headLineDone = false;
+  ClientFuture _headFuture = CLIENT_REQUEST_CAN_CONTINUE;
   uint8_t     _currentVersion = 0;
   HTTPClientStatus _currentStatus = HC_NONE;
   unsigned long _statusChange = 0;
+  std::unique_ptr<ClientSlot[]> _slots; // _maxClients - 1 other connections
+  uint8_t     _maxClients = 1;
+  uint8_t     _nextSlot = 0;
 
   RequestHandlerType*  _currentHandler = nullptr;
   RequestHandlerType*  _firstHandler = nullptr;
   RequestHandlerType*  _lastHandler = nullptr;
+  std::vector<RouteEntry> _exactRoutes;   // sorted by uri, then order
+  std::vector<RouteEntry> _patternRoutes; // sorted by order
+  bool             _routeIndexValid = false;
   THandlerFunction _notFoundHandler;
   THandlerFunction _fileUploadHandler;
 
@@ -319,14 +407,23 @@ protected:
 
   int              _headerKeysCount = 0;
   RequestArgument* _currentHeaders = nullptr;
+  std::unique_ptr<uint32_t[]> _headerHashes; // case-insensitive hash of each key
 
   size_t           _contentLength = 0;
   String           _responseHeaders;
 
   String           _hostHeader;
+  String           _webSocketKey;    // Sec-WebSocket-Key of the request, see WebSocketHandler
+  bool             _clientGiven = false; // connection kept by the handler, see EventSourceRequestHandler
+  std::vector<WebSocketType*> _webSockets;
+  ResponseCache*   _cacheFill = nullptr; // the response sent goes there
+  String           _cacheKey;
   bool             _chunked = false;
   bool             _corsEnabled = false;
   bool             _keepAlive = false;
+  uint16_t         _requestCount = 0; // requests received on the current connection
+  uint16_t         _keepAliveMaxRequests = 0;
+  uint32_t         _keepAliveTimeout = HTTP_MAX_CLOSE_WAIT;
 
   String           _snonce;  // Store noance and opaque for future comparison
   String           _sopaque;
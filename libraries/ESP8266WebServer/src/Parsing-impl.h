@@ -41,58 +41,186 @@ static bool readBytesWithTimeout(typename ServerType::ClientType& client, size_t
   return client.sendSize(dataStream, maxLength, timeout_ms) == maxLength;
 }
 
+// case-insensitive compare of len chars of a header name or value with a PROGMEM string
+static inline bool equalsIgnoreCase_P(const char* str, size_t len, PGM_P pstr)
+{
+  for (; len; --len, ++str, ++pstr) {
+    char c = pgm_read_byte(pstr);
+    if (!c || tolower(*str) != tolower(c))
+      return false;
+  }
+  return !pgm_read_byte(pstr);
+}
+
+static inline bool equalsIgnoreCase_P(const char* str, PGM_P pstr)
+{
+  return equalsIgnoreCase_P(str, strlen(str), pstr);
+}
+
+// whether a comma separated header value like "keep-alive, Upgrade" holds token
+static inline bool hasToken_P(const char* value, PGM_P token)
+{
+  while (*value) {
+    while (*value == ' ' || *value == '\t' || *value == ',')
+      ++value;
+    const char* end = value;
+    while (*end && *end != ',')
+      ++end;
+    const char* last = end;
+    while (last > value && (last[-1] == ' ' || last[-1] == '\t'))
+      --last;
+    if (last > value && equalsIgnoreCase_P(value, last - value, token))
+      return true;
+    value = end;
+  }
+  return false;
+}
+
+// case-insensitive FNV-1a hash of a header name, in RAM or PROGMEM
+static inline uint32_t headerHash_P(PGM_P name)
+{
+  uint32_t hash = 2166136261u;
+  for (char c; (c = pgm_read_byte(name)); ++name)
+    hash = (hash ^ (uint8_t)tolower(c)) * 16777619u;
+  return hash;
+}
+
+static inline bool startsWith_P(const char* str, PGM_P prefix)
+{
+  return strncmp_P(str, prefix, strlen_P(prefix)) == 0;
+}
+
+template <typename ServerType>
+void ESP8266WebServerTemplate<ServerType>::_clearRequestHead() {
+  // keeps the buffer for the next request of a keep-alive connection
+  _head.clear();
+  _headMatch = 0;
+  _headLineDone = false;
+  _headFuture = CLIENT_REQUEST_CAN_CONTINUE;
+}
+
+template <typename ServerType>
+bool ESP8266WebServerTemplate<ServerType>::_readRequestHead(ClientType& client) {
+  // Collect the request line and headers as they arrive, up to and including
+  // the blank line, so that the body is left in the client for _parseRequest().
+  // Returns false while more data is needed: handleClient() resumes here on
+  // its next call instead of blocking on a slow client.
+  static const char endOfHead[] = "\r\n\r\n";
+  while (_headMatch < 4) {
+    const char* data;
+    size_t avail;
+    char c[1];
+    bool peek = client.hasPeekBufferAPI();
+    if (peek) {
+      avail = client.peekAvailable();
+      data = client.peekBuffer();
+    } else {
+      int r = client.available() ? client.read() : -1;
+      avail = r < 0 ? 0 : 1;
+      c[0] = r;
+      data = c;
+    }
+    if (!avail)
+      return false;
+
+    size_t take = 0;
+    while (take < avail && _headMatch < 4) {
+      char ch = data[take++];
+      if (ch == endOfHead[_headMatch])
+        _headMatch++;
+      else
+        _headMatch = (ch == '\r');
+      if (_headMatch == 2 && !_headLineDone)
+        break; // give the hook a chance before any header is consumed
+    }
+
+    if (_head.length() + take > HTTP_MAX_HEAD_SIZE) {
+      DBGWS("request head too long\n");
+      _headFuture = CLIENT_MUST_STOP;
+      return true;
+    }
+    _head.reserve((_head.length() + take + 127) & ~127);
+    _head.concat(data, take);
+    if (peek)
+      client.peekConsume(take);
+
+    if (_headMatch == 2 && !_headLineDone) {
+      _headLineDone = true;
+      DBGWS("request: %s", _head.c_str());
+
+      // First line of HTTP request looks like "GET /path HTTP/1.1"
+      // Retrieve the "/path" part by finding the spaces
+      const char* line = _head.c_str();
+      const char* addr_start = strchr(line, ' ');
+      const char* addr_end = addr_start ? strchr(addr_start + 1, ' ') : nullptr;
+      if (!addr_end) {
+        DBGWS("Invalid request\n");
+        _headFuture = CLIENT_MUST_STOP;
+        return true;
+      }
+
+      if (_hook) {
+        const char* search = (const char*)memchr(addr_start + 1, '?', addr_end - addr_start - 1);
+        String methodStr, url;
+        methodStr.concat(line, addr_start - line);
+        url.concat(addr_start + 1, (search ? search : addr_end) - addr_start - 1);
+        _currentUri = url;
+        _chunked = false;
+        _headFuture = _hook(methodStr, url, &client, mime::getContentType);
+        if (_headFuture != CLIENT_REQUEST_CAN_CONTINUE)
+          return true;
+      }
+    }
+  }
+  return true;
+}
+
 template <typename ServerType>
 typename ESP8266WebServerTemplate<ServerType>::ClientFuture ESP8266WebServerTemplate<ServerType>::_parseRequest(ClientType& client) {
-  // Read the first line of HTTP request
-  String req = client.readStringUntil('\r');
-  DBGWS("request: %s\n", req.c_str());
-  client.readStringUntil('\n');
+  if (_headFuture != CLIENT_REQUEST_CAN_CONTINUE)
+    return _headFuture;
+
   //reset header value
   for (int i = 0; i < _headerKeysCount; ++i) {
     _currentHeaders[i].value.clear();
    }
 
-  // First line of HTTP request looks like "GET /path HTTP/1.1"
-  // Retrieve the "/path" part by finding the spaces
-  int addr_start = req.indexOf(' ');
-  int addr_end = req.indexOf(' ', addr_start + 1);
-  if (addr_start == -1 || addr_end == -1) {
-    DBGWS("Invalid request\n");
-    return CLIENT_MUST_STOP;
-  }
-
-  String methodStr = req.substring(0, addr_start);
-  String url = req.substring(addr_start + 1, addr_end);
-  String versionEnd = req.substring(addr_end + 8);
-  _currentVersion = atoi(versionEnd.c_str());
-  String searchStr;
-  int hasSearch = url.indexOf('?');
-  if (hasSearch != -1){
-    searchStr = url.substring(hasSearch + 1);
-    url = url.substring(0, hasSearch);
+  // The head is complete, split it in place: "\r\n", the spaces of the
+  // request line, '?' and ':' are overwritten by terminating zeros.
+  char* line = _head.begin();
+  char* lineEnd = strstr(line, "\r\n");
+  *lineEnd = 0;
+  char* addr_start = strchr(line, ' ');
+  char* addr_end = strchr(addr_start + 1, ' ');
+  *addr_start = 0;
+  *addr_end = 0;
+
+  const char* methodStr = line;
+  char* url = addr_start + 1;
+  const char* versionStr = addr_end + 1;
+  _currentVersion = strlen(versionStr) > 7 ? atoi(versionStr + 7) : 0;
+  const char* searchStr = lineEnd; // empty
+  char* hasSearch = strchr(url, '?');
+  if (hasSearch) {
+    *hasSearch = 0;
+    searchStr = hasSearch + 1;
   }
   _currentUri = url;
   _chunked = false;
-
-  if (_hook)
-  {
-    auto whatNow = _hook(methodStr, url, &client, mime::getContentType);
-    if (whatNow != CLIENT_REQUEST_CAN_CONTINUE)
-        return whatNow;
-  }
+  _webSocketKey.clear();
 
   HTTPMethod method = HTTP_GET;
-  if (methodStr == F("HEAD")) {
+  if (!strcmp_P(methodStr, PSTR("HEAD"))) {
     method = HTTP_HEAD;
-  } else if (methodStr == F("POST")) {
+  } else if (!strcmp_P(methodStr, PSTR("POST"))) {
     method = HTTP_POST;
-  } else if (methodStr == F("DELETE")) {
+  } else if (!strcmp_P(methodStr, PSTR("DELETE"))) {
     method = HTTP_DELETE;
-  } else if (methodStr == F("OPTIONS")) {
+  } else if (!strcmp_P(methodStr, PSTR("OPTIONS"))) {
     method = HTTP_OPTIONS;
-  } else if (methodStr == F("PUT")) {
+  } else if (!strcmp_P(methodStr, PSTR("PUT"))) {
     method = HTTP_PUT;
-  } else if (methodStr == F("PATCH")) {
+  } else if (!strcmp_P(methodStr, PSTR("PATCH"))) {
     method = HTTP_PATCH;
   }
   _currentMethod = method;
@@ -101,62 +229,66 @@ typename ESP8266WebServerTemplate<ServerType>::ClientFuture ESP8266WebServerTemp
                                     // if the protocol version is greater than HTTP 1.0
 
   DBGWS("method: %s url: %s search: %s keepAlive=: %d\n",
-      methodStr.c_str(), url.c_str(), searchStr.c_str(), _keepAlive);
+      methodStr, url, searchStr, _keepAlive);
 
   //attach handler
-  RequestHandlerType* handler;
-  for (handler = _firstHandler; handler; handler = handler->next()) {
-    if (handler->canHandle(_currentMethod, _currentUri))
+  _currentHandler = _findHandler(_currentMethod, _currentUri);
+
+  String boundaryStr;
+  bool isForm = false;
+  bool isEncoded = false;
+  uint32_t contentLength = 0;
+  //parse headers
+  for (char* headerName = lineEnd + 2; ; ) {
+    char* headerEnd = strstr(headerName, "\r\n");
+    if (!headerEnd || headerEnd == headerName) break; //no more headers
+    *headerEnd = 0;
+    char* headerDiv = strchr(headerName, ':');
+    if (!headerDiv) {
       break;
+    }
+    *headerDiv = 0;
+    char* headerValue = headerDiv + 1;
+    while (*headerValue == ' ' || *headerValue == '\t')
+      ++headerValue;
+    for (char* end = headerEnd; end > headerValue && (end[-1] == ' ' || end[-1] == '\t'); )
+      *--end = 0;
+    _collectHeader(headerName, headerValue);
+
+    DBGWS("headerName: %s\nheaderValue: %s\n", headerName, headerValue);
+
+    if (equalsIgnoreCase_P(headerName, Content_Type)){
+      using namespace mime;
+      if (startsWith_P(headerValue, mimeTable[txt].mimeType)){
+        isForm = false;
+      } else if (startsWith_P(headerValue, PSTR("application/x-www-form-urlencoded"))){
+        isForm = false;
+        isEncoded = true;
+      } else if (startsWith_P(headerValue, PSTR("multipart/"))){
+        const char* boundary = strchr(headerValue, '=');
+        boundaryStr = boundary ? boundary + 1 : headerValue;
+        boundaryStr.replace("\"","");
+        isForm = true;
+      }
+    } else if (equalsIgnoreCase_P(headerName, PSTR("Content-Length"))){
+      contentLength = atoi(headerValue);
+    } else if (equalsIgnoreCase_P(headerName, PSTR("Host"))){
+      _hostHeader = headerValue;
+    } else if (equalsIgnoreCase_P(headerName, PSTR("Sec-WebSocket-Key"))){
+      _webSocketKey = headerValue;
+    } else if (equalsIgnoreCase_P(headerName, PSTR("Connection"))){
+      // HTTP/1.1 connections persist unless "close" is given,
+      // HTTP/1.0 ones only when "keep-alive" is
+      if (hasToken_P(headerValue, PSTR("close")))
+        _keepAlive = false;
+      else if (hasToken_P(headerValue, PSTR("keep-alive")))
+        _keepAlive = true;
+    }
+    headerName = headerEnd + 2;
   }
-  _currentHandler = handler;
 
-  String formData;
   // below is needed only when POST type request
   if (method == HTTP_POST || method == HTTP_PUT || method == HTTP_PATCH || method == HTTP_DELETE){
-    String boundaryStr;
-    String headerName;
-    String headerValue;
-    bool isForm = false;
-    bool isEncoded = false;
-    uint32_t contentLength = 0;
-    //parse headers
-    while(1){
-      req = client.readStringUntil('\r');
-      client.readStringUntil('\n');
-      if (req.isEmpty()) break; //no more headers
-      int headerDiv = req.indexOf(':');
-      if (headerDiv == -1){
-        break;
-      }
-      headerName = req.substring(0, headerDiv);
-      headerValue = req.substring(headerDiv + 1);
-      headerValue.trim();
-       _collectHeader(headerName.c_str(),headerValue.c_str());
-
-      DBGWS("headerName: %s\nheaderValue: %s\n", headerName.c_str(), headerValue.c_str());
-
-      if (headerName.equalsIgnoreCase(FPSTR(Content_Type))){
-        using namespace mime;
-        if (headerValue.startsWith(FPSTR(mimeTable[txt].mimeType))){
-          isForm = false;
-        } else if (headerValue.startsWith(F("application/x-www-form-urlencoded"))){
-          isForm = false;
-          isEncoded = true;
-        } else if (headerValue.startsWith(F("multipart/"))){
-          boundaryStr = headerValue.substring(headerValue.indexOf('=') + 1);
-          boundaryStr.replace("\"","");
-          isForm = true;
-        }
-      } else if (headerName.equalsIgnoreCase(F("Content-Length"))){
-        contentLength = headerValue.toInt();
-      } else if (headerName.equalsIgnoreCase(F("Host"))){
-        _hostHeader = headerValue;
-      } else if (headerName.equalsIgnoreCase(F("Connection"))){
-        _keepAlive = headerValue.equalsIgnoreCase(F("keep-alive"));
-      }
-    }
-
     String plainBuf;
     if (   !isForm
         && // read content into plainBuf
@@ -168,16 +300,17 @@ typename ESP8266WebServerTemplate<ServerType>::ClientFuture ESP8266WebServerTemp
         return CLIENT_MUST_STOP;
     }
 
+    String search(searchStr);
     if (isEncoded) {
         // isEncoded => !isForm => plainBuf is not empty
         // add plainBuf in search str
-        if (searchStr.length())
-          searchStr += '&';
-        searchStr += plainBuf;
+        if (search.length())
+          search += '&';
+        search += plainBuf;
     }
 
     // parse searchStr for key/value pairs
-    _parseArguments(searchStr);
+    _parseArguments(search);
 
     if (!isForm) {
       if (contentLength) {
@@ -194,36 +327,13 @@ typename ESP8266WebServerTemplate<ServerType>::ClientFuture ESP8266WebServerTemp
       }
     }
   } else {
-    String headerName;
-    String headerValue;
-    //parse headers
-    while(1){
-      req = client.readStringUntil('\r');
-      client.readStringUntil('\n');
-      if (req.isEmpty()) break;//no moar headers
-      int headerDiv = req.indexOf(':');
-      if (headerDiv == -1){
-        break;
-      }
-      headerName = req.substring(0, headerDiv);
-      headerValue = req.substring(headerDiv + 2);
-      _collectHeader(headerName.c_str(),headerValue.c_str());
-
-      DBGWS("headerName: %s\nheaderValue: %s\n", headerName.c_str(), headerValue.c_str());
-
-      if (headerName.equalsIgnoreCase(F("Host"))){
-        _hostHeader = headerValue;
-      } else if (headerName.equalsIgnoreCase(F("Connection"))){
-        _keepAlive = headerValue.equalsIgnoreCase(F("keep-alive"));
-      }
-    }
     _parseArguments(searchStr);
   }
   client.flush();
 
 #ifdef DEBUG_ESP_HTTP_SERVER
   DBGWS("Request: %s\nArguments: %s\nfinal list of key/value pairs:\n",
-    url.c_str(), searchStr.c_str());
+    url, searchStr);
   for (int i = 0; i < _currentArgCount; i++)
     DBGWS("  key:'%s' value:'%s'\r\n",
       _currentArgs[i].key.c_str(),
@@ -235,13 +345,31 @@ typename ESP8266WebServerTemplate<ServerType>::ClientFuture ESP8266WebServerTemp
 
 template <typename ServerType>
 bool ESP8266WebServerTemplate<ServerType>::_collectHeader(const char* headerName, const char* headerValue) {
+  int i = _headerIndex(headerName);
+  if (i < 0)
+    return false;
+  // values are cleared, not freed, between requests so this reuses their buffer
+  _currentHeaders[i].value = headerValue;
+  return true;
+}
+
+template <typename ServerType>
+void ESP8266WebServerTemplate<ServerType>::_hashHeaderKeys() {
+  _headerHashes.reset(new uint32_t[_headerKeysCount]);
+  for (int i = 0; i < _headerKeysCount; i++)
+    _headerHashes[i] = headerHash_P(_currentHeaders[i].key.c_str());
+}
+
+// index of the collected header called name (RAM or PROGMEM), or -1.
+// keys are only compared when their hash matches, nothing is allocated
+template <typename ServerType>
+int ESP8266WebServerTemplate<ServerType>::_headerIndex(PGM_P name) const {
+  uint32_t hash = headerHash_P(name);
   for (int i = 0; i < _headerKeysCount; i++) {
-    if (_currentHeaders[i].key.equalsIgnoreCase(headerName)) {
-            _currentHeaders[i].value=headerValue;
-            return true;
-        }
+    if (_headerHashes[i] == hash && equalsIgnoreCase_P(_currentHeaders[i].key.c_str(), name))
+      return i;
   }
-  return false;
+  return -1;
 }
 
 template <typename ServerType>
@@ -322,28 +450,90 @@ int ESP8266WebServerTemplate<ServerType>::_parseArgumentsPrivate(const String& d
 }
 
 template <typename ServerType>
-void ESP8266WebServerTemplate<ServerType>::_uploadWriteByte(uint8_t b){
-  if (_currentUpload->currentSize == HTTP_UPLOAD_BUFLEN){
-    if(_currentHandler && _currentHandler->canUpload(_currentUri))
-      _currentHandler->upload(*this, _currentUri, *_currentUpload);
-    _currentUpload->totalSize += _currentUpload->currentSize;
-    _currentUpload->currentSize = 0;
-  }
-  _currentUpload->buf[_currentUpload->currentSize++] = b;
+void ESP8266WebServerTemplate<ServerType>::_uploadSend(size_t len){
+  // hand the first len bytes of buf to the handler, keep the rest
+  size_t keep = _currentUpload->currentSize - len;
+  _currentUpload->currentSize = len;
+  if(_currentHandler && _currentHandler->canUpload(_currentUri))
+    _currentHandler->upload(*this, _currentUri, *_currentUpload);
+  _currentUpload->totalSize += len;
+  memmove(_currentUpload->buf, _currentUpload->buf + len, keep);
+  _currentUpload->currentSize = keep;
 }
 
+// Read file data up to and including the next "\r\n--boundary", passing
+// it to the handler one buf at a time. Data is looked at through the peek
+// buffer before being consumed, so nothing past the boundary is taken from
+// the client, and the boundary is searched with Boyer-Moore-Horspool.
 template <typename ServerType>
-int ESP8266WebServerTemplate<ServerType>::_uploadReadByte(ClientType& client){
-  int res = client.read();
-  if(res == -1){
-    while(!client.available() && client.connected())
+bool ESP8266WebServerTemplate<ServerType>::_uploadReadFile(ClientType& client, const String& boundary){
+  char pattern[4 + boundary.length() + 1];
+  size_t m = snprintf(pattern, sizeof(pattern), "\r\n--%s", boundary.c_str());
+  if (m > 255 || m > HTTP_UPLOAD_BUFLEN / 2) {
+    DBGWS("Error: boundary too long\n");
+    return false;
+  }
+  uint8_t skip[256];
+  memset(skip, m, sizeof(skip));
+  for (size_t i = 0; i < m - 1; i++)
+    skip[(uint8_t)pattern[i]] = m - 1 - i;
+
+  uint8_t* buf = _currentUpload->buf;
+  size_t s = 0; // next position in buf where the pattern may start
+  bool peekAPI = client.hasPeekBufferAPI();
+  while (true) {
+    if (_currentUpload->currentSize == HTTP_UPLOAD_BUFLEN) {
+      // the tail from s on may be the start of the boundary
+      _uploadSend(s);
+      s = 0;
+    }
+
+    const char* data;
+    char c;
+    size_t avail;
+    if (peekAPI) {
+      data = client.peekBuffer();
+      avail = client.peekAvailable();
+    } else {
+      int ret = client.peek();
+      c = ret;
+      data = &c;
+      avail = ret < 0 ? 0 : 1;
+    }
+    if (!avail) {
+      if (!client.connected())
+        return false;
       yield();
-    res = client.read();
+      continue;
+    }
+
+    size_t len = _currentUpload->currentSize;
+    size_t n = std::min(avail, HTTP_UPLOAD_BUFLEN - len);
+    memcpy(buf + len, data, n);
+    size_t end = len + n;
+    while (s + m <= end) {
+      size_t i = m - 1;
+      while (buf[s + i] == (uint8_t)pattern[i])
+        if (i-- == 0) {
+          // found, consume up to the end of the boundary only
+          size_t used = s + m - len;
+          if (peekAPI)
+            client.peekConsume(used);
+          else
+            client.read();
+          _currentUpload->currentSize = s;
+          return true;
+        }
+      s += skip[buf[s + m - 1]];
+    }
+    if (peekAPI)
+      client.peekConsume(n);
+    else
+      client.read();
+    _currentUpload->currentSize = end;
   }
-  return res;
 }
 
-
 template <typename ServerType>
 bool ESP8266WebServerTemplate<ServerType>::_parseForm(ClientType& client, const String& boundary, uint32_t len){
   (void) len;
@@ -430,39 +620,8 @@ bool ESP8266WebServerTemplate<ServerType>::_parseForm(ClientType& client, const
               _currentHandler->upload(*this, _currentUri, *_currentUpload);
             _currentUpload->status = UPLOAD_FILE_WRITE;
 
-            int fastBoundaryLen = 4 /* \r\n-- */ + boundary.length() + 1 /* \0 */;
-            char fastBoundary[ fastBoundaryLen ];
-            snprintf(fastBoundary, fastBoundaryLen, "\r\n--%s", boundary.c_str());
-            int boundaryPtr = 0;
-            while ( true ) {
-                int ret = _uploadReadByte(client);
-                if (ret < 0) {
-                    // Unexpected, we should have had data available per above
-                    return _parseFormUploadAborted();
-                }
-                char in = (char) ret;
-                if (in == fastBoundary[ boundaryPtr ]) {
-                    // The input matched the current expected character, advance and possibly exit this file
-                    boundaryPtr++;
-                    if (boundaryPtr == fastBoundaryLen - 1) {
-                        // We read the whole boundary line, we're done here!
-                        break;
-                    }
-                } else {
-                    // The char doesn't match what we want, so dump whatever matches we had, the read in char, and reset ptr to start
-                    for (int i = 0; i < boundaryPtr; i++) {
-                        _uploadWriteByte( fastBoundary[ i ] );
-                    }
-                    if (in == fastBoundary[ 0 ]) {
-                       // This could be the start of the real end, mark it so and don't emit/skip it
-                       boundaryPtr = 1;
-                    } else {
-                      // Not the 1st char of our pattern, so emit and ignore
-                      _uploadWriteByte( in );
-                      boundaryPtr = 0;
-                    }
-                }
-            }
+            if (!_uploadReadFile(client, boundary))
+                return _parseFormUploadAborted();
             // Found the boundary string, finish processing this file upload
             if (_currentHandler && _currentHandler->canUpload(_currentUri))
                 _currentHandler->upload(*this, _currentUri, *_currentUpload);
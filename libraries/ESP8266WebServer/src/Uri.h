@@ -22,6 +22,14 @@ class Uri {
         virtual bool canHandle(const String &requestUri, __attribute__((unused)) std::vector<String> &pathArgs) {
             return _uri == requestUri;
         }
+
+        // The one request uri this matches, or nullptr when canHandle() does
+        // pattern matching. Exact uris are looked up in the server's sorted
+        // route index instead of being tried one by one.
+        // Subclasses overriding canHandle() must also override this.
+        virtual const String* exactUri() const {
+            return &_uri;
+        }
 };
 
 #endif
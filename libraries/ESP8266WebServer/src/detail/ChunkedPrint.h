@@ -0,0 +1,90 @@
+#ifndef CHUNKEDPRINT_H
+#define CHUNKEDPRINT_H
+
+#include <Arduino.h>
+#include <memory>
+
+namespace esp8266webserver {
+
+// Print for the body of a chunked response. Output is gathered in one
+// buffer, and every full buffer goes out as a complete chunk (size line,
+// data, CRLF) in a single write, instead of many tiny segments.
+// Without chunked encoding (HTTP/1.0) data is just buffered, and with no
+// output (HEAD requests) it is dropped. Flushed when destroyed.
+class ChunkedPrint : public Print {
+public:
+    // room before the data for the size line, "ffff\r\n"
+    static constexpr size_t headerSize = 6;
+
+    ChunkedPrint(Print* out, bool chunked, size_t size = HTTP_DOWNLOAD_UNIT_SIZE - headerSize - 2)
+    : _out(out)
+    , _chunked(chunked)
+    , _size(std::min(size, (size_t)0xffff))
+    {
+        if (_out)
+            _buf.reset(new (std::nothrow) char[headerSize + _size + 2]);
+    }
+
+    ChunkedPrint(const ChunkedPrint&) = delete;
+    ChunkedPrint& operator=(const ChunkedPrint&) = delete;
+
+    ~ChunkedPrint() {
+        flush();
+    }
+
+    size_t write(uint8_t c) override {
+        return write(&c, 1);
+    }
+
+    size_t write(const uint8_t* data, size_t size) override {
+        if (!_out)
+            return size;
+        if (!_buf)
+            return 0;
+        size_t done = 0;
+        while (done < size) {
+            if (_len == _size)
+                flush();
+            size_t n = std::min(size - done, _size - _len);
+            memcpy(_buf.get() + headerSize + _len, data + done, n);
+            _len += n;
+            done += n;
+        }
+        return done;
+    }
+
+    int availableForWrite() override {
+        return _size - _len;
+    }
+
+    // send what is buffered, as one chunk
+    void flush() override {
+        if (!_out || !_len)
+            return;
+        char* start = _buf.get() + headerSize;
+        size_t total = _len;
+        if (_chunked) {
+            char line[headerSize + 1];
+            int n = snprintf_P(line, sizeof(line), PSTR("%x\r\n"), (unsigned)_len);
+            start -= n;
+            memcpy(start, line, n);
+            memcpy(start + n + _len, "\r\n", 2);
+            total += n + 2;
+        }
+        size_t sent = _out->write(start, total);
+        if (sent != total)
+            DBGWS("ChunkedPrint: short write (%u<%u)\n", (unsigned)sent, (unsigned)total);
+        _len = 0;
+    }
+
+protected:
+    Print* _out;
+    bool _chunked;
+    size_t _size;
+    size_t _len = 0;
+    std::unique_ptr<char[]> _buf;
+};
+
+} // namespace
+
+#endif //CHUNKEDPRINT_H
@@ -3,7 +3,9 @@
 
 #include <ESP8266WebServer.h>
 #include <vector>
+#include <memory>
 #include <assert.h>
+#include "ResponseCache.h"
 
 namespace esp8266webserver {
 
@@ -16,12 +18,26 @@ public:
     virtual bool canUpload(const String& uri) { (void) uri; return false; }
     virtual bool handle(WebServerType& server, HTTPMethod requestMethod, const String& requestUri) { (void) server; (void) requestMethod; (void) requestUri; return false; }
     virtual void upload(WebServerType& server, const String& requestUri, HTTPUpload& upload) { (void) server; (void) requestUri; (void) upload; }
+    // uri this handler is limited to, or nullptr when canHandle() must be asked
+    virtual const String* exactUri() const { return nullptr; }
 
     RequestHandler<ServerType>* next() { return _next; }
     void next(RequestHandler<ServerType>* r) { _next = r; }
 
+    // Keep the 200 responses this handler sends with send() to GET requests,
+    // for ttl ms (0: until invalidate()), up to entries of them told apart
+    // by the values of the args named. They get an ETag, and HEAD requests
+    // are answered from them too.
+    RequestHandler<ServerType>& cache(uint32_t ttl, std::vector<String> args = {}, uint8_t entries = 4) {
+        _cache.reset(new ResponseCache(ttl, std::move(args), entries));
+        return *this;
+    }
+    void invalidate() { if (_cache) _cache->invalidate(); }
+    ResponseCache* responseCache() { return _cache.get(); }
+
 private:
     RequestHandler<ServerType>* _next = nullptr;
+    std::unique_ptr<ResponseCache> _cache;
 	
 protected:
     std::vector<String> pathArgs;
@@ -6,6 +6,8 @@
 #include "mimetable.h"
 #include "WString.h"
 #include "Uri.h"
+#include <vector>
+#include <algorithm>
 
 namespace esp8266webserver {
 
@@ -32,6 +34,10 @@ public:
         return _uri->canHandle(requestUri, RequestHandler<ServerType>::pathArgs);
     }
 
+    const String* exactUri() const override {
+        return _uri->exactUri();
+    }
+
     bool canUpload(const String& requestUri) override  {
         if (!_ufn || !canHandle(HTTP_POST, requestUri))
             return false;
@@ -62,6 +68,130 @@ protected:
     HTTPMethod _method;
 };
 
+#ifndef EVENTSOURCE_MAX_CLIENTS
+#define EVENTSOURCE_MAX_CLIENTS 4 // subscribers per event source
+#endif
+
+// Server-Sent Events: a GET request subscribes, and its connection is kept
+// open by this handler after the response header. send() formats an event
+// once, in a buffer shared by all subscribers, and writes it to each one.
+template<typename ServerType>
+class EventSourceRequestHandler : public RequestHandler<ServerType> {
+    using WebServerType = ESP8266WebServerTemplate<ServerType>;
+    using ClientType = typename ServerType::ClientType;
+public:
+    EventSourceRequestHandler(const Uri &uri)
+    : _uri(uri.clone())
+    {
+    }
+
+    ~EventSourceRequestHandler() {
+        delete _uri;
+    }
+
+    bool canHandle(HTTPMethod requestMethod, const String& requestUri) override {
+        if (requestMethod != HTTP_GET)
+            return false;
+
+        return _uri->canHandle(requestUri, RequestHandler<ServerType>::pathArgs);
+    }
+
+    const String* exactUri() const override {
+        return _uri->exactUri();
+    }
+
+    bool handle(WebServerType& server, HTTPMethod requestMethod, const String& requestUri) override {
+        if (!canHandle(requestMethod, requestUri))
+            return false;
+
+        ClientType* slot = nullptr;
+        for (ClientType& client : _clients) {
+            if (!client.connected()) {
+                slot = &client;
+                break;
+            }
+        }
+        if (!slot) {
+            server.send(503, F("text/plain"), F("Too many subscribers"));
+            return true;
+        }
+
+        static const char header[] PROGMEM =
+            "HTTP/1.1 200 OK\r\n"
+            "Content-Type: text/event-stream\r\n"
+            "Cache-Control: no-cache\r\n"
+            "Connection: keep-alive\r\n"
+            "\r\n";
+        if (server.client().write_P(header, sizeof(header) - 1) != sizeof(header) - 1)
+            return true;
+        *slot = server.client();
+        slot->setNoDelay(true);
+        server._clientGiven = true;
+        return true;
+    }
+
+    // one event to every subscriber, data may hold several lines
+    // event and id are optional, returns how many subscribers got it
+    uint8_t send(const char* data, const char* event = nullptr, const char* id = nullptr) {
+        _event.clear();
+        if (event) {
+            _event += F("event: ");
+            _event += event;
+            _event += '\n';
+        }
+        if (id) {
+            _event += F("id: ");
+            _event += id;
+            _event += '\n';
+        }
+        for (const char* line = data; ; ) {
+            const char* end = strchr(line, '\n');
+            _event += F("data: ");
+            _event.concat(line, end ? end - line : strlen(line));
+            _event += '\n';
+            if (!end)
+                break;
+            line = end + 1;
+        }
+        _event += '\n';
+        return _write(_event.c_str(), _event.length());
+    }
+
+    uint8_t send(const String& data, const char* event = nullptr, const char* id = nullptr) {
+        return send(data.c_str(), event, id);
+    }
+
+    // a comment, ignored by browsers, to keep idle connections open
+    uint8_t keepAlive() {
+        return _write(":\n\n", 3);
+    }
+
+    uint8_t subscribers() {
+        uint8_t count = 0;
+        for (ClientType& client : _clients)
+            count += client.connected();
+        return count;
+    }
+
+protected:
+    uint8_t _write(const char* data, size_t length) {
+        uint8_t count = 0;
+        for (ClientType& client : _clients) {
+            if (!client.connected())
+                continue;
+            if (client.write((const uint8_t*)data, length) == length)
+                count++;
+            else
+                client.stop();
+        }
+        return count;
+    }
+
+    Uri *_uri;
+    ClientType _clients[EVENTSOURCE_MAX_CLIENTS];
+    String _event; // the formatted event, kept for its capacity
+};
+
 template<typename ServerType>
 class StaticRequestHandler : public RequestHandler<ServerType> {
     using WebServerType = ESP8266WebServerTemplate<ServerType>;
@@ -84,6 +214,24 @@ public:
         return mime::getContentType(path);
     }
 
+    // strong validator for a file: size, and its modification time
+    // or when not available part of its MD5
+    static String makeETag(uint32_t size, uint32_t tag) {
+        char etag[20];
+        snprintf_P(etag, sizeof(etag), PSTR("\"%x-%x\""), (unsigned)size, (unsigned)tag);
+        return String(etag);
+    }
+
+    static uint32_t contentTag(File& f) {
+        MD5Builder calcMD5;
+        uint8_t md5[16];
+        calcMD5.begin();
+        calcMD5.addStream(f, f.size());
+        calcMD5.calculate();
+        calcMD5.getBytes(md5);
+        return md5[0] | (md5[1] << 8) | (md5[2] << 16) | ((uint32_t)md5[3] << 24);
+    }
+
 protected:
     FS _fs;
     String _uri;
@@ -103,7 +251,15 @@ public:
         :
     SRH(fs, path, uri, cache_header),
     _baseUriLength{SRH::_uri.length()}
-    {}
+    {
+        // Files present now are indexed so that requests for them need
+        // no exists() lookup, and a matching If-None-Match no flash access.
+        // Files written later are still found on the filesystem.
+        _indexDir(SRH::_path);
+        std::sort(_index.begin(), _index.end(),
+            [](const IndexEntry& a, const IndexEntry& b) { return strcmp(a.name.c_str(), b.name.c_str()) < 0; });
+        _index.shrink_to_fit();
+    }
 
     bool canHandle(HTTPMethod requestMethod, const String& requestUri) override {
         return SRH::validMethod(requestMethod) && requestUri.startsWith(SRH::_uri);
@@ -130,7 +286,7 @@ public:
 
         // If neither <blah> nor <blah>.gz exist, and <blah> is a file.htm, try it with file.html instead
         // For the normal case this will give a search order of index.htm, index.htm.gz, index.html, index.html.gz
-        if (!SRH::_fs.exists(path) && !SRH::_fs.exists(path + ".gz") && path.endsWith(".htm")) {
+        if (!_exists(path) && !_exists(path + ".gz") && path.endsWith(".htm")) {
             path += 'l';
         }
 
@@ -141,12 +297,21 @@ public:
         using namespace mime;
         // look for gz file, only if the original specified path is not a gz.  So part only works to send gzip via content encoding when a non compressed is asked for
         // if you point the the path to gzip you will serve the gzip as content type "application/x-gzip", not text or javascript etc...
-        if (!path.endsWith(FPSTR(mimeTable[gz].endsWith)) && !SRH::_fs.exists(path))  {
+        if (!path.endsWith(FPSTR(mimeTable[gz].endsWith)) && !_exists(path))  {
             String pathWithGz = path + FPSTR(mimeTable[gz].endsWith);
-            if(SRH::_fs.exists(pathWithGz))
+            if(_exists(pathWithGz))
                 path += FPSTR(mimeTable[gz].endsWith);
         }
 
+        IndexEntry* entry = _find(path);
+        if (entry && server.header("If-None-Match") == SRH::makeETag(entry->size, entry->tag)) {
+            if (SRH::_cache_header.length() != 0)
+                server.sendHeader("Cache-Control", SRH::_cache_header);
+            server.sendHeader("ETag", SRH::makeETag(entry->size, entry->tag));
+            server.send(304);
+            return true;
+        }
+
         File f = SRH::_fs.open(path, "r");
         if (!f)
             return false;
@@ -159,12 +324,74 @@ public:
         if (SRH::_cache_header.length() != 0)
             server.sendHeader("Cache-Control", SRH::_cache_header);
 
+        if (entry) {
+            if (entry->size != f.size()) {
+                // rewritten since indexed
+                entry->size = f.size();
+                entry->tag = (uint32_t)f.getLastWrite();
+                if (!entry->tag) {
+                    entry->tag = SRH::contentTag(f);
+                    f.seek(0);
+                }
+            }
+            server.sendHeader("ETag", SRH::makeETag(entry->size, entry->tag));
+        }
+
         server.streamFile(f, contentType, requestMethod);
         return true;
     }
 
 protected:
+    struct IndexEntry {
+        String name;  // path below SRH::_path
+        uint32_t size;
+        uint32_t tag; // see makeETag()
+    };
+
+    void _indexDir(const String& dir) {
+        Dir d = SRH::_fs.openDir(dir);
+        while (d.next()) {
+            // SPIFFS has no directories and gives full names, other
+            // filesystems give names relative to the listed directory
+            String path = d.fileName();
+            if (!path.startsWith("/")) {
+                String name = path;
+                path = dir;
+                if (!path.endsWith("/"))
+                    path += '/';
+                path += name;
+            }
+            if (d.isDirectory()) {
+                _indexDir(path);
+                continue;
+            }
+            if (!path.startsWith(SRH::_path))
+                continue;
+
+            uint32_t tag = (uint32_t)d.fileTime();
+            if (!tag) {
+                File f = d.openFile("r");
+                tag = SRH::contentTag(f);
+            }
+            _index.push_back({path.substring(SRH::_path.length()), (uint32_t)d.fileSize(), tag});
+        }
+    }
+
+    IndexEntry* _find(const String& path) {
+        if (!path.startsWith(SRH::_path))
+            return nullptr;
+        const char* name = path.c_str() + SRH::_path.length();
+        auto it = std::lower_bound(_index.begin(), _index.end(), name,
+            [](const IndexEntry& e, const char* n) { return strcmp(e.name.c_str(), n) < 0; });
+        return (it != _index.end() && it->name == name) ? &*it : nullptr;
+    }
+
+    bool _exists(const String& path) {
+        return _find(path) || SRH::_fs.exists(path);
+    }
+
     size_t _baseUriLength;
+    std::vector<IndexEntry> _index; // sorted by name
 };
 
 template<typename ServerType>
@@ -187,6 +414,11 @@ public:
         calcMD5.calculate();
         calcMD5.getBytes(_ETag_md5);
         f.close();
+        char etag[1 + 24 + 1 + 1] = "\"";
+        const size_t len = base64::encode(_ETag_md5, 16, etag + 1);
+        etag[len + 1] = '"';
+        etag[len + 2] = '\0';
+        _ETag = etag;
     }
 
     bool canHandle(HTTPMethod requestMethod, const String& requestUri) override  {
@@ -197,9 +429,10 @@ public:
         if (!canHandle(requestMethod, requestUri))
             return false;
 
-        const String etag = "\"" + base64::encode(_ETag_md5, 16, false) + "\"";
-
-        if(server.header("If-None-Match") == etag){
+        if(server.header("If-None-Match") == _ETag){
+            if (SRH::_cache_header.length() != 0)
+                server.sendHeader("Cache-Control", SRH::_cache_header);
+            server.sendHeader("ETag", _ETag);
             server.send(304);
             return true;
         }
@@ -217,14 +450,15 @@ public:
         if (SRH::_cache_header.length() != 0)
             server.sendHeader("Cache-Control", SRH::_cache_header);
 
-        server.sendHeader("ETag", etag);
+        server.sendHeader("ETag", _ETag);
 
         server.streamFile(f, mime::getContentType(SRH::_path), requestMethod);
         return true;
     }
 
 protected:
-    uint8_t _ETag_md5[16];       
+    uint8_t _ETag_md5[16];
+    String _ETag;
 };
 
 } // namespace
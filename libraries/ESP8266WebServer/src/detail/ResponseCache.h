@@ -0,0 +1,78 @@
+#ifndef RESPONSECACHE_H
+#define RESPONSECACHE_H
+
+#include <Arduino.h>
+#include <vector>
+
+namespace esp8266webserver {
+
+// Responses of one route kept for its GET requests, see RequestHandler::cache().
+// A response is found again by method, uri and the values of the chosen
+// arguments, until it expires or the route is invalidated.
+class ResponseCache {
+public:
+    struct Entry {
+        String key;
+        String contentType;
+        String headers;      // sent by the handler with sendHeader()
+        String body;
+        String etag;
+        unsigned long stored = 0;
+    };
+
+    ResponseCache(uint32_t ttl, std::vector<String>&& args, uint8_t maxEntries)
+    : _ttl(ttl)
+    , _args(std::move(args))
+    , _maxEntries(maxEntries ? maxEntries : 1)
+    {
+    }
+
+    const std::vector<String>& args() const {
+        return _args;
+    }
+
+    // the fresh entry for key, or nullptr
+    Entry* find(const String& key) {
+        for (auto it = _entries.begin(); it != _entries.end(); ++it) {
+            if (it->key != key)
+                continue;
+            if (_ttl && millis() - it->stored > _ttl) {
+                _entries.erase(it);
+                return nullptr;
+            }
+            return &*it;
+        }
+        return nullptr;
+    }
+
+    // a new entry for key, in place of the oldest one when full
+    Entry& store(const String& key) {
+        if (_entries.size() >= _maxEntries) {
+            auto oldest = _entries.begin();
+            for (auto it = _entries.begin(); it != _entries.end(); ++it) {
+                if (it->stored - oldest->stored > (unsigned long)-1 / 2)
+                    oldest = it;
+            }
+            _entries.erase(oldest);
+        }
+        _entries.emplace_back();
+        Entry& entry = _entries.back();
+        entry.key = key;
+        entry.stored = millis();
+        return entry;
+    }
+
+    void invalidate() {
+        _entries.clear();
+    }
+
+protected:
+    uint32_t _ttl; // ms, 0: until invalidated
+    std::vector<String> _args;
+    uint8_t _maxEntries;
+    std::vector<Entry> _entries;
+};
+
+} // namespace
+
+#endif //RESPONSECACHE_H
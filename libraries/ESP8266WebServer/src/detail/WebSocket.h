@@ -0,0 +1,385 @@
+#ifndef WEBSOCKET_H
+#define WEBSOCKET_H
+
+#include <ESP8266WebServer.h>
+#include <base64.h>
+#include <bearssl/bearssl_hash.h>
+#include <memory>
+#include "RequestHandler.h"
+#include "Uri.h"
+
+#ifndef WEBSOCKET_MAX_CLIENTS
+#define WEBSOCKET_MAX_CLIENTS 4 // connections per endpoint
+#endif
+
+#ifndef WEBSOCKET_MAX_MESSAGE
+#define WEBSOCKET_MAX_MESSAGE 1024 // largest message assembled from fragments
+#endif
+
+namespace esp8266webserver {
+
+// WebSocket endpoint (RFC 6455), see ESP8266WebServerTemplate::onWebSocket().
+// The upgrade is an ordinary GET request, after which the connection is
+// taken from the web server and read by handleClient() through this handler.
+// A frame received whole in the client's buffer is unmasked in place and
+// given to the callback from there. Only fragmented messages, or frames
+// split between received segments, are assembled in a buffer.
+template<typename ServerType>
+class WebSocketHandler : public RequestHandler<ServerType> {
+    using WebServerType = ESP8266WebServerTemplate<ServerType>;
+    using ClientType = typename ServerType::ClientType;
+public:
+    WebSocketHandler(const Uri &uri, typename WebServerType::TWebSocketFunction fn)
+    : _fn(fn)
+    , _uri(uri.clone())
+    {
+    }
+
+    ~WebSocketHandler() {
+        delete _uri;
+    }
+
+    bool canHandle(HTTPMethod requestMethod, const String& requestUri) override {
+        if (requestMethod != HTTP_GET)
+            return false;
+
+        return _uri->canHandle(requestUri, RequestHandler<ServerType>::pathArgs);
+    }
+
+    const String* exactUri() const override {
+        return _uri->exactUri();
+    }
+
+    bool handle(WebServerType& server, HTTPMethod requestMethod, const String& requestUri) override {
+        if (!canHandle(requestMethod, requestUri))
+            return false;
+
+        if (server._webSocketKey.isEmpty()) {
+            server.sendHeader(F("Upgrade"), F("websocket"));
+            server.send(426, F("text/plain"), F("WebSocket upgrade expected"));
+            return true;
+        }
+        int num = 0;
+        while (num < WEBSOCKET_MAX_CLIENTS && _conns[num].open)
+            num++;
+        if (num == WEBSOCKET_MAX_CLIENTS) {
+            server.send(503, F("text/plain"), F("Too many WebSocket clients"));
+            return true;
+        }
+
+        // Sec-WebSocket-Accept: base64(SHA-1(key + GUID)), the GUID in RAM for br_sha1
+        static const char guid[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+        br_sha1_context sha1;
+        uint8_t hash[br_sha1_SIZE];
+        br_sha1_init(&sha1);
+        br_sha1_update(&sha1, server._webSocketKey.c_str(), server._webSocketKey.length());
+        br_sha1_update(&sha1, guid, sizeof(guid) - 1);
+        br_sha1_out(&sha1, hash);
+        char accept[29];
+        base64::encode(hash, sizeof(hash), accept);
+
+        char response[160];
+        int len = snprintf_P(response, sizeof(response),
+            PSTR("HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Accept: %s\r\n\r\n"),
+            accept);
+        if (server.client().write((const uint8_t*)response, len) != (size_t)len)
+            return true;
+
+        Connection& c = _conns[num];
+        c = Connection();
+        c.client = server.client();
+        c.client.setNoDelay(true);
+        c.open = true;
+        server._clientGiven = true;
+        DBGWS("websocket %d: connected\n", num);
+        _fn(num, WS_CONNECTED, (const uint8_t*)requestUri.c_str(), requestUri.length());
+        return true;
+    }
+
+    // reads what the clients sent and calls back, from handleClient()
+    bool loop() {
+        bool busy = false;
+        for (uint8_t num = 0; num < WEBSOCKET_MAX_CLIENTS; num++) {
+            if (_conns[num].open)
+                busy |= _poll(num);
+        }
+        return busy;
+    }
+
+    bool sendText(uint8_t num, const char* text, size_t length) {
+        return _sendFrame(num, OP_TEXT, (const uint8_t*)text, length);
+    }
+    bool sendText(uint8_t num, const char* text) {
+        return sendText(num, text, strlen(text));
+    }
+    bool sendText(uint8_t num, const String& text) {
+        return sendText(num, text.c_str(), text.length());
+    }
+    bool sendBinary(uint8_t num, const uint8_t* data, size_t length) {
+        return _sendFrame(num, OP_BINARY, data, length);
+    }
+
+    // the frame header is made once for all clients, and the payload is
+    // written from data to each of them: return how many were sent to
+    uint8_t broadcastText(const char* text, size_t length) {
+        return _sendFrame(ALL, OP_TEXT, (const uint8_t*)text, length);
+    }
+    uint8_t broadcastText(const char* text) {
+        return broadcastText(text, strlen(text));
+    }
+    uint8_t broadcastText(const String& text) {
+        return broadcastText(text.c_str(), text.length());
+    }
+    uint8_t broadcastBinary(const uint8_t* data, size_t length) {
+        return _sendFrame(ALL, OP_BINARY, data, length);
+    }
+
+    bool ping(uint8_t num) {
+        return _sendFrame(num, OP_PING, nullptr, 0);
+    }
+
+    // close handshake: the status code is sent, then the connection dropped
+    void disconnect(uint8_t num, uint16_t code = 1000) {
+        if (num < WEBSOCKET_MAX_CLIENTS && _conns[num].open)
+            _fail(num, code);
+    }
+
+    bool connected(uint8_t num) const {
+        return num < WEBSOCKET_MAX_CLIENTS && _conns[num].open;
+    }
+
+    uint8_t connectedClients() const {
+        uint8_t count = 0;
+        for (const Connection& c : _conns)
+            count += c.open;
+        return count;
+    }
+
+    IPAddress remoteIP(uint8_t num) {
+        return connected(num) ? _conns[num].client.remoteIP() : IPAddress();
+    }
+
+protected:
+    enum : uint8_t { OP_CONTINUATION = 0x0, OP_TEXT = 0x1, OP_BINARY = 0x2,
+                     OP_CLOSE = 0x8, OP_PING = 0x9, OP_PONG = 0xa };
+    static constexpr int ALL = -1;
+    static constexpr size_t MERGE = 128; // payloads going out in one write with their header
+
+    struct Connection {
+        ClientType client;
+        bool open = false;
+        bool inFrame = false;      // header read, payload to come
+        bool fin = false;
+        uint8_t opcode = 0;        // of the current frame
+        uint8_t message = 0;       // opcode of the current message
+        uint8_t mask[4];
+        uint32_t left = 0;         // payload bytes of the frame still to come
+        uint32_t maskPos = 0;      // payload bytes of the frame unmasked so far
+        std::unique_ptr<uint8_t[]> buf; // message assembled, see _poll()
+        size_t len = 0;
+    };
+
+    static void _unmask(uint8_t* data, size_t length, const uint8_t* mask, uint32_t pos) {
+        for (size_t i = 0; i < length; i++)
+            data[i] ^= mask[(pos + i) & 3];
+    }
+
+    static size_t _frameHeader(uint8_t* hdr, uint8_t opcode, size_t length) {
+        hdr[0] = 0x80 | opcode;
+        if (length < 126) {
+            hdr[1] = length;
+            return 2;
+        }
+        if (length <= 0xffff) {
+            hdr[1] = 126;
+            hdr[2] = length >> 8;
+            hdr[3] = length;
+            return 4;
+        }
+        hdr[1] = 127;
+        memset(hdr + 2, 0, 4);
+        hdr[6] = length >> 24;
+        hdr[7] = length >> 16;
+        hdr[8] = length >> 8;
+        hdr[9] = length;
+        return 10;
+    }
+
+    uint8_t _sendFrame(int num, uint8_t opcode, const uint8_t* data, size_t length) {
+        uint8_t frame[10 + MERGE];
+        size_t hdrLen = _frameHeader(frame, opcode, length);
+        bool merged = length <= MERGE;
+        if (merged && length)
+            memcpy(frame + hdrLen, data, length);
+
+        uint8_t sent = 0;
+        for (int i = 0; i < WEBSOCKET_MAX_CLIENTS; i++) {
+            Connection& c = _conns[i];
+            if (!c.open || (num != ALL && num != i))
+                continue;
+            bool ok;
+            if (merged)
+                ok = c.client.write(frame, hdrLen + length) == hdrLen + length;
+            else
+                ok = c.client.write(frame, hdrLen) == hdrLen && c.client.write(data, length) == length;
+            sent += ok;
+        }
+        return sent;
+    }
+
+    void _drop(uint8_t num) {
+        Connection& c = _conns[num];
+        c.client.stop();
+        c = Connection();
+        DBGWS("websocket %d: disconnected\n", num);
+        _fn(num, WS_DISCONNECTED, nullptr, 0);
+    }
+
+    void _fail(uint8_t num, uint16_t code) {
+        uint8_t status[2] = { (uint8_t)(code >> 8), (uint8_t)code };
+        _sendFrame(num, OP_CLOSE, status, sizeof(status));
+        _drop(num);
+    }
+
+    void _control(uint8_t num, uint8_t opcode, const uint8_t* data, size_t length) {
+        if (opcode == OP_PING) {
+            _sendFrame(num, OP_PONG, data, length);
+        } else if (opcode == OP_CLOSE) {
+            // echo the status code
+            _sendFrame(num, OP_CLOSE, data, std::min(length, (size_t)2));
+            _drop(num);
+        }
+    }
+
+    // the message of the frame just completed, when it was the last one
+    void _endFrame(uint8_t num, const uint8_t* data, size_t length) {
+        Connection& c = _conns[num];
+        c.inFrame = false;
+        if (!c.fin)
+            return;
+        uint8_t type = c.message;
+        c.message = 0;
+        _fn(num, type == OP_TEXT ? WS_TEXT : WS_BINARY, data, length);
+    }
+
+    bool _poll(uint8_t num) {
+        Connection& c = _conns[num];
+        if (!c.client.connected() && !c.client.available()) {
+            _drop(num);
+            return true;
+        }
+
+        bool busy = false;
+        while (c.open && (c.inFrame || c.client.available())) {
+            if (!c.inFrame) {
+                uint8_t hdr[14];
+                if (c.client.available() < 2)
+                    break;
+                c.client.peekBytes(hdr, 2);
+                uint8_t len7 = hdr[1] & 0x7f;
+                size_t hdrLen = 2 + (len7 == 126 ? 2 : len7 == 127 ? 8 : 0) + 4;
+                if (!(hdr[1] & 0x80) || (hdr[0] & 0x70)) {
+                    // frames from clients are masked, and without extensions
+                    _fail(num, 1002);
+                    return true;
+                }
+                if ((size_t)c.client.available() < hdrLen)
+                    break;
+                c.client.read(hdr, hdrLen);
+                uint64_t length = len7;
+                if (len7 == 126) {
+                    length = (hdr[2] << 8) | hdr[3];
+                } else if (len7 == 127) {
+                    length = 0;
+                    for (int i = 2; i < 10; i++)
+                        length = (length << 8) | hdr[i];
+                }
+                memcpy(c.mask, hdr + hdrLen - 4, 4);
+                c.fin = hdr[0] & 0x80;
+                c.opcode = hdr[0] & 0x0f;
+                busy = true;
+
+                if (c.opcode & 0x8) {
+                    if (!c.fin || length > 125) {
+                        _fail(num, 1002);
+                        return true;
+                    }
+                } else if ((c.opcode == OP_CONTINUATION) != (c.message != 0) || c.opcode > OP_BINARY) {
+                    _fail(num, 1002);
+                    return true;
+                } else if (c.len + length > WEBSOCKET_MAX_MESSAGE) {
+                    _fail(num, 1009);
+                    return true;
+                } else if (c.opcode != OP_CONTINUATION) {
+                    c.message = c.opcode;
+                }
+                c.left = length;
+                c.maskPos = 0;
+                c.inFrame = true;
+            }
+
+            if (c.opcode & 0x8) {
+                // control frames are short and not fragmented: read whole
+                uint8_t payload[125];
+                if ((size_t)c.client.available() < c.left)
+                    break;
+                size_t length = c.left;
+                c.client.read(payload, length);
+                _unmask(payload, length, c.mask, 0);
+                c.inFrame = false;
+                _control(num, c.opcode, payload, length);
+                busy = true;
+                continue;
+            }
+
+            if (c.fin && !c.len && c.client.hasPeekBufferAPI() && c.client.peekAvailable() >= c.left) {
+                // the whole message is in the receive buffer
+                uint8_t* data = (uint8_t*)const_cast<char*>(c.client.peekBuffer());
+                size_t length = c.left;
+                _unmask(data, length, c.mask, 0);
+                _endFrame(num, data, length);
+                // the callback may have disconnected, the data is gone then
+                if (c.open)
+                    c.client.peekConsume(length);
+                busy = true;
+                continue;
+            }
+
+            if (c.left) {
+                if (!c.buf) {
+                    c.buf.reset(new (std::nothrow) uint8_t[WEBSOCKET_MAX_MESSAGE]);
+                    if (!c.buf) {
+                        _fail(num, 1011);
+                        return true;
+                    }
+                }
+                size_t n = std::min((size_t)c.client.available(), (size_t)c.left);
+                if (!n)
+                    break;
+                n = c.client.read(c.buf.get() + c.len, n);
+                _unmask(c.buf.get() + c.len, n, c.mask, c.maskPos);
+                c.len += n;
+                c.maskPos += n;
+                c.left -= n;
+                busy = true;
+                if (c.left)
+                    continue;
+            }
+            bool last = c.fin;
+            _endFrame(num, c.buf.get(), c.len);
+            if (last && c.open) {
+                c.buf.reset();
+                c.len = 0;
+            }
+        }
+        return busy;
+    }
+
+    typename WebServerType::TWebSocketFunction _fn;
+    Uri *_uri;
+    Connection _conns[WEBSOCKET_MAX_CLIENTS];
+};
+
+} // namespace
+
+#endif //WEBSOCKET_H
@@ -1,6 +1,8 @@
 #include "mimetable.h"
 #include "pgmspace.h"
 #include "WString.h"
+#include <algorithm>
+#include <vector>
 
 namespace mime
 {
@@ -88,14 +90,88 @@ const Entry mimeTable[maxType] PROGMEM =
     { kDefaultSuffix, kDefault }
 };
 
+// mimeTable entries (without the default one) ordered by suffix, so the
+// extension of a path can be found with a binary search
+static uint8_t sortedTypes[none];
+static bool sortedTypesReady = false;
+
+struct UserType
+{
+    String extension;
+    String mimeType;
+};
+
+// extra types from setContentType(), sorted by extension
+static std::vector<UserType> userTypes;
+
+static bool suffixLess(uint8_t a, uint8_t b)
+{
+    char suffix[16];
+    strncpy_P(suffix, mimeTable[a].endsWith, sizeof(suffix) - 1);
+    suffix[sizeof(suffix) - 1] = 0;
+    return strcmp_P_bulk(suffix, mimeTable[b].endsWith) < 0;
+}
+
+static void sortTypes()
+{
+    for (size_t i = 0; i < none; i++)
+        sortedTypes[i] = i;
+    std::sort(sortedTypes, sortedTypes + none, suffixLess);
+    sortedTypesReady = true;
+}
+
+// extension of the last path segment including the dot, or nullptr
+static const char* extensionOf(const char* path)
+{
+    const char* ext = strrchr(path, '.');
+    if (!ext || strchr(ext, '/'))
+        return nullptr;
+    return ext;
+}
+
+static const UserType* findUserType(const char* ext)
+{
+    auto it = std::lower_bound(userTypes.begin(), userTypes.end(), ext,
+                               [](const UserType& t, const char* e) { return strcmp(t.extension.c_str(), e) < 0; });
+    if (it == userTypes.end() || it->extension != ext)
+        return nullptr;
+    return &*it;
+}
+
     String getContentType(const String& path) {
-        for (size_t i = 0; i < maxType; i++) {
-            if (path.endsWith(FPSTR(mimeTable[i].endsWith))) {
-                return String(FPSTR(mimeTable[i].mimeType));
+        const char* ext = extensionOf(path.c_str());
+        if (ext) {
+            if (const UserType* user = findUserType(ext))
+                return user->mimeType;
+            if (!sortedTypesReady)
+                sortTypes();
+            size_t lo = 0, hi = none;
+            while (lo < hi) {
+                size_t mid = (lo + hi) / 2;
+                int cmp = strcmp_P_bulk(ext, mimeTable[sortedTypes[mid]].endsWith);
+                if (cmp == 0)
+                    return String(FPSTR(mimeTable[sortedTypes[mid]].mimeType));
+                if (cmp < 0)
+                    hi = mid;
+                else
+                    lo = mid + 1;
             }
         }
         // Fall-through and just return default type
         return String(FPSTR(kDefault));
     }
 
+    void setContentType(const String& extension, const String& mimeType) {
+        String ext;
+        if (!extension.startsWith("."))
+            ext = '.';
+        ext += extension;
+        auto it = std::lower_bound(userTypes.begin(), userTypes.end(), ext,
+                                   [](const UserType& t, const String& e) { return t.extension < e; });
+        if (it != userTypes.end() && it->extension == ext)
+            it->mimeType = mimeType;
+        else
+            userTypes.insert(it, UserType { ext, mimeType });
+    }
+
 }
@@ -47,6 +47,10 @@ struct Entry
 extern const Entry mimeTable[maxType];
 
 String getContentType(const String& path);
+
+// Add or replace the type for an extension like ".webp" or "webp",
+// looked up before the built-in table
+void setContentType(const String& extension, const String& mimeType);
 }
 
 #endif
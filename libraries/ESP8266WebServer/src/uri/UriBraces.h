@@ -13,6 +13,10 @@ class UriBraces : public Uri {
             return new UriBraces(_uri);
         };
 
+        const String* exactUri() const override final {
+            return nullptr;
+        }
+
         bool canHandle(const String &requestUri, std::vector<String> &pathArgs) override final {
             if (Uri::canHandle(requestUri, pathArgs))
                 return true;
@@ -28,6 +28,10 @@ class UriRegex : public Uri {
             return new UriRegex(_uri);
         };
 
+        const String* exactUri() const override final {
+            return nullptr;
+        }
+
         bool canHandle(const String &requestUri, std::vector<String> &pathArgs) override final {
             if (Uri::canHandle(requestUri, pathArgs))
                 return true;
@@ -0,0 +1,115 @@
+// Times the BearSSL kernels that dominate a TLS connection, for each of
+// the implementations built into the core, so that the fastest ones can be
+// picked for a given CPU frequency and flash mode:
+//
+//  - EC point multiplication (ECDHE and ECDSA): P-256 and Curve25519
+//  - bulk ciphers: AES-CBC, GHASH (AES-GCM), ChaCha20 and Poly1305
+//
+// The kernels used by WiFiClientSecure and WiFiServerSecure are selected at
+// build time with -DBEARSSL_CTMUL32 (GHASH and Poly1305 using only 32 bit
+// products) and -DBEARSSL_AES_SMALL (table based AES, not constant-time).
+//
+// No network is needed.
+//
+// Released to the public domain
+
+#include <ESP8266WiFi.h>
+#include <StackThunk.h>
+#include <bearssl/bearssl.h>
+
+static uint8_t data[1024];
+static uint8_t key[32];
+static uint8_t iv[16];
+
+static void report(const char *name, uint32_t start, uint32_t count, size_t bytes) {
+  uint32_t us = micros() - start;
+  if (bytes) {
+    Serial.printf("%-26s %7u us/KB\n", name, (unsigned)(us / count * 1024 / bytes));
+  } else {
+    Serial.printf("%-26s %7u us\n", name, (unsigned)(us / count));
+  }
+}
+
+static void benchCbc(const char *name, const br_block_cbcenc_class *vt) {
+  br_aes_gen_cbcenc_keys ctx;
+  vt->init(&ctx.vtable, key, 16);
+  uint32_t start = micros();
+  for (int i = 0; i < 16; i++) {
+    vt->run(&ctx.vtable, iv, data, sizeof(data));
+  }
+  report(name, start, 16, sizeof(data));
+}
+
+static void benchGhash(const char *name, br_ghash ghash) {
+  uint8_t y[16] = { 0 };
+  uint32_t start = micros();
+  for (int i = 0; i < 16; i++) {
+    ghash(y, key, data, sizeof(data));
+  }
+  report(name, start, 16, sizeof(data));
+}
+
+static void benchPoly1305(const char *name, br_poly1305_run poly) {
+  uint8_t tag[16];
+  uint32_t start = micros();
+  for (int i = 0; i < 16; i++) {
+    poly(key, iv, data, sizeof(data), nullptr, 0, tag, &br_chacha20_ct_run, 1);
+  }
+  // includes the ChaCha20 encryption of the data
+  report(name, start, 16, sizeof(data));
+}
+
+static void benchEc(const char *name, const br_ec_impl *impl, int curve) {
+  size_t len;
+  const unsigned char *g = impl->generator(curve, &len);
+  unsigned char point[65];
+  memcpy(point, g, len);
+  uint32_t start = micros();
+  for (int i = 0; i < 4; i++) {
+    impl->mul(point, len, key, 32, curve);
+  }
+  report(name, start, 4, 0);
+}
+
+// EC code needs more stack than the default 4K, run it on the BearSSL stack
+extern "C" void benchAll() {
+  Serial.printf("\nPoint multiplication\n");
+  benchEc("P-256 m15", &br_ec_p256_m15, BR_EC_secp256r1);
+  benchEc("P-256 prime_i15", &br_ec_prime_i15, BR_EC_secp256r1);
+  benchEc("Curve25519 m15", &br_ec_c25519_m15, BR_EC_curve25519);
+  benchEc("Curve25519 i15", &br_ec_c25519_i15, BR_EC_curve25519);
+
+  Serial.printf("\nBulk\n");
+  benchCbc("AES-128-CBC ct (default)", &br_aes_ct_cbcenc_vtable);
+  benchCbc("AES-128-CBC small", &br_aes_small_cbcenc_vtable);
+  benchCbc("AES-128-CBC big", &br_aes_big_cbcenc_vtable);
+  benchGhash("GHASH ctmul (default)", &br_ghash_ctmul);
+  benchGhash("GHASH ctmul32", &br_ghash_ctmul32);
+  benchPoly1305("ChaPoly ctmul (default)", &br_poly1305_ctmul_run);
+  benchPoly1305("ChaPoly ctmul32", &br_poly1305_ctmul32_run);
+  benchPoly1305("ChaPoly i15", &br_poly1305_i15_run);
+
+  Serial.printf("\nBearSSL stack used: %u\n", (unsigned)stack_thunk_get_max_usage());
+}
+
+make_stack_thunk(benchAll);
+extern "C" void thunk_benchAll();
+
+void setup() {
+  Serial.begin(115200);
+  WiFi.mode(WIFI_OFF);
+  for (size_t i = 0; i < sizeof(data); i++) {
+    data[i] = i;
+  }
+  for (size_t i = 0; i < sizeof(key); i++) {
+    key[i] = 0x5a ^ i;
+  }
+
+  Serial.printf("\nBearSSL kernels at %u MHz\n", ESP.getCpuFreqMHz());
+  stack_thunk_add_ref();
+  thunk_benchAll();
+  stack_thunk_del_ref();
+}
+
+void loop() {
+}
@@ -29,6 +29,8 @@
 #include <string.h>
 #include <Arduino.h>
 #include <StackThunk.h>
+#include <umm_malloc/umm_heap_select.h>
+#include <coredecls.h>
 #include <Updater_Signing.h>
 #ifndef ARDUINO_SIGNING
   #define ARDUINO_SIGNING 0
@@ -641,6 +643,43 @@ namespace brssl {
     }
     return dest;
   }
+
+  // Precompiled tables (tools/cert2ta.py) in RAM are used in place.  BearSSL
+  // reads them byte by byte, which flash does not allow, so tables in
+  // PROGMEM are copied once, still without any parsing.
+  static bool in_flash(const void *p) {
+#if CORE_MOCK
+    (void)p;
+    return false;
+#else
+    return (uintptr_t)p >= 0x40200000;
+#endif
+  }
+
+  static size_t pkey_len(const br_x509_pkey &pk, bool *flash) {
+    if (pk.key_type == BR_KEYTYPE_RSA) {
+      *flash |= in_flash(pk.key.rsa.n) || in_flash(pk.key.rsa.e);
+      return pk.key.rsa.nlen + pk.key.rsa.elen;
+    }
+    *flash |= in_flash(pk.key.ec.q);
+    return pk.key.ec.qlen;
+  }
+
+  static uint8_t *pkey_copy(br_x509_pkey &pk, uint8_t *dst) {
+    if (pk.key_type == BR_KEYTYPE_RSA) {
+      memcpy_P(dst, pk.key.rsa.n, pk.key.rsa.nlen);
+      pk.key.rsa.n = dst;
+      dst += pk.key.rsa.nlen;
+      memcpy_P(dst, pk.key.rsa.e, pk.key.rsa.elen);
+      pk.key.rsa.e = dst;
+      dst += pk.key.rsa.elen;
+    } else {
+      memcpy_P(dst, pk.key.ec.q, pk.key.ec.qlen);
+      pk.key.ec.q = dst;
+      dst += pk.key.ec.qlen;
+    }
+    return dst;
+  }
 };
 
 
@@ -651,20 +690,45 @@ namespace BearSSL {
 
 PublicKey::PublicKey() {
   _key = nullptr;
+  _precompiled = false;
 }
 
 PublicKey::PublicKey(const char *pemKey) {
   _key = nullptr;
+  _precompiled = false;
   parse(pemKey);
 }
 
 PublicKey::PublicKey(const uint8_t *derKey, size_t derLen) {
   _key = nullptr;
+  _precompiled = false;
   parse(derKey, derLen);
 }
 
+PublicKey::PublicKey(const br_x509_pkey *key) {
+  br_x509_pkey pk;
+  memcpy_P(&pk, key, sizeof(pk));
+  bool flash = false;
+  size_t len = brssl::pkey_len(pk, &flash);
+  _precompiled = true;
+  _key = (brssl::public_key *)malloc(sizeof(brssl::public_key) + (flash ? len : 0));
+  if (!_key) {
+    return;
+  }
+  if (flash) {
+    brssl::pkey_copy(pk, (uint8_t *)(_key + 1));
+  }
+  _key->key_type = pk.key_type;
+  if (pk.key_type == BR_KEYTYPE_RSA) {
+    _key->key.rsa = pk.key.rsa;
+  } else {
+    _key->key.ec = pk.key.ec;
+  }
+}
+
 PublicKey::PublicKey(Stream &stream, size_t size) {
   _key = nullptr;
+  _precompiled = false;
   auto buff = brssl::loadStream(stream, size);
   if (buff) {
     parse(buff, size);
@@ -674,7 +738,11 @@ PublicKey::PublicKey(Stream &stream, size_t size) {
 
 PublicKey::~PublicKey() {
   if (_key) {
-    brssl::free_public_key(_key);
+    if (_precompiled) {
+      free(_key);
+    } else {
+      brssl::free_public_key(_key);
+    }
   }
 }
 
@@ -684,9 +752,14 @@ bool PublicKey::parse(const char *pemKey) {
 
 bool PublicKey::parse(const uint8_t *derKey, size_t derLen) {
   if (_key) {
-    brssl::free_public_key(_key);
+    if (_precompiled) {
+      free(_key);
+    } else {
+      brssl::free_public_key(_key);
+    }
     _key = nullptr;
   }
+  _precompiled = false;
   _key = brssl::read_public_key((const char *)derKey, derLen);
   return _key ? true : false;
 }
@@ -797,12 +870,16 @@ X509List::X509List() {
   _count = 0;
   _cert = nullptr;
   _ta = nullptr;
+  _block = nullptr;
+  _precompiled = false;
 }
 
 X509List::X509List(const char *pemCert) {
   _count = 0;
   _cert = nullptr;
   _ta = nullptr;
+  _block = nullptr;
+  _precompiled = false;
   append(pemCert);
 }
 
@@ -811,6 +888,8 @@ X509List::X509List(const uint8_t *derCert, size_t derLen) {
   _count = 0;
   _cert = nullptr;
   _ta = nullptr;
+  _block = nullptr;
+  _precompiled = false;
   append(derCert, derLen);
 }
 
@@ -818,6 +897,8 @@ X509List::X509List(Stream &stream, size_t size) {
   _count = 0;
   _cert = nullptr;
   _ta = nullptr;
+  _block = nullptr;
+  _precompiled = false;
   auto buff = brssl::loadStream(stream, size);
   if (buff) {
     append(buff, size);
@@ -825,7 +906,49 @@ X509List::X509List(Stream &stream, size_t size) {
   }
 }
 
+X509List::X509List(const br_x509_trust_anchor *ta, size_t count) {
+  _count = 0;
+  _cert = nullptr;
+  _ta = nullptr;
+  _block = nullptr;
+  _precompiled = true;
+
+  size_t len = count * sizeof(br_x509_trust_anchor);
+  bool flash = brssl::in_flash(ta);
+  for (size_t i = 0; i < count; i++) {
+    br_x509_trust_anchor t;
+    memcpy_P(&t, &ta[i], sizeof(t));
+    flash |= brssl::in_flash(t.dn.data);
+    len += t.dn.len + brssl::pkey_len(t.pkey, &flash);
+  }
+  if (!flash) {
+    _ta = const_cast<br_x509_trust_anchor *>(ta);
+    _count = count;
+    return;
+  }
+
+  // Everything in a single block
+  _block = malloc(len);
+  if (!_block) {
+    return;
+  }
+  _ta = (br_x509_trust_anchor *)_block;
+  memcpy_P(_ta, ta, count * sizeof(br_x509_trust_anchor));
+  uint8_t *dst = (uint8_t *)&_ta[count];
+  for (size_t i = 0; i < count; i++) {
+    memcpy_P(dst, _ta[i].dn.data, _ta[i].dn.len);
+    _ta[i].dn.data = dst;
+    dst += _ta[i].dn.len;
+    dst = brssl::pkey_copy(_ta[i].pkey, dst);
+  }
+  _count = count;
+}
+
 X509List::~X509List() {
+  if (_precompiled) {
+    free(_block);
+    return;
+  }
   brssl::free_certificates(_cert, _count); // also frees cert
   for (size_t i = 0; i < _count; i++) {
     brssl::free_ta_contents(&_ta[i]);
@@ -838,6 +961,9 @@ bool X509List::append(const char *pemCert) {
 }
 
 bool X509List::append(const uint8_t *derCert, size_t derLen) {
+  if (_precompiled) {
+    return false;
+  }
   size_t numCerts;
   br_x509_certificate *newCerts = brssl::read_certificates((const char *)derCert, derLen, &numCerts);
   if (!newCerts) {
@@ -876,9 +1002,61 @@ bool X509List::append(const uint8_t *derCert, size_t derLen) {
   return true;
 }
 
+// Serialized session layout, little endian:
+//  0 magic   4 session id  36 id length  38 version  40 cipher suite
+//  44 master secret  92 crc32 of the bytes before
+static constexpr uint32_t sessionMagic = 0x53534201; // "\x01BSS", format 1
+
+static void putLE(uint8_t *p, uint32_t v, int n) {
+  for (int i = 0; i < n; i++, v >>= 8)
+    p[i] = v;
+}
+
+static uint32_t getLE(const uint8_t *p, int n) {
+  uint32_t v = 0;
+  for (int i = n - 1; i >= 0; i--)
+    v = (v << 8) | p[i];
+  return v;
+}
+
+size_t Session::serialize(uint8_t *buf, size_t len) const {
+  if (!buf || len < serializedSize)
+    return 0;
+  memset(buf, 0, serializedSize);
+  putLE(buf, sessionMagic, 4);
+  memcpy(buf + 4, _session.session_id, sizeof(_session.session_id));
+  buf[36] = _session.session_id_len;
+  putLE(buf + 38, _session.version, 2);
+  putLE(buf + 40, _session.cipher_suite, 2);
+  memcpy(buf + 44, _session.master_secret, sizeof(_session.master_secret));
+  putLE(buf + 92, crc32(buf, 92), 4);
+  return serializedSize;
+}
+
+bool Session::deserialize(const uint8_t *buf, size_t len) {
+  memset(&_session, 0, sizeof(_session));
+  if (!buf || len < serializedSize || getLE(buf, 4) != sessionMagic
+      || getLE(buf + 92, 4) != crc32(buf, 92) || buf[36] > sizeof(_session.session_id))
+    return false;
+  memcpy(_session.session_id, buf + 4, sizeof(_session.session_id));
+  _session.session_id_len = buf[36];
+  _session.version = getLE(buf + 38, 2);
+  _session.cipher_suite = getLE(buf + 40, 2);
+  memcpy(_session.master_secret, buf + 44, sizeof(_session.master_secret));
+  return true;
+}
+
+static ServerSession *allocSessions(uint32_t size, size_t heapId) {
+  HeapSelect ephemeral(heapId);
+  return size > 0 ? new ServerSession[size] : nullptr;
+}
+
+ServerSessions::ServerSessions(uint32_t size, size_t heapId) :
+  ServerSessions(allocSessions(size, heapId), size, true) {}
+
 ServerSessions::~ServerSessions() {
   if (_isDynamic && _store != nullptr)
-    delete _store;
+    delete[] _store;
 }
 
 ServerSessions::ServerSessions(ServerSession *sessions, uint32_t size, bool isDynamic) :
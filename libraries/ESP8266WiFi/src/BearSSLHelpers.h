@@ -43,6 +43,8 @@ class PublicKey {
     PublicKey();
     PublicKey(const char *pemKey);
     PublicKey(const uint8_t *derKey, size_t derLen);
+    // Precompiled by tools/cert2ta.py, used without parsing
+    PublicKey(const br_x509_pkey *key);
     PublicKey(Stream& stream, size_t size);
     PublicKey(Stream& stream) : PublicKey(stream, stream.available()) { };
     ~PublicKey();
@@ -61,6 +63,7 @@ class PublicKey {
 
   private:
     brssl::public_key *_key;
+    bool _precompiled;
 };
 
 // Holds either a single private RSA or EC key for use when BearSSL wants a secretkey.
@@ -102,6 +105,10 @@ class X509List {
     X509List();
     X509List(const char *pemCert);
     X509List(const uint8_t *derCert, size_t derLen);
+    // Trust anchors precompiled by tools/cert2ta.py: nothing is parsed, and
+    // tables in RAM are used in place.  Such a list only holds trust
+    // anchors (no certificates for a client chain) and cannot be appended.
+    X509List(const br_x509_trust_anchor *ta, size_t count);
     X509List(Stream& stream, size_t size);
     X509List(Stream& stream) : X509List(stream, stream.available()) { };
     ~X509List();
@@ -127,6 +134,8 @@ class X509List {
     size_t _count;
     br_x509_certificate *_cert;
     br_x509_trust_anchor *_ta;
+    void *_block; // precompiled trust anchors copied from flash
+    bool _precompiled;
 };
 
 // Opaque object which wraps the BearSSL SSL session to make repeated connections
@@ -141,6 +150,20 @@ class Session {
 
   public:
     Session() { memset(&_session, 0, sizeof(_session)); }
+
+    // Size of the serialized form, a multiple of 4 to fit RTC user memory
+    static constexpr size_t serializedSize = 96;
+
+    // Write the session into buf (at least serializedSize bytes), to keep
+    // it across deep sleep in RTC memory or in flash. The master secret is
+    // part of it, so keep it where others can't read it.
+    // Returns the number of bytes written, or 0 if buf is too small.
+    size_t serialize(uint8_t *buf, size_t len) const;
+
+    // Restore a session written by serialize(). Returns false and leaves the
+    // session empty if the data is not a valid serialized session.
+    bool deserialize(const uint8_t *buf, size_t len);
+
   private:
     br_ssl_session_parameters *getSession() { return &_session; }
     // The actual BearSSL session information
@@ -165,6 +188,10 @@ class ServerSessions {
     // returned by size() will be 0.
     ServerSessions(uint32_t size) : ServerSessions(size > 0 ? new ServerSession[size] : nullptr, size, true) {}
 
+    // Same, allocating from the given heap (UMM_HEAP_DRAM, UMM_HEAP_IRAM or
+    // UMM_HEAP_EXTERNAL, see umm_malloc/umm_heap_select.h).
+    ServerSessions(uint32_t size, size_t heapId);
+
     ~ServerSessions();
 
     // Returns the number of sessions the cache can hold.
@@ -18,6 +18,7 @@
 */
 
 #include "CertStoreBearSSL.h"
+#include <algorithm>
 #include <memory>
 
 
@@ -41,6 +42,20 @@ extern "C" {
 CertStore::~CertStore() {
   free(_indexName);
   free(_dataName);
+  _clearCache();
+}
+
+void CertStore::setCacheSize(size_t entries) {
+  _clearCache();
+  _cacheSize = entries;
+  _cache.reserve(entries); // So adding to the cache never allocates
+}
+
+void CertStore::_clearCache() {
+  for (auto &c : _cache) {
+    delete c.x509;
+  }
+  _cache.clear();
 }
 
 CertStore::CertInfo CertStore::_preprocessCert(uint32_t length, uint32_t offset, const void *raw) {
@@ -85,6 +100,7 @@ int CertStore::initCertStore(fs::FS &fs, const char *indexFileName, const char *
   uint32_t offset = 0;
 
   _fs = &fs;
+  _clearCache();
 
   // In case initCertStore called multiple times, don't leak old filenames
   free(_indexName);
@@ -163,8 +179,88 @@ int CertStore::initCertStore(fs::FS &fs, const char *indexFileName, const char *
     }
   }
   data.close();
+  IndexTrailer trailer = { _indexMagic, (uint32_t)count, 0 };
+  if (index.write((uint8_t *)&trailer, sizeof(trailer)) != sizeof(trailer)) {
+    index.close();
+    return 0;
+  }
   index.close();
-  return count;
+  return _sortIndex(count);
+}
+
+// Rewrite the index ordered by subject hash, so findHashedTA() can use a
+// binary search.  Without the RAM for it the index is left unsorted.
+int CertStore::_sortIndex(int count) {
+  if (count < 2) {
+    return count;
+  }
+  size_t size = count * sizeof(CertInfo);
+  CertInfo *all = new (std::nothrow) CertInfo[count];
+  if (!all) {
+    DEBUG_BSSL("CertStore::_sortIndex: OOM, index stays unsorted\n");
+    return count;
+  }
+  fs::File index = _fs->open(_indexName, "r");
+  if (!index || index.read((uint8_t *)all, size) != (int)size) {
+    delete[] all;
+    return count;
+  }
+  index.close();
+
+  std::sort(all, all + count, [](const CertInfo &a, const CertInfo &b) {
+    return memcmp(a.sha256, b.sha256, sizeof(a.sha256)) < 0;
+  });
+  IndexTrailer trailer = { _indexMagic, (uint32_t)count, 1 };
+  index = _fs->open(_indexName, "w");
+  bool ok = index && index.write((uint8_t *)all, size) == size &&
+            index.write((uint8_t *)&trailer, sizeof(trailer)) == sizeof(trailer);
+  index.close();
+  delete[] all;
+  return ok ? count : 0;
+}
+
+// Look up the index entry for a subject hash
+bool CertStore::_findInfo(fs::File &index, const void *hashed_dn, CertInfo &ci) {
+  IndexTrailer trailer;
+  size_t size = index.size();
+  if (size < sizeof(trailer) || !index.seek(size - sizeof(trailer), fs::SeekSet) ||
+      index.read((uint8_t *)&trailer, sizeof(trailer)) != sizeof(trailer) ||
+      trailer.magic != _indexMagic || size != sizeof(trailer) + trailer.count * sizeof(ci)) {
+    DEBUG_BSSL("CertStore::_findInfo: bad index\n");
+    return false;
+  }
+
+  if (trailer.sorted) {
+    uint32_t lo = 0, hi = trailer.count;
+    while (lo < hi) {
+      uint32_t mid = (lo + hi) / 2;
+      if (!index.seek(mid * sizeof(ci), fs::SeekSet) ||
+          index.read((uint8_t *)&ci, sizeof(ci)) != sizeof(ci)) {
+        return false;
+      }
+      int cmp = memcmp(ci.sha256, hashed_dn, sizeof(ci.sha256));
+      if (!cmp) {
+        return true;
+      }
+      if (cmp < 0) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    return false;
+  }
+
+  index.seek(0, fs::SeekSet);
+  for (uint32_t i = 0; i < trailer.count; i++) {
+    if (index.read((uint8_t *)&ci, sizeof(ci)) != sizeof(ci)) {
+      return false;
+    }
+    if (!memcmp(ci.sha256, hashed_dn, sizeof(ci.sha256))) {
+      return true;
+    }
+  }
+  return false;
 }
 
 void CertStore::installCertStore(br_x509_minimal_context *ctx) {
@@ -179,49 +275,66 @@ const br_x509_trust_anchor *CertStore::findHashedTA(void *ctx, void *hashed_dn,
     return nullptr;
   }
 
+  for (auto it = cs->_cache.begin(); it != cs->_cache.end(); ++it) {
+    if (!memcmp(it->sha256, hashed_dn, sizeof(it->sha256))) {
+      std::rotate(cs->_cache.begin(), it, it + 1); // Now the most recently used
+      return cs->_cache.front().x509->getTrustAnchors();
+    }
+  }
+
   fs::File index = cs->_fs->open(cs->_indexName, "r");
   if (!index) {
     return nullptr;
   }
+  bool found = _findInfo(index, hashed_dn, ci);
+  index.close();
+  if (!found) {
+    return nullptr;
+  }
 
-  while (index.read((uint8_t *)&ci, sizeof(ci)) == sizeof(ci)) {
-    if (!memcmp(ci.sha256, hashed_dn, sizeof(ci.sha256))) {
-      index.close();
-      uint8_t *der = (uint8_t*)malloc(ci.length);
-      if (!der) {
-        return nullptr;
-      }
-      fs::File data = cs->_fs->open(cs->_dataName, "r");
-      if (!data) {
-        free(der);
-        return nullptr;
-      }
-      if (!data.seek(ci.offset, fs::SeekSet)) {
-        data.close();
-        free(der);
-        return nullptr;
-      }
-      if (data.read(der, ci.length) != (int)ci.length) {
-        free(der);
-        return nullptr;
-      }
-      data.close();
-      cs->_x509 = new (std::nothrow) X509List(der, ci.length);
-      free(der);
-      if (!cs->_x509) {
-        DEBUG_BSSL("CertStore::findHashedTA: OOM\n");
-        return nullptr;
-      }
+  uint8_t *der = (uint8_t*)malloc(ci.length);
+  if (!der) {
+    return nullptr;
+  }
+  fs::File data = cs->_fs->open(cs->_dataName, "r");
+  if (!data) {
+    free(der);
+    return nullptr;
+  }
+  if (!data.seek(ci.offset, fs::SeekSet)) {
+    data.close();
+    free(der);
+    return nullptr;
+  }
+  if (data.read(der, ci.length) != (int)ci.length) {
+    free(der);
+    return nullptr;
+  }
+  data.close();
+  cs->_x509 = new (std::nothrow) X509List(der, ci.length);
+  free(der);
+  if (!cs->_x509) {
+    DEBUG_BSSL("CertStore::findHashedTA: OOM\n");
+    return nullptr;
+  }
 
-      br_x509_trust_anchor *ta = (br_x509_trust_anchor*)cs->_x509->getTrustAnchors();
-      memcpy(ta->dn.data, ci.sha256, sizeof(ci.sha256));
-      ta->dn.len = sizeof(ci.sha256);
+  br_x509_trust_anchor *ta = (br_x509_trust_anchor*)cs->_x509->getTrustAnchors();
+  memcpy(ta->dn.data, ci.sha256, sizeof(ci.sha256));
+  ta->dn.len = sizeof(ci.sha256);
 
-      return ta;
+  if (cs->_cacheSize) {
+    if (cs->_cache.size() == cs->_cacheSize) {
+      delete cs->_cache.back().x509;
+      cs->_cache.pop_back();
     }
+    CachedTA c;
+    memcpy(c.sha256, ci.sha256, sizeof(c.sha256));
+    c.x509 = cs->_x509;
+    cs->_cache.insert(cs->_cache.begin(), c);
+    cs->_x509 = nullptr; // Owned by the cache, freeHashedTA() keeps it
   }
-  index.close();
-  return nullptr;
+
+  return ta;
 }
 
 void CertStore::freeHashedTA(void *ctx, const br_x509_trust_anchor *ta) {
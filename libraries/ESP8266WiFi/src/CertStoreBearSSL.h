@@ -24,6 +24,7 @@
 #include <BearSSLHelpers.h>
 #include <bearssl/bearssl.h>
 #include <FS.h>
+#include <vector>
 
 // Base class for the certificate stores, which allow use
 // of a large set of certificates stored on FS or SD card to
@@ -50,12 +51,27 @@ class CertStore: public CertStoreBase {
     // Installs the cert store into the X509 decoder (normally via static function callbacks)
     void installCertStore(br_x509_minimal_context *ctx);
 
+    // Keep up to this many decoded trust anchors in RAM (least recently
+    // used ones are dropped), so they are not read from the FS again.
+    // Each takes about the size of its certificate.  Default 0, no cache.
+    void setCacheSize(size_t entries);
+
   protected:
     fs::FS *_fs = nullptr;
     char *_indexName = nullptr;
     char *_dataName = nullptr;
     X509List *_x509 = nullptr;
 
+    // Decoded trust anchors, most recently used first
+    class CachedTA {
+    public:
+      uint8_t sha256[32];
+      X509List *x509;
+    };
+    std::vector<CachedTA> _cache;
+    size_t _cacheSize = 0;
+    void _clearCache();
+
     // These need to be static as they are callbacks from BearSSL C code
     static const br_x509_trust_anchor *findHashedTA(void *ctx, void *hashed_dn, size_t len);
     static void freeHashedTA(void *ctx, const br_x509_trust_anchor *ta);
@@ -69,6 +85,17 @@ class CertStore: public CertStoreBase {
     };
     static CertInfo _preprocessCert(uint32_t length, uint32_t offset, const void *raw);
 
+    // Written after the CertInfo entries of the index file
+    class IndexTrailer {
+    public:
+      uint32_t magic;
+      uint32_t count;
+      uint32_t sorted; // entries are ordered by sha256
+    };
+    static constexpr uint32_t _indexMagic = 0x31494353; // "SCI1"
+    int _sortIndex(int count);
+    static bool _findInfo(fs::File &index, const void *hashed_dn, CertInfo &ci);
+
 };
 
 };
@@ -0,0 +1,159 @@
+/*
+ ClientTxPool.cpp - fixed memory for data written to TCP connections
+
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <stdlib.h>
+#include <algorithm>
+#include <new>
+#include "debug.h"
+#include "include/ClientTxPool.h"
+
+uint8_t* ClientTxPool::_mem = nullptr;
+uint16_t* ClientTxPool::_link = nullptr;
+ClientTxPool::Queue* ClientTxPool::_orphans = nullptr;
+uint16_t ClientTxPool::_count = 0;
+uint16_t ClientTxPool::_free = ClientTxPool::none;
+uint16_t ClientTxPool::_free_count = 0;
+
+bool ClientTxPool::begin(size_t bytes)
+{
+    size_t count = std::min(bytes / chunk, (size_t)none);
+    if (_mem || !count) {
+        return false;
+    }
+    _mem = (uint8_t*)malloc(count * chunk);
+    _link = (uint16_t*)malloc(count * sizeof(_link[0]));
+    // each closed connection still sending holds at least one chunk
+    _orphans = new (std::nothrow) Queue[count];
+    if (!_mem || !_link || !_orphans) {
+        free(_mem);
+        free(_link);
+        delete[] _orphans;
+        _mem = nullptr;
+        _link = nullptr;
+        _orphans = nullptr;
+        return false;
+    }
+    _count = count;
+    for (uint16_t c = 0; c < _count; c++) {
+        _put(c);
+    }
+    DEBUGV(":txpool %d x %d\r\n", (int)_count, (int)chunk);
+    return true;
+}
+
+void ClientTxPool::_put(uint16_t c)
+{
+    _link[c] = _free;
+    _free = c;
+    _free_count++;
+}
+
+uint8_t* ClientTxPool::reserve(Queue& q, size_t& len)
+{
+    if (q.tail == none || q.tail_used == chunk) {
+        if (_free == none) {
+            return nullptr;
+        }
+        uint16_t c = _free;
+        _free = _link[c];
+        _free_count--;
+        _link[c] = none;
+        if (q.tail == none) {
+            q.head = c;
+            q.head_acked = 0;
+        } else {
+            _link[q.tail] = c;
+        }
+        q.tail = c;
+        q.tail_used = 0;
+    }
+    len = std::min(len, chunk - q.tail_used);
+    return _mem + q.tail * chunk + q.tail_used;
+}
+
+void ClientTxPool::acked(Queue& q, size_t len)
+{
+    // all chunks but the tail are full
+    while (len && q.head != none) {
+        size_t end = q.head == q.tail? q.tail_used: chunk;
+        size_t take = std::min(len, end - q.head_acked);
+        q.head_acked += take;
+        len -= take;
+        if (q.head_acked < end) {
+            break;
+        }
+        uint16_t next = _link[q.head];
+        _put(q.head);
+        if (q.head == q.tail) {
+            q = Queue();
+            break;
+        }
+        q.head = next;
+        q.head_acked = 0;
+    }
+}
+
+void ClientTxPool::release(Queue& q)
+{
+    for (uint16_t c = q.head; c != none; ) {
+        uint16_t next = c == q.tail? none: _link[c];
+        _put(c);
+        c = next;
+    }
+    q = Queue();
+}
+
+void ClientTxPool::orphan(tcp_pcb* pcb, Queue& q)
+{
+    if (q.head == none) {
+        return;
+    }
+    for (uint16_t i = 0; i < _count; i++) {
+        if (_orphans[i].head == none) {
+            _orphans[i] = q;
+            q = Queue();
+            tcp_arg(pcb, &_orphans[i]);
+            tcp_sent(pcb, &_s_orphan_acked);
+            tcp_err(pcb, &_s_orphan_error);
+            return;
+        }
+    }
+    // not reached: there are no more orphans than chunks
+    release(q);
+}
+
+err_t ClientTxPool::_s_orphan_acked(void* arg, tcp_pcb* pcb, uint16_t len)
+{
+    Queue& q = *reinterpret_cast<Queue*>(arg);
+    acked(q, len);
+    if (q.head == none) {
+        tcp_arg(pcb, NULL);
+        tcp_sent(pcb, NULL);
+        tcp_err(pcb, NULL);
+    }
+    return ERR_OK;
+}
+
+void ClientTxPool::_s_orphan_error(void* arg, err_t err)
+{
+    (void)err;
+    // the pcb is gone
+    release(*reinterpret_cast<Queue*>(arg));
+}
@@ -23,7 +23,9 @@
  */
 
 #include <list>
+#include <vector>
 #include <string.h>
+#include <Schedule.h>
 #include <coredecls.h>
 #include <PolledTimeout.h>
 #include "ESP8266WiFi.h"
@@ -81,7 +83,16 @@ struct WiFiEventHandlerOpaque
     bool mCanExpire = true; /* stopgap solution to handle deprecated void onEvent(cb, evt) case */
 };
 
-static std::list<WiFiEventHandler> sCbEventList;
+// one list per event, the last one for WIFI_EVENT_ANY
+static std::list<WiFiEventHandler> sCbEventList[WIFI_EVENT_MAX + 1];
+
+struct WiFiEventRawSlot
+{
+    WiFiEventRawCb cb;
+    void* arg;
+};
+
+static WiFiEventRawSlot sRawEventTable[WIFI_EVENT_MAX][WIFI_EVENT_RAW_SLOTS];
 
 bool ESP8266WiFiGenericClass::_persistent = false;
 WiFiMode_t ESP8266WiFiGenericClass::_forceSleepLastMode = WIFI_OFF;
@@ -97,7 +108,36 @@ void ESP8266WiFiGenericClass::onEvent(WiFiEventCb f, WiFiEvent_t event)
         (*f)(static_cast<WiFiEvent>(e->event));
     });
     handler->mCanExpire = false;
-    sCbEventList.push_back(handler);
+    sCbEventList[handler->mEvent].push_back(handler);
+}
+
+bool ESP8266WiFiGenericClass::onEventRaw(WiFiEvent_t event, WiFiEventRawCb cb, void* arg)
+{
+    if (event >= WIFI_EVENT_MAX || !cb) {
+        return false;
+    }
+    for (auto& slot : sRawEventTable[event]) {
+        if (!slot.cb) {
+            slot.arg = arg;
+            slot.cb = cb;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ESP8266WiFiGenericClass::removeEventRaw(WiFiEvent_t event, WiFiEventRawCb cb, void* arg)
+{
+    if (event >= WIFI_EVENT_MAX) {
+        return false;
+    }
+    for (auto& slot : sRawEventTable[event]) {
+        if (slot.cb == cb && slot.arg == arg) {
+            slot.cb = nullptr;
+            return true;
+        }
+    }
+    return false;
 }
 
 WiFiEventHandler ESP8266WiFiGenericClass::onStationModeConnected(std::function<void(const WiFiEventStationModeConnected&)> f)
@@ -110,7 +150,7 @@ WiFiEventHandler ESP8266WiFiGenericClass::onStationModeConnected(std::function<v
         dst.channel = src.channel;
         f(dst);
     });
-    sCbEventList.push_back(handler);
+    sCbEventList[handler->mEvent].push_back(handler);
     return handler;
 }
 
@@ -124,7 +164,7 @@ WiFiEventHandler ESP8266WiFiGenericClass::onStationModeDisconnected(std::functio
         dst.reason = static_cast<WiFiDisconnectReason>(src.reason);
         f(dst);
     });
-    sCbEventList.push_back(handler);
+    sCbEventList[handler->mEvent].push_back(handler);
     return handler;
 }
 
@@ -137,7 +177,7 @@ WiFiEventHandler ESP8266WiFiGenericClass::onStationModeAuthModeChanged(std::func
         dst.newMode = src.new_mode;
         f(dst);
     });
-    sCbEventList.push_back(handler);
+    sCbEventList[handler->mEvent].push_back(handler);
     return handler;
 }
 
@@ -151,7 +191,7 @@ WiFiEventHandler ESP8266WiFiGenericClass::onStationModeGotIP(std::function<void(
         dst.gw = src.gw.addr;
         f(dst);
     });
-    sCbEventList.push_back(handler);
+    sCbEventList[handler->mEvent].push_back(handler);
     return handler;
 }
 
@@ -161,7 +201,7 @@ WiFiEventHandler ESP8266WiFiGenericClass::onStationModeDHCPTimeout(std::function
         (void) e;
         f();
     });
-    sCbEventList.push_back(handler);
+    sCbEventList[handler->mEvent].push_back(handler);
     return handler;
 }
 
@@ -174,7 +214,7 @@ WiFiEventHandler ESP8266WiFiGenericClass::onSoftAPModeStationConnected(std::func
         dst.aid = src.aid;
         f(dst);
     });
-    sCbEventList.push_back(handler);
+    sCbEventList[handler->mEvent].push_back(handler);
     return handler;
 }
 
@@ -187,7 +227,7 @@ WiFiEventHandler ESP8266WiFiGenericClass::onSoftAPModeStationDisconnected(std::f
         dst.aid = src.aid;
         f(dst);
     });
-    sCbEventList.push_back(handler);
+    sCbEventList[handler->mEvent].push_back(handler);
     return handler;
 }
 
@@ -200,7 +240,7 @@ WiFiEventHandler ESP8266WiFiGenericClass::onSoftAPModeProbeRequestReceived(std::
         dst.rssi = src.rssi;
         f(dst);
     });
-    sCbEventList.push_back(handler);
+    sCbEventList[handler->mEvent].push_back(handler);
     return handler;
 }
 
@@ -210,10 +250,24 @@ WiFiEventHandler ESP8266WiFiGenericClass::onWiFiModeChange(std::function<void(co
         WiFiEventModeChange& dst = *reinterpret_cast<WiFiEventModeChange*>(&e->event_info);
         f(dst);
     });
-    sCbEventList.push_back(handler);
+    sCbEventList[handler->mEvent].push_back(handler);
     return handler;
 }
 
+static void runEventHandlers(std::list<WiFiEventHandler>& handlers, System_Event_t* event)
+{
+    for(auto it = std::begin(handlers); it != std::end(handlers); ) {
+        WiFiEventHandler &handler = *it;
+        if (handler->canExpire() && handler.unique()) {
+            it = handlers.erase(it);
+        }
+        else {
+            (*handler)(event);
+            ++it;
+        }
+    }
+}
+
 /**
  * callback for WiFi events
  * @param arg
@@ -238,18 +292,18 @@ void ESP8266WiFiGenericClass::_eventCallback(void* arg)
         }
     }
 
-    for(auto it = std::begin(sCbEventList); it != std::end(sCbEventList); ) {
-        WiFiEventHandler &handler = *it;
-        if (handler->canExpire() && handler.unique()) {
-            it = sCbEventList.erase(it);
-        }
-        else {
-            (*handler)(event);
-            ++it;
+    if (event->event < WIFI_EVENT_MAX) {
+        for (auto& slot : sRawEventTable[event->event]) {
+            if (slot.cb) {
+                slot.cb(event, slot.arg);
+            }
         }
+        runEventHandlers(sCbEventList[event->event], event);
     }
+    runEventHandlers(sCbEventList[WIFI_EVENT_ANY], event);
 }
 
+
 /**
  * Return the current channel associated with the network
  * @return channel (1-13)
@@ -586,6 +640,163 @@ bool ESP8266WiFiGenericClass::isSleepLevelMax () {
 void wifi_dns_found_callback(const char *name, const ip_addr_t *ipaddr, void *callback_arg);
 
 static bool _dns_lookup_pending = false;
+static bool _dns_lookup_answered = false;
+
+namespace {
+
+struct DNSCacheEntry {
+    String name;
+    IPAddress ip;       // INADDR_NONE for a failed lookup
+    uint32_t expires;   // millis()
+};
+
+std::vector<DNSCacheEntry> _dnsCache;
+size_t _dnsCacheEntries = 0;
+uint32_t _dnsCacheTtl = 0;
+uint32_t _dnsCacheNegativeTtl = 0;
+
+// true when aHostname has a live entry, aResult is then its answer
+bool _dnsCacheGet(const char* aHostname, IPAddress& aResult)
+{
+    uint32_t now = millis();
+    for (const auto& entry : _dnsCache) {
+        if ((int32_t)(entry.expires - now) > 0 && !strcasecmp(entry.name.c_str(), aHostname)) {
+            aResult = entry.ip;
+            return true;
+        }
+    }
+    return false;
+}
+
+void _dnsCachePut(const char* aHostname, const IPAddress& aResult)
+{
+    uint32_t ttl = aResult.isSet() ? _dnsCacheTtl : _dnsCacheNegativeTtl;
+    if (!_dnsCacheEntries || !ttl) {
+        return;
+    }
+
+    DNSCacheEntry* slot = nullptr;
+    for (auto& entry : _dnsCache) {
+        if (!strcasecmp(entry.name.c_str(), aHostname)) {
+            slot = &entry;
+            break;
+        }
+    }
+    if (!slot) {
+        if (_dnsCache.size() < _dnsCacheEntries) {
+            _dnsCache.emplace_back();
+            slot = &_dnsCache.back();
+        } else {
+            // replace the entry closest to (or past) expiry
+            uint32_t now = millis();
+            slot = &_dnsCache.front();
+            for (auto& entry : _dnsCache) {
+                if ((int32_t)(entry.expires - now) < (int32_t)(slot->expires - now)) {
+                    slot = &entry;
+                }
+            }
+        }
+        slot->name = aHostname;
+    }
+    slot->ip = aResult.isSet() ? aResult : INADDR_NONE;
+    slot->expires = millis() + ttl;
+}
+
+// one per hostByNameAsync() lookup, lwIP's callback argument
+struct DNSRequest {
+    String name;
+    ESP8266WiFiGenericClass::DNSCallback cb;
+};
+
+void _dnsDeliver(DNSRequest* req, const IPAddress& aResult)
+{
+    _dnsCachePut(req->name.c_str(), aResult);
+    req->cb(req->name.c_str(), aResult);
+    delete req;
+}
+
+void _dnsAsyncFoundCallback(const char* name, const ip_addr_t* ipaddr, void* callback_arg)
+{
+    (void) name;
+    DNSRequest* req = reinterpret_cast<DNSRequest*>(callback_arg);
+    IPAddress result = ipaddr ? IPAddress(ipaddr) : INADDR_NONE;
+    // called from lwIP, hand over to loop() context
+    if (!schedule_function([req, result]() { _dnsDeliver(req, result); })) {
+        _dnsDeliver(req, result);
+    }
+}
+
+} // namespace
+
+/**
+ * Set up the DNS cache used by hostByName() and hostByNameAsync().
+ * Shrinking or disabling it drops all entries.
+ * @param entries           number of names kept, 0 disables the cache
+ * @param ttl_ms            how long a found address is kept
+ * @param negativeTtl_ms    how long a failed lookup is remembered, 0 for never
+ */
+void ESP8266WiFiGenericClass::setDNSCache(size_t entries, uint32_t ttl_ms, uint32_t negativeTtl_ms)
+{
+    if (entries < _dnsCache.size()) {
+        clearDNSCache();
+    }
+    _dnsCacheEntries = entries;
+    _dnsCacheTtl = ttl_ms;
+    _dnsCacheNegativeTtl = negativeTtl_ms;
+    _dnsCache.reserve(entries);
+}
+
+void ESP8266WiFiGenericClass::clearDNSCache()
+{
+    std::vector<DNSCacheEntry>().swap(_dnsCache);
+    _dnsCache.reserve(_dnsCacheEntries);
+}
+
+/**
+ * Resolve the given hostname without waiting for the answer.
+ * @param aHostname     Name to be resolved
+ * @param cb            called from loop() with the name and the address,
+ *                      which is not set when the lookup failed
+ * @return true if the lookup was started (or answered from a cache)
+ */
+bool ESP8266WiFiGenericClass::hostByNameAsync(const char* aHostname, DNSCallback cb)
+{
+    if (!aHostname || !cb) {
+        return false;
+    }
+
+    DNSRequest* req = new (std::nothrow) DNSRequest{aHostname, std::move(cb)};
+    if (!req) {
+        return false;
+    }
+
+    IPAddress result;
+    if (result.fromString(aHostname) || _dnsCacheGet(aHostname, result)) {
+        DEBUG_WIFI_GENERIC("[hostByNameAsync] Host: %s is a IP or cached\n", aHostname);
+        if (!schedule_function([req, result]() { req->cb(req->name.c_str(), result); delete req; })) {
+            delete req;
+            return false;
+        }
+        return true;
+    }
+
+    DEBUG_WIFI_GENERIC("[hostByNameAsync] request IP for: %s\n", aHostname);
+    ip_addr_t addr;
+#if LWIP_IPV4 && LWIP_IPV6
+    err_t err = dns_gethostbyname_addrtype(aHostname, &addr, &_dnsAsyncFoundCallback, req, LWIP_DNS_ADDRTYPE_DEFAULT);
+#else
+    err_t err = dns_gethostbyname(aHostname, &addr, &_dnsAsyncFoundCallback, req);
+#endif
+    if (err == ERR_OK) {
+        // in lwIP's table, lwIP won't call back
+        _dnsAsyncFoundCallback(aHostname, &addr, req);
+    } else if (err != ERR_INPROGRESS) {
+        DEBUG_WIFI_GENERIC("[hostByNameAsync] Host: %s lookup error: %d!\n", aHostname, (int)err);
+        delete req;
+        return false;
+    }
+    return true;
+}
 
 /**
  * Resolve the given hostname to an IP address.
@@ -611,6 +822,11 @@ int ESP8266WiFiGenericClass::hostByName(const char* aHostname, IPAddress& aResul
         return 1;
     }
 
+    if(_dnsCacheGet(aHostname, aResult)) {
+        DEBUG_WIFI_GENERIC("[hostByName] Host: %s cached: %s\n", aHostname, aResult.toString().c_str());
+        return aResult.isSet() ? 1 : 0;
+    }
+
     DEBUG_WIFI_GENERIC("[hostByName] request IP for: %s\n", aHostname);
 #if LWIP_IPV4 && LWIP_IPV6
     err_t err = dns_gethostbyname_addrtype(aHostname, &addr, &wifi_dns_found_callback, &aResult,LWIP_DNS_ADDRTYPE_DEFAULT);
@@ -619,8 +835,10 @@ int ESP8266WiFiGenericClass::hostByName(const char* aHostname, IPAddress& aResul
 #endif
     if(err == ERR_OK) {
         aResult = IPAddress(&addr);
+        _dnsCachePut(aHostname, aResult);
     } else if(err == ERR_INPROGRESS) {
         _dns_lookup_pending = true;
+        _dns_lookup_answered = false;
         delay(timeout_ms);
         // will resume on timeout or when wifi_dns_found_callback fires
         _dns_lookup_pending = false;
@@ -628,6 +846,10 @@ int ESP8266WiFiGenericClass::hostByName(const char* aHostname, IPAddress& aResul
         if(aResult.isSet()) {
             err = ERR_OK;
         }
+        // a timeout says nothing about the name, only cache real answers
+        if(_dns_lookup_answered) {
+            _dnsCachePut(aHostname, aResult);
+        }
     }
 
     if(err != 0) {
@@ -705,6 +927,7 @@ void wifi_dns_found_callback(const char *name, const ip_addr_t *ipaddr, void *ca
     if(ipaddr) {
         (*reinterpret_cast<IPAddress*>(callback_arg)) = IPAddress(ipaddr);
     }
+    _dns_lookup_answered = true;
     esp_schedule(); // break delay in hostByName
 }
 
@@ -718,12 +941,11 @@ bool ESP8266WiFiGenericClass::shutdownValidCRC (const WiFiState& state)
     return crc32(&state.state, sizeof(state.state)) == state.crc;
 }
 
-bool ESP8266WiFiGenericClass::shutdown (WiFiState& state, uint32 sleepUs)
+bool ESP8266WiFiGenericClass::saveState (WiFiState& state)
 {
-    bool persistent = _persistent;
-    WiFiMode_t before_off_mode = getMode();
+    WiFiMode_t mode = getMode();
 
-    if (before_off_mode & WIFI_STA)
+    if (mode & WIFI_STA)
     {
         bool ret = wifi_get_ip_info(STATION_IF, &state.state.ip);
         if (!ret)
@@ -741,24 +963,8 @@ bool ESP8266WiFiGenericClass::shutdown (WiFiState& state, uint32 sleepUs)
         state.state.channel = wifi_get_channel();
     }
 
-    // disable persistence in FW so in case of power failure
-    // it doesn't wake up in off mode.
-    // persistence state will be restored on WiFi resume.
-    WiFi.persistent(false);
-    if (!WiFi.forceSleepBegin(sleepUs))
-    {
-        // WIFI_OFF mode set by forceSleepBegin()
-        DEBUG_WIFI("core: error with forceSleepBegin()\n");
-        WiFi.mode(before_off_mode);
-        WiFi.persistent(persistent);
-        return false;
-    }
-
-    // WiFi is now in force-sleep mode
-    // finish filling state and process crc
-
-    state.state.persistent = persistent;
-    state.state.mode = before_off_mode;
+    state.state.persistent = _persistent;
+    state.state.mode = mode;
 
     uint8_t i = 0;
     for (auto& ntp: state.state.ntp)
@@ -778,6 +984,36 @@ bool ESP8266WiFiGenericClass::shutdown (WiFiState& state, uint32 sleepUs)
     return true;
 }
 
+bool ESP8266WiFiGenericClass::shutdown (WiFiState& state, uint32 sleepUs)
+{
+    bool persistent = _persistent;
+    WiFiMode_t before_off_mode = getMode();
+
+    if (!saveState(state))
+    {
+        return false;
+    }
+
+    // disable persistence in FW so in case of power failure
+    // it doesn't wake up in off mode.
+    // persistence state will be restored on WiFi resume.
+    WiFi.persistent(false);
+    if (!WiFi.forceSleepBegin(sleepUs))
+    {
+        // WIFI_OFF mode set by forceSleepBegin()
+        DEBUG_WIFI("core: error with forceSleepBegin()\n");
+        WiFi.mode(before_off_mode);
+        WiFi.persistent(persistent);
+        // do not resume from a state that was not shut down
+        state.crc++;
+        return false;
+    }
+
+    // WiFi is now in force-sleep mode
+
+    return true;
+}
+
 bool ESP8266WiFiGenericClass::shutdown (WiFiState& state) {
     return shutdown(state, 0);
 }
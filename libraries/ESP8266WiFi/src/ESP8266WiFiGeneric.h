@@ -42,6 +42,14 @@ typedef std::shared_ptr<WiFiEventHandlerOpaque> WiFiEventHandler;
 
 typedef void (*WiFiEventCb)(WiFiEvent_t);
 
+// SDK's System_Event_t
+struct _esp_event;
+typedef void (*WiFiEventRawCb)(struct _esp_event* event, void* arg);
+
+#ifndef WIFI_EVENT_RAW_SLOTS
+#define WIFI_EVENT_RAW_SLOTS 2 // onEventRaw() handlers per event
+#endif
+
 enum class DNSResolveType: uint8_t
 {
     DNS_AddrType_IPv4 = 0,	// LWIP_DNS_ADDRTYPE_IPV4 = 0
@@ -74,6 +82,12 @@ class ESP8266WiFiGenericClass {
         WiFiEventHandler onSoftAPModeProbeRequestReceived(std::function<void(const WiFiEventSoftAPModeProbeRequestReceived&)>);
         WiFiEventHandler onWiFiModeChange(std::function<void(const WiFiEventModeChange&)>);
 
+        // Plain function called with the SDK's event, without allocation or
+        // copy, before the handlers above.  WIFI_EVENT_RAW_SLOTS handlers
+        // per event, WIFI_EVENT_ANY is not accepted.
+        bool onEventRaw(WiFiEvent_t event, WiFiEventRawCb cb, void* arg = nullptr);
+        bool removeEventRaw(WiFiEvent_t event, WiFiEventRawCb cb, void* arg = nullptr);
+
         uint8_t channel(void);
 
         bool setSleepMode(WiFiSleepType_t type, uint8_t listenInterval = 0);
@@ -137,6 +151,9 @@ class ESP8266WiFiGenericClass {
         bool shutdown(WiFiState& stateSave);
         bool shutdown(WiFiState& stateSave, uint32 sleepUs);
         bool resumeFromShutdown(WiFiState& savedState);
+        // fill stateSave from the current connection without shutting down,
+        // resumeFromShutdown() reconnects from it
+        bool saveState(WiFiState& stateSave);
 
         static bool shutdownValidCRC (const WiFiState& state);
         static void preinitWiFiOff () __attribute__((deprecated("WiFi is off by default at boot, use enableWiFiAtBoot() for legacy behavior")));
@@ -159,6 +176,19 @@ class ESP8266WiFiGenericClass {
 #if LWIP_IPV4 && LWIP_IPV6
         int hostByName(const char* aHostname, IPAddress& aResult, uint32_t timeout_ms, DNSResolveType resolveType);
 #endif
+
+        // Resolve without blocking. cb(name, ip) is called later from loop()
+        // context, ip is not set when the lookup failed. Several lookups can
+        // be in flight at once. Returns false when the lookup couldn't start.
+        using DNSCallback = std::function<void(const char* aHostname, const IPAddress& aResult)>;
+        bool hostByNameAsync(const char* aHostname, DNSCallback cb);
+
+        // Keep answers for up to `entries` names above lwIP's own table,
+        // for both hostByName() and hostByNameAsync(). lwIP doesn't pass the
+        // record TTL up, so found names are kept ttl_ms at most and failed
+        // lookups negativeTtl_ms. 0 entries (the default) disables the cache.
+        void setDNSCache(size_t entries, uint32_t ttl_ms = 60000, uint32_t negativeTtl_ms = 5000);
+        void clearDNSCache();
         bool getPersistent();
 
     protected:
@@ -20,18 +20,49 @@
 extern "C"
 {
 #include "lwip/etharp.h" // gratuitous arp
+#include "user_interface.h" // wifi_get_sleep_type()
 } // extern "C"
 
 #include <Schedule.h>
 
 #include "ESP8266WiFiGratuitous.h"
 
-namespace experimental
+namespace
 {
 
-ETSTimer* ESP8266WiFiGratuitous::_timer = nullptr;
+// STA interface whose linkoutput is observed, and its original linkoutput
+netif* hookedInterface = nullptr;
+netif_linkoutput_fn hookedLinkoutput = nullptr;
 
-void ESP8266WiFiGratuitous::stationKeepAliveNow ()
+// unicast packets were sent during the current interval
+bool unicastSent = false;
+// a gratuitous ARP waits for the radio to be woken by other traffic
+bool pending = false;
+
+err_t linkoutputHook (netif* interface, pbuf* p)
+{
+    err_t ret = hookedLinkoutput(interface, p);
+
+    if (ret == ERR_OK && p->len >= 6)
+    {
+        if ((static_cast<const uint8_t*>(p->payload)[0] & 1) == 0)
+        {
+            // the AP has just seen us
+            unicastSent = true;
+            pending = false;
+        }
+        else if (pending)
+        {
+            // the radio is awake anyway
+            pending = false;
+            schedule_function([]() { experimental::ESP8266WiFiGratuitous::stationKeepAliveNow(); });
+        }
+    }
+
+    return ret;
+}
+
+netif* stationInterface ()
 {
     for (netif* interface = netif_list; interface != nullptr; interface = interface->next)
         if (
@@ -40,16 +71,78 @@ void ESP8266WiFiGratuitous::stationKeepAliveNow ()
             && interface->num == STATION_IF
             && (!ip4_addr_isany_val(*netif_ip4_addr(interface))))
         {
-            etharp_gratuitous(interface);
-            break;
+            return interface;
         }
+    return nullptr;
+}
+
+void hook ()
+{
+    // the interface may be set up again after a reconnection
+    netif* interface = stationInterface();
+    if (interface && interface->linkoutput != linkoutputHook)
+    {
+        hookedLinkoutput = interface->linkoutput;
+        interface->linkoutput = linkoutputHook;
+        hookedInterface = interface;
+    }
+}
+
+void unhook ()
+{
+    if (hookedInterface && hookedInterface->linkoutput == linkoutputHook)
+        hookedInterface->linkoutput = hookedLinkoutput;
+    hookedInterface = nullptr;
+    unicastSent = false;
+    pending = false;
+}
+
+} // namespace
+
+namespace experimental
+{
+
+ETSTimer* ESP8266WiFiGratuitous::_timer = nullptr;
+uint32_t ESP8266WiFiGratuitous::_sent = 0;
+uint32_t ESP8266WiFiGratuitous::_skipped = 0;
+
+void ESP8266WiFiGratuitous::stationKeepAliveNow ()
+{
+    netif* interface = stationInterface();
+    if (interface)
+    {
+        etharp_gratuitous(interface);
+        _sent++;
+    }
+}
+
+void ESP8266WiFiGratuitous::intervalElapsed ()
+{
+    hook();
+
+    if (unicastSent)
+    {
+        unicastSent = false;
+        _skipped++;
+        return;
+    }
+
+    if (pending || wifi_get_sleep_type() == NONE_SLEEP_T)
+    {
+        // no traffic came along during a whole interval, or the radio is always on
+        pending = false;
+        stationKeepAliveNow();
+        return;
+    }
+
+    pending = true;
 }
 
 void ESP8266WiFiGratuitous::scheduleItForNextYieldOnce (void*)
 {
     schedule_recurrent_function_us([]()
     {
-        ESP8266WiFiGratuitous::stationKeepAliveNow();
+        ESP8266WiFiGratuitous::intervalElapsed();
         return false;
     }, 0);
 }
@@ -62,11 +155,16 @@ bool ESP8266WiFiGratuitous::stationKeepAliveSetIntervalMs (uint32_t ms)
         free(_timer);
         _timer = nullptr;
     }
+    unhook();
 
     if (ms)
     {
+        _sent = 0;
+        _skipped = 0;
+
         // send one now
         stationKeepAliveNow();
+        hook();
 
         _timer = (ETSTimer*)malloc(sizeof(ETSTimer));
         if (_timer == nullptr)
@@ -33,6 +33,9 @@ public:
     // disable(0) or enable/update automatic sending of Gratuitous ARP packets.
     // A gratuitous ARP packet is immediately sent when calling this function, then
     // based on a time interval in milliseconds, default = 1s
+    // An interval in which unicast packets were sent needs no gratuitous ARP.
+    // With modem or light sleep enabled, a due packet waits up to one more
+    // interval for other outgoing traffic, so that it does not wake the radio by itself.
     // return value: true when started, false otherwise
     static bool stationKeepAliveSetIntervalMs (uint32_t ms = 1000);
 
@@ -42,11 +45,18 @@ public:
     // immediately send one gratuitous ARP from STA
     static void stationKeepAliveNow ();
 
+    // number of gratuitous ARPs sent and skipped since keep-alive was started
+    static uint32_t stationKeepAliveSent () { return _sent; }
+    static uint32_t stationKeepAliveSkipped () { return _skipped; }
+
 protected:
 
     static void scheduleItForNextYieldOnce (void*);
+    static void intervalElapsed ();
 
     static ETSTimer* _timer;
+    static uint32_t _sent;
+    static uint32_t _skipped;
 };
 
 }; // experimental::
@@ -25,6 +25,7 @@
 
 #include "PolledTimeout.h"
 #include "ESP8266WiFiMulti.h"
+#include "include/WiFiState.h"
 #include <limits.h>
 #include <string.h>
 
@@ -188,6 +189,11 @@ wl_status_t ESP8266WiFiMulti::run(uint32_t connectTimeoutMs)
     if (_firstRun) {
         _firstRun = false;
 
+        // Connect to last known good AP without scanning
+        if (resumeLastKnownAP(connectTimeoutMs) == WL_CONNECTED) {
+            return WL_CONNECTED;
+        }
+
         // Check if previous WiFi connection saved
         if (strlen(WiFi.SSID().c_str())) {
             DEBUG_WIFI_MULTI("[WIFIM] Connecting saved WiFi\n");
@@ -197,6 +203,9 @@ wl_status_t ESP8266WiFiMulti::run(uint32_t connectTimeoutMs)
 
             // Wait for status change
             status = waitWiFiConnect(connectTimeoutMs);
+            if (status == WL_CONNECTED) {
+                saveLastKnownAP();
+            }
         }
     }
 
@@ -215,11 +224,78 @@ wl_status_t ESP8266WiFiMulti::run(uint32_t connectTimeoutMs)
     }
 
     // Try to connect to multiple WiFi's with strongest signal (RSSI)
-    return connectWiFiMulti(connectTimeoutMs);
+    status = connectWiFiMulti(connectTimeoutMs);
+    if (status == WL_CONNECTED) {
+        saveLastKnownAP();
+    }
+
+    return status;
 }
 
 /**
- * @brief Start WiFi scan
+ * @brief Connect to the AP saved by saveLastKnownAP(), using its BSSID, channel and IP configuration
+ * @param connectTimeoutMs
+ *      WiFi connect timeout in ms
+ * @return
+ *      WiFi connection status
+ */
+wl_status_t ESP8266WiFiMulti::resumeLastKnownAP(uint32_t connectTimeoutMs)
+{
+    if (_rtcUserDataSlot < 0) {
+        return WL_DISCONNECTED;
+    }
+
+    WiFiState state;
+    if (!ESP.rtcUserMemoryRead(_rtcUserDataSlot, reinterpret_cast<uint32_t *>(&state), sizeof(state)) ||
+        !WiFi.shutdownValidCRC(state)) {
+        DEBUG_WIFI_MULTI("[WIFIM] No last known AP\n");
+        return WL_DISCONNECTED;
+    }
+
+    // The AP must still be in the AP list, with the same passphrase
+    char ssid[sizeof(station_config::ssid) + 1];
+    memcpy(ssid, state.state.fwconfig.ssid, sizeof(station_config::ssid));
+    ssid[sizeof(station_config::ssid)] = 0;
+    char passphrase[sizeof(station_config::password) + 1];
+    memcpy(passphrase, state.state.fwconfig.password, sizeof(station_config::password));
+    passphrase[sizeof(station_config::password)] = 0;
+    if (!APlistExists(ssid, passphrase)) {
+        DEBUG_WIFI_MULTI("[WIFIM] Last known AP %s not in AP list\n", ssid);
+        return WL_NO_SSID_AVAIL;
+    }
+
+    DEBUG_WIFI_MULTI("[WIFIM] Resume last known AP %s, CH: %d\n", ssid, state.state.channel);
+
+    if (WiFi.resumeFromShutdown(state) && (waitWiFiConnect(connectTimeoutMs) == WL_CONNECTED)) {
+        return WL_CONNECTED;
+    }
+
+    DEBUG_WIFI_MULTI("[WIFIM] Resume failed\n");
+
+    // Go back to DHCP, the saved address may not be valid on the AP found by scanning
+    WiFi.config(IPAddress(), IPAddress(), IPAddress());
+
+    return WL_CONNECT_FAILED;
+}
+
+/**
+ * @brief Save the current connection to RTC user memory for resumeLastKnownAP()
+ */
+void ESP8266WiFiMulti::saveLastKnownAP()
+{
+    if (_rtcUserDataSlot < 0) {
+        return;
+    }
+
+    WiFiState state;
+    if (!WiFi.saveState(state) ||
+        !ESP.rtcUserMemoryWrite(_rtcUserDataSlot, reinterpret_cast<uint32_t *>(&state), sizeof(state))) {
+        DEBUG_WIFI_MULTI("[WIFIM] Could not save last known AP\n");
+    }
+}
+
+/**
+ * @brief Start WiFi scan, or reuse a scan result younger than the scan cache max age
  * @retval >0
  *      Number of detected WiFi SSID's
  * @retval 0
@@ -231,14 +307,24 @@ int8_t ESP8266WiFiMulti::startScan()
 {
     int8_t scanResult;
 
+    // Remove previous WiFi SSID/password
+    WiFi.disconnect();
+
+    // Reuse a recent scan of all channels, e.g. by another WiFi user
+    if (_scanCacheMaxAgeMs) {
+        scanResult = WiFi.scanCached(_scanCacheMaxAgeMs);
+        if (scanResult >= 0) {
+            DEBUG_WIFI_MULTI("[WIFIM] Using scan from %u ms ago\n", WiFi.scanAge());
+            printWiFiScan();
+            return scanResult;
+        }
+    }
+
     DEBUG_WIFI_MULTI("[WIFIM] Start scan\n");
 
     // Clean previous scan
     WiFi.scanDelete();
 
-    // Remove previous WiFi SSID/password
-    WiFi.disconnect();
-
     // Start wifi scan in async mode
     WiFi.scanNetworks(true);
 
@@ -50,6 +50,11 @@
 #define WIFI_SCAN_TIMEOUT_MS        5000
 #endif
 
+//! Default maximum age in ms of a scan result reused by run(), 0 to always scan
+#ifndef WIFI_SCAN_CACHE_MAX_AGE_MS
+#define WIFI_SCAN_CACHE_MAX_AGE_MS  0
+#endif
+
 struct WifiAPEntry {
     char *ssid;
     char *passphrase;
@@ -70,15 +75,26 @@ public:
 
     void cleanAPlist();
 
+    void setScanCacheMaxAge(uint32_t maxAgeMs) { _scanCacheMaxAgeMs = maxAgeMs; }
+
+    // Keep the last-known-good AP (BSSID, channel, IP configuration) in RTC user memory,
+    // starting at rtcUserDataSlot, and try it first without scanning after a reboot or deep sleep
+    void enableFastReconnect(uint32_t rtcUserDataSlot) { _rtcUserDataSlot = rtcUserDataSlot; }
+    void disableFastReconnect() { _rtcUserDataSlot = -1; }
+
 private:
     WifiAPlist _APlist;
     bool _firstRun;
+    uint32_t _scanCacheMaxAgeMs = WIFI_SCAN_CACHE_MAX_AGE_MS;
+    int32_t _rtcUserDataSlot = -1;
 
     bool APlistAdd(const char *ssid, const char *passphrase = NULL);
     bool APlistExists(const char *ssid, const char *passphrase = NULL);
     void APlistClean();
 
     wl_status_t connectWiFiMulti(uint32_t connectTimeoutMs);
+    wl_status_t resumeLastKnownAP(uint32_t connectTimeoutMs);
+    void saveLastKnownAP();
     int8_t startScan();
     void printWiFiScan();
 };
@@ -40,9 +40,13 @@ extern "C" {
 #include "lwip/err.h"
 #include "lwip/dns.h"
 #include "lwip/dhcp.h"
+#include "lwip/prot/dhcp.h"
 }
 
 #include "debug.h"
+#include "include/WiFiState.h"
+#include <Schedule.h>
+#include <coredecls.h>
 
 extern "C" void esp_schedule();
 extern "C" void esp_yield();
@@ -596,6 +600,96 @@ int8_t ESP8266WiFiSTAClass::RSSI(void) {
     return wifi_station_get_rssi();
 }
 
+// -----------------------------------------------------------------------------------------------------------------------
+// ------------------------------------------------- DHCP lease caching --------------------------------------------------
+// -----------------------------------------------------------------------------------------------------------------------
+
+extern netif netif_git[2];
+
+static WiFiDhcpLease reusedDhcpLease;
+static WiFiEventHandler reusedDhcpLeaseHandler;
+
+/**
+ * check the crc of a lease read back from RTC user memory
+ * @param lease     lease filled by saveDhcpLease()
+ * @return true if the lease can be reused
+ */
+bool ESP8266WiFiSTAClass::dhcpLeaseValid(const WiFiDhcpLease& lease) {
+    return crc32(&lease.state, sizeof(lease.state)) == lease.crc;
+}
+
+/**
+ * save the address obtained by the DHCP client
+ * @param lease     filled with the current lease
+ * @return false if the current address was not obtained by DHCP
+ */
+bool ESP8266WiFiSTAClass::saveDhcpLease(WiFiDhcpLease& lease) {
+    netif* intf = &netif_git[STATION_IF];
+    const dhcp* client = netif_dhcp_data(intf);
+    if(_useStaticIp || !client || !dhcp_supplied_address(intf)) {
+        DEBUG_WIFI("[DHCP] no lease to save\n");
+        return false;
+    }
+
+    lease.state.ip = *netif_ip4_addr(intf);
+    lease.state.netmask = *netif_ip4_netmask(intf);
+    lease.state.gw = *netif_ip4_gw(intf);
+    lease.state.server = *ip_2_ip4(&client->server_ip_addr);
+    lease.state.leaseSeconds = client->offered_t0_lease;
+    lease.crc = crc32(&lease.state, sizeof(lease.state));
+    return true;
+}
+
+/**
+ * request the saved lease on the next connection with DHCP INIT-REBOOT
+ * the server answers the single DHCPREQUEST with ACK, or NAK when the lease is no longer valid
+ * @param lease     lease filled by saveDhcpLease()
+ * @return false if the lease is not valid
+ */
+bool ESP8266WiFiSTAClass::reuseDhcpLease(const WiFiDhcpLease& lease) {
+    if(!dhcpLeaseValid(lease)) {
+        return false;
+    }
+
+    reusedDhcpLease = lease;
+    reusedDhcpLeaseHandler = WiFi.onStationModeConnected([](const WiFiEventStationModeConnected&) {
+        // The firmware starts the DHCP client around this event.
+        // Try again once from the scheduler in case it has not done so yet.
+        if(!_requestDhcpLease()) {
+            schedule_function([]() { _requestDhcpLease(); });
+        }
+        reusedDhcpLeaseHandler.reset(); // only the first connection after reuseDhcpLease()
+    });
+    return true;
+}
+
+/**
+ * private
+ * turn the DISCOVER just sent by the DHCP client into an INIT-REBOOT for the saved lease
+ * @return false if the DHCP client is not waiting for an offer
+ */
+bool ESP8266WiFiSTAClass::_requestDhcpLease() {
+    netif* intf = &netif_git[STATION_IF];
+    dhcp* client = netif_dhcp_data(intf);
+    if(_useStaticIp || !client || client->state != DHCP_STATE_SELECTING) {
+        DEBUG_WIFI("[DHCP] lease not reused (state %d)\n", client ? client->state : -1);
+        return false;
+    }
+
+    client->offered_ip_addr = reusedDhcpLease.state.ip;
+    client->offered_sn_mask = reusedDhcpLease.state.netmask;
+    client->offered_gw_addr = reusedDhcpLease.state.gw;
+    ip_addr_copy_from_ip4(client->server_ip_addr, reusedDhcpLease.state.server);
+
+    // lwIP reboots a bound client when the network changes:
+    // DHCPREQUEST for offered_ip_addr, DISCOVER again after a NAK or the reboot retries
+    client->state = DHCP_STATE_BOUND;
+    dhcp_network_changed(intf);
+
+    DEBUG_WIFI("[DHCP] requesting saved lease %s\n", IPAddress(reusedDhcpLease.state.ip).toString().c_str());
+    return true;
+}
+
 
 
 // -----------------------------------------------------------------------------------------------------------------------
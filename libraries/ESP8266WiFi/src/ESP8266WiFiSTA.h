@@ -29,6 +29,7 @@
 #include "user_interface.h"
 #include "LwipIntf.h"
 
+struct WiFiDhcpLease;
 
 class ESP8266WiFiSTAClass: public LwipIntf {
         // ----------------------------------------------------------------------------------------------
@@ -83,11 +84,20 @@ class ESP8266WiFiSTAClass: public LwipIntf {
 
         static void enableInsecureWEP (bool enable = true) { _useInsecureWEP = enable; }
 
+        // DHCP lease caching: the lease can be kept in RTC user memory across deep sleep.
+        // reuseDhcpLease() makes the next connection request it with a single DHCPREQUEST
+        // (INIT-REBOOT) instead of DISCOVER/OFFER/REQUEST/ACK, and falls back to DISCOVER on NAK or timeout.
+        bool saveDhcpLease(WiFiDhcpLease& lease);
+        bool reuseDhcpLease(const WiFiDhcpLease& lease);
+        static bool dhcpLeaseValid(const WiFiDhcpLease& lease);
+
     protected:
 
         static bool _useStaticIp;
         static bool _useInsecureWEP;
 
+        static bool _requestDhcpLease();
+
     // ----------------------------------------------------------------------------------------------
     // ------------------------------------ STA remote configure  -----------------------------------
     // ----------------------------------------------------------------------------------------------
@@ -36,6 +36,7 @@ extern "C" {
 }
 
 #include "debug.h"
+#include <Schedule.h>
 
 extern "C" void esp_schedule();
 extern "C" void esp_yield();
@@ -44,7 +45,7 @@ extern "C" void esp_yield();
 // ---------------------------------------------------- Private functions ------------------------------------------------
 // -----------------------------------------------------------------------------------------------------------------------
 
-
+static constexpr uint16_t ALL_CHANNELS_MASK = 0x7ffe; // bits 1 to 14
 
 
 // -----------------------------------------------------------------------------------------------------------------------
@@ -58,6 +59,15 @@ bool ESP8266WiFiScanClass::_scanComplete = false;
 size_t ESP8266WiFiScanClass::_scanCount = 0;
 void* ESP8266WiFiScanClass::_scanResult = 0;
 
+struct scan_config ESP8266WiFiScanClass::_scanConfig;
+uint8_t ESP8266WiFiScanClass::_scanSsid[33];
+uint8_t ESP8266WiFiScanClass::_scanChannelList[14];
+uint8_t ESP8266WiFiScanClass::_scanChannelCount = 0;
+uint8_t ESP8266WiFiScanClass::_scanChannelIndex = 0;
+uint16_t ESP8266WiFiScanClass::_scanChannelMask = 0;
+bool ESP8266WiFiScanClass::_scanFiltered = false;
+uint32_t ESP8266WiFiScanClass::_scanTime = 0;
+
 std::function<void(int)> ESP8266WiFiScanClass::_onComplete;
 
 /**
@@ -69,10 +79,62 @@ std::function<void(int)> ESP8266WiFiScanClass::_onComplete;
  * @return Number of discovered networks
  */
 int8_t ESP8266WiFiScanClass::scanNetworks(bool async, bool show_hidden, uint8 channel, uint8* ssid) {
+    return scanChannels(&channel, 1, async, show_hidden, ssid);
+}
+
+/**
+ * Start scan of a list of WiFi channels, one channel after the other.
+ * Scanning a few known channels with a short dwell time takes a fraction of a full scan,
+ * and leaves the current channel for a shorter time.
+ * The results of all channels are collected into one result list.
+ * @param channels      channels to scan (0 for all channels)
+ * @param channelCount  number of entries in channels, at most 14
+ * @param async         run in async mode
+ * @param show_hidden   show hidden networks
+ * @param ssid*         scan for only this ssid (NULL for all ssid's)
+ * @param scanType      WIFI_SCAN_TYPE_ACTIVE (send probe requests) or WIFI_SCAN_TYPE_PASSIVE (listen for beacons)
+ * @param dwellMs       time spent on each channel (0 for the SDK default), maximum time for active scans
+ * @return Number of discovered networks
+ */
+int8_t ESP8266WiFiScanClass::scanChannels(const uint8_t* channels, uint8_t channelCount, bool async, bool show_hidden, uint8* ssid,
+                                          wifi_scan_type_t scanType, uint32_t dwellMs) {
     if(ESP8266WiFiScanClass::_scanStarted) {
         return WIFI_SCAN_RUNNING;
     }
 
+    if(!channels || channelCount == 0 || channelCount > sizeof(_scanChannelList)) {
+        return WIFI_SCAN_FAILED;
+    }
+
+    memcpy(_scanChannelList, channels, channelCount);
+    _scanChannelCount = channelCount;
+
+    memset(&_scanConfig, 0, sizeof(_scanConfig));
+    _scanFiltered = (ssid != NULL);
+    if(ssid) {
+        // ssid must stay valid until the last channel has been scanned
+        strncpy(reinterpret_cast<char*>(_scanSsid), reinterpret_cast<const char*>(ssid), sizeof(_scanSsid) - 1);
+        _scanSsid[sizeof(_scanSsid) - 1] = 0;
+        _scanConfig.ssid = _scanSsid;
+    }
+    _scanConfig.show_hidden = show_hidden;
+    _scanConfig.scan_type = scanType;
+    if(scanType == WIFI_SCAN_TYPE_PASSIVE) {
+        _scanConfig.scan_time.passive = dwellMs;
+    } else {
+        _scanConfig.scan_time.active.max = dwellMs;
+    }
+
+    return _startScan(async);
+}
+
+/**
+ * private
+ * start scanning the first channel of _scanChannelList
+ * @param async         run in async mode
+ * @return Number of discovered networks
+ */
+int8_t ESP8266WiFiScanClass::_startScan(bool async) {
     ESP8266WiFiScanClass::_scanAsync = async;
 
     WiFi.enableSTA(true);
@@ -84,26 +146,45 @@ int8_t ESP8266WiFiScanClass::scanNetworks(bool async, bool show_hidden, uint8 ch
 
     scanDelete();
 
-    struct scan_config config;
-    memset(&config, 0, sizeof(config));
-    config.ssid = ssid;
-    config.channel = channel;
-    config.show_hidden = show_hidden;
-    if(wifi_station_scan(&config, reinterpret_cast<scan_done_cb_t>(&ESP8266WiFiScanClass::_scanDone))) {
-        ESP8266WiFiScanClass::_scanComplete = false;
-        ESP8266WiFiScanClass::_scanStarted = true;
-
-        if(ESP8266WiFiScanClass::_scanAsync) {
-            delay(0); // time for the OS to trigger the scan
-            return WIFI_SCAN_RUNNING;
+    _scanChannelIndex = 0;
+    _scanChannelMask = 0;
+    if(!_scanNextChannel()) {
+        return WIFI_SCAN_FAILED;
+    }
+
+    if(ESP8266WiFiScanClass::_scanAsync) {
+        delay(0); // time for the OS to trigger the scan
+        return WIFI_SCAN_RUNNING;
+    }
+
+    esp_yield(); // will resume when _scanDone fires
+    while(ESP8266WiFiScanClass::_scanStarted) {
+        // more channels to go
+        if(!_scanNextChannel()) {
+            _scanTime = millis();
+            _scanStarted = false;
+            _scanComplete = true;
+            break;
         }
+        esp_yield();
+    }
+    return ESP8266WiFiScanClass::_scanCount;
+}
 
-        esp_yield(); // will resume when _scanDone fires
-        return ESP8266WiFiScanClass::_scanCount;
-    } else {
-        return WIFI_SCAN_FAILED;
+/**
+ * private
+ * start scanning _scanChannelList[_scanChannelIndex]
+ * @return true if the SDK accepted the scan
+ */
+bool ESP8266WiFiScanClass::_scanNextChannel() {
+    _scanConfig.channel = _scanChannelList[_scanChannelIndex];
+    if(!wifi_station_scan(&_scanConfig, reinterpret_cast<scan_done_cb_t>(&ESP8266WiFiScanClass::_scanDone))) {
+        return false;
     }
 
+    ESP8266WiFiScanClass::_scanComplete = false;
+    ESP8266WiFiScanClass::_scanStarted = true;
+    return true;
 }
 
 /**
@@ -147,6 +228,36 @@ void ESP8266WiFiScanClass::scanDelete() {
     _scanComplete = false;
 }
 
+/**
+ * age of the last completed scan result
+ * @return milliseconds since the scan completed, or UINT32_MAX if there is no result
+ */
+uint32_t ESP8266WiFiScanClass::scanAge() {
+    if(!_scanComplete) {
+        return UINT32_MAX;
+    }
+    return millis() - _scanTime;
+}
+
+/**
+ * reuse the last scan result instead of scanning again
+ * only results of scans without ssid filter are reused
+ * @param maxAgeMs  maximum accepted age of the result
+ * @param channel   channel which must have been scanned (0 for all channels)
+ * @return number of networks in the result, or WIFI_SCAN_FAILED if there is no fresh result covering channel
+ */
+int8_t ESP8266WiFiScanClass::scanCached(uint32_t maxAgeMs, uint8 channel) {
+    if(_scanStarted || _scanFiltered || scanAge() > maxAgeMs) {
+        return WIFI_SCAN_FAILED;
+    }
+
+    uint16_t required = channel ? (1 << channel) : ALL_CHANNELS_MASK;
+    if((_scanChannelMask & required) != required) {
+        return WIFI_SCAN_FAILED;
+    }
+
+    return ESP8266WiFiScanClass::_scanCount;
+}
 
 /**
  * loads all infos from a scanned wifi in to the ptr parameters
@@ -294,31 +405,52 @@ bool ESP8266WiFiScanClass::isHidden(uint8_t i) {
  * @param status STATUS
  */
 void ESP8266WiFiScanClass::_scanDone(void* result, int status) {
-    if(status != OK) {
-        ESP8266WiFiScanClass::_scanCount = 0;
-        ESP8266WiFiScanClass::_scanResult = 0;
-    } else {
+    bool lastChannel = true;
+
+    if(status == OK) {
 
-        int i = 0;
+        size_t i = 0;
         bss_info* head = reinterpret_cast<bss_info*>(result);
 
         for(bss_info* it = head; it; it = STAILQ_NEXT(it, next), ++i)
             ;
-        ESP8266WiFiScanClass::_scanCount = i;
-        if(i == 0) {
-            ESP8266WiFiScanClass::_scanResult = 0;
-        } else {
-            bss_info* copied_info = new bss_info[i];
-            i = 0;
+        if(i != 0) {
+            // append to the results of the previous channels
+            bss_info* copied_info = new bss_info[ESP8266WiFiScanClass::_scanCount + i];
+            bss_info* previous_info = reinterpret_cast<bss_info*>(ESP8266WiFiScanClass::_scanResult);
+            if(previous_info) {
+                memcpy(copied_info, previous_info, ESP8266WiFiScanClass::_scanCount * sizeof(bss_info));
+                delete[] previous_info;
+            }
+            i = ESP8266WiFiScanClass::_scanCount;
             for(bss_info* it = head; it; it = STAILQ_NEXT(it, next), ++i) {
                 memcpy(copied_info + i, it, sizeof(bss_info));
             }
 
             ESP8266WiFiScanClass::_scanResult = copied_info;
+            ESP8266WiFiScanClass::_scanCount = i;
         }
 
+        uint8_t channel = _scanChannelList[_scanChannelIndex];
+        _scanChannelMask |= channel ? (1 << channel) : ALL_CHANNELS_MASK;
+        lastChannel = (++_scanChannelIndex >= _scanChannelCount);
+    }
+
+    if(!lastChannel) {
+        if(!ESP8266WiFiScanClass::_scanAsync) {
+            esp_schedule(); // resume scanNetworks, which starts the next channel
+        } else {
+            // the SDK does not accept a new scan from within its scan callback
+            schedule_function([]() {
+                if(!_scanNextChannel()) {
+                    _scanDone(nullptr, FAIL);
+                }
+            });
+        }
+        return;
     }
 
+    ESP8266WiFiScanClass::_scanTime = millis();
     ESP8266WiFiScanClass::_scanStarted = false;
     ESP8266WiFiScanClass::_scanComplete = true;
 
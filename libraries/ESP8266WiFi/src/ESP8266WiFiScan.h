@@ -37,9 +37,17 @@ class ESP8266WiFiScanClass {
         int8_t scanNetworks(bool async = false, bool show_hidden = false, uint8 channel = 0, uint8* ssid = NULL);
         void scanNetworksAsync(std::function<void(int)> onComplete, bool show_hidden = false);
 
+        // targeted scan: only the listed channels, with an optional ssid filter and dwell time per channel
+        int8_t scanChannels(const uint8_t* channels, uint8_t channelCount, bool async = false, bool show_hidden = false, uint8* ssid = NULL,
+                            wifi_scan_type_t scanType = WIFI_SCAN_TYPE_ACTIVE, uint32_t dwellMs = 0);
+
         int8_t scanComplete();
         void scanDelete();
 
+        // scan result cache
+        uint32_t scanAge();
+        int8_t scanCached(uint32_t maxAgeMs, uint8 channel = 0);
+
         // scan result
         bool getNetworkInfo(uint8_t networkItem, String &ssid, uint8_t &encryptionType, int32_t &RSSI, uint8_t* &BSSID, int32_t &channel, bool &isHidden);
 
@@ -60,8 +68,19 @@ class ESP8266WiFiScanClass {
         static size_t _scanCount;
         static void* _scanResult;
 
+        static struct scan_config _scanConfig;
+        static uint8_t _scanSsid[33];
+        static uint8_t _scanChannelList[14];
+        static uint8_t _scanChannelCount;
+        static uint8_t _scanChannelIndex;
+        static uint16_t _scanChannelMask;
+        static bool _scanFiltered;
+        static uint32_t _scanTime;
+
         static std::function<void(int)> _onComplete;
 
+        int8_t _startScan(bool async);
+        static bool _scanNextChannel();
         static void _scanDone(void* result, int status);
         static void * _getScanInfoByIndex(int i);
 
@@ -62,6 +62,11 @@ void WiFiClient::setDefaultSync (bool sync)
     defaultSync = sync;
 }
 
+bool WiFiClient::setTxPool (size_t bytes)
+{
+    return ClientContext::setTxPool(bytes);
+}
+
 bool WiFiClient::getDefaultNoDelay ()
 {
     return defaultNoDelay;
@@ -138,7 +143,7 @@ int WiFiClient::connect(const String& host, uint16_t port)
     return connect(host.c_str(), port);
 }
 
-int WiFiClient::connect(IPAddress ip, uint16_t port)
+bool WiFiClient::_newContext()
 {
     if (_client) {
         stop();
@@ -148,7 +153,7 @@ int WiFiClient::connect(IPAddress ip, uint16_t port)
 
     tcp_pcb* pcb = tcp_new();
     if (!pcb)
-        return 0;
+        return false;
 
     if (_localPort > 0) {
         pcb->local_port = _localPort++;
@@ -157,6 +162,14 @@ int WiFiClient::connect(IPAddress ip, uint16_t port)
     _client = new ClientContext(pcb, nullptr, nullptr);
     _client->ref();
     _client->setTimeout(_timeout);
+    return true;
+}
+
+int WiFiClient::connect(IPAddress ip, uint16_t port)
+{
+    if (!_newContext())
+        return 0;
+
     int res = _client->connect(ip, port);
     if (res == 0) {
         _client->unref();
@@ -170,6 +183,29 @@ int WiFiClient::connect(IPAddress ip, uint16_t port)
     return 1;
 }
 
+int WiFiClient::connectAsync(IPAddress ip, uint16_t port, std::function<void(bool connected)> cb)
+{
+    if (!_newContext())
+        return 0;
+
+    int res = _client->connectAsync(ip, port, std::move(cb));
+    if (res == 0) {
+        _client->unref();
+        _client = nullptr;
+        return 0;
+    }
+
+    setSync(defaultSync);
+    setNoDelay(defaultNoDelay);
+
+    return 1;
+}
+
+bool WiFiClient::connecting()
+{
+    return _client && _client->state() == SYN_SENT;
+}
+
 void WiFiClient::setNoDelay(bool nodelay) {
     if (!_client)
         return;
@@ -182,6 +218,97 @@ bool WiFiClient::getNoDelay() const {
     return _client->getNoDelay();
 }
 
+void WiFiClient::cork()
+{
+    if (!_client)
+        return;
+    _client->cork();
+}
+
+void WiFiClient::uncork()
+{
+    if (!_client)
+        return;
+    _client->uncork();
+}
+
+void WiFiClient::setAutoCork(size_t bytes, uint16_t ms)
+{
+    if (!_client)
+        return;
+    _client->setAutoCork(bytes, ms);
+}
+
+void WiFiClient::setRxWindow(size_t bytes)
+{
+    if (!_client)
+        return;
+    _client->setRxWindow(bytes);
+}
+
+size_t WiFiClient::getRxWindow() const
+{
+    if (!_client)
+        return 0;
+    return _client->getRxWindow();
+}
+
+void WiFiClient::setTxBuffer(size_t bytes)
+{
+    if (!_client)
+        return;
+    _client->setTxBuffer(bytes);
+}
+
+size_t WiFiClient::getTxBuffer() const
+{
+    if (!_client)
+        return 0;
+    return _client->getTxBuffer();
+}
+
+void WiFiClient::onData(std::function<void()> cb)
+{
+    if (!_client)
+        return;
+    _client->onData(std::move(cb));
+}
+
+void WiFiClient::onWritable(std::function<void()> cb)
+{
+    if (!_client)
+        return;
+    _client->onWritable(std::move(cb));
+}
+
+void WiFiClient::onDisconnect(std::function<void()> cb)
+{
+    if (!_client)
+        return;
+    _client->onClosed(std::move(cb));
+}
+
+void WiFiClient::setRxBufferLimit(size_t bytes, uint16_t pbufs)
+{
+    if (!_client)
+        return;
+    _client->setRxBufferLimit(bytes, pbufs);
+}
+
+size_t WiFiClient::getRxBuffered() const
+{
+    if (!_client)
+        return 0;
+    return _client->getRxBuffered();
+}
+
+uint16_t WiFiClient::getRxPbufs() const
+{
+    if (!_client)
+        return 0;
+    return _client->getRxPbufs();
+}
+
 void WiFiClient::setSync(bool sync)
 {
     if (!_client)
@@ -216,6 +343,16 @@ size_t WiFiClient::write(const uint8_t *buf, size_t size)
     return _client->write((const char*)buf, size);
 }
 
+size_t WiFiClient::writev(const Segment* segments, size_t count)
+{
+    if (!_client || !count)
+    {
+        return 0;
+    }
+    _client->setTimeout(_timeout);
+    return _client->writev(segments, count);
+}
+
 size_t WiFiClient::write(Stream& stream)
 {
     // (this method is deprecated)
@@ -439,3 +576,13 @@ void WiFiClient::peekConsume (size_t consume)
     if (_client)
         _client->peekConsume(consume);
 }
+
+size_t WiFiClient::peekSegments (Segment* segments, size_t maxSegments)
+{
+    return _client? _client->peekSegments(segments, maxSegments): 0;
+}
+
+size_t WiFiClient::peekSegmentsCount ()
+{
+    return _client? _client->peekSegmentsCount(): 0;
+}
@@ -22,6 +22,7 @@
 #ifndef wificlient_h
 #define wificlient_h
 #include <memory>
+#include <functional>
 #include "Arduino.h"
 #include "Print.h"
 #include "Client.h"
@@ -56,11 +57,35 @@ public:
   virtual int connect(IPAddress ip, uint16_t port) override;
   virtual int connect(const char *host, uint16_t port) override;
   virtual int connect(const String& host, uint16_t port);
+
+  // start a plain TCP connection and return at once, 0 when it could not be
+  // started. connecting() is true until the connection is up (connected())
+  // or failed; cb, when set, is called from loop() with the outcome.
+  // The connection gives up after the setTimeout() delay.
+  int connectAsync(IPAddress ip, uint16_t port, std::function<void(bool connected)> cb = nullptr);
+  bool connecting();
+  // Callbacks called from loop() instead of polling available(): data
+  // received, room freed in the send buffer, and connection ended (by the
+  // peer, an error or stop()).  The callbacks are released after the
+  // disconnect one, they may capture a copy of this WiFiClient.
+  void onData(std::function<void()> cb);
+  void onWritable(std::function<void()> cb);
+  void onDisconnect(std::function<void()> cb);
   virtual size_t write(uint8_t) override;
   virtual size_t write(const uint8_t *buf, size_t size) override;
   virtual size_t write_P(PGM_P buf, size_t size);
   size_t write(Stream& stream) [[ deprecated("use stream.sendHow(client...)") ]];
 
+  struct Segment
+  {
+    const char* data;
+    size_t len;
+  };
+
+  // scatter-gather write (writev)
+  // all segments are queued before being sent in as few packets as possible
+  virtual size_t writev(const Segment* segments, size_t count);
+
   virtual int available() override;
   virtual int read() override;
   virtual int read(uint8_t* buf, size_t size) override;
@@ -110,12 +135,46 @@ public:
   bool getNoDelay() const;
   void setNoDelay(bool nodelay);
 
+  // cork() holds small writes back in lwIP's send buffer, to be sent as
+  // full segments by uncork() (or when the buffer is full), for example
+  // around a series of print() calls.  setAutoCork(bytes, ms) does that
+  // for every write: data goes out once `bytes` are waiting or `ms` after
+  // the first write, ms=0 meaning at the next loop().  bytes=0 turns it
+  // off.  While corked, writes are copied even when Sync is true.
+  void cork();
+  void uncork();
+  void setAutoCork(size_t bytes, uint16_t ms = 0);
+
+  // Per-connection budgets below lwIP's TCP_WND and TCP_SND_BUF (0: the
+  // lwIP variant's values), e.g. so that a bulk download leaves memory to
+  // a control connection.  The receive window shrinks as data is read,
+  // the one announced when the connection opened is not taken back.
+  void setRxWindow(size_t bytes);
+  size_t getRxWindow() const;
+  void setTxBuffer(size_t bytes);
+  size_t getTxBuffer() const;
+
+  // Bounded receive for slow readers: while `bytes` or more are received
+  // and not read, reading does not reopen the TCP window, and beyond
+  // `pbufs` network buffers new data is left to lwIP, which offers it again
+  // every 250ms (0: no limit).  getRxBuffered() and getRxPbufs() tell how
+  // much memory this connection holds.
+  void setRxBufferLimit(size_t bytes, uint16_t pbufs = 0);
+  size_t getRxBuffered() const;
+  uint16_t getRxPbufs() const;
+
   // default Sync=false
   // When sync is true, all writes are automatically flushed.
   // This is slower but also does not allocate
   // temporary memory for sending data
   static void setDefaultSync (bool sync);
   static bool getDefaultSync ();
+
+  // Written data is normally copied by lwIP into heap buffers until it is
+  // acknowledged.  Called early in setup(), this sets aside `bytes` for it
+  // instead, used by connections opened afterwards.  Long transfers then
+  // no longer fragment the heap.
+  static bool setTxPool (size_t bytes);
   bool getSync() const;
   void setSync(bool sync);
 
@@ -129,9 +188,20 @@ public:
   // semantic forbids any kind of read() before calling peekConsume()
   virtual const char* peekBuffer () override;
 
-  // consume bytes after use (see peekBuffer)
+  // consume bytes after use (see peekBuffer, peekSegments)
   virtual void peekConsume (size_t consume) override;
 
+  // zero-copy receive API:
+  // describe received data as a list of contiguous segments (one per
+  // received pbuf) which can be parsed in place, without any copy.
+  // Segments are released in order with peekConsume(), one by one or
+  // several at once.  Any read() invalidates all segments.
+  // fill up to maxSegments segments, return the number of filled segments
+  virtual size_t peekSegments (Segment* segments, size_t maxSegments);
+
+  // return the number of segments currently available
+  virtual size_t peekSegmentsCount ();
+
   virtual bool outputCanTimeout () override { return connected(); }
   virtual bool inputCanTimeout () override { return connected(); }
 
@@ -143,6 +213,9 @@ protected:
   int8_t _connected(void* tpcb, int8_t err);
   void _err(int8_t err);
 
+  // drop the current connection and prepare a new one
+  bool _newContext();
+
   ClientContext* _client;
   static uint16_t _localPort;
 };
@@ -48,6 +48,7 @@ extern "C" {
 #include <mmu_iram.h>
 #include <umm_malloc/umm_malloc.h>
 #include <umm_malloc/umm_heap_select.h>
+#include <core_esp8266_governor.h>
 
 #if !CORE_MOCK
 
@@ -71,6 +72,12 @@ extern "C" {
 
 namespace BearSSL {
 
+// TLS record buffers, served by the Heap routed to UMM_HEAP_CLASS_IOBUF
+// (the IRAM Heap when there is one) with DRAM as fallback
+static std::shared_ptr<unsigned char> _alloc_iobuf(size_t size) {
+  return std::shared_ptr<unsigned char>((unsigned char *)umm_class_malloc(UMM_HEAP_CLASS_IOBUF, size), free);
+}
+
 void WiFiClientSecureCtx::_clear() {
   // TLS handshake may take more than the 5 second default timeout
   _timeout = 15000;
@@ -86,7 +93,12 @@ void WiFiClientSecureCtx::_clear() {
   _now = 0; // You can override or ensure time() is correct w/configTime
   _ta = nullptr;
   setBufferSizes(16384, 512); // Minimum safe
+  _mfln_ip = IPAddress();
+  _mfln_port = 0;
+  _mfln_ok = false;
   _handshake_done = false;
+  _async_state = ConnectState::idle;
+  _async_start = 0;
   _recvapp_buf = nullptr;
   _recvapp_len = 0;
   _oom_err = false;
@@ -179,6 +191,35 @@ void WiFiClientSecureCtx::setClientECCert(const X509List *chain,
 }
 
 void WiFiClientSecureCtx::setBufferSizes(int recv, int xmit) {
+  _auto_in_size = 0;
+  _setBufferSizes(recv, xmit);
+}
+
+bool WiFiClientSecureCtx::setBufferSizesAuto(int recv, int xmit) {
+  if (recv != 512 && recv != 1024 && recv != 2048 && recv != 4096) {
+    return false; // Not an MFLN size
+  }
+  _auto_in_size = recv;
+  _auto_out_size = xmit;
+  _mfln_port = 0; // Probe again
+  return true;
+}
+
+// Called before connecting when setBufferSizesAuto() is on
+void WiFiClientSecureCtx::_autoBufferSizes(IPAddress ip, uint16_t port) {
+  if (!_auto_in_size) {
+    return;
+  }
+  if (_mfln_port != port || _mfln_ip != ip) {
+    _mfln_ok = WiFiClientSecure::probeMaxFragmentLength(ip, port, _auto_in_size);
+    _mfln_ip = ip;
+    _mfln_port = port;
+    DEBUG_BSSL("_autoBufferSizes: MFLN %d %s\n", _auto_in_size, _mfln_ok ? "supported" : "not supported");
+  }
+  _setBufferSizes(_mfln_ok ? _auto_in_size : 16384, _auto_out_size);
+}
+
+void WiFiClientSecureCtx::_setBufferSizes(int recv, int xmit) {
   // Following constants taken from bearssl/src/ssl/ssl_engine.c (not exported unfortunately)
   const int MAX_OUT_OVERHEAD = 85;
   const int MAX_IN_OVERHEAD = 325;
@@ -203,6 +244,7 @@ bool WiFiClientSecureCtx::stop(unsigned int maxWaitMs) {
     }
   }
   _freeSSL();
+  _async_state = ConnectState::idle;
   return ret;
 }
 
@@ -212,6 +254,7 @@ bool WiFiClientSecureCtx::flush(unsigned int maxWaitMs) {
 }
 
 int WiFiClientSecureCtx::connect(IPAddress ip, uint16_t port) {
+  _autoBufferSizes(ip, port);
   if (!WiFiClient::connect(ip, port)) {
     return 0;
   }
@@ -224,6 +267,7 @@ int WiFiClientSecureCtx::connect(const char* name, uint16_t port) {
     DEBUG_BSSL("connect: Name lookup failure\n");
     return 0;
   }
+  _autoBufferSizes(remote_addr, port);
   if (!WiFiClient::connect(remote_addr, port)) {
     DEBUG_BSSL("connect: Unable to connect TCP socket\n");
     return 0;
@@ -235,6 +279,46 @@ int WiFiClientSecureCtx::connect(const String& host, uint16_t port) {
   return connect(host.c_str(), port);
 }
 
+int WiFiClientSecureCtx::connectAsync(IPAddress ip, uint16_t port, const char* hostName) {
+  _freeSSL();
+  _autoBufferSizes(ip, port);
+  _async_host = hostName ? hostName : "";
+  _async_start = millis();
+  if (!WiFiClient::connectAsync(ip, port)) {
+    DEBUG_BSSL("connectAsync: Unable to connect TCP socket\n");
+    _async_state = ConnectState::failed;
+    return 0;
+  }
+  _async_state = ConnectState::tcp;
+  return 1;
+}
+
+WiFiClientSecureCtx::ConnectState WiFiClientSecureCtx::connectStep() {
+  if (_async_state == ConnectState::tcp) {
+    if (WiFiClient::connecting()) {
+      return _async_state;
+    }
+    if (!_clientConnected() || !_setupSSL(_async_host.length() ? _async_host.c_str() : nullptr)) {
+      _async_state = ConnectState::failed;
+      return _async_state;
+    }
+    _async_state = ConnectState::handshake;
+  }
+  if (_async_state == ConnectState::handshake) {
+    // Not blocking: the engine only processes what was received so far
+    if ((_run_until(BR_SSL_SENDAPP, false) == 0) && (br_ssl_engine_current_state(_eng) & BR_SSL_SENDAPP)) {
+      _handshake_done = true;
+      _handshakeEnd(true);
+      _async_state = ConnectState::connected;
+    } else if (!_clientConnected() || (br_ssl_engine_current_state(_eng) == BR_SSL_CLOSED) ||
+               ((millis() - _async_start) > _timeout)) {
+      _handshakeEnd(false);
+      _async_state = ConnectState::failed;
+    }
+  }
+  return _async_state;
+}
+
 void WiFiClientSecureCtx::_freeSSL() {
   // These are smart pointers and will free if refcnt==0
   _sc = nullptr;
@@ -333,6 +417,57 @@ size_t WiFiClientSecureCtx::write_P(PGM_P buf, size_t size) {
   return _write((const uint8_t *)buf, size, true);
 }
 
+// gather all segments into as few TLS records as possible
+size_t WiFiClientSecureCtx::writev(const Segment* segments, size_t count) {
+  size_t sent_bytes = 0;
+
+  if (!connected() || !count || !_handshake_done) {
+    return 0;
+  }
+
+  size_t index = 0;
+  size_t offset = 0;
+  while (index < count) {
+    // Ensure we yield if we need multiple fragments to avoid WDT
+    if (sent_bytes) {
+      optimistic_yield(1000);
+    }
+
+    // Get BearSSL to a state where we can send
+    if (_run_until(BR_SSL_SENDAPP) < 0) {
+      break;
+    }
+
+    if (!(br_ssl_engine_current_state(_eng) & BR_SSL_SENDAPP)) {
+      break;
+    }
+
+    size_t sendapp_len;
+    unsigned char *sendapp_buf = br_ssl_engine_sendapp_buf(_eng, &sendapp_len);
+    size_t filled = 0;
+    while (index < count && filled < sendapp_len) {
+      size_t to_copy = std::min(segments[index].len - offset, sendapp_len - filled);
+      memcpy(sendapp_buf + filled, segments[index].data + offset, to_copy);
+      filled += to_copy;
+      offset += to_copy;
+      if (offset == segments[index].len) {
+        index++;
+        offset = 0;
+      }
+    }
+    // a full sendapp buffer is turned into a record by BearSSL
+    br_ssl_engine_sendapp_ack(_eng, filled);
+    sent_bytes += filled;
+  }
+
+  if (sent_bytes) {
+    br_ssl_engine_flush(_eng, 0);
+    flush();
+  }
+
+  return sent_bytes;
+}
+
 size_t WiFiClientSecureCtx::write(Stream& stream) {
   if (!connected() || !_handshake_done) {
     DEBUG_BSSL("write: Connect/handshake not completed yet\n");
@@ -346,28 +481,27 @@ int WiFiClientSecureCtx::read(uint8_t *buf, size_t size) {
     return -1;
   }
 
-  int avail = available();
-  bool conn = connected();
-  if (!avail && conn) {
-    return 0;  // We're still connected, but nothing to read
-  }
-  if (!avail && !conn) {
-    DEBUG_BSSL("read: Not connected, none left available\n");
-    return -1;
-  }
-
-  if (avail) {
-    // Take data from the recvapp buffer
-    int to_copy = _recvapp_len < size ? _recvapp_len : size;
-    memcpy(buf, _recvapp_buf, to_copy);
+  // Plaintext is decrypted in place in BearSSL's record buffer, copy it
+  // straight to the caller, from as many records as were already received
+  size_t done = 0;
+  while (done < size) {
+    size_t avail = available();
+    if (!avail) {
+      break;
+    }
+    size_t to_copy = std::min(avail, size - done);
+    memcpy(buf + done, _recvapp_buf, to_copy);
     br_ssl_engine_recvapp_ack(_eng, to_copy);
     _recvapp_buf = nullptr;
     _recvapp_len = 0;
-    return to_copy;
+    done += to_copy;
+  }
+  if (done) {
+    return done;
   }
 
-  if (!conn) {
-    DEBUG_BSSL("read: Not connected\n");
+  if (!connected()) {
+    DEBUG_BSSL("read: Not connected, none left available\n");
     return -1;
   }
   return 0; // If we're connected, no error but no read.
@@ -389,6 +523,18 @@ void WiFiClientSecureCtx::peekConsume (size_t consume)
     _recvapp_len = 0;
 }
 
+size_t WiFiClientSecureCtx::peekSegments (Segment* segments, size_t maxSegments)
+{
+    if (!maxSegments)
+        return 0;
+    size_t len = peekAvailable();
+    if (!len)
+        return 0;
+    segments[0].data = peekBuffer();
+    segments[0].len = len;
+    return 1;
+}
+
 int WiFiClientSecureCtx::read() {
   uint8_t c;
   if (1 == read(&c, 1)) {
@@ -579,6 +725,7 @@ int WiFiClientSecureCtx::_run_until(unsigned target, bool blocking) {
 }
 
 bool WiFiClientSecureCtx::_wait_for_handshake() {
+  CpuBoost boost;
   _handshake_done = false;
   while (!_handshake_done && _clientConnected()) {
     int ret = _run_until(BR_SSL_SENDAPP);
@@ -942,6 +1089,25 @@ extern "C" {
     br_x509_minimal_set_hash(x509, br_sha512_ID, &br_sha512_vtable);
   }
 
+  // Build time choice of the symmetric kernels, see BearSSL_Benchmark.
+  // BEARSSL_CTMUL32: GHASH (GCM) and Poly1305 with 32x32->32 multiplies
+  // only, the LX106 has no instruction for the high half of a product.
+  // BEARSSL_AES_SMALL: table based AES, faster but not constant-time.
+  static void br_ssl_engine_set_kernels(br_ssl_engine_context *eng) {
+    (void) eng;
+#ifdef BEARSSL_AES_SMALL
+    br_ssl_engine_set_aes_cbc(eng, &br_aes_small_cbcenc_vtable, &br_aes_small_cbcdec_vtable);
+#ifndef BEARSSL_SSL_BASIC
+    br_ssl_engine_set_aes_ctr(eng, &br_aes_small_ctr_vtable);
+    br_ssl_engine_set_aes_ctrcbc(eng, &br_aes_small_ctrcbc_vtable);
+#endif
+#endif
+#if defined(BEARSSL_CTMUL32) && !defined(BEARSSL_SSL_BASIC)
+    br_ssl_engine_set_ghash(eng, &br_ghash_ctmul32);
+    br_ssl_engine_set_poly1305(eng, &br_poly1305_ctmul32_run);
+#endif
+  }
+
   // Default initializion for our SSL clients
   static void br_ssl_client_base_init(br_ssl_client_context *cc, const uint16_t *cipher_list, int cipher_cnt) {
     uint16_t suites[cipher_cnt];
@@ -966,6 +1132,7 @@ extern "C" {
     br_ssl_engine_set_default_des_cbc(&cc->eng);
     br_ssl_engine_set_default_chapol(&cc->eng);
 #endif
+    br_ssl_engine_set_kernels(&cc->eng);
   }
 
   // Default initializion for our SSL clients
@@ -991,6 +1158,7 @@ extern "C" {
     br_ssl_engine_set_default_des_cbc(&cc->eng);
     br_ssl_engine_set_default_chapol(&cc->eng);
 #endif
+    br_ssl_engine_set_kernels(&cc->eng);
   }
 
 }
@@ -1086,6 +1254,16 @@ bool WiFiClientSecureCtx::_installClientX509Validator() {
 // Called by connect() to do the actual SSL setup and handshake.
 // Returns if the SSL handshake succeeded.
 bool WiFiClientSecureCtx::_connectSSL(const char* hostName) {
+  if (!_setupSSL(hostName)) {
+    return false;
+  }
+  auto ret = _wait_for_handshake();
+  _handshakeEnd(ret);
+  return ret;
+}
+
+// Everything _connectSSL() does before the handshake, also for connectStep()
+bool WiFiClientSecureCtx::_setupSSL(const char* hostName) {
   DEBUG_BSSL("_connectSSL: start connection\n");
   _freeSSL();
   _oom_err = false;
@@ -1099,17 +1277,12 @@ bool WiFiClientSecureCtx::_connectSSL(const char* hostName) {
 
   _sc = std::make_shared<br_ssl_client_context>();
   _eng = &_sc->eng; // Allocation/deallocation taken care of by the _sc shared_ptr
-  //C This was borrowed from @earlephilhower PoC, to exemplify the use of IRAM.
-  //C Is this something we want to keep in the final release?
-  { // ESP.setIramHeap(); would be an alternative to using a class to set a scope for IRAM usage.
-    HeapSelectIram ephemeral;
-    _iobuf_in = std::shared_ptr<unsigned char>(new (std::nothrow) unsigned char[_iobuf_in_size], std::default_delete<unsigned char[]>());
-    _iobuf_out = std::shared_ptr<unsigned char>(new (std::nothrow) unsigned char[_iobuf_out_size], std::default_delete<unsigned char[]>());
-    DBG_MMU_PRINTF("\n_iobuf_in:       %p\n", _iobuf_in.get());
-    DBG_MMU_PRINTF(  "_iobuf_out:      %p\n", _iobuf_out.get());
-    DBG_MMU_PRINTF(  "_iobuf_in_size:  %u\n", _iobuf_in_size);
-    DBG_MMU_PRINTF(  "_iobuf_out_size: %u\n", _iobuf_out_size);
-  } // ESP.resetHeap();
+  _iobuf_in = _alloc_iobuf(_iobuf_in_size);
+  _iobuf_out = _alloc_iobuf(_iobuf_out_size);
+  DBG_MMU_PRINTF("\n_iobuf_in:       %p\n", _iobuf_in.get());
+  DBG_MMU_PRINTF(  "_iobuf_out:      %p\n", _iobuf_out.get());
+  DBG_MMU_PRINTF(  "_iobuf_in_size:  %u\n", _iobuf_in_size);
+  DBG_MMU_PRINTF(  "_iobuf_out_size: %u\n", _iobuf_out_size);
 
   if (!_sc || !_iobuf_in || !_iobuf_out) {
     _freeSSL(); // Frees _sc, _iobuf*
@@ -1160,8 +1333,10 @@ bool WiFiClientSecureCtx::_connectSSL(const char* hostName) {
     DEBUG_BSSL("_connectSSL: Can't reset client\n");
     return false;
   }
+  return true;
+}
 
-  auto ret = _wait_for_handshake();
+void WiFiClientSecureCtx::_handshakeEnd(bool ret) {
 #ifdef DEBUG_ESP_SSL
   if (!ret) {
     char err[256];
@@ -1179,8 +1354,6 @@ bool WiFiClientSecureCtx::_connectSSL(const char* hostName) {
 
   // reduce timeout after successful handshake to fail fast if server stop accepting our data for whathever reason
   if (ret) _timeout = 5000;
-
-  return ret;
 }
 
 // Slightly different X509 setup for servers who want to validate client
@@ -1225,15 +1398,12 @@ bool WiFiClientSecureCtx::_connectSSLServerRSA(const X509List *chain,
   _oom_err = false;
   _sc_svr = std::make_shared<br_ssl_server_context>();
   _eng = &_sc_svr->eng; // Allocation/deallocation taken care of by the _sc shared_ptr
-  { // ESP.setIramHeap();
-    HeapSelectIram ephemeral;
-    _iobuf_in = std::shared_ptr<unsigned char>(new (std::nothrow) unsigned char[_iobuf_in_size], std::default_delete<unsigned char[]>());
-    _iobuf_out = std::shared_ptr<unsigned char>(new (std::nothrow) unsigned char[_iobuf_out_size], std::default_delete<unsigned char[]>());
-    DBG_MMU_PRINTF("\n_iobuf_in:       %p\n", _iobuf_in.get());
-    DBG_MMU_PRINTF(  "_iobuf_out:      %p\n", _iobuf_out.get());
-    DBG_MMU_PRINTF(  "_iobuf_in_size:  %u\n", _iobuf_in_size);
-    DBG_MMU_PRINTF(  "_iobuf_out_size: %u\n", _iobuf_out_size);
-  }	// ESP.resetHeap();
+  _iobuf_in = _alloc_iobuf(_iobuf_in_size);
+  _iobuf_out = _alloc_iobuf(_iobuf_out_size);
+  DBG_MMU_PRINTF("\n_iobuf_in:       %p\n", _iobuf_in.get());
+  DBG_MMU_PRINTF(  "_iobuf_out:      %p\n", _iobuf_out.get());
+  DBG_MMU_PRINTF(  "_iobuf_in_size:  %u\n", _iobuf_in_size);
+  DBG_MMU_PRINTF(  "_iobuf_out_size: %u\n", _iobuf_out_size);
 
   if (!_sc_svr || !_iobuf_in || !_iobuf_out) {
     _freeSSL();
@@ -1272,15 +1442,12 @@ bool WiFiClientSecureCtx::_connectSSLServerEC(const X509List *chain,
   _oom_err = false;
   _sc_svr = std::make_shared<br_ssl_server_context>();
   _eng = &_sc_svr->eng; // Allocation/deallocation taken care of by the _sc shared_ptr
-  { // ESP.setIramHeap();
-    HeapSelectIram ephemeral;
-    _iobuf_in = std::shared_ptr<unsigned char>(new (std::nothrow) unsigned char[_iobuf_in_size], std::default_delete<unsigned char[]>());
-    _iobuf_out = std::shared_ptr<unsigned char>(new (std::nothrow) unsigned char[_iobuf_out_size], std::default_delete<unsigned char[]>());
-    DBG_MMU_PRINTF("\n_iobuf_in:       %p\n", _iobuf_in.get());
-    DBG_MMU_PRINTF(  "_iobuf_out:      %p\n", _iobuf_out.get());
-    DBG_MMU_PRINTF(  "_iobuf_in_size:  %u\n", _iobuf_in_size);
-    DBG_MMU_PRINTF(  "_iobuf_out_size: %u\n", _iobuf_out_size);
-  }	// ESP.resetHeap();
+  _iobuf_in = _alloc_iobuf(_iobuf_in_size);
+  _iobuf_out = _alloc_iobuf(_iobuf_out_size);
+  DBG_MMU_PRINTF("\n_iobuf_in:       %p\n", _iobuf_in.get());
+  DBG_MMU_PRINTF(  "_iobuf_out:      %p\n", _iobuf_out.get());
+  DBG_MMU_PRINTF(  "_iobuf_in_size:  %u\n", _iobuf_in_size);
+  DBG_MMU_PRINTF(  "_iobuf_out_size: %u\n", _iobuf_out_size);
 
   if (!_sc_svr || !_iobuf_in || !_iobuf_out) {
     _freeSSL();
@@ -43,10 +43,20 @@ class WiFiClientSecureCtx : public WiFiClient {
     int connect(const String& host, uint16_t port) override;
     int connect(const char* name, uint16_t port) override;
 
+    // connect() without blocking: connectAsync() starts the TCP connection,
+    // then each connectStep(), from loop(), advances it and the TLS
+    // handshake as far as received data allows.  hostName, when given, is
+    // sent (SNI) and checked against the certificate.
+    enum class ConnectState: uint8_t { idle, tcp, handshake, connected, failed };
+    int connectAsync(IPAddress ip, uint16_t port, const char* hostName = nullptr);
+    ConnectState connectStep();
+    ConnectState connectState() const { return _async_state; }
+
     uint8_t connected() override;
     size_t write(const uint8_t *buf, size_t size) override;
     size_t write_P(PGM_P buf, size_t size) override;
     size_t write(Stream& stream); // Note this is not virtual
+    size_t writev(const Segment* segments, size_t count) override;
     int read(uint8_t *buf, size_t size) override;
     int read(char *buf, size_t size) { return read((uint8_t*)buf, size); }
     int available() override;
@@ -104,6 +114,12 @@ class WiFiClientSecureCtx : public WiFiClient {
     // Sets the requested buffer size for transmit and receive
     void setBufferSizes(int recv, int xmit);
 
+    // Choose buffer sizes on each connect(): recv (512, 1024, 2048 or 4096)
+    // if the server supports MFLN for it, else the 16KB a TLS record may need.
+    // The server is probed once, later connections to it reuse the answer.
+    // setBufferSizes() turns this off again.
+    bool setBufferSizesAuto(int recv = 512, int xmit = 512);
+
     // Returns whether MFLN negotiation for the above buffer sizes succeeded (after connection)
     int getMFLNStatus() {
       return connected() && br_ssl_engine_get_mfln_negotiated(_eng);
@@ -140,8 +156,14 @@ class WiFiClientSecureCtx : public WiFiClient {
     // consume bytes after use (see peekBuffer)
     virtual void peekConsume (size_t consume) override;
 
+    // decrypted data is always contiguous: at most one segment
+    virtual size_t peekSegments (Segment* segments, size_t maxSegments) override;
+    virtual size_t peekSegmentsCount () override { return peekAvailable()? 1: 0; }
+
   protected:
     bool _connectSSL(const char *hostName); // Do initial SSL handshake
+    bool _setupSSL(const char *hostName); // _connectSSL() up to the handshake
+    void _handshakeEnd(bool ok);
 
   private:
     void _clear();
@@ -163,9 +185,20 @@ class WiFiClientSecureCtx : public WiFiClient {
     CertStoreBase *_certStore;
     int _iobuf_in_size;
     int _iobuf_out_size;
+    // setBufferSizesAuto() settings, and the last server probed
+    int _auto_in_size;
+    int _auto_out_size;
+    IPAddress _mfln_ip;
+    uint16_t _mfln_port;
+    bool _mfln_ok;
     bool _handshake_done;
     bool _oom_err;
 
+    // connectAsync() progress
+    ConnectState _async_state;
+    String _async_host;
+    uint32_t _async_start;
+
     // Optional storage space pointer for session parameters
     // Will be used on connect and updated on close
     Session *_session;
@@ -193,6 +226,8 @@ class WiFiClientSecureCtx : public WiFiClient {
     int _run_until(unsigned target, bool blocking = true);
     size_t _write(const uint8_t *buf, size_t size, bool pmem);
     bool _wait_for_handshake(); // Sets and return the _handshake_done after connecting
+    void _setBufferSizes(int recv, int xmit);
+    void _autoBufferSizes(IPAddress ip, uint16_t port);
 
     // Optional client certificate
     const X509List *_chain;
@@ -243,12 +278,18 @@ class WiFiClientSecure : public WiFiClient {
     int connect(const String& host, uint16_t port) override { return _ctx->connect(host, port); }
     int connect(const char* name, uint16_t port) override { return _ctx->connect(name, port); }
 
+    using ConnectState = WiFiClientSecureCtx::ConnectState;
+    int connectAsync(IPAddress ip, uint16_t port, const char* hostName = nullptr) { return _ctx->connectAsync(ip, port, hostName); }
+    ConnectState connectStep() { return _ctx->connectStep(); }
+    ConnectState connectState() const { return _ctx->connectState(); }
+
     uint8_t connected() override { return _ctx->connected(); }
     size_t write(const uint8_t *buf, size_t size) override { return _ctx->write(buf, size); }
     size_t write_P(PGM_P buf, size_t size) override { return _ctx->write_P(buf, size); }
     size_t write(const char *buf) { return write((const uint8_t*)buf, strlen(buf)); }
     size_t write_P(const char *buf) { return write_P((PGM_P)buf, strlen_P(buf)); }
     size_t write(Stream& stream) /* Note this is not virtual */ { return _ctx->write(stream); }
+    size_t writev(const Segment* segments, size_t count) override { return _ctx->writev(segments, count); }
     int read(uint8_t *buf, size_t size) override { return _ctx->read(buf, size); }
     int available() override { return _ctx->available(); }
     int availableForWrite() override { return _ctx->availableForWrite(); }
@@ -291,6 +332,7 @@ class WiFiClientSecure : public WiFiClient {
 
     // Sets the requested buffer size for transmit and receive
     void setBufferSizes(int recv, int xmit) { _ctx->setBufferSizes(recv, xmit); }
+    bool setBufferSizesAuto(int recv = 512, int xmit = 512) { return _ctx->setBufferSizesAuto(recv, xmit); }
 
     // Returns whether MFLN negotiation for the above buffer sizes succeeded (after connection)
     int getMFLNStatus() { return _ctx->getMFLNStatus(); }
@@ -329,6 +371,9 @@ class WiFiClientSecure : public WiFiClient {
     // consume bytes after use (see peekBuffer)
     virtual void peekConsume (size_t consume) override { return _ctx->peekConsume(consume); }
 
+    virtual size_t peekSegments (Segment* segments, size_t maxSegments) override { return _ctx->peekSegments(segments, maxSegments); }
+    virtual size_t peekSegmentsCount () override { return _ctx->peekSegmentsCount(); }
+
   private:
     std::shared_ptr<WiFiClientSecureCtx> _ctx;
 
@@ -36,6 +36,7 @@ extern "C" {
 #include "lwip/tcp.h"
 #include "lwip/inet.h"
 #include <include/ClientContext.h>
+#include <Schedule.h>
 
 #ifndef MAX_PENDING_CLIENTS_PER_PORT
 #define MAX_PENDING_CLIENTS_PER_PORT 5
@@ -109,18 +110,29 @@ bool WiFiServer::hasClient() {
     return false;
 }
 
+ClientContext* WiFiServer::_takeUnclaimed() {
+    ClientContext* client = _unclaimed;
+    if (!client)
+        return nullptr;
+
+    // pcb can be null when peer has already closed the connection
+    if (client->getPCB()) {
+        // give permission to lwIP to accept one more peer
+        // (no-op when it was not delayed, see setAcceptBacklog())
+        tcp_backlog_accepted(client->getPCB());
+    }
+
+    _unclaimed = client->next();
+    client->next(nullptr);
+    if (_unclaimedCount)
+        --_unclaimedCount;
+    return client;
+}
+
 WiFiClient WiFiServer::available(byte* status) {
     (void) status;
     if (_unclaimed) {
-        WiFiClient result(_unclaimed);
-
-        // pcb can be null when peer has already closed the connection
-        if (_unclaimed->getPCB()) {
-            // give permission to lwIP to accept one more peer
-            tcp_backlog_accepted(_unclaimed->getPCB());
-        }
-
-        _unclaimed = _unclaimed->next();
+        WiFiClient result(_takeUnclaimed());
         result.setNoDelay(getNoDelay());
         DEBUGV("WS:av status=%d WCav=%d\r\n", result.status(), result.available());
         return result;
@@ -179,6 +191,21 @@ long WiFiServer::_accept(tcp_pcb* apcb, long err) {
     (void) err;
     DEBUGV("WS:ac\r\n");
 
+    if (_acceptFilter && !_acceptFilter(IPAddress(&apcb->remote_ip), apcb->remote_port)) {
+        DEBUGV("WS:filtered\r\n");
+        tcp_abort(apcb);
+        return ERR_ABRT;
+    }
+
+    if (_unclaimedMax && _unclaimedCount >= _unclaimedMax) {
+        // drop the oldest unclaimed client, with what it received
+        ClientContext* oldest = _takeUnclaimed();
+        DEBUGV("WS:drop oldest\r\n");
+        oldest->ref();
+        oldest->abort();
+        oldest->unref();
+    }
+
     // always accept new PCB so incoming data can be stored in our buffers even before
     // user calls ::available()
     ClientContext* client = new ClientContext(apcb, &WiFiServer::_s_discard, this);
@@ -187,14 +214,33 @@ long WiFiServer::_accept(tcp_pcb* apcb, long err) {
     // http://lwip.100.n7.nabble.com/Problem-re-opening-listening-pbc-tt32484.html#a32494
     // https://www.nongnu.org/lwip/2_1_x/group__tcp__raw.html#gaeff14f321d1eecd0431611f382fcd338
 
-    // increase lwIP's backlog
-    tcp_backlog_delayed(apcb);
+    // increase lwIP's backlog, unless the unclaimed list has its own limit
+    if (!_unclaimedMax)
+        tcp_backlog_delayed(apcb);
 
     _unclaimed = slist_append_tail(_unclaimed, client);
+    ++_unclaimedCount;
+
+    if (_acceptHandler)
+        _scheduleAccept();
 
     return ERR_OK;
 }
 
+void WiFiServer::_scheduleAccept() {
+    if (_acceptScheduled)
+        return;
+    std::shared_ptr<WiFiServer*> token = _acceptToken;
+    _acceptScheduled = schedule_function([token]() {
+        WiFiServer* server = *token;
+        if (!server)
+            return;
+        server->_acceptScheduled = false;
+        if (server->_acceptHandler && server->hasClient())
+            server->_acceptHandler();
+    });
+}
+
 void WiFiServer::_discard(ClientContext* client) {
     (void) client;
     // _discarded = slist_append_tail(_discarded, client);
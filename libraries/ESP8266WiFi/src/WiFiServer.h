@@ -28,6 +28,9 @@ extern "C" {
   struct tcp_pcb;
 }
 
+#include <functional>
+#include <memory>
+
 #include "Server.h"
 #include "IPAddress.h"
 
@@ -61,6 +64,22 @@ extern "C" {
 //
 // When user calls WiFiServer::available(), the tcp server stops muting and
 // answers to newcomers (until the "backlog" pending list is full again).
+//
+// setAcceptBacklog(n) changes that policy: accepted clients no longer hold
+// lwIP's backlog, which then only limits the connections still in their
+// handshake (SYN flood).  At most n accepted clients wait for available(),
+// when one more comes in, the oldest waiting one is aborted.  A port
+// scanner opening connections it never uses cannot mute the server, and
+// the pbufs of the clients it leaves behind are released.
+//
+// setAcceptFilter() rejects connections before they are queued, e.g. by
+// remote address.  It runs in lwIP context: it must be short and must not
+// yield or allocate much.
+//
+// onAccept() sets a function called from loop() (via the scheduler) after
+// new clients arrived, several arrivals before it runs make one call.  It
+// would typically call accept() until hasClient() is false, instead of
+// polling available() from loop().
 
 class ClientContext;
 class WiFiClient;
@@ -76,12 +95,36 @@ protected:
   ClientContext* _discarded = nullptr;
   enum { _ndDefault, _ndFalse, _ndTrue } _noDelay = _ndDefault;
 
+public:
+  using AcceptFilter = std::function<bool(const IPAddress& remoteIP, uint16_t remotePort)>;
+  using AcceptHandler = std::function<void(void)>;
+
+protected:
+  uint8_t _unclaimedMax = 0;    // 0: unclaimed clients hold lwIP's backlog
+  uint8_t _unclaimedCount = 0;
+  bool _acceptScheduled = false;
+  AcceptFilter _acceptFilter;
+  AcceptHandler _acceptHandler;
+  // what a scheduled onAccept() call runs on, cleared when this is destroyed
+  std::shared_ptr<WiFiServer*> _acceptToken;
+
 public:
   WiFiServer(const IPAddress& addr, uint16_t port);
   WiFiServer(uint16_t port);
-  virtual ~WiFiServer() {}
+  virtual ~WiFiServer() {
+    if (_acceptToken && *_acceptToken == this)
+      *_acceptToken = nullptr;
+  }
   WiFiClient available(uint8_t* status = NULL);
+  WiFiClient accept() { return available(); }
   bool hasClient();
+  void setAcceptBacklog(uint8_t unclaimed) { _unclaimedMax = unclaimed; }
+  void setAcceptFilter(AcceptFilter filter) { _acceptFilter = std::move(filter); }
+  void onAccept(AcceptHandler handler) {
+    _acceptHandler = std::move(handler);
+    if (!_acceptToken)
+      _acceptToken = std::make_shared<WiFiServer*>(this);
+  }
   void begin();
   void begin(uint16_t port);
   void begin(uint16_t port, uint8_t backlog);
@@ -100,6 +143,8 @@ public:
 protected:
   long _accept(tcp_pcb* newpcb, long err);
   void   _discard(ClientContext* client);
+  ClientContext* _takeUnclaimed();
+  void   _scheduleAccept();
 
   static long _s_accept(void *arg, tcp_pcb* newpcb, long err);
   static void _s_discard(void* server, ClientContext* ctx);
@@ -73,20 +73,33 @@ void WiFiServerSecure::setECCert(const X509List *chain, unsigned cert_issuer_key
   _sk = sk;
 }
 
+bool WiFiServerSecure::setCacheSize(uint32_t sessions, size_t heapId) {
+  _cache = nullptr;
+  _ownCache.reset();
+  if (!sessions)
+    return true;
+  _ownCache = std::make_shared<ServerSessions>(sessions, heapId);
+  if (_ownCache->size() != sessions) {
+    DEBUGV("WS:cache OOM\r\n");
+    _ownCache.reset();
+    return false;
+  }
+  _cache = _ownCache.get();
+  return true;
+}
+
 // Return a client if there's an available connection waiting.  If one is returned,
 // then any validation (i.e. client cert checking) will have succeeded.
 WiFiClientSecure WiFiServerSecure::available(uint8_t* status) {
   (void) status; // Unused
   if (_unclaimed) {
     if (_sk && _sk->isRSA()) {
-      WiFiClientSecure result(_unclaimed, _chain, _sk, _iobuf_in_size, _iobuf_out_size, _cache, _client_CA_ta, _tls_min, _tls_max);
-      _unclaimed = _unclaimed->next();
+      WiFiClientSecure result(_takeUnclaimed(), _chain, _sk, _iobuf_in_size, _iobuf_out_size, _cache, _client_CA_ta, _tls_min, _tls_max);
       result.setNoDelay(_noDelay);
       DEBUGV("WS:av\r\n");
       return result;
     } else if (_sk && _sk->isEC()) {
-      WiFiClientSecure result(_unclaimed, _chain, _cert_issuer_key_type, _sk, _iobuf_in_size, _iobuf_out_size, _cache, _client_CA_ta, _tls_min, _tls_max);
-      _unclaimed = _unclaimed->next();
+      WiFiClientSecure result(_takeUnclaimed(), _chain, _cert_issuer_key_type, _sk, _iobuf_in_size, _iobuf_out_size, _cache, _client_CA_ta, _tls_min, _tls_max);
       result.setNoDelay(_noDelay);
       DEBUGV("WS:av\r\n");
       return result;
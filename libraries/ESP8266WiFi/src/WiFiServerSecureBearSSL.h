@@ -24,6 +24,8 @@
 #include "WiFiClientSecureBearSSL.h"
 #include "BearSSLHelpers.h"
 #include <bearssl/bearssl.h>
+#include <umm_malloc/umm_malloc_cfg.h>
+#include <memory>
 
 namespace BearSSL {
 
@@ -45,8 +47,14 @@ class WiFiServerSecure : public WiFiServer {
     // Sets the server's cache to the given one.
     void setCache(ServerSessions *cache) {
       _cache = cache;
+      _ownCache.reset();
     }
 
+    // Allocates a cache of the given number of sessions (100 bytes each)
+    // owned by the server, from the given heap. 0 disables the cache.
+    // Returns false if the allocation failed.
+    bool setCacheSize(uint32_t sessions, size_t heapId = UMM_HEAP_DRAM);
+
     // Set the server's RSA key and x509 certificate (required, pick one).
     // Caller needs to preserve the chain and key throughout the life of the server.
     void setRSACert(const X509List *chain, const PrivateKey *sk);
@@ -79,6 +87,7 @@ class WiFiServerSecure : public WiFiServer {
     int _iobuf_out_size = 837;
     const X509List *_client_CA_ta = nullptr;
     ServerSessions *_cache = nullptr;
+    std::shared_ptr<ServerSessions> _ownCache; // shared by copies of the server
 
     // TLS ciphers allowed
     uint32_t _tls_min = BR_TLS10;
@@ -22,6 +22,7 @@
 
 #define LWIP_INTERNAL
 #include <functional>
+#include <memory>
 
 extern "C"
 {
@@ -44,7 +45,7 @@ template<>
 WiFiUDP* SList<WiFiUDP>::_s_first = 0;
 
 /* Constructor */
-WiFiUDP::WiFiUDP() : _ctx(0)
+WiFiUDP::WiFiUDP() : _ctx(0), _rxMaxPackets(UdpContext::rxBufMaxDepth)
 {
     WiFiUDP::_add(this);
 }
@@ -52,6 +53,8 @@ WiFiUDP::WiFiUDP() : _ctx(0)
 WiFiUDP::WiFiUDP(const WiFiUDP& other)
 {
     _ctx = other._ctx;
+    _rxMaxPackets = other._rxMaxPackets;
+    _rxMaxBytes = other._rxMaxBytes;
     if (_ctx)
         _ctx->ref();
     WiFiUDP::_add(this);
@@ -60,6 +63,8 @@ WiFiUDP::WiFiUDP(const WiFiUDP& other)
 WiFiUDP& WiFiUDP::operator=(const WiFiUDP& rhs)
 {
     _ctx = rhs._ctx;
+    _rxMaxPackets = rhs._rxMaxPackets;
+    _rxMaxBytes = rhs._rxMaxBytes;
     if (_ctx)
         _ctx->ref();
     return *this;
@@ -82,6 +87,7 @@ uint8_t WiFiUDP::begin(uint16_t port)
 
     _ctx = new UdpContext;
     _ctx->ref();
+    _ctx->setRxQueueLimit(_rxMaxPackets, _rxMaxBytes);
     return (_ctx->listen(IPAddress(), port)) ? 1 : 0;
 }
 
@@ -98,6 +104,7 @@ uint8_t WiFiUDP::beginMulticast(IPAddress interfaceAddr, IPAddress multicast, ui
 
     _ctx = new UdpContext;
     _ctx->ref();
+    _ctx->setRxQueueLimit(_rxMaxPackets, _rxMaxBytes);
     ip_addr_t addr = IPADDR4_INIT(INADDR_ANY);
     if (!_ctx->listen(&addr, port)) {
         return 0;
@@ -124,6 +131,29 @@ int WiFiUDP::available() {
     return result;
 }
 
+void WiFiUDP::setRxQueueLimit(size_t packets, size_t bytes)
+{
+    _rxMaxPackets = packets;
+    _rxMaxBytes = bytes;
+    if (_ctx)
+        _ctx->setRxQueueLimit(packets, bytes);
+}
+
+WiFiUDP::RxQueueStats WiFiUDP::getRxQueueStats() const
+{
+    if (!_ctx)
+        return RxQueueStats { 0, 0, 0, 0, 0 };
+
+    const UdpContext::RxStats& stats = _ctx->getRxStats();
+    return RxQueueStats { stats.dropped, stats.packets, stats.bytes, stats.maxPackets, stats.maxBytes };
+}
+
+void WiFiUDP::resetRxQueueStats()
+{
+    if (_ctx)
+        _ctx->resetRxStats();
+}
+
 /* Release any resources being used by this WiFiUDP instance */
 void WiFiUDP::stop()
 {
@@ -202,6 +232,53 @@ int WiFiUDP::parsePacket()
     return _ctx->getSize();
 }
 
+size_t WiFiUDP::parsePackets(std::function<void(const Datagram&)> cb, size_t max)
+{
+    if (!_ctx || !cb)
+        return 0;
+
+    size_t count = 0;
+    while (count < max && _ctx->next()) {
+        size_t size = _ctx->getSize();
+        const char* data = _ctx->peekBuffer();
+        std::unique_ptr<char[]> copy;
+        if (!data && size) {
+            // datagram in several pbufs
+            copy.reset(new (std::nothrow) char[size]);
+            if (!copy) {
+                _ctx->flush();
+                continue;
+            }
+            size = _ctx->read(copy.get(), size);
+            data = copy.get();
+        }
+        cb(Datagram { reinterpret_cast<const uint8_t*>(data), size, _ctx->getRemoteAddress(), _ctx->getRemotePort() });
+        _ctx->flush();
+        count++;
+    }
+
+    if (!count)
+        optimistic_yield(100);
+
+    return count;
+}
+
+size_t WiFiUDP::sendPackets(const Datagram* datagrams, size_t count, bool noCopy)
+{
+    if (!_ctx) {
+        _ctx = new UdpContext;
+        _ctx->ref();
+    }
+
+    size_t sent = 0;
+    for (; sent < count; sent++) {
+        const Datagram& d = datagrams[sent];
+        if (_ctx->sendNow(reinterpret_cast<const char*>(d.data), d.size, d.ip, d.port, noCopy) != ERR_OK)
+            break;
+    }
+    return sent;
+}
+
 int WiFiUDP::read()
 {
     if (!_ctx)
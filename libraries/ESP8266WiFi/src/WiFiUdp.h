@@ -22,6 +22,7 @@
 #ifndef WIFIUDP_H
 #define WIFIUDP_H
 
+#include <functional>
 #include <Udp.h>
 #include <include/slist.h>
 
@@ -32,6 +33,8 @@ class UdpContext;
 class WiFiUDP : public UDP, public SList<WiFiUDP> {
 private:
   UdpContext* _ctx;
+  size_t _rxMaxPackets;
+  size_t _rxMaxBytes = SIZE_MAX;
 
 public:
   WiFiUDP();  // Constructor
@@ -94,6 +97,39 @@ public:
   int peek() override;
   void flush() override;	// Finish reading the current packet
 
+  // Batched receive and send, without per packet calls and copies.
+  // For parsePackets(), ip:port is the sender and data is valid during the
+  // callback only (destinationIP() is the one of the current packet).
+  // For sendPackets(), ip:port is the destination.
+  struct Datagram
+  {
+    const uint8_t* data;
+    size_t size;
+    IPAddress ip;
+    uint16_t port;
+  };
+  // hand up to max queued packets to cb, returns how many
+  size_t parsePackets(std::function<void(const Datagram&)> cb, size_t max = SIZE_MAX);
+  // returns how many were sent, stops at the first error
+  // noCopy: send straight from the datagrams' data, which must be in RAM
+  // and stay unchanged until sendPackets() returns (it is copied otherwise)
+  size_t sendPackets(const Datagram* datagrams, size_t count, bool noCopy = false);
+
+  // Receive queue bound: packets arriving while `packets` (or `bytes`) are
+  // already waiting, the current one included, are dropped and counted.
+  // Default is 5 packets, without byte limit.
+  void setRxQueueLimit(size_t packets, size_t bytes = SIZE_MAX);
+  struct RxQueueStats
+  {
+    uint32_t dropped;   // since begin() or resetRxQueueStats()
+    size_t packets;     // waiting now
+    size_t bytes;
+    size_t maxPackets;  // high-water marks
+    size_t maxBytes;
+  };
+  RxQueueStats getRxQueueStats() const;
+  void resetRxQueueStats();
+
   // Return the IP address of the host who sent the current incoming packet
   IPAddress remoteIP() override;
   // Return the port of the host who sent the current incoming packet
@@ -30,7 +30,10 @@ extern "C" void esp_yield();
 extern "C" void esp_schedule();
 
 #include <assert.h>
+#include <functional>
 #include <esp_priv.h>
+#include <Schedule.h>
+#include "ClientTxPool.h"
 
 bool getDefaultPrivateGlobalSyncValue ();
 
@@ -39,7 +42,7 @@ class ClientContext
 public:
     ClientContext(tcp_pcb* pcb, discard_cb_t discard_cb, void* discard_cb_arg) :
         _pcb(pcb), _rx_buf(0), _rx_buf_offset(0), _discard_cb(discard_cb), _discard_cb_arg(discard_cb_arg), _refcnt(0), _next(0),
-        _sync(::getDefaultPrivateGlobalSyncValue())
+        _sync(::getDefaultPrivateGlobalSyncValue()), _tx_pooled(ClientTxPool::active())
     {
         tcp_setprio(_pcb, TCP_PRIO_MIN);
         tcp_arg(_pcb, this);
@@ -68,6 +71,8 @@ public:
             tcp_poll(_pcb, NULL, 0);
             tcp_abort(_pcb);
             _pcb = nullptr;
+            ClientTxPool::release(_txq);
+            _post_event(EVENT_CLOSED);
         }
         return ERR_ABRT;
     }
@@ -82,6 +87,19 @@ public:
             tcp_recv(_pcb, NULL);
             tcp_err(_pcb, NULL);
             tcp_poll(_pcb, NULL, 0);
+            if (_rx_withheld) {
+                // tcp_close() resets when the window is not fully open
+                tcp_recved(_pcb, _rx_withheld);
+                _rx_withheld = 0;
+            }
+            if ((_pcb->state == ESTABLISHED || _pcb->state == CLOSE_WAIT) &&
+                !_pcb->refused_data && _pcb->rcv_wnd == TCP_WND_MAX(_pcb)) {
+                // FIN after what is still in flight, from the pool
+                ClientTxPool::orphan(_pcb, _txq);
+            } else {
+                // reset, lwIP frees what is in flight
+                ClientTxPool::release(_txq);
+            }
             err = tcp_close(_pcb);
             if(err != ERR_OK) {
                 DEBUGV(":tc err %d\r\n", (int) err);
@@ -89,6 +107,7 @@ public:
                 err = ERR_ABRT;
             }
             _pcb = nullptr;
+            _post_event(EVENT_CLOSED);
         }
         return err;
     }
@@ -118,6 +137,10 @@ public:
     {
         DEBUGV(":ur %d\r\n", _refcnt);
         if(--_refcnt == 0) {
+            // nobody is left to be told
+            _data_cb = nullptr;
+            _writable_cb = nullptr;
+            _closed_cb = nullptr;
             discard_received();
             close();
             if(_discard_cb) {
@@ -130,17 +153,7 @@ public:
 
     int connect(ip_addr_t* addr, uint16_t port)
     {
-        // note: not using `const ip_addr_t* addr` because
-        // - `ip6_addr_assign_zone()` below modifies `*addr`
-        // - caller's parameter `WiFiClient::connect` is a local copy
-#if LWIP_IPV6
-        // Set zone so that link local addresses use the default interface
-        if (IP_IS_V6(addr) && ip6_addr_lacks_zone(ip_2_ip6(addr), IP6_UNKNOWN)) {
-            ip6_addr_assign_zone(ip_2_ip6(addr), IP6_UNKNOWN, netif_default);
-        }
-#endif
-        err_t err = tcp_connect(_pcb, addr, port, &ClientContext::_s_connected);
-        if (err != ERR_OK) {
+        if (!_tcp_connect(addr, port)) {
             return 0;
         }
         _connect_pending = true;
@@ -163,9 +176,108 @@ public:
         return 1;
     }
 
+    // Start connecting and return at once. state() stays SYN_SENT until
+    // the connection is ESTABLISHED, or CLOSED on error or after the
+    // timeout. cb, when set, is called from loop() with the outcome.
+    int connectAsync(ip_addr_t* addr, uint16_t port, std::function<void(bool)> cb)
+    {
+        if (!_tcp_connect(addr, port)) {
+            return 0;
+        }
+        _connect_async = true;
+        _connect_cb = std::move(cb);
+        _op_start_time = millis();
+        return 1;
+    }
+
+    // Event callbacks, called from loop() instead of polling: data
+    // received, room freed in the send buffer by the peer's acks, and end
+    // of the connection (by the peer, an error, close() or abort()).
+    // Events coming before the callbacks ran are merged into one call.
+    // After the closed callback, all callbacks are released.
+    void onData(std::function<void()> cb)
+    {
+        _data_cb = std::move(cb);
+        if (getSize()) {
+            _post_event(EVENT_DATA);
+        }
+    }
+
+    void onWritable(std::function<void()> cb)
+    {
+        _writable_cb = std::move(cb);
+    }
+
+    void onClosed(std::function<void()> cb)
+    {
+        _closed_cb = std::move(cb);
+        if (!_pcb) {
+            _post_event(EVENT_CLOSED);
+        }
+    }
+
     size_t availableForWrite() const
     {
-        return _pcb? tcp_sndbuf(_pcb): 0;
+        return _pcb? _tx_room(): 0;
+    }
+
+    // per-connection budgets below lwIP's TCP_WND and TCP_SND_BUF, 0: none.
+    // The receive window shrinks as the application consumes data, the
+    // window announced when the connection was opened is not taken back.
+    void setRxWindow(size_t bytes)
+    {
+        _rx_wnd_max = bytes >= TCP_WND? 0: std::max(bytes, (size_t)TCP_MSS);
+        // give back what was withheld if the window was raised
+        _recved(0);
+    }
+
+    // see ClientTxPool, connections opened afterwards use it
+    static bool setTxPool(size_t bytes)
+    {
+        return ClientTxPool::begin(bytes);
+    }
+
+    size_t getRxWindow() const
+    {
+        return _rx_wnd_max? _rx_wnd_max: TCP_WND;
+    }
+
+    void setTxBuffer(size_t bytes)
+    {
+        _tx_buf_max = bytes >= TCP_SND_BUF? 0: std::max(bytes, (size_t)TCP_MSS);
+    }
+
+    size_t getTxBuffer() const
+    {
+        return _tx_buf_max? _tx_buf_max: TCP_SND_BUF;
+    }
+
+    // bounded receive: while `bytes` or more are received and not read, the
+    // window is not reopened by reads.  Beyond `pbufs` network buffers, new
+    // data is refused: lwIP keeps it and offers it again every 250ms.
+    // 0: no limit
+    void setRxBufferLimit(size_t bytes, uint16_t pbufs)
+    {
+        _rx_high = bytes;
+        _rx_pbuf_max = pbufs;
+        _recved(0);
+    }
+
+    // received and not read yet
+    size_t getRxBuffered() const
+    {
+        return _rx_buf? _rx_buf->tot_len - _rx_buf_offset: 0;
+    }
+
+    uint16_t getRxPbufs() const
+    {
+        return _rx_buf? pbuf_clen(_rx_buf): 0;
+    }
+
+    // read but not given back to the receive window yet
+    size_t getRxWithheld() const
+    {
+        return _rx_withheld;
     }
 
     void setNoDelay(bool nodelay)
@@ -188,6 +300,36 @@ public:
         return tcp_nagle_disabled(_pcb);
     }
 
+    // cork: writes are queued in lwIP's send buffer without tcp_output()
+    // until uncork(), or until the send buffer is full
+    void cork()
+    {
+        _corked = true;
+    }
+
+    void uncork()
+    {
+        _corked = false;
+        _cork_output();
+    }
+
+    bool isCorked() const
+    {
+        return _corked;
+    }
+
+    // automatic cork: queued writes are sent once `bytes` are waiting or
+    // `ms` after the first of them, 0 ms meaning at the next loop()
+    // (bytes == 0: off)
+    void setAutoCork(size_t bytes, uint16_t ms)
+    {
+        _cork_bytes = bytes;
+        _cork_ms = ms;
+        if (!bytes) {
+            _cork_output();
+        }
+    }
+
     void setTimeout(int timeout_ms)
     {
         _timeout_ms = timeout_ms;
@@ -310,12 +452,11 @@ public:
         if(!_rx_buf) {
             return;
         }
-        if(_pcb) {
-            tcp_recved(_pcb, (size_t) _rx_buf->tot_len);
-        }
+        size_t size = _rx_buf->tot_len;
         pbuf_free(_rx_buf);
         _rx_buf = 0;
         _rx_buf_offset = 0;
+        _recved(size);
     }
 
     bool wait_until_acked(int max_wait_ms = WIFICLIENT_MAX_FLUSH_WAIT_MS)
@@ -327,6 +468,9 @@ public:
         if (!_pcb)
             return true;
 
+        // tcp_output() below sends what cork held back
+        _cork_queued = 0;
+
         int prevsndbuf = -1;
 
         // wait for peer's acks to flush lwIP's output buffer
@@ -380,7 +524,18 @@ public:
         if (!_pcb) {
             return 0;
         }
-        return _write_from_source(ds, dl);
+        WiFiClient::Segment segment = { ds, dl };
+        return _write_from_source(&segment, 1);
+    }
+
+    // scatter-gather write: all segments are queued with TCP_WRITE_FLAG_MORE
+    // (except the last chunk) and sent with a single tcp_output()
+    size_t writev(const WiFiClient::Segment* segments, size_t count)
+    {
+        if (!_pcb) {
+            return 0;
+        }
+        return _write_from_source(segments, count);
     }
 
     void keepAlive (uint16_t idle_sec = TCP_DEFAULT_KEEPALIVE_IDLE_SEC, uint16_t intv_sec = TCP_DEFAULT_KEEPALIVE_INTERVAL_SEC, uint8_t count = TCP_DEFAULT_KEEPALIVE_COUNT)
@@ -442,14 +597,124 @@ public:
         return _rx_buf->len - _rx_buf_offset;
     }
 
-    // consume bytes after use (see peekBuffer)
+    // consume bytes after use (see peekBuffer, peekSegments)
+    // consumed size may span over several segments
     void peekConsume (size_t consume)
     {
-        _consume(consume);
+        while (consume && _rx_buf) {
+            size_t chunk = std::min(consume, (size_t)(_rx_buf->len - _rx_buf_offset));
+            _consume(chunk);
+            consume -= chunk;
+        }
+    }
+
+    // zero-copy receive: describe the whole received pbuf chain
+    // as a list of (pointer, length) segments, starting at current read position
+    // return number of segments filled (at most maxSegments)
+    // segments remain valid until they are released with peekConsume()
+    size_t peekSegments (WiFiClient::Segment* segments, size_t maxSegments) const
+    {
+        size_t count = 0;
+        size_t offset = _rx_buf_offset;
+        for (const pbuf* p = _rx_buf; p && count < maxSegments; p = p->next) {
+            if (p->len > offset) {
+                segments[count].data = (const char*)p->payload + offset;
+                segments[count].len = p->len - offset;
+                count++;
+            }
+            offset = 0;
+        }
+        return count;
+    }
+
+    // return number of segments in the received pbuf chain
+    size_t peekSegmentsCount () const
+    {
+        size_t count = 0;
+        for (const pbuf* p = _rx_buf; p; p = p->next)
+            count++;
+        return count;
     }
 
 protected:
 
+    bool _tcp_connect(ip_addr_t* addr, uint16_t port)
+    {
+        // note: not using `const ip_addr_t* addr` because
+        // - `ip6_addr_assign_zone()` below modifies `*addr`
+        // - caller's parameter `WiFiClient::connect` is a local copy
+#if LWIP_IPV6
+        // Set zone so that link local addresses use the default interface
+        if (IP_IS_V6(addr) && ip6_addr_lacks_zone(ip_2_ip6(addr), IP6_UNKNOWN)) {
+            ip6_addr_assign_zone(ip_2_ip6(addr), IP6_UNKNOWN, netif_default);
+        }
+#endif
+        return tcp_connect(_pcb, addr, port, &ClientContext::_s_connected) == ERR_OK;
+    }
+
+    // end of a connectAsync(), from lwIP: pass the outcome to loop()
+    void _connect_async_done(bool ok)
+    {
+        DEBUGV(":cad %d\r\n", (int)ok);
+        _connect_async = false;
+        if (!_connect_cb) {
+            return;
+        }
+        // keep this context until the callback has run
+        ref();
+        if (!schedule_function([this, cb = std::move(_connect_cb), ok]() { cb(ok); unref(); })) {
+            --_refcnt;
+        }
+        _connect_cb = nullptr;
+    }
+
+    enum : uint8_t { EVENT_DATA = 1, EVENT_WRITABLE = 2, EVENT_CLOSED = 4 };
+
+    // from lwIP or the sketch: have the event's callback called from loop()
+    void _post_event(uint8_t event)
+    {
+        if (!(event == EVENT_DATA? _data_cb: event == EVENT_WRITABLE? _writable_cb: _closed_cb)) {
+            return;
+        }
+        _events |= event;
+        if (_events_scheduled) {
+            return;
+        }
+        // keep this context until the callbacks have run
+        ref();
+        if (!schedule_function([this]() { _run_events(); })) {
+            --_refcnt;
+            return;
+        }
+        _events_scheduled = true;
+    }
+
+    void _run_events()
+    {
+        uint8_t events = _events;
+        _events = 0;
+        _events_scheduled = false;
+        DEBUGV(":ev %d\r\n", (int)events);
+        if ((events & EVENT_DATA) && _data_cb && getSize()) {
+            _data_cb();
+        }
+        if ((events & EVENT_WRITABLE) && _writable_cb && _pcb) {
+            _writable_cb();
+        }
+        if (events & EVENT_CLOSED) {
+            // what the callbacks captured, maybe the WiFiClient itself, is
+            // released with them
+            auto cb = std::move(_closed_cb);
+            _closed_cb = nullptr;
+            _data_cb = nullptr;
+            _writable_cb = nullptr;
+            if (cb) {
+                cb();
+            }
+        }
+        unref();
+    }
+
     bool _is_timeout()
     {
         return millis() - _op_start_time > _timeout_ms;
@@ -464,12 +729,17 @@ protected:
         }
     }
 
-    size_t _write_from_source(const char* ds, const size_t dl)
+    size_t _write_from_source(const WiFiClient::Segment* segments, size_t count)
     {
         assert(_datasource == nullptr);
         assert(!_send_waiting);
-        _datasource = ds;
-        _datalen = dl;
+        _datasource = segments;
+        _datacount = count;
+        _datalen = 0;
+        for (size_t i = 0; i < count; i++)
+            _datalen += segments[i].len;
+        _dataindex = 0;
+        _dataoffset = 0;
         _written = 0;
         _op_start_time = millis();
         do {
@@ -482,6 +752,7 @@ protected:
                     DEBUGV(":wtmo\r\n");
                 }
                 _datasource = nullptr;
+                _datacount = 0;
                 _datalen = 0;
                 break;
             }
@@ -495,12 +766,51 @@ protected:
             _send_waiting = false;
         } while(true);
 
-        if (_sync)
+        // corked data is copied, there is nothing to wait for
+        if (_sync && !_is_corked())
             wait_until_acked();
 
         return _written;
     }
 
+    bool _is_corked() const
+    {
+        return _corked || _cork_bytes;
+    }
+
+    void _cork_output()
+    {
+        _cork_queued = 0;
+        if (_pcb) {
+            // lwIP's tcp_output doc: "Find out what we can send and send it"
+            // *with respect to Nagle*
+            // more info: https://lists.gnu.org/archive/html/lwip-users/2017-11/msg00134.html
+            tcp_output(_pcb);
+        }
+    }
+
+    // automatic cork: send what is queued after _cork_ms
+    void _cork_arm()
+    {
+        if (_cork_timer) {
+            return;
+        }
+        // keep this context until the timer has run
+        ref();
+        _cork_timer = schedule_recurrent_function_us([this]() {
+            _cork_timer = false;
+            if (_cork_queued && !_corked) {
+                _cork_output();
+            }
+            unref();
+            return false;
+        }, (uint32_t)_cork_ms * 1000);
+        if (!_cork_timer) {
+            --_refcnt;
+            _cork_output();
+        }
+    }
+
     bool _write_some()
     {
         if (!_datasource || !_pcb) {
@@ -514,11 +824,26 @@ protected:
         while (_written < _datalen) {
             if (state() == CLOSED)
                 return false;
+            const WiFiClient::Segment& segment = _datasource[_dataindex];
+            if (_dataoffset == segment.len) {
+                // segment fully queued (or empty), next one
+                _dataindex++;
+                _dataoffset = 0;
+                continue;
+            }
             const auto remaining = _datalen - _written;
-            size_t next_chunk_size = std::min((size_t)tcp_sndbuf(_pcb), remaining);
+            size_t next_chunk_size = std::min(_tx_room(), segment.len - _dataoffset);
             if (!next_chunk_size)
                 break;
-            const char* buf = _datasource + _written;
+            const char* buf = segment.data + _dataoffset;
+            if (_tx_pooled) {
+                // lwIP references the pool until the data is acknowledged
+                uint8_t* pooled = ClientTxPool::reserve(_txq, next_chunk_size);
+                if (!pooled)
+                    break;
+                memcpy_P(pooled, buf, next_chunk_size);
+                buf = (const char*)pooled;
+            }
 
             uint8_t flags = 0;
             if (next_chunk_size < remaining)
@@ -528,7 +853,7 @@ protected:
                 //   #5173: windows needs this flag
                 //   more info: https://lists.gnu.org/archive/html/lwip-users/2009-11/msg00018.html
                 flags |= TCP_WRITE_FLAG_MORE; // do not tcp-PuSH (yet)
-            if (!_sync)
+            if ((!_sync || _is_corked()) && !_tx_pooled)
                 // user data must be copied when data are sent but not yet acknowledged
                 // (with sync, we wait for acknowledgment before returning to user)
                 flags |= TCP_WRITE_FLAG_COPY;
@@ -538,7 +863,11 @@ protected:
             DEBUGV(":wrc %d %d %d\r\n", next_chunk_size, remaining, (int)err);
 
             if (err == ERR_OK) {
+                if (_tx_pooled)
+                    ClientTxPool::commit(_txq, next_chunk_size);
                 _written += next_chunk_size;
+                _dataoffset += next_chunk_size;
+                _cork_queued += next_chunk_size;
                 has_written = true;
             } else {
                 // ERR_MEM(-1) is a valid error meaning
@@ -549,10 +878,13 @@ protected:
 
         if (has_written)
         {
-            // lwIP's tcp_output doc: "Find out what we can send and send it"
-            // *with respect to Nagle*
-            // more info: https://lists.gnu.org/archive/html/lwip-users/2017-11/msg00134.html
-            tcp_output(_pcb);
+            // a full send buffer must go out, its acks make room for the rest
+            if (!_is_corked() || _written < _datalen ||
+                (!_corked && _cork_queued >= _cork_bytes)) {
+                _cork_output();
+            } else if (!_corked) {
+                _cork_arm();
+            }
         }
 
         return has_written;
@@ -569,9 +901,12 @@ protected:
     err_t _acked(tcp_pcb* pcb, uint16_t len)
     {
         (void) pcb;
-        (void) len;
         DEBUGV(":ack %d\r\n", len);
+        ClientTxPool::acked(_txq, len);
         _write_some_from_cb();
+        if (!_datasource) {
+            _post_event(EVENT_WRITABLE);
+        }
         return ERR_OK;
     }
 
@@ -593,8 +928,44 @@ protected:
             pbuf_ref(_rx_buf);
             pbuf_free(head);
         }
-        if(_pcb)
-            tcp_recved(_pcb, size);
+        _recved(size);
+    }
+
+    // Reopens the receive window by what the application consumed, as far
+    // as setRxWindow() allows
+    void _recved(size_t size)
+    {
+        if (!_pcb) {
+            return;
+        }
+        _rx_withheld += size;
+        if (_rx_high && getRxBuffered() >= _rx_high) {
+            // slow reader, let the sender wait
+            return;
+        }
+        size_t give = _rx_withheld;
+        if (_rx_wnd_max) {
+            size_t wnd = _pcb->rcv_wnd;
+            give = wnd >= _rx_wnd_max? 0: std::min(give, _rx_wnd_max - wnd);
+        }
+        if (give) {
+            _rx_withheld -= give;
+            tcp_recved(_pcb, give);
+        }
+    }
+
+    // room in the send buffer, as far as setTxBuffer() allows
+    size_t _tx_room() const
+    {
+        size_t room = tcp_sndbuf(_pcb);
+        if (_tx_buf_max) {
+            size_t used = TCP_SND_BUF - room;
+            room = used >= _tx_buf_max? 0: std::min(room, _tx_buf_max - used);
+        }
+        if (_tx_pooled) {
+            room = std::min(room, ClientTxPool::room(_txq));
+        }
+        return room;
     }
 
     err_t _recv(tcp_pcb* pcb, pbuf* pb, err_t err)
@@ -608,6 +979,7 @@ protected:
             if (_rx_buf && _rx_buf->tot_len)
             {
                 // there is still something to read
+                _post_event(EVENT_CLOSED);
                 return ERR_OK;
             }
             else
@@ -620,6 +992,12 @@ protected:
             }
         }
 
+        if (_rx_pbuf_max && _rx_buf && pbuf_clen(_rx_buf) >= _rx_pbuf_max) {
+            // lwIP keeps it as refused data and tries again later
+            DEBUGV(":rrf %d\r\n", pb->tot_len);
+            return ERR_MEM;
+        }
+
         if(_rx_buf) {
             DEBUGV(":rch %d, %d\r\n", _rx_buf->tot_len, pb->tot_len);
             pbuf_cat(_rx_buf, pb);
@@ -628,6 +1006,7 @@ protected:
             _rx_buf = pb;
             _rx_buf_offset = 0;
         }
+        _post_event(EVENT_DATA);
         return ERR_OK;
     }
 
@@ -640,7 +1019,12 @@ protected:
         tcp_recv(_pcb, NULL);
         tcp_err(_pcb, NULL);
         _pcb = nullptr;
+        ClientTxPool::release(_txq);
         _notify_error();
+        _post_event(EVENT_CLOSED);
+        if (_connect_async) {
+            _connect_async_done(false);
+        }
     }
 
     err_t _connected(struct tcp_pcb *pcb, err_t err)
@@ -652,11 +1036,19 @@ protected:
             _connect_pending = false;
             esp_schedule(); // break delay in connect
         }
+        if (_connect_async) {
+            _connect_async_done(true);
+        }
         return ERR_OK;
     }
 
     err_t _poll(tcp_pcb*)
     {
+        if (_connect_async && _is_timeout()) {
+            DEBUGV(":catmo\r\n");
+            _connect_async_done(false);
+            return abort();
+        }
         _write_some_from_cb();
         return ERR_OK;
     }
@@ -695,18 +1087,44 @@ private:
     discard_cb_t _discard_cb;
     void* _discard_cb_arg;
 
-    const char* _datasource = nullptr;
+    const WiFiClient::Segment* _datasource = nullptr;
+    size_t _datacount = 0;
+    size_t _dataindex = 0;
+    size_t _dataoffset = 0;
     size_t _datalen = 0;
     size_t _written = 0;
     uint32_t _timeout_ms = 5000;
     uint32_t _op_start_time = 0;
     bool _send_waiting = false;
     bool _connect_pending = false;
+    bool _connect_async = false;
+    std::function<void(bool)> _connect_cb;
+
+    std::function<void()> _data_cb;
+    std::function<void()> _writable_cb;
+    std::function<void()> _closed_cb;
+    uint8_t _events = 0;        // posted, not run yet
+    bool _events_scheduled = false;
 
     int8_t _refcnt;
     ClientContext* _next;
 
     bool _sync;
+
+    bool _corked = false;
+    bool _cork_timer = false;
+    uint16_t _cork_ms = 0;
+    size_t _cork_bytes = 0;     // automatic cork threshold, 0: off
+    size_t _cork_queued = 0;    // written to lwIP, not tcp_output()'ed yet
+
+    size_t _rx_wnd_max = 0;     // setRxWindow(), 0: TCP_WND
+    size_t _rx_withheld = 0;    // consumed but not tcp_recved() yet
+    size_t _rx_high = 0;        // setRxBufferLimit(), 0: none
+    uint16_t _rx_pbuf_max = 0;
+    size_t _tx_buf_max = 0;     // setTxBuffer(), 0: TCP_SND_BUF
+
+    bool _tx_pooled;            // written data goes through ClientTxPool
+    ClientTxPool::Queue _txq;
 };
 
 #endif//CLIENTCONTEXT_H
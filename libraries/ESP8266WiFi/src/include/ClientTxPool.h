@@ -0,0 +1,88 @@
+/*
+ ClientTxPool.h - fixed memory for data written to TCP connections
+
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef CLIENTTXPOOL_H
+#define CLIENTTXPOOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <lwip/tcp.h>
+
+// With TCP_WRITE_FLAG_COPY, lwIP copies written data into pbufs taken from
+// the heap, where they sit between the sketch's allocations until the peer
+// acknowledges them.  Once set up, ClientContext copies written data into
+// chunks of this pool instead and gives them to lwIP without copy.  A
+// connection's chunks are given back in order as data is acknowledged, or
+// when lwIP is done with a closed connection.
+class ClientTxPool
+{
+public:
+    static constexpr uint16_t none = 0xffff;
+    static constexpr size_t chunk = TCP_MSS;
+
+    // one connection's chunks, oldest first
+    struct Queue
+    {
+        uint16_t head = none;
+        uint16_t tail = none;
+        uint16_t head_acked = 0;    // acknowledged bytes at the start of head
+        uint16_t tail_used = 0;     // written bytes in tail
+    };
+
+    // once, early: the point is to take this memory before the heap fragments
+    static bool begin(size_t bytes);
+
+    static bool active()
+    {
+        return _mem;
+    }
+
+    static size_t room(const Queue& q)
+    {
+        return (q.tail == none? 0: chunk - q.tail_used) + _free_count * chunk;
+    }
+
+    // contiguous room for at most len bytes, nullptr when the pool is empty
+    static uint8_t* reserve(Queue& q, size_t& len);
+
+    static void commit(Queue& q, size_t len)
+    {
+        q.tail_used += len;
+    }
+
+    static void acked(Queue& q, size_t len);
+    static void release(Queue& q);
+
+    // before tcp_close(): q's chunks stay with the pcb until it is done
+    static void orphan(tcp_pcb* pcb, Queue& q);
+
+protected:
+    static void _put(uint16_t c);
+    static err_t _s_orphan_acked(void* arg, tcp_pcb* pcb, uint16_t len);
+    static void _s_orphan_error(void* arg, err_t err);
+
+    static uint8_t* _mem;
+    static uint16_t* _link;
+    static Queue* _orphans;
+    static uint16_t _count;
+    static uint16_t _free;
+    static uint16_t _free_count;
+};
+
+#endif//CLIENTTXPOOL_H
@@ -31,6 +31,7 @@ void esp_schedule();
 
 #include <AddrList.h>
 #include <PolledTimeout.h>
+#include <mmu_iram.h>
 
 #define PBUF_ALIGNER_ADJUST 4
 #define PBUF_ALIGNER(x) ((void*)((((intptr_t)(x))+3)&~3))
@@ -42,6 +43,16 @@ public:
 
     typedef std::function<void(void)> rxhandler_t;
 
+    // receive queue accounting, max* are high-water marks
+    struct RxStats
+    {
+        uint32_t dropped = 0;
+        size_t packets = 0;
+        size_t bytes = 0;
+        size_t maxPackets = 0;
+        size_t maxBytes = 0;
+    };
+
     UdpContext()
     : _pcb(0)
     , _rx_buf(0)
@@ -176,6 +187,26 @@ public:
 #endif
     }
 
+    // packets arriving while `packets` (or `bytes`) are already queued,
+    // the current one included, are dropped
+    void setRxQueueLimit(size_t packets, size_t bytes)
+    {
+        _rx_max_packets = packets;
+        _rx_max_bytes = bytes;
+    }
+
+    const RxStats& getRxStats() const
+    {
+        return _rx_stats;
+    }
+
+    void resetRxStats()
+    {
+        _rx_stats.dropped = 0;
+        _rx_stats.maxPackets = _rx_stats.packets;
+        _rx_stats.maxBytes = _rx_stats.bytes;
+    }
+
     // warning: handler is called from tcp stack context
     // esp_yield and non-reentrant functions which depend on it will fail
     void onRx(rxhandler_t handler) {
@@ -275,6 +306,10 @@ public:
 
         auto deleteme = _rx_buf;
 
+        // the current packet leaves the queue
+        _rx_stats.packets--;
+        _rx_stats.bytes -= _rx_buf_size;
+
         // forward in the chain until next address-info pbuf or end of chain
         while(_rx_buf && _rx_buf->flags != PBUF_HELPER_FLAG)
             _rx_buf = _rx_buf->next;
@@ -350,6 +385,16 @@ public:
         return pbuf_get_at(_rx_buf, _rx_buf_offset);
     }
 
+    // contiguous view of the rest of the current packet (getSize() bytes),
+    // nullptr when the packet spans several pbufs
+    const char* peekBuffer() const
+    {
+        if (!_rx_buf || _rx_buf->len < _rx_buf_size)
+            return nullptr;
+
+        return reinterpret_cast<const char*>(_rx_buf->payload) + _rx_buf_offset;
+    }
+
     void flush()
     {
         //XXX this does not follow Arduino's flush definition
@@ -417,6 +462,50 @@ public:
         return err == ERR_OK;
     }
 
+    // send one datagram straight from data, without the append() buffer
+    // noCopy: lwIP references data (PBUF_REF) instead of copying it, data
+    // then must stay valid until this returns. Only for DRAM, anything else
+    // (PROGMEM, IRAM) is copied with aligned reads.
+    err_t sendNow(const char* data, size_t size, const ip_addr_t* addr = 0, uint16_t port = 0, bool noCopy = false)
+    {
+        pbuf* pb;
+        if (noCopy && mmu_is_dram(data)) {
+            pb = pbuf_alloc(PBUF_TRANSPORT, size, PBUF_REF);
+            if (pb) {
+                pb->payload = const_cast<char*>(data);
+            }
+        } else {
+            pb = pbuf_alloc(PBUF_TRANSPORT, size, PBUF_RAM);
+            if (pb) {
+                memcpy_P(pb->payload, data, size);
+            }
+        }
+        if (!pb) {
+            DEBUGV("failed pbuf_alloc");
+            return ERR_MEM;
+        }
+
+        ip_addr_t dst;
+        if (addr) {
+            ip_addr_copy(dst, *addr);
+#if LWIP_IPV6
+            if (IP_IS_V6(&dst) && ip6_addr_lacks_zone(ip_2_ip6(&dst), IP6_UNKNOWN)) {
+                ip6_addr_assign_zone(ip_2_ip6(&dst), IP6_UNKNOWN, netif_default);
+            }
+#endif
+        } else {
+            ip_addr_copy(dst, _pcb->remote_ip);
+            port = _pcb->remote_port;
+        }
+
+        err_t err = udp_sendto(_pcb, pb, &dst, port);
+        if (err != ERR_OK) {
+            DEBUGV(":usn rc=%d\r\n", (int) err);
+        }
+        pbuf_free(pb);
+        return err;
+    }
+
 private:
 
     err_t trySend(const ip_addr_t* addr, uint16_t port, bool keepBufferOnError)
@@ -513,19 +602,13 @@ private:
             const ip_addr_t *srcaddr, u16_t srcport)
     {
         (void) upcb;
-        // check receive pbuf chain depth
-        // optimization path: cache the pbuf chain length
+        // bounded receive queue
+        if (_rx_stats.packets >= _rx_max_packets || _rx_stats.bytes + pb->tot_len > _rx_max_bytes)
         {
-            pbuf* p;
-            int count = 0;
-            for (p = _rx_buf; p && ++count < rxBufMaxDepth*2; p = p->next);
-            if (p)
-            {
-                // pbuf chain too deep, dropping
-                pbuf_free(pb);
-                DEBUGV(":udr\r\n");
-                return;
-            }
+            pbuf_free(pb);
+            _rx_stats.dropped++;
+            DEBUGV(":udr\r\n");
+            return;
         }
 
         // chain this helper pbuf first
@@ -550,6 +633,7 @@ private:
             {
                 // memory issue - discard received data
                 pbuf_free(pb);
+                _rx_stats.dropped++;
                 return;
             }
             // construct in place
@@ -576,6 +660,13 @@ private:
             _rx_buf_size = pb->tot_len;
         }
 
+        _rx_stats.packets++;
+        _rx_stats.bytes += pb->tot_len;
+        if (_rx_stats.packets > _rx_stats.maxPackets)
+            _rx_stats.maxPackets = _rx_stats.packets;
+        if (_rx_stats.bytes > _rx_stats.maxBytes)
+            _rx_stats.maxBytes = _rx_stats.bytes;
+
         if (_on_rx) {
             _on_rx();
         }
@@ -615,9 +706,14 @@ private:
     };
     AddrHelper _currentAddr;
 
-    // rx pbuf depth barrier (counter of buffered UDP received packets)
-    // keep it small
-    static constexpr int rxBufMaxDepth = 4;
+    RxStats _rx_stats;
+    size_t _rx_max_packets = rxBufMaxDepth;
+    size_t _rx_max_bytes = SIZE_MAX;
+
+public:
+    // default rx queue depth (counter of buffered UDP received packets,
+    // the current one and 4 more), keep it small
+    static constexpr size_t rxBufMaxDepth = 5;
 };
 
 
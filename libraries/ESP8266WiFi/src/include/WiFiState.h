@@ -20,4 +20,17 @@ struct WiFiState
     } state;
 };
 
+struct WiFiDhcpLease
+{
+    uint32_t crc;
+    struct
+    {
+        ip4_addr_t ip;
+        ip4_addr_t netmask;
+        ip4_addr_t gw;
+        ip4_addr_t server;
+        uint32_t leaseSeconds;
+    } state;
+};
+
 #endif // WIFISTATE_H_
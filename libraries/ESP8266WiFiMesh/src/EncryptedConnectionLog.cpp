@@ -23,10 +23,22 @@
  */
 
 #include "EncryptedConnectionLog.h"
+#include "TypeConversionFunctions.h"
+#include <algorithm>
 
 namespace
 {
   using EspnowProtocolInterpreter::hashKeyLength;
+  namespace TypeCast = MeshTypeConversionFunctions;
+
+  // Stale entries are normally removed once their deadline passes. Frequent duration updates could still fill the heap before that, so it is compacted beyond this size.
+  constexpr uint32_t expiryHeapCompactionLimit = 4 * EspnowProtocolInterpreter::maxEncryptedConnections;
+
+  // Entry a expires later than entry b. Using this as heap comparator puts the earliest deadline at the front. Handles millis() rollover.
+  bool expiresLater(const EncryptedConnectionLog::ExpiryEntry &a, const EncryptedConnectionLog::ExpiryEntry &b)
+  {
+    return (int32_t)(a.deadlineMs - b.deadlineMs) > 0;
+  }
 }
 
 EncryptedConnectionLog::EncryptedConnectionLog(const uint8_t peerStaMac[6], const uint8_t peerApMac[6], const uint64_t peerSessionKey, const uint64_t ownSessionKey, const uint8_t hashKey[hashKeyLength]) 
@@ -35,9 +47,12 @@ EncryptedConnectionLog::EncryptedConnectionLog(const uint8_t peerStaMac[6], cons
 
 EncryptedConnectionLog::EncryptedConnectionLog(const uint8_t peerStaMac[6], const uint8_t peerApMac[6], const uint64_t peerSessionKey, const uint64_t ownSessionKey, const uint32_t duration, const uint8_t hashKey[hashKeyLength]) 
   : EncryptedConnectionData(peerStaMac, peerApMac, peerSessionKey, ownSessionKey, duration, hashKey)
-{ }
+{
+  addExpiryEntry(duration); // The base class constructor calls the base class setRemainingDuration, which does not know about the expiry heap.
+}
 
-std::unique_ptr<ExpiringTimeTracker> EncryptedConnectionLog::_soonestExpiringConnectionTracker = nullptr;
+std::vector<EncryptedConnectionLog::ExpiryEntry> EncryptedConnectionLog::_expiryHeap = {};
+uint32_t EncryptedConnectionLog::_lastExpiryID = 0;
 
 bool EncryptedConnectionLog::_newRemovalsScheduled = false;
 
@@ -47,7 +62,7 @@ void EncryptedConnectionLog::setRemainingDuration(const uint32_t remainingDurati
   
   setScheduledForRemoval(false);
 
-  updateSoonestExpiringConnectionTracker(remainingDuration);
+  addExpiryEntry(remainingDuration);
 }
 
 void EncryptedConnectionLog::removeDuration()
@@ -76,20 +91,51 @@ bool EncryptedConnectionLog::removalScheduled() const { return _scheduledForRemo
 void EncryptedConnectionLog::setNewRemovalsScheduled(const bool newRemovalsScheduled) { _newRemovalsScheduled = newRemovalsScheduled; }
 bool EncryptedConnectionLog::newRemovalsScheduled( ) { return _newRemovalsScheduled; }
 
-const ExpiringTimeTracker *EncryptedConnectionLog::getSoonestExpiringConnectionTracker()
+void EncryptedConnectionLog::addExpiryEntry(const uint32_t remainingDuration)
 {
-  return _soonestExpiringConnectionTracker.get();
+  uint8_t encryptedPeerMac[6] {0};
+  _expiryID = ++_lastExpiryID;
+  pushExpiryEntry(ExpiryEntry{(uint32_t)(millis() + remainingDuration), _expiryID, TypeCast::macToUint64(getEncryptedPeerMac(encryptedPeerMac))});
 }
 
-void EncryptedConnectionLog::updateSoonestExpiringConnectionTracker(const uint32_t remainingDuration)
+bool EncryptedConnectionLog::isCurrentExpiry(const ExpiryEntry &entry) const { return entry.expiryID == _expiryID; }
+
+bool EncryptedConnectionLog::connectionExpiryDue()
 {
-  if(!getSoonestExpiringConnectionTracker() || remainingDuration < getSoonestExpiringConnectionTracker()->remainingDuration())
-  {
-    _soonestExpiringConnectionTracker = std::unique_ptr<ExpiringTimeTracker>(new ExpiringTimeTracker(remainingDuration));  // TODO: Change to std::make_unique<ExpiringTimeTracker>(remainingDuration); once compiler fully supports C++14
-  }
+  return _expiryHeap.size() > expiryHeapCompactionLimit || (!_expiryHeap.empty() && (int32_t)(millis() - _expiryHeap.front().deadlineMs) >= 0);
+}
+
+bool EncryptedConnectionLog::popExpiredEntry(ExpiryEntry &expiredEntry)
+{
+  if(_expiryHeap.empty() || (int32_t)(millis() - _expiryHeap.front().deadlineMs) < 0)
+    return false;
+
+  std::pop_heap(_expiryHeap.begin(), _expiryHeap.end(), expiresLater);
+  expiredEntry = _expiryHeap.back();
+  _expiryHeap.pop_back();
+  
+  return true;
 }
 
-void EncryptedConnectionLog::clearSoonestExpiringConnectionTracker()
+void EncryptedConnectionLog::pushExpiryEntry(const ExpiryEntry &entry)
 {
-  _soonestExpiringConnectionTracker = nullptr;
+  _expiryHeap.push_back(entry);
+  std::push_heap(_expiryHeap.begin(), _expiryHeap.end(), expiresLater);
+}
+
+void EncryptedConnectionLog::rebuildExpiryHeap(const std::vector<EncryptedConnectionLog> &encryptedConnections)
+{
+  _expiryHeap.clear();
+  
+  for(const EncryptedConnectionLog &connection : encryptedConnections)
+  {
+    if(const ExpiringTimeTracker *timeTracker = connection.temporary())
+    {
+      uint8_t encryptedPeerMac[6] {0};
+      _expiryHeap.push_back(ExpiryEntry{(uint32_t)(millis() + timeTracker->remainingDuration()), connection._expiryID, TypeCast::macToUint64(connection.getEncryptedPeerMac(encryptedPeerMac))});
+    }
+  }
+  
+  std::make_heap(_expiryHeap.begin(), _expiryHeap.end(), expiresLater);
+  _expiryHeap.shrink_to_fit();
 }
@@ -27,6 +27,7 @@
 
 #include "EncryptedConnectionData.h"
 #include "EspnowProtocolInterpreter.h"
+#include <vector>
 
 class EncryptedConnectionLog : public EncryptedConnectionData {
   
@@ -37,10 +38,6 @@ public:
   EncryptedConnectionLog(const uint8_t peerStaMac[6], const uint8_t peerApMac[6], const uint64_t peerSessionKey, const uint64_t ownSessionKey, 
                          const uint32_t duration, const uint8_t hashKey[EspnowProtocolInterpreter::hashKeyLength]);
 
-  // Only guaranteed to expire at the latest when the soonestExpiringConnection does. Can expire before the soonestExpiringConnection since it is not updated on connection removal.
-  // Needs to be a copy to avoid invalidation during operations on temporaryEncryptedConnections.
-  static std::unique_ptr<ExpiringTimeTracker> _soonestExpiringConnectionTracker;
-  
   // Only indicates if at least one removal was scheduled since the flag was last cleared, not if the removal is still scheduled to happen.
   // Canceling a removal will not update the flag.
   static bool _newRemovalsScheduled;
@@ -55,13 +52,47 @@ public:
   static void setNewRemovalsScheduled(const bool newRemovalsScheduled);
   static bool newRemovalsScheduled();
 
-  static const ExpiringTimeTracker *getSoonestExpiringConnectionTracker();
-  static void updateSoonestExpiringConnectionTracker(const uint32_t remainingDuration);
-  static void clearSoonestExpiringConnectionTracker();
+  /**
+   * An expiry deadline of a temporary encrypted connection. A new entry is added to the expiry heap each time the duration of a connection is set,
+   * so older entries of the same connection become stale. Only the entry with the same expiryID as the connection is current.
+   */
+  struct ExpiryEntry
+  {
+    uint32_t deadlineMs;
+    uint32_t expiryID;
+    uint64_t encryptedPeerMac;
+  };
+
+  /**
+   * @return True if the earliest deadline in the expiry heap has passed or the heap needs compaction, i.e. if updateTemporaryEncryptedConnections has any work to do.
+   */
+  static bool connectionExpiryDue();
+
+  /**
+   * Remove the entry with the earliest deadline from the expiry heap, if that deadline has passed.
+   * 
+   * @return True if an entry was removed and stored in expiredEntry. False if no deadline has passed.
+   */
+  static bool popExpiredEntry(ExpiryEntry &expiredEntry);
+  static void pushExpiryEntry(const ExpiryEntry &entry);
+
+  /**
+   * Replace the contents of the expiry heap with the current entries of the temporary connections in encryptedConnections, removing all stale entries.
+   */
+  static void rebuildExpiryHeap(const std::vector<EncryptedConnectionLog> &encryptedConnections);
+  
+  bool isCurrentExpiry(const ExpiryEntry &entry) const;
 
 private:
 
+  // Min-heap of the expiry deadlines of temporary connections, so expiry processing only has to look at connections whose deadline has passed.
+  static std::vector<ExpiryEntry> _expiryHeap;
+  static uint32_t _lastExpiryID;
+
+  void addExpiryEntry(const uint32_t remainingDuration);
+
   bool _scheduledForRemoval = false;
+  uint32_t _expiryID = 0;
   void setScheduledForRemoval(const bool scheduledForRemoval);
 };
 
@@ -549,28 +549,34 @@ void EspnowConnectionManager::handlePostponedRemovals()
 
 void EspnowConnectionManager::updateTemporaryEncryptedConnections(const bool scheduledRemovalOnly)
 {  
-  EncryptedConnectionLog::clearSoonestExpiringConnectionTracker();
+  // Only connections with a passed deadline in the expiry heap are examined, instead of all encrypted connections.
+  std::vector<EncryptedConnectionLog::ExpiryEntry> keptEntries;
+  EncryptedConnectionLog::ExpiryEntry expiredEntry;
   
-  for(auto connectionIterator = encryptedConnections().begin(); connectionIterator != encryptedConnections().end(); ) 
+  while(EncryptedConnectionLog::popExpiredEntry(expiredEntry))
   {
-    if(auto timeTrackerPointer = connectionIterator->temporary()) 
+    uint8_t macArray[6] = { 0 };
+    auto connectionIterator = getEncryptedConnectionIterator(TypeCast::uint64ToMac(expiredEntry.encryptedPeerMac, macArray), encryptedConnections());
+    
+    if(connectionIterator == encryptedConnections().end() || !connectionIterator->isCurrentExpiry(expiredEntry) || !connectionIterator->temporary())
+      continue; // Stale entry. The connection has been removed, made permanent or given a new duration.
+    
+    if(connectionIterator->temporary()->expired() && (!scheduledRemovalOnly || connectionIterator->removalScheduled())) 
     {
-      if(timeTrackerPointer->expired() && (!scheduledRemovalOnly || connectionIterator->removalScheduled())) 
-      {
-        uint8_t macArray[6] = { 0 };
-        removeEncryptedConnectionUnprotected(connectionIterator->getEncryptedPeerMac(macArray), &connectionIterator);
-        continue;
-      } 
-      else 
-      {        
-        EncryptedConnectionLog::updateSoonestExpiringConnectionTracker(timeTrackerPointer->remainingDuration());
-      }
+      removeEncryptedConnectionUnprotected(macArray, &connectionIterator);
+    } 
+    else 
+    {
+      keptEntries.push_back(expiredEntry); // Handled during a later call
     }
-    assert(!connectionIterator->removalScheduled()); // timeTracker should always exist and be expired if removal is scheduled.
-    
-    ++connectionIterator;   
   }
 
+  for(const EncryptedConnectionLog::ExpiryEntry &entry : keptEntries)
+    EncryptedConnectionLog::pushExpiryEntry(entry);
+
+  if(EncryptedConnectionLog::connectionExpiryDue() && !scheduledRemovalOnly)
+    EncryptedConnectionLog::rebuildExpiryHeap(encryptedConnections()); // Only stale or not quite expired entries can remain, so the heap has grown too big.
+
   EncryptedConnectionLog::setNewRemovalsScheduled(false);
 }
 
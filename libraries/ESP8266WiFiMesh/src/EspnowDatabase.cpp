@@ -28,6 +28,7 @@ namespace
   uint32_t _logEntryLifetimeMs = 2500;
   uint32_t _broadcastResponseTimeoutMs = 1000; // This is shorter than _logEntryLifetimeMs to preserve RAM since broadcasts are not deleted from sentRequests until they expire.
   ExpiringTimeTracker _logClearingCooldown(500);
+  uint8_t _logClearingStep = 0; // The next log to clear in clearOldLogEntriesStepwise, 0 when no stepwise clearing is in progress.
 
   uint32_t _encryptionRequestTimeoutMs = 300;
 
@@ -45,6 +46,12 @@ namespace
   std::map<std::pair<peerMac_td, messageID_td>, RequestData> _sentRequests = {};
   std::map<std::pair<peerMac_td, messageID_td>, TimeTracker> _receivedRequests = {};
 
+  // Indexes by MAC of the logs searched for each received transmission, see MacIndex.
+  constexpr uint16_t defaultPeerLimit = 64;
+  MacIndex _sentRequestIndex(defaultPeerLimit, 16);
+  MacIndex _receivedRequestIndex(defaultPeerLimit, 16);
+  MacIndex _responseRecipientIndex(defaultPeerLimit, 4);
+
   std::shared_ptr<bool> _espnowConnectionQueueMutex = std::make_shared<bool>(false);
   std::shared_ptr<bool> _responsesToSendMutex = std::make_shared<bool>(false);
 }
@@ -171,6 +178,21 @@ void EspnowDatabase::deleteExpiredLogEntries(std::list<PeerRequestLog> &logEntri
   }
 }
 
+template <typename T>
+void EspnowDatabase::rebuildIndex(MacIndex &index, const std::map<std::pair<uint64_t, uint64_t>, T> &logEntries)
+{
+  index.clear();
+  for(const auto &entry : logEntries)
+    index.add(entry.first.first, entry.first.second);
+}
+
+void EspnowDatabase::rebuildIndex(MacIndex &index, const std::list<ResponseData> &logEntries)
+{
+  index.clear();
+  for(const auto &entry : logEntries)
+    index.add(TypeCast::macToUint64(entry.getRecipientMac()));
+}
+
 void EspnowDatabase::setLogEntryLifetimeMs(const uint32_t logEntryLifetimeMs)
 {
   _logEntryLifetimeMs = logEntryLifetimeMs;
@@ -204,6 +226,7 @@ void EspnowDatabase::clearAllScheduledResponses()
   }
   
   responsesToSend().clear();
+  _responseRecipientIndex.clear();
 }
 
 void EspnowDatabase::deleteScheduledResponsesByRecipient(const uint8_t *recipientMac, const bool encryptedOnly)
@@ -214,6 +237,9 @@ void EspnowDatabase::deleteScheduledResponsesByRecipient(const uint8_t *recipien
     assert(false && String(F("ERROR! responsesToSend locked. Don't call deleteScheduledResponsesByRecipient from callbacks as this may corrupt program state! Aborting."))); 
   }
   
+  if(!_responseRecipientIndex.mayContain(TypeCast::macToUint64(recipientMac)))
+    return;
+  
   for(auto responseIterator = responsesToSend().begin(); responseIterator != responsesToSend().end(); )
   {
     if(MeshUtilityFunctions::macEqual(responseIterator->getRecipientMac(), recipientMac) && 
@@ -232,6 +258,17 @@ void EspnowDatabase::setEncryptionRequestTimeout(const uint32_t timeoutMs)
 }
 uint32_t EspnowDatabase::getEncryptionRequestTimeout() {return _encryptionRequestTimeoutMs;}
 
+void EspnowDatabase::setPeerLimit(const uint16_t peerLimit)
+{
+  _sentRequestIndex.setPeerLimit(peerLimit);
+  _receivedRequestIndex.setPeerLimit(peerLimit);
+  _responseRecipientIndex.setPeerLimit(peerLimit);
+  rebuildIndex(_sentRequestIndex, sentRequests());
+  rebuildIndex(_receivedRequestIndex, receivedRequests());
+  rebuildIndex(_responseRecipientIndex, responsesToSend());
+}
+uint16_t EspnowDatabase::peerLimit() {return _sentRequestIndex.peerLimit();}
+
 void EspnowDatabase::setAutoEncryptionDuration(const uint32_t duration)
 {
   _autoEncryptionDuration = duration;
@@ -264,14 +301,54 @@ void EspnowDatabase::clearOldLogEntries(bool forced)
   }
   
   _logClearingCooldown.reset();
+  _logClearingStep = 0;
   
   deleteExpiredLogEntries(receivedEspnowTransmissions(), logEntryLifetimeMs());
   deleteExpiredLogEntries(receivedRequests(), logEntryLifetimeMs()); // Just needs to be long enough to not accept repeated transmissions by mistake.
+  rebuildIndex(_receivedRequestIndex, receivedRequests());
   deleteExpiredLogEntries(sentRequests(), logEntryLifetimeMs(), broadcastResponseTimeoutMs());
+  rebuildIndex(_sentRequestIndex, sentRequests());
   deleteExpiredLogEntries(responsesToSend(), logEntryLifetimeMs());
+  rebuildIndex(_responseRecipientIndex, responsesToSend());
   deleteExpiredLogEntries(peerRequestConfirmationsToSend(), getEncryptionRequestTimeout());
 }
 
+bool EspnowDatabase::clearOldLogEntriesStepwise()
+{
+  if(_logClearingStep == 0)
+  {
+    if(!_logClearingCooldown)
+      return true;
+
+    _logClearingCooldown.reset();
+  }
+
+  switch(_logClearingStep++)
+  {
+    case 0:
+      deleteExpiredLogEntries(receivedEspnowTransmissions(), logEntryLifetimeMs());
+      break;
+    case 1:
+      deleteExpiredLogEntries(receivedRequests(), logEntryLifetimeMs());
+      rebuildIndex(_receivedRequestIndex, receivedRequests());
+      break;
+    case 2:
+      deleteExpiredLogEntries(sentRequests(), logEntryLifetimeMs(), broadcastResponseTimeoutMs());
+      rebuildIndex(_sentRequestIndex, sentRequests());
+      break;
+    case 3:
+      deleteExpiredLogEntries(responsesToSend(), logEntryLifetimeMs());
+      rebuildIndex(_responseRecipientIndex, responsesToSend());
+      break;
+    default:
+      deleteExpiredLogEntries(peerRequestConfirmationsToSend(), getEncryptionRequestTimeout());
+      _logClearingStep = 0;
+      return true;
+  }
+
+  return false;
+}
+
 std::list<ResponseData>::const_iterator EspnowDatabase::getScheduledResponse(const uint32_t responseIndex)
 {
   assert(responseIndex < numberOfScheduledResponses());
@@ -315,6 +392,9 @@ uint8 EspnowDatabase::getWiFiChannel() const
 
 bool EspnowDatabase::requestReceived(const uint64_t requestMac, const uint64_t requestID)
 {
+  if(!_receivedRequestIndex.mayContain(requestMac, requestID))
+    return false;
+  
   return receivedRequests().count(std::make_pair(requestMac, requestID));
 }
 
@@ -333,15 +413,26 @@ MutexTracker EspnowDatabase::captureResponsesToSendMutex(const std::function<voi
 void EspnowDatabase::storeSentRequest(const uint64_t targetBSSID, const uint64_t messageID, const RequestData &requestData)
 {
   sentRequests().insert(std::make_pair(std::make_pair(targetBSSID, messageID), requestData));
+  _sentRequestIndex.add(targetBSSID, messageID);
 }
 
 void EspnowDatabase::storeReceivedRequest(const uint64_t senderBSSID, const uint64_t messageID, const TimeTracker &timeTracker)
 {
   receivedRequests().insert(std::make_pair(std::make_pair(senderBSSID, messageID), timeTracker));
+  _receivedRequestIndex.add(senderBSSID, messageID);
+}
+
+void EspnowDatabase::storeScheduledResponse(const String &message, const uint8_t *recipientMac, const uint64_t requestID)
+{
+  responsesToSend().emplace_back(message, recipientMac, requestID);
+  _responseRecipientIndex.add(TypeCast::macToUint64(recipientMac));
 }
 
 EspnowMeshBackend *EspnowDatabase::getOwnerOfSentRequest(const uint64_t requestMac, const uint64_t requestID)
 {
+  if(!_sentRequestIndex.mayContain(requestMac, requestID))
+    return nullptr;
+  
   std::map<std::pair<peerMac_td, messageID_td>, RequestData>::iterator sentRequest = sentRequests().find(std::make_pair(requestMac, requestID));
   
   if(sentRequest != sentRequests().end())
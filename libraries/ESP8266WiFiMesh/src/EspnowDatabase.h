@@ -28,6 +28,7 @@
 #include "MessageData.h"
 #include "MutexTracker.h"
 #include "PeerRequestLog.h"
+#include "MacIndex.h"
 #include "ConditionalPrinter.h"
 #include "TypeConversionFunctions.h"
 
@@ -57,6 +58,8 @@ public:
   static void deleteScheduledResponsesByRecipient(const uint8_t *recipientMac, const bool encryptedOnly);
   static void setEncryptionRequestTimeout(const uint32_t timeoutMs);
   static uint32_t getEncryptionRequestTimeout();
+  static void setPeerLimit(const uint16_t peerLimit);
+  static uint16_t peerLimit();
   
   void setAutoEncryptionDuration(const uint32_t duration);
   uint32_t getAutoEncryptionDuration() const;
@@ -92,8 +95,19 @@ public:
   
   static void clearOldLogEntries(bool forced);
 
+  /**
+   * Like clearOldLogEntries(false), but only one log is cleared per call, to keep the duration of each call short.
+   * 
+   * @return True when all logs have been cleared (or clearing is on cooldown), false if more calls are needed to complete the clearing.
+   */
+  static bool clearOldLogEntriesStepwise();
+
+  /*
+   * Entries of sentRequests, receivedRequests and responsesToSend must be added with these, so they are indexed by MAC.
+   */
   static void storeSentRequest(const uint64_t targetBSSID, const uint64_t messageID, const RequestData &requestData);
   static void storeReceivedRequest(const uint64_t senderBSSID, const uint64_t messageID, const TimeTracker &timeTracker);
+  static void storeScheduledResponse(const String &message, const uint8_t *recipientMac, const uint64_t requestID);
   
   /**
   * Get a pointer to the EspnowMeshBackend instance that sent a request with the given requestID to the specified mac address.
@@ -137,56 +151,32 @@ public:
   template <typename T>
   static void deleteEntriesByMac(std::map<std::pair<macAndType_td, uint64_t>, T> &logEntries, const uint8_t *peerMac, const bool encryptedOnly)
   {    
-    bool macFound = false;
+    uint64_t uint64Mac = MeshTypeConversionFunctions::macToUint64(peerMac);
     
-    for(typename std::map<std::pair<macAndType_td, uint64_t>, T>::iterator entryIterator = logEntries.begin(); 
-        entryIterator != logEntries.end(); )
+    // Since the map is sorted by MAC, the entries of peerMac are found together, from the lowest message type and ID.
+    for(typename std::map<std::pair<macAndType_td, uint64_t>, T>::iterator entryIterator = logEntries.lower_bound(std::make_pair(EspnowProtocolInterpreter::createMacAndTypeValue(uint64Mac, 0), 0)); 
+        entryIterator != logEntries.end() && macAndTypeToUint64Mac(entryIterator->first.first) == uint64Mac; )
     {
-      if(macAndTypeToUint64Mac(entryIterator->first.first) == MeshTypeConversionFunctions::macToUint64(peerMac))
-      {
-        macFound = true;
-           
-        if(!encryptedOnly || EspnowProtocolInterpreter::usesEncryption(entryIterator->first.second))
-        {
-          entryIterator = logEntries.erase(entryIterator);
-          continue;
-        }
-      }
-      else if(macFound)
-      {
-        // Since the map is sorted by MAC, we know here that no more matching MAC will be found.
-        return;
-      }
-  
-      ++entryIterator;
+      if(!encryptedOnly || EspnowProtocolInterpreter::usesEncryption(entryIterator->first.second))
+        entryIterator = logEntries.erase(entryIterator);
+      else
+        ++entryIterator;
     }
   }
   
   template <typename T>
   static void deleteEntriesByMac(std::map<std::pair<uint64_t, uint64_t>, T> &logEntries, const uint8_t *peerMac, const bool encryptedOnly)
   {    
-    bool macFound = false;
+    uint64_t uint64Mac = MeshTypeConversionFunctions::macToUint64(peerMac);
     
-    for(typename std::map<std::pair<uint64_t, uint64_t>, T>::iterator entryIterator = logEntries.begin(); 
-        entryIterator != logEntries.end(); )
+    // Since the map is sorted by MAC, the entries of peerMac are found together, from the lowest message ID.
+    for(typename std::map<std::pair<uint64_t, uint64_t>, T>::iterator entryIterator = logEntries.lower_bound(std::make_pair(uint64Mac, 0)); 
+        entryIterator != logEntries.end() && entryIterator->first.first == uint64Mac; )
     {
-      if(entryIterator->first.first == MeshTypeConversionFunctions::macToUint64(peerMac))
-      {
-        macFound = true;
-           
-        if(!encryptedOnly || EspnowProtocolInterpreter::usesEncryption(entryIterator->first.second))
-        {
-          entryIterator = logEntries.erase(entryIterator);
-          continue;
-        }
-      }
-      else if(macFound)
-      {
-        // Since the map is sorted by MAC, we know here that no more matching MAC will be found.
-        return;
-      }
-  
-      ++entryIterator;
+      if(!encryptedOnly || EspnowProtocolInterpreter::usesEncryption(entryIterator->first.second))
+        entryIterator = logEntries.erase(entryIterator);
+      else
+        ++entryIterator;
     }
   }
 
@@ -214,6 +204,10 @@ private:
   template <typename T>
   static void deleteExpiredLogEntries(std::list<T> &logEntries, const uint32_t maxEntryLifetimeMs);
 
+  template <typename T>
+  static void rebuildIndex(MacIndex &index, const std::map<std::pair<uint64_t, uint64_t>, T> &logEntries);
+  static void rebuildIndex(MacIndex &index, const std::list<ResponseData> &logEntries);
+
   uint8_t _senderMac[6] = {0};
   uint8_t _senderAPMac[6] = {0};
   
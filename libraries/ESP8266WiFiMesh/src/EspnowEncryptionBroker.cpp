@@ -465,11 +465,16 @@ bool EspnowEncryptionBroker::verifyEncryptionRequestHmac(const String &encryptio
     if(hmacStartIndex < 0)
       return false;
    
-    if(hmac.length() == 2*experimental::crypto::SHA256::NATURAL_LENGTH // We know that each HMAC byte should become 2 String characters due to uint8ArrayToHexString.
-       && verifyMeshHmac(TypeCast::macToString(requesterStaMac) + TypeCast::macToString(requesterApMac) + encryptionRequestHmacMessage.substring(0, hmacStartIndex), hmac, hashKey, hashKeyLength))
-    {
-      return true;
-    }
+    if(hmac.length() != 2*experimental::crypto::SHA256::NATURAL_LENGTH) // We know that each HMAC byte should become 2 String characters due to uint8ArrayToHexString.
+      return false;
+
+    // Feed the HMAC input piecewise instead of concatenating a copy of the request.
+    experimental::crypto::HmacContext<experimental::crypto::SHA256> hmacContext(hashKey, hashKeyLength);
+    hmacContext.update(TypeCast::macToString(requesterStaMac));
+    hmacContext.update(TypeCast::macToString(requesterApMac));
+    hmacContext.update(encryptionRequestHmacMessage.c_str(), hmacStartIndex);
+    
+    return verifyMeshHmac(hmacContext, hmac);
   }
 
   return false;
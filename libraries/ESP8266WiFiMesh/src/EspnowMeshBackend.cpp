@@ -17,6 +17,7 @@
 */
 
 #include <ESP8266WiFi.h>
+#include <Schedule.h>
 extern "C" {
   #include <espnow.h>
 }
@@ -37,6 +38,19 @@ namespace
   namespace TypeCast = MeshTypeConversionFunctions;
 
   EspnowMeshBackend *_espnowRequestManager = nullptr;
+
+  enum class MaintenanceStep
+  {
+    LOG_CLEARING,
+    ENCRYPTED_CONNECTION_UPDATE,
+    PEER_REQUEST_CONFIRMATIONS,
+    CONTROL_TRANSMISSIONS,
+    RESPONSES,
+    BULK_TRANSMISSIONS
+  };
+
+  MaintenanceStep _nextMaintenanceStep = MaintenanceStep::LOG_CLEARING;
+  uint32_t _maintenanceTaskID = 0; // Incremented to stop the current maintenance task.
 }
 
 void espnowDelay(uint32_t durationMs)
@@ -96,6 +110,7 @@ EspnowMeshBackend::~EspnowMeshBackend()
   }
 
   _database.deleteSentRequestsByOwner(this);
+  EspnowTransmitter::deleteQueuedTransmissionsByOwner(this);
 }
 
 std::vector<EspnowNetworkInfo> & EspnowMeshBackend::connectionQueue()
@@ -166,6 +181,7 @@ bool EspnowMeshBackend::deactivateEspnow()
   {
     EspnowDatabase::responsesToSend().clear();
     EspnowDatabase::peerRequestConfirmationsToSend().clear();
+    EspnowTransmitter::clearQueuedTransmissions();
     EspnowDatabase::receivedEspnowTransmissions().clear();
     EspnowDatabase::sentRequests().clear();
     EspnowDatabase::receivedRequests().clear();
@@ -194,7 +210,7 @@ void EspnowMeshBackend::performEspnowMaintenance(const uint32_t estimatedMaxDura
 
   EspnowDatabase::clearOldLogEntries(false);
 
-  if(EncryptedConnectionLog::getSoonestExpiringConnectionTracker() && EncryptedConnectionLog::getSoonestExpiringConnectionTracker()->expired())
+  if(EncryptedConnectionLog::connectionExpiryDue())
   {
     EspnowConnectionManager::updateTemporaryEncryptedConnections();
   }
@@ -212,6 +228,80 @@ void EspnowMeshBackend::performEspnowMaintenance(const uint32_t estimatedMaxDura
   }
 }
 
+bool EspnowMeshBackend::performEspnowMaintenanceSlice(const uint32_t sliceDurationMs)
+{
+  assert(sliceDurationMs >= 1);
+  
+  ExpiringTimeTracker sliceTracker = ExpiringTimeTracker(sliceDurationMs);
+
+  // Doing this during an ESP-NOW transmission could invalidate iterators. Since slices may run from yield(), a captured mutex just means we try again later.
+  MutexTracker mutexTracker(EspnowTransmitter::captureEspnowTransmissionMutex(EspnowConnectionManager::handlePostponedRemovals));
+  if(!mutexTracker.mutexCaptured())
+    return false;
+
+  while(true)
+  {
+    bool stepCompleted = true;
+    
+    switch(_nextMaintenanceStep)
+    {
+      case MaintenanceStep::LOG_CLEARING:
+        stepCompleted = EspnowDatabase::clearOldLogEntriesStepwise();
+        break;
+      case MaintenanceStep::ENCRYPTED_CONNECTION_UPDATE:
+        if(EncryptedConnectionLog::connectionExpiryDue())
+          EspnowConnectionManager::updateTemporaryEncryptedConnections();
+        break;
+      case MaintenanceStep::PEER_REQUEST_CONFIRMATIONS:
+        EspnowEncryptionBroker::sendPeerRequestConfirmations(&sliceTracker);
+        stepCompleted = !sliceTracker.expired();
+        break;
+      case MaintenanceStep::CONTROL_TRANSMISSIONS:
+        EspnowTransmitter::sendQueuedTransmissions(TransmissionPriority::CONTROL, &sliceTracker);
+        stepCompleted = !sliceTracker.expired();
+        break;
+      case MaintenanceStep::RESPONSES:
+        EspnowTransmitter::sendEspnowResponses(&sliceTracker);
+        stepCompleted = !sliceTracker.expired();
+        break;
+      case MaintenanceStep::BULK_TRANSMISSIONS:
+        EspnowTransmitter::sendQueuedTransmissions(TransmissionPriority::BULK, &sliceTracker);
+        stepCompleted = !sliceTracker.expired();
+        break;
+    }
+
+    if(stepCompleted)
+    {
+      if(_nextMaintenanceStep == MaintenanceStep::BULK_TRANSMISSIONS)
+      {
+        _nextMaintenanceStep = MaintenanceStep::LOG_CLEARING;
+        return true;
+      }
+      
+      _nextMaintenanceStep = static_cast<MaintenanceStep>(static_cast<int>(_nextMaintenanceStep) + 1);
+    }
+
+    if(sliceTracker.expired())
+      return false;
+  }
+}
+
+void EspnowMeshBackend::startEspnowMaintenanceTask(const uint32_t sliceDurationMs, const uint32_t sliceIntervalMs)
+{
+  const uint32_t taskID = ++_maintenanceTaskID;
+  
+  schedule_recurrent_function_us([taskID, sliceDurationMs]()
+  {
+    if(taskID != _maintenanceTaskID)
+      return false; // Task stopped or replaced
+    
+    performEspnowMaintenanceSlice(sliceDurationMs);
+    return true;
+  }, sliceIntervalMs * 1000);
+}
+
+void EspnowMeshBackend::stopEspnowMaintenanceTask() { ++_maintenanceTaskID; }
+
 void EspnowMeshBackend::espnowReceiveCallbackWrapper(uint8_t *macaddr, uint8_t *dataArray, const uint8_t len)
 {
   using namespace EspnowProtocolInterpreter;
@@ -239,10 +329,10 @@ void EspnowMeshBackend::espnowReceiveCallbackWrapper(uint8_t *macaddr, uint8_t *
 
     if(EspnowTransmitter::useEncryptedMessages())
     {
-      // chacha20Poly1305Decrypt decrypts dataArray in place.
+      // Decrypts dataArray in place, without allocating.
       // We are using the protocol bytes as a key salt.
-      if(!experimental::crypto::ChaCha20Poly1305::decrypt(dataArray + metadataSize(), len - metadataSize(), getEspnowMessageEncryptionKey(), dataArray, 
-                                                   protocolBytesSize, dataArray + protocolBytesSize, dataArray + protocolBytesSize + 12))
+      if(!MeshCryptoInterface::decryptInPlace(dataArray + metadataSize(), len - metadataSize(), getEspnowMessageEncryptionKey(), dataArray, 
+                                              protocolBytesSize, dataArray + protocolBytesSize, dataArray + protocolBytesSize + 12))
       {
         return; // Decryption of message failed.
       }
@@ -393,20 +483,33 @@ void EspnowMeshBackend::espnowReceiveCallback(const uint8_t *macaddr, uint8_t *d
       if(EspnowDatabase::receivedEspnowTransmissions().find(key) != EspnowDatabase::receivedEspnowTransmissions().end())
         return; // Should not call BroadcastFilter more than once for an accepted message
       
-      String message = getHashKeyLength(dataArray, len);
       _database.setSenderMac(macaddr);
       uint8_t senderAPMac[6] {0};
       _database.setSenderAPMac(getTransmissionMac(dataArray, senderAPMac));
       _encryptionBroker.setReceivedEncryptedTransmission(usesEncryption(messageID));
-      bool acceptBroadcast = getBroadcastFilter()(message, *this);
-      if(acceptBroadcast)
+
+      if(binaryBroadcastFilterType binaryBroadcastFilter = getBinaryBroadcastFilter())
       {
+        uint8_t espnowMetadataSize = metadataSize();
+        if(len < espnowMetadataSize || !binaryBroadcastFilter(dataArray + espnowMetadataSize, len - espnowMetadataSize, *this))
+          return;
+
         // Does nothing if key already in receivedEspnowTransmissions
-        EspnowDatabase::receivedEspnowTransmissions().insert(std::make_pair(key, MessageData(message, getTransmissionsRemaining(dataArray))));
+        EspnowDatabase::receivedEspnowTransmissions().insert(std::make_pair(key, MessageData(dataArray, len)));
       }
       else
       {
-        return;
+        String message = getHashKeyLength(dataArray, len);
+        bool acceptBroadcast = getBroadcastFilter()(message, *this);
+        if(acceptBroadcast)
+        {
+          // Does nothing if key already in receivedEspnowTransmissions
+          EspnowDatabase::receivedEspnowTransmissions().insert(std::make_pair(key, MessageData(message, getTransmissionsRemaining(dataArray))));
+        }
+        else
+        {
+          return;
+        }
       }
     }
     else
@@ -449,10 +552,10 @@ void EspnowMeshBackend::espnowReceiveCallback(const uint8_t *macaddr, uint8_t *d
   std::map<std::pair<macAndType_td, messageID_td>, MessageData>::iterator storedMessageIterator = EspnowDatabase::receivedEspnowTransmissions().find(std::make_pair(macAndType, messageID));
   assert(storedMessageIterator != EspnowDatabase::receivedEspnowTransmissions().end());
 
-  // Copy totalMessage in case user callbacks (request/responseHandler) do something odd with receivedEspnowTransmissions list.
-  String totalMessage = storedMessageIterator->second.getTotalMessage(); // https://stackoverflow.com/questions/134731/returning-a-const-reference-to-an-object-instead-of-a-copy It is likely that most compilers will perform Named Value Return Value Optimisation in this case
+  // Move the message out in case user callbacks (request/responseHandler) do something odd with receivedEspnowTransmissions list.
+  MessageData totalMessage = std::move(storedMessageIterator->second);
 
-  EspnowDatabase::receivedEspnowTransmissions().erase(storedMessageIterator); // Erase the extra copy of the totalMessage, to save RAM. 
+  EspnowDatabase::receivedEspnowTransmissions().erase(storedMessageIterator);
    
   //Serial.println("methodStart erase done " + String(millis() - methodStart));
   
@@ -465,12 +568,16 @@ void EspnowMeshBackend::espnowReceiveCallback(const uint8_t *macaddr, uint8_t *d
     uint8_t senderAPMac[6] {0};
     _database.setSenderAPMac(getTransmissionMac(dataArray, senderAPMac));
     _encryptionBroker.setReceivedEncryptedTransmission(usesEncryption(messageID));
-    String response = getRequestHandler()(totalMessage, *this);
+    String response;
+    if(binaryRequestHandlerType binaryRequestHandler = getBinaryRequestHandler())
+      response = binaryRequestHandler(totalMessage.getTotalMessageData(), totalMessage.getTotalMessageLength(), *this);
+    else
+      response = getRequestHandler()(totalMessage.getTotalMessage(), *this);
     //Serial.println("methodStart response acquired " + String(millis() - methodStart));
      
     if(response.length() > 0)
     {
-      EspnowDatabase::responsesToSend().emplace_back(response, macaddr, messageID);
+      EspnowDatabase::storeScheduledResponse(response, macaddr, messageID);
       
       //Serial.println("methodStart Q done " + String(millis() - methodStart));
     }
@@ -492,7 +599,10 @@ void EspnowMeshBackend::espnowReceiveCallback(const uint8_t *macaddr, uint8_t *d
     uint8_t senderAPMac[6] {0};
     _database.setSenderAPMac(getTransmissionMac(dataArray, senderAPMac));
     _encryptionBroker.setReceivedEncryptedTransmission(usesEncryption(messageID));
-    getResponseHandler()(totalMessage, *this);
+    if(binaryResponseHandlerType binaryResponseHandler = getBinaryResponseHandler())
+      binaryResponseHandler(totalMessage.getTotalMessageData(), totalMessage.getTotalMessageLength(), *this);
+    else
+      getResponseHandler()(totalMessage.getTotalMessage(), *this);
   }
   else
   {
@@ -522,6 +632,12 @@ void EspnowMeshBackend::setLogEntryLifetimeMs(const uint32_t logEntryLifetimeMs)
 }
 uint32_t EspnowMeshBackend::logEntryLifetimeMs() { return EspnowDatabase::logEntryLifetimeMs(); }
 
+void EspnowMeshBackend::setPeerLimit(const uint16_t peerLimit)
+{
+  EspnowDatabase::setPeerLimit(peerLimit);
+}
+uint16_t EspnowMeshBackend::peerLimit() { return EspnowDatabase::peerLimit(); }
+
 void EspnowMeshBackend::setBroadcastResponseTimeoutMs(const uint32_t broadcastResponseTimeoutMs)
 {
   EspnowDatabase::setBroadcastResponseTimeoutMs(broadcastResponseTimeoutMs);
@@ -555,6 +671,19 @@ void EspnowMeshBackend::setEspnowRetransmissionInterval(const uint32_t intervalM
 }
 uint32_t EspnowMeshBackend::getEspnowRetransmissionInterval() {return EspnowTransmitter::getEspnowRetransmissionInterval();}
 
+void EspnowMeshBackend::setMaxQueuedTransmissions(const uint16_t maxQueuedTransmissions)
+{
+  EspnowTransmitter::setMaxQueuedTransmissions(maxQueuedTransmissions);
+}
+uint16_t EspnowMeshBackend::getMaxQueuedTransmissions() {return EspnowTransmitter::getMaxQueuedTransmissions();}
+
+void EspnowMeshBackend::setPeerTransmissionRate(const uint32_t framesPerSecond, const uint32_t burstFrames)
+{
+  EspnowTransmitter::setPeerTransmissionRate(framesPerSecond, burstFrames);
+}
+uint32_t EspnowMeshBackend::getPeerTransmissionRate() {return EspnowTransmitter::getPeerTransmissionRate();}
+uint32_t EspnowMeshBackend::getPeerTransmissionBurst() {return EspnowTransmitter::getPeerTransmissionBurst();}
+
 void EspnowMeshBackend::setEncryptionRequestTimeout(const uint32_t timeoutMs)
 {
   EspnowDatabase::setEncryptionRequestTimeout(timeoutMs);
@@ -570,6 +699,15 @@ uint32_t EspnowMeshBackend::getAutoEncryptionDuration() const {return _database.
 void EspnowMeshBackend::setBroadcastFilter(const broadcastFilterType broadcastFilter) {_broadcastFilter = broadcastFilter;}
 EspnowMeshBackend::broadcastFilterType EspnowMeshBackend::getBroadcastFilter() const {return _broadcastFilter;}
 
+void EspnowMeshBackend::setBinaryRequestHandler(const binaryRequestHandlerType binaryRequestHandler) {_binaryRequestHandler = binaryRequestHandler;}
+EspnowMeshBackend::binaryRequestHandlerType EspnowMeshBackend::getBinaryRequestHandler() const {return _binaryRequestHandler;}
+
+void EspnowMeshBackend::setBinaryResponseHandler(const binaryResponseHandlerType binaryResponseHandler) {_binaryResponseHandler = binaryResponseHandler;}
+EspnowMeshBackend::binaryResponseHandlerType EspnowMeshBackend::getBinaryResponseHandler() const {return _binaryResponseHandler;}
+
+void EspnowMeshBackend::setBinaryBroadcastFilter(const binaryBroadcastFilterType binaryBroadcastFilter) {_binaryBroadcastFilter = binaryBroadcastFilter;}
+EspnowMeshBackend::binaryBroadcastFilterType EspnowMeshBackend::getBinaryBroadcastFilter() const {return _binaryBroadcastFilter;}
+
 void EspnowMeshBackend::setEspnowEncryptedConnectionKey(const uint8_t espnowEncryptedConnectionKey[encryptedConnectionKeyLength])
 {
   _connectionManager.setEspnowEncryptedConnectionKey(espnowEncryptedConnectionKey);
@@ -756,6 +894,11 @@ void EspnowMeshBackend::prepareForTransmission(const String &message, const bool
 }
 
 TransmissionStatusType EspnowMeshBackend::initiateTransmission(const String &message, const EspnowNetworkInfo &recipientInfo)
+{
+  return initiateTransmission(reinterpret_cast<const uint8_t *>(message.c_str()), message.length(), recipientInfo);
+}
+
+TransmissionStatusType EspnowMeshBackend::initiateTransmission(const uint8_t *message, const uint32_t messageLength, const EspnowNetworkInfo &recipientInfo)
 {
   uint8_t targetBSSID[6] {0};
 
@@ -768,13 +911,18 @@ TransmissionStatusType EspnowMeshBackend::initiateTransmission(const String &mes
     verboseModePrint(emptyString);
   }
 
-  return initiateTransmissionKernel(message, targetBSSID);
+  return initiateTransmissionKernel(message, messageLength, targetBSSID);
 }
 
 TransmissionStatusType EspnowMeshBackend::initiateTransmissionKernel(const String &message, const uint8_t *targetBSSID)
+{
+  return initiateTransmissionKernel(reinterpret_cast<const uint8_t *>(message.c_str()), message.length(), targetBSSID);
+}
+
+TransmissionStatusType EspnowMeshBackend::initiateTransmissionKernel(const uint8_t *message, const uint32_t messageLength, const uint8_t *targetBSSID)
 {
   uint32_t transmissionStartTime = millis();
-  TransmissionStatusType transmissionResult = _transmitter.sendRequest(message, targetBSSID, this);
+  TransmissionStatusType transmissionResult = _transmitter.sendRequest(message, messageLength, targetBSSID, this);
 
   uint32_t transmissionDuration = millis() - transmissionStartTime;
   
@@ -848,6 +996,18 @@ TransmissionStatusType EspnowMeshBackend::attemptTransmission(const String &mess
   return initiateTransmission(message, recipientInfo);
 }
 
+TransmissionStatusType EspnowMeshBackend::attemptTransmission(const uint8_t *message, const uint32_t messageLength, const EspnowNetworkInfo &recipientInfo)
+{
+  MutexTracker mutexTracker(EspnowTransmitter::captureEspnowTransmissionMutex(EspnowConnectionManager::handlePostponedRemovals));
+  if(!mutexTracker.mutexCaptured())
+  {
+    assert(false && String(F("ERROR! Transmission in progress. Don't call attemptTransmission from callbacks as this may corrupt program state! Aborting."))); 
+    return TransmissionStatusType::CONNECTION_FAILED;
+  }
+
+  return initiateTransmission(message, messageLength, recipientInfo);
+}
+
 TransmissionStatusType EspnowMeshBackend::initiateAutoEncryptingTransmission(const String &message, uint8_t *targetBSSID, EncryptedConnectionStatus connectionStatus)
 {
   TransmissionStatusType transmissionResult = TransmissionStatusType::CONNECTION_FAILED;
@@ -941,6 +1101,43 @@ void EspnowMeshBackend::broadcast(const String &message)
   EspnowTransmitter::espnowSendToNode(message, EspnowProtocolInterpreter::broadcastMac, 'B', this);
 }
 
+void EspnowMeshBackend::broadcast(const uint8_t *message, const uint32_t messageLength)
+{  
+  MutexTracker mutexTracker(EspnowTransmitter::captureEspnowTransmissionMutex(EspnowConnectionManager::handlePostponedRemovals));
+  if(!mutexTracker.mutexCaptured())
+  {
+    assert(false && String(F("ERROR! Transmission in progress. Don't call broadcast from callbacks as this may corrupt program state! Aborting."))); 
+    return;
+  }
+
+  EspnowTransmitter::espnowSendToNode(message, messageLength, EspnowProtocolInterpreter::broadcastMac, 'B', this);
+}
+
+bool EspnowMeshBackend::queueTransmission(const String &message, const EspnowNetworkInfo &recipientInfo, const TransmissionPriority priority)
+{
+  return queueTransmission(reinterpret_cast<const uint8_t *>(message.c_str()), message.length(), recipientInfo, priority);
+}
+
+bool EspnowMeshBackend::queueTransmission(const uint8_t *message, const uint32_t messageLength, const EspnowNetworkInfo &recipientInfo, const TransmissionPriority priority)
+{
+  assert(recipientInfo.BSSID() != nullptr); // We need at least the BSSID to transmit
+
+  uint8_t targetBSSID[6] {0};
+  recipientInfo.getBSSID(targetBSSID);
+  
+  return EspnowTransmitter::queueTransmission(message, messageLength, targetBSSID, 'Q', *this, priority);
+}
+
+bool EspnowMeshBackend::queueBroadcast(const String &message, const TransmissionPriority priority)
+{
+  return queueBroadcast(reinterpret_cast<const uint8_t *>(message.c_str()), message.length(), priority);
+}
+
+bool EspnowMeshBackend::queueBroadcast(const uint8_t *message, const uint32_t messageLength, const TransmissionPriority priority)
+{
+  return EspnowTransmitter::queueTransmission(message, messageLength, EspnowProtocolInterpreter::broadcastMac, 'B', *this, priority);
+}
+
 void EspnowMeshBackend::setBroadcastTransmissionRedundancy(const uint8_t redundancy) { _transmitter.setBroadcastTransmissionRedundancy(redundancy); }
 uint8_t EspnowMeshBackend::getBroadcastTransmissionRedundancy() const { return _transmitter.getBroadcastTransmissionRedundancy(); }
 
@@ -960,10 +1157,20 @@ void EspnowMeshBackend::sendStoredEspnowMessages(const ExpiringTimeTracker *esti
 {
   EspnowEncryptionBroker::sendPeerRequestConfirmations(estimatedMaxDurationTracker);
 
+  if(estimatedMaxDurationTracker && estimatedMaxDurationTracker->expired())
+    return;
+
+  EspnowTransmitter::sendQueuedTransmissions(TransmissionPriority::CONTROL, estimatedMaxDurationTracker);
+
   if(estimatedMaxDurationTracker && estimatedMaxDurationTracker->expired())
     return;
 
   EspnowTransmitter::sendEspnowResponses(estimatedMaxDurationTracker);
+
+  if(estimatedMaxDurationTracker && estimatedMaxDurationTracker->expired())
+    return;
+
+  EspnowTransmitter::sendQueuedTransmissions(TransmissionPriority::BULK, estimatedMaxDurationTracker);
 }
 
 uint32_t EspnowMeshBackend::getMaxMessageBytesPerTransmission()
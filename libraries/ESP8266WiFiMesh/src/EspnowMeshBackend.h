@@ -109,6 +109,10 @@ class EspnowMeshBackend : public MeshBackendBase {
 public: 
 
   using broadcastFilterType = std::function<bool(String &, EspnowMeshBackend &)>;
+  // Binary versions of the requestHandler, responseHandler and broadcastFilter. The data pointers are only valid during the call.
+  using binaryRequestHandlerType = std::function<String(const uint8_t *, uint32_t, EspnowMeshBackend &)>;
+  using binaryResponseHandlerType = std::function<TransmissionStatusType(const uint8_t *, uint32_t, EspnowMeshBackend &)>;
+  using binaryBroadcastFilterType = std::function<bool(const uint8_t *, uint32_t, EspnowMeshBackend &)>;
   
   /**
    * ESP-NOW constructor method. Creates an ESP-NOW node, ready to be initialised.
@@ -218,6 +222,30 @@ public:
    */
   static void performEspnowMaintenance(const uint32_t estimatedMaxDuration = 0);
 
+  /**
+   * Perform a part of the work of performEspnowMaintenance(), resuming where the previous slice stopped.
+   * The work is split into steps (clearing of each log, encrypted connection updates, peer request confirmations, queued transmissions and responses)
+   * and the slice stops as soon as the duration is exceeded, so the remaining work is carried over to the next slice.
+   * A single step, e.g. one ESP-NOW message transmission, is never interrupted, so a slice may still overshoot by the duration of that step.
+   * 
+   * Does nothing if a transmission is in progress, so it is safe to call from places where that may be the case, e.g. a recurrent scheduled function.
+   * 
+   * @param sliceDurationMs The maximum duration of the slice, in milliseconds. Must be at least 1.
+   * @return True if the slice completed a full round of maintenance. False if work remains or the slice was skipped.
+   */
+  static bool performEspnowMaintenanceSlice(const uint32_t sliceDurationMs);
+
+  /**
+   * Run the ESP-NOW maintenance as a cooperative task instead of calling performEspnowMaintenance() from the loop.
+   * A recurrent scheduled function calls performEspnowMaintenanceSlice(sliceDurationMs) every sliceIntervalMs, including during delay() and yield().
+   * Starting the task again replaces the previous task.
+   * 
+   * @param sliceDurationMs The maximum duration of each slice, in milliseconds.
+   * @param sliceIntervalMs The time between the start of two slices, in milliseconds.
+   */
+  static void startEspnowMaintenanceTask(const uint32_t sliceDurationMs = 2, const uint32_t sliceIntervalMs = 10);
+  static void stopEspnowMaintenanceTask();
+
   /**
    * At critical heap level no more incoming requests are accepted.
    */
@@ -257,6 +285,15 @@ public:
    * @param recipientInfo The recipient information.
    */
   TransmissionStatusType attemptTransmission(const String &message, const EspnowNetworkInfo &recipientInfo);
+
+  /**
+   * Binary version of attemptTransmission for a single recipient. The message is sent as is, without any conversion to String.
+   * 
+   * @param message The message bytes. Must not be modified until the method returns.
+   * @param messageLength The number of bytes in message.
+   * @param recipientInfo The recipient information.
+   */
+  TransmissionStatusType attemptTransmission(const uint8_t *message, const uint32_t messageLength, const EspnowNetworkInfo &recipientInfo);
   
   /* 
    * Will ensure that an encrypted connection exists to each target node before sending the message, 
@@ -303,6 +340,34 @@ public:
    */
   void broadcast(const String &message);
 
+  /**
+   * Binary version of broadcast. The message is sent as is, without any conversion to String.
+   * 
+   * @param message The message bytes. Must not be modified until the method returns.
+   * @param messageLength The number of bytes in message.
+   */
+  void broadcast(const uint8_t *message, const uint32_t messageLength);
+
+  /**
+   * Queue a request to a single recipient instead of sending it right away. Queued transmissions are sent during performEspnowMaintenance, 
+   * CONTROL class transmissions before any responses and BULK class transmissions after them, so urgent messages are not delayed by large amounts of bulk data.
+   * BULK class transmissions are subject to the per peer rate limit set by setPeerTransmissionRate.
+   * The outcome of a queued transmission is not reported, but failures are included in getTransmissionFailRate().
+   * 
+   * @param message The message to send. It is copied into the queue.
+   * @param recipientInfo The recipient information. Only the BSSID is used.
+   * @param priority The priority class of the transmission.
+   * @return True if the message was queued. False if the queue is full (see setMaxQueuedTransmissions) or heap is too low.
+   */
+  bool queueTransmission(const String &message, const EspnowNetworkInfo &recipientInfo, const TransmissionPriority priority = TransmissionPriority::BULK);
+  bool queueTransmission(const uint8_t *message, const uint32_t messageLength, const EspnowNetworkInfo &recipientInfo, const TransmissionPriority priority = TransmissionPriority::BULK);
+
+  /**
+   * Queue a broadcast. See queueTransmission and broadcast for details.
+   */
+  bool queueBroadcast(const String &message, const TransmissionPriority priority = TransmissionPriority::BULK);
+  bool queueBroadcast(const uint8_t *message, const uint32_t messageLength, const TransmissionPriority priority = TransmissionPriority::BULK);
+
   /**
    * Set the number of redundant transmissions that will be made for every broadcast. 
    * A greater number increases the likelihood that the broadcast is received, but also means it takes longer time to send.
@@ -341,6 +406,17 @@ public:
   static void setLogEntryLifetimeMs(const uint32_t logEntryLifetimeMs);
   static uint32_t logEntryLifetimeMs();
 
+  /**
+   * Set the number of peers the ESP-NOW logs are indexed for. The indexes let most received transmissions be handled without searching the logs, 
+   * they take about peerLimit * 36 bits of RAM. With more peers than this, more transmissions fall back to searching the logs.
+   * 
+   * Set to 64 by default.
+   * 
+   * @param peerLimit The number of peers to index the logs for.
+   */
+  static void setPeerLimit(const uint16_t peerLimit);
+  static uint16_t peerLimit();
+
   /**
    * Set the duration during which sent ESP-NOW broadcast are stored in the log and can receive responses.
    * This is shorter by default than logEntryLifetimeMs() in order to preserve RAM since broadcasts are always kept in the log until they expire,
@@ -628,6 +704,26 @@ public:
   static void setEspnowRetransmissionInterval(const uint32_t intervalMs);
   static uint32_t getEspnowRetransmissionInterval();
 
+  /**
+   * Set the maximum number of transmissions that can wait in the transmit queues (both priority classes combined). Each queued transmission keeps a copy of its message on the heap.
+   * 
+   * @param maxQueuedTransmissions The maximum number of queued transmissions. Defaults to 32.
+   */
+  static void setMaxQueuedTransmissions(const uint16_t maxQueuedTransmissions);
+  static uint16_t getMaxQueuedTransmissions();
+
+  /**
+   * Limit the rate of queued BULK class transmissions to each peer. Every ESP-NOW frame uses one token from the token bucket of the receiving peer,
+   * and each bucket is refilled at framesPerSecond tokens per second up to burstFrames tokens. A broadcast counts as one peer.
+   * CONTROL class transmissions and transmissions that are not queued are not limited.
+   * 
+   * @param framesPerSecond The sustained number of frames per second allowed to each peer. 0 disables the limit, which is the default.
+   * @param burstFrames The number of frames that can be sent to a peer in a burst. Must be at least getMaxTransmissionsPerMessage(). Defaults to 10.
+   */
+  static void setPeerTransmissionRate(const uint32_t framesPerSecond, const uint32_t burstFrames);
+  static uint32_t getPeerTransmissionRate();
+  static uint32_t getPeerTransmissionBurst();
+
   // The maximum amount of time each of the two stages in an encrypted connection request may take.
   static void setEncryptionRequestTimeout(const uint32_t timeoutMs);
   static uint32_t getEncryptionRequestTimeout();
@@ -638,6 +734,17 @@ public:
   void setBroadcastFilter(const broadcastFilterType broadcastFilter);
   broadcastFilterType getBroadcastFilter() const;
 
+  /**
+   * Set handlers receiving messages as raw bytes, reassembled from all transmissions in one buffer. 
+   * When set, they are used instead of the String based requestHandler, responseHandler and broadcastFilter respectively. Set to nullptr to go back to those.
+   */
+  void setBinaryRequestHandler(const binaryRequestHandlerType binaryRequestHandler);
+  binaryRequestHandlerType getBinaryRequestHandler() const;
+  void setBinaryResponseHandler(const binaryResponseHandlerType binaryResponseHandler);
+  binaryResponseHandlerType getBinaryResponseHandler() const;
+  void setBinaryBroadcastFilter(const binaryBroadcastFilterType binaryBroadcastFilter);
+  binaryBroadcastFilterType getBinaryBroadcastFilter() const;
+
   /**
    * Set a function that should be called after each attempted ESP-NOW response transmission.
    * In case of a successful response transmission, the call happens just before the response is removed from the waiting list.
@@ -989,7 +1096,9 @@ private:
 
   void prepareForTransmission(const String &message, const bool scan, const bool scanAllWiFiChannels);
   TransmissionStatusType initiateTransmission(const String &message, const EspnowNetworkInfo &recipientInfo);
+  TransmissionStatusType initiateTransmission(const uint8_t *message, const uint32_t messageLength, const EspnowNetworkInfo &recipientInfo);
   TransmissionStatusType initiateTransmissionKernel(const String &message, const uint8_t *targetBSSID);  
+  TransmissionStatusType initiateTransmissionKernel(const uint8_t *message, const uint32_t messageLength, const uint8_t *targetBSSID);
   TransmissionStatusType initiateAutoEncryptingTransmission(const String &message, uint8_t *targetBSSID, const EncryptedConnectionStatus connectionStatus);
   void printTransmissionStatistics() const;
   
@@ -1008,6 +1117,9 @@ private:
   void espnowReceiveCallback(const uint8_t *macaddr, uint8_t *data, const uint8_t len);
 
   broadcastFilterType _broadcastFilter;
+  binaryRequestHandlerType _binaryRequestHandler = nullptr;
+  binaryResponseHandlerType _binaryResponseHandler = nullptr;
+  binaryBroadcastFilterType _binaryBroadcastFilter = nullptr;
 
   bool _acceptsUnverifiedRequests = true;
 };
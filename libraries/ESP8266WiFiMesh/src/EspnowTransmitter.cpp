@@ -47,6 +47,75 @@ namespace
   bool _espnowSendConfirmed = false;
 
   uint8_t _maxTransmissionsPerMessage = 3;
+
+  struct QueuedTransmission
+  {
+    std::unique_ptr<uint8_t[]> message;
+    uint32_t messageLength;
+    uint8_t targetBSSID[6];
+    char messageType;
+    EspnowMeshBackend *espnowInstance;
+  };
+
+  struct TokenBucket
+  {
+    uint32_t milliTokens;
+    uint32_t updateTimeMs;
+  };
+
+  std::list<QueuedTransmission> _transmissionQueues[2] = {}; // Indexed by TransmissionPriority
+  uint16_t _maxQueuedTransmissions = 32;
+  
+  std::map<uint64_t, TokenBucket> _peerTokenBuckets = {};
+  uint32_t _peerTransmissionRate = 0; // frames per second, 0 for no limit
+  uint32_t _peerTransmissionBurst = 10;
+
+  uint32_t framesRequired(const uint32_t messageLength)
+  {
+    uint32_t maxBytes = EspnowProtocolInterpreter::getMaxMessageBytesPerTransmission();
+    return messageLength > maxBytes ? (messageLength + maxBytes - 1) / maxBytes : 1;
+  }
+
+  void refillTokenBucket(TokenBucket &bucket, const uint32_t currentTimeMs)
+  {
+    // The rate is given in frames per second, which is the same as milliTokens per millisecond.
+    uint64_t milliTokens = bucket.milliTokens + (uint64_t)(currentTimeMs - bucket.updateTimeMs) * _peerTransmissionRate;
+    bucket.milliTokens = std::min(milliTokens, (uint64_t)_peerTransmissionBurst * 1000);
+    bucket.updateTimeMs = currentTimeMs;
+  }
+
+  bool consumePeerTokens(const uint8_t *peerMac, const uint32_t frames)
+  {
+    if(_peerTransmissionRate == 0)
+      return true;
+
+    uint32_t currentTimeMs = millis();
+    auto emplacementResult = _peerTokenBuckets.emplace(TypeCast::macToUint64(peerMac), TokenBucket{_peerTransmissionBurst * 1000, currentTimeMs});
+    TokenBucket &bucket = emplacementResult.first->second;
+    refillTokenBucket(bucket, currentTimeMs);
+
+    uint32_t requiredMilliTokens = std::min(frames, _peerTransmissionBurst) * 1000;
+    if(bucket.milliTokens < requiredMilliTokens)
+      return false;
+
+    bucket.milliTokens -= requiredMilliTokens;
+    return true;
+  }
+
+  void pruneTokenBuckets()
+  {
+    // A full bucket holds no information beyond what a new bucket would, so it can be removed.
+    uint32_t currentTimeMs = millis();
+    for(auto bucketIterator = _peerTokenBuckets.begin(); bucketIterator != _peerTokenBuckets.end(); )
+    {
+      refillTokenBucket(bucketIterator->second, currentTimeMs);
+
+      if(bucketIterator->second.milliTokens >= _peerTransmissionBurst * 1000)
+        bucketIterator = _peerTokenBuckets.erase(bucketIterator);
+      else
+        ++bucketIterator;
+    }
+  }
 }
 
 EspnowTransmitter::EspnowTransmitter(ConditionalPrinter &conditionalPrinterInstance, EspnowDatabase &databaseInstance, EspnowConnectionManager &connectionManagerInstance) 
@@ -195,6 +264,86 @@ void EspnowTransmitter::sendEspnowResponses(const ExpiringTimeTracker *estimated
   }
 }
 
+bool EspnowTransmitter::queueTransmission(const uint8_t *message, const uint32_t messageLength, const uint8_t *targetBSSID, const char messageType, 
+                                          EspnowMeshBackend &espnowInstance, const TransmissionPriority priority)
+{
+  assert(messageType == 'Q' || messageType == 'B');
+  assert(messageLength <= getMaxMessageLength());
+  
+  if(numberOfQueuedTransmissions(TransmissionPriority::CONTROL) + numberOfQueuedTransmissions(TransmissionPriority::BULK) >= getMaxQueuedTransmissions())
+    return false;
+
+  std::unique_ptr<uint8_t[]> messageCopy(new (std::nothrow) uint8_t[messageLength ? messageLength : 1]);
+  if(!messageCopy)
+    return false;
+  
+  std::copy_n(message, messageLength, messageCopy.get());
+
+  QueuedTransmission transmission{std::move(messageCopy), messageLength, {0}, messageType, &espnowInstance};
+  std::copy_n(targetBSSID, 6, transmission.targetBSSID);
+  _transmissionQueues[static_cast<uint8_t>(priority)].push_back(std::move(transmission));
+  
+  return true;
+}
+
+void EspnowTransmitter::sendQueuedTransmissions(const TransmissionPriority priority, const ExpiringTimeTracker *estimatedMaxDurationTracker)
+{
+  std::list<QueuedTransmission> &transmissionQueue = _transmissionQueues[static_cast<uint8_t>(priority)];
+  
+  while(true)
+  {
+    // The search restarts from the beginning after each transmission, since callbacks during a transmission may modify the queue.
+    auto transmissionIterator = transmissionQueue.begin();
+    while(transmissionIterator != transmissionQueue.end() && priority == TransmissionPriority::BULK 
+          && !consumePeerTokens(transmissionIterator->targetBSSID, framesRequired(transmissionIterator->messageLength)))
+    {
+      ++transmissionIterator;
+    }
+
+    if(transmissionIterator == transmissionQueue.end())
+      break;
+
+    QueuedTransmission transmission = std::move(*transmissionIterator);
+    transmissionQueue.erase(transmissionIterator);
+    
+    espnowSendToNode(transmission.message.get(), transmission.messageLength, transmission.targetBSSID, transmission.messageType, transmission.espnowInstance);
+
+    if(estimatedMaxDurationTracker && estimatedMaxDurationTracker->expired())
+      break;
+  }
+
+  if(priority == TransmissionPriority::BULK && _peerTransmissionRate)
+    pruneTokenBuckets();
+}
+
+uint32_t EspnowTransmitter::numberOfQueuedTransmissions(const TransmissionPriority priority) { return _transmissionQueues[static_cast<uint8_t>(priority)].size(); }
+
+void EspnowTransmitter::deleteQueuedTransmissionsByOwner(const EspnowMeshBackend *instancePointer)
+{
+  for(std::list<QueuedTransmission> &transmissionQueue : _transmissionQueues)
+    transmissionQueue.remove_if([instancePointer](const QueuedTransmission &transmission){ return transmission.espnowInstance == instancePointer; });
+}
+
+void EspnowTransmitter::clearQueuedTransmissions()
+{
+  for(std::list<QueuedTransmission> &transmissionQueue : _transmissionQueues)
+    transmissionQueue.clear();
+}
+
+void EspnowTransmitter::setMaxQueuedTransmissions(const uint16_t maxQueuedTransmissions) { _maxQueuedTransmissions = maxQueuedTransmissions; }
+uint16_t EspnowTransmitter::getMaxQueuedTransmissions() { return _maxQueuedTransmissions; }
+
+void EspnowTransmitter::setPeerTransmissionRate(const uint32_t framesPerSecond, const uint32_t burstFrames)
+{
+  assert(burstFrames >= getMaxTransmissionsPerMessage());
+  
+  _peerTransmissionRate = framesPerSecond;
+  _peerTransmissionBurst = burstFrames;
+  _peerTokenBuckets.clear();
+}
+uint32_t EspnowTransmitter::getPeerTransmissionRate() { return _peerTransmissionRate; }
+uint32_t EspnowTransmitter::getPeerTransmissionBurst() { return _peerTransmissionBurst; }
+
 MutexTracker EspnowTransmitter::captureEspnowTransmissionMutex()
 {
   // Syntax like this will move the resulting value into its new position (similar to NRVO): https://stackoverflow.com/a/11540204
@@ -206,6 +355,13 @@ MutexTracker EspnowTransmitter::captureEspnowTransmissionMutex(const std::functi
 bool EspnowTransmitter::transmissionInProgress(){return *_espnowTransmissionMutex;}
 
 TransmissionStatusType EspnowTransmitter::espnowSendToNode(const String &message, const uint8_t *targetBSSID, const char messageType, EspnowMeshBackend *espnowInstance)
+{
+  // Copy the message String to make sure it is not modified by a callback during the delay(1) calls of the transmission.
+  const String messageCopy = message;
+  return espnowSendToNode(reinterpret_cast<const uint8_t *>(messageCopy.c_str()), messageCopy.length(), targetBSSID, messageType, espnowInstance);
+}
+
+TransmissionStatusType EspnowTransmitter::espnowSendToNode(const uint8_t *message, const uint32_t messageLength, const uint8_t *targetBSSID, const char messageType, EspnowMeshBackend *espnowInstance)
 {
   using EspnowProtocolInterpreter::synchronizationRequestHeader;
   
@@ -228,13 +384,19 @@ TransmissionStatusType EspnowTransmitter::espnowSendToNode(const String &message
       }
     }
 
-    return espnowSendToNodeUnsynchronized(message, encryptedMac, messageType, EspnowConnectionManager::generateMessageID(encryptedConnection), espnowInstance);
+    return espnowSendToNodeUnsynchronized(message, messageLength, encryptedMac, messageType, EspnowConnectionManager::generateMessageID(encryptedConnection), espnowInstance);
   }
   
-  return espnowSendToNodeUnsynchronized(message, targetBSSID, messageType, EspnowConnectionManager::generateMessageID(encryptedConnection), espnowInstance);
+  return espnowSendToNodeUnsynchronized(message, messageLength, targetBSSID, messageType, EspnowConnectionManager::generateMessageID(encryptedConnection), espnowInstance);
 }
 
 TransmissionStatusType EspnowTransmitter::espnowSendToNodeUnsynchronized(const String message, const uint8_t *targetBSSID, const char messageType, const uint64_t messageID, EspnowMeshBackend *espnowInstance)
+{
+  // The message String is copied into the argument to make sure it is not modified by a callback during the delay(1) calls of the transmission.
+  return espnowSendToNodeUnsynchronized(reinterpret_cast<const uint8_t *>(message.c_str()), message.length(), targetBSSID, messageType, messageID, espnowInstance);
+}
+
+TransmissionStatusType EspnowTransmitter::espnowSendToNodeUnsynchronized(const uint8_t *message, const uint32_t messageLength, const uint8_t *targetBSSID, const char messageType, const uint64_t messageID, EspnowMeshBackend *espnowInstance)
 {
   using namespace EspnowProtocolInterpreter;
 
@@ -245,14 +407,14 @@ TransmissionStatusType EspnowTransmitter::espnowSendToNodeUnsynchronized(const S
     return TransmissionStatusType::TRANSMISSION_FAILED;
   }
 
-  // We copy the message String and bssid array from the arguments in this method to make sure they are
+  // We copy the bssid array from the arguments in this method to make sure it is
   // not modified by a callback during the delay(1) calls further down. 
   // This also makes it possible to get the current _transmissionTargetBSSID outside of the method.
   std::copy_n(targetBSSID, 6, _transmissionTargetBSSID);
   
   EncryptedConnectionLog *encryptedConnection = EspnowConnectionManager::getEncryptedConnection(_transmissionTargetBSSID);
   
-  int32_t transmissionsRequired = ceil((double)message.length() / getMaxMessageBytesPerTransmission());
+  int32_t transmissionsRequired = ceil((double)messageLength / getMaxMessageBytesPerTransmission());
   int32_t transmissionsRemaining = transmissionsRequired > 1 ? transmissionsRequired - 1 : 0;
 
   _transmissionsTotal++;
@@ -295,9 +457,9 @@ TransmissionStatusType EspnowTransmitter::espnowSendToNodeUnsynchronized(const S
     {
       transmissionSize = espnowMetadataSize;
       
-      if(message.length() > 0)
+      if(messageLength > 0)
       {
-        uint32_t remainingLength = message.length() % getMaxMessageBytesPerTransmission();
+        uint32_t remainingLength = messageLength % getMaxMessageBytesPerTransmission();
         transmissionSize += (remainingLength == 0 ? getMaxMessageBytesPerTransmission() : remainingLength);
       }
     }
@@ -327,14 +489,14 @@ TransmissionStatusType EspnowTransmitter::espnowSendToNodeUnsynchronized(const S
     
     int32_t transmissionStartIndex = (transmissionsRequired - transmissionsRemaining - 1) * getMaxMessageBytesPerTransmission();
     
-    std::copy_n(message.begin() + transmissionStartIndex, transmissionSize - espnowMetadataSize, transmission + espnowMetadataSize);
+    std::copy_n(message + transmissionStartIndex, transmissionSize - espnowMetadataSize, transmission + espnowMetadataSize);
 
     if(useEncryptedMessages())
     {      
-      // chacha20Poly1305Encrypt encrypts transmission in place.
+      // Encrypts the transmission array in place, nonce and tag go into the metadata, so the frame needs no extra buffer.
       // We are using the protocol bytes as a key salt.
-      experimental::crypto::ChaCha20Poly1305::encrypt(transmission + espnowMetadataSize, transmissionSize - espnowMetadataSize, getEspnowMessageEncryptionKey(), transmission, 
-                                               protocolBytesSize, transmission + protocolBytesSize, transmission + protocolBytesSize + 12);
+      MeshCryptoInterface::encryptInPlace(transmission + espnowMetadataSize, transmissionSize - espnowMetadataSize, getEspnowMessageEncryptionKey(), transmission, 
+                                          protocolBytesSize, transmission + protocolBytesSize, transmission + protocolBytesSize + 12);
     }
     
     ////// Transmit //////
@@ -413,6 +575,11 @@ TransmissionStatusType EspnowTransmitter::sendRequest(const String &message, con
   return transmissionStatus;
 }
 
+TransmissionStatusType EspnowTransmitter::sendRequest(const uint8_t *message, const uint32_t messageLength, const uint8_t *targetBSSID, EspnowMeshBackend *espnowInstance)
+{
+  return espnowSendToNode(message, messageLength, targetBSSID, 'Q', espnowInstance);
+}
+
 TransmissionStatusType EspnowTransmitter::sendResponse(const String &message, const uint64_t requestID, const uint8_t *targetBSSID, EspnowMeshBackend *espnowInstance)
 {
   EncryptedConnectionLog *encryptedConnection = EspnowConnectionManager::getEncryptedConnection(targetBSSID);
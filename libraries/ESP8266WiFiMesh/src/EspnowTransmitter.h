@@ -26,6 +26,13 @@
 
 class EspnowMeshBackend;
 
+// Transmissions in the CONTROL class are always sent before BULK class transmissions and are not rate limited.
+enum class TransmissionPriority
+{
+  CONTROL = 0,
+  BULK    = 1
+};
+
 class EspnowTransmitter
 {
 
@@ -46,13 +53,18 @@ public:
    */
   // Send a message to the node having targetBSSID as mac, changing targetBSSID to the mac of the encrypted connection if it exists and ensuring such an encrypted connection is synchronized.
   static TransmissionStatusType espnowSendToNode(const String &message, const uint8_t *targetBSSID, const char messageType, EspnowMeshBackend *espnowInstance = nullptr);
+  // Binary version. The message array must not be modified until the method returns.
+  static TransmissionStatusType espnowSendToNode(const uint8_t *message, const uint32_t messageLength, const uint8_t *targetBSSID, const char messageType, EspnowMeshBackend *espnowInstance = nullptr);
   // Send a message using exactly the arguments given, without consideration for any encrypted connections.
   static TransmissionStatusType espnowSendToNodeUnsynchronized(const String message, const uint8_t *targetBSSID, const char messageType, const uint64_t messageID, EspnowMeshBackend *espnowInstance = nullptr);
+  // Binary version. The message array must not be modified until the method returns.
+  static TransmissionStatusType espnowSendToNodeUnsynchronized(const uint8_t *message, const uint32_t messageLength, const uint8_t *targetBSSID, const char messageType, const uint64_t messageID, EspnowMeshBackend *espnowInstance = nullptr);
 
   // Send a PeerRequestConfirmation using exactly the arguments given, without consideration for any encrypted connections.
   static TransmissionStatusType espnowSendPeerRequestConfirmationsUnsynchronized(const String message, const uint8_t *targetBSSID, const char messageType, EspnowMeshBackend *espnowInstance = nullptr);
   
   TransmissionStatusType sendRequest(const String &message, const uint8_t *targetBSSID, EspnowMeshBackend *espnowInstance);
+  TransmissionStatusType sendRequest(const uint8_t *message, const uint32_t messageLength, const uint8_t *targetBSSID, EspnowMeshBackend *espnowInstance);
   TransmissionStatusType sendResponse(const String &message, const uint64_t requestID, const uint8_t *targetBSSID, EspnowMeshBackend *espnowInstance);
   
   static void setUseEncryptedMessages(const bool useEncryptedMessages);
@@ -82,6 +94,40 @@ public:
    */
   static void sendEspnowResponses(const ExpiringTimeTracker *estimatedMaxDurationTracker = nullptr);
 
+  /**
+   * Add a 'Q' or 'B' type message to the transmit queue of the given priority class. The message is copied.
+   * Queued transmissions are sent by sendQueuedTransmissions, one message at a time, in order within each class.
+   * 
+   * @return True if the message was queued. False if the queue is full or there was not enough heap to store the message.
+   */
+  static bool queueTransmission(const uint8_t *message, const uint32_t messageLength, const uint8_t *targetBSSID, const char messageType, 
+                                EspnowMeshBackend &espnowInstance, const TransmissionPriority priority);
+
+  /**
+   * Send the queued transmissions of the given priority class. BULK transmissions to peers without enough tokens in their
+   * rate limit bucket are left in the queue, so they do not hold back the transmissions to other peers.
+   * Failed transmissions are removed from the queue and are counted by getTransmissionFailRate().
+   * 
+   * @param estimatedMaxDurationTracker See sendEspnowResponses.
+   */
+  static void sendQueuedTransmissions(const TransmissionPriority priority, const ExpiringTimeTracker *estimatedMaxDurationTracker = nullptr);
+  static uint32_t numberOfQueuedTransmissions(const TransmissionPriority priority);
+  static void deleteQueuedTransmissionsByOwner(const EspnowMeshBackend *instancePointer);
+  static void clearQueuedTransmissions();
+  
+  static void setMaxQueuedTransmissions(const uint16_t maxQueuedTransmissions);
+  static uint16_t getMaxQueuedTransmissions();
+
+  /**
+   * Limit the rate of queued BULK transmissions to each peer with a token bucket. Each ESP-NOW frame of a message uses one token.
+   * 
+   * @param framesPerSecond The number of tokens added to the bucket of each peer per second. 0 disables rate limiting, which is the default.
+   * @param burstFrames The bucket size, i.e. the number of frames that can be sent to a peer in a burst after an idle period. Must be at least getMaxTransmissionsPerMessage().
+   */
+  static void setPeerTransmissionRate(const uint32_t framesPerSecond, const uint32_t burstFrames);
+  static uint32_t getPeerTransmissionRate();
+  static uint32_t getPeerTransmissionBurst();
+
   /** 
    * Will be captured if a transmission initiated by a public method is in progress.
    */
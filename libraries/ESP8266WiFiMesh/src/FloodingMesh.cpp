@@ -22,6 +22,7 @@
  * THE SOFTWARE.
  */
 
+#include <Schedule.h>
 #include "FloodingMesh.h"
 #include "TypeConversionFunctions.h"
 #include "JsonTranslator.h"
@@ -35,6 +36,9 @@ namespace
   constexpr uint8_t MESSAGE_COMPLETE = 255;
 
   char _metadataDelimiter = 23; // Defaults to 23 = End-of-Transmission-Block (ETB) control character in ASCII
+
+  FloodingMesh *_resumeForwardingInstance = nullptr; // Only compared, never dereferenced, so it does not matter if the instance is destroyed.
+  uint32_t _meshMaintenanceTaskID = 0; // Incremented to stop the current maintenance task.
 }
 
 std::set<FloodingMesh *> FloodingMesh::availableFloodingMeshes = {};
@@ -132,6 +136,11 @@ void FloodingMesh::performMeshInstanceMaintenance()
 {
   EspnowMeshBackend::performEspnowMaintenance(); 
   
+  forwardBacklog(nullptr);
+}
+
+void FloodingMesh::forwardBacklog(const ExpiringTimeTracker *estimatedMaxDurationTracker)
+{
   for(std::list<std::pair<String, bool>>::iterator backlogIterator = getForwardingBacklog().begin();  backlogIterator != getForwardingBacklog().end(); )
   {
     std::pair<String, bool> &messageData = *backlogIterator;
@@ -147,11 +156,65 @@ void FloodingMesh::performMeshInstanceMaintenance()
     }
 
     backlogIterator = getForwardingBacklog().erase(backlogIterator);
-    
-    EspnowMeshBackend::performEspnowMaintenance(); // It is best to performEspnowMaintenance frequently to keep the Espnow backend responsive. Especially if each encryptedBroadcast takes a lot of time.
+
+    if(estimatedMaxDurationTracker)
+    {
+      if(estimatedMaxDurationTracker->expired())
+        return;
+    }
+    else
+    {
+      EspnowMeshBackend::performEspnowMaintenance(); // It is best to performEspnowMaintenance frequently to keep the Espnow backend responsive. Especially if each encryptedBroadcast takes a lot of time.
+    }
   }
 }
 
+void FloodingMesh::performMeshMaintenanceSlice(const uint32_t sliceDurationMs)
+{
+  assert(sliceDurationMs >= 1);
+  
+  ExpiringTimeTracker sliceTracker(sliceDurationMs);
+
+  EspnowMeshBackend::performEspnowMaintenanceSlice(std::max(sliceDurationMs / 2, (uint32_t)1));
+
+  if(EspnowTransmitter::transmissionInProgress() || sliceTracker.expired())
+    return;
+  
+  // Start with the instance that ran out of time in the previous slice, so a long backlog in one instance cannot starve the others.
+  auto meshIterator = availableFloodingMeshes.lower_bound(_resumeForwardingInstance);
+  
+  for(uint32_t visitedInstances = 0; visitedInstances < availableFloodingMeshes.size(); ++visitedInstances, ++meshIterator)
+  {
+    if(meshIterator == availableFloodingMeshes.end())
+      meshIterator = availableFloodingMeshes.begin();
+
+    FloodingMesh *meshInstance = *meshIterator;
+    meshInstance->forwardBacklog(&sliceTracker);
+
+    if(sliceTracker.expired())
+    {
+      _resumeForwardingInstance = meshInstance;
+      return;
+    }
+  }
+}
+
+void FloodingMesh::startMeshMaintenanceTask(const uint32_t sliceDurationMs, const uint32_t sliceIntervalMs)
+{
+  const uint32_t taskID = ++_meshMaintenanceTaskID;
+  
+  schedule_recurrent_function_us([taskID, sliceDurationMs]()
+  {
+    if(taskID != _meshMaintenanceTaskID)
+      return false; // Task stopped or replaced
+    
+    performMeshMaintenanceSlice(sliceDurationMs);
+    return true;
+  }, sliceIntervalMs * 1000);
+}
+
+void FloodingMesh::stopMeshMaintenanceTask() { ++_meshMaintenanceTaskID; }
+
 String FloodingMesh::serializeMeshState() const
 {
   String connectionState = getEspnowMeshBackendConst().serializeUnencryptedConnection();
@@ -195,6 +258,28 @@ void FloodingMesh::broadcast(const String &message)
   broadcastKernel(targetMeshName + String(metadataDelimiter()) + messageID + String(metadataDelimiter()) + message);
 }
 
+void FloodingMesh::broadcast(const uint8_t *message, const uint32_t messageLength)
+{
+  assert(messageLength <= maxUnencryptedMessageLength());
+  
+  String messageID = generateMessageID();
+
+  // Remove getEspnowMeshBackend().getMeshName() from the metadata below to broadcast to all ESP-NOW nodes regardless of MeshName.
+  String targetMeshName = getEspnowMeshBackend().getMeshName();
+
+  String totalMessage;
+  if(!totalMessage.reserve(targetMeshName.length() + messageID.length() + 2 + messageLength))
+    return;
+
+  totalMessage += targetMeshName;
+  totalMessage += metadataDelimiter();
+  totalMessage += messageID;
+  totalMessage += metadataDelimiter();
+  totalMessage.concat(reinterpret_cast<const char *>(message), messageLength);
+
+  broadcastKernel(totalMessage);
+}
+
 void FloodingMesh::broadcastKernel(const String &message)
 {
   getEspnowMeshBackend().broadcast(message);
@@ -224,7 +309,6 @@ void FloodingMesh::encryptedBroadcastKernel(const String &message)
 void FloodingMesh::clearMessageLogs()
 {
   _messageIDs.clear();
-  std::queue<messageQueueElementType>().swap(_messageIdOrder);
 }
 
 void FloodingMesh::clearForwardingBacklog()
@@ -265,9 +349,9 @@ uint32_t FloodingMesh::maxEncryptedMessageLength() const
 void FloodingMesh::setMessageLogSize(const uint16_t messageLogSize) 
 { 
   assert(messageLogSize >= 1);
-  _messageLogSize = messageLogSize; 
+  _messageIDs.setCapacity(messageLogSize); 
 }
-uint16_t FloodingMesh::messageLogSize() const { return _messageLogSize; }
+uint16_t FloodingMesh::messageLogSize() const { return _messageIDs.capacity(); }
 
 void FloodingMesh::setMetadataDelimiter(const char metadataDelimiter) 
 { 
@@ -300,12 +384,12 @@ bool FloodingMesh::insertPreliminaryMessageID(const uint64_t messageID)
   if(messageID >> 16 == TypeCast::macToUint64(WiFi.softAPmacAddress(apMacArray)))
     return false; // The node should not receive its own messages.
   
-  auto insertionResult = _messageIDs.emplace(messageID, 0); // Returns std::pair<iterator,bool>
+  auto insertionResult = _messageIDs.emplace(messageID, 0); // Returns std::pair<uint8_t *, bool>, the oldest messageID is dropped if the log is full.
 
   if(insertionResult.second) // Insertion succeeded.
-    updateMessageQueue(insertionResult.first);
-  else if(insertionResult.first->second < getBroadcastReceptionRedundancy()) // messageID exists but not with desired redundancy
-    insertionResult.first->second++;
+    return true;
+  else if(*insertionResult.first < getBroadcastReceptionRedundancy()) // messageID exists but not with desired redundancy
+    ++*insertionResult.first;
   else
     return false; // messageID already existed in _messageIDs with desired redundancy
 
@@ -318,31 +402,18 @@ bool FloodingMesh::insertCompletedMessageID(const uint64_t messageID)
   if(messageID >> 16 == TypeCast::macToUint64(WiFi.softAPmacAddress(apMacArray)))
     return false; // The node should not receive its own messages.
   
-  auto insertionResult = _messageIDs.emplace(messageID, MESSAGE_COMPLETE); // Returns std::pair<iterator,bool>
+  auto insertionResult = _messageIDs.emplace(messageID, MESSAGE_COMPLETE); // Returns std::pair<uint8_t *, bool>, the oldest messageID is dropped if the log is full.
 
   if(insertionResult.second) // Insertion succeeded.
-    updateMessageQueue(insertionResult.first);
-  else if(insertionResult.first->second < MESSAGE_COMPLETE) // messageID exists but is not complete
-    insertionResult.first->second = MESSAGE_COMPLETE;
+    return true;
+  else if(*insertionResult.first < MESSAGE_COMPLETE) // messageID exists but is not complete
+    *insertionResult.first = MESSAGE_COMPLETE;
   else
     return false; // messageID already existed in _messageIDs and is complete
 
   return true;
 }
 
-void FloodingMesh::updateMessageQueue(const messageQueueElementType messageIterator)
-{
-  _messageIdOrder.emplace(messageIterator);
-  
-  if(_messageIDs.size() > messageLogSize())
-  {
-    _messageIDs.erase(_messageIdOrder.front());
-    _messageIdOrder.pop();
-    assert(_messageIDs.size() == messageLogSize()); // If this is false we either have too many elements in messageIDs or we deleted too many elements.
-    assert(_messageIDs.size() == _messageIdOrder.size()); // The containers should always be in sync
-  }
-}
-
 void FloodingMesh::restoreDefaultRequestHandler()
 {
   getEspnowMeshBackend().setRequestHandler([this](const String &request, MeshBackendBase &meshInstance){ return _defaultRequestHandler(request, meshInstance); });
@@ -392,8 +463,8 @@ String FloodingMesh::_defaultRequestHandler(const String &request, MeshBackendBa
 {
   (void)meshInstance; // This is useful to remove a "unused parameter" compiler warning. Does nothing else.
   
-  String broadcastTarget;
-  String remainingRequest = request;
+  const char *requestBuffer = request.c_str();
+  uint32_t broadcastTargetLength = 0;
   
   if(request.charAt(0) == metadataDelimiter())
   {
@@ -402,30 +473,33 @@ String FloodingMesh::_defaultRequestHandler(const String &request, MeshBackendBa
     if(broadcastTargetEndIndex == -1)
       return emptyString; // metadataDelimiter not found
     
-    broadcastTarget = request.substring(1, broadcastTargetEndIndex + 1); // Include delimiter
-    remainingRequest.remove(0, broadcastTargetEndIndex + 1);
+    broadcastTargetLength = broadcastTargetEndIndex + 1; // Include delimiters
   }
   
-  int32_t messageIDEndIndex = remainingRequest.indexOf(metadataDelimiter());
+  int32_t messageIDEndIndex = request.indexOf(metadataDelimiter(), broadcastTargetLength);
 
   if(messageIDEndIndex == -1)
     return emptyString; // metadataDelimiter not found
 
-  uint64_t messageID = TypeCast::stringToUint64(remainingRequest.substring(0, messageIDEndIndex));
+  uint64_t messageID = TypeCast::stringToUint64(requestBuffer + broadcastTargetLength, messageIDEndIndex - broadcastTargetLength);
 
   if(insertCompletedMessageID(messageID))
   {
     uint8_t originMacArray[6] = { 0 };
     setOriginMac(TypeCast::uint64ToMac(messageID >> 16, originMacArray)); // messageID consists of MAC + 16 bit counter
   
-    String message = remainingRequest;
-    message.remove(0, messageIDEndIndex + 1); // This approach avoids the null value removal of substring()
+    String message;
+    message.concat(requestBuffer + messageIDEndIndex + 1, request.length() - (messageIDEndIndex + 1)); // This approach avoids the null value removal of substring()
     
     if(getMessageHandler()(message, *this))
     {
-      message = broadcastTarget + remainingRequest.substring(0, messageIDEndIndex + 1) + message;
-      assert(message.length() <= _espnowBackend.getMaxMessageLength());
-      getForwardingBacklog().emplace_back(message, getEspnowMeshBackend().receivedEncryptedTransmission());
+      String forwardedMessage;
+      forwardedMessage.reserve(messageIDEndIndex + 1 + message.length());
+      forwardedMessage.concat(requestBuffer + 1, broadcastTargetLength ? broadcastTargetLength - 1 : 0); // Drop the leading delimiter added by the broadcastFilter
+      forwardedMessage.concat(requestBuffer + broadcastTargetLength, messageIDEndIndex + 1 - broadcastTargetLength);
+      forwardedMessage.concat(message.c_str(), message.length());
+      assert(forwardedMessage.length() <= _espnowBackend.getMaxMessageLength());
+      getForwardingBacklog().emplace_back(forwardedMessage, getEspnowMeshBackend().receivedEncryptedTransmission());
     }
   }
   
@@ -508,11 +582,12 @@ bool FloodingMesh::_defaultBroadcastFilter(String &firstTransmission, EspnowMesh
   if(metadataEndIndex == -1)
     return false; // metadataDelimiter not found
 
-  String targetMeshName = firstTransmission.substring(0, metadataEndIndex);
-  
-  if(!targetMeshName.isEmpty() && meshInstance.getMeshName() != targetMeshName)
+  if(metadataEndIndex > 0) // Compare in place, to avoid a substring allocation for every received broadcast.
   {
-    return false; // Broadcast is for another mesh network
+    const String &meshName = meshInstance.getMeshName();
+    
+    if((int32_t)meshName.length() != metadataEndIndex || memcmp(meshName.c_str(), firstTransmission.c_str(), metadataEndIndex) != 0)
+      return false; // Broadcast is for another mesh network
   }
   
   int32_t messageIDEndIndex = firstTransmission.indexOf(metadataDelimiter(), metadataEndIndex + 1);
@@ -520,7 +595,7 @@ bool FloodingMesh::_defaultBroadcastFilter(String &firstTransmission, EspnowMesh
   if(messageIDEndIndex == -1)
     return false; // metadataDelimiter not found
 
-  uint64_t messageID = TypeCast::stringToUint64(firstTransmission.substring(metadataEndIndex + 1, messageIDEndIndex));
+  uint64_t messageID = TypeCast::stringToUint64(firstTransmission.c_str() + metadataEndIndex + 1, messageIDEndIndex - (metadataEndIndex + 1));
 
   if(insertPreliminaryMessageID(messageID))
   {
@@ -26,8 +26,8 @@
 #define __FLOODINGMESH_H__
 
 #include "EspnowMeshBackend.h"
+#include "MessageIDLog.h"
 #include <set>
-#include <queue>
 
 /**
  * An alternative to standard delay(). Will continuously call performMeshMaintenance() during the waiting time, so that the FloodingMesh node remains responsive.
@@ -146,6 +146,24 @@ public:
    */
   void performMeshInstanceMaintenance();
 
+  /**
+   * Perform a part of the maintenance of all available Flooding Mesh instances, resuming where the previous slice stopped.
+   * Half of the slice is used for EspnowMeshBackend::performEspnowMaintenanceSlice(), the rest for forwarding received broadcasts, one at a time.
+   * A single forwarded broadcast is never interrupted, and encrypted broadcasts include a WiFi scan, so a slice may still overshoot.
+   * 
+   * Does nothing if a transmission is in progress, so it is safe to call from a recurrent scheduled function.
+   * 
+   * @param sliceDurationMs The maximum duration of the slice, in milliseconds. Must be at least 1.
+   */
+  static void performMeshMaintenanceSlice(const uint32_t sliceDurationMs);
+
+  /**
+   * Run performMeshMaintenanceSlice(sliceDurationMs) every sliceIntervalMs from a recurrent scheduled function, instead of calling performMeshMaintenance() from the loop.
+   * Starting the task again replaces the previous task. See also EspnowMeshBackend::startEspnowMaintenanceTask().
+   */
+  static void startMeshMaintenanceTask(const uint32_t sliceDurationMs = 2, const uint32_t sliceIntervalMs = 10);
+  static void stopMeshMaintenanceTask();
+
   /**
    * Serialize the current mesh node state. Useful to save a state before the node goes to sleep.
    * Note that this saves the current state only, so if a broadcast is made after this, the stored state is invalid.
@@ -166,6 +184,15 @@ public:
    */
   void broadcast(const String &message);
 
+  /**
+   * Binary version of broadcast. The bytes are sent as is, so binary data does not have to be encoded as text first.
+   * Receivers get the message in their messageHandler as a String holding the same bytes (which may include null characters).
+   * 
+   * @param message The message bytes. Maximum message length is given by maxUnencryptedMessageLength().
+   * @param messageLength The number of bytes in message.
+   */
+  void broadcast(const uint8_t *message, const uint32_t messageLength);
+
   /**
    * Set the maximum number of redundant copies that will be received of every broadcast. (from different senders)
    * A greater number increases the likelihood that at least one of the copies is received successfully, but will also use more RAM.
@@ -230,7 +257,7 @@ public:
  * The number of received messageID:s that will be stored by the node. Used to remember which messages have been received. 
  * Setting this too low will cause the same message to be received many times.
  * Setting this too high will cause the node to run out of RAM.
- * In practice, setting this value to more than 1337 is probably a bad idea since the node will run out of RAM quickly and crash as a result.
+ * Lookups take constant time regardless of log size, but each entry of the log uses up to 17 bytes of RAM, allocated when the first message is received.
  * 
  * Defaults to 100.
  * 
@@ -286,8 +313,6 @@ public:
 
 protected:
 
-  using messageQueueElementType = std::map<uint64_t, uint8_t>::iterator;
-
   static std::set<FloodingMesh *> availableFloodingMeshes;
   
   String generateMessageID();
@@ -296,9 +321,16 @@ protected:
 
   void encryptedBroadcastKernel(const String &message);
 
+  /**
+   * Forward the messages in the forwarding backlog.
+   * 
+   * @param estimatedMaxDurationTracker If not nullptr, forwarding stops once it has expired. If nullptr, all messages are forwarded and 
+   *                                    EspnowMeshBackend::performEspnowMaintenance() is called after each one.
+   */
+  void forwardBacklog(const ExpiringTimeTracker *estimatedMaxDurationTracker);
+
   bool insertPreliminaryMessageID(const uint64_t messageID);
   bool insertCompletedMessageID(const uint64_t messageID);
-  void updateMessageQueue(const messageQueueElementType messageIterator);
   
   void loadMeshState(const String &serializedMeshState);
 
@@ -319,8 +351,7 @@ private:
 
   messageHandlerType _messageHandler;
 
-  std::map<uint64_t, uint8_t> _messageIDs = {};
-  std::queue<messageQueueElementType> _messageIdOrder = {};
+  MessageIDLog _messageIDs{100};
   std::list<std::pair<String, bool>> _forwardingBacklog = {};
 
   String _macIgnoreList;
@@ -335,7 +366,6 @@ private:
   uint8_t _originMac[6] = {0};
   
   uint16_t _messageCount = 0;
-  uint16_t _messageLogSize = 100;
 
   uint8_t _broadcastReceptionRedundancy = 2;
 };
@@ -29,19 +29,112 @@
 namespace
 {
   namespace TypeCast = MeshTypeConversionFunctions;
-  
-  bool getMac(const String &jsonString, const String &valueIdentifier, uint8_t *resultArray)
+
+  // Index where the value of "identifier": starts, or -1. identifier may be stored in PROGMEM. No temporary String is created.
+  int32_t findValueStart(const String &jsonString, PGM_P identifier, const uint32_t identifierLength, const int32_t searchStartIndex)
   {
-    String jsonValue;
-    bool decoded = JsonTranslator::decode(jsonString, valueIdentifier, jsonValue);
+    const char *json = jsonString.c_str();
+    const uint32_t jsonLength = jsonString.length();
+    
+    for(uint32_t index = searchStartIndex; index + identifierLength + 3 <= jsonLength; ++index)
+    {
+      const char *quote = (const char *)memchr(json + index, '"', jsonLength - index - identifierLength - 2);
+      if(!quote)
+        break;
+
+      index = quote - json;
+      if(json[index + identifierLength + 1] == '"' && json[index + identifierLength + 2] == ':' && memcmp_P(json + index + 1, identifier, identifierLength) == 0)
+        return index + identifierLength + 3; // Do not include valueIdentifier and associated characters
+    }
 
-    if(jsonValue.length() != 12)
-      decoded = false; // Mac String is always 12 characters long
+    return -1;
+  }
+
+  /*
+   * Locate the value of identifier within jsonString, without copying it.
+   * valueStart and valueLength describe the contents of a JSON string (without the " characters) or an entire JSON object (including the {} characters).
+   */
+  bool findValue(const String &jsonString, PGM_P identifier, const uint32_t identifierLength, uint32_t &valueStart, uint32_t &valueLength)
+  {
+    int32_t startIndex = findValueStart(jsonString, identifier, identifierLength, 0);
+    if(startIndex < 0)
+      return false;
     
-    if(decoded)
-      TypeCast::stringToMac(jsonValue, resultArray);
+    int32_t endIndex = JsonTranslator::getEndIndex(jsonString, startIndex);
+    if(endIndex < 0)
+      return false;
+
+    if(jsonString[startIndex] == '"')
+      ++startIndex; // Should not include starting "
+    else if(jsonString[startIndex] == '{')
+      ++endIndex; // Should include ending }
+    else
+      assert(false && F("Illegal JSON starting character!"));
+
+    valueStart = startIndex;
+    valueLength = endIndex - startIndex;
+    return true;
+  }
+
+  bool decodeString(const String &jsonString, PGM_P identifier, String &value)
+  {
+    uint32_t valueStart = 0;
+    uint32_t valueLength = 0;
+    if(!findValue(jsonString, identifier, strlen_P(identifier), valueStart, valueLength))
+      return false;
+
+    value = emptyString;
+    value.concat(jsonString.c_str() + valueStart, valueLength);
+    return true;
+  }
+
+  bool decodeUint32(const String &jsonString, PGM_P identifier, const uint32_t identifierLength, uint32_t &value)
+  {
+    uint32_t valueStart = 0;
+    uint32_t valueLength = 0;
+    if(!findValue(jsonString, identifier, identifierLength, valueStart, valueLength))
+      return false;
+    
+    value = strtoul(jsonString.c_str() + valueStart, nullptr, 0); // strtoul stops reading input when an invalid character, like the ending ", is discovered.
+    return true;
+  }
+
+  bool decodeUint64(const String &jsonString, PGM_P identifier, const uint32_t identifierLength, uint64_t &value, const uint8_t radix)
+  {
+    uint32_t valueStart = 0;
+    uint32_t valueLength = 0;
+    if(!findValue(jsonString, identifier, identifierLength, valueStart, valueLength))
+      return false;
+    
+    value = TypeCast::stringToUint64(jsonString.c_str() + valueStart, valueLength, radix);
+    return true;
+  }
   
-    return decoded;
+  bool getMac(const String &jsonString, PGM_P identifier, uint8_t *resultArray)
+  {
+    uint32_t valueStart = 0;
+    uint32_t valueLength = 0;
+    if(!findValue(jsonString, identifier, strlen_P(identifier), valueStart, valueLength) || valueLength != 12)
+      return false; // Mac String is always 12 characters long
+    
+    TypeCast::uint64ToMac(TypeCast::stringToUint64(jsonString.c_str() + valueStart, valueLength), resultArray);
+    return true;
+  }
+
+  void appendQuoted(String &result, const String &element)
+  {
+    result += '"';
+    result += element;
+    result += '"';
+  }
+
+  uint32_t encodedLength(std::initializer_list<String> identifiersAndValues)
+  {
+    uint32_t length = 1; // The final } replaces the last ,
+    for(const String &element : identifiersAndValues)
+      length += element.length() + 3; // Quotes and : or ,
+
+    return length;
   }
 }
 
@@ -49,12 +142,7 @@ namespace JsonTranslator
 {
   int32_t getStartIndex(const String &jsonString, const String &valueIdentifier, const int32_t searchStartIndex)
   {
-    int32_t startIndex = jsonString.indexOf(String('"') + valueIdentifier + F("\":"), searchStartIndex);
-    if(startIndex < 0)
-      return startIndex;
-  
-    startIndex += valueIdentifier.length() + 3; // Do not include valueIdentifier and associated characters
-    return startIndex;
+    return findValueStart(jsonString, valueIdentifier.c_str(), valueIdentifier.length(), searchStartIndex);
   }
   
   int32_t getEndIndex(const String &jsonString, const int32_t searchStartIndex)
@@ -97,16 +185,18 @@ namespace JsonTranslator
   {
     assert(identifiersAndValues.size() % 2 == 0); // List must consist of identifer-value pairs.
     
-    String result = String('{');
+    String result;
+    result.reserve(encodedLength(identifiersAndValues)); // Build the result in a single allocation
+    result += '{';
 
     bool isIdentifier = true;
-    for(String element : identifiersAndValues)
+    for(const String &element : identifiersAndValues)
     {
       bool isObject = !isIdentifier && element[0] == '{';
       if(isObject)
         result += element;
       else
-        result += String('"') + element + String('"');
+        appendQuoted(result, element);
       
       if(isIdentifier)
         result += ':';
@@ -125,15 +215,23 @@ namespace JsonTranslator
   {
     assert(identifiersAndValues.size() % 2 == 0); // List must consist of identifer-value pairs.
     
-    String result = String('{');
+    String result;
+    result.reserve(encodedLength(identifiersAndValues));
+    result += '{';
 
     bool isIdentifier = true;
-    for(String element : identifiersAndValues)
+    for(const String &element : identifiersAndValues)
     {
       if(isIdentifier)
-        result += String('"') + element + String('"') + ':';
+      {
+        appendQuoted(result, element);
+        result += ':';
+      }
       else
-        result += element + ',';
+      {
+        result += element;
+        result += ',';
+      }
 
       isIdentifier = !isIdentifier;
     }
@@ -145,112 +243,92 @@ namespace JsonTranslator
 
   bool decode(const String &jsonString, const String &valueIdentifier, String &value)
   {
-    int32_t startIndex = getStartIndex(jsonString, valueIdentifier);
-    if(startIndex < 0)
+    uint32_t valueStart = 0;
+    uint32_t valueLength = 0;
+    if(!findValue(jsonString, valueIdentifier.c_str(), valueIdentifier.length(), valueStart, valueLength))
       return false;
-    
-    int32_t endIndex = getEndIndex(jsonString, startIndex);
-    if(endIndex < 0)
-      return false;
-
-    if(jsonString[startIndex] == '"')
-      ++startIndex; // Should not include starting "
-    else if(jsonString[startIndex] == '{')
-      ++endIndex; // Should include ending }
-    else
-      assert(false && F("Illegal JSON starting character!"));
       
-    value = jsonString.substring(startIndex, endIndex);
+    value = jsonString.substring(valueStart, valueStart + valueLength);
     return true;
   }
 
   bool decode(const String &jsonString, const String &valueIdentifier, uint32_t &value)
   {
-    String jsonValue;
-    bool decoded = decode(jsonString, valueIdentifier, jsonValue);
-    
-    if(decoded)
-      value = strtoul(jsonValue.c_str(), nullptr, 0); // strtoul stops reading input when an invalid character is discovered.
-  
-    return decoded;
+    return decodeUint32(jsonString, valueIdentifier.c_str(), valueIdentifier.length(), value);
   }
 
   bool decodeRadix(const String &jsonString, const String &valueIdentifier, uint64_t &value, const uint8_t radix)
   {
-    String jsonValue;
-    bool decoded = decode(jsonString, valueIdentifier, jsonValue);
-    
-    if(decoded)
-      value = TypeCast::stringToUint64(jsonValue, radix);
-  
-    return decoded;
+    return decodeUint64(jsonString, valueIdentifier.c_str(), valueIdentifier.length(), value, radix);
   }
 
+  // The getters below pass the PROGMEM identifiers directly, so no String is created to hold them.
+  
   bool getConnectionState(const String &jsonString, String &result)
   {
-    return decode(jsonString, FPSTR(jsonConnectionState), result);
+    return decodeString(jsonString, jsonConnectionState, result);
   }
   
   bool getPassword(const String &jsonString, String &result)
   {
-    return decode(jsonString, FPSTR(jsonPassword), result);
+    return decodeString(jsonString, jsonPassword, result);
   }
   
   bool getOwnSessionKey(const String &jsonString, uint64_t &result)
   {
-    return decodeRadix(jsonString, FPSTR(jsonOwnSessionKey), result);
+    return decodeUint64(jsonString, jsonOwnSessionKey, strlen_P(jsonOwnSessionKey), result, 16);
   }
   
   bool getPeerSessionKey(const String &jsonString, uint64_t &result)
   {
-    return decodeRadix(jsonString, FPSTR(jsonPeerSessionKey), result);
+    return decodeUint64(jsonString, jsonPeerSessionKey, strlen_P(jsonPeerSessionKey), result, 16);
   }
   
   bool getPeerStaMac(const String &jsonString, uint8_t *resultArray)
   {  
-    return getMac(jsonString, FPSTR(jsonPeerStaMac), resultArray);
+    return getMac(jsonString, jsonPeerStaMac, resultArray);
   }
   
   bool getPeerApMac(const String &jsonString, uint8_t *resultArray)
   {
-    return getMac(jsonString, FPSTR(jsonPeerApMac), resultArray);
+    return getMac(jsonString, jsonPeerApMac, resultArray);
   }
   
   bool getDuration(const String &jsonString, uint32_t &result)
   {  
-    return decode(jsonString, FPSTR(jsonDuration), result);
+    return decodeUint32(jsonString, jsonDuration, strlen_P(jsonDuration), result);
   }
   
   bool getNonce(const String &jsonString, String &result)
   {
-    return decode(jsonString, FPSTR(jsonNonce), result);
+    return decodeString(jsonString, jsonNonce, result);
   }
 
   bool getHmac(const String &jsonString, String &result)
   {
-    return decode(jsonString, FPSTR(jsonHmac), result);
+    return decodeString(jsonString, jsonHmac, result);
   }
 
   bool getDesync(const String &jsonString, bool &result)
   {  
-    String jsonValue;
-    bool decoded = decode(jsonString, FPSTR(jsonDesync), jsonValue);
+    uint32_t longResult = 0;
+    bool decoded = decodeUint32(jsonString, jsonDesync, strlen_P(jsonDesync), longResult);
     
     if(decoded)
-      result = bool(strtoul(jsonValue.c_str(), nullptr, 0)); // strtoul stops reading input when an invalid character is discovered.
+      result = bool(longResult);
   
     return decoded;
   }
 
   bool getUnsynchronizedMessageID(const String &jsonString, uint32_t &result)
   {
-    return decode(jsonString, FPSTR(jsonUnsynchronizedMessageID), result);
+    return decodeUint32(jsonString, jsonUnsynchronizedMessageID, strlen_P(jsonUnsynchronizedMessageID), result);
   }
 
   bool getMeshMessageCount(const String &jsonString, uint16_t &result)
   {  
     uint32_t longResult = 0;
-    bool decoded = decode(jsonString, FPSTR(jsonMeshMessageCount), longResult);
+    bool decoded = decodeUint32(jsonString, jsonMeshMessageCount, strlen_P(jsonMeshMessageCount), longResult);
 
     if(longResult > 65535) // Must fit within uint16_t
       decoded = false;
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2019 Anders Löfgren
+ *
+ * License (MIT license):
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "MacIndex.h"
+#include <algorithm>
+
+MacIndex::MacIndex(const uint16_t peerLimit, const uint8_t bitsPerPeer) : _bitsPerPeer(bitsPerPeer)
+{
+  setPeerLimit(peerLimit);
+}
+
+void MacIndex::setPeerLimit(const uint16_t peerLimit)
+{
+  _peerLimit = peerLimit;
+
+  // A power of two, so bits are picked by masking
+  uint32_t bitCount = 32;
+  while(bitCount < (uint32_t)peerLimit * _bitsPerPeer)
+    bitCount <<= 1;
+
+  _bits.assign(bitCount / 32, 0);
+  _bits.shrink_to_fit();
+  _bitMask = bitCount - 1;
+}
+
+uint16_t MacIndex::peerLimit() const
+{
+  return _peerLimit;
+}
+
+uint32_t MacIndex::bitIndex(const uint64_t mac, const uint64_t messageID) const
+{
+  // splitmix64 finalizer, so every bit of the MAC and the message ID counts
+  uint64_t key = mac ^ (messageID * 0x9E3779B97F4A7C15ULL);
+  key = (key ^ (key >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  key = (key ^ (key >> 27)) * 0x94D049BB133111EBULL;
+  key ^= key >> 31;
+  
+  return static_cast<uint32_t>(key) & _bitMask;
+}
+
+void MacIndex::add(const uint64_t mac, const uint64_t messageID)
+{
+  uint32_t index = bitIndex(mac, messageID);
+  _bits[index / 32] |= 1UL << (index % 32);
+}
+
+bool MacIndex::mayContain(const uint64_t mac, const uint64_t messageID) const
+{
+  uint32_t index = bitIndex(mac, messageID);
+  return _bits[index / 32] & (1UL << (index % 32));
+}
+
+void MacIndex::clear()
+{
+  std::fill(_bits.begin(), _bits.end(), 0);
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2019 Anders Löfgren
+ *
+ * License (MIT license):
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef __MACINDEX_H__
+#define __MACINDEX_H__
+
+#include <stdint.h>
+#include <vector>
+
+/**
+ * Compact index telling whether a log may hold an entry for a MAC (and message ID), so the log need not be searched when it cannot.
+ * Each key is hashed to one bit, in memory allocated up front for a given number of peers. 
+ * A clear bit means there is no such entry. A set bit may also come from another key or from an entry since deleted, 
+ * in which case the log is searched as before. Keys are only ever added; the index is rebuilt when its log is pruned.
+ */
+class MacIndex {
+
+public:
+
+  MacIndex(const uint16_t peerLimit, const uint8_t bitsPerPeer);
+
+  /**
+   * Reallocate the index for peerLimit peers. The index is cleared and must be rebuilt.
+   */
+  void setPeerLimit(const uint16_t peerLimit);
+  uint16_t peerLimit() const;
+
+  void add(const uint64_t mac, const uint64_t messageID = 0);
+  bool mayContain(const uint64_t mac, const uint64_t messageID = 0) const;
+  void clear();
+
+private:
+
+  uint32_t bitIndex(const uint64_t mac, const uint64_t messageID) const;
+
+  std::vector<uint32_t> _bits;
+  uint32_t _bitMask = 0;
+  uint16_t _peerLimit;
+  uint8_t _bitsPerPeer;
+};
+
+#endif
@@ -250,6 +250,9 @@ void MeshBackendBase::setScanHidden(const bool scanHidden)
 
 bool MeshBackendBase::getScanHidden() const {return _scanHidden;}
 
+void MeshBackendBase::setScanResultMaxAge(const uint32_t scanResultMaxAgeMs) {_scanResultMaxAgeMs = scanResultMaxAgeMs;}
+uint32_t MeshBackendBase::getScanResultMaxAge() const {return _scanResultMaxAgeMs;}
+
 void MeshBackendBase::setAPHidden(const bool apHidden)
 {
   if(getAPHidden() != apHidden)
@@ -294,8 +297,15 @@ void MeshBackendBase::scanForNetworks(const bool scanAllWiFiChannels)
 
   // If scanAllWiFiChannels is true, scanning will cause the WiFi radio to cycle through all WiFi channels.
   // This means existing WiFi connections are likely to break or work poorly if done frequently.
-  int n = 0;
-  if(scanAllWiFiChannels)
+  int n = WIFI_SCAN_FAILED;
+  if(getScanResultMaxAge())
+    n = WiFi.scanCached(getScanResultMaxAge(), scanAllWiFiChannels ? 0 : getWiFiChannel());
+    
+  if(n >= 0)
+  {
+    verboseModePrint(F("reusing recent scan. "), false);
+  }
+  else if(scanAllWiFiChannels)
   {
     n = WiFi.scanNetworks(false, getScanHidden());
   }
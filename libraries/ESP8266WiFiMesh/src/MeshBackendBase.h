@@ -238,6 +238,18 @@ public:
   void setScanHidden(const bool scanHidden);
   bool getScanHidden() const;
 
+  /**
+   * Set the maximum age of a scan result that scanForNetworks will reuse instead of scanning again.
+   * The result may come from any previous scan, e.g. by ESP8266WiFiMulti or another mesh backend, as long as it covered the required channels without an SSID filter.
+   * This is 0 by default, which means a new scan is always made.
+   * 
+   * Note that a reused result may contain hidden networks even if getScanHidden() is false, and may lack them even if it is true.
+   *
+   * @param scanResultMaxAgeMs The maximum age in milliseconds.
+   */
+  void setScanResultMaxAge(const uint32_t scanResultMaxAgeMs);
+  uint32_t getScanResultMaxAge() const;
+
   /**
    * Set whether the AP controlled by this MeshBackendBase instance will have a WiFi network with hidden SSID.
    * This is false by default.
@@ -337,6 +349,7 @@ private:
   
   uint8 _meshWiFiChannel;
   bool _scanHidden = false;
+  uint32_t _scanResultMaxAgeMs = 0;
   bool _apHidden = false;
 };
 
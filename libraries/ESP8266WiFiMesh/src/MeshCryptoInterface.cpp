@@ -24,6 +24,12 @@
 
 #include "MeshCryptoInterface.h"
 #include <assert.h>
+#include "TypeConversionFunctions.h"
+
+namespace
+{
+  namespace TypeCast = MeshTypeConversionFunctions;
+}
 
 namespace MeshCryptoInterface
 {
@@ -41,6 +47,36 @@ namespace MeshCryptoInterface
       return false;
   }
 
+  bool verifyMeshHmac(const experimental::crypto::HmacContext<experimental::crypto::SHA256> &hmacContext, const String &messageHmac)
+  {
+    const uint32_t hmacLength = messageHmac.length()/2;
+    if(hmacLength == 0 || hmacLength > experimental::crypto::SHA256::NATURAL_LENGTH || messageHmac.length() != 2*hmacLength)
+      return false;
+
+    uint8_t generatedHmac[experimental::crypto::SHA256::NATURAL_LENGTH] {};
+    uint8_t receivedHmac[experimental::crypto::SHA256::NATURAL_LENGTH] {};
+    hmacContext.finish(generatedHmac);
+    TypeCast::hexStringToUint8Array(messageHmac, receivedHmac, hmacLength);
+
+    uint8_t difference = 0;
+    for(uint32_t i = 0; i < hmacLength; ++i)
+      difference |= generatedHmac[i] ^ receivedHmac[i];
+
+    return difference == 0;
+  }
+
+  void encryptInPlace(uint8_t *data, const size_t dataLength, const uint8_t *key, const void *keySalt, const size_t keySaltLength, 
+                      uint8_t *resultingNonce, uint8_t *resultingTag)
+  {
+    experimental::crypto::ChaCha20Poly1305::encrypt(data, dataLength, key, keySalt, keySaltLength, resultingNonce, resultingTag ? resultingTag : data + dataLength);
+  }
+
+  bool decryptInPlace(uint8_t *data, const size_t dataLength, const uint8_t *key, const void *keySalt, const size_t keySaltLength, 
+                      const uint8_t *encryptionNonce, const uint8_t *encryptionTag)
+  {
+    return experimental::crypto::ChaCha20Poly1305::decrypt(data, dataLength, key, keySalt, keySaltLength, encryptionNonce, encryptionTag ? encryptionTag : data + dataLength);
+  }
+
   uint8_t *initializeKey(uint8_t *key, const uint8_t keyLength, const String &keySeed)
   {
     assert(keyLength <= experimental::crypto::SHA256::NATURAL_LENGTH);
@@ -67,6 +67,48 @@ namespace MeshCryptoInterface
    * @return True if the HMAC is correct. False otherwise.
    */
   bool verifyMeshHmac(const String &message, const String &messageHmac, const uint8_t *hashKey, const uint8_t hashKeyLength);
+
+  /**
+   * Verify a SHA256 HMAC against a context that has been fed the message, without building the message or the generated HMAC as Strings.
+   *
+   * @param hmacContext A context created with the hash key and fed the message. It is finished, not modified.
+   * @param messageHmac A string with the generated HMAC in HEX format. Valid messageHmac.length() is 2 to 64.
+   *
+   * @return True if the HMAC is correct. False otherwise.
+   */
+  bool verifyMeshHmac(const experimental::crypto::HmacContext<experimental::crypto::SHA256> &hmacContext, const String &messageHmac);
+
+  /**
+   * Encrypt data in place with ChaCha20-Poly1305. The key, keySalt and the nonce generation are the same as for experimental::crypto::ChaCha20Poly1305::encrypt.
+   * Uses no heap memory, so it can be used for every transmitted frame.
+   *
+   * @param data The array to encrypt in place.
+   * @param dataLength The length of the data to encrypt, in bytes.
+   * @param key The secret encryption key to use. Must be experimental::crypto::ENCRYPTION_KEY_LENGTH bytes long.
+   * @param keySalt The salt to use when generating a subkey from key. Set to nullptr to prevent subkey generation.
+   * @param keySaltLength The length of keySalt in bytes.
+   * @param resultingNonce The array that will store the 12 byte nonce.
+   * @param resultingTag The array that will store the 16 byte authentication tag. 
+   *                     If nullptr, the tag is appended to the data, so data must be able to contain dataLength + 16 bytes.
+   */
+  void encryptInPlace(uint8_t *data, const size_t dataLength, const uint8_t *key, const void *keySalt, const size_t keySaltLength, 
+                      uint8_t *resultingNonce, uint8_t *resultingTag = nullptr);
+
+  /**
+   * Decrypt data in place with ChaCha20-Poly1305. The counterpart of encryptInPlace.
+   *
+   * @param data The array to decrypt in place.
+   * @param dataLength The length of the data to decrypt, in bytes, not counting an appended tag.
+   * @param key The secret encryption key to use. Must be experimental::crypto::ENCRYPTION_KEY_LENGTH bytes long.
+   * @param keySalt The salt that was used during encryption.
+   * @param keySaltLength The length of keySalt in bytes.
+   * @param encryptionNonce The 12 byte nonce generated during encryption.
+   * @param encryptionTag The 16 byte tag generated during encryption. If nullptr, the tag is read from the end of data (data + dataLength).
+   *
+   * @return True if the tag matches. False otherwise. Note that data is modified regardless of this outcome.
+   */
+  bool decryptInPlace(uint8_t *data, const size_t dataLength, const uint8_t *key, const void *keySalt, const size_t keySaltLength, 
+                      const uint8_t *encryptionNonce, const uint8_t *encryptionTag = nullptr);
   
   /**
    * Initialize key with a SHA-256 hash of keySeed.
@@ -31,24 +31,47 @@ MessageData::MessageData(const String &message, const uint8_t transmissionsRemai
   _timeTracker(creationTimeMs)
 {
   _transmissionsExpected = transmissionsRemaining + 1;
-  _totalMessage += message;
+  allocateMessage(message.length() + transmissionsRemaining * EspnowMeshBackend::getMaxMessageBytesPerTransmission());
+  appendToMessage(reinterpret_cast<const uint8_t *>(message.c_str()), message.length());
   ++_transmissionsReceived;
 }
 
-MessageData::MessageData(uint8_t *initialTransmission, const uint8_t transmissionLength, const uint32_t creationTimeMs) :
+MessageData::MessageData(const uint8_t *initialTransmission, const uint8_t transmissionLength, const uint32_t creationTimeMs) :
   _timeTracker(creationTimeMs)
 {
   _transmissionsExpected = EspnowProtocolInterpreter::getTransmissionsRemaining(initialTransmission) + 1;
+  allocateMessage(_transmissionsExpected * EspnowMeshBackend::getMaxMessageBytesPerTransmission());
   addToMessage(initialTransmission, transmissionLength);
 }
 
-bool MessageData::addToMessage(uint8_t *transmission, const uint8_t transmissionLength)
+void MessageData::allocateMessage(const uint32_t messageCapacity)
+{
+  // One extra byte for a terminating null, so text messages can also be read as C strings.
+  _totalMessage.reset(new (std::nothrow) uint8_t[messageCapacity + 1]);
+  _totalMessageCapacity = _totalMessage ? messageCapacity : 0;
+  if(_totalMessage)
+    _totalMessage[0] = 0;
+}
+
+bool MessageData::appendToMessage(const uint8_t *data, const uint32_t dataLength)
+{
+  if(_totalMessageLength + dataLength > _totalMessageCapacity)
+    return false;
+
+  std::copy_n(data, dataLength, _totalMessage.get() + _totalMessageLength);
+  _totalMessageLength += dataLength;
+  _totalMessage[_totalMessageLength] = 0;
+  return true;
+}
+
+bool MessageData::addToMessage(const uint8_t *transmission, const uint8_t transmissionLength)
 {
   if(EspnowProtocolInterpreter::getTransmissionsRemaining(transmission) == getTransmissionsRemaining() - 1)
   {
-    String message = EspnowProtocolInterpreter::getHashKeyLength(transmission, transmissionLength);
-    assert(message.length() <= EspnowMeshBackend::getMaxMessageBytesPerTransmission()); // Should catch some cases where transmission is not null terminated.
-    _totalMessage += message;
+    uint8_t metadataSize = EspnowProtocolInterpreter::metadataSize();
+    uint32_t messageSize = transmissionLength >= metadataSize ? transmissionLength - metadataSize : 0;
+    assert(messageSize <= EspnowMeshBackend::getMaxMessageBytesPerTransmission());
+    appendToMessage(transmission + metadataSize, messageSize);
     ++_transmissionsReceived;
     return true;
   }
@@ -73,7 +96,14 @@ uint8_t MessageData::getTransmissionsRemaining() const
 
 String MessageData::getTotalMessage() const
 {
-  return _totalMessage;
+  String totalMessage;
+  if(_totalMessageLength > 0)
+    totalMessage.concat(reinterpret_cast<const char *>(_totalMessage.get()), _totalMessageLength);
+  return totalMessage;
 }
 
+const uint8_t *MessageData::getTotalMessageData() const { return _totalMessage.get(); }
+
+uint32_t MessageData::getTotalMessageLength() const { return _totalMessageLength; }
+
 const TimeTracker &MessageData::getTimeTracker() const { return _timeTracker; }
@@ -27,28 +27,41 @@
 
 #include "TimeTracker.h"
 #include <Arduino.h>
+#include <memory>
 
 class MessageData {
 
 public:
 
   MessageData(const String &message, const uint8_t transmissionsRemaining, const uint32_t creationTimeMs = millis());
-  MessageData(uint8_t *initialTransmission, const uint8_t transmissionLength, const uint32_t creationTimeMs = millis());
+  MessageData(const uint8_t *initialTransmission, const uint8_t transmissionLength, const uint32_t creationTimeMs = millis());
   /**
-   * @transmission A string of characters, including initial protocol bytes. Not const since that would increase heap consumption during processing.
+   * @transmission An array of bytes, including initial protocol bytes.
    * @transmissionLength Length of transmission.
    */
-  bool addToMessage(uint8_t *transmission, const uint8_t transmissionLength);
+  bool addToMessage(const uint8_t *transmission, const uint8_t transmissionLength);
   uint8_t getTransmissionsReceived() const;
   uint8_t getTransmissionsExpected() const;
   uint8_t getTransmissionsRemaining() const;
   String getTotalMessage() const;
+  /**
+   * The message parts are stored in one buffer allocated for the whole message when the first part is received.
+   * 
+   * @return A pointer to the message bytes received so far. nullptr if the buffer could not be allocated.
+   */
+  const uint8_t *getTotalMessageData() const;
+  uint32_t getTotalMessageLength() const;
   const TimeTracker &getTimeTracker() const;
 
 private:
 
+  void allocateMessage(const uint32_t messageCapacity);
+  bool appendToMessage(const uint8_t *data, const uint32_t dataLength);
+
   TimeTracker _timeTracker;
-  String _totalMessage;
+  std::unique_ptr<uint8_t[]> _totalMessage;
+  uint32_t _totalMessageLength = 0;
+  uint32_t _totalMessageCapacity = 0;
   uint8_t _transmissionsReceived = 0;
   uint8_t _transmissionsExpected;
 };
@@ -0,0 +1,166 @@
+/*
+ * License (MIT license):
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "MessageIDLog.h"
+
+MessageIDLog::MessageIDLog(const uint16_t capacity) : _capacity(capacity)
+{
+  assert(capacity >= 1);
+}
+
+bool MessageIDLog::allocate()
+{
+  _slotBits = 1;
+  while((1U << _slotBits) < 2U * _capacity) // Keep the load factor at or below 0.5 so probe sequences stay short.
+    ++_slotBits;
+
+  _messageIDs.reset(new (std::nothrow) uint64_t[_capacity]);
+  _states.reset(new (std::nothrow) uint8_t[_capacity]);
+  _slots.reset(new (std::nothrow) uint16_t[1U << _slotBits]()); // Value-initialized, so all slots start out empty.
+
+  if(!_messageIDs || !_states || !_slots)
+  {
+    _messageIDs.reset();
+    _states.reset();
+    _slots.reset();
+    return false;
+  }
+
+  return true;
+}
+
+uint32_t MessageIDLog::homeSlot(const uint64_t messageID) const
+{
+  // Fibonacci hashing of the folded ID. Cheaper than a full 64-bit mix and the top bits of the product are well distributed.
+  uint32_t folded = (uint32_t)messageID ^ (uint32_t)(messageID >> 32);
+  return (folded * 2654435769U) >> (32 - _slotBits);
+}
+
+uint32_t MessageIDLog::findSlot(const uint64_t messageID) const
+{
+  const uint32_t slotMask = (1U << _slotBits) - 1;
+  uint32_t slot = homeSlot(messageID);
+
+  while(_slots[slot] && _messageIDs[_slots[slot] - 1] != messageID)
+    slot = (slot + 1) & slotMask;
+
+  return slot; // Either the slot holding messageID or the empty slot where it would be inserted.
+}
+
+void MessageIDLog::eraseOldest()
+{
+  const uint32_t slotMask = (1U << _slotBits) - 1;
+  uint32_t emptySlot = findSlot(_messageIDs[_oldest]);
+  assert(_slots[emptySlot] == _oldest + 1);
+
+  // Backward shift deletion: move later entries of the probe sequence into the hole, so no tombstones are needed.
+  for(uint32_t slot = (emptySlot + 1) & slotMask; _slots[slot]; slot = (slot + 1) & slotMask)
+  {
+    uint32_t home = homeSlot(_messageIDs[_slots[slot] - 1]);
+    
+    // The entry may only move if its home slot is not cyclically within (emptySlot, slot].
+    if(slot > emptySlot ? (home <= emptySlot || home > slot) : (home <= emptySlot && home > slot))
+    {
+      _slots[emptySlot] = _slots[slot];
+      emptySlot = slot;
+    }
+  }
+
+  _slots[emptySlot] = 0;
+  _oldest = (_oldest + 1) % _capacity;
+  --_size;
+}
+
+std::pair<uint8_t *, bool> MessageIDLog::emplace(const uint64_t messageID, const uint8_t state)
+{
+  if(!_slots && !allocate())
+    return {nullptr, true};
+
+  uint32_t slot = findSlot(messageID);
+  
+  if(_slots[slot])
+    return {&_states[_slots[slot] - 1], false};
+
+  if(_size == _capacity)
+  {
+    eraseOldest();
+    slot = findSlot(messageID); // The deletion may have shifted entries into the slot found earlier.
+  }
+
+  uint16_t ringIndex = (_oldest + _size) % _capacity;
+  _messageIDs[ringIndex] = messageID;
+  _states[ringIndex] = state;
+  _slots[slot] = ringIndex + 1;
+  ++_size;
+  
+  return {&_states[ringIndex], true};
+}
+
+uint8_t *MessageIDLog::find(const uint64_t messageID)
+{
+  if(!_slots)
+    return nullptr;
+  
+  uint32_t slot = findSlot(messageID);
+  return _slots[slot] ? &_states[_slots[slot] - 1] : nullptr;
+}
+
+void MessageIDLog::setCapacity(const uint16_t capacity)
+{
+  assert(capacity >= 1);
+  
+  if(!_slots)
+  {
+    _capacity = capacity;
+    return;
+  }
+
+  std::unique_ptr<uint64_t[]> oldMessageIDs = std::move(_messageIDs);
+  std::unique_ptr<uint8_t[]> oldStates = std::move(_states);
+  const uint16_t oldCapacity = _capacity;
+  const uint16_t keptCount = std::min(_size, capacity);
+  const uint16_t firstKept = (_oldest + _size - keptCount) % oldCapacity;
+
+  clear();
+  _capacity = capacity;
+  
+  if(!keptCount || !allocate())
+    return;
+  
+  for(uint16_t i = 0; i < keptCount; ++i)
+  {
+    uint16_t ringIndex = (firstKept + i) % oldCapacity;
+    emplace(oldMessageIDs[ringIndex], oldStates[ringIndex]);
+  }
+}
+
+uint16_t MessageIDLog::capacity() const { return _capacity; }
+uint16_t MessageIDLog::size() const { return _size; }
+
+void MessageIDLog::clear()
+{
+  _messageIDs.reset();
+  _states.reset();
+  _slots.reset();
+  _oldest = 0;
+  _size = 0;
+}
@@ -0,0 +1,89 @@
+/*
+ * License (MIT license):
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef __MESSAGEIDLOG_H__
+#define __MESSAGEIDLOG_H__
+
+#include <Arduino.h>
+#include <memory>
+#include <utility>
+
+/**
+ * Fixed-size log of the most recently seen 64-bit message IDs, each with a small state value.
+ * 
+ * IDs are kept in insertion order in a ring, and a power of two sized open-addressing hash table
+ * (linear probing, at most 50 % load) indexes the ring. Lookups, insertions and the eviction of the
+ * oldest ID when the log is full are therefore all O(1), regardless of capacity.
+ * Memory is allocated on the first insertion, 13 to 17 bytes per ID of capacity.
+ */
+class MessageIDLog {
+
+public:
+
+  explicit MessageIDLog(const uint16_t capacity);
+
+  MessageIDLog(const MessageIDLog &) = delete;
+  MessageIDLog &operator=(const MessageIDLog &) = delete;
+
+  /**
+   * Insert messageID with the given state, unless it is already in the log. 
+   * If the log is full, the oldest message ID is removed to make room.
+   * 
+   * @return A pair of a pointer to the state stored for messageID and true if messageID was inserted, false if it was already in the log.
+   *         If memory for the log could not be allocated the pointer is nullptr and the bool is true, so the message is treated as new.
+   */
+  std::pair<uint8_t *, bool> emplace(const uint64_t messageID, const uint8_t state);
+
+  /**
+   * @return A pointer to the state stored for messageID, or nullptr if messageID is not in the log.
+   */
+  uint8_t *find(const uint64_t messageID);
+
+  /**
+   * Change the maximum number of message IDs stored. The newest message IDs are kept if the log shrinks.
+   * 
+   * @param capacity Must be at least 1.
+   */
+  void setCapacity(const uint16_t capacity);
+  uint16_t capacity() const;
+
+  uint16_t size() const;
+  void clear();
+
+private:
+
+  bool allocate();
+  uint32_t homeSlot(const uint64_t messageID) const;
+  uint32_t findSlot(const uint64_t messageID) const;
+  void eraseOldest();
+
+  std::unique_ptr<uint64_t[]> _messageIDs;
+  std::unique_ptr<uint8_t[]> _states;
+  std::unique_ptr<uint16_t[]> _slots; // Ring index + 1 of the ID stored in each slot, 0 for an empty slot.
+  
+  uint16_t _capacity;
+  uint16_t _oldest = 0;
+  uint16_t _size = 0;
+  uint8_t _slotBits = 0;
+};
+
+#endif
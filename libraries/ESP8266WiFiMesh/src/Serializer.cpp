@@ -33,10 +33,24 @@ namespace
 {
   namespace TypeCast = MeshTypeConversionFunctions;
 
-  String createJsonEndPair(const String &valueIdentifier, const String &value)
+  void appendJsonEndPair(String &result, const String &valueIdentifier, const String &value)
   {
-    const String q = String('"');
-    return q + valueIdentifier + q + ':' + q + value + F("\"}}");
+    result.reserve(result.length() + valueIdentifier.length() + value.length() + 7); // Quotes, : and the two ending }
+    result += '"';
+    result += valueIdentifier;
+    result += F("\":\"");
+    result += value;
+    result += F("\"}}");
+  }
+
+  String quote(const String &value)
+  {
+    String result;
+    result.reserve(value.length() + 2);
+    result += '"';
+    result += value;
+    result += '"';
+    return result;
   }
 }
 
@@ -82,32 +96,32 @@ namespace Serializer
   {
     using namespace JsonTranslator;
 
-    const String q = String('"');
-
+    const String arguments = encode({FPSTR(jsonArguments), 
+                                     encodeLiterally({FPSTR(jsonNonce), quote(requestNonce), 
+                                                      FPSTR(jsonPassword), quote(authenticationPassword), 
+                                                      FPSTR(jsonOwnSessionKey), quote(TypeCast::uint64ToString(peerSessionKey)),   // Exchanges session keys since it should be valid for the receiver.
+                                                      FPSTR(jsonPeerSessionKey), quote(TypeCast::uint64ToString(ownSessionKey))})});
+    
     // Returns: infoHeader{"arguments":{"nonce":"1F2","password":"abc","ownSK":"3B4","peerSK":"1A2"}}
-    return 
-    infoHeader + 
-    encode({FPSTR(jsonArguments), 
-    encodeLiterally({FPSTR(jsonNonce), q + requestNonce + q, 
-                     FPSTR(jsonPassword), q + authenticationPassword + q, 
-                     FPSTR(jsonOwnSessionKey), q + TypeCast::uint64ToString(peerSessionKey) + q,   // Exchanges session keys since it should be valid for the receiver.
-                     FPSTR(jsonPeerSessionKey), q + TypeCast::uint64ToString(ownSessionKey) + q})});
+    String result;
+    result.reserve(infoHeader.length() + arguments.length());
+    result += infoHeader;
+    result += arguments;
+    return result;
   }
   
   String createEncryptionRequestHmacMessage(const String &requestHeader, const String &requestNonce, const uint8_t *hashKey, const uint8_t hashKeyLength, const uint32_t duration)
   {
     using namespace JsonTranslator;
 
-    String mainMessage = requestHeader;
+    const String arguments = requestHeader == FPSTR(EspnowProtocolInterpreter::temporaryEncryptionRequestHeader) ? 
+                             encode({FPSTR(jsonArguments), encode({FPSTR(jsonDuration), String(duration), FPSTR(jsonNonce), requestNonce})}) :
+                             encode({FPSTR(jsonArguments), encode({FPSTR(jsonNonce), requestNonce})});
 
-    if(requestHeader == FPSTR(EspnowProtocolInterpreter::temporaryEncryptionRequestHeader))
-    {
-      mainMessage += encode({FPSTR(jsonArguments), encode({FPSTR(jsonDuration), String(duration), FPSTR(jsonNonce), requestNonce})});
-    }
-    else
-    {
-      mainMessage += encode({FPSTR(jsonArguments), encode({FPSTR(jsonNonce), requestNonce})});
-    }
+    String mainMessage;
+    mainMessage.reserve(requestHeader.length() + arguments.length());
+    mainMessage += requestHeader;
+    mainMessage += arguments;
 
     // We need to have an open JSON object so we can add the HMAC later.
     mainMessage.remove(mainMessage.length() - 2);
@@ -115,10 +129,14 @@ namespace Serializer
 
     uint8_t staMac[6] {0};
     uint8_t apMac[6] {0};
-    String requesterStaApMac = TypeCast::macToString(WiFi.macAddress(staMac)) + TypeCast::macToString(WiFi.softAPmacAddress(apMac));
-    String hmac = MeshCryptoInterface::createMeshHmac(requesterStaApMac + mainMessage, hashKey, hashKeyLength);
+    experimental::crypto::HmacContext<experimental::crypto::SHA256> hmacContext(hashKey, hashKeyLength);
+    hmacContext.update(TypeCast::macToString(WiFi.macAddress(staMac)));
+    hmacContext.update(TypeCast::macToString(WiFi.softAPmacAddress(apMac)));
+    hmacContext.update(mainMessage);
+    const String hmac = hmacContext.finish();
 
     // Returns: requestHeader{"arguments":{"duration":"123","nonce":"1F2","hmac":"3B4"}}
-    return mainMessage + createJsonEndPair(FPSTR(jsonHmac), hmac);
+    appendJsonEndPair(mainMessage, FPSTR(jsonHmac), hmac);
+    return mainMessage;
   }
 }
@@ -108,6 +108,10 @@ void TcpIpMeshBackend::activateAPHook()
 
 void TcpIpMeshBackend::deactivateAPHook()
 {
+  for(SessionStation &station : _sessionStations)
+    station.client.stop();
+  _sessionStations.clear();
+  
   _server.stop();
 }
 
@@ -201,6 +205,46 @@ void TcpIpMeshBackend::setAPModeTimeout(const uint32_t apModeTimeoutMs)
 
 uint32_t TcpIpMeshBackend::getAPModeTimeout() const {return _apModeTimeoutMs;}
 
+void TcpIpMeshBackend::setSessionDuration(const uint32_t sessionDurationMs)
+{
+  _sessionDurationMs = sessionDurationMs;
+
+  if(!_sessionDurationMs)
+    endSession();
+}
+
+uint32_t TcpIpMeshBackend::getSessionDuration() const {return _sessionDurationMs;}
+
+void TcpIpMeshBackend::endSession()
+{
+  for(SessionStation &station : _sessionStations)
+    station.client.stop();
+  _sessionStations.clear();
+  
+  endStationSession();
+}
+
+void TcpIpMeshBackend::endStationSession()
+{
+  _sessionClient.stop();
+  
+  if(_sessionDisconnectPending)
+  {
+    _sessionDisconnectPending = false;
+    WiFi.disconnect();
+    yield();
+  }
+}
+
+void TcpIpMeshBackend::endExpiredSession()
+{
+  if((_sessionDisconnectPending || _sessionClient) && _sessionTimeout)
+  {
+    verboseModePrint(F("Session expired."));
+    endStationSession();
+  }
+}
+
 /**
  * Disconnect completely from a network.
  */
@@ -299,6 +343,22 @@ TransmissionStatusType TcpIpMeshBackend::attemptDataTransfer()
  */
 TransmissionStatusType TcpIpMeshBackend::attemptDataTransferKernel()
 {
+  if(_sessionClient.connected())
+  {
+    // Kept from the previous transmission, see setSessionDuration()
+    verboseModePrint(F("Reusing session connection."));
+    TransmissionStatusType transmissionOutcome = exchangeInfo(_sessionClient);
+    if (static_cast<int>(transmissionOutcome) <= 0)
+    {
+      verboseModePrint(F("Transmission failed during exchangeInfo."));
+      _sessionClient.stop();
+    }
+    
+    return transmissionOutcome;
+  }
+  
+  _sessionClient.stop(); // Closed by the server
+  
   WiFiClient currClient;
   currClient.setTimeout(_stationModeTimeoutMs);
 
@@ -317,8 +377,15 @@ TransmissionStatusType TcpIpMeshBackend::attemptDataTransferKernel()
     return transmissionOutcome;
   }
   
-  currClient.stop();
-  yield();
+  if(_sessionDurationMs)
+  {
+    _sessionClient = currClient;
+  }
+  else
+  {
+    currClient.stop();
+    yield();
+  }
 
   return transmissionOutcome;
 }
@@ -396,10 +463,19 @@ TransmissionStatusType TcpIpMeshBackend::connectToNode(const String &targetSSID,
 
 TransmissionStatusType TcpIpMeshBackend::initiateTransmission(const TcpIpNetworkInfo &recipientInfo)
 {
+  assert(!recipientInfo.SSID().isEmpty()); // We need at least SSID to connect
+
+  if(_sessionDisconnectPending && WiFi.status() == WL_CONNECTED && WiFi.SSID() == recipientInfo.SSID())
+  {
+    // Still connected from the session, see setSessionDuration()
+    return attemptDataTransfer();
+  }
+
+  _sessionClient.stop();
+  _sessionDisconnectPending = false;
   WiFi.disconnect();
   yield();
 
-  assert(!recipientInfo.SSID().isEmpty()); // We need at least SSID to connect
   String targetSSID = recipientInfo.SSID();
   int32_t targetWiFiChannel = recipientInfo.wifiChannel();
   uint8_t targetBSSID[6] {0};
@@ -421,9 +497,19 @@ void TcpIpMeshBackend::enterPostTransmissionState(const bool concludingDisconnec
     setStaticIP(staticIP);
   }
 
+  if(_sessionDurationMs && WiFi.status() == WL_CONNECTED)
+  {
+    // Stay connected until the session expires, see setSessionDuration()
+    _sessionTimeout.reset(_sessionDurationMs);
+    _sessionDisconnectPending = _sessionDisconnectPending || concludingDisconnect;
+    return;
+  }
+
   // If we do not want to be connected at end of transmission, disconnect here so we can re-enable static IP first (above).
   if(concludingDisconnect)
   {
+    _sessionClient.stop();
+    _sessionDisconnectPending = false;
     WiFi.disconnect();
     yield();
   }
@@ -438,8 +524,11 @@ void TcpIpMeshBackend::attemptTransmission(const String &message, const bool sca
     return;
   }
   
+  endExpiredSession();
+  
   if(initialDisconnect)
   {
+    endStationSession();
     WiFi.disconnect();
     yield();
   }
@@ -448,7 +537,7 @@ void TcpIpMeshBackend::attemptTransmission(const String &message, const bool sca
 
   latestTransmissionOutcomes().clear();
   
-  if(WiFi.status() == WL_CONNECTED)
+  if(WiFi.status() == WL_CONNECTED && !_sessionDisconnectPending) // A connection kept only by the session does not stop the node from transmitting to the connectionQueue
   {
     TransmissionStatusType transmissionResult = attemptDataTransfer();
     latestTransmissionOutcomes().push_back(TransmissionOutcome(constConnectionQueue().back(), transmissionResult));
@@ -491,6 +580,11 @@ void TcpIpMeshBackend::attemptTransmission(const String &message, const bool sca
 }
 
 TransmissionStatusType TcpIpMeshBackend::attemptTransmission(const String &message, const TcpIpNetworkInfo &recipientInfo, const bool concludingDisconnect, const bool initialDisconnect)
+{  
+  return attemptTransmission(std::vector<String>{message}, recipientInfo, concludingDisconnect, initialDisconnect);
+}
+
+TransmissionStatusType TcpIpMeshBackend::attemptTransmission(const std::vector<String> &messages, const TcpIpNetworkInfo &recipientInfo, const bool concludingDisconnect, const bool initialDisconnect)
 {  
   MutexTracker mutexTracker(_tcpIpTransmissionMutex);
   if(!mutexTracker.mutexCaptured())
@@ -500,21 +594,31 @@ TransmissionStatusType TcpIpMeshBackend::attemptTransmission(const String &messa
   }
 
   TransmissionStatusType transmissionResult = TransmissionStatusType::CONNECTION_FAILED;
-  setTemporaryMessage(message);
+  
+  endExpiredSession();
   
   if(initialDisconnect)
   {
+    endStationSession();
     WiFi.disconnect();
     yield();
   }
 
-  if(WiFi.status() == WL_CONNECTED && WiFi.SSID() == recipientInfo.SSID())
-  {
-    transmissionResult = attemptDataTransfer();
-  }
-  else
+  for(const String &message : messages)
   {
-    transmissionResult = initiateTransmission(recipientInfo);
+    setTemporaryMessage(message);
+    
+    if(WiFi.status() == WL_CONNECTED && WiFi.SSID() == recipientInfo.SSID())
+    {
+      transmissionResult = attemptDataTransfer();
+    }
+    else
+    {
+      transmissionResult = initiateTransmission(recipientInfo);
+    }
+
+    if(static_cast<int>(transmissionResult) <= 0)
+      break;
   }
   
   enterPostTransmissionState(concludingDisconnect);
@@ -523,6 +627,28 @@ TransmissionStatusType TcpIpMeshBackend::attemptTransmission(const String &messa
   return transmissionResult;
 }
 
+/**
+ * Read a request from a connected station, pass it to the requestHandler and send back the response.
+ */
+void TcpIpMeshBackend::respondToRequest(WiFiClient &currClient)
+{
+  /* Read in request and pass it to the supplied requestHandler */
+  String request = currClient.readStringUntil('\r');
+  yield();
+  currClient.flush();
+  
+  String response = getRequestHandler()(request, *this);
+
+  /* Send the response back to the client */
+  if (currClient.connected())
+  {
+    verboseModePrint(String(F("Responding")));
+    currClient.print(response + '\r');
+    currClient.flush();
+    yield();
+  }
+}
+
 void TcpIpMeshBackend::acceptRequests()
 {
   MutexTracker mutexTracker(_tcpIpTransmissionMutex);
@@ -532,6 +658,26 @@ void TcpIpMeshBackend::acceptRequests()
     return;
   }
   
+  endExpiredSession();
+  
+  // Stations sending further requests on connections kept by session mode, see setSessionDuration()
+  for(auto stationIterator = _sessionStations.begin(); stationIterator != _sessionStations.end(); )
+  {
+    if(stationIterator->client.available())
+    {
+      respondToRequest(stationIterator->client);
+      stationIterator->idleTimeout.reset(_sessionDurationMs);
+    }
+
+    if(!stationIterator->client.connected() || stationIterator->idleTimeout)
+    {
+      stationIterator->client.stop();
+      stationIterator = _sessionStations.erase(stationIterator);
+    }
+    else
+      ++stationIterator;
+  }
+  
   while (true) {
     WiFiClient _client = _server.available();
     
@@ -542,20 +688,11 @@ void TcpIpMeshBackend::acceptRequests()
       continue;
     }
     
-    /* Read in request and pass it to the supplied requestHandler */
-    String request = _client.readStringUntil('\r');
-    yield();
-    _client.flush();
-    
-    String response = getRequestHandler()(request, *this);
+    respondToRequest(_client);
 
-    /* Send the response back to the client */
-    if (_client.connected())
+    if (_sessionDurationMs && _client.connected() && _sessionStations.size() < _maxAPStations)
     {
-      verboseModePrint(String(F("Responding")));
-      _client.print(response + '\r');
-      _client.flush();
-      yield();
+      _sessionStations.push_back(SessionStation{_client, ExpiringTimeTracker(_sessionDurationMs)});
     }
   }
 }
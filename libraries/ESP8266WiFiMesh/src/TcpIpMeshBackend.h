@@ -32,6 +32,7 @@
 #include <vector>
 #include "MeshBackendBase.h"
 #include "TcpIpNetworkInfo.h"
+#include "ExpiringTimeTracker.h"
 
 class TcpIpMeshBackend : public MeshBackendBase {
 
@@ -125,6 +126,15 @@ public:
    * Note that if wifiChannel and BSSID are missing from recipientInfo, connection time will be longer.
    */
   TransmissionStatusType attemptTransmission(const String &message, const TcpIpNetworkInfo &recipientInfo, const bool concludingDisconnect = true, const bool initialDisconnect = false);
+
+  /**
+   * Transmit several messages to a single recipient, in order, over one WiFi connection (and one TCP connection in session mode, see setSessionDuration).
+   * The response to each message is sent to the responseHandler callback. Stops at the first message that fails.
+   * Will not change connectionQueue, latestTransmissionOutcomes or stored message.
+   * 
+   * @return The status of the last message transmitted.
+   */
+  TransmissionStatusType attemptTransmission(const std::vector<String> &messages, const TcpIpNetworkInfo &recipientInfo, const bool concludingDisconnect = true, const bool initialDisconnect = false);
   
   /**
    * If any clients are connected, accept their requests and call the requestHandler function for each one.
@@ -208,6 +218,25 @@ public:
   void setAPModeTimeout(const uint32_t apModeTimeoutMs);
   uint32_t getAPModeTimeout() const;
 
+  /**
+   * Set the duration of transmission sessions, 0 (session mode off) by default. 
+   * 
+   * In session mode, the connection to an AP and the TCP connection to its server are kept for sessionDurationMs after each transmission, 
+   * so further transmissions to the same node need neither a new WiFi connection nor a new TCP handshake. 
+   * A concludingDisconnect then only takes effect when the session expires, which is checked by attemptTransmission and acceptRequests, or with endSession().
+   * As an AP, acceptRequests keeps each station's TCP connection open for further requests until it has been idle for sessionDurationMs (at most getMaxAPStations() connections).
+   * Nodes without session mode close their TCP connection after each response, a new one is then made for the next transmission.
+   *
+   * @param sessionDurationMs The session duration to use, in milliseconds.
+   */
+  void setSessionDuration(const uint32_t sessionDurationMs);
+  uint32_t getSessionDuration() const;
+
+  /**
+   * End the current session: close the TCP connections kept by session mode, and disconnect from the AP if a concludingDisconnect was deferred.
+   */
+  void endSession();
+
 protected:
 
   static std::vector<TcpIpNetworkInfo> _connectionQueue;
@@ -263,6 +292,9 @@ private:
   TransmissionStatusType attemptDataTransferKernel();
   TransmissionStatusType initiateTransmission(const TcpIpNetworkInfo &recipientInfo);
   void enterPostTransmissionState(const bool concludingDisconnect);
+  void endStationSession();
+  void endExpiredSession();
+  void respondToRequest(WiFiClient &currClient);
    
   uint32_t _connectionAttemptTimeoutMs = 10000;
   int _stationModeTimeoutMs = 5000; // int is the type used in the Arduino core for this particular API, not uint32_t, which is why we use int here.
@@ -273,6 +305,18 @@ private:
   uint8_t _maxAPStations = 4; // Only affects TCP/IP connections, not ESP-NOW connections
   
   bool useStaticIP;
+
+  uint32_t _sessionDurationMs = 0;
+  ExpiringTimeTracker _sessionTimeout = ExpiringTimeTracker(0);
+  bool _sessionDisconnectPending = false; // Still connected to the AP of the latest transmission, only because of the session
+  WiFiClient _sessionClient;
+  
+  struct SessionStation
+  {
+    WiFiClient client;
+    ExpiringTimeTracker idleTimeout;
+  };
+  std::vector<SessionStation> _sessionStations;
 };
 
 #endif
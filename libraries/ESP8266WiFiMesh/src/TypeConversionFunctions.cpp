@@ -60,6 +60,11 @@ namespace MeshTypeConversionFunctions
   }
   
   uint64_t stringToUint64(const String &string, const byte base)
+  {
+    return stringToUint64(string.c_str(), string.length(), base);
+  }
+  
+  uint64_t stringToUint64(const char *string, const uint32_t length, const uint8_t base)
   {
     assert(2 <= base && base <= 36);
     
@@ -67,18 +72,18 @@ namespace MeshTypeConversionFunctions
   
     if(base == 16)
     {
-      for(uint32_t i = 0; i < string.length(); ++i)
+      for(uint32_t i = 0; i < length; ++i)
       {
         result <<= 4; // We could write result *= 16; and the compiler would optimize it to a shift, but the explicit shift notation makes it clearer where the speed-up comes from.
-        result += pgm_read_byte(base36CharValues + string.charAt(i) - '0');
+        result += pgm_read_byte(base36CharValues + string[i] - '0');
       }
     }
     else
     {
-      for(uint32_t i = 0; i < string.length(); ++i)
+      for(uint32_t i = 0; i < length; ++i)
       {
         result *= base;
-        result += pgm_read_byte(base36CharValues + string.charAt(i) - '0');
+        result += pgm_read_byte(base36CharValues + string[i] - '0');
       }
     }
     
@@ -54,6 +54,12 @@ namespace MeshTypeConversionFunctions
    * @return A uint64_t of the string, using radix "base" during decoding.
    */
   uint64_t stringToUint64(const String &string, const uint8_t base = 16);
+
+  /**
+   * Same as stringToUint64(const String &, const uint8_t), but converts the first "length" characters of a char array.
+   * Useful for parsing a number inside a larger String without creating a substring.
+   */
+  uint64_t stringToUint64(const char *string, const uint32_t length, const uint8_t base = 16);
   
   /** 
    *  Convert the contents of a uint8_t array to a String in HEX format. The resulting String starts from index 0 of the array.
@@ -25,6 +25,7 @@
 
 #include "ESP8266httpUpdate.h"
 #include <StreamString.h>
+#include <PolledTimeout.h>
 
 extern "C" uint32_t _FS_start;
 extern "C" uint32_t _FS_end;
@@ -43,6 +44,18 @@ ESP8266HTTPUpdate::~ESP8266HTTPUpdate(void)
 {
 }
 
+/**
+ * drop the partial update kept for resuming
+ */
+void ESP8266HTTPUpdate::resetResume()
+{
+    if(_resume.size && Update.isRunning()) {
+        Update.end();
+        Update.clearError();
+    }
+    _resume = Resume();
+}
+
 /**
  * set the Authorization for the http request
  * @param user const String&
@@ -270,21 +283,13 @@ String ESP8266HTTPUpdate::getLastErrorString(void)
 
 
 /**
- *
- * @param http HTTPClient *
- * @param currentVersion const char *
- * @return HTTPUpdateResult
+ * headers of every request, they are consumed by each of them
+ * @param http HTTPClient &
+ * @param currentVersion const String &
+ * @param spiffs bool
  */
-HTTPUpdateResult ESP8266HTTPUpdate::handleUpdate(HTTPClient& http, const String& currentVersion, bool spiffs)
+void ESP8266HTTPUpdate::addRequestHeaders(HTTPClient& http, const String& currentVersion, bool spiffs)
 {
-
-    HTTPUpdateResult ret = HTTP_UPDATE_FAILED;
-
-    // use HTTP/1.0 for update since the update handler not support any transfer Encoding
-    http.useHTTP10(true);
-    http.setTimeout(_httpClientTimeout);
-    http.setFollowRedirects(_followRedirects);
-    http.setUserAgent(F("ESP8266-http-Update"));
     http.addHeader(F("x-ESP8266-Chip-ID"), String(ESP.getChipId()));
     http.addHeader(F("x-ESP8266-STA-MAC"), WiFi.macAddress());
     http.addHeader(F("x-ESP8266-AP-MAC"), WiFi.softAPmacAddress());
@@ -313,8 +318,36 @@ HTTPUpdateResult ESP8266HTTPUpdate::handleUpdate(HTTPClient& http, const String&
     {
         http.setAuthorization(_auth.c_str());
     }
+}
 
-    const char * headerkeys[] = { "x-MD5" };
+/**
+ *
+ * @param http HTTPClient *
+ * @param currentVersion const char *
+ * @return HTTPUpdateResult
+ */
+HTTPUpdateResult ESP8266HTTPUpdate::handleUpdate(HTTPClient& http, const String& currentVersion, bool spiffs)
+{
+
+    HTTPUpdateResult ret = HTTP_UPDATE_FAILED;
+
+    // use HTTP/1.0 for update since the update handler not support any transfer Encoding
+    http.useHTTP10(true);
+    http.setTimeout(_httpClientTimeout);
+    http.setFollowRedirects(_followRedirects);
+    http.setUserAgent(F("ESP8266-http-Update"));
+    addRequestHeaders(http, currentVersion, spiffs);
+
+    // a partial update left by a previous call, see setResume()
+    bool resuming = _resumeAttempts && _resume.size && _resume.spiffs == spiffs && Update.isRunning();
+    if(!resuming) {
+        resetResume();
+    } else {
+        http.addHeader(F("Range"), String(F("bytes=")) + _resume.offset + '-');
+        http.addHeader(F("If-Range"), _resume.validator);
+    }
+
+    const char * headerkeys[] = { "x-MD5", "ETag", "Last-Modified", "Content-Range" };
     size_t headerkeyssize = sizeof(headerkeys) / sizeof(char*);
 
     // track these headers
@@ -351,6 +384,11 @@ HTTPUpdateResult ESP8266HTTPUpdate::handleUpdate(HTTPClient& http, const String&
 
     switch(code) {
     case HTTP_CODE_OK:  ///< OK (Start Update)
+        if(resuming) {
+            // changed since, or the server does not do ranges
+            DEBUG_HTTP_UPDATE("[httpUpdate] cannot resume, starting over\n");
+            resetResume();
+        }
         if(len > 0) {
             bool startUpdate = true;
             if(spiffs) {
@@ -424,23 +462,26 @@ HTTPUpdateResult ESP8266HTTPUpdate::handleUpdate(HTTPClient& http, const String&
                         }
                     }
                 }
-                if(runUpdate(*tcp, len, http.header("x-MD5"), command)) {
-                    ret = HTTP_UPDATE_OK;
-                    DEBUG_HTTP_UPDATE("[httpUpdate] Update ok\n");
-                    http.end();
-                    // Warn main app we're all done
-                    if (_cbEnd) {
-                        _cbEnd();
-                    }
+                // ETag only if strong, If-Range does not take weak ones
+                String validator = http.header("ETag");
+                if(validator.startsWith(F("W/")) || validator.isEmpty()) {
+                    validator = http.header("Last-Modified");
+                }
 
-#ifdef ATOMIC_FS_UPDATE
-                    if(_rebootOnUpdate) {
-#else
-                    if(_rebootOnUpdate && !spiffs) {
-#endif
-                        ESP.restart();
+                bool ok;
+                if(_resumeAttempts && !validator.isEmpty()) {
+                    ok = beginUpdate(len, http.header("x-MD5"), command);
+                    if(ok) {
+                        _resume.validator = validator;
+                        _resume.size = len;
+                        _resume.spiffs = spiffs;
+                        ok = runResumable(http, currentVersion, spiffs);
                     }
-
+                } else {
+                    ok = runUpdate(*tcp, len, http.header("x-MD5"), command);
+                }
+                if(ok) {
+                    ret = updateDone(http, spiffs);
                 } else {
                     ret = HTTP_UPDATE_FAILED;
                     DEBUG_HTTP_UPDATE("[httpUpdate] Update failed\n");
@@ -452,6 +493,28 @@ HTTPUpdateResult ESP8266HTTPUpdate::handleUpdate(HTTPClient& http, const String&
             DEBUG_HTTP_UPDATE("[httpUpdate] Content-Length was 0 or wasn't set by Server?!\n");
         }
         break;
+    case HTTP_CODE_PARTIAL_CONTENT:
+        if(resuming && rangeMatches(http)) {
+            DEBUG_HTTP_UPDATE("[httpUpdate] resuming at %u of %u\n", _resume.offset, _resume.size);
+            if (_cbStart) {
+                _cbStart();
+            }
+            if (_closeConnectionsOnUpdate) {
+                WiFiUDP::stopAll();
+                WiFiClient::stopAllExcept(http.getStreamPtr());
+            }
+            if(runResumable(http, currentVersion, spiffs)) {
+                ret = updateDone(http, spiffs);
+            } else {
+                ret = HTTP_UPDATE_FAILED;
+                DEBUG_HTTP_UPDATE("[httpUpdate] Update failed\n");
+            }
+            break;
+        }
+        resetResume();
+        _setLastError(HTTP_UE_SERVER_WRONG_HTTP_CODE);
+        ret = HTTP_UPDATE_FAILED;
+        break;
     case HTTP_CODE_NOT_MODIFIED:
         ///< Not Modified (No updates)
         ret = HTTP_UPDATE_NO_UPDATES;
@@ -481,20 +544,133 @@ HTTPUpdateResult ESP8266HTTPUpdate::handleUpdate(HTTPClient& http, const String&
 }
 
 /**
- * write Update to flash
- * @param in Stream&
- * @param size uint32_t
- * @param md5 String
- * @return true if Update ok
+ * the update is written, tell the application and reboot if asked to
+ * @param http HTTPClient &
+ * @param spiffs bool
+ * @return HTTP_UPDATE_OK unless rebooting
  */
-bool ESP8266HTTPUpdate::runUpdate(Stream& in, uint32_t size, const String& md5, int command)
+HTTPUpdateResult ESP8266HTTPUpdate::updateDone(HTTPClient& http, bool spiffs)
 {
+    DEBUG_HTTP_UPDATE("[httpUpdate] Update ok\n");
+    http.end();
+    // Warn main app we're all done
+    if (_cbEnd) {
+        _cbEnd();
+    }
 
+#ifdef ATOMIC_FS_UPDATE
+    if(_rebootOnUpdate) {
+#else
+    if(_rebootOnUpdate && !spiffs) {
+#endif
+        ESP.restart();
+    }
+    return HTTP_UPDATE_OK;
+}
+
+/**
+ * check that the partial response continues the partial update
+ * @param http HTTPClient &
+ * @return true if Content-Range is bytes <offset>-<size - 1>/<size>
+ */
+bool ESP8266HTTPUpdate::rangeMatches(HTTPClient& http)
+{
+    unsigned long first, last, size;
+    if(sscanf(http.header("Content-Range").c_str(), "bytes %lu-%lu/%lu", &first, &last, &size) != 3) {
+        return false;
+    }
+    return first == _resume.offset && last + 1 == _resume.size && size == _resume.size;
+}
+
+/**
+ * write the image to the update begun, asking for the rest of it with a
+ * Range request whenever the connection drops or stalls
+ * @param http HTTPClient & with the response being read
+ * @param currentVersion const String &
+ * @param spiffs bool
+ * @return true if Update ok, false keeps a partial update unless it failed
+ */
+bool ESP8266HTTPUpdate::runResumable(HTTPClient& http, const String& currentVersion, bool spiffs)
+{
     StreamString error;
+    uint8_t attempts = _resumeAttempts;
+    esp8266::polledTimeout::oneShotMs timeout(_httpClientTimeout);
+
+    while(_resume.offset < _resume.size) {
+        // the same client is connected again for each request
+        size_t written = Update.write(*http.getStreamPtr());
+        if(Update.hasError()) {
+            _setLastError(Update.getError());
+            Update.printError(error);
+            error.trim(); // remove line ending
+            DEBUG_HTTP_UPDATE("[httpUpdate] Update.write failed! (%s)\n", error.c_str());
+            _resume = Resume();
+            return false;
+        }
+        if(written) {
+            _resume.offset += written;
+            timeout.reset();
+            if (_cbProgress) {
+                _cbProgress(_resume.offset, _resume.size);
+            }
+            continue;
+        }
+        if(http.connected() && !timeout) {
+            if(!Update.eraseAhead()) {
+                delay(1);
+            }
+            continue;
+        }
 
-    if (_cbProgress) {
-        Update.onProgress(_cbProgress);
+        // lost or stalled, the update stays for the next call if need be
+        if(!attempts) {
+            _setLastError(HTTPC_ERROR_CONNECTION_LOST);
+            return false;
+        }
+        attempts--;
+        DEBUG_HTTP_UPDATE("[httpUpdate] resuming at %u of %u\n", _resume.offset, _resume.size);
+        delay(100);
+        addRequestHeaders(http, currentVersion, spiffs);
+        http.addHeader(F("Range"), String(F("bytes=")) + _resume.offset + '-');
+        http.addHeader(F("If-Range"), _resume.validator);
+        int code = http.GET();
+        if(code <= 0) {
+            DEBUG_HTTP_UPDATE("[httpUpdate] HTTP error: %s\n", http.errorToString(code).c_str());
+            // not connected: the next attempt reconnects right away
+            timeout.reset();
+            continue;
+        }
+        if(code != HTTP_CODE_PARTIAL_CONTENT || !rangeMatches(http)) {
+            // changed on the server meanwhile
+            DEBUG_HTTP_UPDATE("[httpUpdate] cannot resume, HTTP Code is (%d)\n", code);
+            _setLastError(HTTP_UE_SERVER_WRONG_HTTP_CODE);
+            resetResume();
+            return false;
+        }
+        timeout.reset();
+    }
+
+    _resume = Resume();
+    if(!Update.end()) {
+        _setLastError(Update.getError());
+        Update.printError(error);
+        error.trim(); // remove line ending
+        DEBUG_HTTP_UPDATE("[httpUpdate] Update.end failed! (%s)\n", error.c_str());
+        return false;
     }
+    return true;
+}
+
+/**
+ * start writing an update
+ * @param size uint32_t
+ * @param md5 String
+ * @param command int
+ * @return true if Update began
+ */
+bool ESP8266HTTPUpdate::beginUpdate(uint32_t size, const String& md5, int command)
+{
+    StreamString error;
 
     if(!Update.begin(size, command, _ledPin, _ledOn)) {
         _setLastError(Update.getError());
@@ -515,6 +691,28 @@ bool ESP8266HTTPUpdate::runUpdate(Stream& in, uint32_t size, const String& md5,
             return false;
         }
     }
+    return true;
+}
+
+/**
+ * write Update to flash
+ * @param in Stream&
+ * @param size uint32_t
+ * @param md5 String
+ * @return true if Update ok
+ */
+bool ESP8266HTTPUpdate::runUpdate(Stream& in, uint32_t size, const String& md5, int command)
+{
+
+    StreamString error;
+
+    if (_cbProgress) {
+        Update.onProgress(_cbProgress);
+    }
+
+    if(!beginUpdate(size, md5, command)) {
+        return false;
+    }
 
     if(Update.writeStream(in) != size) {
         _setLastError(Update.getError());
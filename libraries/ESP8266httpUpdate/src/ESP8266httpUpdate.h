@@ -112,6 +112,28 @@ public:
         _ledOn = ledOn;
     }
 
+    /**
+     * resume an interrupted download with HTTP Range requests, at most
+     * attempts times per update call.  When the call still fails, the
+     * partial update is kept so that the next call resumes it as well.
+     * The server must give a strong ETag or a Last-Modified date, which
+     * If-Range checks: a changed image is downloaded again from the start.
+     * @param attempts 0 (default): start over every time
+     */
+    void setResume(uint8_t attempts)
+    {
+        _resumeAttempts = attempts;
+    }
+
+    // drops the partial update kept for resuming
+    void resetResume();
+
+    // bytes of the image already written by the partial update, 0 if none
+    size_t resumeOffset() const
+    {
+        return _resume.offset;
+    }
+
     void setAuthorization(const String& user, const String& password);
     void setAuthorization(const String& auth);
 
@@ -167,6 +189,13 @@ public:
 protected:
     t_httpUpdate_return handleUpdate(HTTPClient& http, const String& currentVersion, bool spiffs = false);
     bool runUpdate(Stream& in, uint32_t size, const String& md5, int command = U_FLASH);
+    bool beginUpdate(uint32_t size, const String& md5, int command);
+    HTTPUpdateResult updateDone(HTTPClient& http, bool spiffs);
+
+    // resumable download, see setResume()
+    void addRequestHeaders(HTTPClient& http, const String& currentVersion, bool spiffs);
+    bool rangeMatches(HTTPClient& http);
+    bool runResumable(HTTPClient& http, const String& currentVersion, bool spiffs);
 
     // Set the error and potentially use a CB to notify the application
     void _setLastError(int err) {
@@ -194,6 +223,14 @@ private:
 
     int _ledPin = -1;
     uint8_t _ledOn;
+
+    uint8_t _resumeAttempts = 0;
+    struct Resume {
+        String validator;   // If-Range: ETag, or else Last-Modified
+        size_t offset = 0;  // bytes given to Update
+        size_t size = 0;    // whole image, 0 if nothing to resume
+        bool spiffs = false;
+    } _resume;
 };
 
 #if !defined(NO_GLOBAL_INSTANCES) && !defined(NO_GLOBAL_HTTPUPDATE)
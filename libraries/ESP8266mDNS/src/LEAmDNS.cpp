@@ -63,7 +63,11 @@ MDNSResponder::MDNSResponder(void)
         m_pUDPContext(0),
         m_pcHostname(0),
         m_pServiceQueries(0),
-        m_fnServiceTxtCallback(0)
+        m_fnServiceTxtCallback(0),
+        m_pAnswerCache(0),
+        m_pAnswerCapture(0),
+        m_i32RtcUserDataSlot(-1),
+        m_u8ProbeCount(MDNS_PROBE_COUNT)
 {
 }
 
@@ -78,6 +82,7 @@ MDNSResponder::~MDNSResponder(void)
     _releaseHostname();
     _releaseUDPContext();
     _releaseServices();
+    _releaseAnswerCache();
 }
 
 /*
@@ -180,6 +185,7 @@ bool MDNSResponder::setHostname(const char* p_pcHostname)
         {
             if (pService->m_bAutoName)
             {
+                _releaseAnswerCache();
                 bResult = pService->setName(p_pcHostname);
                 pService->m_ProbeInformation.m_ProbingStatus = ProbingStatus_ReadyToStart;
             }
@@ -303,6 +309,7 @@ bool MDNSResponder::setServiceName(const MDNSResponder::hMDNSService p_hService,
     bool    bResult = (((!p_pcInstanceName) ||
                         (MDNS_DOMAIN_LABEL_MAXLENGTH >= os_strlen(p_pcInstanceName))) &&
                        ((pService = _findService(p_hService))) &&
+                       (_releaseAnswerCache()) &&
                        (pService->setName(p_pcInstanceName)) &&
                        ((pService->m_ProbeInformation.m_ProbingStatus = ProbingStatus_ReadyToStart)));
     DEBUG_EX_ERR(if (!bResult)
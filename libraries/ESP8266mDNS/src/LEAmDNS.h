@@ -170,6 +170,23 @@ namespace MDNSImplementation
 */
 #define MDNS_UDPCONTEXT_TIMEOUT  50
 
+/*
+    Number of prepared answer messages kept for reuse
+*/
+#define MDNS_ANSWERCACHE_MAXITEMS       4
+/*
+    Answers are only cached for up to this many services
+*/
+#define MDNS_ANSWERCACHE_MAXSERVICES    8
+/*
+    Maximum size of a cached answer message
+*/
+#define MDNS_ANSWERCACHE_MAXLENGTH      1440
+/*
+    Maximum size of the known answer section of outgoing queries
+*/
+#define MDNS_KNOWNANSWERS_MAXLENGTH     1024
+
 /**
     MDNSResponder
 */
@@ -488,6 +505,19 @@ public:
     bool setServiceProbeResultCallback(const MDNSResponder::hMDNSService p_hService,
                                        MDNSServiceProbeFn1 p_fnCallback);
 
+    // Keep the last successfully probed host domain and the AP's BSSID in RTC user memory,
+    // starting at p_u32RtcUserDataSlot (4 words). When probing again for the same host domain
+    // on the same AP (eg. after deep sleep), only one probe is sent, without the initial
+    // random delay, and announcing starts at once.
+    void enableFastProbe(uint32_t p_u32RtcUserDataSlot)
+    {
+        m_i32RtcUserDataSlot = p_u32RtcUserDataSlot;
+    }
+    void disableFastProbe(void)
+    {
+        m_i32RtcUserDataSlot = -1;
+    }
+
     // Application should call this whenever AP is configured/disabled
     bool notifyAPChange(void);
 
@@ -1029,9 +1059,11 @@ protected:
                 uint32_t                          m_u32TTL;
                 esp8266::polledTimeout::oneShotMs m_TTLTimeout;
                 timeoutLevel_t                    m_timeoutLevel;
+                uint32_t                          m_u32SetTime;     // millis() at 'set'
 
                 stcTTL(void);
                 bool set(uint32_t p_u32TTL);
+                uint32_t remaining(void) const;
 
                 bool flagged(void);
                 bool restart(void);
@@ -1175,8 +1207,26 @@ protected:
         };
 
     public:
+        /**
+            stcKnownAnswer
+
+            A PTR answer already known for a service type query (RFC 6762, 7.1).
+        */
+        struct stcKnownAnswer
+        {
+            stcKnownAnswer*         m_pNext;
+            const stcMDNS_RRDomain* m_pServiceTypeDomain;   // eg. _http._tcp.local
+            const stcMDNS_RRDomain* m_pServiceDomain;       // eg. MyESP._http._tcp.local
+            uint32_t                m_u32TTL;               // Remaining TTL (seconds)
+
+            stcKnownAnswer(const stcMDNS_RRDomain& p_ServiceTypeDomain,
+                           const stcMDNS_RRDomain& p_ServiceDomain,
+                           uint32_t p_u32TTL);
+        };
+
         uint16_t                m_u16ID;                    // Query ID (used only in lagacy queries)
         stcMDNS_RRQuestion*     m_pQuestions;               // A list of queries
+        stcKnownAnswer*         m_pKnownAnswers;            // Known answers for the queries
         uint8_t                 m_u8HostReplyMask;          // Flags for reply components/answers
         bool                    m_bLegacyQuery;             // Flag: Legacy query
         bool                    m_bResponse;                // Flag: Response to a query
@@ -1195,6 +1245,10 @@ protected:
 
         bool shiftOffset(uint16_t p_u16Shift);
 
+        bool addKnownAnswer(const stcMDNS_RRDomain& p_ServiceTypeDomain,
+                            const stcMDNS_RRDomain& p_ServiceDomain,
+                            uint32_t p_u32TTL);
+
         bool addDomainCacheItem(const void* p_pHostnameOrService,
                                 bool p_bAdditionalData,
                                 uint16_t p_u16Offset);
@@ -1202,6 +1256,24 @@ protected:
                                         bool p_bAdditionalData) const;
     };
 
+    /**
+        stcMDNSAnswerCacheItem
+
+        A complete (wire format) answer message, as prepared by '_prepareMDNSMessage'.
+        The key holds everything that selects the content of the message: interface IP,
+        host reply mask, send flags and the reply masks of all services.
+    */
+    struct stcMDNSAnswerCacheItem
+    {
+        stcMDNSAnswerCacheItem* m_pNext;
+        uint8_t                 m_au8Key[4 + 1 + 1 + MDNS_ANSWERCACHE_MAXSERVICES];
+        uint8_t*                m_pu8Message;
+        uint16_t                m_u16Length;
+
+        stcMDNSAnswerCacheItem(const uint8_t* p_pu8Key);
+        ~stcMDNSAnswerCacheItem(void);
+    };
+
     // Instance variables
     stcMDNSService*                 m_pServices;
     UdpContext*                     m_pUDPContext;
@@ -1209,6 +1281,10 @@ protected:
     stcMDNSServiceQuery*            m_pServiceQueries;
     MDNSDynamicServiceTxtCallbackFunc m_fnServiceTxtCallback;
     stcProbeInformation             m_HostProbeInformation;
+    stcMDNSAnswerCacheItem*         m_pAnswerCache;
+    stcMDNSAnswerCacheItem*         m_pAnswerCapture;   // Answer message currently being recorded
+    int32_t                         m_i32RtcUserDataSlot;   // Known host record for fast probing, -1: off
+    uint8_t                         m_u8ProbeCount;     // MDNS_PROBE_COUNT, or 1 for a known host
 
     /** CONTROL **/
     /* MAINTENANCE */
@@ -1237,6 +1313,8 @@ protected:
     bool _updateProbeStatus(void);
     bool _resetProbeStatus(bool p_bRestart = true);
     bool _hasProbesWaitingForAnswers(void) const;
+    bool _isKnownHost(void) const;
+    void _saveKnownHost(bool p_bValid);
     bool _sendHostProbe(void);
     bool _sendServiceProbe(stcMDNSService& p_rService);
     bool _cancelProbingForHost(void);
@@ -1260,8 +1338,8 @@ protected:
                              IPAddress p_IPAddress);
     bool _sendMDNSServiceQuery(const stcMDNSServiceQuery& p_ServiceQuery);
     bool _sendMDNSQuery(const stcMDNS_RRDomain& p_QueryDomain,
-                        uint16_t p_u16QueryType,
-                        stcMDNSServiceQuery::stcAnswer* p_pKnownAnswers = 0);
+                        uint16_t p_u16QueryType);
+    bool _collectKnownAnswers(stcMDNSSendParameter& p_rSendParameter);
 
     uint8_t _replyMaskForHost(const stcMDNS_RRHeader& p_RRHeader,
                               bool* p_pbFullNameMatch = 0) const;
@@ -1380,6 +1458,8 @@ protected:
 #endif
     bool _writeMDNSAnswer_SRV(stcMDNSService& p_rService,
                               stcMDNSSendParameter& p_rSendParameter);
+    bool _writeMDNSKnownAnswer(const stcMDNSSendParameter::stcKnownAnswer& p_KnownAnswer,
+                               stcMDNSSendParameter& p_rSendParameter);
 
     /** HELPERS **/
     /* UDP CONTEXT */
@@ -1447,6 +1527,17 @@ protected:
                                           const char* p_pcService,
                                           const char* p_pcProtocol);
 
+    /* ANSWER CACHE */
+    bool _answerCacheKey(const stcMDNSSendParameter& p_SendParameter,
+                         IPAddress p_IPAddress,
+                         uint8_t* p_pu8Key) const;
+    stcMDNSAnswerCacheItem* _findAnswerCacheItem(const uint8_t* p_pu8Key);
+    bool _startAnswerCapture(const uint8_t* p_pu8Key);
+    bool _captureAnswer(const unsigned char* p_pcBuffer,
+                        size_t p_stLength);
+    bool _finishAnswerCapture(bool p_bSuccess);
+    bool _releaseAnswerCache(void);
+
     /* MISC */
 #if not defined ESP_8266_MDNS_INCLUDE || defined DEBUG_ESP_MDNS_RESPONDER
     bool _printRRDomain(const stcMDNS_RRDomain& p_rRRDomain) const;
@@ -28,6 +28,7 @@
 #include <lwip/ip_addr.h>
 #include <WString.h>
 #include <cstdint>
+#include <coredecls.h> // crc32()
 
 /*
     ESP8266mDNS Control.cpp
@@ -1218,15 +1219,26 @@ bool MDNSResponder::_updateProbeStatus(void)
     {
         DEBUG_EX_INFO(DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _updateProbeStatus: Starting host probing...\n")););
 
-        // First probe delay SHOULD be random 0-250 ms
-        m_HostProbeInformation.m_Timeout.reset(rand() % MDNS_PROBE_DELAY);
+        if (_isKnownHost())
+        {
+            // Claimed on this AP before: probe once, right now
+            DEBUG_EX_INFO(DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _updateProbeStatus: Known host, fast probing.\n")););
+            m_u8ProbeCount = 1;
+            m_HostProbeInformation.m_Timeout.reset(0);
+        }
+        else
+        {
+            m_u8ProbeCount = MDNS_PROBE_COUNT;
+            // First probe delay SHOULD be random 0-250 ms
+            m_HostProbeInformation.m_Timeout.reset(rand() % MDNS_PROBE_DELAY);
+        }
         m_HostProbeInformation.m_ProbingStatus = ProbingStatus_InProgress;
     }
     else if ((ProbingStatus_InProgress == m_HostProbeInformation.m_ProbingStatus) &&                // Probing AND
              (m_HostProbeInformation.m_Timeout.expired()))                                          // Time for next probe
     {
 
-        if (MDNS_PROBE_COUNT > m_HostProbeInformation.m_u8SentCount)                                // Send next probe
+        if (m_u8ProbeCount > m_HostProbeInformation.m_u8SentCount)                                  // Send next probe
         {
             if ((bResult = _sendHostProbe()))
             {
@@ -1245,9 +1257,10 @@ bool MDNSResponder::_updateProbeStatus(void)
                 m_HostProbeInformation.m_fnHostProbeResultCallback(m_pcHostname, true);
             }
 
-            // Prepare to announce host
+            // Prepare to announce host (at once, if fast probing)
             m_HostProbeInformation.m_u8SentCount = 0;
-            m_HostProbeInformation.m_Timeout.reset(MDNS_ANNOUNCE_DELAY);
+            m_HostProbeInformation.m_Timeout.reset((MDNS_PROBE_COUNT == m_u8ProbeCount) ? MDNS_ANNOUNCE_DELAY : 0);
+            _saveKnownHost(true);
             DEBUG_EX_INFO(DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _updateProbeStatus: Prepared host announcing.\n\n")););
         }
     }   // else: Probing already finished OR waiting for next time slot
@@ -1286,7 +1299,7 @@ bool MDNSResponder::_updateProbeStatus(void)
                  (pService->m_ProbeInformation.m_Timeout.expired()))               // Time for next probe
         {
 
-            if (MDNS_PROBE_COUNT > pService->m_ProbeInformation.m_u8SentCount)                  // Send next probe
+            if (m_u8ProbeCount > pService->m_ProbeInformation.m_u8SentCount)                    // Send next probe
             {
                 if ((bResult = _sendServiceProbe(*pService)))
                 {
@@ -1377,6 +1390,73 @@ bool MDNSResponder::_hasProbesWaitingForAnswers(void) const
     return bResult;
 }
 
+/*
+    MDNSResponder::_isKnownHost
+
+    Fast probing: the host domain was claimed before (see '_saveKnownHost') on the AP the
+    station is connected to now.
+*/
+namespace
+{
+struct stcMDNSKnownHost
+{
+    uint32_t    m_u32CRC;           // Of the following fields
+    uint32_t    m_u32HostnameCRC;
+    uint8_t     m_au8BSSID[6];
+    uint8_t     m_au8Reserved[2];
+
+    void set(const char* p_pcHostname)
+    {
+        m_u32HostnameCRC = crc32(p_pcHostname, strlen(p_pcHostname));
+        memcpy(m_au8BSSID, WiFi.BSSID(), sizeof(m_au8BSSID));
+        m_au8Reserved[0] = m_au8Reserved[1] = 0;
+        m_u32CRC = crc32(&m_u32HostnameCRC, sizeof(*this) - sizeof(m_u32CRC));
+    }
+};
+}
+
+bool MDNSResponder::_isKnownHost(void) const
+{
+
+    if ((0 > m_i32RtcUserDataSlot) ||
+            (!m_pcHostname) ||
+            (WL_CONNECTED != WiFi.status()))
+    {
+        return false;
+    }
+    stcMDNSKnownHost    saved;
+    stcMDNSKnownHost    current;
+    current.set(m_pcHostname);
+    return ((ESP.rtcUserMemoryRead(m_i32RtcUserDataSlot, reinterpret_cast<uint32_t*>(&saved), sizeof(saved))) &&
+            (0 == memcmp(&saved, &current, sizeof(saved))));
+}
+
+/*
+    MDNSResponder::_saveKnownHost
+
+    Records (or forgets, after a conflict) the host domain for fast probing.
+*/
+void MDNSResponder::_saveKnownHost(bool p_bValid)
+{
+
+    if ((0 > m_i32RtcUserDataSlot) ||
+            (!m_pcHostname))
+    {
+        return;
+    }
+    stcMDNSKnownHost    known;
+    if ((p_bValid) &&
+            (WL_CONNECTED == WiFi.status()))
+    {
+        known.set(m_pcHostname);
+    }
+    else
+    {
+        memset(&known, 0, sizeof(known));
+    }
+    ESP.rtcUserMemoryWrite(m_i32RtcUserDataSlot, reinterpret_cast<uint32_t*>(&known), sizeof(known));
+}
+
 /*
     MDNSResponder::_sendHostProbe
 
@@ -1492,6 +1572,7 @@ bool MDNSResponder::_cancelProbingForHost(void)
     bool    bResult = false;
 
     m_HostProbeInformation.clear(false);
+    _saveKnownHost(false);
     // Send host notification
     if (m_HostProbeInformation.m_fnHostProbeResultCallback)
     {
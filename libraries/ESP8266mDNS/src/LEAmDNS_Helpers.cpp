@@ -193,6 +193,7 @@ bool MDNSResponder::_allocUDPContext(void)
 bool MDNSResponder::_releaseUDPContext(void)
 {
 
+    _releaseAnswerCache();
     if (m_pUDPContext)
     {
         m_pUDPContext->unref();
@@ -390,6 +391,7 @@ bool MDNSResponder::_setHostname(const char* p_pcHostname)
 bool MDNSResponder::_releaseHostname(void)
 {
 
+    _releaseAnswerCache();
     if (m_pcHostname)
     {
         delete[] m_pcHostname;
@@ -432,6 +434,7 @@ MDNSResponder::stcMDNSService* MDNSResponder::_allocService(const char* p_pcName
         // Add to list (or start list)
         pService->m_pNext = m_pServices;
         m_pServices = pService;
+        _releaseAnswerCache();
     }
     return pService;
 }
@@ -446,6 +449,7 @@ bool MDNSResponder::_releaseService(MDNSResponder::stcMDNSService* p_pService)
 
     if (p_pService)
     {
+        _releaseAnswerCache();
         stcMDNSService* pPred = m_pServices;
         while ((pPred) &&
                 (pPred->m_pNext != p_pService))
@@ -579,6 +583,7 @@ MDNSResponder::stcMDNSServiceTxt* MDNSResponder::_allocServiceTxt(MDNSResponder:
 
             // Add to list (or start list)
             p_pService->m_Txts.add(pTxt);
+            _releaseAnswerCache();
         }
     }
     return pTxt;
@@ -591,6 +596,7 @@ bool MDNSResponder::_releaseServiceTxt(MDNSResponder::stcMDNSService* p_pService
                                        MDNSResponder::stcMDNSServiceTxt* p_pTxt)
 {
 
+    _releaseAnswerCache();
     return ((p_pService) &&
             (p_pTxt) &&
             (p_pService->m_Txts.remove(p_pTxt)));
@@ -613,6 +619,7 @@ MDNSResponder::stcMDNSServiceTxt* MDNSResponder::_updateServiceTxt(MDNSResponder
     {
         p_pTxt->update(p_pcValue);
         p_pTxt->m_bTemp = p_bTemp;
+        _releaseAnswerCache();
     }
     return p_pTxt;
 }
@@ -702,6 +709,195 @@ bool MDNSResponder::_releaseTempServiceTxts(MDNSResponder::stcMDNSService& p_rSe
 }
 
 
+/*
+    ANSWER CACHE
+*/
+
+/*
+    MDNSResponder::_answerCacheKey
+
+    Builds the cache key for the answer message described by p_SendParameter.
+    Only plain (no questions, no legacy ID) responses are cached, and only if no
+    dynamic TXT callbacks are set, as these may change the TXTs for every message.
+
+*/
+bool MDNSResponder::_answerCacheKey(const MDNSResponder::stcMDNSSendParameter& p_SendParameter,
+                                    IPAddress p_IPAddress,
+                                    uint8_t* p_pu8Key) const
+{
+
+    bool    bResult = ((p_SendParameter.m_bResponse) &&
+                       (!p_SendParameter.m_pQuestions) &&
+                       (!p_SendParameter.m_u16ID) &&
+                       (!m_fnServiceTxtCallback));
+
+    if (bResult)
+    {
+        memset(p_pu8Key, 0, sizeof(stcMDNSAnswerCacheItem::m_au8Key));
+        uint32_t    u32IPAddress = (uint32_t)p_IPAddress;
+        memcpy(p_pu8Key, &u32IPAddress, sizeof(u32IPAddress));
+        p_pu8Key[4] = p_SendParameter.m_u8HostReplyMask;
+        p_pu8Key[5] = ((p_SendParameter.m_bLegacyQuery ? 0x01 : 0) |
+                       (p_SendParameter.m_bAuthorative ? 0x02 : 0) |
+                       (p_SendParameter.m_bCacheFlush ? 0x04 : 0) |
+                       (p_SendParameter.m_bUnicast ? 0x08 : 0) |
+                       (p_SendParameter.m_bUnannounce ? 0x10 : 0));
+
+        size_t  stIndex = 6;
+        for (stcMDNSService* pService = m_pServices; ((bResult) && (pService)); pService = pService->m_pNext)
+        {
+            bResult = ((stIndex < sizeof(stcMDNSAnswerCacheItem::m_au8Key)) &&
+                       (!pService->m_fnTxtCallback));
+            if (bResult)
+            {
+                p_pu8Key[stIndex++] = pService->m_u8ReplyMask;
+            }
+        }
+    }
+    return bResult;
+}
+
+/*
+    MDNSResponder::_findAnswerCacheItem
+*/
+MDNSResponder::stcMDNSAnswerCacheItem* MDNSResponder::_findAnswerCacheItem(const uint8_t* p_pu8Key)
+{
+
+    stcMDNSAnswerCacheItem* pItem = m_pAnswerCache;
+    while ((pItem) &&
+            (0 != memcmp(pItem->m_au8Key, p_pu8Key, sizeof(pItem->m_au8Key))))
+    {
+        pItem = pItem->m_pNext;
+    }
+    return pItem;
+}
+
+/*
+    MDNSResponder::_startAnswerCapture
+
+    Starts recording all bytes appended to the UDP output buffer (see '_udpAppendBuffer').
+
+*/
+bool MDNSResponder::_startAnswerCapture(const uint8_t* p_pu8Key)
+{
+
+    if (m_pAnswerCapture)
+    {
+        delete m_pAnswerCapture;
+    }
+    m_pAnswerCapture = new stcMDNSAnswerCacheItem(p_pu8Key);
+    if ((m_pAnswerCapture) &&
+            (!((m_pAnswerCapture->m_pu8Message = new uint8_t[MDNS_ANSWERCACHE_MAXLENGTH]))))
+    {
+        delete m_pAnswerCapture;
+        m_pAnswerCapture = 0;
+    }
+    return (0 != m_pAnswerCapture);
+}
+
+/*
+    MDNSResponder::_captureAnswer
+
+    Adds the given bytes to the answer message being recorded.
+    Too long messages are not cached at all.
+
+*/
+bool MDNSResponder::_captureAnswer(const unsigned char* p_pcBuffer,
+                                   size_t p_stLength)
+{
+
+    if (m_pAnswerCapture)
+    {
+        if ((m_pAnswerCapture->m_u16Length + p_stLength) <= MDNS_ANSWERCACHE_MAXLENGTH)
+        {
+            memcpy(m_pAnswerCapture->m_pu8Message + m_pAnswerCapture->m_u16Length, p_pcBuffer, p_stLength);
+            m_pAnswerCapture->m_u16Length += p_stLength;
+        }
+        else
+        {
+            delete m_pAnswerCapture;
+            m_pAnswerCapture = 0;
+        }
+    }
+    return true;
+}
+
+/*
+    MDNSResponder::_finishAnswerCapture
+
+    Stores the recorded answer message (if complete) in the answer cache.
+    The cache is kept in MRU order and limited to MDNS_ANSWERCACHE_MAXITEMS items.
+
+*/
+bool MDNSResponder::_finishAnswerCapture(bool p_bSuccess)
+{
+
+    bool    bResult = false;
+
+    if ((p_bSuccess) &&
+            (m_pAnswerCapture) &&
+            (m_pAnswerCapture->m_u16Length))
+    {
+        // Shrink the buffer to the message size
+        uint8_t*    pu8Message = new uint8_t[m_pAnswerCapture->m_u16Length];
+        if (pu8Message)
+        {
+            memcpy(pu8Message, m_pAnswerCapture->m_pu8Message, m_pAnswerCapture->m_u16Length);
+            delete[] m_pAnswerCapture->m_pu8Message;
+            m_pAnswerCapture->m_pu8Message = pu8Message;
+
+            m_pAnswerCapture->m_pNext = m_pAnswerCache;
+            m_pAnswerCache = m_pAnswerCapture;
+            m_pAnswerCapture = 0;
+
+            // Drop the oldest items
+            stcMDNSAnswerCacheItem* pItem = m_pAnswerCache;
+            for (uint32_t u = 1; ((pItem) && (u < MDNS_ANSWERCACHE_MAXITEMS)); ++u)
+            {
+                pItem = pItem->m_pNext;
+            }
+            while ((pItem) &&
+                    (pItem->m_pNext))
+            {
+                stcMDNSAnswerCacheItem* pNext = pItem->m_pNext->m_pNext;
+                delete pItem->m_pNext;
+                pItem->m_pNext = pNext;
+            }
+            bResult = true;
+        }
+    }
+    if (m_pAnswerCapture)
+    {
+        delete m_pAnswerCapture;
+        m_pAnswerCapture = 0;
+    }
+    return bResult;
+}
+
+/*
+    MDNSResponder::_releaseAnswerCache
+
+    Needs to be called, whenever the content of answers may change (hostname, services, TXTs).
+
+*/
+bool MDNSResponder::_releaseAnswerCache(void)
+{
+
+    while (m_pAnswerCache)
+    {
+        stcMDNSAnswerCacheItem* pNext = m_pAnswerCache->m_pNext;
+        delete m_pAnswerCache;
+        m_pAnswerCache = pNext;
+    }
+    if (m_pAnswerCapture)
+    {
+        delete m_pAnswerCapture;
+        m_pAnswerCapture = 0;
+    }
+    return true;
+}
+
+
 /*
     MISC
 */
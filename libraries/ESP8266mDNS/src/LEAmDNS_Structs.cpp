@@ -1579,7 +1579,8 @@ bool MDNSResponder::stcMDNSService::releaseProtocol(void)
 MDNSResponder::stcMDNSServiceQuery::stcAnswer::stcTTL::stcTTL(void)
     :   m_u32TTL(0),
         m_TTLTimeout(esp8266::polledTimeout::oneShotMs::neverExpires),
-        m_timeoutLevel(TIMEOUTLEVEL_UNSET)
+        m_timeoutLevel(TIMEOUTLEVEL_UNSET),
+        m_u32SetTime(0)
 {
 
 }
@@ -1591,6 +1592,7 @@ bool MDNSResponder::stcMDNSServiceQuery::stcAnswer::stcTTL::set(uint32_t p_u32TT
 {
 
     m_u32TTL = p_u32TTL;
+    m_u32SetTime = millis();
     if (m_u32TTL)
     {
         m_timeoutLevel = TIMEOUTLEVEL_BASE;             // Set to 80%
@@ -1604,6 +1606,18 @@ bool MDNSResponder::stcMDNSServiceQuery::stcAnswer::stcTTL::set(uint32_t p_u32TT
     return true;
 }
 
+/*
+    MDNSResponder::stcMDNSServiceQuery::stcAnswer::stcTTL::remaining
+
+    The remaining TTL (in seconds), based on the time of the last 'set'.
+*/
+uint32_t MDNSResponder::stcMDNSServiceQuery::stcAnswer::stcTTL::remaining(void) const
+{
+
+    uint32_t    u32Elapsed = ((millis() - m_u32SetTime) / 1000);
+    return ((u32Elapsed < m_u32TTL) ? (m_u32TTL - u32Elapsed) : 0);
+}
+
 /*
     MDNSResponder::stcMDNSServiceQuery::stcAnswer::stcTTL::flagged
 */
@@ -2360,6 +2374,27 @@ MDNSResponder::stcMDNSSendParameter::stcDomainCacheItem::stcDomainCacheItem(cons
 
 }
 
+/**
+    MDNSResponder::stcMDNSSendParameter::stcKnownAnswer
+
+    A known PTR answer to be included in a query.
+
+*/
+
+/*
+    MDNSResponder::stcMDNSSendParameter::stcKnownAnswer::stcKnownAnswer constructor
+*/
+MDNSResponder::stcMDNSSendParameter::stcKnownAnswer::stcKnownAnswer(const stcMDNS_RRDomain& p_ServiceTypeDomain,
+        const stcMDNS_RRDomain& p_ServiceDomain,
+        uint32_t p_u32TTL)
+    :   m_pNext(0),
+        m_pServiceTypeDomain(&p_ServiceTypeDomain),
+        m_pServiceDomain(&p_ServiceDomain),
+        m_u32TTL(p_u32TTL)
+{
+
+}
+
 /**
     MDNSResponder::stcMDNSSendParameter
 */
@@ -2369,6 +2404,7 @@ MDNSResponder::stcMDNSSendParameter::stcDomainCacheItem::stcDomainCacheItem(cons
 */
 MDNSResponder::stcMDNSSendParameter::stcMDNSSendParameter(void)
     :   m_pQuestions(0),
+        m_pKnownAnswers(0),
         m_pDomainCacheItems(0)
 {
 
@@ -2409,6 +2445,13 @@ bool MDNSResponder::stcMDNSSendParameter::clear(void)
         m_pQuestions = pNext;
     }
 
+    while (m_pKnownAnswers)
+    {
+        stcKnownAnswer* pNext = m_pKnownAnswers->m_pNext;
+        delete m_pKnownAnswers;
+        m_pKnownAnswers = pNext;
+    }
+
     return clearCachedNames();;
 }
 /*
@@ -2440,6 +2483,31 @@ bool MDNSResponder::stcMDNSSendParameter::shiftOffset(uint16_t p_u16Shift)
     return true;
 }
 
+/*
+    MDNSResponder::stcMDNSSendParameter::addKnownAnswer
+*/
+bool MDNSResponder::stcMDNSSendParameter::addKnownAnswer(const stcMDNS_RRDomain& p_ServiceTypeDomain,
+        const stcMDNS_RRDomain& p_ServiceDomain,
+        uint32_t p_u32TTL)
+{
+
+    bool    bResult = false;
+
+    stcKnownAnswer* pNewItem = new stcKnownAnswer(p_ServiceTypeDomain, p_ServiceDomain, p_u32TTL);
+    if (pNewItem)
+    {
+        // Append, to keep the order of the service queries
+        stcKnownAnswer** ppLast = &m_pKnownAnswers;
+        while (*ppLast)
+        {
+            ppLast = &((*ppLast)->m_pNext);
+        }
+        *ppLast = pNewItem;
+        bResult = true;
+    }
+    return bResult;
+}
+
 /*
     MDNSResponder::stcMDNSSendParameter::addDomainCacheItem
 */
@@ -2482,6 +2550,39 @@ uint16_t MDNSResponder::stcMDNSSendParameter::findCachedDomainOffset(const void*
     return (pCacheItem ? pCacheItem->m_u16Offset : 0);
 }
 
+
+/**
+    MDNSResponder::stcMDNSAnswerCacheItem
+
+    A prepared answer message for reuse.
+
+*/
+
+/*
+    MDNSResponder::stcMDNSAnswerCacheItem::stcMDNSAnswerCacheItem constructor
+*/
+MDNSResponder::stcMDNSAnswerCacheItem::stcMDNSAnswerCacheItem(const uint8_t* p_pu8Key)
+    :   m_pNext(0),
+        m_pu8Message(0),
+        m_u16Length(0)
+{
+
+    memcpy(m_au8Key, p_pu8Key, sizeof(m_au8Key));
+}
+
+/*
+    MDNSResponder::stcMDNSAnswerCacheItem::~stcMDNSAnswerCacheItem destructor
+*/
+MDNSResponder::stcMDNSAnswerCacheItem::~stcMDNSAnswerCacheItem(void)
+{
+
+    if (m_pu8Message)
+    {
+        delete[] m_pu8Message;
+        m_pu8Message = 0;
+    }
+}
+
 }   // namespace MDNSImplementation
 
 } // namespace esp8266
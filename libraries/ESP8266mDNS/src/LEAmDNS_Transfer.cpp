@@ -166,6 +166,21 @@ bool MDNSResponder::_prepareMDNSMessage(MDNSResponder::stcMDNSSendParameter& p_r
     bool    bResult = true;
     p_rSendParameter.clearCachedNames(); // Need to remove cached names, p_SendParameter might have been used before on other interface
 
+    // Answers (announcements) are mostly the same for every query, so reuse a prepared message if possible
+    uint8_t au8CacheKey[sizeof(stcMDNSAnswerCacheItem::m_au8Key)];
+    bool    bCacheable = _answerCacheKey(p_rSendParameter, p_IPAddress, au8CacheKey);
+    if (bCacheable)
+    {
+        const stcMDNSAnswerCacheItem*   pCacheItem = _findAnswerCacheItem(au8CacheKey);
+        if (pCacheItem)
+        {
+            DEBUG_EX_INFO(DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _prepareMDNSMessage: Using cached answer (%u bytes)\n"), pCacheItem->m_u16Length););
+            return ((_udpAppendBuffer(pCacheItem->m_pu8Message, pCacheItem->m_u16Length)) &&
+                    (p_rSendParameter.shiftOffset(pCacheItem->m_u16Length)));
+        }
+        _startAnswerCapture(au8CacheKey);
+    }
+
     // Prepare header; count answers
     stcMDNS_MsgHeader  msgHeader(p_rSendParameter.m_u16ID, p_rSendParameter.m_bResponse, 0, p_rSendParameter.m_bAuthorative);
     // If this is a response, the answers are anwers,
@@ -213,6 +228,14 @@ bool MDNSResponder::_prepareMDNSMessage(MDNSResponder::stcMDNSSendParameter& p_r
              : (bResult = _writeMDNSQuestion(*pQuestion, p_rSendParameter)));
             DEBUG_EX_ERR(if (!bResult) DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _prepareMDNSMessage: _writeMDNSQuestion FAILED!\n")););
         }
+        // Known answers (queries only)
+        for (const stcMDNSSendParameter::stcKnownAnswer* pKnownAnswer = p_rSendParameter.m_pKnownAnswers; ((bResult) && (pKnownAnswer)); pKnownAnswer = pKnownAnswer->m_pNext)
+        {
+            ((Sequence_Count == sequence)
+             ? ++msgHeader.m_u16ANCount
+             : (bResult = _writeMDNSKnownAnswer(*pKnownAnswer, p_rSendParameter)));
+            DEBUG_EX_ERR(if (!bResult) DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _prepareMDNSMessage: _writeMDNSKnownAnswer FAILED!\n")););
+        }
 
         // Answers and authoritative answers
 #ifdef MDNS_IP4_SUPPORT
@@ -359,6 +382,10 @@ bool MDNSResponder::_prepareMDNSMessage(MDNSResponder::stcMDNSSendParameter& p_r
 #endif
         DEBUG_EX_ERR(if (!bResult) DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _prepareMDNSMessage: Loop %i FAILED!\n"), sequence););
     }   // for sequence
+    if (bCacheable)
+    {
+        _finishAnswerCapture(bResult);
+    }
     DEBUG_EX_ERR(if (!bResult) DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _prepareMDNSMessage: FAILED!\n")););
     return bResult;
 }
@@ -382,8 +409,7 @@ bool MDNSResponder::_sendMDNSServiceQuery(const MDNSResponder::stcMDNSServiceQue
 
 */
 bool MDNSResponder::_sendMDNSQuery(const MDNSResponder::stcMDNS_RRDomain& p_QueryDomain,
-                                   uint16_t p_u16QueryType,
-                                   stcMDNSServiceQuery::stcAnswer* p_pKnownAnswers /*= 0*/)
+                                   uint16_t p_u16QueryType)
 {
 
     bool                    bResult = false;
@@ -397,15 +423,65 @@ bool MDNSResponder::_sendMDNSQuery(const MDNSResponder::stcMDNS_RRDomain& p_Quer
         // It seems, that some mDNS implementations don't support 'unicast response' questions...
         sendParameter.m_pQuestions->m_Header.m_Attributes.m_u16Class = (/*0x8000 |*/ DNS_RRCLASS_IN);   // /*Unicast &*/ INternet
 
-        // TODO: Add known answer to the query
-        (void)p_pKnownAnswers;
-
-        bResult = _sendMDNSMessage(sendParameter);
+        bResult = ((_collectKnownAnswers(sendParameter)) &&
+                   (_sendMDNSMessage(sendParameter)));
     }   // else: FAILED to alloc question
     DEBUG_EX_ERR(if (!bResult) DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _sendMDNSQuery: FAILED to alloc question!\n")););
     return bResult;
 }
 
+/*
+    MDNSResponder::_collectKnownAnswers
+
+    Adds the already known answers for all PTR (service type) questions to the send parameter,
+    so responders don't need to answer again (known-answer suppression, see RFC 6762, 7.1).
+    If several service queries exist for the same service type, they share one query, so
+    only answers known to all of them are included.
+    Only answers with more than half of their TTL left are included, and the known-answer
+    section is limited to MDNS_KNOWNANSWERS_MAXLENGTH bytes.
+
+*/
+bool MDNSResponder::_collectKnownAnswers(MDNSResponder::stcMDNSSendParameter& p_rSendParameter)
+{
+
+    bool    bResult = true;
+    size_t  stLength = 0;
+
+    for (stcMDNS_RRQuestion* pQuestion = p_rSendParameter.m_pQuestions; ((bResult) && (pQuestion)); pQuestion = pQuestion->m_pNext)
+    {
+        const stcMDNS_RRDomain& serviceTypeDomain = pQuestion->m_Header.m_Domain;
+        stcMDNSServiceQuery*    pFirstServiceQuery = ((DNS_RRTYPE_PTR == pQuestion->m_Header.m_Attributes.m_u16Type)
+                                                      ? _findNextServiceQueryByServiceType(serviceTypeDomain, 0)
+                                                      : 0);
+        for (stcMDNSServiceQuery::stcAnswer* pSQAnswer = (pFirstServiceQuery ? pFirstServiceQuery->m_pAnswers : 0); ((bResult) && (pSQAnswer)); pSQAnswer = pSQAnswer->m_pNext)
+        {
+            uint32_t    u32TTL = pSQAnswer->m_TTLServiceDomain.remaining();
+            bool        bKnown = ((pSQAnswer->m_u32ContentFlags & ServiceQueryAnswerType_ServiceDomain) &&
+                                  (!pSQAnswer->m_TTLServiceDomain.finalTimeoutLevel()) &&     // Not about to be deleted
+                                  ((pSQAnswer->m_TTLServiceDomain.m_u32TTL / 2) < u32TTL));   // More than half of the TTL left
+            for (stcMDNSServiceQuery* pServiceQuery = _findNextServiceQueryByServiceType(serviceTypeDomain, pFirstServiceQuery); ((bKnown) && (pServiceQuery)); pServiceQuery = _findNextServiceQueryByServiceType(serviceTypeDomain, pServiceQuery))
+            {
+                bKnown = (0 != pServiceQuery->findAnswerForServiceDomain(pSQAnswer->m_ServiceDomain));
+            }
+            if (bKnown)
+            {
+                size_t  stAnswerLength = (serviceTypeDomain.m_u16NameLength +
+                                          10 +                                      // TYPE, CLASS, TTL, RDLength
+                                          pSQAnswer->m_ServiceDomain.m_u16NameLength);
+                if (MDNS_KNOWNANSWERS_MAXLENGTH < (stLength + stAnswerLength))
+                {
+                    DEBUG_EX_INFO(DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _collectKnownAnswers: Known-answer section full!\n")););
+                    return true;
+                }
+                stLength += stAnswerLength;
+                bResult = p_rSendParameter.addKnownAnswer(serviceTypeDomain, pSQAnswer->m_ServiceDomain, u32TTL);
+            }
+        }
+    }
+    DEBUG_EX_ERR(if (!bResult) DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _collectKnownAnswers: FAILED!\n")););
+    return bResult;
+}
+
 /**
     HELPERS
 */
@@ -1103,7 +1179,8 @@ bool MDNSResponder::_udpAppendBuffer(const unsigned char* p_pcBuffer,
     bool bResult = ((m_pUDPContext) &&
                     (p_pcBuffer) &&
                     (p_stLength) &&
-                    (p_stLength == m_pUDPContext->append((const char*)p_pcBuffer, p_stLength)));
+                    (p_stLength == m_pUDPContext->append((const char*)p_pcBuffer, p_stLength)) &&
+                    (_captureAnswer(p_pcBuffer, p_stLength)));
     DEBUG_EX_ERR(if (!bResult)
 {
     DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _udpAppendBuffer: FAILED!\n"));
@@ -1606,6 +1683,33 @@ bool MDNSResponder::_writeMDNSAnswer_PTR_NAME(MDNSResponder::stcMDNSService& p_r
 }
 
 
+/*
+    MDNSResponder::_writeMDNSKnownAnswer
+
+    Write a known PTR answer (for a service type query) to the UDP output buffer.
+    The TTL is the remaining TTL of the answer.
+
+    eg. _http._tcp.local PTR IN 4500 xx MyESP._http._tcp.local
+*/
+bool MDNSResponder::_writeMDNSKnownAnswer(const MDNSResponder::stcMDNSSendParameter::stcKnownAnswer& p_KnownAnswer,
+        MDNSResponder::stcMDNSSendParameter& p_rSendParameter)
+{
+    DEBUG_EX_INFO(DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _writeMDNSKnownAnswer\n")););
+
+    stcMDNS_RRAttributes    attributes(DNS_RRTYPE_PTR, DNS_RRCLASS_IN);	// No cache flush! only INternet
+    bool    bResult = ((_writeMDNSRRDomain(*p_KnownAnswer.m_pServiceTypeDomain, p_rSendParameter)) &&       // _http._tcp.local
+                       (_writeMDNSRRAttributes(attributes, p_rSendParameter)) &&                            // TYPE & CLASS
+                       (_write32(p_KnownAnswer.m_u32TTL, p_rSendParameter)) &&                              // TTL
+                       (_write16(p_KnownAnswer.m_pServiceDomain->m_u16NameLength, p_rSendParameter)) &&     // RDLength
+                       (_writeMDNSRRDomain(*p_KnownAnswer.m_pServiceDomain, p_rSendParameter)));            // RData (eg. MyESP._http._tcp.local)
+
+    DEBUG_EX_ERR(if (!bResult)
+{
+    DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _writeMDNSKnownAnswer: FAILED!\n"));
+    });
+    return bResult;
+}
+
 /*
     MDNSResponder::_writeMDNSAnswer_TXT
 
@@ -1641,12 +1745,14 @@ bool MDNSResponder::_writeMDNSAnswer_TXT(MDNSResponder::stcMDNSService& p_rServi
             unsigned char       ucLengthByte = pTxt->length();
             bResult = ((_udpAppendBuffer((unsigned char*)&ucLengthByte, sizeof(ucLengthByte))) &&   // Length
                        (p_rSendParameter.shiftOffset(sizeof(ucLengthByte))) &&
-                       ((size_t)os_strlen(pTxt->m_pcKey) == m_pUDPContext->append(pTxt->m_pcKey, os_strlen(pTxt->m_pcKey))) &&          // Key
+                       ((!*pTxt->m_pcKey) ||
+                        (_udpAppendBuffer((const unsigned char*)pTxt->m_pcKey, os_strlen(pTxt->m_pcKey)))) &&                           // Key
                        (p_rSendParameter.shiftOffset((size_t)os_strlen(pTxt->m_pcKey))) &&
-                       (1 == m_pUDPContext->append("=", 1)) &&                                                                          // =
+                       (_udpAppendBuffer((const unsigned char*)"=", 1)) &&                                                          // =
                        (p_rSendParameter.shiftOffset(1)) &&
                        ((!pTxt->m_pcValue) ||
-                        (((size_t)os_strlen(pTxt->m_pcValue) == m_pUDPContext->append(pTxt->m_pcValue, os_strlen(pTxt->m_pcValue))) &&  // Value
+                        (!*pTxt->m_pcValue) ||
+                        ((_udpAppendBuffer((const unsigned char*)pTxt->m_pcValue, os_strlen(pTxt->m_pcValue))) &&                       // Value
                          (p_rSendParameter.shiftOffset((size_t)os_strlen(pTxt->m_pcValue))))));
 
             DEBUG_EX_ERR(if (!bResult)
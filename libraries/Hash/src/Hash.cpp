@@ -23,10 +23,59 @@
  */
 
 #include <Arduino.h>
-#include <bearssl/bearssl_hash.h>
 
 #include "Hash.h"
 
+/*
+ * SHA-1 with the 80 rounds unrolled over a 16 word message schedule,
+ * after the public domain implementation by Steve Reid.  BearSSL keeps
+ * all 80 schedule words and loops, which costs more loads and stores on
+ * the lx106 than the rotating register assignment below.
+ */
+namespace {
+
+inline uint32_t sha1_rol(uint32_t x, uint32_t n) {
+    return (x << n) | (x >> (32 - n));
+}
+
+inline uint32_t sha1_load(const uint8_t* p) {
+    return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+}
+
+#define SHA1_BLK0(i) (w[i] = sha1_load(data + 4 * (i)))
+#define SHA1_BLK(i) (w[(i) & 15] = sha1_rol(w[((i) + 13) & 15] ^ w[((i) + 8) & 15] ^ w[((i) + 2) & 15] ^ w[(i) & 15], 1))
+#define SHA1_R0(v, x, y, z, u, i) u += ((x & (y ^ z)) ^ z) + SHA1_BLK0(i) + 0x5a827999 + sha1_rol(v, 5); x = sha1_rol(x, 30);
+#define SHA1_R1(v, x, y, z, u, i) u += ((x & (y ^ z)) ^ z) + SHA1_BLK(i) + 0x5a827999 + sha1_rol(v, 5); x = sha1_rol(x, 30);
+#define SHA1_R2(v, x, y, z, u, i) u += (x ^ y ^ z) + SHA1_BLK(i) + 0x6ed9eba1 + sha1_rol(v, 5); x = sha1_rol(x, 30);
+#define SHA1_R3(v, x, y, z, u, i) u += (((x | y) & z) | (x & y)) + SHA1_BLK(i) + 0x8f1bbcdc + sha1_rol(v, 5); x = sha1_rol(x, 30);
+#define SHA1_R4(v, x, y, z, u, i) u += (x ^ y ^ z) + SHA1_BLK(i) + 0xca62c1d6 + sha1_rol(v, 5); x = sha1_rol(x, 30);
+// five rounds, after which the variables are back in place
+#define SHA1_R5(R, i) \
+    R(a, b, c, d, e, (i)) R(e, a, b, c, d, (i) + 1) R(d, e, a, b, c, (i) + 2) \
+    R(c, d, e, a, b, (i) + 3) R(b, c, d, e, a, (i) + 4)
+
+void sha1_blocks(uint32_t state[5], const uint8_t* data, size_t blocks) {
+    uint32_t w[16];
+    for (; blocks; --blocks, data += 64) {
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+
+        SHA1_R5(SHA1_R0, 0) SHA1_R5(SHA1_R0, 5) SHA1_R5(SHA1_R0, 10)
+        SHA1_R0(a, b, c, d, e, 15) SHA1_R1(e, a, b, c, d, 16) SHA1_R1(d, e, a, b, c, 17)
+        SHA1_R1(c, d, e, a, b, 18) SHA1_R1(b, c, d, e, a, 19)
+        SHA1_R5(SHA1_R2, 20) SHA1_R5(SHA1_R2, 25) SHA1_R5(SHA1_R2, 30) SHA1_R5(SHA1_R2, 35)
+        SHA1_R5(SHA1_R3, 40) SHA1_R5(SHA1_R3, 45) SHA1_R5(SHA1_R3, 50) SHA1_R5(SHA1_R3, 55)
+        SHA1_R5(SHA1_R4, 60) SHA1_R5(SHA1_R4, 65) SHA1_R5(SHA1_R4, 70) SHA1_R5(SHA1_R4, 75)
+
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+    }
+}
+
+} // namespace
+
 /**
  * create a sha1 hash from data
  * @param data uint8_t *
@@ -34,7 +83,7 @@
  * @param hash uint8_t[20]
  */
 void sha1(const uint8_t* data, uint32_t size, uint8_t hash[20]) {
-    br_sha1_context ctx;
+    uint32_t state[5] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0 };
 
 #ifdef DEBUG_SHA1
     os_printf("DATA:");
@@ -49,9 +98,26 @@ void sha1(const uint8_t* data, uint32_t size, uint8_t hash[20]) {
     os_printf("\n");
 #endif
 
-    br_sha1_init(&ctx);
-    br_sha1_update(&ctx, data, size);
-    br_sha1_out(&ctx, hash);
+    sha1_blocks(state, data, size / 64);
+
+    // the rest of the data, 0x80, zeros, and the length in bits
+    uint8_t tail[128] = { 0 };
+    const uint32_t rest = size % 64;
+    memcpy(tail, data + size - rest, rest);
+    tail[rest] = 0x80;
+    const uint32_t tailSize = rest < 56 ? 64 : 128;
+    const uint64_t bits = (uint64_t)size << 3;
+    for (uint32_t i = 0; i < 8; i++) {
+        tail[tailSize - 1 - i] = bits >> (8 * i);
+    }
+    sha1_blocks(state, tail, tailSize / 64);
+
+    for (uint32_t i = 0; i < 5; i++) {
+        hash[4 * i] = state[i] >> 24;
+        hash[4 * i + 1] = state[i] >> 16;
+        hash[4 * i + 2] = state[i] >> 8;
+        hash[4 * i + 3] = state[i];
+    }
 
 #ifdef DEBUG_SHA1
     os_printf("SHA1:");
@@ -0,0 +1,221 @@
+/*
+  I2SMixer.cpp - Fixed point mixer and resampler feeding the I2S DMA
+  This file is part of the esp8266 core for Arduino environment.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <Arduino.h>
+#include <math.h>
+#include <string.h>
+#include <core_esp8266_i2s.h>
+#include "I2SMixer.h"
+
+static constexpr uint32_t ONE = 1 << 16;
+
+I2SMixer::I2SMixer(uint32_t outputRate) {
+  _rate = outputRate;
+  memset(_src, 0, sizeof(_src));
+  _outLen = 0;
+  _outPos = 0;
+}
+
+I2SMixer::~I2SMixer() {
+  for (int i = 0; i < I2SMIXER_MAX_SOURCES; i++) {
+    removeSource(i);
+  }
+}
+
+// Windowed sinc, one row per fractional position.  Every row is scaled to a
+// DC gain of exactly 1.0 in Q15 so constant input has no phase ripple.
+int16_t *I2SMixer::_makeFilter(float cutoff) {
+  const int phases = 1 << PHASE_BITS;
+  int16_t *coef = (int16_t *)malloc(phases * TAPS * sizeof(int16_t));
+  if (!coef) {
+    return nullptr;
+  }
+  for (int p = 0; p < phases; p++) {
+    float row[TAPS];
+    float sum = 0;
+    for (int k = 0; k < TAPS; k++) {
+      // Output lies between hist[TAPS/2 - 1] and hist[TAPS/2]
+      float x = (k - (TAPS / 2 - 1)) - (float)p / phases;
+      float sinc = (x == 0) ? 1.0f : sinf(M_PI * cutoff * x) / (M_PI * cutoff * x);
+      float window = 0.5f + 0.5f * cosf(M_PI * x / (TAPS / 2));
+      row[k] = sinc * window;
+      sum += row[k];
+    }
+    int total = 0;
+    for (int k = 0; k < TAPS; k++) {
+      coef[p * TAPS + k] = (int16_t)lrintf(row[k] / sum * 32767);
+      total += coef[p * TAPS + k];
+    }
+    // Put the rounding error on the center tap
+    coef[p * TAPS + TAPS / 2 - 1] += 32767 - total;
+  }
+  return coef;
+}
+
+int I2SMixer::addSource(ReadFn fn, void *arg, uint32_t rate, bool stereo) {
+  if (!fn || !rate) {
+    return -1;
+  }
+  for (int id = 0; id < I2SMIXER_MAX_SOURCES; id++) {
+    if (_src[id]) {
+      continue;
+    }
+    Source *s = (Source *)calloc(1, sizeof(Source));
+    if (!s) {
+      return -1;
+    }
+    s->fn = fn;
+    s->arg = arg;
+    s->stereo = stereo;
+    s->step = (uint32_t)(((uint64_t)rate << 16) / _rate);
+    s->gain = s->gainTarget = ONE;
+    if (s->step != ONE) {
+      // Pass band up to the lower of the two Nyquist rates, with some margin
+      float cutoff = (rate < _rate) ? 0.9f : 0.9f * _rate / rate;
+      s->coef = _makeFilter(cutoff);
+      if (!s->coef) {
+        free(s);
+        return -1;
+      }
+    }
+    _src[id] = s;
+    return id;
+  }
+  return -1;
+}
+
+void I2SMixer::removeSource(int id) {
+  if (id < 0 || id >= I2SMIXER_MAX_SOURCES || !_src[id]) {
+    return;
+  }
+  free(_src[id]->coef);
+  free(_src[id]);
+  _src[id] = nullptr;
+}
+
+void I2SMixer::setVolume(int id, float volume, uint32_t rampMs) {
+  if (id < 0 || id >= I2SMIXER_MAX_SOURCES || !_src[id]) {
+    return;
+  }
+  Source *s = _src[id];
+  volume = constrain(volume, 0.0f, 1.0f);
+  s->gainTarget = (int32_t)(volume * ONE);
+  uint32_t frames = (uint64_t)_rate * rampMs / 1000;
+  if (!frames) {
+    s->gain = s->gainTarget;
+    s->gainStep = 0;
+    return;
+  }
+  s->gainStep = (s->gainTarget - s->gain) / (int32_t)frames;
+  if (!s->gainStep) {
+    s->gainStep = (s->gainTarget > s->gain) ? 1 : -1;
+  }
+}
+
+void I2SMixer::_push(Source &s) {
+  if (s.inPos >= s.inLen) {
+    s.inLen = s.fn(s.arg, s.in, BLOCK);
+    s.inPos = 0;
+  }
+  int16_t ch0 = 0;
+  int16_t ch1 = 0;
+  if (s.inPos < s.inLen) {
+    if (s.stereo) {
+      ch0 = s.in[s.inPos * 2];
+      ch1 = s.in[s.inPos * 2 + 1];
+    } else {
+      ch0 = ch1 = s.in[s.inPos];
+    }
+    s.inPos++;
+  }
+  memmove(&s.hist[0][0], &s.hist[0][1], (TAPS - 1) * sizeof(int16_t));
+  memmove(&s.hist[1][0], &s.hist[1][1], (TAPS - 1) * sizeof(int16_t));
+  s.hist[0][TAPS - 1] = ch0;
+  s.hist[1][TAPS - 1] = ch1;
+}
+
+void I2SMixer::_next(Source &s, int16_t &ch0, int16_t &ch1) {
+  if (!s.coef) {
+    // Same rate, no filtering
+    _push(s);
+    ch0 = s.hist[0][TAPS - 1];
+    ch1 = s.hist[1][TAPS - 1];
+    return;
+  }
+  while (s.pos >= ONE) {
+    _push(s);
+    s.pos -= ONE;
+  }
+  const int16_t *c = s.coef + (s.pos >> (16 - PHASE_BITS)) * TAPS;
+  int32_t acc0 = 0;
+  int32_t acc1 = 0;
+  for (int k = 0; k < TAPS; k++) {
+    acc0 += s.hist[0][k] * c[k];
+    acc1 += s.hist[1][k] * c[k];
+  }
+  ch0 = constrain(acc0 >> 15, -32768, 32767);
+  ch1 = constrain(acc1 >> 15, -32768, 32767);
+  s.pos += s.step;
+}
+
+void I2SMixer::mix(int16_t *frames, size_t count) {
+  memset(frames, 0, count * 2 * sizeof(int16_t));
+  for (int id = 0; id < I2SMIXER_MAX_SOURCES; id++) {
+    Source *s = _src[id];
+    if (!s) {
+      continue;
+    }
+    for (size_t i = 0; i < count; i++) {
+      int16_t ch0, ch1;
+      _next(*s, ch0, ch1);
+      if (s->gainStep) {
+        s->gain += s->gainStep;
+        if ((s->gainStep > 0) == (s->gain >= s->gainTarget)) {
+          s->gain = s->gainTarget;
+          s->gainStep = 0;
+        }
+      }
+      int32_t m0 = frames[i * 2] + ((ch0 * s->gain) >> 16);
+      int32_t m1 = frames[i * 2 + 1] + ((ch1 * s->gain) >> 16);
+      frames[i * 2] = constrain(m0, -32768, 32767);
+      frames[i * 2 + 1] = constrain(m1, -32768, 32767);
+    }
+  }
+}
+
+size_t I2SMixer::pump() {
+  // i2s_write_buffer_nb() needs a running transmitter, only TX sets a non zero count
+  if (!i2s_available()) {
+    return 0;
+  }
+  size_t queued = 0;
+  for (;;) {
+    if (_outPos == _outLen) {
+      mix(_out, BLOCK);
+      _outLen = BLOCK;
+      _outPos = 0;
+    }
+    uint16_t n = i2s_write_buffer_nb(_out + _outPos * 2, _outLen - _outPos);
+    _outPos += n;
+    queued += n;
+    if (_outPos < _outLen) {
+      return queued;
+    }
+  }
+}
@@ -0,0 +1,89 @@
+/*
+  I2SMixer.h - Fixed point mixer and resampler feeding the I2S DMA
+  This file is part of the esp8266 core for Arduino environment.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef _I2SMIXER_H_INCLUDED
+#define _I2SMIXER_H_INCLUDED
+
+#include <Arduino.h>
+
+#define I2SMIXER_MAX_SOURCES 4
+
+// Mixes up to I2SMIXER_MAX_SOURCES PCM streams into 16 bit stereo frames at
+// the output rate.  Sources are pulled through a callback and may run at any
+// rate, sources at another rate than the output go through an 8 tap, 32
+// phase polyphase FIR.  All the arithmetic is Q15 with int32 accumulators.
+//
+// Frames are pairs of int16_t in the order i2s_write_buffer() takes them;
+// mono sources are copied to both channels.
+class I2SMixer
+{
+public:
+  // Fill up to 'count' frames (interleaved for stereo sources) and return
+  // how many were written.  Returning fewer, even 0, is an underrun of that
+  // source only, which is mixed as silence.
+  typedef size_t (*ReadFn)(void *arg, int16_t *frames, size_t count);
+
+  I2SMixer(uint32_t outputRate = 44100);
+  ~I2SMixer();
+
+  // Returns the source id, or -1 if all slots are used or out of memory
+  int addSource(ReadFn fn, void *arg, uint32_t rate, bool stereo);
+  void removeSource(int id);
+  // volume 0.0 ... 1.0, reached linearly over rampMs
+  void setVolume(int id, float volume, uint32_t rampMs = 0);
+
+  // Render 'count' stereo frames
+  void mix(int16_t *frames, size_t count);
+  // Feed the I2S DMA with as much as it takes without blocking, call it
+  // often from loop().  Returns the number of frames queued.
+  size_t pump();
+
+protected:
+  static constexpr int TAPS = 8;
+  static constexpr int PHASE_BITS = 5;
+  static constexpr int BLOCK = 32; // frames read from a source at once
+
+  struct Source {
+    ReadFn   fn;
+    void    *arg;
+    bool     stereo;
+    uint32_t step;       // input frames per output frame, Q16
+    uint32_t pos;        // position between history and next input, Q16
+    int32_t  gain;       // Q16
+    int32_t  gainTarget;
+    int32_t  gainStep;
+    int16_t *coef;       // (1 << PHASE_BITS) x TAPS, Q15
+    int16_t  hist[2][TAPS];
+    int16_t  in[BLOCK * 2];
+    uint16_t inLen;
+    uint16_t inPos;
+  };
+
+  static int16_t *_makeFilter(float cutoff);
+  void _next(Source &s, int16_t &ch0, int16_t &ch1);
+  void _push(Source &s);
+
+  uint32_t _rate;
+  Source  *_src[I2SMIXER_MAX_SOURCES];
+  int16_t  _out[BLOCK * 2];
+  uint16_t _outLen;
+  uint16_t _outPos;
+};
+
+#endif
@@ -0,0 +1,164 @@
+/*
+  I2SSerial.cpp - Transmit only UART on the I2S data pin
+  This file is part of the esp8266 core for Arduino environment.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <Arduino.h>
+#include <core_esp8266_i2s.h>
+#include "I2SSerial.h"
+
+#define I2SSERIAL_BUFFERS 4
+
+I2SSerial *I2SSerial::_active = nullptr;
+
+static inline IRAM_ATTR uint32_t reverse8(uint32_t b) {
+  b = ((b & 0xF0) >> 4) | ((b & 0x0F) << 4);
+  b = ((b & 0xCC) >> 2) | ((b & 0x33) << 2);
+  return ((b & 0xAA) >> 1) | ((b & 0x55) << 1);
+}
+
+I2SSerial::I2SSerial(size_t fifoSize) {
+  _fifo = nullptr;
+  _fifoSize = fifoSize < 16 ? 16 : fifoSize;
+  _head = 0;
+  _tail = 0;
+  _ringUs = 0;
+}
+
+I2SSerial::~I2SSerial() {
+  end();
+}
+
+bool I2SSerial::begin(uint32_t baud) {
+  if (_active || baud < 9600 || baud > 2000000) {
+    return false;
+  }
+  _fifo = (uint8_t *)malloc(_fifoSize);
+  if (!_fifo) {
+    return false;
+  }
+  _head = _tail = 0;
+  // Around 1ms per buffer, every word holds 32 bits
+  uint16_t words = constrain(baud / 32000, 16, 1023);
+  if (!i2s_set_bits(16) || !i2s_set_buffers(I2SSERIAL_BUFFERS, words)) {
+    end();
+    return false;
+  }
+  _active = this;
+  i2s_set_refill_callback(_refill);
+  // Only the data pin, the clocks run inside the peripheral
+  if (!i2s_rxtxdrive_begin(false, true, false, false)) {
+    end();
+    return false;
+  }
+  i2s_set_rate(baud / 32);
+  float real = i2s_get_real_rate() * 32;
+  if (fabsf(real - baud) > baud * 0.02f) {
+    end();
+    return false;
+  }
+  _ringUs = (uint64_t)I2SSERIAL_BUFFERS * words * 32 * 1000000 / (uint32_t)real;
+  return true;
+}
+
+void I2SSerial::end() {
+  if (_active == this) {
+    i2s_end();
+    i2s_set_refill_callback(nullptr);
+    _active = nullptr;
+  }
+  free(_fifo);
+  _fifo = nullptr;
+}
+
+// Runs from the SLC interrupt.  A byte only starts if all its 10 bits fit in
+// this buffer, the rest is idle (high) line.
+IRAM_ATTR void I2SSerial::_refill(uint32_t *buf, uint16_t words) {
+  I2SSerial *s = _active;
+  uint32_t bits = words * 32;
+  uint32_t word = 0;
+  uint32_t used = 0;  // bits in 'word'
+  uint32_t out = 0;   // words written
+  size_t tail = s ? s->_tail : 0;
+  while (s && tail != s->_head && bits >= 10) {
+    // start bit 0, 8 data bits LSB first, stop bit 1; the MSB goes out first
+    uint32_t frame = (reverse8(s->_fifo[tail]) << 1) | 1;
+    uint32_t left = 32 - used;
+    if (left >= 10) {
+      word |= frame << (left - 10);
+      used += 10;
+    } else {
+      word |= frame >> (10 - left);
+      buf[out++] = word;
+      word = frame << (32 - (10 - left));
+      used = 10 - left;
+    }
+    if (used == 32) {
+      buf[out++] = word;
+      word = 0;
+      used = 0;
+    }
+    bits -= 10;
+    tail = (tail + 1) % s->_fifoSize;
+  }
+  if (s) {
+    s->_tail = tail;
+  }
+  if (used) {
+    buf[out++] = word | (0xFFFFFFFF >> used);
+  }
+  while (out < words) {
+    buf[out++] = 0xFFFFFFFF;
+  }
+}
+
+size_t I2SSerial::write(uint8_t c) {
+  return write(&c, 1);
+}
+
+size_t I2SSerial::write(const uint8_t *buffer, size_t size) {
+  if (_active != this) {
+    return 0;
+  }
+  for (size_t i = 0; i < size; i++) {
+    size_t next = (_head + 1) % _fifoSize;
+    while (next == _tail) {
+      yield();
+    }
+    _fifo[_head] = buffer[i];
+    _head = next;
+  }
+  return size;
+}
+
+int I2SSerial::availableForWrite() {
+  if (_active != this) {
+    return 0;
+  }
+  return (_tail + _fifoSize - _head - 1) % _fifoSize;
+}
+
+void I2SSerial::flush() {
+  if (_active != this) {
+    return;
+  }
+  while (_tail != _head) {
+    yield();
+  }
+  // The last bytes were just put into a buffer that goes out within a ring
+  delay(_ringUs / 1000 + 1);
+}
@@ -0,0 +1,64 @@
+/*
+  I2SSerial.h - Transmit only UART on the I2S data pin
+  This file is part of the esp8266 core for Arduino environment.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef _I2SSERIAL_H_INCLUDED
+#define _I2SSERIAL_H_INCLUDED
+
+#include <Arduino.h>
+
+// 8N1 output on GPIO3 (I2SO_DATA, also U0RXD, so Serial can only send
+// while this runs) with the I2S bit clock as the baud clock.  Bytes go to a
+// FIFO and are expanded into start, data and stop bits by the I2S DMA
+// interrupt as it frees buffers, so the CPU never times bits.  The bit
+// clock is 160MHz / n for an integer n, begin() fails when the nearest one
+// is more than 2% off the requested baud rate.  Up to 2Mbaud is supported.
+//
+// Bytes leave the pin a few DMA buffers after they are written, about 4ms
+// at 1Mbaud and 15ms at 115200.  Only one instance can run, and it owns the
+// I2S transmitter.
+class I2SSerial : public Print
+{
+public:
+  I2SSerial(size_t fifoSize = 256);
+  ~I2SSerial();
+
+  bool begin(uint32_t baud);
+  void end();
+
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t *buffer, size_t size) override;
+  int availableForWrite() override;
+  // Wait until every written byte has left the pin
+  void flush() override;
+
+  using Print::write;
+
+protected:
+  static void _refill(uint32_t *buf, uint16_t words);
+
+  static I2SSerial *_active;
+
+  uint8_t *_fifo;
+  size_t   _fifoSize;
+  volatile size_t _head; // written by the application
+  volatile size_t _tail; // consumed by the interrupt
+  uint32_t _ringUs;      // time for the DMA to go round all buffers
+};
+
+#endif
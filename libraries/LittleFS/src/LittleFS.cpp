@@ -24,6 +24,8 @@
 #include <Arduino.h>
 #include <stdlib.h>
 #include <algorithm>
+#include <new>
+#include <Schedule.h>
 #include "LittleFS.h"
 #include "debug.h"
 #include "flash_hal.h"
@@ -168,6 +170,9 @@ int LittleFSImpl::lfs_flash_read(const struct lfs_config *c,
     lfs_block_t block, lfs_off_t off, void *dst, lfs_size_t size) {
     LittleFSImpl *me = reinterpret_cast<LittleFSImpl*>(c->context);
     uint32_t addr = me->_start + (block * me->_blockSize) + off;
+    if (me->_blockCache) {
+        return me->_blockCacheRead(addr, static_cast<uint8_t*>(dst), size);
+    }
     return flash_hal_read(addr, size, static_cast<uint8_t*>(dst)) == FLASH_HAL_OK ? 0 : -1;
 }
 
@@ -176,14 +181,138 @@ int LittleFSImpl::lfs_flash_prog(const struct lfs_config *c,
     LittleFSImpl *me = reinterpret_cast<LittleFSImpl*>(c->context);
     uint32_t addr = me->_start + (block * me->_blockSize) + off;
     const uint8_t *src = reinterpret_cast<const uint8_t *>(buffer);
-    return flash_hal_write(addr, size, static_cast<const uint8_t*>(src)) == FLASH_HAL_OK ? 0 : -1;
+    if (flash_hal_write(addr, size, static_cast<const uint8_t*>(src)) != FLASH_HAL_OK) {
+        me->_blockCacheInvalidate(addr, size);
+        return -1;
+    }
+    me->_blockCacheUpdate(addr, src, size);
+    me->_setErased(block, false);
+    me->_written = true;
+    return 0;
 }
 
 int LittleFSImpl::lfs_flash_erase(const struct lfs_config *c, lfs_block_t block) {
     LittleFSImpl *me = reinterpret_cast<LittleFSImpl*>(c->context);
     uint32_t addr = me->_start + (block * me->_blockSize);
     uint32_t size = me->_blockSize;
-    return flash_hal_erase(addr, size) == FLASH_HAL_OK ? 0 : -1;
+    if (me->_erased && (me->_erased[block / 8] & (1 << (block % 8)))) {
+        // Still blank since gc() erased it
+        return 0;
+    }
+    me->_blockCacheInvalidate(addr, size);
+    if (flash_hal_erase(addr, size) != FLASH_HAL_OK) {
+        return -1;
+    }
+    // The allocator moves through the blocks in order, gc() continues here
+    me->_eraseNext = (block + 1) % me->_lfs_cfg.block_count;
+    me->_setErased(block, true);
+    return 0;
+}
+
+void LittleFSImpl::_setErased(lfs_block_t block, bool erased) {
+    if (!_erased) {
+        return;
+    }
+    const uint8_t bit = 1 << (block % 8);
+    if (erased && !(_erased[block / 8] & bit)) {
+        _erased[block / 8] |= bit;
+        _erasedCount++;
+    } else if (!erased && (_erased[block / 8] & bit)) {
+        _erased[block / 8] &= ~bit;
+        _erasedCount--;
+    }
+}
+
+int LittleFSImpl::_markUsed(void *used, lfs_block_t block) {
+    static_cast<uint8_t*>(used)[block / 8] |= 1 << (block % 8);
+    return 0;
+}
+
+bool LittleFSImpl::gc() {
+    return _eraseFree(LITTLEFS_GC_ERASE_BLOCKS) >= 0;
+}
+
+// Erases up to blocks free blocks not erased yet, returns how many or -1
+int LittleFSImpl::_eraseFree(uint32_t blocks) {
+    if (!_mounted || !_erased) {
+        return -1;
+    }
+    const lfs_size_t count = _lfs_cfg.block_count;
+    uint8_t *used = new (std::nothrow) uint8_t[(count + 7) / 8];
+    if (!used) {
+        return -1;
+    }
+    memset(used, 0, (count + 7) / 8);
+    int rc = lfs_fs_traverse(&_lfs, _markUsed, used);
+    if (rc < 0) {
+        DEBUGV("lfs_fs_traverse rc=%d\n", rc);
+        delete[] used;
+        return -1;
+    }
+    uint32_t erased = 0;
+    for (lfs_size_t i = 0; i < count && erased < blocks; i++) {
+        lfs_block_t block = (_eraseNext + i) % count;
+        const uint8_t bit = 1 << (block % 8);
+        if ((used[block / 8] & bit) || (_erased[block / 8] & bit)) {
+            continue;
+        }
+        uint32_t addr = _start + (block * _blockSize);
+        _blockCacheInvalidate(addr, _blockSize);
+        if (flash_hal_erase(addr, _blockSize) != FLASH_HAL_OK) {
+            delete[] used;
+            return -1;
+        }
+        _setErased(block, true);
+        erased++;
+    }
+    delete[] used;
+    return erased;
+}
+
+void LittleFSImpl::_startMaintenance() {
+    _stopMaintenance();
+    if (!_cfg._maintenanceBlocks || !_erased) {
+        return;
+    }
+    _maintenanceAlive = std::make_shared<bool>(true);
+    std::shared_ptr<bool> alive = _maintenanceAlive;
+    schedule_recurrent_function_us([this, alive]() {
+        if (!*alive) {
+            return false;
+        }
+        _maintenance();
+        return true;
+    }, _cfg._maintenanceIntervalMs * 1000);
+}
+
+void LittleFSImpl::_stopMaintenance() {
+    if (_maintenanceAlive) {
+        *_maintenanceAlive = false;
+        _maintenanceAlive.reset();
+    }
+}
+
+// One step per call so loop() is never held for long: a block erase while
+// the pool is short, otherwise a compaction pass if anything was written
+void LittleFSImpl::_maintenance() {
+    if (_erasedCount < _cfg._maintenanceBlocks) {
+        if (_eraseFree(1) > 0) {
+            return;
+        }
+        // no free block left to erase, fall through
+    }
+    if (!_written) {
+        return;
+    }
+#if LFS_VERSION >= 0x00020009
+    // rewrites metadata pairs past compact_thresh, and fills the lookahead
+    int rc = lfs_fs_gc(&_lfs);
+    if (rc < 0) {
+        DEBUGV("lfs_fs_gc rc=%d\n", rc);
+    }
+#endif
+    // after the pass, its own progs do not call for another
+    _written = false;
 }
 
 int LittleFSImpl::lfs_flash_sync(const struct lfs_config *c) {
@@ -192,6 +321,105 @@ int LittleFSImpl::lfs_flash_sync(const struct lfs_config *c) {
     return 0;
 }
 
+void LittleFSImpl::_blockCacheAlloc() {
+    if (_blockCache || !_cfg._blockCacheLines) {
+        return;
+    }
+    _blockCache = new (std::nothrow) BlockCacheLine[_cfg._blockCacheLines];
+    _blockCacheData = new (std::nothrow) uint8_t[(size_t)_cfg._blockCacheLines * _cfg._blockCacheLineSize];
+    if (!_blockCache || !_blockCacheData) {
+        DEBUGV("LittleFS: no memory for block cache, running uncached\n");
+        _blockCacheFree();
+        return;
+    }
+    for (uint32_t i = 0; i < _cfg._blockCacheLines; i++) {
+        _blockCache[i].addr = ~0U;
+        _blockCache[i].lastUse = 0;
+    }
+}
+
+void LittleFSImpl::_blockCacheFree() {
+    delete[] _blockCache;
+    delete[] _blockCacheData;
+    _blockCache = nullptr;
+    _blockCacheData = nullptr;
+}
+
+int LittleFSImpl::_blockCacheRead(uint32_t addr, uint8_t *dst, uint32_t size) {
+    const uint32_t lineSize = _cfg._blockCacheLineSize;
+    while (size) {
+        uint32_t lineAddr = addr & ~(lineSize - 1);
+        uint32_t lineOff = addr - lineAddr;
+        uint32_t len = std::min(size, lineSize - lineOff);
+
+        BlockCacheLine *victim = &_blockCache[0];
+        BlockCacheLine *hit = nullptr;
+        for (uint32_t i = 0; i < _cfg._blockCacheLines; i++) {
+            BlockCacheLine *line = &_blockCache[i];
+            if (line->addr == lineAddr) {
+                hit = line;
+                break;
+            }
+            if (line->addr == ~0U || (victim->addr != ~0U && line->lastUse < victim->lastUse)) {
+                victim = line;
+            }
+        }
+
+        if (!hit && len == lineSize) {
+            // Whole line wanted (e.g. large sequential reads), don't evict others for it
+            if (flash_hal_read(addr, len, dst) != FLASH_HAL_OK) {
+                return -1;
+            }
+        } else {
+            if (!hit) {
+                hit = victim;
+                hit->addr = ~0U;
+                if (flash_hal_read(lineAddr, lineSize, _blockCacheData + (hit - _blockCache) * lineSize) != FLASH_HAL_OK) {
+                    return -1;
+                }
+                hit->addr = lineAddr;
+            }
+            hit->lastUse = ++_blockCacheTick;
+            memcpy(dst, _blockCacheData + (hit - _blockCache) * lineSize + lineOff, len);
+        }
+
+        addr += len;
+        dst += len;
+        size -= len;
+    }
+    return 0;
+}
+
+void LittleFSImpl::_blockCacheUpdate(uint32_t addr, const uint8_t *src, uint32_t size) {
+    if (!_blockCache) {
+        return;
+    }
+    // Keep cached lines in step with what was just programmed
+    const uint32_t lineSize = _cfg._blockCacheLineSize;
+    for (uint32_t i = 0; i < _cfg._blockCacheLines; i++) {
+        uint32_t lineAddr = _blockCache[i].addr;
+        if (lineAddr == ~0U || lineAddr + lineSize <= addr || lineAddr >= addr + size) {
+            continue;
+        }
+        uint32_t from = std::max(lineAddr, addr);
+        uint32_t to = std::min(lineAddr + lineSize, addr + size);
+        memcpy(_blockCacheData + i * lineSize + (from - lineAddr), src + (from - addr), to - from);
+    }
+}
+
+void LittleFSImpl::_blockCacheInvalidate(uint32_t addr, uint32_t size) {
+    if (!_blockCache) {
+        return;
+    }
+    const uint32_t lineSize = _cfg._blockCacheLineSize;
+    for (uint32_t i = 0; i < _cfg._blockCacheLines; i++) {
+        uint32_t lineAddr = _blockCache[i].addr;
+        if (lineAddr != ~0U && lineAddr + lineSize > addr && lineAddr < addr + size) {
+            _blockCache[i].addr = ~0U;
+        }
+    }
+}
+
 
 }; // namespace
 
@@ -28,6 +28,7 @@
 #define __LITTLEFS_H
 
 #include <limits>
+#include <new>
 #include <FS.h>
 #include <FSImpl.h>
 #include <debug.h>
@@ -37,6 +38,11 @@
 #define LFS_NAME_MAX 32
 #include "../lib/littlefs/lfs.h"
 
+// Number of free blocks each LittleFS.gc() call erases ahead of time
+#ifndef LITTLEFS_GC_ERASE_BLOCKS
+#define LITTLEFS_GC_ERASE_BLOCKS 1
+#endif
+
 using namespace fs;
 
 namespace littlefs_impl {
@@ -49,6 +55,55 @@ class LittleFSConfig : public FSConfig
 public:
     static constexpr uint32_t FSId = 0x4c495454;
     LittleFSConfig(bool autoFormat = true) : FSConfig(FSId, autoFormat) { }
+
+    LittleFSConfig setAutoFormat(bool val = true) {
+        _autoFormat = val;
+        return *this;
+    }
+    // lfs_config sizes. cacheSize is also the size of the buffer each open file allocates,
+    // it must be a multiple of readSize and progSize and a factor of the block size.
+    // lookaheadSize must be a multiple of 8.
+    LittleFSConfig setReadSize(uint16_t size) {
+        _readSize = size;
+        return *this;
+    }
+    LittleFSConfig setProgSize(uint16_t size) {
+        _progSize = size;
+        return *this;
+    }
+    LittleFSConfig setCacheSize(uint16_t size) {
+        _cacheSize = size;
+        return *this;
+    }
+    LittleFSConfig setLookaheadSize(uint16_t size) {
+        _lookaheadSize = size;
+        return *this;
+    }
+    // LRU cache of flash reads shared by all open files, lines * lineSize bytes, 0 lines = disabled.
+    // lineSize must be a power of two and a factor of the block size.
+    LittleFSConfig setBlockCache(uint16_t lines, uint16_t lineSize = 256) {
+        _blockCacheLines = lines;
+        _blockCacheLineSize = lineSize;
+        return *this;
+    }
+    // Maintenance run by the scheduler every intervalMs while mounted: keeps
+    // erasedBlocks free blocks erased ahead of time, then compacts metadata
+    // after writes (littlefs 2.9 and later).  0 blocks = disabled.
+    LittleFSConfig setMaintenance(uint16_t erasedBlocks, uint32_t intervalMs = 1000) {
+        _maintenanceBlocks = erasedBlocks;
+        _maintenanceIntervalMs = intervalMs;
+        return *this;
+    }
+
+    // Inherit _type and _autoFormat
+    uint16_t _readSize = 64;
+    uint16_t _progSize = 64;
+    uint16_t _cacheSize = 64;
+    uint16_t _lookaheadSize = 64;
+    uint16_t _blockCacheLines = 0;
+    uint16_t _blockCacheLineSize = 256;
+    uint16_t _maintenanceBlocks = 0;
+    uint32_t _maintenanceIntervalMs = 1000;
 };
 
 class LittleFSImpl : public FSImpl
@@ -80,9 +135,12 @@ public:
     }
 
     ~LittleFSImpl() {
+        _stopMaintenance();
         if (_mounted) {
             lfs_unmount(&_lfs);
         }
+        _blockCacheFree();
+        delete[] _erased;
     }
 
     FileImplPtr open(const char* path, OpenMode openMode, AccessMode accessMode) override;
@@ -176,8 +234,25 @@ public:
         if ((cfg._type != LittleFSConfig::FSId) || _mounted) {
             return false;
         }
-        _cfg = *static_cast<const LittleFSConfig *>(&cfg);
-       return true;
+        const LittleFSConfig& lcfg = *static_cast<const LittleFSConfig *>(&cfg);
+        if (!lcfg._readSize || !lcfg._progSize || !lcfg._cacheSize
+            || (lcfg._cacheSize % lcfg._readSize) || (lcfg._cacheSize % lcfg._progSize)
+            || (_blockSize % lcfg._cacheSize) || !lcfg._lookaheadSize || (lcfg._lookaheadSize % 8)) {
+            DEBUGV("LittleFS: invalid read/prog/cache/lookahead sizes\n");
+            return false;
+        }
+        if (lcfg._blockCacheLines && (!lcfg._blockCacheLineSize || (lcfg._blockCacheLineSize & (lcfg._blockCacheLineSize - 1))
+                                      || (_blockSize % lcfg._blockCacheLineSize))) {
+            DEBUGV("LittleFS: invalid block cache line size\n");
+            return false;
+        }
+        _cfg = lcfg;
+        _lfs_cfg.read_size = _cfg._readSize;
+        _lfs_cfg.prog_size = _cfg._progSize;
+        _lfs_cfg.cache_size = _cfg._cacheSize;
+        _lfs_cfg.lookahead_size = _cfg._lookaheadSize;
+        _blockCacheFree();
+        return true;
     }
 
     bool begin() override {
@@ -198,10 +273,17 @@ public:
         if (!_mounted) {
             return;
         }
+        _stopMaintenance();
         lfs_unmount(&_lfs);
         _mounted = false;
+        _blockCacheFree();
+        delete[] _erased;
+        _erased = nullptr;
     }
 
+    // Pre-erase a few free blocks so later writes don't wait for the erase
+    bool gc() override;
+
     bool format() override {
         if (_size == 0) {
             DEBUGV("lfs size is zero\n");
@@ -210,6 +292,7 @@ public:
 
         bool wasMounted = _mounted;
         if (_mounted) {
+            _stopMaintenance();
             lfs_unmount(&_lfs);
             _mounted = false;
         }
@@ -261,6 +344,10 @@ public:
         }
     }
 
+    bool dirCacheSupported() const override {
+        return true;
+    }
+
 
 protected:
     friend class LittleFSFileImpl;
@@ -272,13 +359,23 @@ protected:
 
     bool _tryMount() {
         if (_mounted) {
+            _stopMaintenance();
             lfs_unmount(&_lfs);
             _mounted = false;
         }
         memset(&_lfs, 0, sizeof(_lfs));
+        _blockCacheAlloc();
+        if (!_erased) {
+            _erased = new (std::nothrow) uint8_t[(_lfs_cfg.block_count + 7) / 8];
+        }
+        if (_erased) {
+            memset(_erased, 0, (_lfs_cfg.block_count + 7) / 8);
+        }
+        _erasedCount = 0;
         int rc = lfs_mount(&_lfs, &_lfs_cfg);
         if (rc==0) {
             _mounted = true;
+            _startMaintenance();
         }
         return _mounted;
     }
@@ -337,6 +434,39 @@ protected:
                               lfs_off_t off, const void *buffer, lfs_size_t size);
     static int lfs_flash_erase(const struct lfs_config *c, lfs_block_t block);
     static int lfs_flash_sync(const struct lfs_config *c);
+    static int _markUsed(void *used, lfs_block_t block);
+    int _eraseFree(uint32_t blocks);
+    void _setErased(lfs_block_t block, bool erased);
+
+    // Background maintenance, see LittleFSConfig::setMaintenance()
+    void _startMaintenance();
+    void _stopMaintenance();
+    void _maintenance();
+
+    // Shared read cache, see LittleFSConfig::setBlockCache()
+    struct BlockCacheLine {
+        uint32_t addr;      // flash address of the line, or ~0 when unused
+        uint32_t lastUse;
+    };
+    void _blockCacheAlloc();
+    void _blockCacheFree();
+    int _blockCacheRead(uint32_t addr, uint8_t *dst, uint32_t size);
+    void _blockCacheUpdate(uint32_t addr, const uint8_t *src, uint32_t size);
+    void _blockCacheInvalidate(uint32_t addr, uint32_t size);
+
+    BlockCacheLine* _blockCache = nullptr;
+    uint8_t*        _blockCacheData = nullptr;
+    uint32_t        _blockCacheTick = 0;
+
+    // Blocks known to be erased since their last prog, see gc()
+    uint8_t*        _erased = nullptr;
+    lfs_block_t     _eraseNext = 0;
+    uint32_t        _erasedCount = 0;
+
+    // The scheduled task holds a copy and stops once it reads false,
+    // so it never touches an unmounted (or deleted) filesystem
+    std::shared_ptr<bool> _maintenanceAlive;
+    bool            _written = false;   // progs since the last compaction
 
     lfs_t       _lfs;
     lfs_config  _lfs_cfg;
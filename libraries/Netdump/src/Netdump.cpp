@@ -22,26 +22,30 @@
 #include "Netdump.h"
 #include <lwip/init.h>
 #include "Schedule.h"
+#include <atomic>
 
 
 namespace NetCapture
 {
 
-CallBackList<Netdump::LwipCallback> Netdump::lwipCallback;
+Netdump::LwipCallback Netdump::lwipCallback;
 
 Netdump::Netdump()
 {
-    using namespace std::placeholders;
     phy_capture = capture;
-    lwipHandler = lwipCallback.add(std::bind(&Netdump::netdumpCapture, this, _1, _2, _3, _4, _5));
+    lwipHandler = lwipCallback.add([this](int netif_idx, const char* data, int len, int out, int success)
+    {
+        netdumpCapture(netif_idx, data, len, out, success);
+    });
 };
 
 Netdump::~Netdump()
 {
+    lwipCallback.remove(lwipHandler);
     reset();
-    if (packetBuffer)
+    if (ringBuffer)
     {
-        delete[] packetBuffer;
+        delete[] ringBuffer;
     }
 };
 
@@ -61,9 +65,15 @@ void Netdump::setFilter(const Filter nf)
     netDumpFilter = nf;
 }
 
+void Netdump::setRawFilter(const RawFilter& rf)
+{
+    netDumpRawFilter = rf;
+}
+
 void Netdump::reset()
 {
     setCallback(nullptr, nullptr);
+    setRawFilter(RawFilter());
 }
 
 void Netdump::printDump(Print& out, Packet::PacketDetail ndd, const Filter nf)
@@ -87,16 +97,12 @@ void Netdump::fileDump(File& outfile, const Filter nf)
 bool Netdump::tcpDump(WiFiServer &tcpDumpServer, const Filter nf)
 {
 
-    if (!packetBuffer)
+    if (!ringBuffer && !setCaptureBuffer(tcpBufferSize))
     {
-        packetBuffer = new (std::nothrow) char[tcpBufferSize];
-
-        if (!packetBuffer)
-        {
-            return false;
-        }
+        return false;
     }
-    bufferIndex = 0;
+    ringReset();
+    droppedPackets = 0;
 
     schedule_function([&tcpDumpServer, this, nf]()
     {
@@ -105,6 +111,31 @@ bool Netdump::tcpDump(WiFiServer &tcpDumpServer, const Filter nf)
     return true;
 }
 
+bool Netdump::setCaptureBuffer(size_t size)
+{
+    char* oldBuffer = ringBuffer;
+    ringBuffer = nullptr;   // the capture hook won't push meanwhile
+    ringSize = 0;
+    ringReset();
+    if (oldBuffer)
+    {
+        delete[] oldBuffer;
+    }
+
+    ringBuffer = new (std::nothrow) char[size];
+    if (!ringBuffer)
+    {
+        return false;
+    }
+    ringSize = size;
+    return true;
+}
+
+void Netdump::setSnapLen(size_t len)
+{
+    snapLen = len ? len : maxPcapLength;
+}
+
 void Netdump::capture(int netif_idx, const char* data, size_t len, int out, int success)
 {
     if (lwipCallback.execute(netif_idx, data, len, out, success) == 0)
@@ -117,6 +148,10 @@ void Netdump::netdumpCapture(int netif_idx, const char* data, size_t len, int ou
 {
     if (netDumpCallback)
     {
+        if (!netDumpRawFilter.empty() && !netDumpRawFilter.match(data, len))
+        {
+            return;
+        }
         Packet np(millis(), netif_idx, data, len, out, success);
         if (netDumpFilter  && !netDumpFilter(np))
         {
@@ -133,7 +168,7 @@ void Netdump::writePcapHeader(Stream& s) const
     pcapHeader[1] = 0x00040002;     // pcap major/minor version
     pcapHeader[2] = 0;			     // pcap UTC correction in seconds
     pcapHeader[3] = 0;			     // pcap time stamp accuracy
-    pcapHeader[4] = maxPcapLength;  // pcap max packet length per record
+    pcapHeader[4] = snapLen;        // pcap max packet length per record
     pcapHeader[5] = 1;              // pacp data linkt type = ethernet
     s.write(reinterpret_cast<char*>(pcapHeader), 24);
 }
@@ -145,7 +180,7 @@ void Netdump::printDumpProcess(Print& out, Packet::PacketDetail ndd, const Packe
 
 void Netdump::fileDumpProcess(File& outfile, const Packet& np) const
 {
-    size_t incl_len = np.getPacketSize() > maxPcapLength ? maxPcapLength : np.getPacketSize();
+    size_t incl_len = np.getPacketSize() > snapLen ? snapLen : np.getPacketSize();
     uint32_t pcapHeader[4];
 
     struct timeval tv;
@@ -166,37 +201,20 @@ void Netdump::tcpDumpProcess(const Packet& np)
         // skip myself
         return;
     }
-    size_t incl_len = np.getPacketSize() > maxPcapLength ? maxPcapLength : np.getPacketSize();
-
-    if (bufferIndex + 16 + incl_len < tcpBufferSize) // only add if enough space available
-    {
-        struct timeval tv;
-        gettimeofday(&tv, nullptr);
-        uint32_t* pcapHeader = reinterpret_cast<uint32_t*>(&packetBuffer[bufferIndex]);
-        pcapHeader[0] = tv.tv_sec;      // add pcap record header
-        pcapHeader[1] = tv.tv_usec;
-        pcapHeader[2] = incl_len;
-        pcapHeader[3] = np.getPacketSize();
-        bufferIndex += 16; // pcap header size
-        memcpy(&packetBuffer[bufferIndex], np.rawData(), incl_len);
-        bufferIndex += incl_len;
-    }
-
-    if (bufferIndex && tcpDumpClient && tcpDumpClient.availableForWrite() >= (int)bufferIndex)
-    {
-        tcpDumpClient.write(packetBuffer, bufferIndex);
-        bufferIndex = 0;
-    }
+    // called from the capture hook: only queue the record, it is sent by tcpDumpLoop()
+    ringPush(np);
 }
 
 void Netdump::tcpDumpLoop(WiFiServer &tcpDumpServer, const Filter nf)
 {
     if (tcpDumpServer.hasClient())
     {
+        setCallback(nullptr);
+
         tcpDumpClient = tcpDumpServer.available();
         tcpDumpClient.setNoDelay(true);
 
-        bufferIndex = 0;
+        ringReset();
         writePcapHeader(tcpDumpClient);
 
         setCallback([this](const Packet & ndp)
@@ -208,10 +226,9 @@ void Netdump::tcpDumpLoop(WiFiServer &tcpDumpServer, const Filter nf)
     {
         setCallback(nullptr);
     }
-    if (bufferIndex && tcpDumpClient && tcpDumpClient.availableForWrite() >= (int)bufferIndex)
+    else
     {
-        tcpDumpClient.write(packetBuffer, bufferIndex);
-        bufferIndex = 0;
+        ringDrain(tcpDumpClient);
     }
 
     if (tcpDumpServer.status() != CLOSED)
@@ -223,4 +240,124 @@ void Netdump::tcpDumpLoop(WiFiServer &tcpDumpServer, const Filter nf)
     }
 }
 
+bool Netdump::ringPush(const Packet& np)
+{
+    if (!ringBuffer)
+    {
+        return false;
+    }
+
+    uint32_t incl_len = np.getPacketSize() > snapLen ? snapLen : np.getPacketSize();
+    size_t need = pcapRecordHeader + incl_len;
+    size_t head = ringHead;
+    size_t tail = ringTail;
+    size_t pos = head;
+
+    // head == tail means empty, so the head must never catch up with the tail
+    bool fits;
+    if (head < tail)
+    {
+        fits = tail - head > need;
+    }
+    else if (ringSize - head > need || (ringSize - head == need && tail > 0))
+    {
+        fits = true;
+    }
+    else
+    {
+        // no room before the end, start over at 0
+        fits = tail > need;
+        if (fits)
+        {
+            if (ringSize - head >= pcapRecordHeader)
+            {
+                memcpy(&ringBuffer[head + 8], &ringWrap, sizeof(ringWrap));
+            }
+            pos = 0;
+        }
+    }
+    if (!fits)
+    {
+        droppedPackets = droppedPackets + 1;
+        return false;
+    }
+
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    uint32_t pcapHeader[4];
+    pcapHeader[0] = tv.tv_sec;      // pcap record header
+    pcapHeader[1] = tv.tv_usec;
+    pcapHeader[2] = incl_len;
+    pcapHeader[3] = np.getPacketSize();
+    memcpy(&ringBuffer[pos], pcapHeader, pcapRecordHeader);
+    memcpy(&ringBuffer[pos + pcapRecordHeader], np.rawData(), incl_len);
+
+    pos += need;
+    // the record must be complete before the consumer can see it
+    std::atomic_thread_fence(std::memory_order_release);
+    ringHead = pos == ringSize ? 0 : pos;
+    return true;
+}
+
+void Netdump::ringDrain(Print& out)
+{
+    int avail = out.availableForWrite();
+    size_t tail = ringTail;
+    size_t start = tail;
+
+    // contiguous records are sent in a single write
+    auto flushRecords = [&]()
+    {
+        if (tail > start)
+        {
+            out.write(&ringBuffer[start], tail - start);
+        }
+        if (tail == ringSize)
+        {
+            tail = 0;
+        }
+        start = tail;
+        // done reading the records before the producer can reuse their room
+        std::atomic_thread_fence(std::memory_order_release);
+        ringTail = tail;
+    };
+
+    while (tail != ringHead)
+    {
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        uint32_t incl_len = ringWrap;
+        if (ringSize - tail >= pcapRecordHeader)
+        {
+            memcpy(&incl_len, &ringBuffer[tail + 8], sizeof(incl_len));
+        }
+        if (incl_len == ringWrap)
+        {
+            flushRecords();
+            tail = start = 0;
+            ringTail = 0;
+            continue;
+        }
+
+        int len = pcapRecordHeader + incl_len;
+        if (len > avail)
+        {
+            break;
+        }
+        avail -= len;
+        tail += len;
+        if (tail == ringSize)
+        {
+            flushRecords();
+        }
+    }
+    flushRecords();
+}
+
+void Netdump::ringReset()
+{
+    ringHead = 0;
+    ringTail = 0;
+}
+
 } // namespace NetCapture
@@ -27,6 +27,7 @@
 #include <lwipopts.h>
 #include <FS.h>
 #include "NetdumpPacket.h"
+#include "NetdumpFilter.h"
 #include <ESP8266WiFi.h>
 #include "CallBackList.h"
 
@@ -41,7 +42,8 @@ public:
 
     using Filter = std::function<bool(const Packet&)>;
     using Callback = std::function<void(const Packet&)>;
-    using LwipCallback = std::function<void(int, const char*, int, int, int)>;
+    // called for every packet, kept allocation free
+    using LwipCallback = StaticCallBackList<void(int, const char*, int, int, int), 4>;
 
     Netdump();
     ~Netdump();
@@ -49,20 +51,37 @@ public:
     void setCallback(const Callback nc);
     void setCallback(const Callback nc, const Filter nf);
     void setFilter(const Filter nf);
+    // checked on the raw frame before the Packet is built and the Filter runs
+    void setRawFilter(const RawFilter& rf);
     void reset();
 
     void printDump(Print& out, Packet::PacketDetail ndd, const Filter nf = nullptr);
     void fileDump(File& outfile, const Filter nf = nullptr);
     bool tcpDump(WiFiServer &tcpDumpServer, const Filter nf = nullptr);
 
+    // Capture ring used by tcpDump(). Packets are only copied into it from
+    // the lwIP hook, and sent to the client later from the scheduled loop,
+    // so a slow client never stalls the traffic being captured: packets that
+    // don't fit are dropped and counted instead. The ring is allocated from
+    // the current heap, call this inside a HeapSelect scope to place it in
+    // another one (e.g. HeapSelect ephemeral(UMM_HEAP_EXTERNAL)).
+    bool setCaptureBuffer(size_t size);
+    // bytes kept of each packet, applies to fileDump() and tcpDump()
+    void setSnapLen(size_t len);
+    uint32_t getDropped() const
+    {
+        return droppedPackets;
+    }
+
 
 private:
     Callback netDumpCallback = nullptr;
     Filter   netDumpFilter   = nullptr;
+    RawFilter netDumpRawFilter;
 
     static void capture(int netif_idx, const char* data, size_t len, int out, int success);
-    static CallBackList<LwipCallback> lwipCallback;
-    CallBackList<LwipCallback>::CallBackHandler lwipHandler;
+    static LwipCallback lwipCallback;
+    LwipCallback::CallBackHandler lwipHandler;
 
     void netdumpCapture(int netif_idx, const char* data, size_t len, int out, int success);
 
@@ -73,13 +92,27 @@ private:
 
     void writePcapHeader(Stream& s) const;
 
+    bool ringPush(const Packet& np);
+    void ringDrain(Print& out);
+    void ringReset();
+
     WiFiClient tcpDumpClient;
-    char* packetBuffer = nullptr;
-    int bufferIndex = 0;
+
+    // single producer (capture hook) / single consumer (tcpDumpLoop) ring
+    // of pcap records, each one kept contiguous: a record that doesn't fit
+    // before the end starts over at 0, leaving a wrap mark behind it
+    char* ringBuffer = nullptr;
+    size_t ringSize = 0;
+    volatile size_t ringHead = 0;   // written by the producer only
+    volatile size_t ringTail = 0;   // written by the consumer only
+    volatile uint32_t droppedPackets = 0;
+    size_t snapLen = maxPcapLength;
 
     static constexpr int tcpBufferSize = 2048;
     static constexpr int maxPcapLength = 1024;
     static constexpr uint32_t pcapMagic = 0xa1b2c3d4;
+    static constexpr size_t pcapRecordHeader = 16;
+    static constexpr uint32_t ringWrap = 0xffffffff;
 };
 
 } // namespace NetCapture
@@ -0,0 +1,81 @@
+/*
+    NetdumpFilter.cpp
+
+    Compiled raw frame filter for Netdump.
+*/
+
+#include "NetdumpFilter.h"
+
+namespace NetCapture
+{
+
+RawFilter::RawFilter(const Insn* insns, size_t count)
+    : program(insns, insns + count)
+{
+    for (const Insn& insn : program)
+    {
+        uint8_t size = insn.size & ~Indexed;
+        if (insn.op > Ret || (insn.op != Ret && size != 1 && size != 2 && size != 4))
+        {
+            valid = false;
+        }
+    }
+}
+
+bool RawFilter::match(const char* data, size_t len) const
+{
+    if (!valid)
+    {
+        return false;
+    }
+
+    const uint8_t* raw = reinterpret_cast<const uint8_t*>(data);
+    size_t x = 0;
+    size_t pc = 0;
+    while (pc < program.size())
+    {
+        const Insn& insn = program[pc];
+        if (insn.op == Ret)
+        {
+            return insn.value != 0;
+        }
+
+        uint8_t size = insn.size & ~Indexed;
+        size_t offset = insn.offset + ((insn.size & Indexed) ? x : 0);
+        if (offset + size > len)
+        {
+            return false;
+        }
+        uint32_t field = 0;
+        for (uint8_t i = 0; i < size; i++)
+        {
+            field = (field << 8) | raw[offset + i];
+        }
+        field &= insn.mask;
+
+        bool result;
+        switch (insn.op)
+        {
+        case Eq:
+            result = field == insn.value;
+            break;
+        case Gt:
+            result = field > insn.value;
+            break;
+        case Ge:
+            result = field >= insn.value;
+            break;
+        case Set:
+            result = field != 0;
+            break;
+        default: // Index
+            x = field * insn.value;
+            pc++;
+            continue;
+        }
+        pc += 1 + (result ? insn.jt : insn.jf);
+    }
+    return false;
+}
+
+} // namespace NetCapture
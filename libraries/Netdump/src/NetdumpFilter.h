@@ -0,0 +1,89 @@
+/*
+    NetdumpFilter.h
+
+    Small compiled packet filter, run over the raw frame before a Packet
+    is built, so unwanted traffic costs a few compares instead of a full
+    protocol decode.
+*/
+
+#ifndef __NETDUMP_FILTER_H
+#define __NETDUMP_FILTER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace NetCapture
+{
+
+// A program is a list of instructions, executed from the first one.
+// Each test loads a big endian field of 1, 2 or 4 bytes at 'offset'
+// (plus the index register when 'size' has Indexed set), masks it and
+// compares it with 'value', then skips 'jt' or 'jf' instructions.
+// Jumps only go forward, so every program terminates. Reading past the
+// end of the frame, or past the end of the program, rejects the packet.
+//
+// Example, IPv4 UDP to or from port 5353:
+//
+//     static const RawFilter::Insn mdns[] =
+//     {
+//         { 12, 2, RawFilter::Eq, 0xffff, 0x0800, 0, 5 },                 // ethertype IPv4
+//         { 23, 1, RawFilter::Eq, 0xff, 17, 0, 4 },                       // UDP
+//         { 14, 1, RawFilter::Index, 0x0f, 4, 0, 0 },                     // X = IP header length
+//         { 14, 2 | RawFilter::Indexed, RawFilter::Eq, 0xffff, 5353, 1, 0 }, // source port
+//         { 16, 2 | RawFilter::Indexed, RawFilter::Eq, 0xffff, 5353, 0, 1 }, // destination port
+//         { 0, 0, RawFilter::Ret, 0, 1, 0, 0 },                           // accept
+//         { 0, 0, RawFilter::Ret, 0, 0, 0, 0 },                           // reject
+//     };
+//     nd.setRawFilter(RawFilter(mdns, sizeof(mdns) / sizeof(mdns[0])));
+
+class RawFilter
+{
+public:
+    enum Op : uint8_t
+    {
+        Eq,     // (field & mask) == value
+        Gt,     // (field & mask) > value
+        Ge,     // (field & mask) >= value
+        Set,    // (field & mask) != 0
+        Index,  // X = (field & mask) * value, then next instruction
+        Ret,    // accept if value != 0
+    };
+
+    // or'ed into Insn::size: offset is relative to the index register
+    static constexpr uint8_t Indexed = 0x80;
+
+    struct Insn
+    {
+        uint16_t offset;
+        uint8_t  size;
+        uint8_t  op;
+        uint32_t mask;
+        uint32_t value;
+        uint8_t  jt;
+        uint8_t  jf;
+    };
+
+    RawFilter() = default;
+    RawFilter(const Insn* insns, size_t count);
+
+    // false when the program has an unknown op or field size
+    bool isValid() const
+    {
+        return valid;
+    }
+    bool empty() const
+    {
+        return program.empty();
+    }
+
+    bool match(const char* data, size_t len) const;
+
+private:
+    std::vector<Insn> program;
+    bool valid = true;
+};
+
+} // namespace NetCapture
+
+#endif /* __NETDUMP_FILTER_H */
@@ -0,0 +1,58 @@
+/*
+  Profiler example
+
+  Samples where the CPU spends its time while the sketch runs a few
+  workloads, and prints the profile when a key is sent over Serial.
+  Save the output to a file and resolve it to functions with
+
+    tools/profile.py -e <sketch>.ino.elf profile.txt
+
+  The same output can be served over HTTP by dumping into a StreamString.
+
+  This example code is in the public domain.
+*/
+
+#include <Profiler.h>
+
+static volatile uint32_t sink;
+
+static void __attribute__((noinline)) crunchFlash() {
+  uint32_t x = sink;
+  for (int i = 0; i < 20000; ++i) {
+    x = x * 1103515245 + 12345;
+  }
+  sink = x;
+}
+
+static void IRAM_ATTR __attribute__((noinline)) crunchIram() {
+  uint32_t x = sink;
+  for (int i = 0; i < 5000; ++i) {
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+  }
+  sink = x;
+}
+
+void setup() {
+  Serial.begin(115200);
+  Serial.println();
+  if (!Profiler.begin()) {
+    Serial.println("Profiler: not enough memory");
+  }
+  Serial.println("send any key to print the profile");
+}
+
+void loop() {
+  crunchFlash();
+  crunchIram();
+  delay(1);
+
+  if (Serial.available()) {
+    while (Serial.available()) {
+      Serial.read();
+    }
+    Profiler.dump(Serial);
+    Profiler.clear();
+  }
+}
@@ -0,0 +1,171 @@
+/*
+  Profiler.cpp - statistical CPU profiler sampling from the timer1 NMI
+
+  This file is part of the esp8266 core for Arduino environment.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <Arduino.h>
+#include <stdlib.h>
+#include <core_esp8266_waveform.h>
+#include "Profiler.h"
+
+extern "C" {
+extern char _text_start[], _text_end[];
+extern char _irom0_text_start[], _irom0_text_end[];
+}
+
+// Only touched by the NMI while sampling, or with sampling stopped
+static uint16_t* s_table = nullptr;
+static uint32_t s_buckets = 0;
+static uint32_t s_shift = 0;
+static uint32_t s_iramBuckets = 0;
+static volatile uint32_t s_samples = 0;
+static volatile uint32_t s_rom = 0;
+static volatile uint32_t s_other = 0;
+static uint32_t s_period = 0;
+static uint32_t s_next = 0;
+static bool s_running = false;
+
+ProfilerClass Profiler;
+
+static IRAM_ATTR uint32_t profilerSample() {
+  const uint32_t now = ESP.getCycleCount();
+  if ((int32_t)(now - s_next) < 0) {
+    // woken up early for a waveform edge
+    return s_next - now;
+  }
+  s_next = now + s_period;
+
+  uint32_t pc;
+  __asm__ __volatile__("rsr %0, epc3" : "=a"(pc));
+  uint32_t bucket;
+  if (pc >= (uint32_t)_text_start && pc < (uint32_t)_text_end) {
+    bucket = (pc - (uint32_t)_text_start) >> s_shift;
+  } else if (pc >= (uint32_t)_irom0_text_start && pc < (uint32_t)_irom0_text_end) {
+    bucket = s_iramBuckets + ((pc - (uint32_t)_irom0_text_start) >> s_shift);
+  } else {
+    if (pc < 0x40100000) {
+      s_rom = s_rom + 1;
+    } else {
+      s_other = s_other + 1;
+    }
+    s_samples = s_samples + 1;
+    return s_period;
+  }
+  if (s_table[bucket] != 0xffff) {
+    ++s_table[bucket];
+  }
+  s_samples = s_samples + 1;
+  return s_period;
+}
+
+bool ProfilerClass::begin(size_t buckets, uint32_t hz) {
+  end();
+  if (!buckets || !hz) {
+    return false;
+  }
+  const uint32_t iram = _text_end - _text_start;
+  const uint32_t flash = _irom0_text_end - _irom0_text_start;
+  uint32_t shift = 2;
+  while (((iram >> shift) + 1) + ((flash >> shift) + 1) > buckets) {
+    ++shift;
+  }
+  s_table = (uint16_t*)calloc(buckets, sizeof(uint16_t));
+  if (!s_table) {
+    return false;
+  }
+  s_buckets = buckets;
+  s_shift = shift;
+  s_iramBuckets = (iram >> shift) + 1;
+  s_period = microsecondsToClockCycles(1000000UL) / hz;
+  clear();
+  resume();
+  return true;
+}
+
+void ProfilerClass::end() {
+  pause();
+  free(s_table);
+  s_table = nullptr;
+  s_buckets = 0;
+}
+
+void ProfilerClass::pause() {
+  if (s_running) {
+    setTimer1Callback(nullptr);
+    s_running = false;
+  }
+}
+
+void ProfilerClass::resume() {
+  if (s_table && !s_running) {
+    s_next = ESP.getCycleCount();
+    s_running = true;
+    setTimer1Callback(profilerSample);
+  }
+}
+
+void ProfilerClass::clear() {
+  const bool wasRunning = s_running;
+  pause();
+  if (s_table) {
+    memset(s_table, 0, s_buckets * sizeof(uint16_t));
+  }
+  s_samples = 0;
+  s_rom = 0;
+  s_other = 0;
+  if (wasRunning) {
+    resume();
+  }
+}
+
+bool ProfilerClass::running() const {
+  return s_running;
+}
+
+uint32_t ProfilerClass::samples() const {
+  return s_samples;
+}
+
+/*
+  # esp8266 profile
+  shift <bucket width log2>
+  samples <total> rom <in ROM> other <elsewhere>
+  <bucket start address, hex> <samples>
+  ...
+  end
+*/
+size_t ProfilerClass::dump(Print& out) {
+  const bool wasRunning = s_running;
+  pause();
+  size_t n = out.printf_P(PSTR("# esp8266 profile\nshift %u\nsamples %u rom %u other %u\n"),
+                          s_shift, s_samples, s_rom, s_other);
+  for (uint32_t i = 0; s_table && i < s_buckets; ++i) {
+    if (!s_table[i]) {
+      continue;
+    }
+    const uint32_t addr = i < s_iramBuckets ?
+                          (uint32_t)_text_start + (i << s_shift) :
+                          (uint32_t)_irom0_text_start + ((i - s_iramBuckets) << s_shift);
+    n += out.printf_P(PSTR("%08x %u\n"), addr, s_table[i]);
+  }
+  n += out.print(F("end\n"));
+  if (wasRunning) {
+    resume();
+  }
+  return n;
+}
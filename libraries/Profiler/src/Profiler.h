@@ -0,0 +1,62 @@
+/*
+  Profiler.h - statistical CPU profiler sampling from the timer1 NMI
+
+  This file is part of the esp8266 core for Arduino environment.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef Profiler_h
+#define Profiler_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <Print.h>
+
+/*
+  The profiler hooks the timer1 callback of the waveform generator
+  (setTimer1Callback()), so it runs next to analogWrite() and tone(), but
+  not together with the asynchronous Wire queue, which uses the same
+  callback.  At every sampling period the NMI reads the interrupted PC
+  (EPC3) and counts it in the bucket covering its address.  The buckets
+  span the IRAM and flash code sections with a power-of-two width chosen
+  so that they fit in the table.  Being an NMI, it also samples code that
+  runs with interrupts disabled.
+
+  dump() prints the non-zero buckets as text, tools/profile.py resolves
+  them to function names with the sketch ELF.
+*/
+class ProfilerClass {
+public:
+  // Allocate a table of `buckets` counters (2 bytes each) and start
+  // sampling `hz` times per second.
+  bool begin(size_t buckets = 4096, uint32_t hz = 1000);
+  // Stop and free the table
+  void end();
+
+  void pause();
+  void resume();
+  void clear();
+
+  bool running() const;
+  uint32_t samples() const;
+
+  // Print the profile in the format read by tools/profile.py
+  size_t dump(Print& out);
+};
+
+extern ProfilerClass Profiler;
+
+#endif
@@ -0,0 +1,50 @@
+/*
+  RecordLog example
+
+  Keeps a circular event log in the flash area reserved for the
+  filesystem (do not use LittleFS or SPIFFS in the same sketch), prints
+  what survived the last reset and then appends one record per second.
+
+  Select a flash layout with a filesystem of at least 8KB.
+
+  This example code is in the public domain.
+*/
+
+#include <RecordLog.h>
+#include <flash_hal.h>
+
+RecordLog eventLog(FS_PHYS_ADDR, FS_PHYS_SIZE);
+
+void setup() {
+  Serial.begin(115200);
+  Serial.println();
+
+  if (!eventLog.begin()) {
+    Serial.println("RecordLog: begin failed, check the filesystem size");
+    return;
+  }
+
+  char record[64];
+  int length;
+  while ((length = eventLog.read(record, sizeof(record) - 1)) >= 0) {
+    record[length < (int)sizeof(record) - 1 ? length : sizeof(record) - 1] = 0;
+    Serial.println(record);
+  }
+}
+
+void loop() {
+  static uint32_t last = 0;
+  if (millis() - last < 1000) {
+    return;
+  }
+  last = millis();
+
+  char record[64];
+  int length = snprintf(record, sizeof(record), "uptime %lu ms, heap %u", (unsigned long)last, ESP.getFreeHeap());
+  eventLog.append(record, length);
+  // Records are buffered in RAM until the buffer fills up, write them out
+  // every 10 seconds so at most 10 are lost on a reset
+  if (last % 10000 < 1000) {
+    eventLog.flush();
+  }
+}
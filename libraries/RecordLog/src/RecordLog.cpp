@@ -0,0 +1,301 @@
+/*
+  RecordLog.cpp - circular log of small records stored directly in flash
+
+  This file is part of the esp8266 core for Arduino environment.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <Arduino.h>
+#include <string.h>
+#include <new>
+#include <coredecls.h>
+#include <flash_hal.h>
+#include "debug.h"
+#include "RecordLog.h"
+
+extern "C" {
+#include "spi_flash.h"
+}
+
+static constexpr uint32_t RECORDLOG_MAGIC = 0x474f4c52; // "RLOG"
+static constexpr uint16_t RECORDLOG_ERASED = 0xffff;
+
+static inline uint32_t recordSpace(size_t length) {
+  return 8 + ((length + 3) & ~3);
+}
+
+RecordLog::RecordLog(uint32_t address, uint32_t size, size_t bufferSize)
+: _address(address)
+, _sectors(size / SPI_FLASH_SEC_SIZE)
+, _bufferSize(bufferSize & ~3)
+{
+}
+
+RecordLog::~RecordLog() {
+  end();
+}
+
+uint32_t RecordLog::_sectorAddress(uint32_t sector) const {
+  return _address + sector * SPI_FLASH_SEC_SIZE;
+}
+
+size_t RecordLog::maxRecordSize() const {
+  size_t space = _bufferSize;
+  if (space > SPI_FLASH_SEC_SIZE - sizeof(SectorHeader)) {
+    space = SPI_FLASH_SEC_SIZE - sizeof(SectorHeader);
+  }
+  return space < sizeof(RecordHeader) ? 0 : space - sizeof(RecordHeader);
+}
+
+bool RecordLog::_readSectorHeader(uint32_t sector, uint32_t& sequence) const {
+  SectorHeader header;
+  if (flash_hal_read(_sectorAddress(sector), sizeof(header), (uint8_t*)&header) != FLASH_HAL_OK) {
+    return false;
+  }
+  if (header.magic != RECORDLOG_MAGIC || header.sequence != ~header.sequenceInv) {
+    return false;
+  }
+  sequence = header.sequence;
+  return true;
+}
+
+bool RecordLog::_startSector(uint32_t sector, uint32_t sequence) {
+  if (flash_hal_erase(_sectorAddress(sector), SPI_FLASH_SEC_SIZE) != FLASH_HAL_OK) {
+    DEBUGV("RecordLog: erase of sector %u failed\n", sector);
+    return false;
+  }
+  SectorHeader header = { RECORDLOG_MAGIC, sequence, ~sequence };
+  if (flash_hal_write(_sectorAddress(sector), sizeof(header), (const uint8_t*)&header) != FLASH_HAL_OK) {
+    DEBUGV("RecordLog: header write to sector %u failed\n", sector);
+    return false;
+  }
+  _head = sector;
+  _headSequence = sequence;
+  _writeOffset = sizeof(SectorHeader);
+  return true;
+}
+
+bool RecordLog::_nextSector() {
+  uint32_t next = (_head + 1) % _sectors;
+  if (_count == _sectors) {
+    // About to erase the oldest sector
+    --_count;
+  }
+  if (!_startSector(next, _headSequence + 1)) {
+    // The ring no longer ends at a valid sector, start over on the one after
+    _count = 0;
+    _writeOffset = SPI_FLASH_SEC_SIZE;
+    _head = next;
+    return false;
+  }
+  ++_count;
+  return true;
+}
+
+void RecordLog::_recoverWriteOffset() {
+  uint32_t offset = sizeof(SectorHeader);
+  const uint32_t base = _sectorAddress(_head);
+  while (offset + sizeof(RecordHeader) <= SPI_FLASH_SEC_SIZE) {
+    RecordHeader header;
+    if (flash_hal_read(base + offset, sizeof(header), (uint8_t*)&header) != FLASH_HAL_OK) {
+      break;
+    }
+    if (header.length == RECORDLOG_ERASED && header.lengthInv == RECORDLOG_ERASED) {
+      _writeOffset = offset;
+      return;
+    }
+    if (header.length == 0 || header.length != (uint16_t)~header.lengthInv ||
+        offset + recordSpace(header.length) > SPI_FLASH_SEC_SIZE) {
+      // Torn header, don't append behind it
+      break;
+    }
+    offset += recordSpace(header.length);
+  }
+  _writeOffset = SPI_FLASH_SEC_SIZE;
+}
+
+bool RecordLog::begin() {
+  if ((_address & (SPI_FLASH_SEC_SIZE - 1)) != 0 || _sectors < 2 || maxRecordSize() == 0) {
+    DEBUGV("RecordLog: invalid geometry addr=%x sectors=%u buffer=%u\n", _address, _sectors, _bufferSize);
+    return false;
+  }
+  if (!_buffer) {
+    _buffer = new (std::nothrow) uint8_t[_bufferSize];
+    if (!_buffer) {
+      return false;
+    }
+  }
+  _bufferUsed = 0;
+
+  // The newest sector is the one with the highest sequence number, the
+  // valid ones before it must count down without gaps.
+  bool found = false;
+  for (uint32_t sector = 0; sector < _sectors; ++sector) {
+    uint32_t sequence;
+    if (_readSectorHeader(sector, sequence) && (!found || sequence > _headSequence)) {
+      found = true;
+      _head = sector;
+      _headSequence = sequence;
+    }
+  }
+  if (!found) {
+    _count = 1;
+    if (!_startSector(0, 1)) {
+      end();
+      return false;
+    }
+    rewind();
+    return true;
+  }
+  _count = 1;
+  while (_count < _sectors) {
+    uint32_t sequence;
+    uint32_t sector = (_head + _sectors - _count) % _sectors;
+    if (!_readSectorHeader(sector, sequence) || sequence != _headSequence - _count) {
+      break;
+    }
+    ++_count;
+  }
+  _recoverWriteOffset();
+  rewind();
+  return true;
+}
+
+void RecordLog::end() {
+  if (_buffer) {
+    flush();
+    delete[] _buffer;
+    _buffer = nullptr;
+  }
+  _bufferUsed = 0;
+}
+
+bool RecordLog::append(const void* data, size_t length) {
+  if (!_buffer || length == 0 || length > maxRecordSize()) {
+    return false;
+  }
+  const uint32_t space = recordSpace(length);
+  if (_writeOffset + _bufferUsed + space > SPI_FLASH_SEC_SIZE) {
+    if (!flush() || !_nextSector()) {
+      return false;
+    }
+  }
+  if (_bufferUsed + space > _bufferSize && !flush()) {
+    return false;
+  }
+  RecordHeader header = { (uint16_t)length, (uint16_t)~length, crc32(data, length) };
+  uint8_t* dst = _buffer + _bufferUsed;
+  memcpy(dst, &header, sizeof(header));
+  memcpy(dst + sizeof(header), data, length);
+  memset(dst + sizeof(header) + length, 0xff, space - sizeof(header) - length);
+  _bufferUsed += space;
+  return true;
+}
+
+bool RecordLog::flush() {
+  if (_bufferUsed == 0) {
+    return true;
+  }
+  const uint32_t size = _bufferUsed;
+  _bufferUsed = 0;
+  if (flash_hal_write(_sectorAddress(_head) + _writeOffset, size, _buffer) != FLASH_HAL_OK) {
+    DEBUGV("RecordLog: write to sector %u failed\n", _head);
+    // Part of the range may be programmed, never write there again
+    _writeOffset = SPI_FLASH_SEC_SIZE;
+    return false;
+  }
+  _writeOffset += size;
+  return true;
+}
+
+bool RecordLog::clear() {
+  if (!_buffer) {
+    return false;
+  }
+  _bufferUsed = 0;
+  // Skipping a sequence number breaks the chain to the older sectors,
+  // so begin() will not pick them up again.
+  _count = 1;
+  if (!_startSector((_head + 1) % _sectors, _headSequence + 2)) {
+    _count = 0;
+    _writeOffset = SPI_FLASH_SEC_SIZE;
+    return false;
+  }
+  rewind();
+  return true;
+}
+
+bool RecordLog::rewind() {
+  if (!flush()) {
+    return false;
+  }
+  _readSequence = _headSequence - (_count ? _count - 1 : 0);
+  _readOffset = sizeof(SectorHeader);
+  return true;
+}
+
+int RecordLog::read(void* dst, size_t size) {
+  if (!_buffer || _count == 0) {
+    return -1;
+  }
+  for (;;) {
+    const uint32_t oldest = _headSequence - (_count - 1);
+    if ((int32_t)(_readSequence - oldest) < 0) {
+      // The sector we were in has been recycled
+      _readSequence = oldest;
+      _readOffset = sizeof(SectorHeader);
+    }
+    const bool newest = _readSequence == _headSequence;
+    const uint32_t limit = newest ? _writeOffset : SPI_FLASH_SEC_SIZE;
+
+    RecordHeader header;
+    const uint32_t base = _sectorAddress((_head + _sectors - (_headSequence - _readSequence)) % _sectors);
+    bool valid = _readOffset + sizeof(header) <= limit &&
+                 flash_hal_read(base + _readOffset, sizeof(header), (uint8_t*)&header) == FLASH_HAL_OK &&
+                 header.length != 0 && header.length == (uint16_t)~header.lengthInv &&
+                 _readOffset + recordSpace(header.length) <= limit;
+    if (!valid) {
+      if (newest) {
+        return -1;
+      }
+      ++_readSequence;
+      _readOffset = sizeof(SectorHeader);
+      continue;
+    }
+
+    // Check the CRC over the whole payload even if dst is too small
+    const uint32_t payload = base + _readOffset + sizeof(header);
+    const size_t copied = header.length < size ? header.length : size;
+    uint32_t crc = 0xffffffff;
+    bool ok = true;
+    if (copied) {
+      ok = flash_hal_read(payload, copied, (uint8_t*)dst) == FLASH_HAL_OK;
+      crc = crc32(dst, copied, crc);
+    }
+    for (size_t done = copied; ok && done < header.length;) {
+      uint8_t chunk[32];
+      size_t n = header.length - done < sizeof(chunk) ? header.length - done : sizeof(chunk);
+      ok = flash_hal_read(payload + done, n, chunk) == FLASH_HAL_OK;
+      crc = crc32(chunk, n, crc);
+      done += n;
+    }
+    _readOffset += recordSpace(header.length);
+    if (ok && crc == header.crc) {
+      return header.length;
+    }
+    DEBUGV("RecordLog: skipping corrupt record in sequence %u\n", _readSequence);
+  }
+}
@@ -0,0 +1,102 @@
+/*
+  RecordLog.h - circular log of small records stored directly in flash
+
+  This file is part of the esp8266 core for Arduino environment.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef RecordLog_h
+#define RecordLog_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+  The log occupies a range of whole flash sectors used as a ring.  Every
+  sector starts with a header carrying a sequence number, followed by
+  records made of an 8 byte header (length and CRC32) and the payload
+  padded to 4 bytes.  Appended records are collected in a RAM buffer and
+  written with a single flash_hal_write() when the buffer fills up or on
+  flush().  When the sector being written is full the next one is erased,
+  which drops the oldest sector once the ring has wrapped.
+
+  begin() only reads the sector headers and the record headers of the
+  newest sector, so recovery time does not depend on the log size.  A
+  record torn by a power loss fails its CRC and is skipped on read.
+*/
+class RecordLog {
+public:
+  RecordLog(uint32_t address, uint32_t size, size_t bufferSize = 256);
+  ~RecordLog();
+
+  bool begin();
+  void end();
+
+  // Queue one record.  Returns false if it is empty, larger than
+  // maxRecordSize(), or if writing out the buffer failed.
+  bool append(const void* data, size_t length);
+  // Write the buffered records to flash
+  bool flush();
+  // Drop all records
+  bool clear();
+
+  // Move the read position to the oldest record in flash
+  bool rewind();
+  // Copy the next record into dst (truncated to size) and return its
+  // length, or -1 when there are no more records.  Only records already
+  // written to flash are returned, see flush().
+  int read(void* dst, size_t size);
+
+  size_t maxRecordSize() const;
+  size_t pending() const { return _bufferUsed; }
+
+protected:
+  struct SectorHeader {
+    uint32_t magic;
+    uint32_t sequence;
+    uint32_t sequenceInv;
+  };
+
+  struct RecordHeader {
+    uint16_t length;
+    uint16_t lengthInv;
+    uint32_t crc;
+  };
+
+  uint32_t _sectorAddress(uint32_t sector) const;
+  bool _readSectorHeader(uint32_t sector, uint32_t& sequence) const;
+  bool _startSector(uint32_t sector, uint32_t sequence);
+  bool _nextSector();
+  void _recoverWriteOffset();
+
+  uint32_t _address;
+  uint32_t _sectors;
+  size_t _bufferSize;
+  uint8_t* _buffer = nullptr;
+  size_t _bufferUsed = 0;
+
+  // Sector being written, its sequence number, and where the buffer goes.
+  // _count sectors ending with _head hold valid data.
+  uint32_t _head = 0;
+  uint32_t _headSequence = 0;
+  uint32_t _writeOffset = 0;
+  uint32_t _count = 0;
+
+  uint32_t _readSequence = 0;
+  uint32_t _readOffset = 0;
+};
+
+#endif
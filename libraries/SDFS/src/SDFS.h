@@ -35,6 +35,9 @@
 #include <SPI.h>
 #include <SdFat.h>
 #include <FS.h>
+#include <new>
+
+#define SDFS_SECTOR_SIZE 512
 
 using namespace fs;
 
@@ -47,7 +50,7 @@ class SDFSConfig : public FSConfig
 public:
     static constexpr uint32_t FSId = 0x53444653;
 
-    SDFSConfig(uint8_t csPin = 4, uint32_t spi = SD_SCK_MHZ(10)) : FSConfig(FSId, false), _csPin(csPin), _part(0), _spiSettings(spi)  { }
+    SDFSConfig(uint8_t csPin = 4, uint32_t spi = SD_SCK_MHZ(10)) : FSConfig(FSId, false), _csPin(csPin), _part(0), _spiSettings(spi), _writeBuffer(0)  { }
 
     SDFSConfig setAutoFormat(bool val = true) {
         _autoFormat = val;
@@ -65,11 +68,20 @@ public:
         _part = part;
         return *this;
     }
+    // Collect small writes to files opened for writing into a buffer of this
+    // many bytes (rounded down to whole sectors) and hand them to SdFat as
+    // sector aligned runs, which it sends with multi-block write commands.
+    // 0, the default, writes through.
+    SDFSConfig setWriteBuffer(size_t bytes) {
+        _writeBuffer = bytes & ~(SDFS_SECTOR_SIZE - 1);
+        return *this;
+    }
 
     // Inherit _type and _autoFormat
     uint8_t   _csPin;
     uint8_t   _part;
     uint32_t  _spiSettings;
+    size_t    _writeBuffer;
 };
 
 class SDFSImpl : public FSImpl
@@ -167,6 +179,10 @@ public:
 
     bool format() override;
 
+    bool dirCacheSupported() const override {
+        return true;
+    }
+
     // The following are not common FS interfaces, but are needed only to
     // support the older SD.h exports
     uint8_t type() {
@@ -264,11 +280,16 @@ protected:
 class SDFSFileImpl : public FileImpl
 {
 public:
-    SDFSFileImpl(SDFSImpl *fs, std::shared_ptr<sdfat::File32> fd, const char *name)
+    SDFSFileImpl(SDFSImpl *fs, std::shared_ptr<sdfat::File32> fd, const char *name, size_t writeBuffer = 0)
         : _fs(fs), _fd(fd), _opened(true)
     {
         _name = std::shared_ptr<char>(new char[strlen(name) + 1], std::default_delete<char[]>());
         strcpy(_name.get(), name);
+        if (writeBuffer) {
+            // Word aligned so the SPI FIFO can be filled without copying
+            _wbuf.reset(new (std::nothrow) uint32_t[writeBuffer / 4]);
+            _wbufSize = _wbuf ? writeBuffer : 0;
+        }
     }
 
     ~SDFSFileImpl() override
@@ -284,24 +305,57 @@ public:
 
     size_t write(const uint8_t *buf, size_t size) override
     {
-        return _opened ? _fd->write(buf, size) : -1;
+        if (!_opened) {
+            return -1;
+        }
+        if (!_wbuf) {
+            return _fd->write(buf, size);
+        }
+        size_t done = 0;
+        while (done < size) {
+            size_t left = size - done;
+            if (!_wbufLen && !(_fd->curPosition() & (SDFS_SECTOR_SIZE - 1)) && left >= _wbufSize) {
+                // Already on a sector boundary, pass whole sectors straight through
+                size_t len = left & ~(SDFS_SECTOR_SIZE - 1);
+                size_t wr = _fd->write(buf + done, len);
+                if (wr != len) {
+                    return done + ((int)wr > 0 ? wr : 0);
+                }
+                done += len;
+                continue;
+            }
+            // The first fill stops at a sector boundary of the file
+            size_t target = _wbufSize - (_fd->curPosition() & (SDFS_SECTOR_SIZE - 1));
+            size_t len = std::min(left, target - _wbufLen);
+            memcpy(reinterpret_cast<uint8_t*>(_wbuf.get()) + _wbufLen, buf + done, len);
+            _wbufLen += len;
+            done += len;
+            if (_wbufLen == target && !_flushWriteBuffer()) {
+                return done - len;
+            }
+        }
+        return done;
     }
 
     int read(uint8_t* buf, size_t size) override
     {
-        return _opened ? _fd->read(buf, size) : -1;
+        if (!_opened || !_flushWriteBuffer()) {
+            return -1;
+        }
+        return _fd->read(buf, size);
     }
 
     void flush() override
     {
         if (_opened) {
+            _flushWriteBuffer();
             _fd->sync();
         }
     }
 
     bool seek(uint32_t pos, SeekMode mode) override
     {
-        if (!_opened) {
+        if (!_opened || !_flushWriteBuffer()) {
             return false;
         }
         switch (mode) {
@@ -321,12 +375,12 @@ public:
 
     size_t position() const override
     {
-        return _opened ? _fd->curPosition() : 0;
+        return _opened ? _fd->curPosition() + _wbufLen : 0;
     }
 
     size_t size() const override
     {
-        return _opened ? _fd->fileSize() : 0;
+        return _opened ? std::max<size_t>(_fd->fileSize(), position()) : 0;
     }
 
     bool truncate(uint32_t size) override
@@ -335,12 +389,13 @@ public:
             DEBUGV("SDFSFileImpl::truncate: file not opened\n");
             return false;
         }
-        return _fd->truncate(size);
+        return _flushWriteBuffer() && _fd->truncate(size);
     }
 
     void close() override
     {
         if (_opened) {
+            _flushWriteBuffer();
             _fd->close();
             _opened = false;
         }
@@ -400,10 +455,27 @@ public:
     }
 
 protected:
+    bool _flushWriteBuffer()
+    {
+        if (!_wbufLen) {
+            return true;
+        }
+        size_t len = _wbufLen;
+        _wbufLen = 0;
+        if (_fd->write(_wbuf.get(), len) != len) {
+            DEBUGV("SDFSFileImpl::write: failed writing %d buffered bytes\n", len);
+            return false;
+        }
+        return true;
+    }
+
     SDFSImpl*                     _fs;
     std::shared_ptr<sdfat::File32>  _fd;
     std::shared_ptr<char>         _name;
     bool                          _opened;
+    std::unique_ptr<uint32_t[]>   _wbuf;
+    size_t                        _wbufSize = 0;
+    size_t                        _wbufLen = 0;
 };
 
 class SDFSDirImpl : public DirImpl
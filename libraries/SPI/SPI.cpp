@@ -21,6 +21,7 @@
 
 #include "SPI.h"
 #include "HardwareSerial.h"
+#include "Schedule.h"
 
 #define SPI_PINS_HSPI			0 // Normal HSPI mode (MISO = GPIO12, MOSI = GPIO13, SCLK = GPIO14);
 #define SPI_PINS_HSPI_OVERLAP	1 // HSPI Overllaped in spi0 pins (MISO = SD0, MOSI = SDD1, SCLK = CLK);
@@ -87,6 +88,7 @@ void SPIClass::begin() {
 }
 
 void SPIClass::end() {
+    waitAsync();
     switch (pinSet) {
     case SPI_PINS_HSPI:
         pinMode(SCK, INPUT);
@@ -140,6 +142,7 @@ void SPIClass::setHwCs(bool use) {
 }
 
 void SPIClass::beginTransaction(SPISettings settings) {
+    waitAsync();
     while(SPI1CMD & SPIBUSY) {}
     setFrequency(settings._clock);
     setBitOrder(settings._bitOrder);
@@ -198,29 +201,22 @@ static uint32_t ClkRegToFreq(spiClk_t * reg) {
     return (ESP8266_CLOCK / ((reg->regPre + 1) * (reg->regN + 1)));
 }
 
-void SPIClass::setFrequency(uint32_t freq) {
-    static uint32_t lastSetFrequency = 0;
-    static uint32_t lastSetRegister = 0;
-
+/**
+ * find the clock register value for the Frequency
+ * @param freq
+ * @return 0x80000000 for the sysclock, see setClockDivider()
+ */
+static uint32_t FreqToClkReg(uint32_t freq) {
     if(freq >= ESP8266_CLOCK) {
         // magic number to set spi sysclock bit (see below.)
-        setClockDivider(0x80000000);
-        return;
-    }
-
-    if(lastSetFrequency == freq && lastSetRegister == SPI1CLK) {
-        // do nothing (speed optimization)
-        return;
+        return 0x80000000;
     }
 
     const spiClk_t minFreqReg = { 0x7FFFF020 };
     uint32_t minFreq = ClkRegToFreq((spiClk_t*) &minFreqReg);
     if(freq < minFreq) {
         // use minimum possible clock regardless
-        setClockDivider(minFreqReg.regValue);
-        lastSetRegister = SPI1CLK;
-        lastSetFrequency = freq;
-        return;
+        return minFreqReg.regValue;
     }
 
     uint8_t calN = 1;
@@ -284,10 +280,26 @@ void SPIClass::setFrequency(uint32_t freq) {
 
     // os_printf("[0x%08X][%d]\t EQU: %d\t Pre: %d\t N: %d\t H: %d\t L: %d\t - Real Frequency: %d\n", bestReg.regValue, freq, bestReg.regEQU, bestReg.regPre, bestReg.regN, bestReg.regH, bestReg.regL, ClkRegToFreq(&bestReg));
 
-    setClockDivider(bestReg.regValue);
+    return bestReg.regValue;
+}
+
+void SPIClass::setFrequency(uint32_t freq) {
+    static uint32_t lastSetFrequency = 0;
+    static uint32_t lastSetRegister = 0;
+
+    if(freq >= ESP8266_CLOCK) {
+        setClockDivider(FreqToClkReg(freq));
+        return;
+    }
+
+    if(lastSetFrequency == freq && lastSetRegister == SPI1CLK) {
+        // do nothing (speed optimization)
+        return;
+    }
+
+    setClockDivider(FreqToClkReg(freq));
     lastSetRegister = SPI1CLK;
     lastSetFrequency = freq;
-
 }
 
 void SPIClass::setClockDivider(uint32_t clockDiv) {
@@ -306,6 +318,7 @@ inline void SPIClass::setDataBits(uint16_t bits) {
 }
 
 uint8_t SPIClass::transfer(uint8_t data) {
+    waitAsync();
     while(SPI1CMD & SPIBUSY) {}
     // reset to 8Bit mode
     setDataBits(8);
@@ -357,6 +370,7 @@ void SPIClass::transfer(void *buf, uint16_t count) {
 }
 
 void SPIClass::write(uint8_t data) {
+    waitAsync();
     while(SPI1CMD & SPIBUSY) {}
     // reset to 8Bit mode
     setDataBits(8);
@@ -370,6 +384,7 @@ void SPIClass::write16(uint16_t data) {
 }
 
 void SPIClass::write16(uint16_t data, bool msb) {
+    waitAsync();
     while(SPI1CMD & SPIBUSY) {}
     // Set to 16Bits transfer
     setDataBits(16);
@@ -389,6 +404,7 @@ void SPIClass::write32(uint32_t data) {
 }
 
 void SPIClass::write32(uint32_t data, bool msb) {
+    waitAsync();
     while(SPI1CMD & SPIBUSY) {}
     // Set to 32Bits transfer
     setDataBits(32);
@@ -414,6 +430,7 @@ void SPIClass::write32(uint32_t data, bool msb) {
  * @param size uint32_t
  */
 void SPIClass::writeBytes(const uint8_t * data, uint32_t size) {
+    waitAsync();
     while(size) {
         if(size > 64) {
             writeBytes_(data, 64);
@@ -447,13 +464,14 @@ void SPIClass::writeBytes_(const uint8_t * data, uint8_t size) {
 }
 
 /**
- * @param data uint8_t *
+ * @param data uint8_t *  may be in PROGMEM
  * @param size uint8_t  max for size is 64Byte
  * @param repeat uint32_t
  */
 void SPIClass::writePattern(const uint8_t * data, uint8_t size, uint32_t repeat) {
     if(size > 64) return; //max Hardware FIFO
 
+    waitAsync();
     while(SPI1CMD & SPIBUSY) {}
 
     uint32_t buffer[16];
@@ -470,7 +488,7 @@ void SPIClass::writePattern(const uint8_t * data, uint8_t size, uint32_t repeat)
         while(r--){
             dataPtr = data;
             for(i=0; i<size; i++){
-                *bufferPtr = *dataPtr;
+                *bufferPtr = pgm_read_byte(dataPtr);
                 bufferPtr++;
                 dataPtr++;
             }
@@ -493,7 +511,7 @@ void SPIClass::writePattern(const uint8_t * data, uint8_t size, uint32_t repeat)
         while(r--){
             dataPtr = data;
             for(i=0; i<size; i++){
-                *bufferPtr = *dataPtr;
+                *bufferPtr = pgm_read_byte(dataPtr);
                 bufferPtr++;
                 dataPtr++;
             }
@@ -528,6 +546,7 @@ void SPIClass::writePattern(const uint8_t * data, uint8_t size, uint32_t repeat)
  * @param size uint32_t
  */
 void SPIClass::transferBytes(const uint8_t * out, uint8_t * in, uint32_t size) {
+    waitAsync();
     while(size) {
         if(size > 64) {
             transferBytes_(out, in, 64);
@@ -615,6 +634,158 @@ void SPIClass::transferBytes_(const uint8_t * out, uint8_t * in, uint8_t size) {
     }
 }
 
+bool SPIClass::queue(SPIAsyncTransfer * t) {
+    if(!t || !t->size || (asyncHead - asyncDone) >= ASYNC_QUEUE) {
+        return false;
+    }
+    // The divider search is too slow for the interrupt
+    t->clockReg = FreqToClkReg(t->settings._clock);
+    if(!asyncAttached) {
+        // Shared with SPISlave, which cannot be used at the same time
+        ETS_SPI_INTR_ATTACH(asyncIsr_, this);
+        asyncAttached = true;
+    }
+
+    ETS_SPI_INTR_DISABLE();
+    asyncQueue[asyncHead % ASYNC_QUEUE] = t;
+    asyncHead = asyncHead + 1;
+    if(!asyncActive) {
+        while(SPI1CMD & SPIBUSY) {}
+        SPI1S = (SPI1S & ~SPISTRIS) | SPISTRIE;
+        asyncActive = true;
+        asyncStart_(t);
+    }
+    ETS_SPI_INTR_ENABLE();
+
+    if(!asyncDispatching) {
+        asyncDispatching = schedule_recurrent_function_us([this]() {
+            asyncReport_();
+            asyncDispatching = asyncBusy();
+            return asyncDispatching;
+        }, 100);
+    }
+    return true;
+}
+
+void SPIClass::waitAsync_() {
+    while(asyncBusy()) {
+        if(asyncRun == asyncHead) {
+            // All sent, just not reported yet
+            asyncReport_();
+        } else {
+            optimistic_yield(1000);
+        }
+    }
+}
+
+void SPIClass::asyncReport_() {
+    // Report in queue order from task context, callbacks may queue more
+    while(asyncDone != asyncRun) {
+        SPIAsyncTransfer * t = asyncQueue[asyncDone % ASYNC_QUEUE];
+        asyncDone++;
+        if(t->onDone) {
+            t->onDone(t);
+        }
+    }
+}
+
+void IRAM_ATTR SPIClass::asyncStart_(SPIAsyncTransfer * t) {
+    // Same as setClockDivider(), setBitOrder() and setDataMode()
+    if(t->clockReg == 0x80000000) {
+        GPMUX |= (1 << 9);
+    } else {
+        GPMUX &= ~(1 << 9);
+    }
+    SPI1CLK = t->clockReg;
+    if(t->settings._bitOrder == MSBFIRST) {
+        SPI1C &= ~(SPICWBO | SPICRBO);
+    } else {
+        SPI1C |= (SPICWBO | SPICRBO);
+    }
+    bool CPOL = (t->settings._dataMode & 0x10);
+    bool CPHA = (t->settings._dataMode & 0x01);
+    if(CPOL)
+        CPHA ^= 1;
+    if(CPHA) {
+        SPI1U |= (SPIUSME);
+    } else {
+        SPI1U &= ~(SPIUSME);
+    }
+    if(CPOL) {
+        SPI1P |= 1<<29;
+    } else {
+        SPI1P &= ~(1<<29);
+    }
+
+    if(t->csPin >= 0) {
+        digitalWrite(t->csPin, LOW);
+    }
+    asyncOffset = 0;
+    asyncLoad_(t);
+}
+
+void IRAM_ATTR SPIClass::asyncLoad_(SPIAsyncTransfer * t) {
+    uint32_t left = t->size - asyncOffset;
+    asyncChunk = (left > 64) ? 64 : left;
+
+    const uint32_t mask = ~((SPIMMOSI << SPILMOSI) | (SPIMMISO << SPILMISO));
+    uint32_t bits = asyncChunk * 8 - 1;
+    SPI1U1 = ((SPI1U1 & mask) | ((bits << SPILMOSI) | (bits << SPILMISO)));
+
+    // Byte by byte, the buffers do not have to be aligned
+    volatile uint32_t * fifoPtr = &SPI1W0;
+    const uint8_t * out = t->out ? t->out + asyncOffset : nullptr;
+    for(uint32_t i = 0; i < asyncChunk; i += 4) {
+        uint32_t word = 0xFFFFFFFF;
+        if(out) {
+            for(uint32_t b = 0; b < 4 && i + b < asyncChunk; b++) {
+                word = (word & ~(0xFFU << (b * 8))) | (out[i + b] << (b * 8));
+            }
+        }
+        *(fifoPtr++) = word;
+    }
+    SPI1CMD |= SPIBUSY;
+}
+
+void IRAM_ATTR SPIClass::asyncIsr_(void * arg) {
+    if(!(SPIIR & (1 << SPII1)) || !(SPI1S & SPISTRIS)) {
+        return;
+    }
+    SPI1S &= ~SPISTRIS;
+    SPIClass * self = (SPIClass *) arg;
+    if(!self->asyncActive) {
+        return;
+    }
+
+    SPIAsyncTransfer * t = self->asyncQueue[self->asyncRun % ASYNC_QUEUE];
+    if(t->in) {
+        volatile uint32_t * fifoPtr = &SPI1W0;
+        uint8_t * in = t->in + self->asyncOffset;
+        for(uint32_t i = 0; i < self->asyncChunk; i += 4) {
+            uint32_t word = *(fifoPtr++);
+            for(uint32_t b = 0; b < 4 && i + b < self->asyncChunk; b++) {
+                in[i + b] = word >> (b * 8);
+            }
+        }
+    }
+    self->asyncOffset += self->asyncChunk;
+    if(self->asyncOffset < t->size) {
+        self->asyncLoad_(t);
+        return;
+    }
+
+    if(t->csPin >= 0) {
+        digitalWrite(t->csPin, HIGH);
+    }
+    self->asyncRun = self->asyncRun + 1;
+    if(self->asyncRun != self->asyncHead) {
+        self->asyncStart_(self->asyncQueue[self->asyncRun % ASYNC_QUEUE]);
+    } else {
+        // Blocking transfers must not raise this interrupt
+        SPI1S &= ~SPISTRIE;
+        self->asyncActive = false;
+    }
+}
 
 #if !defined(NO_GLOBAL_INSTANCES) && !defined(NO_GLOBAL_SPI)
 SPIClass SPI;
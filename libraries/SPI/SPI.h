@@ -49,6 +49,19 @@ public:
   uint8_t  _dataMode;
 };
 
+// A transfer run in the background by SPIClass::queue().  The buffers must
+// stay valid and in RAM until onDone is called from loop()/yield() context.
+struct SPIAsyncTransfer {
+  SPISettings settings;
+  int8_t csPin;          // OUTPUT pin driven low for the transfer, or -1
+  const uint8_t * out;   // nullptr sends 0xFF
+  uint8_t * in;          // nullptr drops what is received
+  uint32_t size;
+  void (*onDone)(SPIAsyncTransfer *);
+  void * arg;
+  uint32_t clockReg;     // filled in by queue()
+};
+
 class SPIClass {
 public:
   SPIClass();
@@ -73,9 +86,32 @@ public:
   void writePattern(const uint8_t * data, uint8_t size, uint32_t repeat);
   void transferBytes(const uint8_t * out, uint8_t * in, uint32_t size);
   void endTransaction(void);
+  // Start t once the transfers queued before it are done, false if the
+  // queue is full.  Blocking calls wait until the queue is empty.
+  bool queue(SPIAsyncTransfer * t);
+  bool asyncBusy() const { return asyncHead != asyncDone; }
 private:
   bool useHwCs;
   uint8_t pinSet;
+
+  // The SPI interrupt refills the FIFO and starts the next queued transfer,
+  // the task side only moves asyncHead and asyncDone.
+  enum { ASYNC_QUEUE = 8 };
+  SPIAsyncTransfer * asyncQueue[ASYNC_QUEUE];
+  volatile uint32_t asyncHead = 0;
+  volatile uint32_t asyncRun = 0;
+  uint32_t asyncDone = 0;
+  volatile bool asyncActive = false;
+  bool asyncAttached = false;
+  bool asyncDispatching = false;
+  uint32_t asyncOffset = 0;
+  uint8_t asyncChunk = 0;
+  static void asyncIsr_(void * arg);
+  void asyncStart_(SPIAsyncTransfer * t);
+  void asyncLoad_(SPIAsyncTransfer * t);
+  void asyncReport_();
+  void waitAsync_();
+  void waitAsync() { if (asyncBusy()) waitAsync_(); }
   void writeBytes_(const uint8_t * data, uint8_t size);
   void transferBytes_(const uint8_t * out, uint8_t * in, uint8_t size);
   void transferBytesAligned_(const uint8_t * out, uint8_t * in, uint8_t size);
@@ -0,0 +1,192 @@
+/*
+ SPIFrameBuffer.cpp - RGB565 framebuffer for SPI displays, pushing only
+                      the regions that changed
+
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <algorithm>
+#include <new>
+#include "SPIFrameBuffer.h"
+
+SPIFrameBuffer::SPIFrameBuffer(uint16_t width, uint16_t height, int8_t csPin, int8_t dcPin)
+    : _width(width), _height(height), _csPin(csPin), _dcPin(dcPin) {
+}
+
+SPIFrameBuffer::~SPIFrameBuffer() {
+    end();
+}
+
+bool SPIFrameBuffer::begin() {
+    if(!_buffer) {
+        _buffer = new (std::nothrow) uint16_t[(uint32_t)_width * _height];
+        if(!_buffer) {
+            return false;
+        }
+        memset(_buffer, 0, (uint32_t)_width * _height * 2);
+    }
+    if(_csPin >= 0) {
+        digitalWrite(_csPin, HIGH);
+        pinMode(_csPin, OUTPUT);
+    }
+    digitalWrite(_dcPin, HIGH);
+    pinMode(_dcPin, OUTPUT);
+    // The panel content is unknown
+    _dirtyCount = 0;
+    invalidate();
+    return true;
+}
+
+void SPIFrameBuffer::end() {
+    delete[] _buffer;
+    _buffer = nullptr;
+    _dirtyCount = 0;
+}
+
+void SPIFrameBuffer::drawPixel(int16_t x, int16_t y, uint16_t color) {
+    if(!_buffer || x < 0 || y < 0 || x >= _width || y >= _height) {
+        return;
+    }
+    _buffer[(uint32_t)y * _width + x] = (color >> 8) | (color << 8);
+    _addDirty({ (uint16_t)x, (uint16_t)y, (uint16_t)x, (uint16_t)y });
+}
+
+void SPIFrameBuffer::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    if(x < 0) { w += x; x = 0; }
+    if(y < 0) { h += y; y = 0; }
+    if(x + w > _width) w = _width - x;
+    if(y + h > _height) h = _height - y;
+    if(!_buffer || w <= 0 || h <= 0) {
+        return;
+    }
+    const uint16_t pixel = (color >> 8) | (color << 8);
+    for(int16_t row = 0; row < h; row++) {
+        uint16_t * p = _buffer + (uint32_t)(y + row) * _width + x;
+        for(int16_t col = 0; col < w; col++) {
+            *(p++) = pixel;
+        }
+    }
+    _addDirty({ (uint16_t)x, (uint16_t)y, (uint16_t)(x + w - 1), (uint16_t)(y + h - 1) });
+}
+
+void SPIFrameBuffer::invalidate(int16_t x, int16_t y, int16_t w, int16_t h) {
+    if(x < 0) { w += x; x = 0; }
+    if(y < 0) { h += y; y = 0; }
+    if(x + w > _width) w = _width - x;
+    if(y + h > _height) h = _height - y;
+    if(!_buffer || w <= 0 || h <= 0) {
+        return;
+    }
+    _addDirty({ (uint16_t)x, (uint16_t)y, (uint16_t)(x + w - 1), (uint16_t)(y + h - 1) });
+}
+
+SPIFrameBuffer::Rect SPIFrameBuffer::_unite(const Rect & a, const Rect & b) {
+    return { std::min(a.x0, b.x0), std::min(a.y0, b.y0), std::max(a.x1, b.x1), std::max(a.y1, b.y1) };
+}
+
+void SPIFrameBuffer::_addDirty(Rect r) {
+    // Merge while it costs no more pixels than sending both, each window
+    // also has a fixed cost of a few commands
+    for(uint8_t i = 0; i < _dirtyCount;) {
+        Rect u = _unite(_dirty[i], r);
+        if(u.area() <= _dirty[i].area() + r.area() + 64) {
+            r = u;
+            _dirty[i] = _dirty[--_dirtyCount];
+            i = 0;
+        } else {
+            i++;
+        }
+    }
+    if(_dirtyCount < MAX_DIRTY) {
+        _dirty[_dirtyCount++] = r;
+        return;
+    }
+    // Full, grow the one that needs the fewest extra pixels
+    uint8_t best = 0;
+    uint32_t bestGrowth = UINT32_MAX;
+    for(uint8_t i = 0; i < _dirtyCount; i++) {
+        uint32_t growth = _unite(_dirty[i], r).area() - _dirty[i].area();
+        if(growth < bestGrowth) {
+            best = i;
+            bestGrowth = growth;
+        }
+    }
+    r = _unite(_dirty[best], r);
+    _dirty[best] = _dirty[--_dirtyCount];
+    _addDirty(r);
+}
+
+void SPIFrameBuffer::_command(uint8_t cmd) {
+    digitalWrite(_dcPin, LOW);
+    SPI.write(cmd);
+    digitalWrite(_dcPin, HIGH);
+}
+
+void SPIFrameBuffer::_setWindow(const Rect & r) {
+    if(_window) {
+        _window(r.x0, r.y0, r.x1, r.y1);
+        return;
+    }
+    _command(0x2A);
+    SPI.write32(((uint32_t)r.x0 << 16) | r.x1, true);
+    _command(0x2B);
+    SPI.write32(((uint32_t)r.y0 << 16) | r.y1, true);
+    _command(0x2C);
+}
+
+uint32_t SPIFrameBuffer::push() {
+    uint32_t pixels = 0;
+    uint32_t fifo[16];
+    uint8_t * fifoBytes = (uint8_t *) fifo;
+
+    for(uint8_t i = 0; i < _dirtyCount; i++) {
+        const Rect & r = _dirty[i];
+        if(_csPin >= 0) {
+            digitalWrite(_csPin, LOW);
+        }
+        _setWindow(r);
+
+        // Rows are not contiguous in the buffer, pack them into full FIFO loads
+        const uint32_t rowBytes = (r.x1 - r.x0 + 1) * 2;
+        uint32_t used = 0;
+        for(uint16_t y = r.y0; y <= r.y1; y++) {
+            const uint8_t * src = (const uint8_t *)(_buffer + (uint32_t)y * _width + r.x0);
+            uint32_t left = rowBytes;
+            while(left) {
+                uint32_t n = std::min(left, (uint32_t)sizeof(fifo) - used);
+                memcpy(fifoBytes + used, src, n);
+                used += n;
+                src += n;
+                left -= n;
+                if(used == sizeof(fifo)) {
+                    SPI.writeBytes(fifoBytes, used);
+                    used = 0;
+                }
+            }
+        }
+        if(used) {
+            SPI.writeBytes(fifoBytes, used);
+        }
+
+        if(_csPin >= 0) {
+            digitalWrite(_csPin, HIGH);
+        }
+        pixels += r.area();
+    }
+    _dirtyCount = 0;
+    return pixels;
+}
@@ -0,0 +1,87 @@
+/*
+ SPIFrameBuffer.h - RGB565 framebuffer for SPI displays, pushing only
+                    the regions that changed
+
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef _SPIFRAMEBUFFER_H_INCLUDED
+#define _SPIFRAMEBUFFER_H_INCLUDED
+
+#include <SPI.h>
+
+/*
+  Drawing goes to a framebuffer in RAM and records the changed area in a
+  short list of rectangles, overlapping or nearby ones are merged.  push()
+  then sends each rectangle as one memory write, packing its rows into full
+  64 byte FIFO loads.  Pixels are kept in the byte order the panel expects,
+  so buffer() can be written directly followed by invalidate().
+
+  By default the panel window is set with the MIPI DCS commands used by the
+  ILI9341, ST7735, ST7789 and similar controllers (0x2A, 0x2B, 0x2C).
+*/
+class SPIFrameBuffer {
+public:
+  // Addresses the panel for x0..x1, y0..y1 (inclusive).  Called with CS low,
+  // it must leave DC high for the pixel data.
+  typedef void (*WindowCallback)(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1);
+
+  SPIFrameBuffer(uint16_t width, uint16_t height, int8_t csPin, int8_t dcPin);
+  ~SPIFrameBuffer();
+
+  // Allocate the buffer (width * height * 2 bytes), false if out of memory
+  bool begin();
+  void end();
+  void onWindow(WindowCallback cb) { _window = cb; }
+
+  uint16_t width() const { return _width; }
+  uint16_t height() const { return _height; }
+  uint16_t * buffer() { return _buffer; }
+
+  void drawPixel(int16_t x, int16_t y, uint16_t color);
+  void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+  void fillScreen(uint16_t color) { fillRect(0, 0, _width, _height, color); }
+  // Mark an area as changed after writing to buffer()
+  void invalidate(int16_t x, int16_t y, int16_t w, int16_t h);
+  void invalidate() { invalidate(0, 0, _width, _height); }
+
+  // Send the changed areas using the current SPI settings (MSBFIRST),
+  // returns the number of pixels sent
+  uint32_t push();
+
+protected:
+  struct Rect {
+    uint16_t x0, y0, x1, y1;
+    uint32_t area() const { return (uint32_t)(x1 - x0 + 1) * (y1 - y0 + 1); }
+  };
+
+  static Rect _unite(const Rect & a, const Rect & b);
+  void _addDirty(Rect r);
+  void _setWindow(const Rect & r);
+  void _command(uint8_t cmd);
+
+  enum { MAX_DIRTY = 8 };
+  uint16_t _width;
+  uint16_t _height;
+  int8_t _csPin;
+  int8_t _dcPin;
+  uint16_t * _buffer = nullptr;
+  WindowCallback _window = nullptr;
+  Rect _dirty[MAX_DIRTY];
+  uint8_t _dirtyCount = 0;
+};
+
+#endif
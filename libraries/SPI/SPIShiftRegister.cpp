@@ -0,0 +1,61 @@
+/*
+ SPIShiftRegister.cpp - 74HC595/74HC165 style shift register chains on
+                        the hardware SPI
+
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <GpioPort.h>
+#include "SPIShiftRegister.h"
+
+void SPIShiftRegister::begin() {
+    digitalWrite(_latchPin, LOW);
+    pinMode(_latchPin, OUTPUT);
+}
+
+void SPIShiftRegister::_latch(bool high) {
+    if(_latchPin < 16) {
+        if(high) {
+            gpioPortSet(1 << _latchPin);
+        } else {
+            gpioPortClear(1 << _latchPin);
+        }
+    } else {
+        digitalWrite(_latchPin, high);
+    }
+}
+
+void SPIShiftRegister::write(const uint8_t * data, size_t size) {
+    SPI.beginTransaction(_settings);
+    if((uint32_t)data & 3) {
+        // writeBytes() reads words
+        SPI.transferBytes(data, nullptr, size);
+    } else {
+        SPI.writeBytes(data, size);
+    }
+    _latch(true);
+    _latch(false);
+    SPI.endTransaction();
+}
+
+void SPIShiftRegister::read(uint8_t * data, size_t size) {
+    SPI.beginTransaction(_settings);
+    _latch(true);
+    SPI.transferBytes(nullptr, data, size);
+    _latch(false);
+    SPI.endTransaction();
+}
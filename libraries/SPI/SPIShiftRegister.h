@@ -0,0 +1,58 @@
+/*
+ SPIShiftRegister.h - 74HC595/74HC165 style shift register chains on
+                      the hardware SPI
+
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef _SPISHIFTREGISTER_H_INCLUDED
+#define _SPISHIFTREGISTER_H_INCLUDED
+
+#include <SPI.h>
+
+/*
+  A chain of shift registers on SCLK and MOSI (74HC595, outputs) or SCLK
+  and MISO (74HC165, inputs) with a latch pin, what shiftOut() and
+  shiftIn() do one bit at a time.  Bytes go through the 64 byte FIFO, the
+  bit order is the SPI hardware's, and the latch is driven around each
+  transfer.  The latch pin idles low:
+  - write() shifts the bytes out, then raises and lowers the latch
+    (74HC595 RCLK), the first byte ends in the last register of the chain
+  - read() raises the latch (74HC165 SH/LD, which loaded the inputs while
+    it was low), shifts the bytes in and lowers it again, the first byte
+    comes from the last register of the chain
+  SPI.begin() must have been called.
+*/
+class SPIShiftRegister {
+public:
+  SPIShiftRegister(uint8_t latchPin, uint32_t clock = 8000000, uint8_t bitOrder = MSBFIRST)
+      : _settings(clock, bitOrder, SPI_MODE0), _latchPin(latchPin) {}
+
+  void begin();
+
+  void write(const uint8_t * data, size_t size);
+  void write(uint8_t value) { uint32_t word = value; write((const uint8_t *)&word, 1); }
+  void read(uint8_t * data, size_t size);
+  uint8_t read() { uint32_t word; read((uint8_t *)&word, 1); return word; }
+
+protected:
+  void _latch(bool high);
+
+  SPISettings _settings;
+  uint8_t _latchPin;
+};
+
+#endif
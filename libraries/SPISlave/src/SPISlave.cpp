@@ -19,12 +19,76 @@
   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 */
 #include "SPISlave.h"
+#include <new>
+#include <Schedule.h>
 extern "C" {
 #include "hspi_slave.h"
 }
 
-void SPISlaveClass::_data_rx(uint8_t * data, uint8_t len)
+void IRAM_ATTR SPISlaveClass::_message_rx(const uint8_t * data, uint8_t len)
+{
+    uint8_t offset = 0;
+    if(_msg_fill == 0 && !_msg_dropping) {
+        // First frame of a message
+        _msg_expected = data[0] | (data[1] << 8);
+        offset = 2;
+        if(_msg_expected == 0) {
+            return;
+        }
+        if(_msg_expected > _msg_max || _msg_len[_msg_write]) {
+            _msg_overruns = _msg_overruns + 1;
+            _msg_dropping = true;
+            // In case the delivery of the full buffers could not be scheduled
+            schedule_function_ptr(_s_message_deliver, this);
+        }
+    }
+    uint32_t n = len - offset;
+    if(n > (uint32_t)(_msg_expected - _msg_fill)) {
+        n = _msg_expected - _msg_fill;
+    }
+    if(!_msg_dropping) {
+        uint8_t * dst = _msg_buf[_msg_write] + _msg_fill;
+        for(uint32_t i = 0; i < n; i++) {
+            dst[i] = data[offset + i];
+        }
+    }
+    _msg_fill += n;
+    if(_msg_fill < _msg_expected) {
+        return;
+    }
+    _msg_fill = 0;
+    if(_msg_dropping) {
+        _msg_dropping = false;
+        return;
+    }
+    _msg_len[_msg_write] = _msg_expected;
+    _msg_write ^= 1;
+    schedule_function_ptr(_s_message_deliver, this);
+}
+
+void SPISlaveClass::_message_deliver()
+{
+    // Oldest first, the interrupt may complete the other buffer meanwhile
+    while(_msg_len[_msg_read]) {
+        if(_message_cb) {
+            _message_cb(_msg_buf[_msg_read], _msg_len[_msg_read]);
+        }
+        _msg_len[_msg_read] = 0;
+        _msg_read ^= 1;
+    }
+}
+
+void SPISlaveClass::_s_message_deliver(void *arg)
 {
+    reinterpret_cast<SPISlaveClass*>(arg)->_message_deliver();
+}
+
+void IRAM_ATTR SPISlaveClass::_data_rx(uint8_t * data, uint8_t len)
+{
+    if(_msg_max) {
+        _message_rx(data, len);
+        return;
+    }
     if(_data_cb) {
         _data_cb(data, len);
     }
@@ -47,7 +111,7 @@ void SPISlaveClass::_status_tx(void)
         _status_sent_cb();
     }
 }
-void SPISlaveClass::_s_data_rx(void *arg, uint8_t * data, uint8_t len)
+void IRAM_ATTR SPISlaveClass::_s_data_rx(void *arg, uint8_t * data, uint8_t len)
 {
     reinterpret_cast<SPISlaveClass*>(arg)->_data_rx(data,len);
 }
@@ -110,6 +174,32 @@ void SPISlaveClass::onStatusSent(SpiSlaveSentHandler cb)
 {
     _status_sent_cb = cb;
 }
+bool SPISlaveClass::onMessage(SpiSlaveDataHandler cb, size_t maxLength)
+{
+    if(maxLength > 0xffff) {
+        maxLength = 0xffff;
+    }
+    _msg_max = 0;
+    for(int i = 0; i < 2; i++) {
+        delete[] _msg_buf[i];
+        _msg_buf[i] = (cb && maxLength) ? new (std::nothrow) uint8_t[maxLength] : nullptr;
+        _msg_len[i] = 0;
+    }
+    _msg_fill = 0;
+    _msg_dropping = false;
+    _msg_write = 0;
+    _msg_read = 0;
+    _message_cb = cb;
+    if(!cb || !maxLength) {
+        return true;
+    }
+    if(!_msg_buf[0] || !_msg_buf[1]) {
+        onMessage(nullptr, 0);
+        return false;
+    }
+    _msg_max = maxLength;
+    return true;
+}
 
 #if !defined(NO_GLOBAL_INSTANCES) && !defined(NO_GLOBAL_SPISLAVE)
 SPISlaveClass SPISlave;
@@ -35,6 +35,22 @@ protected:
     SpiSlaveStatusHandler _status_cb;
     SpiSlaveSentHandler _data_sent_cb;
     SpiSlaveSentHandler _status_sent_cb;
+    // Messages are collected in two buffers from the interrupt and handed
+    // to _message_cb from loop() context.  _msg_len[i] is set once buffer i
+    // holds a complete message and is cleared when it has been delivered.
+    SpiSlaveDataHandler _message_cb;
+    uint8_t * _msg_buf[2] = { nullptr, nullptr };
+    volatile uint16_t _msg_len[2] = { 0, 0 };
+    uint16_t _msg_max = 0;
+    uint16_t _msg_expected = 0;
+    uint16_t _msg_fill = 0;
+    bool _msg_dropping = false;
+    uint8_t _msg_write = 0;
+    uint8_t _msg_read = 0;
+    volatile uint32_t _msg_overruns = 0;
+    void _message_rx(const uint8_t * data, uint8_t len);
+    void _message_deliver();
+    static void _s_message_deliver(void *arg);
     void _data_rx(uint8_t * data, uint8_t len);
     void _status_rx(uint32_t data);
     void _data_tx(void);
@@ -50,7 +66,11 @@ public:
         , _data_sent_cb(NULL)
         , _status_sent_cb(NULL)
     {}
-    ~SPISlaveClass() {}
+    ~SPISlaveClass()
+    {
+        delete[] _msg_buf[0];
+        delete[] _msg_buf[1];
+    }
     void begin();
     void begin(uint8_t statusLength);
     void end();
@@ -64,6 +84,17 @@ public:
     void onDataSent(SpiSlaveSentHandler cb);
     void onStatus(SpiSlaveStatusHandler cb);
     void onStatusSent(SpiSlaveSentHandler cb);
+    // Receive whole messages instead of 32 byte frames.  The master starts
+    // each message at a frame boundary with its length as two bytes, low
+    // byte first, and sends the payload in as many frames as needed.  cb is
+    // called from loop()/yield() context with the payload only, while the
+    // next message is received into a second buffer.  Call before begin().
+    bool onMessage(SpiSlaveDataHandler cb, size_t maxLength = 512);
+    // Messages dropped because they were too long or neither buffer was free
+    uint32_t messageOverruns() const
+    {
+        return _msg_overruns;
+    }
 };
 
 #if !defined(NO_GLOBAL_INSTANCES) && !defined(NO_GLOBAL_SPISLAVE)
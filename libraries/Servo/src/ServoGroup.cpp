@@ -0,0 +1,234 @@
+/*
+ServoGroup.cpp - Servos driven from one edge table per refresh frame
+This file is part of the esp8266 core for Arduino environment.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#if defined(ESP8266)
+
+#include <Arduino.h>
+#include <ServoGroup.h>
+#include "core_esp8266_waveform.h"
+
+extern int improved_map(int value, int minIn, int maxIn, int minOut, int maxOut);
+
+// Edges closer than this are busy-waited for instead of returning to the ISR
+#define SPIN_CYCLES microsecondsToClockCycles(4)
+
+ServoGroup* ServoGroup::_active = nullptr;
+
+ServoGroup::ServoGroup()
+{
+  _cnt = 0;
+  memset(_frames, 0, sizeof(_frames));
+  _frame = &_frames[0];
+  _pending = nullptr;
+  _idx = 0;
+  _frameStart = 0;
+  _nextCycle = 0;
+  _periodCycles = 0;
+}
+
+ServoGroup::~ServoGroup() {
+  end();
+}
+
+int ServoGroup::attach(int pin, uint16_t minUs, uint16_t maxUs, int value)
+{
+  if (_cnt >= MAX_SERVO_GROUP || pin < 0 || pin > 16) {
+    return -1;
+  }
+  for (int i = 0; i < _cnt; i++) {
+    if (_pin[i] == pin) {
+      return -1;
+    }
+  }
+  pinMode(pin, OUTPUT);
+  digitalWrite(pin, LOW);
+  int channel = _cnt++;
+  _pin[channel] = pin;
+  // same limits as Servo::attach()
+  _maxUs[channel] = max((uint16_t)250, min((uint16_t)3000, maxUs));
+  _minUs[channel] = max((uint16_t)200, min(_maxUs[channel], minUs));
+  write(channel, value);
+  return channel;
+}
+
+void ServoGroup::detach(int channel)
+{
+  if (channel >= 0 && channel < _cnt) {
+    _pin[channel] = -1;
+  }
+}
+
+bool ServoGroup::begin()
+{
+  if (_active == this) {
+    return true;
+  }
+  if (_active) {
+    return false;
+  }
+  _frame = &_frames[0];
+  _frame->cnt = 0;
+  _frame->mask = 0;
+  _pending = nullptr;
+  _idx = 0;
+  _periodCycles = REFRESH_INTERVAL * ESP.getCpuFreqMHz();
+  _nextCycle = ESP.getCycleCount();
+  _active = this;
+  setTimer1Callback(_onTimer);
+  update();
+  return true;
+}
+
+void ServoGroup::end()
+{
+  if (_active != this) {
+    return;
+  }
+  // An empty frame lets the running one finish and keeps every pin low
+  _waitPending();
+  Frame* next = (_frame == &_frames[0]) ? &_frames[1] : &_frames[0];
+  next->cnt = 0;
+  next->mask = 0;
+  _pending = next;
+  _waitPending();
+  setTimer1Callback(nullptr);
+  _active = nullptr;
+  for (int i = 0; i < _cnt; i++) {
+    if (_pin[i] >= 0) {
+      digitalWrite(_pin[i], LOW);
+    }
+  }
+}
+
+void ServoGroup::write(int channel, int value)
+{
+  if (channel < 0 || channel >= _cnt) {
+    return;
+  }
+  // treat any value less than 200 as angle in degrees, as Servo does
+  if (value < 200) {
+    value = constrain(value, 0, 180);
+    value = improved_map(value, 0, 180, _minUs[channel], _maxUs[channel]);
+  }
+  writeMicroseconds(channel, value);
+}
+
+void ServoGroup::writeMicroseconds(int channel, int value)
+{
+  if (channel < 0 || channel >= _cnt) {
+    return;
+  }
+  _valueUs[channel] = constrain(value, _minUs[channel], _maxUs[channel]);
+}
+
+int ServoGroup::read(int channel)
+{
+  if (channel < 0 || channel >= _cnt) {
+    return 0;
+  }
+  return improved_map(_valueUs[channel], _minUs[channel], _maxUs[channel], 0, 180);
+}
+
+int ServoGroup::readMicroseconds(int channel)
+{
+  if (channel < 0 || channel >= _cnt) {
+    return 0;
+  }
+  return _valueUs[channel];
+}
+
+void ServoGroup::_waitPending()
+{
+  while (_active == this && _pending) {
+    yield();
+  }
+}
+
+void ServoGroup::update()
+{
+  if (_active != this) {
+    return;
+  }
+  // The buffer not being generated may still be the pending one
+  _waitPending();
+  Frame* next = (_frame == &_frames[0]) ? &_frames[1] : &_frames[0];
+  const uint32_t cpuMHz = ESP.getCpuFreqMHz();
+  next->cnt = 0;
+  next->mask = 0;
+  for (int i = 0; i < _cnt; i++) {
+    if (_pin[i] < 0) {
+      continue;
+    }
+    // insertion sort by pulse width
+    uint32_t at = _valueUs[i] * cpuMHz;
+    int j = next->cnt++;
+    while (j > 0 && next->at[j - 1] > at) {
+      next->at[j] = next->at[j - 1];
+      next->pin[j] = next->pin[j - 1];
+      j--;
+    }
+    next->at[j] = at;
+    next->pin[j] = _pin[i];
+    next->mask |= 1 << _pin[i];
+  }
+  _periodCycles = REFRESH_INTERVAL * cpuMHz;
+  _pending = next;
+}
+
+IRAM_ATTR uint32_t ServoGroup::_onTimer()
+{
+  ServoGroup* g = _active;
+  for (;;) {
+    int32_t toGo = g->_nextCycle - ESP.getCycleCount();
+    if (toGo > (int32_t)SPIN_CYCLES) {
+      return toGo;
+    }
+    while ((int32_t)(g->_nextCycle - ESP.getCycleCount()) > 0) {
+    }
+    Frame* f = g->_frame;
+    if (g->_idx >= f->cnt) {
+      // Start of a frame, every pin of the previous one is low by now
+      if (g->_pending) {
+        f = g->_frame = g->_pending;
+        g->_pending = nullptr;
+      }
+      GPOS = f->mask & 0xffff;
+      if (f->mask & (1 << 16)) {
+        GP16O = 1;
+      }
+      // Widths count from the real rising edge, a late frame only moves the frame
+      g->_frameStart = ESP.getCycleCount();
+      g->_idx = 0;
+    } else {
+      do {
+        uint8_t pin = f->pin[g->_idx];
+        if (pin == 16) {
+          GP16O = 0;
+        } else {
+          GPOC = 1 << pin;
+        }
+        g->_idx++;
+        // drop every pin with the same width at once
+      } while (g->_idx < f->cnt && f->at[g->_idx] == f->at[g->_idx - 1]);
+    }
+    g->_nextCycle = g->_frameStart + (g->_idx < f->cnt ? f->at[g->_idx] : g->_periodCycles);
+  }
+}
+
+#endif
@@ -0,0 +1,96 @@
+/*
+  ServoGroup.h - Servos driven from one edge table per refresh frame
+  This file is part of the esp8266 core for Arduino environment.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+  */
+
+//   Every attached pin goes high at the start of a REFRESH_INTERVAL frame
+//   and drops at its pulse width, walking one table sorted by width, instead
+//   of running one waveform per servo.  Positions written with write() or
+//   writeMicroseconds() are staged and only take effect, all together, at
+//   the first frame after update().
+//
+//   The group runs from the waveform generator's timer1 callback, so only
+//   one group can be active and it cannot be used together with other
+//   setTimer1Callback() users such as Wire's queued transfers.
+//
+//   ServoGroup arm;
+//   int elbow = arm.attach(D1);
+//   int wrist = arm.attach(D2, 500, 2500);
+//   arm.begin();
+//   arm.write(elbow, 90);
+//   arm.write(wrist, 45);
+//   arm.update();
+
+#ifndef ServoGroup_h
+#define ServoGroup_h
+
+#include <Servo.h>
+
+#define MAX_SERVO_GROUP 16
+
+class ServoGroup
+{
+public:
+    ServoGroup();
+    ~ServoGroup();
+    // add a pin to the group, sets pinMode, returns the channel or -1 if failure.
+    // The pin starts pulsing at the next update().
+    int attach(int pin, uint16_t min = DEFAULT_MIN_PULSE_WIDTH, uint16_t max = DEFAULT_MAX_PULSE_WIDTH,
+               int value = DEFAULT_NEUTRAL_PULSE_WIDTH);
+    // remove a channel from the group at the next update()
+    void detach(int channel);
+    // start generating frames, returns false if another group is active
+    bool begin();
+    // finish the running frame and stop, all pins are left low
+    void end();
+    void write(int channel, int value);             // staged, as Servo::write()
+    void writeMicroseconds(int channel, int value); // staged pulse width in microseconds
+    int read(int channel);                          // last written value as an angle
+    int readMicroseconds(int channel);              // last written pulse width
+    // hand all staged values to the next frame.  Waits if the previous
+    // update has not been picked up yet.
+    void update();
+
+protected:
+    struct Frame {
+        uint32_t mask;
+        uint8_t  cnt;
+        uint8_t  pin[MAX_SERVO_GROUP];
+        uint32_t at[MAX_SERVO_GROUP]; // cycles after the frame start, ascending
+    };
+
+    static uint32_t _onTimer();
+    void _waitPending();
+
+    static ServoGroup* _active;
+
+    uint8_t  _cnt;
+    int8_t   _pin[MAX_SERVO_GROUP]; // -1 once detached
+    uint16_t _minUs[MAX_SERVO_GROUP];
+    uint16_t _maxUs[MAX_SERVO_GROUP];
+    uint16_t _valueUs[MAX_SERVO_GROUP];
+
+    Frame           _frames[2];
+    Frame* volatile _frame;   // being generated by the ISR
+    Frame* volatile _pending; // picked up at the next frame start
+    uint8_t  _idx;
+    uint32_t _frameStart;
+    uint32_t _nextCycle;
+    uint32_t _periodCycles;
+};
+
+#endif
@@ -0,0 +1,222 @@
+/*
+  TickerGroup.cpp - many periodic callbacks on a single timer
+
+  This file is part of the esp8266 core for Arduino environment.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <new>
+#include <vector>
+#include <Arduino.h>
+
+#include "c_types.h"
+#include "eagle_soc.h"
+#include "osapi.h"
+
+#include "TickerGroup.h"
+
+TickerGroup::TickerGroup(uint32_t slackMs)
+    : _epoch(millis()), _slack(slackMs)
+{
+    os_timer_setfn(&_etsTimer, _static_callback, this);
+}
+
+TickerGroup::~TickerGroup()
+{
+    os_timer_disarm(&_etsTimer);
+    detachAll();
+}
+
+uint32_t TickerGroup::_add(uint32_t milliseconds, bool repeat, bool scheduled, callback_function_t callback)
+{
+    if (!callback)
+        return 0;
+
+    Entry* entry = new (std::nothrow) Entry { nullptr, 0, milliseconds ? milliseconds : 1, 0, repeat, scheduled, false, std::move(callback) };
+    if (!entry)
+        return 0;
+
+    const uint32_t now = millis();
+    if (repeat)
+    {
+        // next multiple of the period since the epoch
+        entry->deadline = _epoch + ((now - _epoch) / entry->period + 1) * entry->period;
+    }
+    else
+    {
+        entry->deadline = now + milliseconds;
+    }
+    entry->id = _nextId++;
+    if (!_nextId)
+        _nextId = 1;
+
+    _insert(entry);
+    _arm();
+    return entry->id;
+}
+
+// keeps entries with equal deadlines in attach order
+void TickerGroup::_insert(Entry* entry)
+{
+    Entry** link = &_first;
+    while (*link && (int32_t)((*link)->deadline - entry->deadline) <= 0)
+        link = &(*link)->next;
+    entry->next = *link;
+    *link = entry;
+}
+
+TickerGroup::Entry* TickerGroup::_find(uint32_t id) const
+{
+    for (Entry* list : { _first, _due })
+    {
+        for (Entry* entry = list; entry; entry = entry->next)
+        {
+            if (entry->id == id && !entry->detached)
+                return entry;
+        }
+    }
+    return nullptr;
+}
+
+bool TickerGroup::detach(uint32_t id)
+{
+    Entry* entry = _find(id);
+    if (!entry)
+        return false;
+
+    entry->detached = true;
+    if (!_firing)
+    {
+        _sweep(_first);
+        _arm();
+    }
+    return true;
+}
+
+void TickerGroup::detachAll()
+{
+    for (Entry* list : { _first, _due })
+    {
+        for (Entry* entry = list; entry; entry = entry->next)
+            entry->detached = true;
+    }
+    if (!_firing)
+    {
+        _sweep(_first);
+        os_timer_disarm(&_etsTimer);
+    }
+}
+
+bool TickerGroup::active(uint32_t id) const
+{
+    return _find(id);
+}
+
+size_t TickerGroup::size() const
+{
+    size_t count = 0;
+    for (Entry* list : { _first, _due })
+    {
+        for (Entry* entry = list; entry; entry = entry->next)
+            count += !entry->detached;
+    }
+    return count;
+}
+
+void TickerGroup::_sweep(Entry*& list)
+{
+    for (Entry** link = &list; *link;)
+    {
+        Entry* entry = *link;
+        if (entry->detached)
+        {
+            *link = entry->next;
+            delete entry;
+        }
+        else
+        {
+            link = &entry->next;
+        }
+    }
+}
+
+void TickerGroup::_arm()
+{
+    os_timer_disarm(&_etsTimer);
+    if (!_first || _firing)
+        return;
+
+    const int32_t wait = _first->deadline - millis();
+    os_timer_arm(&_etsTimer, wait > 0 ? wait : 0, false);
+}
+
+void TickerGroup::_fire()
+{
+    _firing = true;
+    const uint32_t now = millis();
+
+    Entry** tail = &_due;
+    while (_first && (int32_t)(_first->deadline - now) <= (int32_t)_slack)
+    {
+        *tail = _first;
+        _first = _first->next;
+        tail = &(*tail)->next;
+        *tail = nullptr;
+    }
+
+    std::vector<callback_function_t> later;
+    for (Entry* entry = _due; entry; entry = entry->next)
+    {
+        if (entry->detached)
+            continue;
+        if (entry->scheduled)
+            later.push_back(entry->callback);
+        else
+            entry->callback();
+        if (!entry->repeat)
+            entry->detached = true;
+    }
+    if (!later.empty())
+    {
+        schedule_function([later = std::move(later)]()
+        {
+            for (auto& callback : later)
+                callback();
+        });
+    }
+
+    _sweep(_due);
+    while (_due)
+    {
+        Entry* entry = _due;
+        _due = entry->next;
+        // keep the phase, skipping the periods that were missed
+        do
+        {
+            entry->deadline += entry->period;
+        } while ((int32_t)(entry->deadline - now) <= 0);
+        _insert(entry);
+    }
+    _sweep(_first);
+
+    _firing = false;
+    _arm();
+}
+
+void TickerGroup::_static_callback(void* arg)
+{
+    reinterpret_cast<TickerGroup*>(arg)->_fire();
+}
@@ -0,0 +1,114 @@
+/*
+  TickerGroup.h - many periodic callbacks on a single timer
+
+  This file is part of the esp8266 core for Arduino environment.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef TICKERGROUP_H
+#define TICKERGROUP_H
+
+#include <functional>
+#include <Schedule.h>
+#include <ets_sys.h>
+
+/*
+  A TickerGroup keeps its callbacks in a list sorted by deadline and arms
+  one os_timer for the earliest.  Periodic callbacks fire at multiples of
+  their period counted from the creation of the group, so 100ms and 500ms
+  callbacks fire together every 500ms.  The first call therefore comes
+  within one period of attaching, not exactly one period later.  Callbacks
+  due within `slackMs` of the earliest one run in the same burst.
+
+  The _scheduled variants of one burst run together from a single
+  scheduled function, at the following loop().  Callbacks may attach and
+  detach entries, but must not destroy the group.
+*/
+class TickerGroup
+{
+public:
+    typedef std::function<void(void)> callback_function_t;
+
+    TickerGroup(uint32_t slackMs = 0);
+    ~TickerGroup();
+
+    TickerGroup(const TickerGroup&) = delete;
+    TickerGroup& operator=(const TickerGroup&) = delete;
+
+    // These return an id for detach(), or 0 when out of memory
+
+    // callback will be called in SYS ctx when it is due
+    uint32_t attach_ms(uint32_t milliseconds, callback_function_t callback)
+    {
+        return _add(milliseconds, true, false, std::move(callback));
+    }
+
+    // callback will be called at following loop() after it is due
+    uint32_t attach_ms_scheduled(uint32_t milliseconds, callback_function_t callback)
+    {
+        return _add(milliseconds, true, true, std::move(callback));
+    }
+
+    // callback will be called once in SYS ctx
+    uint32_t once_ms(uint32_t milliseconds, callback_function_t callback)
+    {
+        return _add(milliseconds, false, false, std::move(callback));
+    }
+
+    // callback will be called once at following loop() after it is due
+    uint32_t once_ms_scheduled(uint32_t milliseconds, callback_function_t callback)
+    {
+        return _add(milliseconds, false, true, std::move(callback));
+    }
+
+    bool detach(uint32_t id);
+    void detachAll();
+    bool active(uint32_t id) const;
+    size_t size() const;
+
+protected:
+    struct Entry
+    {
+        Entry* next;
+        uint32_t id;
+        uint32_t period;
+        uint32_t deadline;  // millis()
+        bool repeat;
+        bool scheduled;
+        bool detached;
+        callback_function_t callback;
+    };
+
+    static void _static_callback(void* arg);
+    uint32_t _add(uint32_t milliseconds, bool repeat, bool scheduled, callback_function_t callback);
+    Entry* _find(uint32_t id) const;
+    void _insert(Entry* entry);
+    void _sweep(Entry*& list);
+    void _fire();
+    void _arm();
+
+    Entry* _first = nullptr;
+    Entry* _due = nullptr;      // the burst being run
+    uint32_t _epoch;
+    uint32_t _slack;
+    uint32_t _nextId = 1;
+    bool _firing = false;
+
+private:
+    ETSTimer _etsTimer;
+};
+
+#endif //TICKERGROUP_H
@@ -52,6 +52,7 @@ uint8_t TwoWire::txBufferLength = 0;
 uint8_t TwoWire::transmitting = 0;
 void (*TwoWire::user_onRequest)(void);
 void (*TwoWire::user_onReceive)(size_t);
+void (*TwoWire::user_onReceiveData)(const uint8_t*, size_t);
 
 static int default_sda_pin = SDA;
 static int default_scl_pin = SCL;
@@ -120,6 +121,11 @@ void TwoWire::setClockStretchLimit(uint32_t limit)
     twi_setClockStretchLimit(limit);
 }
 
+bool TwoWire::setSlaveBuffers(size_t rxSize, size_t txSize)
+{
+    return twi_setSlaveBuffers(rxSize, txSize);
+}
+
 size_t TwoWire::requestFrom(uint8_t address, size_t size, bool sendStop)
 {
     if (size > BUFFER_LENGTH)
@@ -179,6 +185,16 @@ uint8_t TwoWire::endTransmission(void)
     return endTransmission(true);
 }
 
+uint8_t TwoWire::transfer(twi_transaction_t* segments, size_t count)
+{
+    return twi_transfer(segments, count);
+}
+
+bool TwoWire::queueTransfer(twi_transaction_t* segments, size_t count)
+{
+    return twi_queueTransfer(segments, count);
+}
+
 size_t TwoWire::write(uint8_t data)
 {
     if (transmitting)
@@ -263,6 +279,13 @@ void TwoWire::flush(void)
 
 void TwoWire::onReceiveService(uint8_t* inBytes, size_t numBytes)
 {
+    if (user_onReceiveData)
+    {
+        // no copy, the twi buffer is not reused before the callback returns
+        user_onReceiveData(inBytes, numBytes);
+        return;
+    }
+
     // don't bother if user hasn't registered a callback
     if (!user_onReceive)
     {
@@ -277,10 +300,12 @@ void TwoWire::onReceiveService(uint8_t* inBytes, size_t numBytes)
 
     // copy twi rx buffer into local read buffer
     // this enables new reads to happen in parallel
-    for (uint8_t i = 0; i < numBytes; ++i)
+    // with setSlaveBuffers() the message may not fit, keep its start
+    if (numBytes > BUFFER_LENGTH)
     {
-        rxBuffer[i] = inBytes[i];
+        numBytes = BUFFER_LENGTH;
     }
+    memcpy(rxBuffer, inBytes, numBytes);
 
     // set rx iterator vars
     rxBufferIndex = 0;
@@ -313,11 +338,20 @@ void TwoWire::onReceive(void (*function)(int))
     // really hope size parameter will not exceed 2^31 :)
     static_assert(sizeof(int) == sizeof(size_t), "something is wrong in Arduino kingdom");
     user_onReceive = reinterpret_cast<void(*)(size_t)>(function);
+    user_onReceiveData = nullptr;
 }
 
 void TwoWire::onReceive(void (*function)(size_t))
 {
     user_onReceive = function;
+    user_onReceiveData = nullptr;
+    twi_enableSlaveMode();
+}
+
+void TwoWire::onReceive(void (*function)(const uint8_t*, size_t))
+{
+    user_onReceiveData = function;
+    user_onReceive = nullptr;
     twi_enableSlaveMode();
 }
 
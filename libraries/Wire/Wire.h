@@ -26,6 +26,7 @@
 
 #include <inttypes.h>
 #include "Stream.h"
+#include "twi.h"
 
 
 
@@ -46,6 +47,7 @@ private:
     static uint8_t transmitting;
     static void (*user_onRequest)(void);
     static void (*user_onReceive)(size_t);
+    static void (*user_onReceiveData)(const uint8_t*, size_t);
     static void onRequestService(void);
     static void onReceiveService(uint8_t*, size_t);
 public:
@@ -58,6 +60,8 @@ public:
     void begin(int);
     void setClock(uint32_t);
     void setClockStretchLimit(uint32_t);
+    // Slave mode buffers larger than TWI_BUFFER_LENGTH, before begin(address)
+    bool setSlaveBuffers(size_t rxSize, size_t txSize);
     void beginTransmission(uint8_t);
     void beginTransmission(int);
     uint8_t endTransmission(void);
@@ -70,6 +74,10 @@ public:
     uint8_t requestFrom(int, int);
     uint8_t requestFrom(int, int, int);
 
+    // Segments joined by repeated STARTs, see twi_transfer()
+    uint8_t transfer(twi_transaction_t* segments, size_t count);
+    bool queueTransfer(twi_transaction_t* segments, size_t count);
+
     virtual size_t write(uint8_t);
     virtual size_t write(const uint8_t *, size_t);
     virtual int available(void);
@@ -78,6 +86,9 @@ public:
     virtual void flush(void);
     void onReceive(void (*)(int));      // arduino api
     void onReceive(void (*)(size_t));   // legacy esp8266 backward compatibility
+    // The received bytes in place, valid until the callback returns, and not
+    // limited to BUFFER_LENGTH.  read() and available() are not used.
+    void onReceive(void (*)(const uint8_t*, size_t));
     void onRequest(void (*)(void));
 
     using Print::write;
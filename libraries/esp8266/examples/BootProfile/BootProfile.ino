@@ -0,0 +1,42 @@
+/*
+  Print where the time went between reset and setup(), then deep-sleep
+  and do it again.  Uncomment FAST_BOOT() to compare with the RF
+  calibration skipped.
+
+  Released to public domain
+*/
+
+#include <Arduino.h>
+
+// FAST_BOOT(40);
+
+void setup() {
+  Serial.begin(115200);
+  Serial.println();
+
+  const unsigned long now = micros();
+  const boot_profile_t& profile = ESP.getBootProfile();
+  Serial.printf("reset reason: %s\n", ESP.getResetReason().c_str());
+  Serial.printf("%-10s %10s %8s %8s\n", "step", "cycles", "us", "delta");
+  static const char* const names[BOOT_MARKS] = {
+    "app_entry", "rf_init", "user_init", "init", "variant",
+    "init_done", "ctors", "setup", "loop",
+  };
+  uint32_t last = 0;
+  for (int i = 0; i < BOOT_MARKS; ++i) {
+    if (!profile.cycles[i]) {
+      continue;
+    }
+    const uint32_t us = boot_profile_us(i);
+    Serial.printf("%-10s %10u %8u %8u\n", names[i], profile.cycles[i], us, us - last);
+    last = us;
+  }
+  Serial.printf("RF calibration %s\n", fastboot_rf_cal_skipped() ? "skipped" : "done");
+  Serial.printf("micros() at setup: %lu\n", now);
+
+  Serial.flush();
+  ESP.deepSleep(5e6);
+}
+
+void loop() {
+}
@@ -0,0 +1,31 @@
+/*
+   I2S DMA PWM on a 74HC595 shift register chain
+
+   DATA (GPIO3/RX) -> SER, BCK (GPIO15) -> SRCLK, WS (GPIO2) -> RCLK.
+   Up to 32 outputs fade in and out at 1kHz with 256 steps while the
+   CPU is free for other work.
+
+   Released to the Public Domain
+*/
+
+#include <i2s.h>
+
+const int channels = 8;
+
+void setup() {
+  if (!i2s_pwm_begin(1000, 256)) {
+    // Out of memory or 24 bit mode selected
+    while (true) {
+      delay(1000);
+    }
+  }
+}
+
+void loop() {
+  static uint16_t level = 0;
+  for (int c = 0; c < channels; c++) {
+    i2s_pwm_write(1UL << c, (level + c * 32) & 255);
+  }
+  level++;
+  delay(10);
+}
@@ -22,16 +22,38 @@ PPPServer::PPPServer(Stream* sio): _sio(sio), _cb(netif_status_cb_s), _enabled(f
 
 bool PPPServer::handlePackets()
 {
-    size_t avail;
-    if ((avail = _sio->available()) > 0)
+    // pppos_input() unescapes and checks the FCS (table driven, PPP_FCS_TABLE)
+    // over whole spans, give it everything received since last time
+    if (_sio->hasPeekBufferAPI())
     {
-        // XXX block peeking would be useful here
-        if (avail > _bufsize)
+        // straight from the uart buffer, two spans when it wraps around
+        for (int spans = 0; spans < 2; spans++)
         {
-            avail = _bufsize;
+            size_t avail = _sio->peekAvailable();
+            if (!avail)
+            {
+                break;
+            }
+            pppos_input(_ppp, (u8_t*)_sio->peekBuffer(), avail);
+            _sio->peekConsume(avail);
+        }
+    }
+    else
+    {
+        size_t avail;
+        while ((avail = _sio->available()) > 0)
+        {
+            if (avail > _bufsize)
+            {
+                avail = _bufsize;
+            }
+            avail = _sio->readBytes(_buf, avail);
+            if (!avail)
+            {
+                break;
+            }
+            pppos_input(_ppp, _buf, avail);
         }
-        avail = _sio->readBytes(_buf, avail);
-        pppos_input(_ppp, _buf, avail);
     }
     return _enabled;
 }
@@ -251,14 +251,10 @@ ENC28J60::setregbank(uint8_t new_bank)
 void
 ENC28J60::writedata(const uint8_t *data, int datalen)
 {
-    int i;
     enc28j60_arch_spi_select();
     /* The Write Buffer Memory (WBM) command is 0 1 1 1 1 0 1 0  */
     SPI.transfer(0x7a);
-    for (i = 0; i < datalen; i++)
-    {
-        SPI.transfer(data[i]);
-    }
+    SPI.writeBytes(data, datalen);
     enc28j60_arch_spi_deselect();
 }
 /*---------------------------------------------------------------------------*/
@@ -271,16 +267,12 @@ ENC28J60::writedatabyte(uint8_t byte)
 int
 ENC28J60::readdata(uint8_t *buf, int len)
 {
-    int i;
     enc28j60_arch_spi_select();
     /* THe Read Buffer Memory (RBM) command is 0 0 1 1 1 0 1 0 */
     SPI.transfer(0x3a);
-    for (i = 0; i < len; i++)
-    {
-        buf[i] = SPI.transfer(0);
-    }
+    SPI.transferBytes(nullptr, buf, len);
     enc28j60_arch_spi_deselect();
-    return i;
+    return len;
 }
 /*---------------------------------------------------------------------------*/
 uint8_t
@@ -36,18 +36,19 @@
 #include "w5100.h"
 
 
+// The W5100 has no sequential mode on SPI: every byte is a 4 byte frame of
+// its own, opcode, address and data, ended by raising CS.  Each frame goes
+// out as a single 32 bit FIFO transfer rather than four byte transfers.
+
 uint8_t Wiznet5100::wizchip_read(uint16_t address)
 {
-    uint8_t ret;
+    uint8_t frame[4] = { 0x0F, (uint8_t)(address >> 8), (uint8_t)address, 0 };
 
     wizchip_cs_select();
-    _spi.transfer(0x0F);
-    _spi.transfer((address & 0xFF00) >>  8);
-    _spi.transfer((address & 0x00FF) >>  0);
-    ret = _spi.transfer(0);
+    _spi.transferBytes(frame, frame, sizeof(frame));
     wizchip_cs_deselect();
 
-    return ret;
+    return frame[3];
 }
 
 uint16_t Wiznet5100::wizchip_read_word(uint16_t address)
@@ -67,10 +68,7 @@ void Wiznet5100::wizchip_read_buf(uint16_t address, uint8_t* pBuf, uint16_t len)
 void Wiznet5100::wizchip_write(uint16_t address, uint8_t wb)
 {
     wizchip_cs_select();
-    _spi.transfer(0xF0);
-    _spi.transfer((address & 0xFF00) >>  8);
-    _spi.transfer((address & 0x00FF) >>  0);
-    _spi.transfer(wb);    // Data write (write 1byte data)
+    _spi.write32(((uint32_t)0xF0 << 24) | ((uint32_t)address << 8) | wb, true);
     wizchip_cs_deselect();
 }
 
@@ -61,8 +61,6 @@ uint16_t Wiznet5500::wizchip_read_word(uint8_t block, uint16_t address)
 
 void Wiznet5500::wizchip_read_buf(uint8_t block, uint16_t address, uint8_t* pBuf, uint16_t len)
 {
-    uint16_t i;
-
     wizchip_cs_select();
 
     block |= AccessModeRead;
@@ -70,10 +68,8 @@ void Wiznet5500::wizchip_read_buf(uint8_t block, uint16_t address, uint8_t* pBuf
     wizchip_spi_write_byte((address & 0xFF00) >> 8);
     wizchip_spi_write_byte((address & 0x00FF) >> 0);
     wizchip_spi_write_byte(block);
-    for (i = 0; i < len; i++)
-    {
-        pBuf[i] = wizchip_spi_read_byte();
-    }
+    // sequential data mode: the whole buffer in FIFO sized bursts
+    _spi.transferBytes(nullptr, pBuf, len);
 
     wizchip_cs_deselect();
 }
@@ -100,8 +96,6 @@ void Wiznet5500::wizchip_write_word(uint8_t block, uint16_t address, uint16_t wo
 
 void Wiznet5500::wizchip_write_buf(uint8_t block, uint16_t address, const uint8_t* pBuf, uint16_t len)
 {
-    uint16_t i;
-
     wizchip_cs_select();
 
     block |= AccessModeWrite;
@@ -109,10 +103,7 @@ void Wiznet5500::wizchip_write_buf(uint8_t block, uint16_t address, const uint8_
     wizchip_spi_write_byte((address & 0xFF00) >> 8);
     wizchip_spi_write_byte((address & 0x00FF) >> 0);
     wizchip_spi_write_byte(block);
-    for (i = 0; i < len; i++)
-    {
-        wizchip_spi_write_byte(pBuf[i]);
-    }
+    _spi.writeBytes(pBuf, len);
 
     wizchip_cs_deselect();
 }
@@ -321,6 +312,19 @@ boolean Wiznet5500::begin(const uint8_t *mac_address)
     return true;
 }
 
+void Wiznet5500::enableRecvInterrupt()
+{
+    // INTn goes low on received data on socket 0
+    setSn_IR(0xFF);
+    setSn_IMR(Sn_IR_RECV);
+    setSIMR(0x01);
+}
+
+void Wiznet5500::clearRecvInterrupt()
+{
+    setSn_IR(Sn_IR_RECV);
+}
+
 void Wiznet5500::end()
 {
     setSn_CR(Sn_CR_CLOSE);
@@ -363,8 +367,8 @@ uint16_t Wiznet5500::readFrameSize()
     uint8_t head[2];
     uint16_t data_len = 0;
 
+    // no RECV command yet: readFrameData() or discardFrame() completes it
     wizchip_recv_data(head, 2);
-    setSn_CR(Sn_CR_RECV);
 
     data_len = head[0];
     data_len = (data_len << 8) + head[1];
@@ -87,9 +87,20 @@ protected:
 
     static constexpr bool interruptIsPossible()
     {
-        return false;
+        return true;
     }
 
+    /**
+        Drive the INTn pin (active low) when a frame is received
+    */
+    void enableRecvInterrupt();
+
+    /**
+        Acknowledge the receive interrupt, to be called before
+        reading the pending frames
+    */
+    void clearRecvInterrupt();
+
     /**
         Read an Ethernet frame size
         @return the length of data do receive
@@ -550,6 +561,15 @@ private:
         return wizchip_read(BlockSelectCReg, _IMR_);
     }
 
+    /**
+        Set @ref SIMR register
+        @param (uint8_t)simr Value to set @ref SIMR register.
+    */
+    inline void setSIMR(uint8_t simr)
+    {
+        wizchip_write(BlockSelectCReg, SIMR, simr);
+    }
+
     /**
         Set @ref PHYCFGR register
         @param (uint8_t)phycfgr Value to set @ref PHYCFGR register.
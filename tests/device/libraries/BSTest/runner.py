@@ -14,6 +14,7 @@ try:
 except:
     from ConfigParser import ConfigParser
 import itertools
+import json
 try:
     from urllib.parse import urlparse, urlencode
 except ImportError:
@@ -53,6 +54,7 @@ class BSTestRunner(object):
         self.name = name
         self.mocks = mocks
         self.env_vars = env_vars
+        self.bench_results = []
 
     def get_test_list(self):
         self.sp.sendline('-1')
@@ -117,6 +119,7 @@ class BSTestRunner(object):
                     if extra_env is not None:
                         self.update_env(extra_env)
                 t_start = time.time()
+                self.test_name = name
                 result = self.run_test(index)
                 if name in self.mocks:
                     debug_print('tearing down mocks')
@@ -159,9 +162,13 @@ class BSTestRunner(object):
                             EOF,
                             'Exception',
                             'ets Jan  8 2013',
-                            'wdt reset'])
+                            'wdt reset',
+                            r'>>>>>bs_test_bench name="([^"]*?)" ops=(\d+) bytes=(\d+) cycles=(\d+) min=(\d+) max=(\d+) mhz=(\d+)'])
             if res == 0:
                 continue
+            elif res == 7:
+                self.add_bench_result(self.sp.match)
+                continue
             elif res == 1:
                 test_result = self.sp.match.group(2)
                 if test_result == '1':
@@ -186,6 +193,23 @@ class BSTestRunner(object):
         if timeout <= 0:
             return BSTestRunner.TIMEOUT
 
+    def add_bench_result(self, m):
+        ops, total, cycles, low, high, mhz = [int(m.group(i)) for i in range(2, 8)]
+        ns = cycles * 1000.0 / mhz if mhz else 0.0
+        result = {'name': m.group(1),
+                  'test': self.test_name,
+                  'iterations': ops,
+                  'cycles_per_op': cycles,
+                  'min_cycles': low,
+                  'max_cycles': high,
+                  'mhz': mhz,
+                  'ns_per_op': ns}
+        if total and ops:
+            result['bytes_per_op'] = total / ops
+            result['mb_per_s'] = (total / ops) * 1000.0 / ns if ns else 0.0
+        debug_print('bench', result)
+        self.bench_results.append(result)
+
     def update_env(self, env_to_set):
         for env_kv in env_to_set:
             self.sp.sendline('setenv "{}" "{}"'.format(env_kv[0], env_kv[1]))
@@ -244,7 +268,7 @@ def spawn_exec(name):
 def run_tests(spawn, name, mocks, env_vars):
     tw = BSTestRunner(spawn, name, mocks, env_vars)
     tw.get_test_list()
-    return tw.run_tests()
+    return tw.run_tests(), tw.bench_results
 
 def parse_args():
     parser = argparse.ArgumentParser(description='BS test runner')
@@ -254,6 +278,7 @@ def parse_args():
     parser.add_argument('-n', '--name', help='Test run name')
     parser.add_argument('-o', '--output', help='Output JUnit format test report')
     parser.add_argument('-m', '--mock', help='Set python script to use for mocking purposes')
+    parser.add_argument('-b', '--bench-output', help='Output benchmark results, one JSON object per line')
     parser.add_argument('--env-file', help='File containing a list of environment variables to set', type=argparse.FileType('r'))
     return parser.parse_args()
 
@@ -286,10 +311,14 @@ def main():
         mocks_mod = imp.load_source('mocks', args.mock)
         mocks = mock_decorators.env
     with spawn_func(spawn_arg) as sp:
-        ts = run_tests(sp, name, mocks, env_vars)
+        ts, bench = run_tests(sp, name, mocks, env_vars)
         if args.output:
             with open(args.output, "w") as f:
                 TestSuite.to_file(f, [ts], encoding='raw_unicode_escape')
+        if args.bench_output:
+            with open(args.bench_output, "w") as f:
+                for result in bench:
+                    f.write(json.dumps(result) + '\n')
         return 0
 
 if __name__ == '__main__':
@@ -68,6 +68,14 @@ inline void fatal() {
     ESP.restart();
 }
 
+inline uint32_t cycles() {
+    return esp_get_cycle_count();
+}
+
+inline uint32_t cycles_mhz() {
+    return ESP.getCpuFreqMHz();
+}
+
 } // namespace bs
 
 #endif //BS_ARDUINO_H
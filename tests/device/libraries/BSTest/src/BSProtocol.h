@@ -29,6 +29,12 @@ void output_test_end(IO& io, bool success, size_t checks, size_t failed_checks,
     io.printf(BS_LINE_PREFIX "end line=%d result=%d checks=%d failed_checks=%d\n", line, success, checks, failed_checks);
 }
 
+template<typename IO>
+void output_bench_result(IO& io, const char* name, uint32_t ops, uint32_t bytes, uint32_t cycles, uint32_t min, uint32_t max, uint32_t mhz)
+{
+    io.printf(BS_LINE_PREFIX "bench name=\"%s\" ops=%u bytes=%u cycles=%u min=%u max=%u mhz=%u\n", name, ops, bytes, cycles, min, max, mhz);
+}
+
 template<typename IO>
 void output_menu_begin(IO& io)
 {
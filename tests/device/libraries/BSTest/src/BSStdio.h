@@ -2,7 +2,10 @@
 #define BS_STDIO_H
 
 #include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
 #include <exception>
+#include <chrono>
 
 namespace bs
 {
@@ -43,6 +46,16 @@ inline void fatal() {
     throw std::runtime_error("fatal error");
 }
 
+/* nanoseconds, reported as a 1000MHz cycle counter */
+inline uint32_t cycles() {
+    return (uint32_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+inline uint32_t cycles_mhz() {
+    return 1000;
+}
+
 } // namespace bs
 
 #endif //BS_STDIO_H
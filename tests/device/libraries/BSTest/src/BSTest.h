@@ -89,6 +89,7 @@ struct Env {
     std::function<void(void)> m_check_pass;
     std::function<void(size_t)> m_check_fail;
     std::function<void(size_t)> m_fail;
+    std::function<void(const char*, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t)> m_bench;
     Registry m_registry;
 };
 
@@ -104,6 +105,9 @@ public:
         g_env.m_check_pass = std::bind(&Tself::check_pass, this);
         g_env.m_check_fail = std::bind(&Tself::check_fail, this, std::placeholders::_1);
         g_env.m_fail = std::bind(&Tself::fail, this, std::placeholders::_1);
+        g_env.m_bench = std::bind(&Tself::bench, this, std::placeholders::_1, std::placeholders::_2,
+                                  std::placeholders::_3, std::placeholders::_4, std::placeholders::_5,
+                                  std::placeholders::_6);
     }
 
     ~Runner()
@@ -111,6 +115,7 @@ public:
         g_env.m_check_pass = 0;
         g_env.m_check_fail = 0;
         g_env.m_fail = 0;
+        g_env.m_bench = 0;
     }
 
     void run()
@@ -136,6 +141,11 @@ public:
         bs::fatal();
     }
 
+    void bench(const char* name, uint32_t ops, uint32_t bytes, uint32_t cycles, uint32_t min, uint32_t max)
+    {
+        protocol::output_bench_result(m_io, name, ops, bytes, cycles, min, max, cycles_mhz());
+    }
+
 protected:
     bool do_menu()
     {
@@ -202,6 +212,74 @@ inline void require(bool condition, size_t line)
     }
 }
 
+/*
+  Times what runs between start() and stop() with the CPU cycle counter.
+  report() hands the mean, min and max cycles of one operation to the
+  runner, which saves them with --bench-output.  A single measurement
+  must stay under 2^32 cycles (26s at 160MHz).
+*/
+class Bench
+{
+public:
+    Bench(const char* name) : m_name(name)
+    {
+    }
+
+    void start()
+    {
+        m_start = cycles();
+    }
+
+    // `ops` operations moving `bytes` bytes ran since start()
+    uint32_t stop(uint32_t bytes = 0, uint32_t ops = 1)
+    {
+        uint32_t elapsed = cycles() - m_start;
+        add(elapsed, bytes, ops);
+        return elapsed;
+    }
+
+    void add(uint32_t elapsed, uint32_t bytes = 0, uint32_t ops = 1)
+    {
+        if (!ops) {
+            return;
+        }
+        uint32_t each = elapsed / ops;
+        if (!m_ops || each < m_min) {
+            m_min = each;
+        }
+        if (each > m_max) {
+            m_max = each;
+        }
+        m_total += elapsed;
+        m_ops += ops;
+        m_bytes += bytes;
+    }
+
+    uint32_t ops() const
+    {
+        return m_ops;
+    }
+
+    uint32_t mean() const
+    {
+        return m_ops ? (uint32_t)(m_total / m_ops) : 0;
+    }
+
+    void report() const
+    {
+        g_env.m_bench(m_name, m_ops, m_bytes, mean(), m_min, m_max);
+    }
+
+protected:
+    const char* m_name;
+    uint32_t m_start = 0;
+    uint64_t m_total = 0;
+    uint32_t m_ops = 0;
+    uint32_t m_bytes = 0;
+    uint32_t m_min = 0;
+    uint32_t m_max = 0;
+};
+
 } // ::bs
 
 #define BS_NAME_LINE2( name, line ) name##line
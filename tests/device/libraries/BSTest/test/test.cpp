@@ -3,6 +3,10 @@
 
 BS_ENV_DECLARE();
 
+bool pretest()
+{
+    return true;
+}
 
 int main()
 {
@@ -58,3 +62,16 @@ TEST_CASE("environment variables can be set and read from python", "[bluesmoke]"
     setenv("VAR_FROM_TEST", "24", 1);
 }
 
+
+TEST_CASE("benchmark results are reported", "[bluesmoke]")
+{
+    bs::Bench bench("bluesmoke_loop");
+    for (int i = 0; i < 10; ++i) {
+        bench.start();
+        for (volatile int j = 0; j < 1000; ++j) {
+        }
+        bench.stop(4);
+    }
+    CHECK(bench.ops() == 10);
+    bench.report();
+}
@@ -0,0 +1,143 @@
+// Benchmarks of the core, each test reports its results with bs::Bench,
+// saved by the runner with --bench-output (make bench)
+
+#include <Arduino.h>
+#include <BSTest.h>
+#include <spi_flash_geometry.h>
+
+BS_ENV_DECLARE();
+
+void setup()
+{
+    Serial.begin(115200);
+    BS_RUN(Serial);
+}
+
+bool pretest()
+{
+    return true;
+}
+
+static void benchHeap(const char* mallocName, const char* freeName, size_t size)
+{
+    constexpr int count = 32;
+    void* blocks[count];
+    bs::Bench allocating(mallocName);
+    bs::Bench freeing(freeName);
+    for (int round = 0; round < 8; ++round) {
+        for (int i = 0; i < count; ++i) {
+            allocating.start();
+            blocks[i] = malloc(size);
+            allocating.stop(size);
+        }
+        // every other block first, so that the rest is freed next to holes
+        for (int i = 0; i < 2 * count; i += 2) {
+            const int index = i < count ? i : i - count + 1;
+            freeing.start();
+            free(blocks[index]);
+            freeing.stop(size);
+        }
+        CHECK(blocks[0] != nullptr);
+    }
+    allocating.report();
+    freeing.report();
+}
+
+TEST_CASE("heap alloc/free cycles", "[bench]")
+{
+    benchHeap("heap_malloc_16", "heap_free_16", 16);
+    benchHeap("heap_malloc_128", "heap_free_128", 128);
+    benchHeap("heap_malloc_1024", "heap_free_1024", 1024);
+}
+
+TEST_CASE("yield overhead", "[bench]")
+{
+    bs::Bench yielding("yield");
+    bs::Bench delaying("delay_0");
+    for (int i = 0; i < 1000; ++i) {
+        yielding.start();
+        yield();
+        yielding.stop();
+        delaying.start();
+        delay(0);
+        delaying.stop();
+    }
+    yielding.report();
+    delaying.report();
+    CHECK(yielding.ops() == 1000);
+}
+
+static volatile uint32_t timerCycles;
+
+static void IRAM_ATTR timerIsr()
+{
+    timerCycles = esp_get_cycle_count();
+}
+
+TEST_CASE("ISR latency", "[bench]")
+{
+    // 10us of timer1 at 80MHz, the latency is what is left after it
+    constexpr uint32_t ticks = 800;
+    const uint32_t expected = ticks * ESP.getCpuFreqMHz() / 80;
+    bs::Bench latency("isr_timer1_latency");
+    timer1_attachInterrupt(timerIsr);
+    timer1_enable(TIM_DIV1, TIM_EDGE, TIM_SINGLE);
+    for (int i = 0; i < 200; ++i) {
+        timerCycles = 0;
+        const uint32_t start = esp_get_cycle_count();
+        timer1_write(ticks);
+        while (!timerCycles && esp_get_cycle_count() - start < 100 * expected) {
+        }
+        if (!timerCycles) {
+            break;
+        }
+        const int32_t cycles = timerCycles - start - expected;
+        latency.add(cycles > 0 ? cycles : 0);
+    }
+    timer1_disable();
+    timer1_detachInterrupt();
+    latency.report();
+    CHECK(latency.ops() == 200);
+}
+
+TEST_CASE("flash read/write/erase rates", "[bench]")
+{
+    constexpr size_t sectors = 16;
+    // free sketch space right after the sketch, the OTA area
+    const uint32_t first = (ESP.getSketchSize() + FLASH_SECTOR_SIZE - 1) / FLASH_SECTOR_SIZE;
+    REQUIRE(ESP.getFreeSketchSpace() >= sectors * FLASH_SECTOR_SIZE);
+
+    uint32_t* data = (uint32_t*)malloc(FLASH_SECTOR_SIZE);
+    uint32_t* readBack = (uint32_t*)malloc(FLASH_SECTOR_SIZE);
+    REQUIRE(data && readBack);
+    for (size_t i = 0; i < FLASH_SECTOR_SIZE / 4; ++i) {
+        data[i] = (i + 100) * 33;
+    }
+
+    bs::Bench erasing("flash_erase_4k");
+    bs::Bench writing("flash_write_4k");
+    bs::Bench reading("flash_read_4k");
+    bool same = true;
+    for (uint32_t sector = first; sector < first + sectors; ++sector) {
+        erasing.start();
+        CHECK(ESP.flashEraseSector(sector));
+        erasing.stop(FLASH_SECTOR_SIZE);
+        writing.start();
+        CHECK(ESP.flashWrite(sector * FLASH_SECTOR_SIZE, data, FLASH_SECTOR_SIZE));
+        writing.stop(FLASH_SECTOR_SIZE);
+        reading.start();
+        CHECK(ESP.flashRead(sector * FLASH_SECTOR_SIZE, readBack, FLASH_SECTOR_SIZE));
+        reading.stop(FLASH_SECTOR_SIZE);
+        same = same && memcmp(data, readBack, FLASH_SECTOR_SIZE) == 0;
+    }
+    erasing.report();
+    writing.report();
+    reading.report();
+    CHECK(same);
+    free(data);
+    free(readBack);
+}
+
+void loop()
+{
+}
@@ -0,0 +1,170 @@
+// Network benchmarks against the servers started by test_bench_net.py,
+// results are saved by the runner with --bench-output (make bench)
+
+#include <Arduino.h>
+#include <BSTest.h>
+#include <ESP8266WiFi.h>
+#include <WiFiUdp.h>
+#include <WiFiClientSecure.h>
+
+BS_ENV_DECLARE();
+
+void setup()
+{
+    Serial.begin(115200);
+    Serial.setDebugOutput(true);
+    BS_RUN(Serial);
+}
+
+bool pretest()
+{
+    WiFi.persistent(false);
+    WiFi.mode(WIFI_STA);
+    WiFi.begin(getenv("STA_SSID"), getenv("STA_PASS"));
+    while (WiFi.status() != WL_CONNECTED) {
+        delay(500);
+    }
+    return true;
+}
+
+#define srv getenv("SERVER_IP")
+
+static uint16_t benchPort()
+{
+    const char* port = getenv("BENCH_PORT");
+    return port ? atoi(port) : 0;
+}
+
+// Must match test_bench_net.py
+constexpr size_t TCP_ROUND = 64 * 1024;
+constexpr int TCP_ROUNDS = 4;
+constexpr size_t UDP_SIZE = 1024;
+constexpr int UDP_PACKETS = 256;
+
+TEST_CASE("TCP send throughput", "[bench]")
+{
+    WiFiClient client;
+    REQUIRE(client.connect(srv, benchPort()));
+    client.setNoDelay(true);
+    uint8_t chunk[1460];
+    for (size_t i = 0; i < sizeof(chunk); ++i) {
+        chunk[i] = i;
+    }
+    bs::Bench sending("tcp_send");
+    size_t total = 0;
+    for (int round = 0; round < TCP_ROUNDS; ++round) {
+        size_t sent = 0;
+        sending.start();
+        while (sent < TCP_ROUND && client.connected()) {
+            sent += client.write(chunk, std::min(sizeof(chunk), TCP_ROUND - sent));
+        }
+        sending.stop(sent);
+        total += sent;
+    }
+    client.flush();
+    client.stop();
+    sending.report();
+    CHECK(total == TCP_ROUND * TCP_ROUNDS);
+}
+
+TEST_CASE("TCP receive throughput", "[bench]")
+{
+    WiFiClient client;
+    REQUIRE(client.connect(srv, benchPort()));
+    uint8_t chunk[1460];
+    bs::Bench receiving("tcp_receive");
+    size_t total = 0;
+    for (int round = 0; round < TCP_ROUNDS; ++round) {
+        size_t received = 0;
+        receiving.start();
+        while (received < TCP_ROUND && (client.connected() || client.available())) {
+            int got = client.read(chunk, std::min(sizeof(chunk), TCP_ROUND - received));
+            if (got > 0) {
+                received += got;
+            } else {
+                yield();
+            }
+        }
+        receiving.stop(received);
+        total += received;
+    }
+    client.stop();
+    receiving.report();
+    CHECK(total == TCP_ROUND * TCP_ROUNDS);
+}
+
+TEST_CASE("UDP send throughput", "[bench]")
+{
+    WiFiUDP udp;
+    REQUIRE(udp.begin(0));
+    IPAddress server;
+    REQUIRE(server.fromString(srv));
+    uint8_t packet[UDP_SIZE];
+    memset(packet, 'u', sizeof(packet));
+    bs::Bench sending("udp_send");
+    int sent = 0;
+    for (int i = 0; i < UDP_PACKETS; ++i) {
+        sending.start();
+        udp.beginPacket(server, benchPort());
+        udp.write(packet, sizeof(packet));
+        const bool ok = udp.endPacket();
+        sending.stop(sizeof(packet));
+        sent += ok;
+        // leave the driver some room, a full queue only measures drops
+        delay(1);
+    }
+    udp.stop();
+    sending.report();
+    CHECK(sent == UDP_PACKETS);
+}
+
+TEST_CASE("UDP round trip", "[bench]")
+{
+    WiFiUDP udp;
+    REQUIRE(udp.begin(0));
+    IPAddress server;
+    REQUIRE(server.fromString(srv));
+    bs::Bench roundTrip("udp_round_trip");
+    for (uint32_t i = 0; i < 50; ++i) {
+        roundTrip.start();
+        udp.beginPacket(server, benchPort());
+        udp.write((const uint8_t*)&i, sizeof(i));
+        udp.endPacket();
+        const uint32_t sentAt = millis();
+        uint32_t echo = ~i;
+        while (millis() - sentAt < 500) {
+            if (udp.parsePacket() == sizeof(echo)) {
+                udp.read((uint8_t*)&echo, sizeof(echo));
+                break;
+            }
+            yield();
+        }
+        if (echo == i) {
+            roundTrip.stop(sizeof(i));
+        }
+    }
+    udp.stop();
+    roundTrip.report();
+    CHECK(roundTrip.ops() >= 45);
+}
+
+TEST_CASE("TLS handshake time", "[bench]")
+{
+    BearSSL::WiFiClientSecure client;
+    client.setInsecure();
+    bs::Bench handshake("tls_handshake_rsa2048");
+    for (int i = 0; i < 3; ++i) {
+        handshake.start();
+        const bool connected = client.connect(srv, benchPort());
+        if (connected) {
+            handshake.stop();
+        }
+        client.stop();
+        CHECK(connected);
+    }
+    handshake.report();
+}
+
+void loop()
+{
+}
@@ -0,0 +1,152 @@
+#!/usr/bin/env python3
+
+from mock_decorators import setup, teardown, setenv
+from threading import Thread
+import socket
+import select
+import ssl
+import sys
+import os
+
+# Must match test_bench_net.ino
+TCP_TOTAL = 4 * 64 * 1024
+UDP_SIZE = 1024
+
+CERT_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'test_sw_http_client')
+
+class Server(object):
+    '''Runs handler(sock) in a thread on a socket bound to a free port'''
+
+    def __init__(self, kind, handler):
+        self.sock = socket.socket(socket.AF_INET, kind)
+        self.sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        self.sock.bind(('0.0.0.0', 0))
+        if kind == socket.SOCK_STREAM:
+            self.sock.listen(1)
+        self.port = self.sock.getsockname()[1]
+        self.running = True
+        self.count = 0
+        self.handler = handler
+        self.thread = Thread(target=self.run)
+        self.thread.start()
+        print('bench server on port %d' % self.port, file=sys.stderr)
+
+    def run(self):
+        while self.running:
+            readable, _, _ = select.select([self.sock], [], [], 0.5)
+            if readable:
+                self.handler(self)
+
+    def accept(self):
+        connection, _ = self.sock.accept()
+        connection.settimeout(10)
+        return connection
+
+    def stop(self):
+        self.running = False
+        self.thread.join()
+        self.sock.close()
+
+server = None
+
+def start(e, kind, handler):
+    global server
+    server = Server(kind, handler)
+    setenv(e, 'BENCH_PORT', str(server.port))
+
+def stop():
+    server.stop()
+    print('bench server handled %d' % server.count, file=sys.stderr)
+    return server.count
+
+
+def tcp_sink(s):
+    connection = s.accept()
+    try:
+        while True:
+            data = connection.recv(65536)
+            if not data:
+                break
+            s.count += len(data)
+    finally:
+        connection.close()
+
+@setup('TCP send throughput')
+def setup_tcp_send(e):
+    start(e, socket.SOCK_STREAM, tcp_sink)
+
+@teardown('TCP send throughput')
+def teardown_tcp_send(e):
+    assert(stop() == TCP_TOTAL)
+
+
+def tcp_source(s):
+    connection = s.accept()
+    try:
+        chunk = bytes(range(256)) * 64
+        while s.count < TCP_TOTAL:
+            s.count += connection.send(chunk[:TCP_TOTAL - s.count])
+        connection.shutdown(socket.SHUT_WR)
+        connection.recv(1)
+    finally:
+        connection.close()
+
+@setup('TCP receive throughput')
+def setup_tcp_receive(e):
+    start(e, socket.SOCK_STREAM, tcp_source)
+
+@teardown('TCP receive throughput')
+def teardown_tcp_receive(e):
+    stop()
+
+
+def udp_sink(s):
+    data, _ = s.sock.recvfrom(2048)
+    if len(data) == UDP_SIZE:
+        s.count += 1
+
+@setup('UDP send throughput')
+def setup_udp_send(e):
+    start(e, socket.SOCK_DGRAM, udp_sink)
+
+@teardown('UDP send throughput')
+def teardown_udp_send(e):
+    # the device only counts what it handed to the driver
+    stop()
+
+
+def udp_echo(s):
+    data, address = s.sock.recvfrom(2048)
+    s.sock.sendto(data, address)
+    s.count += 1
+
+@setup('UDP round trip')
+def setup_udp_round_trip(e):
+    start(e, socket.SOCK_DGRAM, udp_echo)
+
+@teardown('UDP round trip')
+def teardown_udp_round_trip(e):
+    stop()
+
+
+def tls_accept(s, context):
+    connection = s.accept()
+    try:
+        with context.wrap_socket(connection, server_side=True) as tls:
+            s.count += 1
+            tls.recv(1)
+    except (ssl.SSLError, OSError) as e:
+        print('tls: %s' % e, file=sys.stderr)
+    finally:
+        connection.close()
+
+@setup('TLS handshake time')
+def setup_tls_handshake(e):
+    context = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+    context.load_cert_chain(os.path.join(CERT_DIR, 'server.crt'),
+                            os.path.join(CERT_DIR, 'server.key'))
+    start(e, socket.SOCK_STREAM, lambda s: tls_accept(s, context))
+
+@teardown('TLS handshake time')
+def teardown_tls_handshake(e):
+    assert(stop() == 3)
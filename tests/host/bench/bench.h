@@ -0,0 +1,65 @@
+/*
+ bench.h - host side micro-benchmarks
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+  A benchmark body loops on `while (run.next())`, the runner picks the
+  iteration count so that one measurement lasts long enough to be
+  stable.  Setup done before the loop is timed too, keep it small or
+  make it part of what is measured.
+*/
+class BenchRun {
+public:
+    explicit BenchRun(uint64_t iterations): _left(iterations) { }
+
+    bool next() { return _left-- != 0; }
+
+    // Bytes handled by one iteration, reported as a throughput
+    void setBytes(size_t bytes) { _bytes = bytes; }
+    size_t bytes() const { return _bytes; }
+
+private:
+    uint64_t _left;
+    size_t _bytes = 0;
+};
+
+typedef void (*BenchFunction)(BenchRun& run);
+
+struct BenchRegister {
+    BenchRegister(const char* name, BenchFunction function);
+};
+
+// Keeps the compiler from dropping a computation nobody reads
+template <typename T>
+inline void benchKeep(const T& value)
+{
+    asm volatile("" : : "r"(&value) : "memory");
+}
+
+#define BENCH(name) \
+    static void bench_##name(BenchRun& run); \
+    static BenchRegister bench_register_##name(#name, bench_##name); \
+    static void bench_##name(BenchRun& run)
+
+#endif // BENCH_H
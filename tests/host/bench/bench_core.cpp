@@ -0,0 +1,215 @@
+/*
+ bench_core.cpp - benchmarks of String, Print, cbuf, Stream::send, crc32, base64
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <Arduino.h>
+#include <StreamDev.h>
+#include <StreamString.h>
+#include <cbuf.h>
+#include <base64.h>
+#include <coredecls.h>
+#include "bench.h"
+
+static uint8_t data4k[4096];
+
+static struct FillData {
+    FillData()
+    {
+        for (size_t i = 0; i < sizeof(data4k); ++i) {
+            data4k[i] = (uint8_t)(i * 167 + (i >> 7));
+        }
+    }
+} fillData;
+
+BENCH(string_append_small)
+{
+    while (run.next()) {
+        String s;
+        for (int i = 0; i < 32; ++i) {
+            s += "key";
+            s += i;
+            s += ',';
+        }
+        benchKeep(s);
+    }
+}
+
+BENCH(string_append_reserved)
+{
+    while (run.next()) {
+        String s;
+        s.reserve(256);
+        for (int i = 0; i < 32; ++i) {
+            s += "key";
+            s += i;
+            s += ',';
+        }
+        benchKeep(s);
+    }
+}
+
+BENCH(string_copy_compare_sso)
+{
+    String a("short");
+    while (run.next()) {
+        String b(a);
+        b += '!';
+        benchKeep(b == a);
+    }
+}
+
+BENCH(string_number)
+{
+    uint32_t v = 0;
+    while (run.next()) {
+        String s(v += 12345);
+        benchKeep(s);
+    }
+}
+
+BENCH(print_printf)
+{
+    while (run.next()) {
+        benchKeep(devnull.printf("%s=%d %u.%02u\n", "temp", -12, 23u, 45u));
+    }
+}
+
+BENCH(print_printf_long)
+{
+    // Over the 64 byte stack buffer, printf() allocates
+    while (run.next()) {
+        benchKeep(devnull.printf("%s %s %s %08x %u\n", "a longer line of text", "with", "several fields", 0xdeadbeefu, 4000000000u));
+    }
+}
+
+BENCH(print_numbers)
+{
+    while (run.next()) {
+        benchKeep(devnull.print(123456789));
+        benchKeep(devnull.print(3.14159, 3));
+    }
+}
+
+BENCH(cbuf_write_read_256)
+{
+    cbuf buf(1024);
+    char out[256];
+    run.setBytes(sizeof(out));
+    while (run.next()) {
+        buf.write((const char*)data4k, sizeof(out));
+        benchKeep(buf.read(out, sizeof(out)));
+    }
+}
+
+BENCH(cbuf_write_read_bytewise)
+{
+    cbuf buf(1024);
+    run.setBytes(256);
+    while (run.next()) {
+        for (int i = 0; i < 256; ++i) {
+            buf.write((char)i);
+        }
+        for (int i = 0; i < 256; ++i) {
+            benchKeep(buf.read());
+        }
+    }
+}
+
+BENCH(cbuf_pow2_write_read_256)
+{
+    cbuf_pow2 buf(1024);
+    char out[256];
+    run.setBytes(sizeof(out));
+    while (run.next()) {
+        buf.write((const char*)data4k, sizeof(out));
+        benchKeep(buf.read(out, sizeof(out)));
+    }
+}
+
+BENCH(stream_send_to_null_4k)
+{
+    run.setBytes(sizeof(data4k));
+    while (run.next()) {
+        StreamConstPtr from(data4k, sizeof(data4k));
+        benchKeep(from.sendAll(devnull));
+    }
+}
+
+BENCH(stream_send_to_string_4k)
+{
+    StreamString to;
+    to.reserve(sizeof(data4k));
+    run.setBytes(sizeof(data4k));
+    while (run.next()) {
+        StreamConstPtr from(data4k, sizeof(data4k));
+        to.clear();
+        benchKeep(from.sendAll(to));
+    }
+}
+
+BENCH(stream_send_size_1k)
+{
+    run.setBytes(1024);
+    while (run.next()) {
+        StreamConstPtr from(data4k, sizeof(data4k));
+        benchKeep(from.sendSize(devnull, 1024));
+    }
+}
+
+BENCH(crc32_4k)
+{
+    run.setBytes(sizeof(data4k));
+    while (run.next()) {
+        benchKeep(crc32(data4k, sizeof(data4k)));
+    }
+}
+
+BENCH(crc32_64)
+{
+    run.setBytes(64);
+    while (run.next()) {
+        benchKeep(crc32(data4k, 64));
+    }
+}
+
+BENCH(base64_encode_1k)
+{
+    run.setBytes(1024);
+    while (run.next()) {
+        benchKeep(base64::encode(data4k, 1024, false));
+    }
+}
+
+BENCH(base64_encode_1k_to_buffer)
+{
+    char out[1024 / 3 * 4 + 8];
+    run.setBytes(1024);
+    while (run.next()) {
+        benchKeep(base64::encode(data4k, 1024, out));
+    }
+}
+
+BENCH(base64_decode_1k)
+{
+    String in = base64::encode(data4k, 1024, false);
+    uint8_t out[1024 + 4];
+    run.setBytes(1024);
+    while (run.next()) {
+        benchKeep(base64::decode(in.c_str(), in.length(), out));
+    }
+}
@@ -0,0 +1,113 @@
+/*
+ bench_fs.cpp - SPIFFS and LittleFS throughput on the flash mock
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <FS.h>
+#include <LittleFS.h>
+#include "../common/spiffs_mock.h"
+#include "../common/littlefs_mock.h"
+#include "bench.h"
+
+// The mock flash is RAM, so these measure the file system code itself
+static uint8_t chunk[256];
+
+static void writeFile(FS& fs, size_t size)
+{
+    File f = fs.open("/bench", "w");
+    for (size_t done = 0; done < size; done += sizeof(chunk)) {
+        f.write(chunk, sizeof(chunk));
+    }
+    f.close();
+}
+
+static void benchWrite(BenchRun& run, FS& fs)
+{
+    fs.begin();
+    run.setBytes(16 * 1024);
+    while (run.next()) {
+        writeFile(fs, 16 * 1024);
+    }
+    fs.end();
+}
+
+static void benchRead(BenchRun& run, FS& fs)
+{
+    fs.begin();
+    writeFile(fs, 16 * 1024);
+    run.setBytes(16 * 1024);
+    while (run.next()) {
+        File f = fs.open("/bench", "r");
+        while (f.read(chunk, sizeof(chunk)) > 0) {
+        }
+        f.close();
+    }
+    fs.end();
+}
+
+static void benchOpenClose(BenchRun& run, FS& fs)
+{
+    fs.begin();
+    writeFile(fs, 1024);
+    while (run.next()) {
+        File f = fs.open("/bench", "r");
+        benchKeep(f.size());
+        f.close();
+    }
+    fs.end();
+}
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+
+BENCH(spiffs_write_16k)
+{
+    SPIFFS_MOCK_DECLARE(256, 8, 512, "");
+    benchWrite(run, SPIFFS);
+}
+
+BENCH(spiffs_read_16k)
+{
+    SPIFFS_MOCK_DECLARE(256, 8, 512, "");
+    benchRead(run, SPIFFS);
+}
+
+BENCH(spiffs_open_close)
+{
+    SPIFFS_MOCK_DECLARE(256, 8, 512, "");
+    benchOpenClose(run, SPIFFS);
+}
+
+#pragma GCC diagnostic pop
+
+BENCH(littlefs_write_16k)
+{
+    LITTLEFS_MOCK_DECLARE(256, 8, 512, "");
+    benchWrite(run, LittleFS);
+}
+
+BENCH(littlefs_read_16k)
+{
+    LITTLEFS_MOCK_DECLARE(256, 8, 512, "");
+    benchRead(run, LittleFS);
+}
+
+BENCH(littlefs_open_close)
+{
+    LITTLEFS_MOCK_DECLARE(256, 8, 512, "");
+    benchOpenClose(run, LittleFS);
+}
@@ -0,0 +1,119 @@
+/*
+ bench_main.cpp - host side micro-benchmark runner
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <chrono>
+#include <vector>
+#include "bench.h"
+
+struct BenchEntry {
+    const char* name;
+    BenchFunction function;
+};
+
+static std::vector<BenchEntry>& benchList()
+{
+    static std::vector<BenchEntry> list;
+    return list;
+}
+
+BenchRegister::BenchRegister(const char* name, BenchFunction function)
+{
+    benchList().push_back({name, function});
+}
+
+static double measure(BenchFunction function, uint64_t iterations, size_t& bytes)
+{
+    BenchRun run(iterations);
+    auto start = std::chrono::steady_clock::now();
+    function(run);
+    auto end = std::chrono::steady_clock::now();
+    bytes = run.bytes();
+    return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+static void usage(const char* argv0)
+{
+    fprintf(stderr,
+            "usage: %s [-l] [-t ms] [-r repeats] [filter...]\n"
+            "    -l       list the benchmarks\n"
+            "    -t ms    minimum time of one measurement (default 200)\n"
+            "    -r n     measurements per benchmark, the fastest is kept (default 3)\n"
+            "    filter   only run benchmarks whose name contains one of these\n"
+            "One JSON object per benchmark is printed on stdout, see bench/compare.py\n",
+            argv0);
+}
+
+int main(int argc, char* argv[])
+{
+    double minNs = 200e6;
+    int repeats = 3;
+    bool list = false;
+
+    for (int opt; (opt = getopt(argc, argv, "lt:r:h")) > 0; ) {
+        switch (opt) {
+        case 'l': list = true; break;
+        case 't': minNs = atof(optarg) * 1e6; break;
+        case 'r': repeats = atoi(optarg); break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+    if (repeats < 1) {
+        repeats = 1;
+    }
+
+    for (const BenchEntry& bench: benchList()) {
+        bool selected = optind == argc;
+        for (int i = optind; i < argc && !selected; ++i) {
+            selected = strstr(bench.name, argv[i]) != nullptr;
+        }
+        if (!selected) {
+            continue;
+        }
+        if (list) {
+            printf("%s\n", bench.name);
+            continue;
+        }
+
+        // Grow the count until one run lasts minNs
+        size_t bytes;
+        uint64_t iterations = 1;
+        double ns = measure(bench.function, iterations, bytes);
+        while (ns < minNs) {
+            double scale = ns > 0 ? minNs * 1.2 / ns : 100;
+            scale = scale < 2 ? 2 : scale > 100 ? 100 : scale;
+            iterations = (uint64_t)(iterations * scale);
+            ns = measure(bench.function, iterations, bytes);
+        }
+        for (int i = 1; i < repeats; ++i) {
+            double again = measure(bench.function, iterations, bytes);
+            ns = again < ns ? again : ns;
+        }
+
+        double perOp = ns / iterations;
+        printf("{\"name\":\"%s\",\"iterations\":%llu,\"ns_per_op\":%.2f,\"bytes_per_op\":%zu,\"mb_per_s\":%.2f}\n",
+               bench.name, (unsigned long long)iterations, perOp, bytes,
+               bytes ? bytes * 1e3 / perOp : 0.0);
+        fflush(stdout);
+    }
+    return 0;
+}
@@ -0,0 +1,83 @@
+/*
+ bench_umm.cpp - benchmarks of the umm_malloc heap
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "bench.h"
+
+// umm_malloc.cpp is built with UMM_TEST_BUILD for the benchmarks: its
+// functions keep their umm_ names and the heap is this 64KB array
+// instead of the DRAM left after the sketch.
+extern "C" {
+char test_umm_heap[0x10000] __attribute__((aligned(8)));
+size_t test_umm_heap_size = sizeof(test_umm_heap);
+int umm_critical_depth;
+int umm_max_critical_depth;
+
+void umm_init(void);
+void* umm_malloc(size_t size);
+void* umm_realloc(void* ptr, size_t size);
+void umm_free(void* ptr);
+}
+
+BENCH(umm_malloc_free_32)
+{
+    umm_init();
+    while (run.next()) {
+        void* p = umm_malloc(32);
+        benchKeep(p);
+        umm_free(p);
+    }
+}
+
+BENCH(umm_churn_64_blocks)
+{
+    // Frees and allocates random sizes (8 to 519 bytes) among 64 live
+    // blocks, the heap fragments as it would on a busy device
+    void* live[64] = { };
+    uint32_t seed = 1;
+    auto rand32 = [&seed]() {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        return seed;
+    };
+
+    umm_init();
+    while (run.next()) {
+        uint32_t r = rand32();
+        void*& slot = live[r & 63];
+        umm_free(slot);
+        slot = umm_malloc(8 + ((r >> 8) & 511));
+        benchKeep(slot);
+    }
+}
+
+BENCH(umm_realloc_grow_1k)
+{
+    umm_init();
+    while (run.next()) {
+        void* p = nullptr;
+        for (size_t size = 16; size <= 1024; size += 16) {
+            p = umm_realloc(p, size);
+        }
+        benchKeep(p);
+        umm_free(p);
+    }
+}
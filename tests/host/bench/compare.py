@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+#
+# Compares two runs of the host benchmarks (make bench BENCHOUT=...)
+# or of the device ones (tests/device: make BENCH=1 all, bench_report.json)
+#
+#    compare.py before.json after.json [-t percent]
+#
+# Prints the time per operation of both runs and the change for each
+# benchmark, and exits with 1 when one got slower by more than the
+# threshold (10% by default).
+#
+# This file is part of the esp8266 core for Arduino environment.
+#
+# This library is free software; you can redistribute it and/or
+# modify it under the terms of the GNU Lesser General Public
+# License as published by the Free Software Foundation; either
+# version 2.1 of the License, or (at your option) any later version.
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    results = {}
+    with open(path) as f:
+        for line in f:
+            line = line.strip()
+            if line.startswith('{'):
+                entry = json.loads(line)
+                results[entry['name']] = entry
+    return results
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Compare two host benchmark runs')
+    parser.add_argument('before')
+    parser.add_argument('after')
+    parser.add_argument('-t', '--threshold', type=float, default=10.0,
+                        help='slowdown in percent reported as a regression')
+    args = parser.parse_args()
+
+    before = load(args.before)
+    after = load(args.after)
+
+    regressions = 0
+    print('%-32s %12s %12s %8s' % ('benchmark', 'before ns', 'after ns', 'change'))
+    for name in sorted(set(before) | set(after)):
+        if name not in before or name not in after:
+            print('%-32s %12s %12s' % (name,
+                  '%.2f' % before[name]['ns_per_op'] if name in before else '-',
+                  '%.2f' % after[name]['ns_per_op'] if name in after else '-'))
+            continue
+        old = before[name]['ns_per_op']
+        new = after[name]['ns_per_op']
+        change = (new - old) * 100.0 / old if old else 0.0
+        mark = ''
+        if change > args.threshold:
+            mark = ' <-- slower'
+            regressions += 1
+        print('%-32s %12.2f %12.2f %+7.1f%%%s' % (name, old, new, change, mark))
+
+    return 1 if regressions else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,26 @@
+// DNSServer under load: make load LOAD_SKETCH=bench/load/DNSServerLoad/DNSServerLoad
+// LOAD="dns 127.0.0.1:9053" (see README.txt)
+
+#include <ESP8266WiFi.h>
+#include <DNSServer.h>
+
+DNSServer dnsServer;
+
+void setup() {
+  Serial.begin(115200);
+  WiFi.mode(WIFI_STA);
+  WiFi.begin();
+
+  const IPAddress ip(192, 168, 4, 1);
+  dnsServer.setErrorReplyCode(DNSReplyCode::NonExistentDomain);
+  dnsServer.start(53, "esp8266.local", ip);
+  dnsServer.addRecord("*.example.com", IPAddress(192, 168, 4, 2));
+  for (int i = 0; i < 16; i++) {
+    dnsServer.addRecord((String("device") + i + ".lan").c_str(), IPAddress(192, 168, 5, i));
+  }
+  Serial.println("DNSServerLoad ready");
+}
+
+void loop() {
+  dnsServer.processRequests();
+}
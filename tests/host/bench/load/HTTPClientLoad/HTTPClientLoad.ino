@@ -0,0 +1,49 @@
+// HTTPClient under load: make load LOAD_SKETCH=bench/load/HTTPClientLoad/HTTPClientLoad
+// LOAD="http-server 8266" (see README.txt)
+//
+// Fetches the same URL over and over, reusing the connection, and prints
+// the request rate every 100 requests.
+
+#include <ESP8266WiFi.h>
+#include <ESP8266HTTPClient.h>
+#include <StreamDev.h>
+
+#ifndef LOAD_URL
+#define LOAD_URL "http://127.0.0.1:8266/"
+#endif
+
+WiFiClient client;
+HTTPClient http;
+uint32_t requests = 0;
+uint32_t failures = 0;
+uint32_t since = 0;
+
+void setup() {
+  Serial.begin(115200);
+  WiFi.mode(WIFI_STA);
+  WiFi.begin();
+  http.setReuse(true);
+  since = millis();
+}
+
+void loop() {
+  if (!http.begin(client, LOAD_URL)) {
+    failures++;
+    delay(100);
+    return;
+  }
+  const int code = http.GET();
+  if (code == HTTP_CODE_OK) {
+    http.writeToStream(&devnull);
+  } else {
+    failures++;
+  }
+  http.end();
+
+  if (++requests % 100 == 0) {
+    const uint32_t now = millis();
+    Serial.printf("HTTPClientLoad: %u requests, %u failed, %u req/s\n",
+                  requests, failures, 100000 / std::max(now - since, (uint32_t)1));
+    since = now;
+  }
+}
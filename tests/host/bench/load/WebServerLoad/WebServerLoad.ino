@@ -0,0 +1,55 @@
+// ESP8266WebServer under load: make load LOAD_SKETCH=bench/load/WebServerLoad/WebServerLoad
+// LOAD="http 127.0.0.1:9080" (see README.txt)
+//
+// A few dozen routes of each kind, so that dispatch costs what it does
+// in a real application.
+
+#include <ESP8266WiFi.h>
+#include <ESP8266WebServer.h>
+#include <uri/UriBraces.h>
+
+ESP8266WebServer server(80);
+
+void handleArgs() {
+  String message;
+  message.reserve(128);
+  for (int i = 0; i < server.args(); i++) {
+    message += server.argName(i);
+    message += '=';
+    message += server.arg(i);
+    message += '\n';
+  }
+  server.send(200, "text/plain", message);
+}
+
+void setup() {
+  Serial.begin(115200);
+  WiFi.mode(WIFI_STA);
+  WiFi.begin();
+
+  for (int i = 0; i < 32; i++) {
+    server.on(String("/api/") + i, [i]() {
+      server.send(200, "application/json", String("{\"route\":") + i + '}');
+    });
+  }
+  server.on(UriBraces("/users/{}/posts/{}"), []() {
+    server.send(200, "text/plain", server.pathArg(0) + '/' + server.pathArg(1));
+  });
+  server.on("/args", handleArgs);
+  server.on("/post", HTTP_POST, []() {
+    server.send(200, "text/plain", String(server.arg("plain").length()));
+  });
+  server.on("/", []() {
+    server.send(200, "text/plain", "hello from esp8266!\r\n");
+  });
+  server.onNotFound([]() {
+    server.send(404, "text/plain", "not found");
+  });
+  server.collectHeaders("User-Agent", "Cookie");
+  server.begin();
+  Serial.println("WebServerLoad ready");
+}
+
+void loop() {
+  server.handleClient();
+}
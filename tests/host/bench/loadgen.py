@@ -0,0 +1,273 @@
+#!/usr/bin/env python3
+#
+# Load generators for sketches running in the host emulation (make load)
+#
+#    loadgen.py [--run "<sketch command>"] http 127.0.0.1:9080 [-c 4] [-n 2000] [-p /path]...
+#    loadgen.py [--run "<sketch command>"] dns 127.0.0.1:9053 [-c 4] [-n 20000] [-q name]...
+#    loadgen.py [--run "<sketch command>"] http-server 8266 [-s 1024] [-d 10]
+#
+# http and dns send requests from -c parallel clients to a server
+# sketch, http-server answers the requests of a client sketch for -d
+# seconds.  --run starts the sketch once the load generator is ready,
+# and stops it with SIGINT when done, so that a profiler wrapping it
+# (perf record, valgrind --tool=callgrind) writes its results.
+#
+# The summary is one JSON line like the host benchmarks print, so
+# compare.py can tell two runs apart.
+#
+# This file is part of the esp8266 core for Arduino environment.
+#
+# This library is free software; you can redistribute it and/or
+# modify it under the terms of the GNU Lesser General Public
+# License as published by the Free Software Foundation; either
+# version 2.1 of the License, or (at your option) any later version.
+
+import argparse
+import http.client
+import http.server
+import json
+import os
+import random
+import shlex
+import signal
+import socket
+import socketserver
+import struct
+import subprocess
+import sys
+import threading
+import time
+
+
+def address(text):
+    host, _, port = text.rpartition(':')
+    return (host or '127.0.0.1', int(port))
+
+
+def summary(name, latencies, errors, seconds):
+    latencies.sort()
+    done = len(latencies)
+
+    def percentile(p):
+        return latencies[min(done - 1, int(done * p / 100))] * 1000.0 if done else 0.0
+
+    result = {
+        'name': name,
+        'iterations': done,
+        'errors': errors,
+        'seconds': round(seconds, 3),
+        'req_per_s': round(done / seconds, 1) if seconds else 0.0,
+        'ns_per_op': seconds * 1e9 / done if done else 0.0,
+        'p50_ms': round(percentile(50), 3),
+        'p90_ms': round(percentile(90), 3),
+        'p99_ms': round(percentile(99), 3),
+        'max_ms': round(latencies[-1] * 1000.0, 3) if done else 0.0,
+    }
+    print(json.dumps(result))
+    return 1 if errors and not done else 0
+
+
+def clients(count, total, request):
+    '''Runs request() total times from count threads, returns the latencies and the error count'''
+    latencies = []
+    errors = [0]
+    left = [total]
+    lock = threading.Lock()
+
+    def worker():
+        state = {}
+        while True:
+            with lock:
+                if left[0] <= 0:
+                    return
+                left[0] -= 1
+            start = time.monotonic()
+            try:
+                request(state)
+            except Exception as e:
+                with lock:
+                    errors[0] += 1
+                    if errors[0] <= 5:
+                        print('request failed: %s' % e, file=sys.stderr)
+                state.clear()
+                continue
+            elapsed = time.monotonic() - start
+            with lock:
+                latencies.append(elapsed)
+
+    threads = [threading.Thread(target=worker) for _ in range(count)]
+    start = time.monotonic()
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    return latencies, errors[0], time.monotonic() - start
+
+
+def wait_tcp(server, seconds):
+    deadline = time.monotonic() + seconds
+    while time.monotonic() < deadline:
+        try:
+            socket.create_connection(server, timeout=1).close()
+            return True
+        except OSError:
+            time.sleep(0.1)
+    return False
+
+
+def load_http(args):
+    server = address(args.server)
+    paths = args.path or ['/']
+    body = b'x' * args.post if args.post else None
+    if not wait_tcp(server, args.wait):
+        print('%s:%d does not answer' % server, file=sys.stderr)
+        return 1
+
+    def request(state):
+        connection = state.get('connection')
+        if connection is None:
+            connection = http.client.HTTPConnection(*server, timeout=args.timeout)
+            if args.keepalive:
+                state['connection'] = connection
+        connection.request('POST' if body else 'GET', random.choice(paths), body,
+                           {'User-Agent': 'loadgen', 'Connection': 'keep-alive' if args.keepalive else 'close'})
+        response = connection.getresponse()
+        response.read()
+        if not args.keepalive:
+            connection.close()
+        if response.status >= 500:
+            raise Exception('HTTP status %d' % response.status)
+
+    latencies, errors, seconds = clients(args.clients, args.requests, request)
+    return summary('load_http', latencies, errors, seconds)
+
+
+def dns_query(name, ident):
+    question = b''.join(struct.pack('B', len(label)) + label.encode() for label in name.split('.'))
+    return struct.pack('>HHHHHH', ident, 0x0100, 1, 0, 0, 0) + question + b'\0' + struct.pack('>HH', 1, 1)
+
+
+def load_dns(args):
+    server = address(args.server)
+    names = args.query or ['esp8266.local', 'www.esp8266.local', 'host.example.com',
+                           'device7.lan', 'unknown.org']
+
+    def request(state):
+        sock = state.get('socket')
+        if sock is None:
+            sock = state['socket'] = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+            sock.settimeout(args.timeout)
+        ident = random.randrange(0x10000)
+        sock.sendto(dns_query(random.choice(names), ident), server)
+        while True:
+            reply, _ = sock.recvfrom(1024)
+            if len(reply) >= 12 and struct.unpack('>H', reply[:2])[0] == ident:
+                return
+
+    # the first replies come once the sketch has bound its socket
+    deadline = time.monotonic() + args.wait
+    while True:
+        try:
+            request({})
+            break
+        except OSError:
+            if time.monotonic() > deadline:
+                print('%s:%d does not answer' % server, file=sys.stderr)
+                return 1
+
+    latencies, errors, seconds = clients(args.clients, args.requests, request)
+    return summary('load_dns', latencies, errors, seconds)
+
+
+def serve_http(args):
+    body = bytes(random.getrandbits(8) for _ in range(args.size))
+    latencies = []
+    lock = threading.Lock()
+
+    class Handler(http.server.BaseHTTPRequestHandler):
+        protocol_version = 'HTTP/1.1'
+
+        def do_GET(self):
+            start = time.monotonic()
+            self.send_response(200)
+            self.send_header('Content-Type', 'application/octet-stream')
+            self.send_header('Content-Length', str(len(body)))
+            self.end_headers()
+            self.wfile.write(body)
+            with lock:
+                latencies.append(time.monotonic() - start)
+
+        def log_message(self, *args):
+            pass
+
+    class Server(socketserver.ThreadingMixIn, http.server.HTTPServer):
+        daemon_threads = True
+        allow_reuse_address = True
+
+    httpd = Server(('127.0.0.1', args.port), Handler)
+    thread = threading.Thread(target=httpd.serve_forever)
+    thread.start()
+    yield
+    start = time.monotonic()
+    time.sleep(args.duration)
+    httpd.shutdown()
+    thread.join()
+    yield summary('load_http_server', latencies, 0, time.monotonic() - start)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Load generators for emulated sketches')
+    parser.add_argument('--run', help='sketch command line, started when the load generator is ready')
+    parser.add_argument('--wait', type=float, default=10, help='seconds to wait for the sketch')
+    parser.add_argument('--timeout', type=float, default=5, help='request timeout in seconds')
+    sub = parser.add_subparsers(dest='mode')
+    sub.required = True
+
+    p = sub.add_parser('http', help='HTTP requests to a server sketch')
+    p.add_argument('server', help='host:port')
+    p.add_argument('-c', '--clients', type=int, default=4)
+    p.add_argument('-n', '--requests', type=int, default=2000)
+    p.add_argument('-p', '--path', action='append', help='path to request, picked at random when repeated')
+    p.add_argument('-P', '--post', type=int, default=0, help='POST that many bytes instead of GET')
+    p.add_argument('-k', '--keepalive', action='store_true', help='reuse connections')
+
+    p = sub.add_parser('dns', help='DNS queries to a server sketch')
+    p.add_argument('server', help='host:port')
+    p.add_argument('-c', '--clients', type=int, default=4)
+    p.add_argument('-n', '--requests', type=int, default=20000)
+    p.add_argument('-q', '--query', action='append', help='name to query, picked at random when repeated')
+
+    p = sub.add_parser('http-server', help='HTTP server for a client sketch')
+    p.add_argument('port', type=int)
+    p.add_argument('-s', '--size', type=int, default=1024, help='response body size')
+    p.add_argument('-d', '--duration', type=float, default=10, help='seconds to serve')
+
+    args = parser.parse_args()
+    random.seed(8266)
+
+    serving = serve_http(args) if args.mode == 'http-server' else None
+    if serving:
+        next(serving)
+
+    sketch = None
+    if args.run:
+        sketch = subprocess.Popen(shlex.split(args.run), stdin=subprocess.DEVNULL, start_new_session=True)
+    try:
+        if serving:
+            result = next(serving)
+        elif args.mode == 'http':
+            result = load_http(args)
+        else:
+            result = load_dns(args)
+    finally:
+        if sketch:
+            os.killpg(sketch.pid, signal.SIGINT)
+            try:
+                sketch.wait(30)
+            except subprocess.TimeoutExpired:
+                os.killpg(sketch.pid, signal.SIGKILL)
+    return result
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,263 @@
+/*
+ umm_replay.cpp - replays recorded heap traces against umm_malloc
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/*
+  One binary is built per umm_malloc configuration (make umm-replay), each
+  links its own umm_malloc.cpp built with UMM_TEST_BUILD.
+
+  The trace is what umm_heap_profile_trace_print() writes on the device
+  (UMM_HEAP_PROFILE_TRACE in umm_malloc_cfg.h), other lines are ignored so
+  a whole serial log can be given:
+
+    m <address> <size> [<caller>]     allocation
+    f <address>                       free
+    r <address> <new address> <size>  realloc, for traces from elsewhere
+
+  Addresses only identify the allocations.  Every -i operations, a line
+  with the state of the heap is printed, then a JSON summary like the host
+  benchmarks print (bench/compare.py).
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+extern "C" {
+// largest heap the 15 bit block numbers of 8 byte blocks can address
+char test_umm_heap[0x40000] __attribute__((aligned(8)));
+size_t test_umm_heap_size = 51200;
+int umm_critical_depth;
+int umm_max_critical_depth;
+
+void umm_init(void);
+void* umm_malloc(size_t size);
+void* umm_realloc(void* ptr, size_t size);
+void umm_free(void* ptr);
+size_t umm_block_size(void);
+size_t umm_free_heap_size(void);
+size_t umm_max_block_size(void);
+int umm_fragmentation_metric(void);
+}
+
+struct ReplayOp {
+    char op;
+    uint32_t id;
+    uint32_t new_id;
+    uint32_t size;
+};
+
+struct ReplayCost {
+    uint64_t count = 0;
+    double ns = 0;
+};
+
+static bool parse(FILE* in, std::vector<ReplayOp>& ops)
+{
+    char line[256];
+    while (fgets(line, sizeof(line), in)) {
+        ReplayOp op = { 0, 0, 0, 0 };
+        unsigned int id, new_id, size;
+        if (sscanf(line, "m %x %u", &id, &size) == 2) {
+            op = { 'm', id, 0, size };
+        } else if (sscanf(line, "f %x", &id) == 1) {
+            op = { 'f', id, 0, 0 };
+        } else if (sscanf(line, "r %x %x %u", &id, &new_id, &size) == 3) {
+            op = { 'r', id, new_id, size };
+        } else {
+            continue;
+        }
+        ops.push_back(op);
+    }
+    return !ferror(in);
+}
+
+static double nowNs()
+{
+    return std::chrono::duration<double, std::nano>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void usage(const char* argv0)
+{
+    fprintf(stderr,
+            "usage: %s [-n name] [-s heap bytes] [-i ops] [-r repeats] [trace]\n"
+            "    -n name   name of the configuration in the summary\n"
+            "    -s bytes  heap size (default %zu)\n"
+            "    -i ops    print the heap state every that many operations (default 1000, 0: never)\n"
+            "    -r n      replays, the fastest one is reported (default 3)\n"
+            "    trace     file from umm_heap_profile_trace_print(), default stdin\n",
+            argv0, test_umm_heap_size);
+}
+
+int main(int argc, char* argv[])
+{
+    const char* name = "default";
+    size_t interval = 1000;
+    int repeats = 3;
+
+    for (int opt; (opt = getopt(argc, argv, "n:s:i:r:h")) > 0; ) {
+        switch (opt) {
+        case 'n': name = optarg; break;
+        case 's': test_umm_heap_size = strtoul(optarg, nullptr, 0); break;
+        case 'i': interval = strtoul(optarg, nullptr, 0); break;
+        case 'r': repeats = atoi(optarg); break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+    size_t largest = std::min(sizeof(test_umm_heap), umm_block_size() * 0x7fff);
+    if (test_umm_heap_size > largest) {
+        fprintf(stderr, "heap size limited to %zu bytes\n", largest);
+        test_umm_heap_size = largest;
+    }
+    if (repeats < 1) {
+        repeats = 1;
+    }
+
+    FILE* in = optind < argc ? fopen(argv[optind], "r") : stdin;
+    std::vector<ReplayOp> ops;
+    if (!in || !parse(in, ops)) {
+        perror(optind < argc ? argv[optind] : "stdin");
+        return 1;
+    }
+    if (in != stdin) {
+        fclose(in);
+    }
+
+    // Time taken by the clock itself, taken off every operation
+    double overhead = 1e9;
+    for (int i = 0; i < 1000; ++i) {
+        double start = nowNs();
+        overhead = std::min(overhead, nowNs() - start);
+    }
+
+    ReplayCost best[3];
+    size_t failed = 0, unknown = 0, peakUsed = 0, minMaxBlock = test_umm_heap_size;
+    int maxFragmentation = 0;
+
+    for (int pass = 0; pass < repeats; ++pass) {
+        // Only the first pass prints the heap state, sampling it is not timed
+        bool report = pass == 0;
+        if (report && interval) {
+            printf("# %s: op used free max_block fragmentation failed\n", name);
+        }
+
+        umm_init();
+        std::unordered_map<uint32_t, std::pair<void*, size_t>> live;
+        ReplayCost cost[3];
+        size_t used = 0;
+        failed = unknown = 0;
+        for (size_t n = 0; n < ops.size(); ++n) {
+            const ReplayOp& op = ops[n];
+            double start, ns;
+            if (op.op == 'm') {
+                start = nowNs();
+                void* p = umm_malloc(op.size);
+                ns = nowNs() - start;
+                cost[0].count++;
+                cost[0].ns += ns - overhead;
+                if (!p) {
+                    failed++;
+                } else {
+                    auto old = live.find(op.id);
+                    if (old != live.end()) {
+                        // freed by something the trace did not see
+                        used -= old->second.second;
+                        umm_free(old->second.first);
+                    }
+                    live[op.id] = { p, op.size };
+                    used += op.size;
+                }
+            } else if (live.find(op.id) == live.end()) {
+                // allocated before the trace started, or failed here
+                unknown++;
+            } else {
+                auto it = live.find(op.id);
+                void* p = it->second.first;
+                size_t size = it->second.second;
+                used -= size;
+                live.erase(it);
+                if (op.op == 'f') {
+                    start = nowNs();
+                    umm_free(p);
+                    ns = nowNs() - start;
+                    cost[1].count++;
+                    cost[1].ns += ns - overhead;
+                } else {
+                    start = nowNs();
+                    void* q = umm_realloc(p, op.size);
+                    ns = nowNs() - start;
+                    cost[2].count++;
+                    cost[2].ns += ns - overhead;
+                    if (!q) {
+                        failed++;
+                        live[op.id] = { p, size };
+                        used += size;
+                    } else {
+                        live[op.new_id] = { q, op.size };
+                        used += op.size;
+                    }
+                }
+            }
+
+            if (report) {
+                peakUsed = std::max(peakUsed, used);
+                if (interval && (n + 1) % interval == 0) {
+                    size_t freeBytes = umm_free_heap_size();
+                    size_t maxBlock = umm_max_block_size();
+                    int fragmentation = umm_fragmentation_metric();
+                    minMaxBlock = std::min(minMaxBlock, maxBlock);
+                    maxFragmentation = std::max(maxFragmentation, fragmentation);
+                    printf("%zu %zu %zu %zu %d %zu\n", n + 1, used, freeBytes, maxBlock, fragmentation, failed);
+                }
+            }
+        }
+
+        if (report) {
+            minMaxBlock = std::min(minMaxBlock, umm_max_block_size());
+            maxFragmentation = std::max(maxFragmentation, umm_fragmentation_metric());
+        }
+
+        for (int i = 0; i < 3; ++i) {
+            if (pass == 0 || cost[i].ns < best[i].ns) {
+                best[i] = cost[i];
+            }
+        }
+    }
+
+    auto perOp = [](const ReplayCost& c) {
+        return c.count ? c.ns / c.count : 0.0;
+    };
+    uint64_t count = best[0].count + best[1].count + best[2].count;
+    double ns = best[0].ns + best[1].ns + best[2].ns;
+    printf("{\"name\":\"umm_replay_%s\",\"iterations\":%llu,\"ns_per_op\":%.2f,"
+           "\"malloc_ns\":%.2f,\"free_ns\":%.2f,\"realloc_ns\":%.2f,"
+           "\"heap\":%zu,\"block\":%zu,\"peak_used\":%zu,\"min_max_block\":%zu,"
+           "\"max_fragmentation\":%d,\"failed\":%zu,\"unknown\":%zu}\n",
+           name, (unsigned long long)count, count ? ns / count : 0.0,
+           perOp(best[0]), perOp(best[1]), perOp(best[2]),
+           test_umm_heap_size, umm_block_size(), peakUsed, minMaxBlock,
+           maxFragmentation, failed, unknown);
+    return 0;
+}
@@ -38,6 +38,13 @@ extern "C" unsigned long micros()
     return ((time.tv_sec - gtod0.tv_sec) * 1000000) + time.tv_usec - gtod0.tv_usec;
 }
 
+uint32_t esp_get_cycle_count()
+{
+    timeval t;
+    gettimeofday(&t, NULL);
+    return (((uint64_t)t.tv_sec) * 1000000 + t.tv_usec) * (F_CPU / 1000000);
+}
+
 
 extern "C" void yield()
 {
@@ -57,6 +64,14 @@ extern "C" void esp_yield()
 {
 }
 
+extern "C" void cpu_boost_begin()
+{
+}
+
+extern "C" void cpu_boost_end()
+{
+}
+
 
 extern "C" void __panic_func(const char* file, int line, const char* func) {
     (void)file;
@@ -41,6 +41,11 @@
 
 #define MOCK_PORT_SHIFTER 9000
 
+// long options without a short one
+#define OPT_LATENCY 256
+#define OPT_KBPS 257
+#define OPT_LOSS 258
+
 bool user_exit = false;
 bool run_once = false;
 const char* host_interface = nullptr;
@@ -127,6 +132,9 @@ void help (const char* argv0, int exitcode)
 		"\t-i <interface> - use this interface for IP address\n"
 		"\t-l             - bind tcp/udp servers to interface only (not 0.0.0.0)\n"
 		"\t-s             - port shifter (default: %d, when root: 0)\n"
+		"\t--latency <ms> - round trip time added to incoming data (default: 0)\n"
+		"\t--kbps <kbps>  - link bandwidth (default: unlimited)\n"
+		"\t--loss <%%>     - lost tcp windows and udp packets in percent (default: 0)\n"
         "\tterminal:\n"
 		"\t-b             - blocking tty/mocked-uart (default: not blocking tty)\n"
 		"\t-T             - show timestamp on output\n"
@@ -159,10 +167,15 @@ static struct option options[] =
 	{ "littlefskb",     required_argument,  NULL, 'L' },
 	{ "portshifter",    required_argument,  NULL, 's' },
 	{ "once",           no_argument,        NULL, '1' },
+	{ "latency",        required_argument,  NULL, OPT_LATENCY },
+	{ "kbps",           required_argument,  NULL, OPT_KBPS },
+	{ "loss",           required_argument,  NULL, OPT_LOSS },
+	{ NULL,             0,                  NULL, 0 },
 };
 
 void cleanup ()
 {
+	mockNetSummary();
 	mock_stop_spiffs();
 	mock_stop_littlefs();
 	mock_stop_uart();
@@ -256,6 +269,15 @@ int main (int argc, char* const argv [])
 		case '1':
 			run_once = true;
 			break;
+		case OPT_LATENCY:
+			mock_net_latency_ms = atoi(optarg);
+			break;
+		case OPT_KBPS:
+			mock_net_kbps = atoi(optarg);
+			break;
+		case OPT_LOSS:
+			mock_net_loss = atof(optarg);
+			break;
 		default:
 			help(argv[0], EXIT_FAILURE);
 		}
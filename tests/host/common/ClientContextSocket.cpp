@@ -41,6 +41,8 @@
 
 int mockSockSetup (int sock)
 {
+	mockNetReset(sock);
+
 	if (fcntl(sock, F_SETFL, O_NONBLOCK) == -1)
 	{
 		perror("socket fcntl(O_NONBLOCK)");
@@ -83,7 +85,10 @@ int mockConnect (uint32_t ipv4, int& sock, int port)
 
 ssize_t mockFillInBuf (int sock, char* ccinbuf, size_t& ccinbufsize)
 {
-	size_t maxread = CCBUFSIZE - ccinbufsize;
+	size_t maxread = mockNetReceivable(sock, CCBUFSIZE - ccinbufsize, false);
+	if (maxread == 0)
+		// not arrived yet
+		return 0;
 	ssize_t ret = ::read(sock, ccinbuf + ccinbufsize, maxread);
 
 	if (ret == 0)
@@ -104,10 +109,28 @@ ssize_t mockFillInBuf (int sock, char* ccinbuf, size_t& ccinbufsize)
 		ret = 0;
 	}
 
+	mockNetReceived(sock, ret, maxread);
 	ccinbufsize += ret;
 	return ret;
 }
 
+static bool mockWaitReadable (int sock, int& timeout_ms)
+{
+	struct pollfd p;
+	p.fd = sock;
+	p.events = POLLIN;
+	if (!mockNetShaping())
+		return poll(&p, 1, timeout_ms) == 1;
+
+	// data may be there already but held back, retry every ms until timeout
+	if (timeout_ms <= 0)
+		return false;
+	if (poll(&p, 1, 1) == 1)
+		usleep(1000);
+	timeout_ms--;
+	return true;
+}
+
 ssize_t mockPeekBytes (int sock, char* dst, size_t usersize, int timeout_ms, char* ccinbuf, size_t& ccinbufsize)
 {
     // usersize==0: peekAvailable()
@@ -115,7 +138,6 @@ ssize_t mockPeekBytes (int sock, char* dst, size_t usersize, int timeout_ms, cha
 	if (usersize > CCBUFSIZE)
 		mockverbose("CCBUFSIZE(%d) should be increased by %zd bytes (-> %zd)\n", CCBUFSIZE, usersize - CCBUFSIZE, usersize);
 
-	struct pollfd p;
 	size_t retsize = 0;
 	do
 	{
@@ -144,9 +166,7 @@ ssize_t mockPeekBytes (int sock, char* dst, size_t usersize, int timeout_ms, cha
 		}
 		
 		// wait for more data until timeout
-		p.fd = sock;
-		p.events = POLLIN;
-	} while (poll(&p, 1, timeout_ms) == 1);
+	} while (mockWaitReadable(sock, timeout_ms));
 	
     if (dst)
     {
@@ -169,6 +189,7 @@ ssize_t mockRead (int sock, char* dst, size_t size, int timeout_ms, char* ccinbu
 	
 ssize_t mockWrite (int sock, const uint8_t* data, size_t size, int timeout_ms)
 {
+	mockNetSend(size, false);
 	size_t sent = 0;
 	while (sent < size)
 	{
@@ -227,6 +227,24 @@ String EspClass::getFullVersion ()
 	return "emulation-on-host";
 }
 
+static uint32_t mock_rtc_user_memory[128];
+
+bool EspClass::rtcUserMemoryRead(uint32_t offset, uint32_t *data, size_t size)
+{
+    if (offset * 4 + size > sizeof(mock_rtc_user_memory) || size == 0)
+        return false;
+    memcpy(data, reinterpret_cast<uint8_t*>(mock_rtc_user_memory) + offset * 4, size);
+    return true;
+}
+
+bool EspClass::rtcUserMemoryWrite(uint32_t offset, uint32_t *data, size_t size)
+{
+    if (offset * 4 + size > sizeof(mock_rtc_user_memory) || size == 0)
+        return false;
+    memcpy(reinterpret_cast<uint8_t*>(mock_rtc_user_memory) + offset * 4, data, size);
+    return true;
+}
+
 uint32_t EspClass::getFreeContStack()
 {
     return 4000;
@@ -241,13 +259,6 @@ uint32_t EspClass::getCycleCount()
     return esp_get_cycle_count();
 }
 
-uint32_t esp_get_cycle_count()
-{
-    timeval t;
-    gettimeofday(&t, NULL);
-    return (((uint64_t)t.tv_sec) * 1000000 + t.tv_usec) * (F_CPU / 1000000);
-}
-
 void EspClass::setDramHeap()
 {
 }
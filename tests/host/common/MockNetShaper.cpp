@@ -0,0 +1,205 @@
+/*
+ Arduino emulation - network conditions for the socket emulation
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*
+  The host sockets are as fast as the loopback, this makes them look like
+  the WiFi link of an esp8266 running lwIP:
+
+  - latency (round trip): incoming data stays in the host socket for that
+    long before the sketch sees it.  TCP is delivered by windows of
+    MOCK_NET_WINDOW bytes, like lwIP which advertises a small window, so a
+    stream runs at one window per round trip.  A TCP write blocks for one
+    round trip per full send buffer, as ClientContext::write() does while
+    waiting for acks;
+  - bandwidth: incoming data is let through at that rate, writes sleep
+    for the time the data takes on the link;
+  - loss: a lost TCP window or send buffer is retransmitted after
+    MOCK_NET_RTO_MS, a lost UDP datagram is dropped.
+
+  Everything runs in the single sketch thread, blocking in a write is what
+  the sketch sees on the device too.  Random losses are reproducible from
+  one run to the next.
+*/
+
+#include <Arduino.h>
+
+#include <map>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MOCK_NET_WINDOW (4 * TCP_MSS)       // lwIP TCP_WND
+#define MOCK_NET_SNDBUF (2 * TCP_MSS)       // lwIP TCP_SND_BUF
+#define MOCK_NET_RTO_MS 1000                // lwIP minimum retransmission timeout
+
+int mock_net_latency_ms = 0;
+int mock_net_kbps = 0;
+double mock_net_loss = 0;   // percent
+
+struct MockNetStats
+{
+	uint64_t received = 0;  // bytes handed to the sketch
+	uint64_t sent = 0;
+	uint32_t lost = 0;      // windows, send buffers or datagrams
+};
+
+struct MockNetSocket
+{
+	size_t window = 0;      // bytes left to deliver from the current window
+	uint64_t ready_us = 0;  // when the current window arrives
+	double tokens = 0;      // incoming bytes the link allows now
+	uint64_t refill_us = 0;
+};
+
+static std::map<int, MockNetSocket> sockets;
+static MockNetStats stats;
+static unsigned int loss_seed = 8266;
+
+static uint64_t now_us ()
+{
+	timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (uint64_t)t.tv_sec * 1000000 + t.tv_nsec / 1000;
+}
+
+static bool lost ()
+{
+	if (mock_net_loss <= 0)
+		return false;
+	if (rand_r(&loss_seed) * 100.0 / RAND_MAX >= mock_net_loss)
+		return false;
+	stats.lost++;
+	return true;
+}
+
+static uint64_t link_us (size_t bytes)
+{
+	// kbps = bits per ms
+	return mock_net_kbps > 0? (uint64_t)bytes * 8000 / mock_net_kbps: 0;
+}
+
+bool mockNetShaping ()
+{
+	return mock_net_latency_ms > 0 || mock_net_kbps > 0 || mock_net_loss > 0;
+}
+
+void mockNetReset (int sock)
+{
+	sockets.erase(sock);
+}
+
+// How many of the `size` bytes waiting in the host socket (one datagram
+// when `datagram`) the sketch may get now
+size_t mockNetReceivable (int sock, size_t size, bool datagram)
+{
+	if (!mockNetShaping())
+		return size;
+
+	MockNetSocket& s = sockets[sock];
+	uint64_t now = now_us();
+	if (!s.window)
+	{
+		pollfd p;
+		p.fd = sock;
+		p.events = POLLIN;
+		if (poll(&p, 1, 0) != 1)
+			return size; // nothing there, the read will find nothing too
+		s.window = datagram? size: MOCK_NET_WINDOW;
+		s.ready_us = now + mock_net_latency_ms * 1000;
+		if (!datagram && lost())
+			s.ready_us += MOCK_NET_RTO_MS * 1000;
+	}
+	if (now < s.ready_us)
+		return 0;
+
+	if (mock_net_kbps > 0)
+	{
+		if (!s.refill_us)
+			s.refill_us = now;
+		s.tokens += (now - s.refill_us) * mock_net_kbps / 8000.0;
+		s.refill_us = now;
+		// no bursts beyond a window or a datagram
+		if (s.tokens > std::max(s.window, (size_t)MOCK_NET_WINDOW))
+			s.tokens = std::max(s.window, (size_t)MOCK_NET_WINDOW);
+		// TCP goes by segments
+		if (s.tokens < (datagram? size: std::min(s.window, (size_t)TCP_MSS)))
+			return 0;
+		if (!datagram)
+			size = std::min(size, (size_t)s.tokens);
+	}
+	return std::min(size, s.window);
+}
+
+// `size` of the `allowed` bytes were handed to the sketch.  Once the
+// window is delivered, or the host socket is empty, the next data waits
+// for a round trip.
+void mockNetReceived (int sock, size_t size, size_t allowed)
+{
+	if (!mockNetShaping() || !size)
+		return;
+	MockNetSocket& s = sockets[sock];
+	s.tokens -= size;
+	s.window = size < allowed || size >= s.window? 0: s.window - size;
+	stats.received += size;
+}
+
+// An incoming datagram to throw away
+bool mockNetDropDatagram ()
+{
+	return lost();
+}
+
+// Waits as long as sending `size` bytes takes on the link, false if a
+// datagram is lost on the way
+bool mockNetSend (size_t size, bool datagram)
+{
+	if (!mockNetShaping())
+		return true;
+	uint64_t wait = link_us(size);
+	if (datagram)
+	{
+		if (lost())
+			return false;
+	}
+	else
+	{
+		// the last send buffer is not waited for
+		for (size_t buffers = size / MOCK_NET_SNDBUF; buffers; buffers--)
+		{
+			wait += mock_net_latency_ms * 1000;
+			if (lost())
+				wait += MOCK_NET_RTO_MS * 1000;
+		}
+	}
+	if (wait)
+		usleep(wait);
+	stats.sent += size;
+	return true;
+}
+
+void mockNetSummary ()
+{
+	static bool done = false;
+	if (!mockNetShaping() || done)
+		return;
+	done = true;
+	fprintf(stderr, MOCK "network: latency %dms, %dkbps, loss %g%%: received %llu bytes, sent %llu, lost %u times\n",
+		mock_net_latency_ms, mock_net_kbps, mock_net_loss,
+		(unsigned long long)stats.received, (unsigned long long)stats.sent, stats.lost);
+}
@@ -67,6 +67,13 @@ void stack_thunk_dump_stack() { }
 // Thunking macro
 #define make_stack_thunk(fcnToThunk)
 
+// Single heap on host
+#include <umm_malloc/umm_malloc.h>
+size_t umm_get_class_heap(umm_heap_class_t) { return UMM_HEAP_CLASS_CURRENT; }
+void umm_set_class_heap(umm_heap_class_t, size_t) { }
+void *umm_class_malloc(umm_heap_class_t, size_t size) { return malloc(size); }
+void *umm_class_calloc(umm_heap_class_t, size_t num, size_t size) { return calloc(num, size); }
+
 };
 
 void configTime(int timezone, int daylightOffset_sec,
@@ -78,3 +85,14 @@ void configTime(int timezone, int daylightOffset_sec,
 
 	mockverbose("configTime: TODO (tz=%dH offset=%dS) (time will be host's)\n", timezone, daylightOffset_sec);
 }
+
+void configTimeFastSync(bool enable)
+{
+	(void)enable;
+}
+
+bool configTimeRtc(uint32_t rtcBlock)
+{
+	(void)rtcBlock;
+	return false;
+}
@@ -254,6 +254,28 @@ uart_get_rx_buffer_size(uart_t* uart)
 	return uart && uart->rx_enabled ? uart->rx_buffer->size : 0;
 }
 
+bool
+uart_set_rx_thresholds(uart_t* uart, uint8_t fifo_full, uint8_t timeout)
+{
+	return uart && uart->rx_enabled && fifo_full >= 1 && fifo_full <= 127 && timeout <= 127;
+}
+
+size_t
+uart_resize_tx_buffer(uart_t* uart, size_t new_size)
+{
+	// host writes are synchronous, there is nothing to buffer
+	(void) uart;
+	(void) new_size;
+	return 0;
+}
+
+size_t
+uart_get_tx_buffer_size(uart_t* uart)
+{
+	(void) uart;
+	return 0;
+}
+
 size_t
 uart_write_char(uart_t* uart, char c)
 {
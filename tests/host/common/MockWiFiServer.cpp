@@ -55,11 +55,19 @@ WiFiServer::WiFiServer (uint16_t port)
 	_port = port;
 }
 
+ClientContext* WiFiServer::_takeUnclaimed ()
+{
+	// no accept queue, the host socket's listen backlog is used instead
+	if (hasClient())
+		return new ClientContext(serverAccept(pcb2int(_listen_pcb)));
+	return nullptr;
+}
+
 WiFiClient WiFiServer::available (uint8_t* status)
 {
 	(void)status;
 	if (hasClient())
-		return WiFiClient(new ClientContext(serverAccept(pcb2int(_listen_pcb))));
+		return WiFiClient(_takeUnclaimed());
 	return WiFiClient();
 }
 
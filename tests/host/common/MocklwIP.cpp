@@ -12,12 +12,25 @@ extern netif netif0;
 
 netif* netif_list = &netif0;
 
+netif netif_git[2];
+
 err_t dhcp_renew(struct netif *netif)
 {
 	(void)netif;
 	return ERR_OK;
 }
 
+u8_t dhcp_supplied_address(const struct netif *netif)
+{
+	(void)netif;
+	return 0;
+}
+
+void dhcp_network_changed(struct netif *netif)
+{
+	(void)netif;
+}
+
 void sntp_setserver(u8_t, const ip_addr_t)
 {
 }
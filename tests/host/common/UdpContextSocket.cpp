@@ -38,6 +38,7 @@
 #include <errno.h>
 #include <assert.h>
 #include <net/if.h>
+#include <sys/ioctl.h>
 
 int mockUDPSocket ()
 {
@@ -134,6 +135,22 @@ size_t mockUDPFillInBuf (int sock, char* ccinbuf, size_t& ccinbufsize, uint8_t&
 	socklen_t addrbufsize = std::min((socklen_t)sizeof(addrbuf), (socklen_t)16);
 
 	size_t maxread = CCBUFSIZE - ccinbufsize;
+	if (mockNetShaping())
+	{
+		int pending = 0;
+		if (ioctl(sock, FIONREAD, &pending) == 0 && pending > 0)
+		{
+			if (mockNetReceivable(sock, pending, true) == 0)
+				// not arrived yet
+				return ccinbufsize;
+			mockNetReceived(sock, pending, pending);
+			if (mockNetDropDatagram())
+			{
+				::recv(sock, ccinbuf + ccinbufsize, maxread, 0);
+				return ccinbufsize;
+			}
+		}
+	}
 	ssize_t ret = ::recvfrom(sock, ccinbuf + ccinbufsize, maxread, 0/*flags*/, (sockaddr*)&addrbuf, &addrbufsize);
 	if (ret == -1)
 	{
@@ -198,6 +215,9 @@ size_t mockUDPWrite (int sock, const uint8_t* data, size_t size, int timeout_ms,
 	peer.sin_family = AF_INET;
 	peer.sin_addr.s_addr = ipv4; //XXFIXME should use lwip_htonl?
 	peer.sin_port = htons(port);
+	if (!mockNetSend(size, true))
+		// lost on the way
+		return size;
 	int ret = ::sendto(sock, data, size, 0/*flags*/, (const sockaddr*)&peer, sizeof(peer));
 	if (ret == -1)
 	{
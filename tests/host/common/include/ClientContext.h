@@ -28,6 +28,8 @@ extern "C" void esp_yield();
 extern "C" void esp_schedule();
 
 #include <assert.h>
+#include <functional>
+#include <Schedule.h>
 
 bool getDefaultPrivateGlobalSyncValue ();
 
@@ -106,6 +108,16 @@ public:
         return mockConnect(addr->addr, _sock, port);
     }
 
+    // the emulation connects synchronously, only the outcome is deferred
+    int connectAsync(const ip_addr_t* addr, uint16_t port, std::function<void(bool)> cb)
+    {
+        if (!connect(addr, port))
+            return 0;
+        if (cb)
+            schedule_function([cb]() { cb(true); });
+        return 1;
+    }
+
     size_t availableForWrite()
     {
         // XXXFIXME be smarter
@@ -123,6 +135,80 @@ public:
         return false;
     }
 
+    void cork()
+    {
+        mockverbose("TODO cork()\n");
+    }
+
+    void uncork()
+    {
+        mockverbose("TODO uncork()\n");
+    }
+
+    void setAutoCork(size_t bytes, uint16_t ms)
+    {
+        mockverbose("TODO setAutoCork(%zd, %d)\n", bytes, (int)ms);
+    }
+
+    void setRxWindow(size_t bytes)
+    {
+        mockverbose("TODO setRxWindow(%zd)\n", bytes);
+    }
+
+    size_t getRxWindow() const
+    {
+        return CCBUFSIZE;
+    }
+
+    void setTxBuffer(size_t bytes)
+    {
+        mockverbose("TODO setTxBuffer(%zd)\n", bytes);
+    }
+
+    size_t getTxBuffer() const
+    {
+        return 512;
+    }
+
+    static bool setTxPool(size_t bytes)
+    {
+        mockverbose("TODO setTxPool(%zd)\n", bytes);
+        return false;
+    }
+
+    void onData(std::function<void()> cb)
+    {
+        (void)cb;
+        mockverbose("TODO onData()\n");
+    }
+
+    void onWritable(std::function<void()> cb)
+    {
+        (void)cb;
+        mockverbose("TODO onWritable()\n");
+    }
+
+    void onClosed(std::function<void()> cb)
+    {
+        (void)cb;
+        mockverbose("TODO onClosed()\n");
+    }
+
+    void setRxBufferLimit(size_t bytes, uint16_t pbufs)
+    {
+        mockverbose("TODO setRxBufferLimit(%zd, %d)\n", bytes, (int)pbufs);
+    }
+
+    size_t getRxBuffered() const
+    {
+        return _inbufsize;
+    }
+
+    uint16_t getRxPbufs() const
+    {
+        return _inbufsize? 1: 0;
+    }
+
     void setTimeout(int timeout_ms)
     {
         _timeout_ms = timeout_ms;
@@ -234,6 +320,19 @@ public:
 	return ret;
     }
 
+    size_t writev(const WiFiClient::Segment* segments, size_t count)
+    {
+        size_t written = 0;
+        for (size_t i = 0; i < count; i++)
+        {
+            size_t ret = write(segments[i].data, segments[i].len);
+            written += ret;
+            if (ret != segments[i].len)
+                break;
+        }
+        return written;
+    }
+
     void keepAlive (uint16_t idle_sec = TCP_DEFAULT_KEEPALIVE_IDLE_SEC, uint16_t intv_sec = TCP_DEFAULT_KEEPALIVE_INTERVAL_SEC, uint8_t count = TCP_DEFAULT_KEEPALIVE_COUNT)
     {
         (void) idle_sec;
@@ -305,6 +404,21 @@ public:
         _inbufsize -= consume;
     }
 
+    // mock: whole input buffer is one segment
+    size_t peekSegments (WiFiClient::Segment* segments, size_t maxSegments)
+    {
+        if (!maxSegments || !peekAvailable())
+            return 0;
+        segments[0].data = _inbuf;
+        segments[0].len = _inbufsize;
+        return 1;
+    }
+
+    size_t peekSegmentsCount ()
+    {
+        return peekAvailable()? 1: 0;
+    }
+
 private:
 
     discard_cb_t _discard_cb = nullptr;
@@ -111,6 +111,33 @@ public:
         return &netif0;
     }
 
+    struct RxStats
+    {
+        uint32_t dropped = 0;
+        size_t packets = 0;
+        size_t bytes = 0;
+        size_t maxPackets = 0;
+        size_t maxBytes = 0;
+    };
+
+    static constexpr size_t rxBufMaxDepth = 5;
+
+    void setRxQueueLimit(size_t packets, size_t bytes)
+    {
+        (void)packets;
+        (void)bytes;
+    }
+
+    const RxStats& getRxStats() const
+    {
+        // the emulation reads from the socket, nothing is queued here
+        return _rx_stats;
+    }
+
+    void resetRxStats()
+    {
+    }
+
     // warning: handler is called from tcp stack context
     // esp_yield and non-reentrant functions which depend on it will fail
     void onRx(rxhandler_t handler)
@@ -194,6 +221,11 @@ public:
         return mockUDPPeekBytes(_sock, &c, 1, _timeout_ms, _inbuf, _inbufsize) ? : -1;
     }
 
+    const char* peekBuffer() const
+    {
+        return _inbuf;
+    }
+
     void flush()
     {
         //mockverbose("UdpContext::flush() does not follow arduino's flush concept\n");
@@ -231,6 +263,15 @@ public:
         _outbufsize = 0;
     }
 
+    err_t sendNow(const char* data, size_t size, const ip_addr_t* addr = 0, uint16_t port = 0, bool noCopy = false)
+    {
+        (void)noCopy;
+        uint32_t dst = addr ? addr->addr : _dst.addr;
+        uint16_t dstport = addr ? port : _dstport;
+        size_t wrt = mockUDPWrite(_sock, (const uint8_t*)data, size, _timeout_ms, dst, dstport);
+        return wrt == size ? ERR_OK : ERR_ABRT;
+    }
+
     bool send(ip_addr_t* addr = 0, uint16_t port = 0)
     {
         return trySend(addr, port, false) == ERR_OK;
@@ -275,6 +316,7 @@ private:
 
     int _sock = -1;
     rxhandler_t _on_rx;
+    RxStats _rx_stats;
     int _refcnt = 0;
 
     ip_addr_t _dst;
@@ -156,6 +156,18 @@ size_t mockUDPRead (int sock, char* dst, size_t size, int timeout_ms, char* ccin
 size_t mockUDPWrite (int sock, const uint8_t* data, size_t size, int timeout_ms, uint32_t ipv4, uint16_t port);
 void mockUDPSwallow (size_t copied, char* ccinbuf, size_t& ccinbufsize);
 
+// MockNetShaper.cpp
+extern int mock_net_latency_ms; // cmdline parameters, 0 = as fast as the host
+extern int mock_net_kbps;
+extern double mock_net_loss;
+bool mockNetShaping ();
+void mockNetReset (int sock);
+size_t mockNetReceivable (int sock, size_t size, bool datagram);
+void mockNetReceived (int sock, size_t size, size_t allowed);
+bool mockNetDropDatagram ();
+bool mockNetSend (size_t size, bool datagram);
+void mockNetSummary ();
+
 class UdpContext;
 void register_udp (int sock, UdpContext* udp = nullptr);
 
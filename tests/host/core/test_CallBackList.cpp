@@ -0,0 +1,89 @@
+/*
+ test_CallBackList.cpp - StaticCallBackList tests
+
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+ */
+
+#include <catch.hpp>
+#include <CallBackList.h>
+
+using namespace experimental::CBListImplentation;
+
+namespace
+{
+
+using List = StaticCallBackList<void(int), 3>;
+
+struct Counted
+{
+    static int alive;
+    int* sum;
+    Counted(int* s) : sum(s) { alive++; }
+    Counted(const Counted& other) : sum(other.sum) { alive++; }
+    ~Counted() { alive--; }
+    void operator()(int v) { *sum += v; }
+};
+
+int Counted::alive = 0;
+
+} // namespace
+
+TEST_CASE("StaticCallBackList adds, executes and removes", "[core][CallBackList]")
+{
+    int sum = 0;
+    List list;
+    auto a = list.add([&sum](int v) { sum += v; });
+    auto b = list.add([&sum](int v) { sum += 10 * v; });
+    CHECK(a != List::invalid);
+    CHECK(b != List::invalid);
+    CHECK(list.size() == 2);
+    CHECK(list.execute(2) == 2);
+    CHECK(sum == 22);
+
+    CHECK(list.remove(a));
+    CHECK_FALSE(list.remove(a));
+    CHECK(list.execute(1) == 1);
+    CHECK(sum == 32);
+}
+
+TEST_CASE("StaticCallBackList has a fixed capacity", "[core][CallBackList]")
+{
+    List list;
+    for (int i = 0; i < 3; i++)
+    {
+        CHECK(list.add([](int) { }) != List::invalid);
+    }
+    CHECK(list.add([](int) { }) == List::invalid);
+    CHECK(list.remove(1));
+    CHECK(list.add([](int) { }) == 1);
+}
+
+TEST_CASE("StaticCallBackList defers destruction during execute", "[core][CallBackList]")
+{
+    int sum = 0;
+    List list;
+    List::CallBackHandler self = List::invalid;
+    {
+        self = list.add(Counted(&sum));
+        CHECK(Counted::alive == 1);
+    }
+    List::CallBackHandler other = List::invalid;
+    // removes itself and the next one while running
+    list.add([&](int)
+    {
+        CHECK(list.remove(self));
+        CHECK(list.remove(other));
+        CHECK(Counted::alive == 1);
+    });
+    other = list.add([&sum](int) { sum += 100; });
+
+    CHECK(list.execute(1) == 2);
+    CHECK(sum == 1);
+    CHECK(Counted::alive == 0);
+    CHECK(list.size() == 1);
+}
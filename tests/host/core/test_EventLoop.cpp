@@ -0,0 +1,123 @@
+/*
+ test_EventLoop.cpp - EventLoop tests
+
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+ */
+
+#include <catch.hpp>
+#include <EventLoop.h>
+
+namespace
+{
+
+struct FakeTime
+{
+  using timeType = uint32_t;
+  static timeType now;
+  static timeType time() { return now; }
+  static timeType toTimeTypeUnit(timeType t) { return t; }
+  static timeType toUserUnit(timeType t) { return t; }
+};
+
+FakeTime::timeType FakeTime::now = 0;
+
+using Loop = esp8266::EventLoop<4, 2, FakeTime>;
+
+struct FakeStream
+{
+  int pending = 0;
+  int available() { return pending; }
+};
+
+void count(int* n) { ++*n; }
+
+} // namespace
+
+TEST_CASE("EventLoop one shot and periodic timers", "[EventLoop]")
+{
+  FakeTime::now = 1000;
+  Loop loop;
+  int once = 0, periodic = 0;
+  REQUIRE(loop.addTimer(50, 0, count, &once) >= 0);
+  REQUIRE(loop.addTimer(20, 20, count, &periodic) >= 0);
+  CHECK(loop.untilNext() == 20);
+
+  FakeTime::now += 19;
+  CHECK(loop.runOnce() == 0);
+  FakeTime::now += 1;
+  CHECK(loop.runOnce() == 1);
+  CHECK(periodic == 1);
+
+  // late: the missed periods are skipped, the phase is kept
+  FakeTime::now += 75;
+  CHECK(loop.runOnce() == 2);
+  CHECK(once == 1);
+  CHECK(periodic == 2);
+  CHECK(loop.untilNext() == 5);
+
+  FakeTime::now += 100;
+  loop.runOnce();
+  CHECK(once == 1);
+  CHECK(periodic == 3);
+}
+
+TEST_CASE("EventLoop runs due timers nearest deadline first", "[EventLoop]")
+{
+  FakeTime::now = 0;
+  Loop loop;
+  static int order[3];
+  static int calls;
+  calls = 0;
+  loop.addTimer(30, 0, [](void*) { order[calls++] = 30; });
+  loop.addTimer(10, 0, [](void*) { order[calls++] = 10; });
+  loop.addTimer(20, 0, [](void*) { order[calls++] = 20; });
+  FakeTime::now = 40;
+  CHECK(loop.runOnce() == 3);
+  CHECK(order[0] == 10);
+  CHECK(order[1] == 20);
+  CHECK(order[2] == 30);
+  CHECK(loop.untilNext() == Loop::neverExpires);
+}
+
+TEST_CASE("EventLoop capacity and removal", "[EventLoop]")
+{
+  FakeTime::now = 0;
+  Loop loop;
+  int n = 0;
+  for (int i = 0; i < 4; ++i)
+  {
+    REQUIRE(loop.addTimer(10, 10, count, &n) == i);
+  }
+  CHECK(loop.addTimer(10, 10, count, &n) == Loop::invalid);
+  CHECK(loop.removeTimer(2));
+  CHECK_FALSE(loop.removeTimer(2));
+  CHECK(loop.addTimer(10, 10, count, &n) == 2);
+  FakeTime::now = 10;
+  CHECK(loop.runOnce() == 4);
+}
+
+TEST_CASE("EventLoop readiness sources", "[EventLoop]")
+{
+  FakeTime::now = 0;
+  Loop loop;
+  FakeStream stream;
+  static int reads;
+  reads = 0;
+  REQUIRE(loop.addSource(&stream, +[](FakeStream* s) { ++reads; s->pending = 0; }) >= 0);
+  volatile bool flag = false;
+  REQUIRE(loop.addFlag(&flag, [](void*) { ++reads; }) >= 0);
+  CHECK(loop.addFlag(&flag, [](void*) { }) == Loop::invalid);
+
+  CHECK(loop.runOnce() == 0);
+  stream.pending = 3;
+  flag = true;
+  CHECK(loop.runOnce() == 2);
+  CHECK(reads == 2);
+  CHECK_FALSE(flag);
+  CHECK(loop.runOnce() == 0);
+}
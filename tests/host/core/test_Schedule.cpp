@@ -0,0 +1,118 @@
+#include <catch.hpp>
+#include "Schedule.h"
+
+// run_scheduled_functions() may yield, esp_schedule() is not part of
+// the host test core library
+extern "C" void esp_schedule() {}
+
+static void count_fn(void* arg)
+{
+    ++*(int*)arg;
+}
+
+static int order[4];
+static int orderCount = 0;
+
+static void order_fn(void* arg)
+{
+    order[orderCount++] = (int)(intptr_t)arg;
+}
+
+static void reschedule_fn(void* arg)
+{
+    int* count = (int*)arg;
+    if (++*count < 3)
+        schedule_function_ptr(reschedule_fn, arg);
+}
+
+TEST_CASE("Scheduled function pointers are called once, in order", "[schedule]")
+{
+    orderCount = 0;
+    for (intptr_t i = 0; i < 4; i++)
+        REQUIRE(schedule_function_ptr(order_fn, (void*)i));
+    run_scheduled_functions();
+    REQUIRE(orderCount == 4);
+    for (int i = 0; i < 4; i++)
+        REQUIRE(order[i] == i);
+    run_scheduled_functions();
+    REQUIRE(orderCount == 4);
+}
+
+TEST_CASE("Scheduled function pointers ring is bounded", "[schedule]")
+{
+    int count = 0;
+    REQUIRE_FALSE(schedule_function_ptr(nullptr));
+    for (int i = 0; i < SCHEDULED_FNPTR_QUEUE_SIZE; i++)
+        REQUIRE(schedule_function_ptr(count_fn, &count));
+    REQUIRE_FALSE(schedule_function_ptr(count_fn, &count));
+    run_scheduled_functions();
+    REQUIRE(count == SCHEDULED_FNPTR_QUEUE_SIZE);
+    REQUIRE(schedule_function_ptr(count_fn, &count));
+    run_scheduled_functions();
+    REQUIRE(count == SCHEDULED_FNPTR_QUEUE_SIZE + 1);
+}
+
+TEST_CASE("Scheduled function pointers scheduled while running are run next time", "[schedule]")
+{
+    int count = 0;
+    REQUIRE(schedule_function_ptr(reschedule_fn, &count));
+    run_scheduled_functions();
+    REQUIRE(count == 1);
+    run_scheduled_functions();
+    REQUIRE(count == 2);
+    run_scheduled_functions();
+    run_scheduled_functions();
+    REQUIRE(count == 3);
+}
+
+TEST_CASE("Recurrent functions are only called when due", "[schedule]")
+{
+    int fast = 0, slow = 0, once = 0;
+    REQUIRE(get_scheduled_recurrent_delay_us() == SCHEDULED_NO_RECURRENT_DELAY);
+    REQUIRE(schedule_recurrent_function_us([&]() { return ++slow < 2; }, 200000));
+    REQUIRE(schedule_recurrent_function_us([&]() { ++once; return false; }, 0));
+    REQUIRE(schedule_recurrent_function_us([&]() { return ++fast < 2; }, 10000));
+    REQUIRE(get_scheduled_recurrent_delay_us() == 0);
+
+    run_scheduled_recurrent_functions();
+    REQUIRE(once == 1);
+    REQUIRE(fast == 0);
+    REQUIRE(slow == 0);
+    uint32_t next = get_scheduled_recurrent_delay_us();
+    REQUIRE(next > 0);
+    REQUIRE(next <= 10000);
+
+    delay(50);
+    run_scheduled_recurrent_functions();
+    REQUIRE(fast == 1);
+    REQUIRE(slow == 0);
+
+    delay(200);
+    run_scheduled_recurrent_functions();
+    REQUIRE(once == 1);
+    REQUIRE(fast == 2);
+    REQUIRE(slow == 1);
+
+    delay(200);
+    run_scheduled_recurrent_functions();
+    REQUIRE(slow == 2); // returned false, removed
+    delay(200);
+    run_scheduled_recurrent_functions();
+    REQUIRE(slow == 2);
+}
+
+TEST_CASE("Recurrent functions with an alarm are polled", "[schedule]")
+{
+    bool alarm = false;
+    int count = 0;
+    REQUIRE(schedule_recurrent_function_us([&]() { return ++count < 2; }, 10000000, [&]() { return alarm; }));
+    run_scheduled_recurrent_functions();
+    REQUIRE(count == 0);
+    alarm = true;
+    run_scheduled_recurrent_functions();
+    REQUIRE(count == 1);
+    run_scheduled_recurrent_functions();
+    REQUIRE(count == 2);
+    run_scheduled_recurrent_functions();
+    REQUIRE(count == 2);
+}
@@ -0,0 +1,77 @@
+/*
+ test_StreamRope.cpp - StreamRope tests
+
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+ */
+
+#include <catch.hpp>
+#include <StreamRope.h>
+#include <StreamString.h>
+
+static String pattern(size_t len)
+{
+    String s;
+    for (size_t i = 0; i < len; i++)
+        s += (char)('a' + i % 26);
+    return s;
+}
+
+TEST_CASE("StreamRope keeps the order across segments", "[core][StreamRope]")
+{
+    StreamRope rope;
+    const String text = pattern(3 * StreamRope::segmentSize + 17);
+    REQUIRE(rope.print(text) == text.length());
+    REQUIRE(rope.length() == text.length());
+    REQUIRE(rope.toString() == text);
+    REQUIRE(rope.peekAvailable() == StreamRope::segmentSize);
+
+    REQUIRE(rope.read() == 'a');
+    REQUIRE(rope.peek() == 'b');
+    uint8_t buf[300];
+    REQUIRE(rope.read(buf, sizeof(buf)) == sizeof(buf));
+    REQUIRE(memcmp(buf, text.c_str() + 1, sizeof(buf)) == 0);
+    REQUIRE(rope.length() == text.length() - 1 - sizeof(buf));
+    REQUIRE(rope.toString() == text.substring(1 + sizeof(buf)));
+
+    rope.clear();
+    REQUIRE(rope.length() == 0);
+    REQUIRE(rope.read() == -1);
+    REQUIRE(rope.peekAvailable() == 0);
+}
+
+TEST_CASE("StreamRope sends through the peekBuffer API", "[core][StreamRope]")
+{
+    StreamRope rope;
+    const String text = pattern(5 * StreamRope::segmentSize - 3);
+    for (size_t i = 0; i < text.length(); i += 100)
+        rope.write((const uint8_t*)text.c_str() + i, std::min((size_t)100, text.length() - i));
+
+    StreamString out;
+    REQUIRE(rope.sendSize(out, 1000) == 1000);
+    REQUIRE(out == text.substring(0, 1000));
+    REQUIRE(rope.sendAll(out) == text.length() - 1000);
+    REQUIRE(out == text);
+    REQUIRE(rope.length() == 0);
+
+    // reusable once empty
+    rope.print("again");
+    REQUIRE(rope.toString() == "again");
+}
+
+TEST_CASE("StreamRope is filled by Stream::send", "[core][StreamRope]")
+{
+    const String text = pattern(2 * StreamRope::segmentSize + 1);
+    StreamString in(text);
+    StreamRope rope;
+    REQUIRE(in.sendAll(rope) == text.length());
+    REQUIRE(rope.toString() == text);
+
+    StreamRope moved(std::move(rope));
+    REQUIRE(rope.length() == 0);
+    REQUIRE(moved.toString() == text);
+}
@@ -54,3 +54,180 @@ TEST_CASE("Updater fails when writes overflow requested size", "[core][Updater]"
     REQUIRE(!u->write(buff, 2048));
     delete u;
 }
+
+TEST_CASE("Updater erases ahead only within the update", "[core][Updater]")
+{
+    UpdaterClass *u;
+    uint8_t buff[4096];
+    memset(buff, 0, sizeof(buff));
+    u = new UpdaterClass();
+    REQUIRE(!u->eraseAhead());
+    REQUIRE(u->begin(3 * 4096 + 100));
+    // Current sector plus two more by default
+    REQUIRE(u->eraseAhead());
+    REQUIRE(u->eraseAhead());
+    REQUIRE(u->eraseAhead());
+    REQUIRE(!u->eraseAhead());
+    // The first sector goes to flash once the buffer overflows
+    REQUIRE(u->write(buff, 4096));
+    REQUIRE(u->write(buff, 1));
+    // The window moved by one sector, the last one ends the update
+    REQUIRE(u->eraseAhead());
+    REQUIRE(!u->eraseAhead());
+    REQUIRE(u->write(buff, 4096));
+    REQUIRE(u->write(buff, 4096));
+    REQUIRE(u->write(buff, 99));
+    REQUIRE(u->remaining() == 0);
+    REQUIRE(!u->eraseAhead());
+    delete u;
+
+    u = new UpdaterClass();
+    u->setEraseAhead(0);
+    REQUIRE(u->begin(8192));
+    REQUIRE(u->eraseAhead());
+    REQUIRE(!u->eraseAhead());
+    delete u;
+}
+
+TEST_CASE("Updater with a second buffer writes it out in steps", "[core][Updater]")
+{
+    UpdaterClass *u;
+    uint8_t buff[4096];
+    memset(buff, 0, sizeof(buff));
+    u = new UpdaterClass();
+    u->setDoubleBuffer(true);
+    REQUIRE(u->begin(3 * 4096));
+    REQUIRE(u->write(buff, 4096));
+    REQUIRE(u->progress() == 0);
+    // The first buffer is handed over, one step of it is written
+    REQUIRE(u->write(buff, 4096));
+    REQUIRE(u->progress() == 4096);
+    // Remaining three steps, then the erases of the last two sectors
+    REQUIRE(u->eraseAhead());
+    REQUIRE(u->eraseAhead());
+    REQUIRE(u->eraseAhead());
+    REQUIRE(u->eraseAhead());
+    REQUIRE(u->eraseAhead());
+    REQUIRE(!u->eraseAhead());
+    REQUIRE(u->write(buff, 4096));
+    REQUIRE(u->remaining() == 0);
+    REQUIRE(!u->eraseAhead());
+    REQUIRE(!u->write(buff, 1));
+    delete u;
+
+    // Same overflow checks as with a single buffer
+    u = new UpdaterClass();
+    u->setDoubleBuffer(true);
+    REQUIRE(u->begin(5000));
+    REQUIRE(u->write(buff, 2048));
+    REQUIRE(u->write(buff, 2048));
+    REQUIRE(!u->write(buff, 2048));
+    delete u;
+}
+
+TEST_CASE("Updater rejects delta patches for another sketch", "[core][Updater]")
+{
+    UpdaterClass *u;
+    uint8_t patch[28 + 5 + 4];
+    memset(patch, 0, sizeof(patch));
+    patch[0] = UPDATER_DELTA_MAGIC;
+    patch[1] = 'E';
+    patch[2] = 'S';
+    patch[3] = 'D';
+    patch[4] = 4;       // 4 byte target
+    patch[8] = 1;       // built from a 1 byte sketch
+    patch[28] = 0x02;   // DATA, 4 bytes
+    patch[29] = 4;
+    u = new UpdaterClass();
+    REQUIRE(u->begin(sizeof(patch)));
+    REQUIRE(u->write(patch, 10) == 10);
+    REQUIRE(u->progress() == 10);
+    REQUIRE(u->size() == sizeof(patch));
+    REQUIRE(!u->hasError());
+    REQUIRE(u->write(patch + 10, sizeof(patch) - 10) != sizeof(patch) - 10);
+    REQUIRE(u->getError() == UPDATE_ERROR_DELTA);
+    delete u;
+}
+
+TEST_CASE("Updater decompresses zlib images while writing them", "[core][Updater]")
+{
+    // zlib with a 4KB window, 8192 and 8193 zero bytes
+    uint8_t zeros8192[] = {
+        0x48, 0xc7, 0xed, 0xc1, 0x01, 0x0d, 0x00, 0x00, 0x00, 0xc2, 0xa0, 0xf7, 0x4f, 0x6d, 0x0e, 0x37,
+        0xa0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x80, 0x77, 0x03, 0x20, 0x00, 0x00, 0x01 };
+    uint8_t zeros8193[] = {
+        0x48, 0xc7, 0xed, 0xc1, 0x01, 0x0d, 0x00, 0x00, 0x00, 0xc2, 0xa0, 0xf7, 0x4f, 0x6d, 0x0e, 0x37,
+        0xa0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x80, 0x7b, 0x03, 0x20, 0x01, 0x00, 0x01 };
+    UpdaterClass *u = new UpdaterClass();
+    REQUIRE(u->begin(8192));
+    REQUIRE(u->setInflate(sizeof(zeros8192), 12));
+    REQUIRE(u->size() == sizeof(zeros8192));
+    REQUIRE(u->write(zeros8192, 10) == 10);
+    REQUIRE(u->progress() == 10);
+    REQUIRE(!u->isFinished());
+    REQUIRE(u->write(zeros8192 + 10, sizeof(zeros8192) - 10) == sizeof(zeros8192) - 10);
+    REQUIRE(u->remaining() == 0);
+    REQUIRE(u->isFinished());
+    REQUIRE(!u->hasError());
+    delete u;
+
+    // One byte more than begin() was given
+    u = new UpdaterClass();
+    REQUIRE(u->begin(8192));
+    REQUIRE(u->setInflate(sizeof(zeros8193), 12));
+    REQUIRE(!u->write(zeros8193, sizeof(zeros8193)));
+    REQUIRE(u->getError() == UPDATE_ERROR_SPACE);
+    delete u;
+
+    // A window smaller than the stream's
+    u = new UpdaterClass();
+    REQUIRE(u->begin(8192));
+    REQUIRE(u->setInflate(sizeof(zeros8192), 10));
+    REQUIRE(!u->write(zeros8192, sizeof(zeros8192)));
+    REQUIRE(u->getError() == UPDATE_ERROR_INFLATE);
+    delete u;
+}
+
+class CountingHash : public UpdaterHashClass {
+  public:
+    void begin() override { bytes = 0; adds = 0; }
+    void add(const void *data, uint32_t len) override { (void)data; bytes += len; adds++; }
+    void end() override { }
+    int len() override { return 0; }
+    const void *hash() override { return nullptr; }
+    const unsigned char *oid() override { return nullptr; }
+    uint32_t bytes = 0;
+    uint32_t adds = 0;
+};
+
+class RecordingVerifier : public UpdaterVerifyClass {
+  public:
+    // The flash mock leaves buffers untouched, the length word reads as 0
+    uint32_t length() override { return 0; }
+    bool verify(UpdaterHashClass *hash, const void *signature, uint32_t signatureLen) override {
+        (void)signature; (void)signatureLen;
+        hashed = static_cast<CountingHash*>(hash)->bytes;
+        adds = static_cast<CountingHash*>(hash)->adds;
+        return false;
+    }
+    uint32_t hashed = 0;
+    uint32_t adds = 0;
+};
+
+TEST_CASE("Updater hashes signed images while writing them", "[core][Updater]")
+{
+    CountingHash hash;
+    RecordingVerifier verify;
+    uint8_t buff[1000];
+    memset(buff, 0, sizeof(buff));
+    UpdaterClass *u = new UpdaterClass();
+    u->installSignature(&hash, &verify);
+    REQUIRE(u->begin(sizeof(buff)));
+    REQUIRE(u->write(buff, sizeof(buff)) == sizeof(buff));
+    REQUIRE(!u->end());
+    REQUIRE(u->getError() == UPDATE_ERROR_SIGN);
+    // Everything but the length word, in one piece without reading back
+    REQUIRE(verify.hashed == sizeof(buff) - sizeof(uint32_t));
+    REQUIRE(verify.adds == 1);
+    delete u;
+}
@@ -0,0 +1,120 @@
+/*
+ test_base64.cpp - base64 codec tests
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <catch.hpp>
+#include <string.h>
+#include <base64.h>
+#include <StreamString.h>
+extern "C" {
+#include <libb64/cencode.h>
+}
+
+static String libb64Encode(const uint8_t* data, size_t length, bool doNewLines)
+{
+    base64_encodestate state;
+    if (doNewLines)
+    {
+        base64_init_encodestate(&state);
+    }
+    else
+    {
+        base64_init_encodestate_nonewlines(&state);
+    }
+    std::unique_ptr<char[]> out(new char[base64_encode_expected_len(length) + 1]);
+    int n = base64_encode_block((const char*)data, length, out.get(), &state);
+    base64_encode_blockend(out.get() + n, &state);
+    return String(out.get());
+}
+
+TEST_CASE("base64::encode matches the RFC 4648 vectors", "[core][base64]")
+{
+    REQUIRE(base64::encode(String("")) == "");
+    REQUIRE(base64::encode(String("f")) == "Zg==");
+    REQUIRE(base64::encode(String("fo")) == "Zm8=");
+    REQUIRE(base64::encode(String("foo")) == "Zm9v");
+    REQUIRE(base64::encode(String("foob")) == "Zm9vYg==");
+    REQUIRE(base64::encode(String("fooba")) == "Zm9vYmE=");
+    REQUIRE(base64::encode(String("foobar")) == "Zm9vYmFy");
+}
+
+TEST_CASE("base64 encoders match libb64", "[core][base64]")
+{
+    uint8_t data[300];
+    for (size_t i = 0; i < sizeof(data); ++i)
+    {
+        data[i] = i * 37 + 11;
+    }
+    for (bool doNewLines : { false, true })
+    {
+        for (size_t offset = 0; offset < 4; ++offset)
+        {
+            for (size_t length = 0; length + offset <= sizeof(data); length += 7)
+            {
+                const String expected = libb64Encode(data + offset, length, doNewLines);
+                REQUIRE(base64::encodedLength(length, doNewLines) == expected.length());
+                REQUIRE(base64::encode(data + offset, length, doNewLines) == expected);
+
+                char buf[500];
+                REQUIRE(base64::encode(data + offset, length, buf, doNewLines) == expected.length());
+                REQUIRE(expected == buf);
+
+                StreamString printed;
+                REQUIRE(base64::encode(data + offset, length, printed, doNewLines) == expected.length());
+                REQUIRE(printed == expected);
+
+                StreamString streamed;
+                {
+                    base64::Encoder encoder(streamed, doNewLines);
+                    for (size_t pos = 0, chunk = 1; pos < length; pos += chunk, chunk = chunk % 5 + 1)
+                    {
+                        encoder.write(data + offset + pos, std::min(chunk, length - pos));
+                    }
+                }
+                REQUIRE(streamed == expected);
+            }
+        }
+    }
+}
+
+TEST_CASE("base64::decode reverses encode", "[core][base64]")
+{
+    uint8_t data[200];
+    for (size_t i = 0; i < sizeof(data); ++i)
+    {
+        data[i] = i * 53 + 5;
+    }
+    for (bool doNewLines : { false, true })
+    {
+        for (size_t length = 0; length <= sizeof(data); ++length)
+        {
+            const String encoded = base64::encode(data, length, doNewLines);
+            uint8_t decoded[sizeof(data) + 3];
+            REQUIRE(base64::decodedLength(encoded.length()) >= length);
+            REQUIRE(base64::decode(encoded, decoded) == (int)length);
+            REQUIRE(memcmp(decoded, data, length) == 0);
+        }
+    }
+
+    uint8_t out[16];
+    REQUIRE(base64::decode(String("Zm9v\r\nYmE="), out) == 5);
+    REQUIRE(memcmp(out, "fooba", 5) == 0);
+    REQUIRE(base64::decode(String("Zm9vYg"), out) == 4);
+    REQUIRE(base64::decode(String("Zm9v*mFy"), out) == -1);
+    REQUIRE(base64::decode(String("Zm9vY"), out) == -1);
+}
@@ -0,0 +1,69 @@
+/*
+ test_cbuf.cpp - cbuf_pow2 tests
+
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+ */
+
+#include <catch.hpp>
+#include <string.h>
+#include <cbuf.h>
+
+TEST_CASE("cbuf_pow2 rounds its capacity up to a power of two", "[core][cbuf]")
+{
+    cbuf_pow2 a(100);
+    REQUIRE(a.capacity() == 128);
+    cbuf_pow2 b(256);
+    REQUIRE(b.capacity() == 256);
+    REQUIRE(b.empty());
+    REQUIRE(b.room() == 256);
+}
+
+TEST_CASE("cbuf_pow2 uses its whole capacity and keeps order across the wrap", "[core][cbuf]")
+{
+    cbuf_pow2 buf(16);
+    for (int i = 0; i < 16; ++i)
+        REQUIRE(buf.write((char)i));
+    REQUIRE(buf.full());
+    REQUIRE_FALSE(buf.write('x'));
+
+    char out[16];
+    REQUIRE(buf.read(out, 10) == 10);
+    REQUIRE(out[9] == 9);
+    REQUIRE(buf.write("abcdefgh", 8) == 8);
+    REQUIRE(buf.available() == 14);
+
+    // the data now wraps: the first span stops at the end of the storage
+    const char* span;
+    REQUIRE(buf.readSpan(span) == 6);
+    REQUIRE(span[0] == 10);
+    buf.consume(6);
+    REQUIRE(buf.readSpan(span) == 8);
+    REQUIRE(memcmp(span, "abcdefgh", 8) == 0);
+    buf.consume(8);
+    REQUIRE(buf.empty());
+    REQUIRE(buf.read() == -1);
+}
+
+TEST_CASE("cbuf_pow2 write spans are committed explicitly", "[core][cbuf]")
+{
+    cbuf_pow2 buf(8);
+    buf.write("12345", 5);
+    buf.consume(5);
+
+    char* span;
+    REQUIRE(buf.writeSpan(span) == 3);
+    memcpy(span, "xyz", 3);
+    REQUIRE(buf.available() == 0);
+    buf.commit(3);
+    REQUIRE(buf.writeSpan(span) == 5);
+    REQUIRE(buf.peek() == 'x');
+
+    char out[4] = { };
+    REQUIRE(buf.read(out, sizeof(out) - 1) == 3);
+    REQUIRE(strcmp(out, "xyz") == 0);
+}
@@ -0,0 +1,43 @@
+/*
+ test_crc32.cpp - crc32() tests
+
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+ */
+
+#include <catch.hpp>
+#include <string.h>
+#include <coredecls.h>
+
+TEST_CASE("crc32 matches the MPEG-2 check value", "[core][crc32]")
+{
+    REQUIRE(crc32("123456789", 9) == 0x0376e6e7);
+    REQUIRE(crc32("", 0) == 0xffffffff);
+}
+
+TEST_CASE("crc32 does not depend on alignment or on how the data is split", "[core][crc32]")
+{
+    uint8_t buf[300];
+    for (size_t i = 0; i < sizeof(buf); ++i)
+        buf[i] = (uint8_t)(i * 131 + 7);
+
+    for (size_t offset = 0; offset < 8; ++offset)
+    {
+        const uint8_t* data = buf + offset;
+        const size_t len = sizeof(buf) - 8;
+        uint32_t whole = crc32(data, len);
+        for (size_t split = 0; split <= len; split += 37)
+        {
+            uint32_t crc = crc32(data, split);
+            REQUIRE(crc32(data + split, len - split, crc) == whole);
+        }
+        uint32_t bytewise = 0xffffffff;
+        for (size_t i = 0; i < len; ++i)
+            bytewise = crc32(data + i, 1, bytewise);
+        REQUIRE(bytewise == whole);
+    }
+}
@@ -0,0 +1,297 @@
+/*
+ test_inflater.cpp - streaming zlib and gzip decompression tests
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <catch.hpp>
+#include <string.h>
+#include <string>
+#include <Inflater.h>
+
+// Compressed with python zlib from the generators below
+static const uint8_t zlibText[] = {
+    0x48, 0xc7, 0x8d, 0x97, 0x51, 0x4e, 0xc3, 0x30, 0x10, 0x44, 0xff, 0xf7, 0x14, 0x39, 0x03, 0x1f,
+    0x15, 0xd7, 0xa9, 0x68, 0x50, 0x23, 0xa0, 0x54, 0xa4, 0xa8, 0xd7, 0x07, 0x29, 0xbb, 0x26, 0xf3,
+    0x18, 0x1b, 0x7e, 0x1a, 0x39, 0xb1, 0xd7, 0xb3, 0xb3, 0x33, 0xf6, 0x76, 0xb9, 0x3c, 0xbf, 0x1e,
+    0x6f, 0xf3, 0xb4, 0xe4, 0xf3, 0xbe, 0x5c, 0x4e, 0xef, 0xf7, 0xe9, 0x7b, 0xb0, 0x9e, 0xa7, 0xc8,
+    0x91, 0xbc, 0xdc, 0x7e, 0xf3, 0x55, 0x2d, 0x5b, 0x5f, 0xe6, 0xdb, 0xd3, 0x79, 0x5a, 0x6f, 0x1f,
+    0xf3, 0xf1, 0x6d, 0x8a, 0x1c, 0xce, 0xeb, 0xf5, 0xf1, 0xe1, 0x70, 0x98, 0x3e, 0xaf, 0x27, 0xb3,
+    0x47, 0x7d, 0x8d, 0xfc, 0x1c, 0xf5, 0x02, 0xb1, 0x97, 0x11, 0x44, 0xdd, 0xb8, 0x22, 0xe4, 0xdb,
+    0x3d, 0xe0, 0x88, 0x02, 0x07, 0x54, 0xf9, 0xc8, 0xaf, 0x39, 0x42, 0x20, 0x20, 0x03, 0x40, 0x0d,
+    0x54, 0xd9, 0x64, 0xc0, 0x7c, 0x24, 0xda, 0x84, 0x80, 0x95, 0x1a, 0x36, 0xf7, 0xac, 0x39, 0xb5,
+    0xf7, 0x16, 0x01, 0x54, 0x82, 0x7f, 0xd9, 0x05, 0xc5, 0xb0, 0x75, 0x03, 0xa7, 0x96, 0x8b, 0x46,
+    0x18, 0xd1, 0xf3, 0x19, 0xb2, 0x3d, 0x76, 0x02, 0xeb, 0xdb, 0x54, 0xf0, 0xa0, 0xc0, 0x51, 0x03,
+    0xad, 0x74, 0xad, 0x34, 0x9a, 0x54, 0x1a, 0xf3, 0x11, 0x46, 0xc3, 0xdb, 0xaf, 0xf2, 0x5b, 0x10,
+    0x7c, 0x0d, 0x14, 0xa0, 0x22, 0x12, 0x9a, 0x6b, 0x01, 0x84, 0xd3, 0x91, 0x55, 0x28, 0x1b, 0x7b,
+    0x74, 0x44, 0x10, 0x40, 0x16, 0x7e, 0x9a, 0x10, 0xa2, 0x4c, 0x00, 0x4a, 0x0b, 0xc4, 0x2a, 0x4b,
+    0x08, 0xef, 0x19, 0x94, 0x4d, 0xe2, 0x3b, 0xd5, 0x85, 0x98, 0x01, 0x52, 0x46, 0xd5, 0x63, 0xac,
+    0x74, 0x95, 0xa8, 0xca, 0xd7, 0x6a, 0x4b, 0xc9, 0xd5, 0x11, 0x4c, 0x0f, 0x53, 0xa8, 0x74, 0x94,
+    0xe1, 0xf0, 0x9e, 0xb5, 0x40, 0xc0, 0x0f, 0x4e, 0x23, 0x8d, 0xfe, 0x2b, 0xeb, 0x81, 0xa5, 0x7d,
+    0x5c, 0x2d, 0xba, 0x22, 0x09, 0xa8, 0x26, 0x34, 0x84, 0x0b, 0x1b, 0x3c, 0xb4, 0xad, 0x9f, 0x23,
+    0x86, 0xe7, 0x9c, 0xb2, 0x0e, 0x6f, 0x58, 0x15, 0x75, 0x4a, 0xd2, 0xf4, 0xb4, 0x4d, 0x46, 0xf8,
+    0x90, 0x04, 0x3a, 0x4e, 0x01, 0x34, 0xa8, 0x9f, 0xfe, 0xc5, 0xec, 0x50, 0xe5, 0x63, 0xb1, 0x7e,
+    0xd4, 0x64, 0xe1, 0xfc, 0xbd, 0xd5, 0xed, 0xea, 0xc6, 0x77, 0xa5, 0xec, 0xb3, 0xb0, 0x4e, 0x47,
+    0x6a, 0xe1, 0xd1, 0xfa, 0xbb, 0x1a, 0x43, 0x67, 0x30, 0xcb, 0xb2, 0x24, 0xbd, 0xff, 0xf5, 0x96,
+    0x18, 0xb3, 0x9d, 0xc9, 0x46, 0x47, 0x05, 0xee, 0x86, 0x55, 0xa0, 0x9d, 0xaa, 0xb2, 0x8a, 0xd6,
+    0xbc, 0x56, 0x8f, 0x7f, 0x1f, 0xd4, 0x3f, 0x1e, 0x0b, 0x9b, 0xeb, 0xe8, 0xee, 0xd0, 0x51, 0x4b,
+    0x3b, 0xfe, 0x73, 0xf6, 0x61, 0x1b, 0x5e, 0x38, 0x4e, 0x8b, 0x6a, 0xdd, 0xd6, 0xb7, 0xe4, 0xee,
+    0xb6, 0xdd, 0xf2, 0x17, 0x21, 0xca, 0x24, 0xc2, 0xa8, 0xb0, 0x75, 0x40, 0x28, 0xea, 0x3a, 0x28,
+    0x42, 0x6f, 0x14, 0x89, 0x40, 0x75, 0xd8, 0x33, 0x1b, 0xf9, 0xfa, 0xe1, 0xa8, 0x4b, 0xb4, 0x64,
+    0x58, 0x55, 0x77, 0xda, 0x58, 0x76, 0x4b, 0x50, 0x97, 0x3a, 0x14, 0x2c, 0xc8, 0x94, 0x61, 0x77,
+    0x49, 0x99, 0xf5, 0x2e, 0x0c, 0xa9, 0x9a, 0xe9, 0x7d, 0x2c, 0x80, 0x2a, 0xbd, 0x31, 0xb1, 0xce,
+    0x27, 0xaf, 0x90, 0x8c, 0xed, 0x42, 0x58, 0xc6, 0x5a, 0x14, 0x43, 0x8d, 0xba, 0x1a, 0xe1, 0xcf,
+    0x06, 0x0d, 0x66, 0xbd, 0x24, 0x14, 0xd8, 0x76, 0x53, 0x2b, 0xd3, 0x3f, 0x98, 0x6d, 0x72, 0x8a,
+    0x0c, 0x7d, 0x5d, 0x78, 0x33, 0xf2, 0x7e, 0x1a, 0x5e, 0x96, 0xe1, 0xdd, 0xf5, 0x73, 0x83, 0xab,
+    0xb4, 0xfb, 0x0d, 0xae, 0x02, 0x56, 0x26, 0xba, 0x9d, 0xbd, 0x25, 0xbe, 0x83, 0xd7, 0xce, 0xb5,
+    0xe5, 0x74, 0x9d, 0x22, 0x4e, 0x0d, 0xf4, 0xfe, 0xa0, 0xb7, 0xf5, 0x3a, 0x72, 0xe6, 0x8d, 0x4c,
+    0x15, 0x1e, 0x3b, 0x7a, 0x1d, 0xdf, 0x2b, 0xf6, 0x2c, 0xe7, 0x2f, 0x17, 0xf6, 0x24, 0x3e, 0x05,
+    0x7f, 0x78, 0xef, 0x9a, 0xab, 0x2f, 0x83, 0xf3, 0x8b, 0x8a,
+};
+static const uint8_t storedText[] = {
+    0x48, 0x0d, 0x01, 0x2c, 0x01, 0xd3, 0xfe, 0x69, 0x6e, 0x66, 0x6c, 0x61, 0x74, 0x65, 0x20, 0x69,
+    0x6e, 0x66, 0x6c, 0x61, 0x74, 0x65, 0x20, 0x77, 0x69, 0x6e, 0x64, 0x6f, 0x77, 0x20, 0x66, 0x6c,
+    0x61, 0x73, 0x68, 0x20, 0x0a, 0x77, 0x69, 0x6e, 0x64, 0x6f, 0x77, 0x20, 0x77, 0x69, 0x6e, 0x64,
+    0x6f, 0x77, 0x20, 0x66, 0x6c, 0x61, 0x73, 0x68, 0x20, 0x66, 0x6c, 0x61, 0x73, 0x68, 0x20, 0x77,
+    0x69, 0x6e, 0x64, 0x6f, 0x77, 0x20, 0x69, 0x6e, 0x66, 0x6c, 0x61, 0x74, 0x65, 0x20, 0x73, 0x6b,
+    0x65, 0x74, 0x63, 0x68, 0x20, 0x73, 0x74, 0x72, 0x65, 0x61, 0x6d, 0x20, 0x0a, 0x73, 0x6b, 0x65,
+    0x74, 0x63, 0x68, 0x20, 0x65, 0x73, 0x70, 0x38, 0x32, 0x36, 0x36, 0x20, 0x75, 0x70, 0x64, 0x61,
+    0x74, 0x65, 0x20, 0x69, 0x6e, 0x66, 0x6c, 0x61, 0x74, 0x65, 0x20, 0x77, 0x69, 0x6e, 0x64, 0x6f,
+    0x77, 0x20, 0x65, 0x73, 0x70, 0x38, 0x32, 0x36, 0x36, 0x20, 0x0a, 0x75, 0x70, 0x64, 0x61, 0x74,
+    0x65, 0x20, 0x0a, 0x65, 0x73, 0x70, 0x38, 0x32, 0x36, 0x36, 0x20, 0x77, 0x69, 0x6e, 0x64, 0x6f,
+    0x77, 0x20, 0x69, 0x6e, 0x66, 0x6c, 0x61, 0x74, 0x65, 0x20, 0x69, 0x6e, 0x66, 0x6c, 0x61, 0x74,
+    0x65, 0x20, 0x69, 0x6e, 0x66, 0x6c, 0x61, 0x74, 0x65, 0x20, 0x77, 0x69, 0x6e, 0x64, 0x6f, 0x77,
+    0x20, 0x66, 0x6c, 0x61, 0x73, 0x68, 0x20, 0x73, 0x6b, 0x65, 0x74, 0x63, 0x68, 0x20, 0x73, 0x74,
+    0x72, 0x65, 0x61, 0x6d, 0x20, 0x65, 0x73, 0x70, 0x38, 0x32, 0x36, 0x36, 0x20, 0x73, 0x6b, 0x65,
+    0x74, 0x63, 0x68, 0x20, 0x66, 0x6c, 0x61, 0x73, 0x68, 0x20, 0x66, 0x6c, 0x61, 0x73, 0x68, 0x20,
+    0x0a, 0x0a, 0x73, 0x74, 0x72, 0x65, 0x61, 0x6d, 0x20, 0x0a, 0x65, 0x73, 0x70, 0x38, 0x32, 0x36,
+    0x36, 0x20, 0x75, 0x70, 0x64, 0x61, 0x74, 0x65, 0x20, 0x75, 0x70, 0x64, 0x61, 0x74, 0x65, 0x20,
+    0x73, 0x74, 0x72, 0x65, 0x61, 0x6d, 0x20, 0x75, 0x70, 0x64, 0x61, 0x74, 0x65, 0x20, 0x65, 0x73,
+    0x70, 0x38, 0x32, 0x36, 0x36, 0x20, 0x73, 0x6b, 0x65, 0x74, 0x63, 0x68, 0x20, 0x65, 0x73, 0x70,
+    0x38, 0x32, 0x36, 0x64, 0x29, 0x69, 0xdd,
+};
+static const uint8_t zlibShort[] = {
+    0x48, 0xc7, 0xcb, 0xcc, 0x4b, 0xcb, 0x49, 0x2c, 0x49, 0x55, 0xc8, 0x84, 0xd2, 0xe5, 0x99, 0x79,
+    0x29, 0xf9, 0xe5, 0x0a, 0x40, 0x4e, 0x71, 0x86, 0x02, 0x17, 0x94, 0x87, 0x22, 0x08, 0x21, 0xa1,
+    0x42, 0x30, 0x6d, 0xc5, 0xd9, 0xa9, 0x25, 0xc9, 0x19, 0x0a, 0xc5, 0x25, 0x45, 0xa9, 0x89, 0xb9,
+    0x0a, 0x5c, 0x50, 0x6e, 0x6a, 0x71, 0x81, 0x85, 0x91, 0x99, 0x19, 0x00, 0x63, 0x76, 0x24, 0x96,
+};
+static const uint8_t gzipText[] = {
+    0x1f, 0x8b, 0x08, 0x1e, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x03, 0x00, 0x78, 0x79, 0x7a, 0x69,
+    0x6d, 0x61, 0x67, 0x65, 0x2e, 0x62, 0x69, 0x6e, 0x00, 0x63, 0x6f, 0x6d, 0x6d, 0x65, 0x6e, 0x74,
+    0x00, 0x6c, 0x13, 0x8d, 0x97, 0x51, 0x4e, 0xc3, 0x30, 0x10, 0x44, 0xff, 0xf7, 0x14, 0x39, 0x03,
+    0x1f, 0x15, 0xd7, 0xa9, 0x68, 0x50, 0x23, 0xa0, 0x54, 0xa4, 0xa8, 0xd7, 0x07, 0x29, 0xbb, 0x26,
+    0xf3, 0x18, 0x1b, 0x7e, 0x1a, 0x39, 0xb1, 0xd7, 0xb3, 0xb3, 0x33, 0xf6, 0x76, 0xb9, 0x3c, 0xbf,
+    0x1e, 0x6f, 0xf3, 0xb4, 0xe4, 0xf3, 0xbe, 0x5c, 0x4e, 0xef, 0xf7, 0xe9, 0x7b, 0xb0, 0x9e, 0xa7,
+    0xc8, 0x91, 0xbc, 0xdc, 0x7e, 0xf3, 0x55, 0x2d, 0x5b, 0x5f, 0xe6, 0xdb, 0xd3, 0x79, 0x5a, 0x6f,
+    0x1f, 0xf3, 0xf1, 0x6d, 0x8a, 0x1c, 0xce, 0xeb, 0xf5, 0xf1, 0xe1, 0x70, 0x98, 0x3e, 0xaf, 0x27,
+    0xb3, 0x47, 0x7d, 0x8d, 0xfc, 0x1c, 0xf5, 0x02, 0xb1, 0x97, 0x11, 0x44, 0xdd, 0xb8, 0x22, 0xe4,
+    0xdb, 0x3d, 0xe0, 0x88, 0x02, 0x07, 0x54, 0xf9, 0xc8, 0xaf, 0x39, 0x42, 0x20, 0x20, 0x03, 0x40,
+    0x0d, 0x54, 0xd9, 0x64, 0xc0, 0x7c, 0x24, 0xda, 0x84, 0x80, 0x95, 0x1a, 0x36, 0xf7, 0xac, 0x39,
+    0xb5, 0xf7, 0x16, 0x01, 0x54, 0x82, 0x7f, 0xd9, 0x05, 0xc5, 0xb0, 0x75, 0x03, 0xa7, 0x96, 0x8b,
+    0x46, 0x18, 0xd1, 0xf3, 0x19, 0xb2, 0x3d, 0x76, 0x02, 0xeb, 0xdb, 0x54, 0xf0, 0xa0, 0xc0, 0x51,
+    0x03, 0xad, 0x74, 0xad, 0x34, 0x9a, 0x54, 0x1a, 0xf3, 0x11, 0x46, 0xc3, 0xdb, 0xaf, 0xf2, 0x5b,
+    0x10, 0x7c, 0x0d, 0x14, 0xa0, 0x22, 0x12, 0x9a, 0x6b, 0x01, 0x84, 0xd3, 0x91, 0x55, 0x28, 0x1b,
+    0x7b, 0x74, 0x44, 0x10, 0x40, 0x16, 0x7e, 0x9a, 0x10, 0xa2, 0x4c, 0x00, 0x4a, 0x0b, 0xc4, 0x2a,
+    0x4b, 0x08, 0xef, 0x19, 0x94, 0x4d, 0xe2, 0x3b, 0xd5, 0x85, 0x98, 0x01, 0x52, 0x46, 0xd5, 0x63,
+    0xac, 0x74, 0x95, 0xa8, 0xca, 0xd7, 0x6a, 0x4b, 0xc9, 0xd5, 0x11, 0x4c, 0x0f, 0x53, 0xa8, 0x74,
+    0x94, 0xe1, 0xf0, 0x9e, 0xb5, 0x40, 0xc0, 0x0f, 0x4e, 0x23, 0x8d, 0xfe, 0x2b, 0xeb, 0x81, 0xa5,
+    0x7d, 0x5c, 0x2d, 0xba, 0x22, 0x09, 0xa8, 0x26, 0x34, 0x84, 0x0b, 0x1b, 0x3c, 0xb4, 0xad, 0x9f,
+    0x23, 0x86, 0xe7, 0x9c, 0xb2, 0x0e, 0x6f, 0x58, 0x15, 0x75, 0x4a, 0xd2, 0xf4, 0xb4, 0x4d, 0x46,
+    0xf8, 0x90, 0x04, 0x3a, 0x4e, 0x01, 0x34, 0xa8, 0x9f, 0xfe, 0xc5, 0xec, 0x50, 0xe5, 0x63, 0xb1,
+    0x7e, 0xd4, 0x64, 0xe1, 0xfc, 0xbd, 0xd5, 0xed, 0xea, 0xc6, 0x77, 0xa5, 0xec, 0xb3, 0xb0, 0x4e,
+    0x47, 0x6a, 0xe1, 0xd1, 0xfa, 0xbb, 0x1a, 0x43, 0x67, 0x30, 0xcb, 0xb2, 0x24, 0xbd, 0xff, 0xf5,
+    0x96, 0x18, 0xb3, 0x9d, 0xc9, 0x46, 0x47, 0x05, 0xee, 0x86, 0x55, 0xa0, 0x9d, 0xaa, 0xb2, 0x8a,
+    0xd6, 0xbc, 0x56, 0x8f, 0x7f, 0x1f, 0xd4, 0x3f, 0x1e, 0x0b, 0x9b, 0xeb, 0xe8, 0xee, 0xd0, 0x51,
+    0x4b, 0x3b, 0xfe, 0x73, 0xf6, 0x61, 0x1b, 0x5e, 0x38, 0x4e, 0x8b, 0x6a, 0xdd, 0xd6, 0xb7, 0xe4,
+    0xee, 0xb6, 0xdd, 0xf2, 0x17, 0x21, 0xca, 0x24, 0xc2, 0xa8, 0xb0, 0x75, 0x40, 0x28, 0xea, 0x3a,
+    0x28, 0x42, 0x6f, 0x14, 0x89, 0x40, 0x75, 0xd8, 0x33, 0x1b, 0xf9, 0xfa, 0xe1, 0xa8, 0x4b, 0xb4,
+    0x64, 0x58, 0x55, 0x77, 0xda, 0x58, 0x76, 0x4b, 0x50, 0x97, 0x3a, 0x14, 0x2c, 0xc8, 0x94, 0x61,
+    0x77, 0x49, 0x99, 0xf5, 0x2e, 0x0c, 0xa9, 0x9a, 0xe9, 0x7d, 0x2c, 0x80, 0x2a, 0xbd, 0x31, 0xb1,
+    0xce, 0x27, 0xaf, 0x90, 0x8c, 0xed, 0x42, 0x58, 0xc6, 0x5a, 0x14, 0x43, 0x8d, 0xba, 0x1a, 0xe1,
+    0xcf, 0x06, 0x0d, 0x66, 0xbd, 0x24, 0x14, 0xd8, 0x76, 0x53, 0x2b, 0xd3, 0x3f, 0x98, 0x6d, 0x72,
+    0x8a, 0x0c, 0x7d, 0x5d, 0x78, 0x33, 0xf2, 0x7e, 0x1a, 0x5e, 0x96, 0xe1, 0xdd, 0xf5, 0x73, 0x83,
+    0xab, 0xb4, 0xfb, 0x0d, 0xae, 0x02, 0x56, 0x26, 0xba, 0x9d, 0xbd, 0x25, 0xbe, 0x83, 0xd7, 0xce,
+    0xb5, 0xe5, 0x74, 0x9d, 0x22, 0x4e, 0x0d, 0xf4, 0xfe, 0xa0, 0xb7, 0xf5, 0x3a, 0x72, 0xe6, 0x8d,
+    0x4c, 0x15, 0x1e, 0x3b, 0x7a, 0x1d, 0xdf, 0x2b, 0xf6, 0x2c, 0xe7, 0x2f, 0x17, 0xf6, 0x24, 0x3e,
+    0x05, 0x7f, 0x78, 0xef, 0x9a, 0xab, 0x2f, 0x20, 0xf0, 0xaf, 0xfa, 0xa0, 0x0f, 0x00, 0x00,
+};
+static const uint8_t zlibFar[] = {
+    0x58, 0xc3, 0xed, 0x58, 0x49, 0x12, 0xe5, 0x3a, 0x08, 0xeb, 0xab, 0x62, 0x06, 0x33, 0x9b, 0xfb,
+    0xaf, 0x9a, 0xf7, 0xef, 0xf0, 0x37, 0x5d, 0x51, 0xa5, 0x32, 0x55, 0xc0, 0x42, 0x52, 0x36, 0x66,
+    0x94, 0x7a, 0xf7, 0x1a, 0x8a, 0x85, 0x79, 0xa3, 0x2a, 0x4b, 0x9f, 0xd1, 0xc9, 0x2b, 0xe7, 0xb5,
+    0xca, 0x5c, 0xe7, 0x56, 0xea, 0x8a, 0x07, 0x7c, 0x25, 0x0c, 0xfa, 0xd9, 0x11, 0xbb, 0x37, 0xc1,
+    0x92, 0x01, 0xc5, 0xf5, 0x1c, 0x74, 0x1b, 0xda, 0x4f, 0x82, 0x4a, 0xd9, 0xcd, 0xb1, 0x8e, 0xce,
+    0x38, 0xf5, 0x63, 0x97, 0xc9, 0xca, 0x86, 0x43, 0xb4, 0x8d, 0x32, 0x86, 0xd8, 0xfb, 0x0a, 0x8f,
+    0x73, 0xbc, 0x92, 0x4a, 0x61, 0x1c, 0x3b, 0x75, 0xa5, 0x23, 0x96, 0x05, 0xa0, 0xb3, 0x78, 0xa8,
+    0x82, 0x23, 0xe9, 0x20, 0x9e, 0x37, 0x34, 0x2d, 0x77, 0x1b, 0xbc, 0x62, 0x61, 0x9f, 0x13, 0x44,
+    0xa4, 0x4f, 0xa2, 0x8c, 0xb6, 0xf4, 0xfa, 0x84, 0x63, 0x4e, 0x2a, 0x90, 0xe2, 0x81, 0xa7, 0x5c,
+    0x0e, 0x37, 0xc0, 0x9f, 0x78, 0x62, 0xa3, 0xf7, 0xbc, 0xca, 0xbb, 0x84, 0x58, 0x1d, 0xe6, 0xbd,
+    0x4c, 0x92, 0x4e, 0x52, 0xd6, 0xe8, 0xec, 0xba, 0x5b, 0x16, 0x03, 0x17, 0xcf, 0x6d, 0xb2, 0x67,
+    0x73, 0xc3, 0x82, 0x92, 0x9b, 0xb5, 0xdb, 0x2d, 0xcd, 0x73, 0xe4, 0x91, 0x19, 0x1c, 0x34, 0xe4,
+    0x65, 0x04, 0x7b, 0x85, 0x55, 0x2b, 0x97, 0xab, 0x99, 0xf9, 0x29, 0x3e, 0xde, 0xd1, 0xd5, 0x73,
+    0xf3, 0x76, 0xb2, 0x5f, 0x60, 0x19, 0x29, 0xf3, 0xd5, 0xe3, 0x39, 0xe2, 0x80, 0x3d, 0x38, 0xe7,
+    0x42, 0x46, 0x86, 0x00, 0xb5, 0x34, 0xa7, 0xe0, 0xe1, 0x4b, 0x06, 0x78, 0x75, 0xc8, 0x7f, 0x0f,
+    0xc2, 0xbb, 0x1a, 0x50, 0x38, 0xe7, 0xca, 0x02, 0xd2, 0x6f, 0xe7, 0xf2, 0x14, 0xa9, 0x23, 0x47,
+    0x5a, 0x08, 0x6b, 0xdc, 0x56, 0x07, 0xb6, 0xa5, 0xf0, 0x1a, 0x77, 0x9a, 0x5a, 0x9f, 0xa8, 0x08,
+    0x49, 0x64, 0xbb, 0xad, 0x6f, 0xcb, 0x23, 0xd7, 0xc6, 0xea, 0x8b, 0xf1, 0x34, 0x28, 0x80, 0x7c,
+    0xd5, 0x00, 0xe3, 0xb2, 0x87, 0x94, 0xed, 0x74, 0xcb, 0x9f, 0x29, 0x66, 0x51, 0xfb, 0xc5, 0xa2,
+    0x49, 0x44, 0x50, 0x5c, 0x7a, 0xdb, 0xd5, 0x23, 0x9e, 0xf4, 0x4a, 0xa1, 0xfb, 0xce, 0xf8, 0x47,
+    0xbd, 0x7d, 0x87, 0xf1, 0x6b, 0x4a, 0x60, 0xa8, 0xa6, 0xae, 0xbe, 0xce, 0xc3, 0x7b, 0x07, 0x99,
+    0xab, 0xab, 0x6a, 0x22, 0xd5, 0x92, 0xde, 0x8a, 0xb3, 0x31, 0x38, 0x26, 0xa2, 0x87, 0xee, 0xf8,
+    0x99, 0x29, 0x64, 0xca, 0x72, 0xd9, 0xca, 0x47, 0xbc, 0x79, 0xf3, 0xff, 0x74, 0x1e, 0xdf, 0x08,
+    0xf8, 0x7b, 0x9a, 0x00, 0x1b, 0x85, 0x40, 0x0e, 0x7e, 0x71, 0xe2, 0x5a, 0xd9, 0xda, 0xc3, 0x6a,
+    0xfe, 0xf4, 0x1e, 0x97, 0xb7, 0x21, 0x5c, 0x53, 0x83, 0x7d, 0x27, 0x1b, 0x98, 0xea, 0x73, 0x40,
+    0xce, 0xd5, 0x7a, 0xfb, 0xbd, 0x0d, 0xe8, 0x18, 0xe9, 0xb9, 0xa3, 0x07, 0xc1, 0xb6, 0x02, 0xb7,
+    0xf3, 0x14, 0x6f, 0xa0, 0xb4, 0x94, 0xe6, 0x0e, 0x03, 0xa1, 0xad, 0x96, 0xe7, 0xbe, 0xc3, 0xac,
+    0x64, 0x17, 0xce, 0x2e, 0x98, 0x6b, 0x45, 0xec, 0x0d, 0x2c, 0xf5, 0xb3, 0xa3, 0xbe, 0x25, 0xbb,
+    0x9e, 0x4c, 0xc8, 0x14, 0xe5, 0x2e, 0x1b, 0x50, 0xcb, 0x97, 0xb1, 0x35, 0x92, 0xea, 0x6a, 0x6e,
+    0x80, 0x37, 0x20, 0x1d, 0x75, 0x7e, 0x03, 0x73, 0x43, 0x64, 0x76, 0x16, 0x6e, 0x5a, 0x75, 0x85,
+    0xba, 0xe2, 0xde, 0x92, 0xfc, 0xe4, 0x0a, 0xca, 0x74, 0xaf, 0xb3, 0x77, 0x7f, 0x2a, 0x04, 0xa2,
+    0xad, 0x5e, 0x35, 0x8e, 0x67, 0xaf, 0x83, 0xc8, 0x37, 0xf4, 0xe7, 0xa0, 0xaf, 0x36, 0x27, 0x37,
+    0xf7, 0x4b, 0x8d, 0x6a, 0x0f, 0xb2, 0xd5, 0x0b, 0x6b, 0xad, 0x58, 0xc2, 0xbc, 0x24, 0x27, 0x60,
+    0xfd, 0xeb, 0x3d, 0xbf, 0x93, 0x7c, 0x66, 0xcf, 0x86, 0xab, 0x5b, 0x1f, 0xd5, 0x94, 0x33, 0xfd,
+    0xba, 0x39, 0x44, 0x6b, 0xed, 0x8f, 0x70, 0xa1, 0xde, 0x84, 0x32, 0x5c, 0x35, 0x8b, 0x99, 0x9d,
+    0x75, 0x7f, 0x66, 0xf8, 0xf3, 0xe1, 0xc3, 0x87, 0x0f, 0x1f, 0x3e, 0x7c, 0xf8, 0xf0, 0xe1, 0xc3,
+    0x87, 0x0f, 0x1f, 0x3e, 0x7c, 0xf8, 0xf0, 0xe1, 0xc3, 0x87, 0xff, 0x1d, 0xfc, 0xed, 0xb7, 0x7f,
+    0xfb, 0xed, 0xdf, 0x7e, 0xfb, 0x3f, 0xbf, 0xdf, 0xfe, 0x17, 0xd4, 0x65, 0x31, 0x2c,
+};
+static const uint8_t zlibWide[] = {
+    0x78, 0xda, 0xcb, 0xcc, 0x4b, 0xcb, 0x49, 0x2c, 0x49, 0x55, 0xc8, 0x84, 0xd2, 0xe5, 0x99, 0x79,
+    0x29, 0xf9, 0xe5, 0x0a, 0x40, 0x4e, 0x71, 0x86, 0x02, 0x17, 0x94, 0x87, 0x22, 0x08, 0x00, 0xe1,
+    0xe7, 0x12, 0x95,
+};
+
+// Words picked by an LCG
+static std::string text(size_t n)
+{
+    static const char* const words[] = {
+        "esp8266 ", "update ", "flash ", "sketch ", "inflate ", "window ", "stream ", "\n" };
+    uint32_t s = 12345;
+    std::string out;
+    while (out.size() < n)
+    {
+        s = (s * 1103515245 + 12345) & 0x7fffffff;
+        out += words[(s >> 16) % 8];
+    }
+    out.resize(n);
+    return out;
+}
+
+// 1000 random letters, 5000 zeros, the same letters again
+static std::string far()
+{
+    uint32_t s = 777;
+    std::string letters;
+    for (int i = 0; i < 1000; ++i)
+    {
+        s = (s * 1103515245 + 12345) & 0x7fffffff;
+        letters += (char)('a' + ((s >> 16) & 15));
+    }
+    return letters + std::string(5000, '\0') + letters;
+}
+
+// Feeds the stream in pieces of `step` bytes
+static Inflater::Error inflate(const uint8_t* data, size_t len, uint8_t windowBits, size_t step, std::string& out)
+{
+    Inflater inflater;
+    REQUIRE(inflater.begin(windowBits, [&](const uint8_t* data, size_t len) {
+        out.append((const char*)data, len);
+        return true;
+    }));
+    for (size_t pos = 0; pos < len; pos += step)
+    {
+        const size_t n = std::min(step, len - pos);
+        if (inflater.write(data + pos, n) != n)
+        {
+            return inflater.error();
+        }
+    }
+    inflater.finish();
+    if (inflater.error() == Inflater::Ok)
+    {
+        REQUIRE(inflater.done());
+        REQUIRE(inflater.total() == out.size());
+    }
+    return inflater.error();
+}
+
+TEST_CASE("Inflater decodes zlib and gzip streams fed in any pieces", "[core][Inflater]")
+{
+    const struct
+    {
+        const uint8_t* data;
+        size_t len;
+        std::string expected;
+    } streams[] = {
+        { zlibText, sizeof(zlibText), text(4000) },         // dynamic trees
+        { zlibShort, sizeof(zlibShort), text(100) },        // fixed trees
+        { storedText, sizeof(storedText), text(300) },      // stored block
+        { gzipText, sizeof(gzipText), text(4000) },         // gzip with all optional fields
+    };
+    for (const auto& stream : streams)
+    {
+        for (size_t step : { (size_t)1, (size_t)7, (size_t)300, (size_t)5000 })
+        {
+            std::string out;
+            REQUIRE(inflate(stream.data, stream.len, 12, step, out) == Inflater::Ok);
+            REQUIRE(out == stream.expected);
+        }
+    }
+
+    // Back references close to the window size, which wraps many times
+    std::string out;
+    REQUIRE(inflate(zlibFar, sizeof(zlibFar), 13, 64, out) == Inflater::Ok);
+    REQUIRE(out == far());
+}
+
+TEST_CASE("Inflater rejects what does not fit or does not decode", "[core][Inflater]")
+{
+    std::string out;
+    // zlib header announcing a 32KB window
+    REQUIRE(inflate(zlibWide, sizeof(zlibWide), 12, 100, out) == Inflater::BadHeader);
+    REQUIRE(inflate(zlibWide, sizeof(zlibWide), 15, 100, out) == Inflater::Ok);
+
+    // Header of a 8KB window with the copy 6000 bytes back, forged to 4KB
+    uint8_t forged[sizeof(zlibFar)];
+    memcpy(forged, zlibFar, sizeof(forged));
+    forged[0] = 0x48;
+    forged[1] = 31 - ((forged[0] << 8) % 31);
+    out.clear();
+    REQUIRE(inflate(forged, sizeof(forged), 12, 100, out) == Inflater::TooFar);
+
+    out.clear();
+    REQUIRE(inflate(zlibText, sizeof(zlibText) - 10, 12, 100, out) == Inflater::Truncated);
+
+    const uint8_t notCompressed[] = { 0xe9, 0x04, 0x02, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+    REQUIRE(inflate(notCompressed, sizeof(notCompressed), 12, 100, out) == Inflater::BadHeader);
+
+    uint8_t corrupted[sizeof(zlibText)];
+    memcpy(corrupted, zlibText, sizeof(corrupted));
+    corrupted[2] |= 0x06;   // reserved block type
+    REQUIRE(inflate(corrupted, sizeof(corrupted), 12, 100, out) == Inflater::BadData);
+
+    Inflater inflater;
+    size_t received = 0;
+    REQUIRE(inflater.begin(12, [&](const uint8_t*, size_t len) {
+        received += len;
+        return received < 1000;
+    }));
+    // Shorter than a block header can be, decoded by finish()
+    REQUIRE(inflater.write(zlibText, sizeof(zlibText)) == sizeof(zlibText));
+    REQUIRE(!inflater.finish());
+    REQUIRE(inflater.error() == Inflater::SinkFailed);
+}
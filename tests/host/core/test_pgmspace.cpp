@@ -53,3 +53,58 @@ TEST_CASE("strstr_P works as strstr", "[core][pgmspace]")
     t("_foo_foo", "foo");
     t("A", "a");
 }
+
+TEST_CASE("memcpy_P_bulk works as memcpy", "[core][pgmspace]")
+{
+    alignas(4) static const char src[] PROGMEM = "The quick brown fox jumps over the lazy dog 0123456789";
+    for (size_t srcOffset = 0; srcOffset < 4; ++srcOffset) {
+        for (size_t dstOffset = 0; dstOffset < 4; ++dstOffset) {
+            for (size_t n = 0; n + srcOffset < sizeof(src); ++n) {
+                alignas(4) char dst[sizeof(src) + 4];
+                memset(dst, '#', sizeof(dst));
+                REQUIRE(memcpy_P_bulk(dst + dstOffset, src + srcOffset, n) == (void*)(dst + dstOffset));
+                REQUIRE(memcmp(dst + dstOffset, src + srcOffset, n) == 0);
+                REQUIRE(dst[dstOffset + n] == '#');
+            }
+        }
+    }
+}
+
+TEST_CASE("strcmp_P_bulk works as strcmp", "[core][pgmspace]")
+{
+    alignas(4) static const char strings[] PROGMEM = "abcdefgh\0abcdefgi\0abc\0\0zz";
+    auto sign = [](int v) { return (v > 0) - (v < 0); };
+    const char* ram[] = { "", "a", "abc", "abcd", "abcdefgh", "abcdefgi", "abcdefghi", "b", "zz", "\xff" };
+    for (size_t offset = 0; offset < sizeof(strings); ++offset) {
+        for (const char* s : ram) {
+            REQUIRE(sign(strcmp_P_bulk(s, strings + offset)) == sign(strcmp(s, strings + offset)));
+        }
+    }
+}
+
+namespace {
+struct Glyph {
+    PGM_P name;
+    uint16_t code;
+};
+static const char g0[] PROGMEM = "alpha";
+static const char g1[] PROGMEM = "beta";
+static const char g2[] PROGMEM = "delta";
+static const char g3[] PROGMEM = "epsilon";
+static const char g4[] PROGMEM = "gamma";
+static const Glyph glyphs[] PROGMEM = {
+    { g0, 0x3b1 }, { g1, 0x3b2 }, { g2, 0x3b4 }, { g3, 0x3b5 }, { g4, 0x3b3 },
+};
+}
+
+TEST_CASE("pgm_table_find does a binary search", "[core][pgmspace]")
+{
+    for (const Glyph& glyph : glyphs) {
+        REQUIRE(pgm_table_find(glyph.name, glyphs) == &glyph);
+    }
+    REQUIRE(pgm_table_find("", glyphs) == nullptr);
+    REQUIRE(pgm_table_find("alph", glyphs) == nullptr);
+    REQUIRE(pgm_table_find("alphabet", glyphs) == nullptr);
+    REQUIRE(pgm_table_find("zeta", glyphs) == nullptr);
+    REQUIRE(pgm_table_find("gamma", glyphs)->code == 0x3b3);
+}
@@ -594,3 +594,118 @@ TEST_CASE("String chaining", "[core][String]")
     REQUIRE(static_cast<const void*>(result.c_str()) == static_cast<const void*>(ptr));
   }
 }
+
+TEST_CASE("Stream::send into a StreamString goes through its write buffer", "[core][StreamString]")
+{
+    const char* text = "direct copy between two buffered streams;and the rest";
+
+    StreamString src(text);
+    StreamString dst;
+    REQUIRE(dst.hasWriteBufferAPI());
+    REQUIRE(src.sendAll(dst) == strlen(text));
+    REQUIRE(dst == text);
+
+    StreamString src2(text);
+    StreamString until;
+    REQUIRE(src2.sendUntil(until, ';') == strlen("direct copy between two buffered streams"));
+    REQUIRE(until == "direct copy between two buffered streams");
+    REQUIRE(src2.sendSize(until, 3) == 3);
+    REQUIRE(until == "direct copy between two buffered streamsand");
+}
+
+TEST_CASE("Print::printf formats straight into a StreamString", "[core][StreamString]")
+{
+    StreamString s;
+    s.print("x=");
+    REQUIRE(s.printf("%d-%s", 42, "ok") == 5);
+    REQUIRE(s == "x=42-ok");
+
+    String longer;
+    for (int i = 0; i < 30; i++)
+        longer += "0123456789";
+    REQUIRE(s.printf("<%s>", longer.c_str()) == longer.length() + 2);
+    REQUIRE(s == String("x=42-ok<") + longer + ">");
+    REQUIRE(s.printf_P(PSTR("%05d"), 7) == 5);
+    REQUIRE(s.endsWith("00007"));
+}
+
+TEST_CASE("String concatenation chains and in place numbers", "[core][String]")
+{
+    String a = "alpha", b = "beta-beta-beta";
+    String r = a + ", " + b + '!' + 42 + F(" flash ") + 123456789UL + " " + (-7LL) + String("x");
+    REQUIRE(r == "alpha, beta-beta-beta!42 flash 123456789 -7x");
+
+    String s;
+    s.reserve(64);
+    s += "n=";
+    s += 1234;
+    s += ' ';
+    s += -5;
+    s += ' ';
+    s += (unsigned char)200;
+    s += ' ';
+    s += 18446744073709551615ULL;
+    s += ' ';
+    s += (-9223372036854775807LL - 1);
+    REQUIRE(s == "n=1234 -5 200 18446744073709551615 -9223372036854775808");
+
+    String big;
+    for (int i = 0; i < 100; i++)
+        big = std::move(big) + "0123456789" + i;
+    REQUIRE(big.length() == 100 * 10 + 10 + 90 * 2);
+    REQUIRE(big.endsWith("012345678999"));
+}
+
+TEST_CASE("Numbers through the integer formatter", "[core][String][Print]")
+{
+    REQUIRE(String(4294967295UL) == "4294967295");
+    REQUIRE(String((long)-2147483647 - 1) == "-2147483648");
+    REQUIRE(String(0UL) == "0");
+    REQUIRE(String(1.0 / 3, 6) == "0.333333");
+    REQUIRE(String(0.999, 2) == "1.00");
+    REQUIRE(String(-0.001, 2) == "-0.00");
+    REQUIRE(String(123456789.125, 3) == "123456789.125");
+    REQUIRE(String(1e15 + 0.25, 2) == "1000000000000000.25");
+    REQUIRE(String(0.05, 9) == "0.050000000");
+
+    char buf[16];
+    REQUIRE(String(dtostrf(-1.5, 8, 2, buf)) == "   -1.50");
+
+    StreamString s;
+    s.print(255, HEX);
+    s.print(' ');
+    s.print(5, BIN);
+    s.print(' ');
+    s.print(511, OCT);
+    s.print(' ');
+    s.print(100, 3);
+    s.print(' ');
+    s.print(-12345678901LL);
+    s.print(' ');
+    s.print(3.14159, 4);
+    s.print(' ');
+    s.print(2.5, 0);
+    REQUIRE(s == "FF 101 777 10201 -12345678901 3.1416 3");
+}
+
+TEST_CASE("StringView", "[core][StringView]")
+{
+    String s = "Content-Length: 1234";
+    StringView v(s);
+    int colon = v.indexOf(':');
+    REQUIRE(colon == 14);
+    REQUIRE(v.substring(0, colon).equalsIgnoreCase(F("CONTENT-length")));
+    REQUIRE(v.substring(colon + 1).toInt() == 1234);
+    REQUIRE(v.startsWith("Content"));
+    REQUIRE(!v.startsWith(F("content")));
+    REQUIRE(v.endsWith("234"));
+    REQUIRE(v.indexOf("Length") == 8);
+    REQUIRE(v == s);
+    REQUIRE(StringView(F("abc")) == "abc");
+    REQUIRE(v.substring(8, 14).toString() == "Length");
+    REQUIRE(v.substring(30).isEmpty());
+    REQUIRE(StringView("-42x").toInt() == -42);
+    REQUIRE(StringView(" +7").toInt() == 7);
+    REQUIRE(StringView("x").toInt() == 0);
+    REQUIRE(StringView(F("flash string over thirty two characters long")).substring(6).toString() == "string over thirty two characters long");
+}
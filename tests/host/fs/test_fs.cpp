@@ -16,6 +16,7 @@
 #include <catch.hpp>
 #include <map>
 #include <FS.h>
+#include <StreamString.h>
 #include "../common/spiffs_mock.h"
 #include "../common/littlefs_mock.h"
 #include "../common/sdfs_mock.h"
@@ -23,6 +24,8 @@
 #include <LittleFS.h>
 #include "../../../libraries/SDFS/src/SDFS.h"
 #include "../../../libraries/SD/src/SD.h"
+#include "../../../libraries/RecordLog/src/RecordLog.h"
+#include "../../../libraries/AssetFS/src/AssetFS.h"
 
 
 namespace spiffs_test {
@@ -57,6 +60,57 @@ TEST_CASE("SPIFFS checks the config object passed in", "[fs]")
     REQUIRE_FALSE(SPIFFS.setConfig(d));
     REQUIRE_FALSE(LittleFS.setConfig(l));
 }
+
+TEST_CASE("SPIFFS mounts from a snapshot until the next write", "[fs]")
+{
+    SPIFFS_MOCK_DECLARE(64, 8, 512, "");
+    uint8_t* snapshot = s_phys_data + s_phys_size - FLASH_SECTOR_SIZE;
+    const size_t validAt = 36;  // offset of the word a write clears
+    uint32_t magic, valid;
+    REQUIRE(SPIFFS.setConfig(SPIFFSConfig().setMountSnapshot().setCachePages(8)));
+    REQUIRE(SPIFFS.format());
+    REQUIRE(SPIFFS.begin());
+    createFile("/snap", "some content");
+    FSInfo written;
+    REQUIRE(SPIFFS.info(written));
+    REQUIRE(written.totalBytes < s_phys_size);
+    SPIFFS.end();
+    memcpy(&magic, snapshot, sizeof(magic));
+    memcpy(&valid, snapshot + validAt, sizeof(valid));
+    REQUIRE(magic == 0x53504d53);
+    REQUIRE(valid == 0xffffffff);
+
+    SPIFFS_MOCK_RESET();
+    REQUIRE(SPIFFS.setConfig(SPIFFSConfig().setMountSnapshot()));
+    REQUIRE(SPIFFS.begin());
+    FSInfo mounted;
+    REQUIRE(SPIFFS.info(mounted));
+    REQUIRE(mounted.usedBytes == written.usedBytes);
+    REQUIRE(readFile("/snap") == "some content");
+    memcpy(&valid, snapshot + validAt, sizeof(valid));
+    REQUIRE(valid == 0xffffffff);
+    createFile("/snap2", "more");
+    memcpy(&valid, snapshot + validAt, sizeof(valid));
+    REQUIRE(valid == 0);
+    SPIFFS.end();
+    memcpy(&valid, snapshot + validAt, sizeof(valid));
+    REQUIRE(valid == 0xffffffff);
+
+    // a full scan finds the counters the snapshot kept
+    SPIFFS_MOCK_RESET();
+    REQUIRE(SPIFFS.setConfig(SPIFFSConfig().setMountSnapshot()));
+    REQUIRE(SPIFFS.begin());
+    REQUIRE(SPIFFS.info(mounted));
+    SPIFFS.end();
+    memset(snapshot + validAt, 0, sizeof(valid));
+    SPIFFS_MOCK_RESET();
+    REQUIRE(SPIFFS.setConfig(SPIFFSConfig().setMountSnapshot()));
+    REQUIRE(SPIFFS.begin());
+    FSInfo scanned;
+    REQUIRE(SPIFFS.info(scanned));
+    REQUIRE(scanned.usedBytes == mounted.usedBytes);
+    REQUIRE(readFile("/snap2") == "more");
+}
 #pragma GCC diagnostic pop
 
 };
@@ -91,6 +145,80 @@ TEST_CASE("LittleFS checks the config object passed in", "[fs]")
     REQUIRE_FALSE(LittleFS.setConfig(s));
     REQUIRE_FALSE(LittleFS.setConfig(d));
     REQUIRE(LittleFS.setConfig(l));
+
+    REQUIRE_FALSE(LittleFS.setConfig(LittleFSConfig().setCacheSize(96)));      // not a multiple of readSize
+    REQUIRE_FALSE(LittleFS.setConfig(LittleFSConfig().setLookaheadSize(12)));  // not a multiple of 8
+    REQUIRE_FALSE(LittleFS.setConfig(LittleFSConfig().setBlockCache(4, 300))); // not a power of two
+    REQUIRE(LittleFS.setConfig(LittleFSConfig().setReadSize(16).setProgSize(16).setCacheSize(128).setBlockCache(4)));
+}
+
+TEST_CASE("LittleFS reads through the shared block cache match what was written", "[fs]")
+{
+    LITTLEFS_MOCK_DECLARE(64, 8, 512, "");
+    REQUIRE(LittleFS.setConfig(LittleFSConfig().setCacheSize(128).setBlockCache(4, 256)));
+    REQUIRE(LittleFS.begin());
+
+    File files[3];
+    for (int i = 0; i < 3; i++) {
+        files[i] = LittleFS.open(String("/log") + i, "w");
+        REQUIRE(files[i]);
+    }
+    for (int record = 0; record < 200; record++) {
+        for (int i = 0; i < 3; i++) {
+            files[i].printf("%d:%d\n", i, record);
+        }
+    }
+    for (int i = 0; i < 3; i++) {
+        files[i].close();
+    }
+    LittleFS.end();
+
+    REQUIRE(LittleFS.begin());
+    for (int i = 0; i < 3; i++) {
+        File f = LittleFS.open(String("/log") + i, "r");
+        REQUIRE(f);
+        for (int record = 0; record < 200; record++) {
+            REQUIRE(f.readStringUntil('\n') == String(i) + ':' + record);
+        }
+    }
+}
+
+static String listDir(const char* path)
+{
+    String ret;
+    Dir d = LittleFS.openDir(path);
+    while (d.next()) {
+        ret += d.fileName() + ":" + d.fileSize() + " ";
+    }
+    return ret;
+}
+
+TEST_CASE("LittleFS directory cache follows changes", "[fs]")
+{
+    LITTLEFS_MOCK_DECLARE(64, 8, 512, "");
+    REQUIRE(LittleFS.begin());
+    REQUIRE(LittleFS.setDirCache(16));
+    REQUIRE(LittleFS.mkdir("/d"));
+    LittleFS.open("/d/a", "w").print("1");
+    LittleFS.open("/d/b", "w").print("22");
+
+    REQUIRE(listDir("/d") == "a:1 b:2 ");
+    REQUIRE(listDir("/d") == "a:1 b:2 "); // from the cache
+    Dir d = LittleFS.openDir("/d");
+    REQUIRE(d.next());
+    REQUIRE(d.openFile("r").readString() == "1");
+
+    File f = LittleFS.open("/d/b", "a");
+    f.print("333");
+    f.close();
+    REQUIRE(listDir("/d") == "a:1 b:5 ");
+    REQUIRE(LittleFS.rename("/d/a", "/d/c"));
+    REQUIRE(listDir("/d") == "b:5 c:1 ");
+    REQUIRE(LittleFS.remove("/d/b"));
+    REQUIRE(listDir("/d") == "c:1 ");
+
+    REQUIRE(LittleFS.setDirCache(0));
+    REQUIRE(listDir("/d") == "c:1 ");
 }
 
 };
@@ -163,3 +291,179 @@ TEST_CASE("SD.h FILE_WRITE macro is append", "[fs]")
 }
 
 };
+
+namespace recordlog_test {
+
+TEST_CASE("RecordLog survives restarts and wraps around", "[fs]")
+{
+    LITTLEFS_MOCK_DECLARE(16, 4, 256, "");
+    char rec[100];
+    {
+        RecordLog log(0, 16 * 1024, 256);
+        REQUIRE(log.begin());
+        REQUIRE(log.read(rec, sizeof(rec)) == -1);
+        REQUIRE_FALSE(log.append(rec, 0));
+        REQUIRE_FALSE(log.append(rec, log.maxRecordSize() + 1));
+        for (int i = 0; i < 10; i++) {
+            int n = snprintf(rec, sizeof(rec), "record %d", i);
+            REQUIRE(log.append(rec, n));
+        }
+        REQUIRE(log.pending() > 0);
+        log.end();
+    }
+    RecordLog log(0, 16 * 1024, 256);
+    REQUIRE(log.begin());
+    for (int i = 0; i < 10; i++) {
+        char exp[100];
+        snprintf(exp, sizeof(exp), "record %d", i);
+        int n = log.read(rec, sizeof(rec));
+        REQUIRE(n == (int)strlen(exp));
+        REQUIRE(memcmp(rec, exp, n) == 0);
+    }
+    REQUIRE(log.read(rec, sizeof(rec)) == -1);
+
+    // Fill well past the 4 sectors, only the newest records remain
+    for (int i = 10; i < 1000; i++) {
+        int n = snprintf(rec, sizeof(rec), "record %d", i);
+        REQUIRE(log.append(rec, n));
+    }
+    REQUIRE(log.rewind());
+    int first = -1, last = -1, count = 0;
+    int n;
+    while ((n = log.read(rec, sizeof(rec) - 1)) > 0) {
+        rec[n] = 0;
+        int v = atoi(rec + 7);
+        if (first < 0) {
+            first = v;
+        } else {
+            REQUIRE(v == last + 1);
+        }
+        last = v;
+        count++;
+    }
+    REQUIRE(first > 10);
+    REQUIRE(last == 999);
+    REQUIRE(count > 200);
+    log.end();
+
+    REQUIRE(log.begin());
+    int again = 0;
+    while (log.read(rec, sizeof(rec)) > 0) {
+        again++;
+    }
+    REQUIRE(again == count);
+    REQUIRE(log.clear());
+    REQUIRE(log.read(rec, sizeof(rec)) == -1);
+    log.end();
+    REQUIRE(log.begin());
+    REQUIRE(log.read(rec, sizeof(rec)) == -1);
+}
+
+TEST_CASE("RecordLog skips corrupted and torn records", "[fs]")
+{
+    LITTLEFS_MOCK_DECLARE(16, 4, 256, "");
+    char rec[16];
+    {
+        RecordLog log(0, 16 * 1024, 256);
+        REQUIRE(log.begin());
+        REQUIRE(log.append("aaaa", 4));
+        REQUIRE(log.append("bbbb", 4));
+        REQUIRE(log.append("cccc", 4));
+        log.end();
+    }
+    // Flip a payload byte of the second record, and tear the header of a
+    // fourth one as a power loss would
+    s_phys_data[12 + 12 + 8] = 'x';
+    s_phys_data[12 + 36] = 4;
+    RecordLog log(0, 16 * 1024, 256);
+    REQUIRE(log.begin());
+    REQUIRE(log.read(rec, sizeof(rec)) == 4);
+    REQUIRE(memcmp(rec, "aaaa", 4) == 0);
+    REQUIRE(log.read(rec, sizeof(rec)) == 4);
+    REQUIRE(memcmp(rec, "cccc", 4) == 0);
+    REQUIRE(log.read(rec, sizeof(rec)) == -1);
+    // New records go to a fresh sector rather than behind the torn header
+    REQUIRE(log.append("dddd", 4));
+    REQUIRE(log.rewind());
+    REQUIRE(log.read(rec, sizeof(rec)) == 4);
+    REQUIRE(log.read(rec, sizeof(rec)) == 4);
+    REQUIRE(log.read(rec, sizeof(rec)) == 4);
+    REQUIRE(memcmp(rec, "dddd", 4) == 0);
+    REQUIRE(log.rewind());
+    memset(rec, 0, sizeof(rec));
+    REQUIRE(log.read(rec, 2) == 4);
+    REQUIRE(rec[1] == 'a');
+    REQUIRE(rec[2] == 0);
+}
+
+};
+
+namespace assetfs_test {
+
+// tools/mkassets.py of /index.html "<h1>hi</h1>", /css.txt "abc",
+// /css/site.css "body{}" and /css/x/deep.txt "deep"
+static const uint8_t image[] PROGMEM __attribute__((aligned(4))) = {
+    0x41, 0x46, 0x53, 0x31, 0x04, 0x00, 0x00, 0x00, 0xa0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x50, 0x00, 0x00, 0x00, 0x84, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 0x00, 0xf1, 0x53, 0x65,
+    0x59, 0x00, 0x00, 0x00, 0x88, 0x00, 0x00, 0x00, 0x06, 0x00, 0x00, 0x00, 0x00, 0xf1, 0x53, 0x65,
+    0x67, 0x00, 0x00, 0x00, 0x90, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0x00, 0xf1, 0x53, 0x65,
+    0x77, 0x00, 0x00, 0x00, 0x94, 0x00, 0x00, 0x00, 0x0b, 0x00, 0x00, 0x00, 0x00, 0xf1, 0x53, 0x65,
+    0x2f, 0x63, 0x73, 0x73, 0x2e, 0x74, 0x78, 0x74, 0x00, 0x2f, 0x63, 0x73, 0x73, 0x2f, 0x73, 0x69,
+    0x74, 0x65, 0x2e, 0x63, 0x73, 0x73, 0x00, 0x2f, 0x63, 0x73, 0x73, 0x2f, 0x78, 0x2f, 0x64, 0x65,
+    0x65, 0x70, 0x2e, 0x74, 0x78, 0x74, 0x00, 0x2f, 0x69, 0x6e, 0x64, 0x65, 0x78, 0x2e, 0x68, 0x74,
+    0x6d, 0x6c, 0x00, 0x00, 0x61, 0x62, 0x63, 0x00, 0x62, 0x6f, 0x64, 0x79, 0x7b, 0x7d, 0x00, 0x00,
+    0x64, 0x65, 0x65, 0x70, 0x3c, 0x68, 0x31, 0x3e, 0x68, 0x69, 0x3c, 0x2f, 0x68, 0x31, 0x3e, 0x00,
+};
+
+TEST_CASE("AssetFS reads files and directories from an image", "[fs]")
+{
+    REQUIRE_FALSE(AssetFS.begin());
+    REQUIRE(AssetFS.setConfig(AssetFSConfig(image)));
+    REQUIRE(AssetFS.begin());
+
+    File f = AssetFS.open("/index.html", "r");
+    REQUIRE(f);
+    REQUIRE(f.size() == 11);
+    REQUIRE(f.getLastWrite() == 1700000000);
+    REQUIRE(f.readString() == "<h1>hi</h1>");
+    REQUIRE(f.seek(4, SeekSet));
+    REQUIRE(f.read() == 'h');
+    REQUIRE(f.write('x') == 0);
+    REQUIRE(String(f.name()) == "index.html");
+    f.close();
+    REQUIRE_FALSE(AssetFS.open("/index.html", "w"));
+    REQUIRE_FALSE(AssetFS.open("/missing", "r"));
+    REQUIRE_FALSE(AssetFS.remove("/index.html"));
+
+    REQUIRE(AssetFS.exists("/css.txt"));
+    REQUIRE(AssetFS.exists("css/site.css"));
+    REQUIRE(AssetFS.exists("/css"));
+    REQUIRE(AssetFS.exists("/css/x/"));
+    REQUIRE_FALSE(AssetFS.exists("/cs"));
+    REQUIRE(AssetFS.open("/css", "r").isDirectory());
+
+    Dir root = AssetFS.openDir("/");
+    String names;
+    while (root.next()) {
+        names += root.fileName();
+        names += root.isDirectory() ? "/ " : " ";
+    }
+    REQUIRE(names == "css.txt css/ index.html ");
+    Dir css = AssetFS.openDir("/css");
+    REQUIRE(css.next());
+    REQUIRE(css.fileName() == "site.css");
+    REQUIRE(css.fileSize() == 6);
+    REQUIRE(css.openFile("r").readString() == "body{}");
+    REQUIRE(css.next());
+    REQUIRE(css.fileName() == "x");
+    REQUIRE(css.isDirectory());
+    REQUIRE_FALSE(css.next());
+
+    FSInfo info;
+    REQUIRE(AssetFS.info(info));
+    REQUIRE(info.totalBytes == sizeof(image));
+    AssetFS.end();
+    REQUIRE_FALSE(AssetFS.exists("/css.txt"));
+}
+
+};
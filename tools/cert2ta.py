@@ -0,0 +1,195 @@
+#!/usr/bin/env python3
+
+# Turns X.509 certificates (and public keys) into BearSSL trust anchors
+# (and keys) as C tables, like "brssl ta" does, to be compiled in the sketch
+# instead of being parsed by X509List/PublicKey at every boot:
+#
+#   python3 cert2ta.py -n trusted ca.pem other.der > trusted.h
+#
+#   #include "trusted.h"
+#   BearSSL::X509List trusted(trusted_TA, trusted_TA_NUM);
+#
+# Tables go to PROGMEM (-r: RAM, used in place without any copy).
+# Only Python's standard library is needed.
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+import argparse
+import base64
+import re
+import sys
+
+OID_RSA = '1.2.840.113549.1.1.1'
+OID_EC = '1.2.840.10045.2.1'
+OID_BASIC_CONSTRAINTS = '2.5.29.19'
+# BR_EC_* curve identifiers
+CURVES = {
+    '1.2.840.10045.3.1.7': 23,  # secp256r1
+    '1.3.132.0.34': 24,         # secp384r1
+    '1.3.132.0.35': 25,         # secp521r1
+}
+
+
+def der_read(data, pos=0):
+    """Returns (tag, content start, content end) of the element at pos"""
+    tag = data[pos]
+    length = data[pos + 1]
+    pos += 2
+    if length & 0x80:
+        n = length & 0x7f
+        length = int.from_bytes(data[pos:pos + n], 'big')
+        pos += n
+    return tag, pos, pos + length
+
+
+def der_children(data, start, end):
+    """(tag, element start, content start, content end) for each child"""
+    children = []
+    while start < end:
+        tag, cstart, cend = der_read(data, start)
+        children.append((tag, start, cstart, cend))
+        start = cend
+    return children
+
+
+def oid_str(raw):
+    first = raw[0]
+    parts = [first // 40, first % 40]
+    value = 0
+    for b in raw[1:]:
+        value = (value << 7) | (b & 0x7f)
+        if not b & 0x80:
+            parts.append(value)
+            value = 0
+    return '.'.join(str(p) for p in parts)
+
+
+def parse_spki(data, start, end):
+    """SubjectPublicKeyInfo -> ('rsa', n, e) or ('ec', curve, q)"""
+    alg, key = der_children(data, start, end)[:2]
+    alg_children = der_children(data, alg[2], alg[3])
+    oid = oid_str(data[alg_children[0][2]:alg_children[0][3]])
+    # BIT STRING: skip the unused bits count
+    bits = data[key[2] + 1:key[3]]
+    if oid == OID_RSA:
+        seq = der_children(bits, *der_read(bits)[1:])
+        n = bits[seq[0][2]:seq[0][3]].lstrip(b'\0')
+        e = bits[seq[1][2]:seq[1][3]].lstrip(b'\0')
+        return ('rsa', n, e)
+    if oid == OID_EC:
+        curve = oid_str(data[alg_children[1][2]:alg_children[1][3]])
+        if curve not in CURVES:
+            raise ValueError('unsupported curve ' + curve)
+        return ('ec', CURVES[curve], bits)
+    raise ValueError('unsupported key type ' + oid)
+
+
+def parse_certificate(data):
+    """-> (subject DN DER, is CA, key)"""
+    cert = der_children(data, *der_read(data)[1:])
+    tbs = der_children(data, cert[0][2], cert[0][3])
+    if tbs[0][0] == 0xa0:  # [0] version
+        tbs = tbs[1:]
+    # serial, signature, issuer, validity, subject, subjectPublicKeyInfo
+    subject = tbs[4]
+    dn = data[subject[1]:subject[3]]
+    key = parse_spki(data, tbs[5][2], tbs[5][3])
+    is_ca = False
+    for ext in tbs[6:]:
+        if ext[0] != 0xa3:  # [3] extensions
+            continue
+        for e in der_children(data, *der_read(data, ext[2])[1:]):
+            fields = der_children(data, e[2], e[3])
+            if oid_str(data[fields[0][2]:fields[0][3]]) != OID_BASIC_CONSTRAINTS:
+                continue
+            value = fields[-1]
+            bc = der_children(data, *der_read(data, value[2])[1:])
+            is_ca = bool(bc) and bc[0][0] == 0x01 and data[bc[0][2]] != 0
+    return dn, is_ca, key
+
+
+def load(path, kind):
+    """DER blobs of that PEM kind (CERTIFICATE, PUBLIC KEY) in a file"""
+    with open(path, 'rb') as f:
+        raw = f.read()
+    pems = re.findall(rb'-----BEGIN ' + kind + rb'-----(.*?)-----END ' + kind + rb'-----', raw, re.S)
+    if pems:
+        return [base64.b64decode(b''.join(p.split())) for p in pems]
+    return [raw]
+
+
+def c_array(name, data, progmem):
+    lines = []
+    for i in range(0, len(data), 12):
+        lines.append('    ' + ', '.join('0x%02x' % b for b in data[i:i + 12]) + ',')
+    return 'static const unsigned char %s[]%s = {\n%s\n};\n' % (name, progmem, '\n'.join(lines))
+
+
+def c_pkey(prefix, key, progmem, out):
+    """Writes the key's arrays, returns its br_x509_pkey initializer"""
+    if key[0] == 'rsa':
+        out.append(c_array(prefix + '_N', key[1], progmem))
+        out.append(c_array(prefix + '_E', key[2], progmem))
+        return ('{ BR_KEYTYPE_RSA, { .rsa = { (unsigned char *)%s_N, sizeof %s_N, (unsigned char *)%s_E, sizeof %s_E } } }'
+                % (prefix, prefix, prefix, prefix))
+    out.append(c_array(prefix + '_Q', key[2], progmem))
+    return ('{ BR_KEYTYPE_EC, { .ec = { %d, (unsigned char *)%s_Q, sizeof %s_Q } } }'
+            % (key[1], prefix, prefix))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Certificates to BearSSL trust anchor tables')
+    parser.add_argument('-n', '--name', default='precompiled', help='C name prefix')
+    parser.add_argument('-k', '--pubkey', action='append', default=[], help='public key file (PEM or DER), may repeat')
+    parser.add_argument('-r', '--ram', action='store_true', help='tables in RAM instead of PROGMEM')
+    parser.add_argument('-o', '--out', help='output header, default stdout')
+    parser.add_argument('certs', nargs='*', help='certificate files (PEM, may hold several, or DER)')
+    args = parser.parse_args()
+
+    progmem = '' if args.ram else ' PROGMEM'
+    out = ['// Generated by cert2ta.py, do not edit\n',
+           '#pragma once\n#include <pgmspace.h>\n#include <bearssl/bearssl_x509.h>\n']
+
+    anchors = []
+    for path in args.certs:
+        for der in load(path, b'CERTIFICATE'):
+            i = len(anchors)
+            dn, is_ca, key = parse_certificate(der)
+            out.append('// %s\n' % path)
+            out.append(c_array('%s_TA%d_DN' % (args.name, i), dn, progmem))
+            pkey = c_pkey('%s_TA%d' % (args.name, i), key, progmem, out)
+            anchors.append('    { { (unsigned char *)%s_TA%d_DN, sizeof %s_TA%d_DN }, %s,\n      %s },'
+                           % (args.name, i, args.name, i, 'BR_X509_TA_CA' if is_ca else '0', pkey))
+    if anchors:
+        out.append('static const br_x509_trust_anchor %s_TA[]%s = {\n%s\n};\n' % (args.name, progmem, '\n'.join(anchors)))
+        out.append('#define %s_TA_NUM %d\n' % (args.name, len(anchors)))
+
+    for i, path in enumerate(args.pubkey):
+        der = load(path, b'PUBLIC KEY')[0]
+        key = parse_spki(der, *der_read(der)[1:])
+        out.append('// %s\n' % path)
+        pkey = c_pkey('%s_KEY%d' % (args.name, i), key, progmem, out)
+        out.append('static const br_x509_pkey %s_KEY%d%s = %s;\n' % (args.name, i, progmem, pkey))
+
+    text = '\n'.join(out)
+    if args.out:
+        with open(args.out, 'w') as f:
+            f.write(text)
+    else:
+        sys.stdout.write(text)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
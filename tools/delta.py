@@ -0,0 +1,116 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+#
+# Create a delta patch for OTA updates (see doc/ota_updates/readme.rst).
+# The patch rebuilds the new binary from the sketch that is currently
+# running on the device, using COPY ops for data that is already in its
+# flash and DATA ops for everything else.
+
+import argparse
+import hashlib
+import struct
+import sys
+
+MAGIC = b'\xd7ESD'
+OP_COPY = 0x01
+OP_DATA = 0x02
+APP_START_OFFSET = 0x1000
+BLOCK = 16          # bytes hashed to find candidate matches
+MIN_COPY = 24       # shorter matches cost more than they save
+
+def parse_args():
+    parser = argparse.ArgumentParser(description='OTA delta patch tool')
+    parser.add_argument('-s', '--source', required=True, help='Binary currently running on the device')
+    parser.add_argument('-t', '--target', required=True, help='New binary, signed if signing is used')
+    parser.add_argument('-o', '--out', required=True, help='Output patch file')
+    return parser.parse_args()
+
+def sketch_size(data):
+    """Size of the image as ESP.getSketchSize() computes it on the device."""
+    pos = APP_START_OFFSET
+    segments = data[pos + 1]
+    pos += 8
+    for _ in range(segments):
+        _, size = struct.unpack('<II', data[pos:pos + 8])
+        pos += 8 + size
+    return (pos + 16) & ~15
+
+def source_md5(source):
+    # The flash mode and size bytes may differ in flash, the device skips them
+    data = bytearray(source)
+    data[2] = 0
+    data[3] = 0
+    return hashlib.md5(data).digest()
+
+def make_patch(source, target):
+    index = {}
+    for i in range(len(source) - BLOCK, -1, -1):
+        index[source[i:i + BLOCK]] = i
+
+    ops = []
+    literal = bytearray()
+    pos = 0
+    # The image header always comes from the target, see source_md5()
+    while pos < len(target):
+        match = None
+        if pos >= 4:
+            cand = index.get(target[pos:pos + BLOCK])
+            if cand is not None:
+                length = 0
+                while (pos + length < len(target) and cand + length < len(source)
+                       and target[pos + length] == source[cand + length]):
+                    length += 1
+                if length >= MIN_COPY:
+                    match = (cand, length)
+        if match:
+            if literal:
+                ops.append(struct.pack('<BI', OP_DATA, len(literal)) + bytes(literal))
+                literal = bytearray()
+            ops.append(struct.pack('<BII', OP_COPY, match[0], match[1]))
+            pos += match[1]
+        else:
+            literal.append(target[pos])
+            pos += 1
+    if literal:
+        ops.append(struct.pack('<BI', OP_DATA, len(literal)) + bytes(literal))
+
+    header = MAGIC + struct.pack('<II', len(target), len(source)) + source_md5(source)
+    return header + b''.join(ops)
+
+def apply_patch(source, patch):
+    out = bytearray()
+    target_size, _ = struct.unpack('<II', patch[4:12])
+    pos = 28
+    while pos < len(patch):
+        op = patch[pos]
+        if op == OP_COPY:
+            src, length = struct.unpack('<II', patch[pos + 1:pos + 9])
+            out += source[src:src + length]
+            pos += 9
+        else:
+            length, = struct.unpack('<I', patch[pos + 1:pos + 5])
+            out += patch[pos + 5:pos + 5 + length]
+            pos += 5 + length
+    assert len(out) == target_size
+    return bytes(out)
+
+def main():
+    args = parse_args()
+    with open(args.source, 'rb') as f:
+        source = f.read()
+    with open(args.target, 'rb') as f:
+        target = f.read()
+    source = source[:sketch_size(source)]
+
+    patch = make_patch(source, target)
+    if apply_patch(source, patch) != target:
+        sys.stderr.write("Delta patch failed to verify\n")
+        return 1
+    with open(args.out, 'wb') as f:
+        f.write(patch)
+    sys.stderr.write("Delta patch: " + args.out + ", " + str(len(patch)) +
+                     " bytes for a " + str(len(target)) + " byte image\n")
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -27,6 +27,11 @@
 # 2016-01-03:
 # - Added more options to parser.
 #
+# Changes
+# 2026-10-14:
+# - Stream the image without per-chunk acknowledgements when the device supports it (-w to disable).
+# - Optionally send the image zlib compressed for the device to decompress while writing (-z).
+#
 
 from __future__ import print_function
 import socket
@@ -35,6 +40,8 @@ import os
 import optparse
 import logging
 import hashlib
+import io
+import zlib
 import random
 
 # Commands
@@ -42,6 +49,10 @@ FLASH = 0
 SPIFFS = 100
 AUTH = 200
 PROGRESS = False
+WINDOW = True
+COMPRESS = False
+# Window of the compressed image, the device allocates it
+COMPRESS_WINDOW_BITS = 12
 # update_progress() : Displays or updates a console progress bar
 ## Accepts a float between 0 and 1. Any int will be converted to a float.
 ## A value under 0 represents a 'halt'.
@@ -91,10 +102,21 @@ def serve(remoteAddr, localAddr, remotePort, localPort, password, filename, comm
   
   content_size = os.path.getsize(filename)
   f = open(filename,'rb')
-  file_md5 = hashlib.md5(f.read()).hexdigest()
+  content = f.read()
+  file_md5 = hashlib.md5(content).hexdigest()
   f.close()
   logging.info('Upload size: %d', content_size)
-  message = '%d %d %d %s\n' % (command, localPort, content_size, file_md5)
+  # The second line lists the transfer options, older devices ignore it
+  options = []
+  if WINDOW:
+    options.append('W')
+  compressed = None
+  if COMPRESS:
+    compressor = zlib.compressobj(9, zlib.DEFLATED, COMPRESS_WINDOW_BITS)
+    compressed = compressor.compress(content) + compressor.flush()
+    logging.info('Compressed size: %d', len(compressed))
+    options.append('Z%d:%d' % (COMPRESS_WINDOW_BITS, len(compressed)))
+  message = '%d %d %d %s\n%s\n' % (command, localPort, content_size, file_md5, ' '.join(options))
 
   # Wait for a connection
   logging.info('Sending invitation to: %s', remoteAddr)
@@ -108,7 +130,7 @@ def serve(remoteAddr, localAddr, remotePort, localPort, password, filename, comm
     logging.error('No Answer')
     sock2.close()
     return 1
-  if (data != "OK"):
+  if (data.split()[:1] != ["OK"]):
     if(data.startswith('AUTH')):
       nonce = data.split()[1]
       cnonce_text = '%s%u%s%s' % (filename, content_size, file_md5, remoteAddr)
@@ -128,7 +150,7 @@ def serve(remoteAddr, localAddr, remotePort, localPort, password, filename, comm
         logging.error('No Answer to our Authentication')
         sock2.close()
         return 1
-      if (data != "OK"):
+      if (data.split()[:1] != ["OK"]):
         sys.stderr.write('FAIL\n')
         logging.error('%s', data)
         sock2.close()
@@ -140,6 +162,12 @@ def serve(remoteAddr, localAddr, remotePort, localPort, password, filename, comm
       sock2.close()
       return 1
   sock2.close()
+  # The options the device took: with W it only sends the result at the
+  # end, with Z it decompresses the image
+  windowed = 'W' in data.split()
+  if 'Z' not in data.split():
+    compressed = None
+  logging.info('Transfer: %s%s', 'windowed' if windowed else 'stop-and-wait', ', compressed' if compressed else '')
 
   logging.info('Waiting for device...')
   try:
@@ -155,7 +183,11 @@ def serve(remoteAddr, localAddr, remotePort, localPort, password, filename, comm
   received_ok = False
 
   try:
-    f = open(filename, "rb")
+    if compressed:
+      f = io.BytesIO(compressed)
+      content_size = len(compressed)
+    else:
+      f = open(filename, "rb")
     if (PROGRESS):
       update_progress(0)
     else:
@@ -163,14 +195,14 @@ def serve(remoteAddr, localAddr, remotePort, localPort, password, filename, comm
       sys.stderr.flush()
     offset = 0
     while True:
-      chunk = f.read(1460)
+      chunk = f.read(8192 if windowed else 1460)
       if not chunk: break
       offset += len(chunk)
       update_progress(offset/float(content_size))
       connection.settimeout(10)
       try:
         connection.sendall(chunk)
-        if connection.recv(32).decode().find('O') >= 0:
+        if not windowed and connection.recv(32).decode().find('O') >= 0:
           # connection will receive only digits or 'OK'
           received_ok = True
       except Exception:
@@ -281,6 +313,18 @@ def parser(unparsed_args):
     help = "Use this option to transmit a SPIFFS image and do not flash the module.",
     default = False
   )
+  group.add_option("-z", "--compress",
+    dest = "compress",
+    help = "Send the image zlib compressed if the device can decompress it.",
+    action = "store_true",
+    default = False
+  )
+  group.add_option("-w", "--no-window",
+    dest = "no_window",
+    help = "Wait for the device to acknowledge each chunk, even if it can receive the image as a stream.",
+    action = "store_true",
+    default = False
+  )
   parser.add_option_group(group)
 
   # output group
@@ -323,6 +367,10 @@ def main(args):
   # check options
   global PROGRESS
   PROGRESS = options.progress
+  global WINDOW
+  WINDOW = not options.no_window
+  global COMPRESS
+  COMPRESS = options.compress
   if (not options.esp_ip or not options.image):
     logging.critical("Not enough arguments.")
 
@@ -0,0 +1,95 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+#
+# Build a read-only AssetFS image (libraries/AssetFS) from a directory.
+#
+# The image is written either as a C++ source defining a PROGMEM array, to
+# add to the sketch, or as a raw binary to place in flash by other means.
+# Files keep their path relative to the directory, with a leading '/'.
+#
+# Layout, all words little endian and every part 4 byte aligned:
+#   header   magic 'AFS1', file count, image size, 0
+#   entries  name offset, data offset, size, modification time, sorted by
+#            name (strcmp order) so lookups can bisect
+#   names    NUL terminated
+#   data
+
+import argparse
+import os
+import struct
+import sys
+
+MAGIC = 0x31534641  # 'AFS1'
+HEADER = 16
+ENTRY = 16
+
+def parse_args():
+    parser = argparse.ArgumentParser(description='AssetFS image builder')
+    parser.add_argument('-o', '--output', required=True,
+                        help='output file, C++ source when it ends in .cpp, raw image otherwise')
+    parser.add_argument('-n', '--name', default='assets_image',
+                        help='name of the array in the C++ source (default: assets_image)')
+    parser.add_argument('directory', help='directory holding the assets')
+    return parser.parse_args()
+
+def align(n):
+    return (n + 3) & ~3
+
+def collect(directory):
+    files = []
+    for root, dirs, names in os.walk(directory):
+        dirs.sort()
+        for name in names:
+            path = os.path.join(root, name)
+            rel = '/' + os.path.relpath(path, directory).replace(os.sep, '/')
+            files.append((rel.encode('utf-8'), path))
+    files.sort()
+    return files
+
+def build(files):
+    names = b''
+    name_offsets = []
+    for rel, _ in files:
+        name_offsets.append(len(names))
+        names += rel + b'\0'
+    names_at = HEADER + ENTRY * len(files)
+    data_at = align(names_at + len(names))
+    data = b''
+    entries = b''
+    for (rel, path), name_offset in zip(files, name_offsets):
+        with open(path, 'rb') as f:
+            content = f.read()
+        mtime = int(os.path.getmtime(path)) & 0xffffffff
+        entries += struct.pack('<IIII', names_at + name_offset, data_at + len(data), len(content), mtime)
+        data += content + b'\0' * (align(len(content)) - len(content))
+    size = data_at + len(data)
+    image = struct.pack('<IIII', MAGIC, len(files), size, 0) + entries + names
+    image += b'\0' * (data_at - len(image))
+    return image + data
+
+def write_cpp(out, name, image):
+    out.write('// AssetFS image generated by tools/mkassets.py, do not edit\n\n')
+    out.write('#include <Arduino.h>\n\n')
+    out.write('extern const uint8_t %s[] PROGMEM __attribute__((aligned(4)));\n' % name)
+    out.write('const uint8_t %s[] PROGMEM __attribute__((aligned(4))) = {\n' % name)
+    for i in range(0, len(image), 16):
+        out.write('    ' + ' '.join('0x%02x,' % b for b in image[i:i + 16]) + '\n')
+    out.write('};\n')
+
+def main():
+    args = parse_args()
+    if not os.path.isdir(args.directory):
+        print('%s: not a directory' % args.directory, file=sys.stderr)
+        return 1
+    image = build(collect(args.directory))
+    if args.output.endswith('.cpp'):
+        with open(args.output, 'w') as out:
+            write_cpp(out, args.name, image)
+    else:
+        with open(args.output, 'wb') as out:
+            out.write(image)
+    print('%s: %d bytes' % (args.output, len(image)))
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(main())
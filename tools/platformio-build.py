@@ -349,7 +349,7 @@ app_ld = env.Command(
     join("$BUILD_DIR", "ld", "local.eagle.app.v6.common.ld"),
     join(FRAMEWORK_DIR, "tools", "sdk", "ld", "eagle.app.v6.common.ld.h"),
     env.VerboseAction(
-        "$CC -CC -E -P -D%s %s %s $SOURCE -o $TARGET"
+        "$CC -CC -E -P -D%s %s %s -I$PROJECT_INCLUDE_DIR $SOURCE -o $TARGET"
         % (
             current_vtables,
             # String representation of MMU flags
@@ -0,0 +1,147 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+#
+# Resolve the output of Profiler.dump() (libraries/Profiler) to functions
+# of the sketch ELF and print where the samples landed.  A bucket that
+# covers the end of one function and the start of the next is credited
+# to the function containing its first address.
+#
+# With --iram-ld, the most sampled functions still running from flash are
+# also written to a linker fragment that places them in IRAM, as many as
+# the free IRAM allows.  Save it as iram_profile.ld.h in the sketch folder
+# and rebuild, the linker script includes it when it is there.  The samples
+# show where the time goes, not the cache misses themselves: a function
+# that runs often from the cache gains little, so use --min to skip those
+# with a small share.
+
+import argparse
+import bisect
+import subprocess
+import sys
+
+# start of the flash mapped code, below is IRAM
+FLASH_CODE = 0x40200000
+
+def parse_args():
+    parser = argparse.ArgumentParser(description='Profiler report')
+    parser.add_argument('-e', '--elf', required=True, help='Sketch ELF file')
+    parser.add_argument('-n', '--nm', default='xtensa-lx106-elf-nm', help='nm of the xtensa toolchain')
+    parser.add_argument('-t', '--top', type=int, default=25, help='Number of functions to print')
+    parser.add_argument('--iram-ld', help='Write an IRAM placement linker fragment to this file')
+    parser.add_argument('--size', default='xtensa-lx106-elf-size', help='size of the xtensa toolchain')
+    parser.add_argument('-i', '--mmu', default='', help='MMU build options, as for sizes.py')
+    parser.add_argument('--budget', type=int, help='IRAM bytes for the fragment, default the free IRAM minus --reserve')
+    parser.add_argument('--reserve', type=int, default=1024, help='IRAM bytes left free (default 1024)')
+    parser.add_argument('--min', type=float, default=0.5, help='Minimum share of samples in %% to move a function (default 0.5)')
+    parser.add_argument('profile', nargs='?', help='Profiler.dump() output, stdin if not given')
+    return parser.parse_args()
+
+def load_symbols(nm, elf, demangle=True):
+    out = subprocess.check_output([nm, '-n', '-S'] + (['-C'] if demangle else []) + ['--defined-only', elf],
+                                  universal_newlines=True)
+    symbols = []
+    for line in out.splitlines():
+        fields = line.split(None, 3)
+        if len(fields) < 4 or fields[2] not in 'tTwW':
+            continue
+        symbols.append((int(fields[0], 16), int(fields[1], 16), fields[3]))
+    symbols.sort()
+    return symbols
+
+def free_iram(size, elf, mmu):
+    # same accounting as sizes.py
+    iram = 0x8000
+    for flag in mmu.split():
+        if flag.startswith('-DMMU_IRAM_SIZE='):
+            iram = int(flag.split('=')[1], 16)
+    out = subprocess.check_output([size, '-A', elf], universal_newlines=True)
+    used = 0
+    for line in out.splitlines():
+        if line.startswith('.text'):  # .text and .text1
+            used += int(line.split()[1])
+    return iram - used
+
+def write_iram_ld(path, hot, samples, budget):
+    # hot: (count, size, mangled names, demangled name), most sampled first
+    lines, total = [], 0
+    for count, size, mangled, name in hot:
+        if total + size > budget:
+            continue
+        total += size
+        sections = ' '.join('.literal.%s .text.%s' % (m, m) for m in mangled)
+        lines.append('    *(%s)  /* %.2f%% %s */' % (sections, 100.0 * count / samples, name.replace('*/', '* /')))
+    with open(path, 'w') as f:
+        f.write('/* Generated by tools/profile.py --iram-ld: %d functions, %d bytes */\n' % (len(lines), total))
+        f.write('\n'.join(lines) + '\n')
+    print('%d functions, %d bytes of %d placed in IRAM by %s' % (len(lines), total, budget, path))
+
+def read_profile(stream):
+    shift, samples, rom, other, buckets = 0, 0, 0, 0, []
+    for line in stream:
+        fields = line.split()
+        if not fields or fields[0] == '#':
+            continue
+        if fields[0] == 'end':
+            break
+        if fields[0] == 'shift':
+            shift = int(fields[1])
+        elif fields[0] == 'samples':
+            samples, rom, other = int(fields[1]), int(fields[3]), int(fields[5])
+        else:
+            buckets.append((int(fields[0], 16), int(fields[1])))
+    return shift, samples, rom, other, buckets
+
+def main():
+    args = parse_args()
+    symbols = load_symbols(args.nm, args.elf)
+    starts = [s[0] for s in symbols]
+    if args.profile:
+        with open(args.profile) as f:
+            shift, samples, rom, other, buckets = read_profile(f)
+    else:
+        shift, samples, rom, other, buckets = read_profile(sys.stdin)
+
+    totals = {}
+    per_symbol = {}
+    for addr, count in buckets:
+        i = bisect.bisect_right(starts, addr) - 1
+        if i >= 0 and addr < symbols[i][0] + max(symbols[i][1], 1 << shift):
+            name = symbols[i][2]
+            per_symbol[i] = per_symbol.get(i, 0) + count
+        else:
+            name = '?? 0x%08x' % addr
+        totals[name] = totals.get(name, 0) + count
+    if rom:
+        totals['(ROM)'] = rom
+    if other:
+        totals['(other)'] = other
+
+    if not samples:
+        print('no samples')
+        return 0
+    print('%d samples, %d byte buckets' % (samples, 1 << shift))
+    ranked = sorted(totals.items(), key=lambda kv: kv[1], reverse=True)
+    for name, count in ranked[:args.top]:
+        print('%6.2f%% %8d  %s' % (100.0 * count / samples, count, name))
+
+    if args.iram_ld:
+        # -ffunction-sections names each section after the mangled symbol,
+        # aliases at the same address get a pattern each
+        mangled = {}
+        for addr, size, name in load_symbols(args.nm, args.elf, demangle=False):
+            mangled.setdefault(addr, []).append(name)
+        hot = []
+        for i, count in per_symbol.items():
+            addr, size, name = symbols[i]
+            if addr < FLASH_CODE or 100.0 * count / samples < args.min:
+                continue
+            hot.append((count, size, mangled[addr], name))
+        hot.sort(reverse=True)
+        budget = args.budget
+        if budget is None:
+            budget = max(free_iram(args.size, args.elf, args.mmu) - args.reserve, 0)
+        write_iram_ld(args.iram_ld, hot, samples, budget)
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -142,6 +142,11 @@ SECTIONS
 
     /* all functional callers are placed in IRAM (including SPI/IRQ callbacks/etc) here */
     *(.text._ZNKSt8functionIF*EE*)  /* std::function<any(...)>::operator()() const */
+
+    /* hot functions listed by tools/profile.py --iram-ld, from the sketch */
+#if __has_include("iram_profile.ld.h")
+#include "iram_profile.ld.h"
+#endif
   } >iram1_0_seg :iram1_0_phdr
 
   .irom0.text : ALIGN(4)
@@ -0,0 +1,140 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+#
+# Format the output of tracelog_dump() (cores/esp8266/core_esp8266_tracelog.h)
+# with the format strings read from the sketch ELF, the same way
+# tracelog_print() does on the ESP.  Each dump line is the address of the
+# format, the time in us and the argument words, all but the time in hex.
+# Strings from RAM were copied into the words, strings from flash are read
+# from the ELF too, other RAM pointers can not be followed and print as such.
+
+import argparse
+import re
+import struct
+import sys
+
+# an argument word announcing a string copied into the next words
+TRACELOG_STRING = 0xffff0000
+FLASH = 0x40000000
+
+CONVERSION = re.compile(r'%([-+ #0-9.]*)(hh|h|ll|l|L|z|j|t)?([a-zA-Z%])')
+
+def parse_args():
+    parser = argparse.ArgumentParser(description='tracelog_dump() formatter')
+    parser.add_argument('-e', '--elf', required=True, help='Sketch ELF file')
+    parser.add_argument('dump', nargs='?', help='tracelog_dump() output, stdin if not given')
+    return parser.parse_args()
+
+def load_sections(elf):
+    # (address, data) of the allocated sections with contents
+    with open(elf, 'rb') as f:
+        data = f.read()
+    if data[:4] != b'\x7fELF' or data[4] != 1 or data[5] != 1:
+        raise ValueError('%s: not a 32 bit little endian ELF' % elf)
+    shoff, = struct.unpack_from('<I', data, 0x20)
+    shentsize, shnum = struct.unpack_from('<HH', data, 0x2e)
+    sections = []
+    for i in range(shnum):
+        _, sh_type, flags, addr, offset, size = struct.unpack_from('<IIIIII', data, shoff + i * shentsize)
+        SHT_NOBITS, SHF_ALLOC = 8, 2
+        if sh_type != SHT_NOBITS and flags & SHF_ALLOC and addr and size:
+            sections.append((addr, data[offset:offset + size]))
+    return sections
+
+def read_string(sections, addr):
+    for start, data in sections:
+        if start <= addr < start + len(data):
+            end = data.find(b'\0', addr - start)
+            if end < 0:
+                end = len(data)
+            return data[addr - start:end].decode('utf-8', 'replace')
+    return None
+
+def format_record(sections, fmt, args):
+    w = 0
+
+    def take(n):
+        nonlocal w
+        if w + n > len(args):
+            w = len(args)
+            return None
+        value = args[w:w + n]
+        w += n
+        return value
+
+    def conversion(m):
+        nonlocal w
+        flags, length, c = m.groups()
+        if c == '%':
+            return '%'
+        wide = length == 'll' or c in 'fFeEgGaA'
+        value = take(2 if wide else 1)
+        if value is None:
+            return '?'
+        if wide:
+            u = value[0] | (value[1] << 32)
+            if c in 'fFeEgGaA':
+                d, = struct.unpack('<d', struct.pack('<Q', u))
+                if c in 'aA':
+                    return d.hex()
+                return ('%' + flags + c) % d
+            if c in 'di':
+                u -= (1 << 64) if u & (1 << 63) else 0
+            return ('%' + flags + ('d' if c == 'u' else c)) % u
+        arg = value[0]
+        if c in 'sS':
+            if arg & 0xffff0000 == TRACELOG_STRING:
+                chars = min(arg & 0xffff, (len(args) - w) * 4)
+                raw = b''.join(struct.pack('<I', x) for x in args[w:])
+                w += (chars + 4) // 4
+                s = raw[:chars].decode('utf-8', 'replace')
+            elif arg >= FLASH:
+                s = read_string(sections, arg)
+                if s is None:
+                    s = '<0x%08x>' % arg
+            elif arg:
+                s = '<0x%08x>' % arg
+            else:
+                s = '(null)'
+            return ('%' + flags + 's') % s
+        if c in 'di':
+            return ('%' + flags + 'd') % (arg - (1 << 32) if arg & (1 << 31) else arg)
+        if c == 'p':
+            return '0x%x' % arg
+        if c == 'c':
+            return ('%' + flags + 'c') % (arg & 0xff)
+        if c in 'uoxX':
+            return ('%' + flags + ('d' if c == 'u' else c)) % arg
+        # %n and unknown conversions
+        return ''
+
+    return CONVERSION.sub(conversion, fmt).rstrip('\r\n')
+
+def main():
+    args = parse_args()
+    sections = load_sections(args.elf)
+    stream = open(args.dump) if args.dump else sys.stdin
+    for line in stream:
+        fields = line.split()
+        if not fields:
+            continue
+        if fields[0] == 'end':
+            break
+        if fields[0] == 'dropped':
+            if int(fields[1]):
+                print('%s records dropped' % fields[1])
+            continue
+        try:
+            addr, time = int(fields[0], 16), int(fields[1])
+            words = [int(x, 16) for x in fields[2:]]
+        except (ValueError, IndexError):
+            continue
+        fmt = read_string(sections, addr)
+        if fmt is None:
+            print('%u.%06u ?? format at 0x%08x' % (time // 1000000, time % 1000000, addr))
+            continue
+        print('%u.%06u %s' % (time // 1000000, time % 1000000, format_record(sections, fmt, words)))
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(main())